@@ -356,10 +356,15 @@ DebugBuild { PX4FirmwarePlugin { PX4FirmwarePluginFactory  { APMFirmwarePlugin {
 
     HEADERS += \
         src/AnalyzeView/LogDownloadTest.h \
+        src/AnalyzeView/FlightLogReaderTest.h \
         src/FactSystem/FactSystemTestBase.h \
         src/FactSystem/FactSystemTestGeneric.h \
         src/FactSystem/FactSystemTestPX4.h \
         src/FactSystem/ParameterManagerTest.h \
+        src/FactSystem/ParameterMetaDataCacheTest.h \
+        src/FactSystem/ParameterStoreTest.h \
+        src/FactSystem/ParameterReadWindowTest.h \
+        src/FactSystem/ParameterCacheTest.h \
         src/MissionManager/ComplexMissionItemTest.h \
         src/MissionManager/MissionCommandTreeTest.h \
         src/MissionManager/MissionControllerManagerTest.h \
@@ -367,11 +372,20 @@ DebugBuild { PX4FirmwarePlugin { PX4FirmwarePluginFactory  { APMFirmwarePlugin {
         src/MissionManager/MissionItemTest.h \
         src/MissionManager/MissionManagerTest.h \
         src/MissionManager/SimpleMissionItemTest.h \
+        src/QtLocationPlugin/LocalTileServer.h \
+        src/QtLocationPlugin/QGCTileCacheTest.h \
+        src/QtLocationPlugin/QGCTileDownloaderTest.h \
         src/qgcunittest/FileDialogTest.h \
         src/qgcunittest/FileManagerTest.h \
+        src/qgcunittest/FileTransferWindowTest.h \
         src/qgcunittest/FlightGearTest.h \
         src/qgcunittest/GeoTest.h \
         src/qgcunittest/LinkManagerTest.h \
+        src/qgcunittest/LogReplayLinkTest.h \
+        src/qgcunittest/MAVLinkFrameScannerTest.h \
+        src/qgcunittest/MAVLinkLogIndexTest.h \
+        src/qgcunittest/MAVLinkLogWriterTest.h \
+        src/qgcunittest/MAVLinkMessageDispatcherTest.h \
         src/qgcunittest/MainWindowTest.h \
         src/qgcunittest/MavlinkLogTest.h \
         src/qgcunittest/MessageBoxTest.h \
@@ -380,14 +394,23 @@ DebugBuild { PX4FirmwarePlugin { PX4FirmwarePluginFactory  { APMFirmwarePlugin {
         src/qgcunittest/TCPLinkTest.h \
         src/qgcunittest/TCPLoopBackServer.h \
         src/qgcunittest/UnitTest.h \
+        src/ui/linechart/TimeSeriesPyramidTest.h \
+        src/ui/linechart/TimeSeriesStoreTest.h \
         src/Vehicle/SendMavCommandTest.h \
+        src/Vehicle/ULogStreamTest.h \
+        src/VideoStreaming/VideoReceiverTest.h \
 
     SOURCES += \
         src/AnalyzeView/LogDownloadTest.cc \
+        src/AnalyzeView/FlightLogReaderTest.cc \
         src/FactSystem/FactSystemTestBase.cc \
         src/FactSystem/FactSystemTestGeneric.cc \
         src/FactSystem/FactSystemTestPX4.cc \
         src/FactSystem/ParameterManagerTest.cc \
+        src/FactSystem/ParameterMetaDataCacheTest.cc \
+        src/FactSystem/ParameterStoreTest.cc \
+        src/FactSystem/ParameterReadWindowTest.cc \
+        src/FactSystem/ParameterCacheTest.cc \
         src/MissionManager/ComplexMissionItemTest.cc \
         src/MissionManager/MissionCommandTreeTest.cc \
         src/MissionManager/MissionControllerManagerTest.cc \
@@ -395,11 +418,20 @@ DebugBuild { PX4FirmwarePlugin { PX4FirmwarePluginFactory  { APMFirmwarePlugin {
         src/MissionManager/MissionItemTest.cc \
         src/MissionManager/MissionManagerTest.cc \
         src/MissionManager/SimpleMissionItemTest.cc \
+        src/QtLocationPlugin/LocalTileServer.cc \
+        src/QtLocationPlugin/QGCTileCacheTest.cc \
+        src/QtLocationPlugin/QGCTileDownloaderTest.cc \
         src/qgcunittest/FileDialogTest.cc \
         src/qgcunittest/FileManagerTest.cc \
+        src/qgcunittest/FileTransferWindowTest.cc \
         src/qgcunittest/FlightGearTest.cc \
         src/qgcunittest/GeoTest.cc \
         src/qgcunittest/LinkManagerTest.cc \
+        src/qgcunittest/LogReplayLinkTest.cc \
+        src/qgcunittest/MAVLinkFrameScannerTest.cc \
+        src/qgcunittest/MAVLinkLogIndexTest.cc \
+        src/qgcunittest/MAVLinkLogWriterTest.cc \
+        src/qgcunittest/MAVLinkMessageDispatcherTest.cc \
         src/qgcunittest/MainWindowTest.cc \
         src/qgcunittest/MavlinkLogTest.cc \
         src/qgcunittest/MessageBoxTest.cc \
@@ -409,7 +441,11 @@ DebugBuild { PX4FirmwarePlugin { PX4FirmwarePluginFactory  { APMFirmwarePlugin {
         src/qgcunittest/TCPLoopBackServer.cc \
         src/qgcunittest/UnitTest.cc \
         src/qgcunittest/UnitTestList.cc \
+        src/ui/linechart/TimeSeriesPyramidTest.cc \
+        src/ui/linechart/TimeSeriesStoreTest.cc \
         src/Vehicle/SendMavCommandTest.cc \
+        src/Vehicle/ULogStreamTest.cc \
+        src/VideoStreaming/VideoReceiverTest.cc \
 } } } } } }
 
 # Main QGC Headers and Source files
@@ -473,11 +509,15 @@ HEADERS += \
     src/QmlControls/ScreenToolsController.h \
     src/QtLocationPlugin/QMLControl/QGCMapEngineManager.h \
     src/Vehicle/MAVLinkLogManager.h \
+    src/Vehicle/ULogStreamAssembler.h \
+    src/Vehicle/ULogStreamWriter.h \
     src/VehicleSetup/JoystickConfigController.h \
     src/audio/QGCAudioWorker.h \
     src/comm/LinkConfiguration.h \
     src/comm/LinkInterface.h \
     src/comm/LinkManager.h \
+    src/comm/MAVLinkFrameScanner.h \
+    src/comm/MAVLinkMessageDispatcher.h \
     src/comm/MAVLinkProtocol.h \
     src/comm/ProtocolInterface.h \
     src/comm/QGCMAVLink.h \
@@ -515,8 +555,12 @@ HEADERS += \
 
 !MobileBuild {
 HEADERS += \
+    src/AnalyzeView/DataFlashLogReader.h \
+    src/AnalyzeView/FlightLogReader.h \
     src/AnalyzeView/GeoTagController.h \
+    src/AnalyzeView/ULogReader.h \
     src/AnalyzeView/LogDownloadController.h \
+    src/AnalyzeView/LogDownloadWindow.h \
     src/GPS/Drivers/src/gps_helper.h \
     src/GPS/Drivers/src/ubx.h \
     src/GPS/GPSManager.h \
@@ -534,11 +578,15 @@ HEADERS += \
     src/ViewWidgets/CustomCommandWidgetController.h \
     src/ViewWidgets/ViewWidgetController.h \
     src/comm/LogReplayLink.h \
+    src/comm/MAVLinkLogIndex.h \
+    src/comm/MAVLinkLogWriter.h \
     src/comm/QGCFlightGearLink.h \
     src/comm/QGCHilLink.h \
     src/comm/QGCJSBSimLink.h \
     src/comm/QGCXPlaneLink.h \
+    src/comm/RingBufferedFileWriter.h \
     src/uas/FileManager.h \
+    src/uas/FileTransferWindow.h \
     src/ui/HILDockWidget.h \
     src/ui/MAVLinkDecoder.h \
     src/ui/MainWindow.h \
@@ -560,6 +608,8 @@ HEADERS += \
     src/ui/linechart/Linecharts.h \
     src/ui/linechart/ScrollZoomer.h \
     src/ui/linechart/Scrollbar.h \
+    src/ui/linechart/TimeSeriesPyramid.h \
+    src/ui/linechart/TimeSeriesStore.h \
     src/ui/uas/QGCUnconnectedInfoWidget.h \
     src/ui/uas/UASMessageView.h \
     src/ui/uas/UASQuickView.h \
@@ -634,11 +684,15 @@ SOURCES += \
     src/QmlControls/ScreenToolsController.cc \
     src/QtLocationPlugin/QMLControl/QGCMapEngineManager.cc \
     src/Vehicle/MAVLinkLogManager.cc \
+    src/Vehicle/ULogStreamAssembler.cc \
+    src/Vehicle/ULogStreamWriter.cc \
     src/VehicleSetup/JoystickConfigController.cc \
     src/audio/QGCAudioWorker.cpp \
     src/comm/LinkConfiguration.cc \
     src/comm/LinkInterface.cc \
     src/comm/LinkManager.cc \
+    src/comm/MAVLinkFrameScanner.cc \
+    src/comm/MAVLinkMessageDispatcher.cc \
     src/comm/MAVLinkProtocol.cc \
     src/comm/QGCMAVLink.cc \
     src/comm/TCPLink.cc \
@@ -668,8 +722,12 @@ contains(DEFINES, QGC_ENABLE_BLUETOOTH) {
 
 !MobileBuild {
 SOURCES += \
+    src/AnalyzeView/DataFlashLogReader.cc \
+    src/AnalyzeView/FlightLogReader.cc \
     src/AnalyzeView/GeoTagController.cc \
+    src/AnalyzeView/ULogReader.cc \
     src/AnalyzeView/LogDownloadController.cc \
+    src/AnalyzeView/LogDownloadWindow.cc \
     src/GPS/Drivers/src/gps_helper.cpp \
     src/GPS/Drivers/src/ubx.cpp \
     src/GPS/GPSManager.cc \
@@ -682,10 +740,14 @@ SOURCES += \
     src/ViewWidgets/CustomCommandWidgetController.cc \
     src/ViewWidgets/ViewWidgetController.cc \
     src/comm/LogReplayLink.cc \
+    src/comm/MAVLinkLogIndex.cc \
+    src/comm/MAVLinkLogWriter.cc \
     src/comm/QGCFlightGearLink.cc \
     src/comm/QGCJSBSimLink.cc \
     src/comm/QGCXPlaneLink.cc \
+    src/comm/RingBufferedFileWriter.cc \
     src/uas/FileManager.cc \
+    src/uas/FileTransferWindow.cc \
     src/ui/HILDockWidget.cc \
     src/ui/MAVLinkDecoder.cc \
     src/ui/MainWindow.cc \
@@ -707,6 +769,8 @@ SOURCES += \
     src/ui/linechart/Linecharts.cc \
     src/ui/linechart/ScrollZoomer.cc \
     src/ui/linechart/Scrollbar.cc \
+    src/ui/linechart/TimeSeriesPyramid.cc \
+    src/ui/linechart/TimeSeriesStore.cc \
     src/ui/uas/QGCUnconnectedInfoWidget.cc \
     src/ui/uas/UASMessageView.cc \
     src/ui/uas/UASQuickView.cc \
@@ -914,6 +978,10 @@ HEADERS += \
     src/FactSystem/FactSystem.h \
     src/FactSystem/FactValidator.h \
     src/FactSystem/ParameterManager.h \
+    src/FactSystem/ParameterMetaDataCache.h \
+    src/FactSystem/ParameterStore.h \
+    src/FactSystem/ParameterReadWindow.h \
+    src/FactSystem/ParameterCache.h \
     src/FactSystem/SettingsFact.h \
 
 SOURCES += \
@@ -924,6 +992,10 @@ SOURCES += \
     src/FactSystem/FactSystem.cc \
     src/FactSystem/FactValidator.cc \
     src/FactSystem/ParameterManager.cc \
+    src/FactSystem/ParameterMetaDataCache.cc \
+    src/FactSystem/ParameterStore.cc \
+    src/FactSystem/ParameterReadWindow.cc \
+    src/FactSystem/ParameterCache.cc \
     src/FactSystem/SettingsFact.cc \
 
 #-------------------------------------------------------------------------------------
@@ -935,6 +1007,7 @@ INCLUDEPATH += \
 HEADERS += \
     src/VideoStreaming/VideoItem.h \
     src/VideoStreaming/VideoReceiver.h \
+    src/VideoStreaming/VideoStream.h \
     src/VideoStreaming/VideoStreaming.h \
     src/VideoStreaming/VideoSurface.h \
     src/VideoStreaming/VideoSurface_p.h \
@@ -942,6 +1015,7 @@ HEADERS += \
 SOURCES += \
     src/VideoStreaming/VideoItem.cc \
     src/VideoStreaming/VideoReceiver.cc \
+    src/VideoStreaming/VideoStream.cc \
     src/VideoStreaming/VideoStreaming.cc \
     src/VideoStreaming/VideoSurface.cc \
 
@@ -0,0 +1,157 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "DataFlashLogReader.h"
+
+#include <string.h>
+
+DataFlashLogReader::DataFlashLogReader(void)
+{
+    memset(_recordLength, 0, sizeof(_recordLength));
+    memset(_typeSlot, -1, sizeof(_typeSlot));
+}
+
+bool DataFlashLogReader::isDataFlashLog(const QByteArray& data)
+{
+    // Logs start with the FMT record which defines FMT
+    return data.size() >= headerLength &&
+            (uint8_t)data[0] == headerByte1 &&
+            (uint8_t)data[1] == headerByte2 &&
+            (uint8_t)data[2] == formatMessageType;
+}
+
+qint64 DataFlashLogReader::_readFileHeader(void)
+{
+    memset(_recordLength, 0, sizeof(_recordLength));
+    memset(_typeSlot, -1, sizeof(_typeSlot));
+    _formats.clear();
+    _recordLength[formatMessageType] = formatLength;
+
+    // No file header, the log starts with the first record
+    _file.seek(0);
+    return isDataFlashLog(_file.read(headerLength)) ? 0 : -1;
+}
+
+FlightLogReader::ScanResult_t DataFlashLogReader::_scanRecord(int& recordLength, int& slot)
+{
+    if (!_fill(headerLength)) {
+        return ScanEnd;
+    }
+
+    const uint8_t* data = _scanData();
+    recordLength = _recordLength[data[2]];
+    if (data[0] != headerByte1 || data[1] != headerByte2 || recordLength == 0) {
+        return ScanSkip;
+    }
+
+    // The header of the next record must follow, unless the log ends here
+    bool complete = _fill(recordLength + 2);
+    if (!complete && !_fill(recordLength)) {
+        // Truncated last record
+        return ScanEnd;
+    }
+    data = _scanData();
+    if (complete && (data[recordLength] != headerByte1 || data[recordLength + 1] != headerByte2)) {
+        return ScanSkip;
+    }
+
+    if (data[2] == formatMessageType) {
+        uint8_t type = data[3];
+        uint8_t length = data[4];
+        if (type != formatMessageType && length >= headerLength) {
+            const char* name = (const char*)data + 5;
+            const char* format = (const char*)data + 9;
+            const char* labels = (const char*)data + 25;
+
+            Format_t definition;
+            definition.name = QString::fromLatin1(name, (int)qstrnlen(name, 4));
+            definition.format = QByteArray(format, (int)qstrnlen(format, 16));
+            definition.labels = QString::fromLatin1(labels, (int)qstrnlen(labels, 64)).split(',');
+            _formats[definition.name] = definition;
+
+            _recordLength[type] = length;
+            _typeSlot[type] = _messageSlot(definition.name);
+        }
+    }
+
+    slot = _typeSlot[data[2]];
+    return ScanRecord;
+}
+
+bool DataFlashLogReader::_decodeRecord(const uint8_t* data, int length, Record_t& record)
+{
+    if (length < headerLength || data[0] != headerByte1 || data[1] != headerByte2) {
+        return false;
+    }
+    int recordLength = _recordLength[data[2]];
+    if (recordLength == 0 || recordLength > length) {
+        return false;
+    }
+
+    record.payload = data + headerLength;
+    record.length = recordLength - headerLength;
+
+    return true;
+}
+
+FlightLogReader::Field_t DataFlashLogReader::field(const QString& message, const QString& fieldName)
+{
+    Field_t field;
+    field.type = FieldInvalid;
+    field.offset = 0;
+    field.scale = 1.0;
+
+    QHash<QString, Format_t>::const_iterator it = _formats.constFind(message);
+    if (it == _formats.constEnd()) {
+        return field;
+    }
+
+    const Format_t& definition = it.value();
+    for (int i=0; i<definition.format.count() && i<definition.labels.count(); i++) {
+        FieldType_t type = FieldInvalid;
+        double      scale = 1.0;
+        int         size = 0;
+
+        switch (definition.format[i]) {
+        case 'b':   type = FieldInt8;                   break;
+        case 'B':
+        case 'M':   type = FieldUInt8;                  break;
+        case 'h':   type = FieldInt16;                  break;
+        case 'H':   type = FieldUInt16;                 break;
+        case 'i':   type = FieldInt32;                  break;
+        case 'I':   type = FieldUInt32;                 break;
+        case 'q':   type = FieldInt64;                  break;
+        case 'Q':   type = FieldUInt64;                 break;
+        case 'f':   type = FieldFloat;                  break;
+        case 'd':   type = FieldDouble;                 break;
+        case 'c':   type = FieldInt16;  scale = 0.01;   break;
+        case 'C':   type = FieldUInt16; scale = 0.01;   break;
+        case 'e':   type = FieldInt32;  scale = 0.01;   break;
+        case 'E':   type = FieldUInt32; scale = 0.01;   break;
+        case 'L':   type = FieldInt32;  scale = 1.0e-7; break;  // Latitude/longitude
+        case 'n':   size = 4;                           break;
+        case 'N':   size = 16;                          break;
+        case 'Z':   size = 64;                          break;
+        case 'a':   size = 64;                          break;  // int16_t[32]
+        default:
+            // Unknown type, offsets of the following fields can't be known
+            return field;
+        }
+
+        if (definition.labels[i] == fieldName) {
+            field.type = type;
+            field.scale = scale;
+            return field;
+        }
+        field.offset += type == FieldInvalid ? size : fieldTypeSize(type);
+    }
+
+    field.offset = 0;
+    return field;
+}
@@ -0,0 +1,57 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#ifndef DataFlashLogReader_H
+#define DataFlashLogReader_H
+
+#include "FlightLogReader.h"
+
+/// Indexed reader for DataFlash binary logs: ArduPilot .bin logs as well as PX4 sdlog2 logs (.px4log), which use
+/// the same record format.
+///
+/// Every record starts with the two header bytes 0xA3 0x95 followed by the message type. The length, name and
+/// fields of each message type are defined by FMT records, which the index pass picks up as it reads. A record only
+/// counts if the header of the next record follows it, otherwise bytes are skipped until the reader is back in sync.
+class DataFlashLogReader : public FlightLogReader
+{
+public:
+    DataFlashLogReader(void);
+
+    /// @return true: data is the start of a DataFlash log
+    static bool isDataFlashLog(const QByteArray& data);
+
+    // Overrides from FlightLogReader
+    Field_t field(const QString& message, const QString& fieldName) final;
+
+    static const uint8_t    headerByte1 =       0xA3;
+    static const uint8_t    headerByte2 =       0x95;
+    static const int        headerLength =      3;
+    static const uint8_t    formatMessageType = 0x80;   ///< FMT
+    static const int        formatLength =      89;     ///< FMT record: header, type, length, name[4], format[16], labels[64]
+
+protected:
+    // Overrides from FlightLogReader
+    qint64          _readFileHeader (void) final;
+    ScanResult_t    _scanRecord     (int& recordLength, int& slot) final;
+    bool            _decodeRecord   (const uint8_t* data, int length, Record_t& record) final;
+    int             _maxRecordLength(void) const final { return 255; }
+
+private:
+    typedef struct {
+        QString     name;
+        QByteArray  format;
+        QStringList labels;
+    } Format_t;
+
+    int                     _recordLength[256]; ///< Record length by message type, header included, 0 for undefined
+    int                     _typeSlot[256];     ///< Index slot by message type
+    QHash<QString, Format_t> _formats;          ///< By message name
+};
+
+#endif
@@ -13,16 +13,50 @@ ExifParser::~ExifParser()
 
 }
 
+bool ExifParser::readHeader(QIODevice& file, QByteArray& header)
+{
+    const int probeBytes = 8 * 1024;
+
+    header = file.read(probeBytes);
+    if (header.size() < 4 || (uchar)header[0] != 0xFF || (uchar)header[1] != 0xD8) {
+        return false;
+    }
+
+    // walk the APPn segments following the start of image marker until we're past APP1
+    int offset = 2;
+    while (offset + 4 <= header.size()) {
+        uchar marker = header[offset + 1];
+        if ((uchar)header[offset] != 0xFF || marker < 0xE0 || marker > 0xEF) {
+            break;
+        }
+        int segmentEnd = offset + 2 + qFromBigEndian<quint16>(reinterpret_cast<const uchar*>(header.constData()) + offset + 2);
+        if (segmentEnd > header.size()) {
+            header.append(file.read(segmentEnd - header.size()));
+        }
+        if (marker == 0xE1) {
+            break;
+        }
+        offset = segmentEnd;
+    }
+
+    return true;
+}
+
 double ExifParser::readTime(QByteArray& buf)
 {
     QByteArray tiffHeader("\x49\x49\x2A", 3);
     QByteArray createDateHeader("\x04\x90\x02", 3);
 
     // find header position
-    uint32_t tiffHeaderIndex = buf.indexOf(tiffHeader);
+    int tiffHeaderIndex = buf.indexOf(tiffHeader);
 
     // find creation date header index
-    uint32_t createDateHeaderIndex = buf.indexOf(createDateHeader);
+    int createDateHeaderIndex = buf.indexOf(createDateHeader);
+
+    if (tiffHeaderIndex < 0 || createDateHeaderIndex < 0 || createDateHeaderIndex + 12 > buf.size()) {
+        qWarning() << "Could not find creation time and date";
+        return -1.0;
+    }
 
     // extract size of date-time string, -1 accounting for null-termination
     uint32_t* sizeString = reinterpret_cast<uint32_t*>(buf.mid(createDateHeaderIndex + 4, 4).data());
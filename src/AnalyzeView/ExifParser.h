@@ -2,6 +2,7 @@
 #define EXIFPARSER_H
 
 #include <QGeoCoordinate>
+#include <QIODevice>
 #include <QDebug>
 
 class ExifParser
@@ -9,6 +10,9 @@ class ExifParser
 public:
     ExifParser();
     ~ExifParser();
+    /// Reads the start of a JPEG file, up to at least the end of the EXIF (APP1) segment. Both readTime and write
+    /// only need this part of the file, the image data which follows is left in the file.
+    bool readHeader(QIODevice& file, QByteArray& header);
     double readTime(QByteArray& buf);
     bool write(QByteArray& data, QGeoCoordinate coordinate);
 };
@@ -0,0 +1,302 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "FlightLogReader.h"
+#include "ULogReader.h"
+#include "DataFlashLogReader.h"
+
+#include <QObject>
+#include <QtEndian>
+#include <QtNumeric>
+
+#include <string.h>
+
+FlightLogReader::FlightLogReader(void)
+    : _fileSize(0)
+    , _dataOffset(0)
+    , _scanPosition(0)
+    , _scanOffset(0)
+    , _scanLength(0)
+    , _indexedRecords(0)
+    , _skippedBytes(0)
+    , _readPosition(0)
+    , _readLength(0)
+{
+
+}
+
+FlightLogReader::~FlightLogReader()
+{
+
+}
+
+FlightLogReader* FlightLogReader::open(const QString& fileName, QString& errorString)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        errorString = QObject::tr("Unable to open log file: %1").arg(file.errorString());
+        return NULL;
+    }
+    QByteArray header = file.read(ULogReader::fileHeaderLength);
+    file.close();
+
+    FlightLogReader* reader = NULL;
+    if (ULogReader::isULog(header)) {
+        reader = new ULogReader;
+    } else if (DataFlashLogReader::isDataFlashLog(header)) {
+        reader = new DataFlashLogReader;
+    } else {
+        errorString = QObject::tr("Unsupported log format, supported are ULog, PX4 sdlog2 and ArduPilot DataFlash logs");
+        return NULL;
+    }
+
+    if (!reader->_open(fileName)) {
+        errorString = QObject::tr("Corrupt log file header");
+        delete reader;
+        return NULL;
+    }
+
+    return reader;
+}
+
+bool FlightLogReader::_open(const QString& fileName)
+{
+    _file.setFileName(fileName);
+    if (!_file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    _fileSize = _file.size();
+    _dataOffset = _readFileHeader();
+
+    return _dataOffset >= 0;
+}
+
+void FlightLogReader::startIndex(const QStringList& messages)
+{
+    _dataOffset = qMax(_readFileHeader(), (qint64)0);
+
+    _scanBuffer.resize(_chunkBytes);
+    _scanPosition = _dataOffset;
+    _scanOffset = 0;
+    _scanLength = 0;
+    _indexedRecords = 0;
+    _skippedBytes = 0;
+    _file.seek(_dataOffset);
+
+    _indexMessages = messages;
+    for (int slot=0; slot<_index.count(); slot++) {
+        _index[slot].clear();
+        _indexSlot[slot] = _indexMessages.isEmpty() || _indexMessages.contains(_nameToSlot.key(slot));
+    }
+}
+
+bool FlightLogReader::continueIndex(qint64 bytes)
+{
+    qint64 endPosition = indexPosition() + bytes;
+
+    while (indexPosition() < endPosition) {
+        int recordLength = 0;
+        int slot = -1;
+
+        switch (_scanRecord(recordLength, slot)) {
+        case ScanRecord:
+            if (slot >= 0 && _indexSlot[slot]) {
+                _index[slot].append(indexPosition());
+                _indexedRecords++;
+            }
+            _scanOffset += recordLength;
+            break;
+        case ScanSkip:
+            _scanOffset++;
+            _skippedBytes++;
+            break;
+        case ScanEnd:
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void FlightLogReader::buildIndex(const QStringList& messages)
+{
+    startIndex(messages);
+    while (continueIndex(_fileSize)) {
+    }
+}
+
+bool FlightLogReader::hasRecords(const QString& name) const
+{
+    return !offsets(name).isEmpty();
+}
+
+const QVector<qint64>& FlightLogReader::offsets(const QString& name) const
+{
+    static const QVector<qint64> noOffsets;
+
+    int slot = _nameToSlot.value(name, -1);
+    return slot == -1 ? noOffsets : _index[slot];
+}
+
+bool FlightLogReader::readRecord(qint64 offset, Record_t& record)
+{
+    int maxRecordLength = _maxRecordLength();
+
+    if (offset < _readPosition || offset + maxRecordLength > _readPosition + _readLength) {
+        // Move the window, unless it already reaches the end of the log
+        if (offset < _readPosition || _readPosition + _readLength < _fileSize) {
+            if (_readBuffer.isEmpty()) {
+                _readBuffer.resize(_chunkBytes);
+            }
+            if (!_file.seek(offset)) {
+                return false;
+            }
+            _readPosition = offset;
+            _readLength = 0;
+            while (_readLength < _readBuffer.size()) {
+                qint64 bytesRead = _file.read(_readBuffer.data() + _readLength, _readBuffer.size() - _readLength);
+                if (bytesRead <= 0) {
+                    break;
+                }
+                _readLength += (int)bytesRead;
+            }
+        }
+    }
+
+    int available = (int)(_readPosition + _readLength - offset);
+    if (available <= 0) {
+        return false;
+    }
+
+    return _decodeRecord((const uint8_t*)_readBuffer.constData() + (offset - _readPosition), available, record);
+}
+
+double FlightLogReader::value(const Record_t& record, const Field_t& field)
+{
+    int size = fieldTypeSize(field.type);
+    if (size == 0 || field.offset < 0 || field.offset + size > record.length) {
+        return qQNaN();
+    }
+
+    const uint8_t* data = record.payload + field.offset;
+    double rawValue = 0;
+
+    switch (field.type) {
+    case FieldInt8:
+        rawValue = (qint8)data[0];
+        break;
+    case FieldUInt8:
+        rawValue = data[0];
+        break;
+    case FieldInt16:
+        rawValue = qFromLittleEndian<qint16>(data);
+        break;
+    case FieldUInt16:
+        rawValue = qFromLittleEndian<quint16>(data);
+        break;
+    case FieldInt32:
+        rawValue = qFromLittleEndian<qint32>(data);
+        break;
+    case FieldUInt32:
+        rawValue = qFromLittleEndian<quint32>(data);
+        break;
+    case FieldInt64:
+        rawValue = (double)qFromLittleEndian<qint64>(data);
+        break;
+    case FieldUInt64:
+        rawValue = (double)qFromLittleEndian<quint64>(data);
+        break;
+    case FieldFloat:
+    {
+        quint32 bits = qFromLittleEndian<quint32>(data);
+        float   floatValue;
+        memcpy(&floatValue, &bits, sizeof(floatValue));
+        rawValue = floatValue;
+        break;
+    }
+    case FieldDouble:
+    {
+        quint64 bits = qFromLittleEndian<quint64>(data);
+        memcpy(&rawValue, &bits, sizeof(rawValue));
+        break;
+    }
+    case FieldInvalid:
+        return qQNaN();
+    }
+
+    return rawValue * field.scale;
+}
+
+int FlightLogReader::fieldTypeSize(FieldType_t type)
+{
+    switch (type) {
+    case FieldInt8:
+    case FieldUInt8:
+        return 1;
+    case FieldInt16:
+    case FieldUInt16:
+        return 2;
+    case FieldInt32:
+    case FieldUInt32:
+    case FieldFloat:
+        return 4;
+    case FieldInt64:
+    case FieldUInt64:
+    case FieldDouble:
+        return 8;
+    case FieldInvalid:
+        break;
+    }
+
+    return 0;
+}
+
+bool FlightLogReader::_fill(int bytes)
+{
+    if (_scanLength - _scanOffset >= bytes) {
+        return true;
+    }
+
+    // Move what is left to the front and read the next chunk behind it
+    int remaining = _scanLength - _scanOffset;
+    if (remaining) {
+        memmove(_scanBuffer.data(), _scanBuffer.constData() + _scanOffset, remaining);
+    }
+    _scanPosition += _scanOffset;
+    _scanOffset = 0;
+    _scanLength = remaining;
+
+    if (bytes > _scanBuffer.size()) {
+        return false;
+    }
+    while (_scanLength < bytes) {
+        qint64 bytesRead = _file.read(_scanBuffer.data() + _scanLength, _scanBuffer.size() - _scanLength);
+        if (bytesRead <= 0) {
+            return false;
+        }
+        _scanLength += (int)bytesRead;
+    }
+
+    return true;
+}
+
+int FlightLogReader::_messageSlot(const QString& name)
+{
+    QHash<QString, int>::const_iterator it = _nameToSlot.constFind(name);
+    if (it != _nameToSlot.constEnd()) {
+        return it.value();
+    }
+
+    int slot = _index.count();
+    _nameToSlot[name] = slot;
+    _index.append(QVector<qint64>());
+    _indexSlot.append(_indexMessages.isEmpty() || _indexMessages.contains(name));
+
+    return slot;
+}
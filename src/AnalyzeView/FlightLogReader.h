@@ -0,0 +1,169 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#ifndef FlightLogReader_H
+#define FlightLogReader_H
+
+#include <QFile>
+#include <QHash>
+#include <QVector>
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+#include <stdint.h>
+
+/// Indexed reader for binary flight logs, base class for ULogReader and DataFlashLogReader.
+///
+/// A single pass over the log builds an index holding the file offset of every record, per message. Analysis
+/// code then pulls just the records of the messages it needs through readRecord, decoding fields by name, without
+/// decoding anything else in the log. Records are read through a read ahead window, so walking the offsets of a
+/// message in order reads the log sequentially.
+///
+/// The index pass reads the log in chunks and can be run in steps (startIndex/continueIndex), so callers can report
+/// progress and cancel on large logs.
+class FlightLogReader
+{
+public:
+    virtual ~FlightLogReader();
+
+    typedef enum {
+        FieldInvalid,
+        FieldInt8,
+        FieldUInt8,
+        FieldInt16,
+        FieldUInt16,
+        FieldInt32,
+        FieldUInt32,
+        FieldInt64,
+        FieldUInt64,
+        FieldFloat,
+        FieldDouble,
+    } FieldType_t;
+
+    typedef struct {
+        FieldType_t type;
+        int         offset;     ///< Offset in the record payload
+        double      scale;      ///< Applied to the raw value by value()
+    } Field_t;
+
+    typedef struct {
+        const uint8_t*  payload;    ///< Valid until the next call to readRecord
+        int             length;
+    } Record_t;
+
+    /// Opens the log with the reader which matches its file header
+    ///     @param errorString Set to the reason if the log can't be opened
+    /// @return NULL: log could not be opened or format not supported. Caller owns the reader.
+    static FlightLogReader* open(const QString& fileName, QString& errorString);
+
+    /// Starts a new index pass
+    ///     @param messages Names of the messages to index, empty list for all
+    void startIndex(const QStringList& messages = QStringList());
+
+    /// Indexes at least the specified number of bytes of the log, unless it ends first
+    /// @return true: there is more to index
+    bool continueIndex(qint64 bytes);
+
+    /// Builds the complete index in one go
+    void buildIndex(const QStringList& messages = QStringList());
+
+    /// @return Names of all messages defined by the log so far
+    QStringList messageNames(void) const { return _nameToSlot.keys(); }
+
+    /// @return true: message is defined by the log and has records in the index
+    bool hasRecords(const QString& name) const;
+
+    /// @return File offsets of the records for the message, in file order
+    const QVector<qint64>& offsets(const QString& name) const;
+
+    /// @return Field of a message, type is FieldInvalid if the message has no such field. Message definitions are
+    /// picked up by the index pass, so this only works after it.
+    virtual Field_t field(const QString& message, const QString& fieldName) = 0;
+
+    /// Reads the record at the specified offset from the index
+    /// @return false: no record at the offset
+    bool readRecord(qint64 offset, Record_t& record);
+
+    /// @return Value of the field in the record, NaN if the record is too short to hold it
+    static double value(const Record_t& record, const Field_t& field);
+
+    static int fieldTypeSize(FieldType_t type);
+
+    QString fileName(void) const        { return _file.fileName(); }
+    qint64  fileSize(void) const        { return _fileSize; }
+    qint64  indexPosition(void) const   { return _scanPosition + _scanOffset; }    ///< File offset the index pass got to
+    quint64 indexedRecords(void) const  { return _indexedRecords; }
+    qint64  skippedBytes(void) const    { return _skippedBytes; }                  ///< Bytes skipped to get back in sync
+
+protected:
+    FlightLogReader(void);
+
+    typedef enum {
+        ScanRecord,         ///< Record found
+        ScanSkip,           ///< Not a record, skip a byte to get back in sync
+        ScanEnd,            ///< Log ends (or is truncated) here
+    } ScanResult_t;
+
+    /// Validates the file header, called at the start of each index pass. Message definitions picked up by a previous
+    /// pass must be dropped here, the pass reads them again.
+    /// @return File offset of the first record, -1 if the file is not in this format
+    virtual qint64 _readFileHeader(void) = 0;
+
+    /// Decodes the record at the current scan position during the index pass. Use _fill and _scanData to get at the
+    /// data.
+    ///     @param recordLength Set to the length of the record
+    ///     @param slot Set to the message slot the record belongs to, -1 for records which are not indexed
+    virtual ScanResult_t _scanRecord(int& recordLength, int& slot) = 0;
+
+    /// Decodes the payload of an indexed record
+    ///     @param data Start of the record
+    ///     @param length Bytes available from data on, at least maxRecordLength unless the log ends before that
+    virtual bool _decodeRecord(const uint8_t* data, int length, Record_t& record) = 0;
+
+    /// @return Maximum length of a single record in this format
+    virtual int _maxRecordLength(void) const = 0;
+
+    /// Makes sure the specified number of bytes following the scan position are available through _scanData
+    /// @return false: log ends before that
+    bool _fill(int bytes);
+
+    const uint8_t* _scanData(void) const { return (const uint8_t*)_scanBuffer.constData() + _scanOffset; }
+
+    /// @return Slot for the message name, created if needed
+    int _messageSlot(const QString& name);
+
+    QFile   _file;
+
+private:
+    bool _open(const QString& fileName);
+
+    qint64                      _fileSize;
+    qint64                      _dataOffset;        ///< File offset of the first record
+
+    QByteArray                  _scanBuffer;
+    qint64                      _scanPosition;      ///< File offset of the start of _scanBuffer
+    int                         _scanOffset;        ///< Offset of the next record in _scanBuffer
+    int                         _scanLength;        ///< Bytes used in _scanBuffer
+    quint64                     _indexedRecords;
+    qint64                      _skippedBytes;
+
+    QHash<QString, int>         _nameToSlot;
+    QVector<QVector<qint64> >   _index;             ///< Record offsets by slot
+    QVector<bool>               _indexSlot;         ///< Slot is indexed
+    QStringList                 _indexMessages;     ///< Messages to index, empty for all
+
+    QByteArray                  _readBuffer;        ///< Read ahead window for readRecord
+    qint64                      _readPosition;      ///< File offset of the start of _readBuffer
+    int                         _readLength;
+
+    static const int _chunkBytes = 256 * 1024;
+};
+
+#endif
@@ -0,0 +1,593 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "FlightLogReaderTest.h"
+#include "FlightLogReader.h"
+#include "ULogReader.h"
+#include "DataFlashLogReader.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QScopedPointer>
+#include <QtEndian>
+#include <QtNumeric>
+
+#include <string.h>
+
+static const char* _ulogCameraTriggerFormat =   "camera_trigger:uint64_t timestamp;uint64_t timestamp_utc;uint32_t seq;uint8_t[4] _padding0;";
+static const char* _ulogGlobalPositionFormat =  "vehicle_global_position:uint64_t timestamp;double lat;double lon;float alt;uint8_t[4] _padding0;";
+static const char* _ulogSensorFormat =          "sensor_combined:uint64_t timestamp;float[3] gyro_rad;float[3] accelerometer_m_s2;uint32_t[2] dt;uint8_t[24] _padding0;";
+static const int   _ulogSensorPayloadLength =   64;
+
+template <typename T> static void _appendLittleEndian(QByteArray& data, T value)
+{
+    uchar buffer[sizeof(T)];
+    qToLittleEndian<T>(value, buffer);
+    data.append((const char*)buffer, sizeof(T));
+}
+
+static void _appendDouble(QByteArray& data, double value)
+{
+    quint64 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    _appendLittleEndian<quint64>(data, bits);
+}
+
+static void _appendFloat(QByteArray& data, float value)
+{
+    quint32 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    _appendLittleEndian<quint32>(data, bits);
+}
+
+FlightLogReaderTest::FlightLogReaderTest(void)
+{
+
+}
+
+QByteArray FlightLogReaderTest::_dataFlashFormat(uint8_t type, uint8_t length, const char* name, const char* format, const char* labels)
+{
+    QByteArray record(DataFlashLogReader::formatLength, 0);
+
+    record[0] = (char)DataFlashLogReader::headerByte1;
+    record[1] = (char)DataFlashLogReader::headerByte2;
+    record[2] = (char)DataFlashLogReader::formatMessageType;
+    record[3] = (char)type;
+    record[4] = (char)length;
+    record.replace(5, (int)strlen(name), name);
+    record.replace(9, (int)strlen(format), format);
+    record.replace(25, (int)strlen(labels), labels);
+
+    return record;
+}
+
+QByteArray FlightLogReaderTest::_dataFlashRecord(uint8_t type, const QByteArray& payload)
+{
+    QByteArray record;
+
+    record.append((char)DataFlashLogReader::headerByte1);
+    record.append((char)DataFlashLogReader::headerByte2);
+    record.append((char)type);
+    record.append(payload);
+
+    return record;
+}
+
+QByteArray FlightLogReaderTest::_ulogHeader(void)
+{
+    QByteArray header("ULog\x01\x12\x35", 7);
+
+    header.append((char)1);
+    _appendLittleEndian<quint64>(header, 0);
+
+    return header;
+}
+
+QByteArray FlightLogReaderTest::_ulogMessage(char type, const QByteArray& payload)
+{
+    QByteArray message;
+
+    _appendLittleEndian<quint16>(message, payload.size());
+    message.append(type);
+    message.append(payload);
+
+    return message;
+}
+
+QByteArray FlightLogReaderTest::_ulogSubscription(uint8_t multiId, uint16_t msgId, const char* name)
+{
+    QByteArray payload;
+
+    payload.append((char)multiId);
+    _appendLittleEndian<quint16>(payload, msgId);
+    payload.append(name);
+
+    return _ulogMessage('A', payload);
+}
+
+QByteArray FlightLogReaderTest::_ulogData(uint16_t msgId, const QByteArray& payload)
+{
+    QByteArray data;
+
+    _appendLittleEndian<quint16>(data, msgId);
+    data.append(payload);
+
+    return _ulogMessage('D', data);
+}
+
+QByteArray FlightLogReaderTest::_cameraTrigger(quint64 timestamp, quint32 seq)
+{
+    QByteArray payload;
+
+    _appendLittleEndian<quint64>(payload, timestamp);
+    _appendLittleEndian<quint64>(payload, timestamp + 1500000000000000ULL);
+    _appendLittleEndian<quint32>(payload, seq);
+    payload.append(QByteArray(4, 0));
+
+    return payload;
+}
+
+QByteArray FlightLogReaderTest::_globalPosition(quint64 timestamp, double lat, double lon, float alt)
+{
+    QByteArray payload;
+
+    _appendLittleEndian<quint64>(payload, timestamp);
+    _appendDouble(payload, lat);
+    _appendDouble(payload, lon);
+    _appendFloat(payload, alt);
+    payload.append(QByteArray(4, 0));
+
+    return payload;
+}
+
+QString FlightLogReaderTest::_writeLog(const QByteArray& log, const QString& name)
+{
+    QString fileName = QDir(_tempDir.path()).filePath(name);
+    QFile   file(fileName);
+
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(log);
+    }
+
+    return fileName;
+}
+
+void FlightLogReaderTest::_dataFlashDecode_test(void)
+{
+    QByteArray gpos;
+    _appendLittleEndian<qint32>(gpos, 473977420);
+    _appendLittleEndian<qint32>(gpos, -85455939);
+    _appendFloat(gpos, 488.5f);
+
+    QByteArray trigger;
+    _appendLittleEndian<quint64>(trigger, 123456789);
+    _appendLittleEndian<quint32>(trigger, 7);
+
+    QByteArray log;
+    log.append(_dataFlashFormat(_gposType, DataFlashLogReader::headerLength + gpos.size(), "GPOS", "LLf", "Lat,Lon,Alt"));
+    log.append(_dataFlashFormat(_triggerType, DataFlashLogReader::headerLength + trigger.size(), "TRIG", "QI", "Time,Seq"));
+    log.append(_dataFlashRecord(_gposType, gpos));
+    log.append(_dataFlashRecord(_triggerType, trigger));
+    log.append(_dataFlashRecord(_gposType, gpos));
+
+    QVERIFY(_tempDir.isValid());
+
+    QString errorString;
+    QScopedPointer<FlightLogReader> reader(FlightLogReader::open(_writeLog(log, "decode.px4log"), errorString));
+    QVERIFY(reader);
+    QVERIFY(dynamic_cast<DataFlashLogReader*>(reader.data()));
+    QCOMPARE(reader->fileSize(), (qint64)log.size());
+
+    reader->buildIndex();
+    QCOMPARE(reader->indexPosition(), (qint64)log.size());
+    QCOMPARE(reader->skippedBytes(), (qint64)0);
+    QCOMPARE(reader->indexedRecords(), (quint64)3);
+    QCOMPARE(reader->offsets("GPOS").count(), 2);
+    QCOMPARE(reader->offsets("TRIG").count(), 1);
+    QCOMPARE(reader->offsets("TRIG")[0], (qint64)(2 * DataFlashLogReader::formatLength + DataFlashLogReader::headerLength + gpos.size()));
+    QVERIFY(!reader->hasRecords("CAM"));
+
+    FlightLogReader::Field_t lat = reader->field("GPOS", "Lat");
+    FlightLogReader::Field_t lon = reader->field("GPOS", "Lon");
+    FlightLogReader::Field_t alt = reader->field("GPOS", "Alt");
+    FlightLogReader::Field_t seq = reader->field("TRIG", "Seq");
+    QCOMPARE((int)reader->field("GPOS", "Spd").type, (int)FlightLogReader::FieldInvalid);
+    QCOMPARE((int)alt.type, (int)FlightLogReader::FieldFloat);
+    QCOMPARE(alt.offset, 8);
+    QCOMPARE(seq.offset, 8);
+
+    FlightLogReader::Record_t record;
+    foreach (qint64 offset, reader->offsets("GPOS")) {
+        QVERIFY(reader->readRecord(offset, record));
+        QCOMPARE(record.length, gpos.size());
+        QVERIFY(qAbs(FlightLogReader::value(record, lat) - 47.397742) < 1e-9);
+        QVERIFY(qAbs(FlightLogReader::value(record, lon) + 8.5455939) < 1e-9);
+        QCOMPARE(FlightLogReader::value(record, alt), 488.5);
+    }
+    QVERIFY(reader->readRecord(reader->offsets("TRIG")[0], record));
+    QCOMPARE(FlightLogReader::value(record, seq), 7.0);
+    QCOMPARE(FlightLogReader::value(record, reader->field("TRIG", "Time")), 123456789.0);
+}
+
+void FlightLogReaderTest::_dataFlashChunkBoundary_test(void)
+{
+    // Well over a single read chunk, with records straddling the chunk boundaries
+    const int recordCount = 50000;
+
+    QByteArray log;
+    log.append(_dataFlashFormat(_triggerType, DataFlashLogReader::headerLength + 12, "TRIG", "QI", "Time,Seq"));
+    for (int i=0; i<recordCount; i++) {
+        QByteArray trigger;
+        _appendLittleEndian<quint64>(trigger, i * 1000);
+        _appendLittleEndian<quint32>(trigger, i);
+        log.append(_dataFlashRecord(_triggerType, trigger));
+    }
+
+    QVERIFY(_tempDir.isValid());
+
+    QString errorString;
+    QScopedPointer<FlightLogReader> reader(FlightLogReader::open(_writeLog(log, "chunk.bin"), errorString));
+    QVERIFY(reader);
+
+    reader->buildIndex();
+    QCOMPARE(reader->offsets("TRIG").count(), recordCount);
+
+    FlightLogReader::Field_t    seq = reader->field("TRIG", "Seq");
+    FlightLogReader::Record_t   record;
+    for (int i=0; i<recordCount; i++) {
+        QVERIFY(reader->readRecord(reader->offsets("TRIG")[i], record));
+        QCOMPARE(FlightLogReader::value(record, seq), (double)i);
+    }
+}
+
+void FlightLogReaderTest::_dataFlashResync_test(void)
+{
+    QByteArray garbage;
+    garbage.append((char)DataFlashLogReader::headerByte1);
+    garbage.append((char)DataFlashLogReader::headerByte2);
+    garbage.append((char)_triggerType);
+    garbage.append("noise");
+
+    QByteArray trigger1;
+    _appendLittleEndian<quint64>(trigger1, 1000);
+    _appendLittleEndian<quint32>(trigger1, 1);
+    QByteArray trigger2;
+    _appendLittleEndian<quint64>(trigger2, 2000);
+    _appendLittleEndian<quint32>(trigger2, 2);
+
+    QByteArray log;
+    log.append(_dataFlashFormat(_triggerType, DataFlashLogReader::headerLength + trigger1.size(), "TRIG", "QI", "Time,Seq"));
+    log.append(_dataFlashRecord(_triggerType, trigger1));
+    log.append(garbage);
+    log.append(_dataFlashRecord(_triggerType, trigger2));
+
+    QVERIFY(_tempDir.isValid());
+
+    QString errorString;
+    QScopedPointer<FlightLogReader> reader(FlightLogReader::open(_writeLog(log, "resync.bin"), errorString));
+    QVERIFY(reader);
+
+    reader->buildIndex();
+    QCOMPARE(reader->skippedBytes(), (qint64)garbage.size());
+    QCOMPARE(reader->offsets("TRIG").count(), 2);
+
+    FlightLogReader::Field_t    seq = reader->field("TRIG", "Seq");
+    FlightLogReader::Record_t   record;
+    QVERIFY(reader->readRecord(reader->offsets("TRIG")[0], record));
+    QCOMPARE(FlightLogReader::value(record, seq), 1.0);
+    QVERIFY(reader->readRecord(reader->offsets("TRIG")[1], record));
+    QCOMPARE(FlightLogReader::value(record, seq), 2.0);
+}
+
+void FlightLogReaderTest::_dataFlashTruncated_test(void)
+{
+    QByteArray trigger;
+    _appendLittleEndian<quint64>(trigger, 1000);
+    _appendLittleEndian<quint32>(trigger, 1);
+
+    QByteArray log;
+    log.append(_dataFlashFormat(_triggerType, DataFlashLogReader::headerLength + trigger.size(), "TRIG", "QI", "Time,Seq"));
+    log.append(_dataFlashRecord(_triggerType, trigger));
+    log.append(_dataFlashRecord(_triggerType, trigger).left(DataFlashLogReader::headerLength + 4));
+
+    QVERIFY(_tempDir.isValid());
+
+    QString errorString;
+    QScopedPointer<FlightLogReader> reader(FlightLogReader::open(_writeLog(log, "truncated.bin"), errorString));
+    QVERIFY(reader);
+
+    reader->buildIndex();
+    QCOMPARE(reader->offsets("TRIG").count(), 1);
+    QCOMPARE(reader->indexPosition(), (qint64)(log.size() - DataFlashLogReader::headerLength - 4));
+
+    // Fields past the end of a record read as NaN
+    FlightLogReader::Record_t record;
+    QVERIFY(reader->readRecord(reader->offsets("TRIG")[0], record));
+    record.length = 4;
+    QVERIFY(qIsNaN(FlightLogReader::value(record, reader->field("TRIG", "Seq"))));
+}
+
+void FlightLogReaderTest::_ulogDecode_test(void)
+{
+    const uint16_t  gposId =        0;
+    const uint16_t  triggerId =     1;
+    const uint16_t  gposId2 =       2;
+    const uint16_t  unsubscribedId = 7;
+
+    QByteArray nested;
+    _appendLittleEndian<quint64>(nested, 42);
+    nested.append(QByteArray(6, 0));
+    _appendFloat(nested, 2.5f);
+
+    QByteArray log;
+    log.append(_ulogHeader());
+    log.append(_ulogMessage('B', QByteArray(8, 0)));
+    log.append(_ulogMessage('F', _ulogCameraTriggerFormat));
+    log.append(_ulogMessage('F', _ulogGlobalPositionFormat));
+    log.append(_ulogMessage('F', "inner_t:uint16_t a;uint8_t b;"));
+    log.append(_ulogMessage('F', "nested_topic:uint64_t timestamp;inner_t[2] inner;float value;"));
+    log.append(_ulogSubscription(0, gposId, "vehicle_global_position"));
+    log.append(_ulogSubscription(0, triggerId, "camera_trigger"));
+    log.append(_ulogSubscription(1, gposId2, "vehicle_global_position"));
+    log.append(_ulogSubscription(0, 3, "nested_topic"));
+    log.append(_ulogData(gposId, _globalPosition(1000, 47.5, 8.25, 500.0f)));
+    log.append(_ulogMessage('L', "\x06........info"));
+    log.append(_ulogData(triggerId, _cameraTrigger(1500, 1)));
+    log.append(_ulogData(unsubscribedId, QByteArray(16, 0)));
+    log.append(_ulogData(gposId2, _globalPosition(2000, 47.75, 8.5, 510.0f)));
+    log.append(_ulogData(3, nested));
+    log.append(_ulogMessage('O', QByteArray(2, 0)));
+    log.append(_ulogData(triggerId, _cameraTrigger(2500, 2)));
+
+    QVERIFY(_tempDir.isValid());
+
+    QString errorString;
+    QScopedPointer<FlightLogReader> reader(FlightLogReader::open(_writeLog(log, "decode.ulg"), errorString));
+    QVERIFY(reader);
+    QVERIFY(dynamic_cast<ULogReader*>(reader.data()));
+
+    reader->buildIndex();
+    QCOMPARE(reader->indexPosition(), (qint64)log.size());
+    QCOMPARE(reader->indexedRecords(), (quint64)5);
+    QCOMPARE(reader->offsets("camera_trigger").count(), 2);
+    QCOMPARE(reader->offsets("vehicle_global_position").count(), 2);  // Both multi instances
+    QCOMPARE(reader->offsets("nested_topic").count(), 1);
+
+    FlightLogReader::Field_t seq = reader->field("camera_trigger", "seq");
+    FlightLogReader::Field_t lat = reader->field("vehicle_global_position", "lat");
+    FlightLogReader::Field_t alt = reader->field("vehicle_global_position", "alt");
+    FlightLogReader::Field_t value = reader->field("nested_topic", "value");
+    QCOMPARE((int)seq.type, (int)FlightLogReader::FieldUInt32);
+    QCOMPARE(seq.offset, 16);
+    QCOMPARE(alt.offset, 24);
+    QCOMPARE(value.offset, 14);
+    QCOMPARE((int)reader->field("camera_trigger", "missing").type, (int)FlightLogReader::FieldInvalid);
+    QCOMPARE((int)reader->field("missing_topic", "seq").type, (int)FlightLogReader::FieldInvalid);
+
+    FlightLogReader::Record_t record;
+    QVERIFY(reader->readRecord(reader->offsets("camera_trigger")[1], record));
+    QCOMPARE(record.length, 24);
+    QCOMPARE(FlightLogReader::value(record, seq), 2.0);
+    QVERIFY(reader->readRecord(reader->offsets("vehicle_global_position")[0], record));
+    QCOMPARE(FlightLogReader::value(record, lat), 47.5);
+    QCOMPARE(FlightLogReader::value(record, alt), 500.0);
+    QVERIFY(reader->readRecord(reader->offsets("vehicle_global_position")[1], record));
+    QCOMPARE(FlightLogReader::value(record, lat), 47.75);
+    QVERIFY(reader->readRecord(reader->offsets("nested_topic")[0], record));
+    QCOMPARE(FlightLogReader::value(record, value), 2.5);
+}
+
+void FlightLogReaderTest::_indexSubset_test(void)
+{
+    QByteArray log;
+    log.append(_ulogHeader());
+    log.append(_ulogMessage('F', _ulogCameraTriggerFormat));
+    log.append(_ulogMessage('F', _ulogGlobalPositionFormat));
+    log.append(_ulogMessage('F', _ulogSensorFormat));
+    log.append(_ulogSubscription(0, 0, "sensor_combined"));
+    log.append(_ulogSubscription(0, 1, "vehicle_global_position"));
+    log.append(_ulogSubscription(0, 2, "camera_trigger"));
+    for (int i=0; i<20000; i++) {
+        log.append(_ulogData(0, QByteArray(_ulogSensorPayloadLength, (char)i)));
+        if (i % 10 == 0) {
+            log.append(_ulogData(1, _globalPosition(i, 47.0 + i * 1e-6, 8.0, 500.0f)));
+        }
+        if (i % 100 == 0) {
+            log.append(_ulogData(2, _cameraTrigger(i, i / 100)));
+        }
+    }
+
+    QVERIFY(_tempDir.isValid());
+
+    QString errorString;
+    QScopedPointer<FlightLogReader> reader(FlightLogReader::open(_writeLog(log, "subset.ulg"), errorString));
+    QVERIFY(reader);
+
+    QStringList messages;
+    messages << "camera_trigger" << "vehicle_global_position";
+
+    // Indexing in steps must give the same index as a single pass
+    int steps = 0;
+    reader->startIndex(messages);
+    while (reader->continueIndex(64 * 1024)) {
+        steps++;
+    }
+    QVERIFY(steps > 1);
+    QCOMPARE(reader->indexPosition(), (qint64)log.size());
+    QVERIFY(!reader->hasRecords("sensor_combined"));
+    QVERIFY(reader->messageNames().contains("sensor_combined"));
+    QCOMPARE(reader->offsets("vehicle_global_position").count(), 2000);
+    QCOMPARE(reader->offsets("camera_trigger").count(), 200);
+    QCOMPARE(reader->indexedRecords(), (quint64)2200);
+
+    QVector<qint64> steppedOffsets = reader->offsets("camera_trigger");
+    reader->buildIndex(messages);
+    QCOMPARE(reader->offsets("camera_trigger"), steppedOffsets);
+
+    FlightLogReader::Field_t    seq = reader->field("camera_trigger", "seq");
+    FlightLogReader::Record_t   record;
+    for (int i=0; i<steppedOffsets.count(); i++) {
+        QVERIFY(reader->readRecord(steppedOffsets[i], record));
+        QCOMPARE(FlightLogReader::value(record, seq), (double)i);
+    }
+
+    reader->buildIndex();
+    QCOMPARE(reader->offsets("sensor_combined").count(), 20000);
+}
+
+void FlightLogReaderTest::_unsupportedLog_test(void)
+{
+    QVERIFY(_tempDir.isValid());
+
+    QString errorString;
+    QScopedPointer<FlightLogReader> reader(FlightLogReader::open(_writeLog(QByteArray(1024, 'x'), "unsupported.log"), errorString));
+    QVERIFY(!reader);
+    QVERIFY(!errorString.isEmpty());
+
+    errorString.clear();
+    reader.reset(FlightLogReader::open(QDir(_tempDir.path()).filePath("missing.ulg"), errorString));
+    QVERIFY(!reader);
+    QVERIFY(!errorString.isEmpty());
+}
+
+/// Synthetic ULog of the specified size: a high rate sensor topic, global position at a tenth of its rate and
+/// camera triggers at a hundredth
+bool FlightLogReaderTest::_writeBenchmarkLog(const QString& fileName, qint64 bytes, int& triggerCount, int& positionCount)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    QByteArray chunk;
+    chunk.append(_ulogHeader());
+    chunk.append(_ulogMessage('F', _ulogCameraTriggerFormat));
+    chunk.append(_ulogMessage('F', _ulogGlobalPositionFormat));
+    chunk.append(_ulogMessage('F', _ulogSensorFormat));
+    chunk.append(_ulogSubscription(0, 0, "sensor_combined"));
+    chunk.append(_ulogSubscription(0, 1, "vehicle_global_position"));
+    chunk.append(_ulogSubscription(0, 2, "camera_trigger"));
+
+    QByteArray  sensor = _ulogData(0, QByteArray(_ulogSensorPayloadLength, 0x55));
+    qint64      written = 0;
+
+    triggerCount = 0;
+    positionCount = 0;
+    for (quint64 i=0; written < bytes; i++) {
+        chunk.append(sensor);
+        if (i % 10 == 0) {
+            chunk.append(_ulogData(1, _globalPosition(i * 1000, 47.0 + positionCount * 1e-7, 8.0, 500.0f)));
+            positionCount++;
+        }
+        if (i % 100 == 0) {
+            chunk.append(_ulogData(2, _cameraTrigger(i * 1000, triggerCount++)));
+        }
+        if (chunk.size() >= 1024 * 1024) {
+            if (file.write(chunk) != chunk.size()) {
+                return false;
+            }
+            written += chunk.size();
+            chunk.clear();
+        }
+    }
+
+    return file.write(chunk) == chunk.size();
+}
+
+/// A small log from the benchmark generator, spanning several write chunks, must index completely
+void FlightLogReaderTest::_indexLog_test(void)
+{
+    int triggerCount;
+    int positionCount;
+
+    QVERIFY(_tempDir.isValid());
+    QString logFilename = QDir(_tempDir.path()).filePath("index.ulg");
+    QVERIFY(_writeBenchmarkLog(logFilename, 2 * 1024 * 1024, triggerCount, positionCount));
+
+    QString errorString;
+    QScopedPointer<FlightLogReader> reader(FlightLogReader::open(logFilename, errorString));
+    QVERIFY2(reader, qPrintable(errorString));
+
+    QStringList messages;
+    messages << "camera_trigger" << "vehicle_global_position";
+    reader->buildIndex(messages);
+
+    QCOMPARE(reader->indexPosition(), reader->fileSize());
+    QCOMPARE(reader->skippedBytes(), (qint64)0);
+    QCOMPARE(reader->offsets("camera_trigger").count(), triggerCount);
+    QCOMPARE(reader->offsets("vehicle_global_position").count(), positionCount);
+    QCOMPARE(reader->indexedRecords(), (quint64)(triggerCount + positionCount));
+
+    FlightLogReader::Field_t    seq = reader->field("camera_trigger", "seq");
+    FlightLogReader::Record_t   record;
+    QVERIFY(reader->readRecord(reader->offsets("camera_trigger").last(), record));
+    QCOMPARE(FlightLogReader::value(record, seq), (double)(triggerCount - 1));
+}
+
+/// Index build and stream pull throughput, the GeoTagController access pattern
+void FlightLogReaderTest::_index_benchmark(void)
+{
+    QString logFilename = QString::fromLocal8Bit(qgetenv("QGC_FLIGHTLOG_BENCHMARK_LOG"));
+    int     triggerCount = -1;
+    int     positionCount = -1;
+
+    if (logFilename.isEmpty()) {
+        bool    ok;
+        qint64  megabytes = qgetenv("QGC_FLIGHTLOG_BENCHMARK_MB").toLongLong(&ok);
+        if (!ok || megabytes <= 0) {
+            megabytes = 64;
+        }
+
+        QVERIFY(_tempDir.isValid());
+        logFilename = QDir(_tempDir.path()).filePath("benchmark.ulg");
+        QVERIFY(_writeBenchmarkLog(logFilename, megabytes * 1024 * 1024, triggerCount, positionCount));
+    }
+
+    QString errorString;
+    QScopedPointer<FlightLogReader> reader(FlightLogReader::open(logFilename, errorString));
+    QVERIFY2(reader, qPrintable(errorString));
+
+    QStringList messages;
+    if (dynamic_cast<ULogReader*>(reader.data())) {
+        messages << "camera_trigger" << "vehicle_global_position";
+    } else {
+        messages << "TRIG" << "GPOS" << "CAM";
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    reader->buildIndex(messages);
+    qint64 indexMSecs = qMax(timer.elapsed(), (qint64)1);
+
+    if (triggerCount >= 0) {
+        QCOMPARE(reader->offsets("camera_trigger").count(), triggerCount);
+        QCOMPARE(reader->offsets("vehicle_global_position").count(), positionCount);
+    }
+
+    // Pull every indexed record of the requested messages, decoding one field each
+    quint64 records = 0;
+    double  sum = 0;
+    timer.restart();
+    foreach (const QString& message, messages) {
+        FlightLogReader::Field_t    field = reader->field(message, dynamic_cast<ULogReader*>(reader.data()) ? "timestamp" : "TimeUS");
+        FlightLogReader::Record_t   record;
+        foreach (qint64 offset, reader->offsets(message)) {
+            QVERIFY(reader->readRecord(offset, record));
+            sum += FlightLogReader::value(record, field);
+            records++;
+        }
+    }
+    qint64 pullMSecs = qMax(timer.elapsed(), (qint64)1);
+
+    double megabytes = reader->fileSize() / (1024.0 * 1024.0);
+    qDebug() << "Benchmark log" << logFilename << "MB" << megabytes;
+    qDebug() << "Index build" << indexMSecs << "msecs" << megabytes / (indexMSecs / 1000.0) << "MB/s,"
+             << reader->indexedRecords() << "records indexed," << reader->skippedBytes() << "bytes skipped";
+    qDebug() << "Stream pull" << pullMSecs << "msecs" << records << "records" << (records * 1000.0) / pullMSecs << "records/s" << sum;
+}
@@ -0,0 +1,58 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#ifndef FlightLogReaderTest_H
+#define FlightLogReaderTest_H
+
+#include "UnitTest.h"
+
+#include <QTemporaryDir>
+
+/// Unit test and benchmark for FlightLogReader, ULogReader and DataFlashLogReader, using synthetic logs.
+///
+/// The index benchmark only runs with --unittest-benchmark. It generates a synthetic ULog of QGC_FLIGHTLOG_BENCHMARK_MB
+/// megabytes (default 64, use 1024 for a 1 GB log). Set QGC_FLIGHTLOG_BENCHMARK_LOG to the path of a real ULog or
+/// DataFlash log to benchmark that instead.
+class FlightLogReaderTest : public UnitTest
+{
+    Q_OBJECT
+
+public:
+    FlightLogReaderTest(void);
+
+private slots:
+    void _dataFlashDecode_test(void);
+    void _dataFlashChunkBoundary_test(void);
+    void _dataFlashResync_test(void);
+    void _dataFlashTruncated_test(void);
+    void _ulogDecode_test(void);
+    void _indexSubset_test(void);
+    void _unsupportedLog_test(void);
+    void _indexLog_test(void);
+    void _index_benchmark(void);
+
+private:
+    QByteArray  _dataFlashFormat(uint8_t type, uint8_t length, const char* name, const char* format, const char* labels);
+    QByteArray  _dataFlashRecord(uint8_t type, const QByteArray& payload);
+    QByteArray  _ulogHeader(void);
+    QByteArray  _ulogMessage(char type, const QByteArray& payload);
+    QByteArray  _ulogSubscription(uint8_t multiId, uint16_t msgId, const char* name);
+    QByteArray  _ulogData(uint16_t msgId, const QByteArray& payload);
+    QByteArray  _cameraTrigger(quint64 timestamp, quint32 seq);
+    QByteArray  _globalPosition(quint64 timestamp, double lat, double lon, float alt);
+    bool        _writeBenchmarkLog(const QString& fileName, qint64 bytes, int& triggerCount, int& positionCount);
+    QString     _writeLog(const QByteArray& log, const QString& name);
+
+    QTemporaryDir _tempDir;
+
+    static const uint8_t _gposType =    16;
+    static const uint8_t _triggerType = 55;
+};
+
+#endif
@@ -9,6 +9,7 @@
 
 #include "GeoTagController.h"
 #include "ExifParser.h"
+#include "FlightLogReader.h"
 #include "QGCFileDialog.h"
 #include "QGCLoggingCategory.h"
 #include "MainWindow.h"
@@ -16,8 +17,31 @@
 #include <QtEndian>
 #include <QMessageBox>
 #include <QDebug>
+#include <QtConcurrent>
+#include <QScopedPointer>
 #include <cfloat>
 
+static const int _progressIntervalMSecs =   100;        ///< How often progress is updated while images are processed
+static const int _copyChunkBytes =          256 * 1024; ///< Image data following the EXIF header is copied in chunks of this size
+static const int _indexStepBytes =          4 * 1024 * 1024;    ///< Log bytes indexed between progress updates and cancel checks
+
+/// Names of the camera trigger and position messages, and their fields, in the supported log formats
+typedef struct {
+    const char* triggerMessage;
+    const char* triggerTime;        ///< Usecs
+    const char* triggerSequence;    ///< NULL if the log does not have one
+    const char* positionMessage;
+    const char* latitude;           ///< Degrees
+    const char* longitude;          ///< Degrees
+    const char* altitude;           ///< Meters
+} GeoTagLogStreams_t;
+
+static const GeoTagLogStreams_t _rgGeoTagLogStreams[] = {
+    { "camera_trigger", "timestamp",    "seq",  "vehicle_global_position",  "lat",  "lon",  "alt" },    // PX4 ULog
+    { "TRIG",           "Time",         "Seq",  "GPOS",                     "Lat",  "Lon",  "Alt" },    // PX4 sdlog2
+    { "CAM",            "TimeUS",       NULL,   "CAM",                      "Lat",  "Lng",  "Alt" },    // ArduPilot DataFlash
+};
+
 GeoTagController::GeoTagController(void)
     : _progress(0)
     , _inProgress(false)
@@ -35,7 +59,7 @@ GeoTagController::~GeoTagController()
 
 void GeoTagController::pickLogFile(void)
 {
-    QString filename = QGCFileDialog::getOpenFileName(MainWindow::instance(), "Select log file load", QString(), "PX4 log file (*.px4log);;All Files (*.*)");
+    QString filename = QGCFileDialog::getOpenFileName(MainWindow::instance(), "Select log file load", QString(), "Flight log file (*.ulg *.px4log *.bin);;All Files (*.*)");
     if (!filename.isEmpty()) {
         _worker.setLogFile(filename);
         emit logFileChanged(filename);
@@ -172,32 +196,24 @@ void GeoTagWorker::run(void)
     emit progressChanged((100/nSteps));
 
     // Parse EXIF
-    ExifParser exifParser;
-    _tagTime.clear();
-    for (int i = 0; i < _imageList.size(); ++i) {
-        QFile file(_imageList.at(i).absoluteFilePath());
-        if (!file.open(QIODevice::ReadOnly)) {
+    QFuture<double> timeFuture = QtConcurrent::mapped(_imageList, _readImageTime);
+    if (!_waitForImages(timeFuture, 100/nSteps, 100/nSteps)) {
+        qCDebug(GeotaggingLog) << "Tagging cancelled";
+        emit error(tr("Tagging cancelled"));
+        return;
+    }
+    _tagTime = timeFuture.results();
+    foreach (double tagTime, _tagTime) {
+        if (qIsNaN(tagTime)) {
             emit error(tr("Geotagging failed. Couldn't open an image."));
             return;
         }
-        QByteArray imageBuffer = file.readAll();
-        file.close();
-
-        _tagTime.append(exifParser.readTime(imageBuffer));
-
-        emit progressChanged((100/nSteps) + ((100/nSteps) / _imageList.size())*i);
-
-        if (_cancel) {
-            qCDebug(GeotaggingLog) << "Tagging cancelled";
-            emit error(tr("Tagging cancelled"));
-            return;
-        }
     }
 
-    // Load PX4 log
+    // Load log
     _geoRef.clear();
     _triggerTime.clear();
-    if (!parsePX4Log()) {
+    if (!parseLog(2*(100/nSteps), 100/nSteps)) {
         if (_cancel) {
             qCDebug(GeotaggingLog) << "Tagging cancelled";
             emit error(tr("Tagging cancelled"));
@@ -235,144 +251,203 @@ void GeoTagWorker::run(void)
     // Tag images
     int maxIndex = std::min(_imageIndices.count(), _triggerIndices.count());
     maxIndex = std::min(maxIndex, _imageList.count());
+    QList<TagJob_t> tagJobs;
     for(int i = 0; i < maxIndex; i++) {
-        QFile fileRead(_imageList.at(_imageIndices[i]).absoluteFilePath());
-        if (!fileRead.open(QIODevice::ReadOnly)) {
-            emit error(tr("Geotagging failed. Couldn't open an image."));
-            return;
-        }
-        QByteArray imageBuffer = fileRead.readAll();
-        fileRead.close();
-
-        if (!exifParser.write(imageBuffer, _geoRef[_triggerIndices[i]])) {
-            emit error(tr("Geotagging failed. Couldn't write to image."));
-            return;
+        TagJob_t job;
+        job.sourceFile = _imageList.at(_imageIndices[i]).absoluteFilePath();
+        if(_saveDirectory == "") {
+            job.targetFile = _imageDirectory + "/TAGGED/" + _imageList.at(_imageIndices[i]).fileName();
         } else {
-            QFile fileWrite;
-            if(_saveDirectory == "") {
-                fileWrite.setFileName(_imageDirectory + "/TAGGED/" + _imageList.at(_imageIndices[i]).fileName());
-            } else {
-                fileWrite.setFileName(_saveDirectory + "/" + _imageList.at(_imageIndices[i]).fileName());
-            }
-            if (!fileWrite.open(QFile::WriteOnly)) {
-                emit error(tr("Geotagging failed. Couldn't write to an image."));
-                return;
-            }
-            fileWrite.write(imageBuffer);
-            fileWrite.close();
-        }
-        emit progressChanged(4*(100/nSteps) + ((100/nSteps) / maxIndex)*i);
-
-        if (_cancel) {
-            qCDebug(GeotaggingLog) << "Tagging cancelled";
-            emit error(tr("Tagging cancelled"));
-            return;
+            job.targetFile = _saveDirectory + "/" + _imageList.at(_imageIndices[i]).fileName();
         }
+        job.coordinate = _geoRef[_triggerIndices[i]];
+        tagJobs.append(job);
     }
 
-    if (_cancel) {
+    QFuture<QString> tagFuture = QtConcurrent::mapped(tagJobs, _tagImage);
+    if (!_waitForImages(tagFuture, 4*(100/nSteps), 100/nSteps)) {
         qCDebug(GeotaggingLog) << "Tagging cancelled";
         emit error(tr("Tagging cancelled"));
         return;
     }
+    foreach (const QString& tagError, tagFuture.results()) {
+        if (!tagError.isEmpty()) {
+            emit error(tagError);
+            return;
+        }
+    }
 
     emit progressChanged(100);
 }
 
-bool GeoTagWorker::parsePX4Log()
+/// Waits for images to be processed on the thread pool, updating progress as it goes
+/// @return false: tagging was cancelled
+bool GeoTagWorker::_waitForImages(QFuture<void> future, double progressStart, double progressSpan)
 {
-    // general message header
-    char header[] = {(char)0xA3, (char)0x95, (char)0x00};
-    // header for GPOS message header
-    char gposHeaderHeader[] = {(char)0xA3, (char)0x95, (char)0x80, (char)0x10, (char)0x00};
-    int gposHeaderOffset;
-    // header for GPOS message
-    char gposHeader[] = {(char)0xA3, (char)0x95, (char)0x10, (char)0x00};
-    int gposOffsets[3] = {3, 7, 11};
-    int gposLengths[3] = {4, 4, 4};
-    // header for trigger message header
-    char triggerHeaderHeader[] = {(char)0xA3, (char)0x95, (char)0x80, (char)0x37, (char)0x00};
-    int triggerHeaderOffset;
-    // header for trigger message
-    char triggerHeader[] = {(char)0xA3, (char)0x95, (char)0x37, (char)0x00};
-    int triggerOffsets[2] = {3, 11};
-    int triggerLengths[2] = {8, 4};
-
-    // load log
-    QFile file(_logFile);
+    while (!future.isFinished()) {
+        if (_cancel) {
+            future.cancel();
+            future.waitForFinished();
+            return false;
+        }
+        if (future.progressMaximum() > 0) {
+            emit progressChanged(progressStart + (progressSpan * future.progressValue()) / future.progressMaximum());
+        }
+        msleep(_progressIntervalMSecs);
+    }
+
+    return !_cancel;
+}
+
+/// Runs on the thread pool
+/// @return Creation time from the EXIF header, -1 if the header can't be decoded, NaN if the image can't be read
+double GeoTagWorker::_readImageTime(const QFileInfo& imageInfo)
+{
+    QFile       file(imageInfo.absoluteFilePath());
+    ExifParser  exifParser;
+    QByteArray  header;
+
     if (!file.open(QIODevice::ReadOnly)) {
-        qCDebug(GeotaggingLog) << "Could not open log file " << _logFile;
-        return false;
+        return qQNaN();
+    }
+    if (!exifParser.readHeader(file, header)) {
+        return -1.0;
+    }
+
+    return exifParser.readTime(header);
+}
+
+/// Runs on the thread pool. Only the EXIF header is modified, the image data following it is copied as is.
+/// @return Error message, empty if the image was tagged
+QString GeoTagWorker::_tagImage(const TagJob_t& job)
+{
+    QFile       fileRead(job.sourceFile);
+    ExifParser  exifParser;
+    QByteArray  header;
+
+    if (!fileRead.open(QIODevice::ReadOnly) || !exifParser.readHeader(fileRead, header)) {
+        return tr("Geotagging failed. Couldn't open an image.");
+    }
+    qint64 imageDataOffset = header.size();
+
+    if (!exifParser.write(header, job.coordinate)) {
+        return tr("Geotagging failed. Couldn't write to image.");
     }
-    QByteArray log = file.readAll();
-    file.close();
 
-    // extract header information: message lengths
-    uint8_t* iptr = reinterpret_cast<uint8_t*>(log.mid(log.indexOf(gposHeaderHeader) + 4, 1).data());
-    gposHeaderOffset = static_cast<int>(qFromLittleEndian(*iptr));
-    iptr = reinterpret_cast<uint8_t*>(log.mid(log.indexOf(triggerHeaderHeader) + 4, 1).data());
-    triggerHeaderOffset = static_cast<int>(qFromLittleEndian(*iptr));
+    QFile fileWrite(job.targetFile);
+    if (!fileWrite.open(QFile::WriteOnly) || fileWrite.write(header) != header.size() || !fileRead.seek(imageDataOffset)) {
+        return tr("Geotagging failed. Couldn't write to an image.");
+    }
+    while (!fileRead.atEnd()) {
+        QByteArray chunk = fileRead.read(_copyChunkBytes);
+        if (chunk.isEmpty() || fileWrite.write(chunk) != chunk.size()) {
+            return tr("Geotagging failed. Couldn't write to an image.");
+        }
+    }
+
+    return QString();
+}
 
-    // extract trigger data
-    int index = 1;
-    int sequence = -1;
-    QGeoCoordinate lastCoordinate;
-    while(index < log.count() - 1) {
+/// Pulls the camera triggers and positions from the log, only the records of these two messages are decoded
+bool GeoTagWorker::parseLog(double progressStart, double progressSpan)
+{
+    QString errorString;
+    QScopedPointer<FlightLogReader> reader(FlightLogReader::open(_logFile, errorString));
+    if (!reader) {
+        qCDebug(GeotaggingLog) << "Could not open log file " << _logFile << errorString;
+        return false;
+    }
 
+    QStringList messages;
+    for (size_t i=0; i<sizeof(_rgGeoTagLogStreams)/sizeof(_rgGeoTagLogStreams[0]); i++) {
+        messages << _rgGeoTagLogStreams[i].triggerMessage << _rgGeoTagLogStreams[i].positionMessage;
+    }
+    reader->startIndex(messages);
+    while (reader->continueIndex(_indexStepBytes)) {
         if (_cancel) {
             return false;
         }
+        emit progressChanged(progressStart + (progressSpan * reader->indexPosition()) / qMax(reader->fileSize(), (qint64)1));
+    }
 
-        // first extract trigger
-        index = log.indexOf(triggerHeader, index + 1);
-        // check for whether last entry has been passed
-        if (index < 0) {
+    const GeoTagLogStreams_t* streams = NULL;
+    for (size_t i=0; i<sizeof(_rgGeoTagLogStreams)/sizeof(_rgGeoTagLogStreams[0]); i++) {
+        if (reader->hasRecords(_rgGeoTagLogStreams[i].triggerMessage)) {
+            streams = &_rgGeoTagLogStreams[i];
             break;
         }
+    }
+    if (!streams) {
+        qCDebug(GeotaggingLog) << "No camera trigger messages in log";
+        return true;
+    }
 
-        if (log.indexOf(header, index + 1) != index + triggerHeaderOffset) {
-            continue;
-        }
-        uint64_t* time = reinterpret_cast<uint64_t*>(log.mid(index + triggerOffsets[0], triggerLengths[0]).data());
-        double timeDouble = static_cast<double>(qFromLittleEndian(*time)) / 1.0e6;
-        uint32_t* seq = reinterpret_cast<uint32_t*>(log.mid(index + triggerOffsets[1], triggerLengths[1]).data());
-        int seqInt = static_cast<int>(qFromLittleEndian(*seq));
-        if (sequence >= seqInt || sequence + 20 < seqInt) { // assume that logging has not skipped more than 20 triggers. this prevents wrong header detection
-            continue;
-        }
-        _triggerTime.append(timeDouble);
-        sequence = seqInt;
-
-        // second extract position
-        bool lookForGpos = true;
-        while (lookForGpos) {
+    FlightLogReader::Field_t timeField = reader->field(streams->triggerMessage, streams->triggerTime);
+    FlightLogReader::Field_t sequenceField = reader->field(streams->triggerMessage, streams->triggerSequence ? streams->triggerSequence : "");
+    FlightLogReader::Field_t latField = reader->field(streams->positionMessage, streams->latitude);
+    FlightLogReader::Field_t lonField = reader->field(streams->positionMessage, streams->longitude);
+    FlightLogReader::Field_t altField = reader->field(streams->positionMessage, streams->altitude);
+    if (timeField.type == FlightLogReader::FieldInvalid || latField.type == FlightLogReader::FieldInvalid ||
+            lonField.type == FlightLogReader::FieldInvalid || altField.type == FlightLogReader::FieldInvalid) {
+        qCDebug(GeotaggingLog) << "Camera trigger or position fields missing in log";
+        return false;
+    }
 
-            if (_cancel) {
-                return false;
-            }
+    // Walk both streams in file order, tagging each trigger with the first position logged after it. A message which
+    // is both (ArduPilot CAM) is a trigger first, then the position for it.
+    const QVector<qint64>&      triggerOffsets = reader->offsets(streams->triggerMessage);
+    const QVector<qint64>&      positionOffsets = reader->offsets(streams->positionMessage);
+    bool                        sameMessage = QString(streams->triggerMessage) == streams->positionMessage;
+    int                         triggerIndex = 0;
+    int                         positionIndex = 0;
+    double                      sequence = -1;
+    int                         pendingTriggers = 0;    ///< Triggers waiting for the next position
+    QGeoCoordinate              lastCoordinate;
+    FlightLogReader::Record_t   record;
+
+    while (triggerIndex < triggerOffsets.count() || (pendingTriggers && positionIndex < positionOffsets.count())) {
+        if (_cancel) {
+            return false;
+        }
 
-            int gposIndex = log.indexOf(gposHeader, index + 1);
-            if (gposIndex < 0) {
-                _geoRef.append(lastCoordinate);
-                break;
+        bool nextIsTrigger = triggerIndex < triggerOffsets.count() &&
+                (positionIndex >= positionOffsets.count() || triggerOffsets[triggerIndex] < positionOffsets[positionIndex] ||
+                 (sameMessage && triggerIndex == positionIndex));
+
+        if (nextIsTrigger) {
+            if (reader->readRecord(triggerOffsets[triggerIndex++], record)) {
+                double seq = sequenceField.type == FlightLogReader::FieldInvalid ? sequence + 1 : FlightLogReader::value(record, sequenceField);
+                if (seq > sequence) {
+                    _triggerTime.append(FlightLogReader::value(record, timeField) / 1.0e6);
+                    sequence = seq;
+                    pendingTriggers++;
+                }
             }
-            index = gposIndex;
-            // verify that at an offset of gposHeaderOffset the next log message starts
-            if (gposIndex + gposHeaderOffset == log.indexOf(header, gposIndex + 1)) {
-                int32_t* lat = reinterpret_cast<int32_t*>(log.mid(gposIndex + gposOffsets[0], gposLengths[0]).data());
-                double latitude = static_cast<double>(qFromLittleEndian(*lat))/1.0e7;
+        } else {
+            if (reader->readRecord(positionOffsets[positionIndex++], record)) {
+                double latitude = FlightLogReader::value(record, latField);
+                double longitude = FlightLogReader::value(record, lonField);
+                double altitude = FlightLogReader::value(record, altField);
+                if (qIsNaN(latitude) || qIsNaN(longitude) || qIsNaN(altitude)) {
+                    continue;
+                }
                 lastCoordinate.setLatitude(latitude);
-                int32_t* lon = reinterpret_cast<int32_t*>(log.mid(gposIndex + gposOffsets[1], gposLengths[1]).data());
-                double longitude = static_cast<double>(qFromLittleEndian(*lon))/1.0e7;
-                longitude = fmod(180.0 + longitude, 360.0) - 180.0;
-                lastCoordinate.setLongitude(longitude);
-                float* alt = reinterpret_cast<float*>(log.mid(gposIndex + gposOffsets[2], gposLengths[2]).data());
-                lastCoordinate.setAltitude(qFromLittleEndian(*alt));
-                _geoRef.append(lastCoordinate);
-                break;
+                lastCoordinate.setLongitude(fmod(180.0 + longitude, 360.0) - 180.0);
+                lastCoordinate.setAltitude(altitude);
+
+                for (; pendingTriggers > 0; pendingTriggers--) {
+                    _geoRef.append(lastCoordinate);
+                }
             }
         }
     }
+
+    for (; pendingTriggers > 0; pendingTriggers--) {
+        _geoRef.append(lastCoordinate);
+    }
+
+    qCDebug(GeotaggingLog) << "Log parsed, indexed records" << reader->indexedRecords() << "skipped bytes" << reader->skippedBytes();
+
     return true;
 }
 
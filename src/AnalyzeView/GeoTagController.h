@@ -18,9 +18,13 @@
 #include <QThread>
 #include <QFileInfoList>
 #include <QElapsedTimer>
+#include <QFuture>
 #include <QDebug>
 #include <QGeoCoordinate>
 
+/// Geotags the images on its own thread. EXIF times are read and images are tagged in parallel on the global
+/// QThreadPool, reading only the EXIF header of each image to get its time. The log is indexed by FlightLogReader and
+/// only the camera trigger and position records are decoded.
 class GeoTagWorker : public QThread
 {
     Q_OBJECT
@@ -47,8 +51,18 @@ signals:
     void progressChanged    (double progress);
 
 private:
-    bool parsePX4Log();
+    typedef struct {
+        QString         sourceFile;
+        QString         targetFile;
+        QGeoCoordinate  coordinate;
+    } TagJob_t;
+
+    bool parseLog(double progressStart, double progressSpan);
     bool triggerFiltering();
+    bool _waitForImages(QFuture<void> future, double progressStart, double progressSpan);
+
+    static double   _readImageTime  (const QFileInfo& imageInfo);
+    static QString  _tagImage       (const TagJob_t& job);
 
     bool                    _cancel;
     QString                 _logFile;
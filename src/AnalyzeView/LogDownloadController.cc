@@ -9,6 +9,7 @@
 
 
 #include "LogDownloadController.h"
+#include "LogDownloadWindow.h"
 #include "MultiVehicleManager.h"
 #include "QGCMAVLink.h"
 #include "QGCFileDialog.h"
@@ -22,55 +23,29 @@
 #include <QDebug>
 #include <QSettings>
 #include <QUrl>
-#include <QBitArray>
-#include <QtCore/qmath.h>
 
 #define kTimeOutMilliseconds 500
 #define kGUIRateMilliseconds 17
-#define kTableBins           512
-#define kChunkSize           (kTableBins * MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN)
+#define kSaveBinsMilliseconds 1000
+#define kBinsFileSuffix      ".bins"
 
 QGC_LOGGING_CATEGORY(LogDownloadLog, "LogDownloadLog")
 
 //-----------------------------------------------------------------------------
 struct LogDownloadData {
     LogDownloadData(QGCLogEntry* entry);
-    QBitArray     chunk_table;
-    uint32_t      current_chunk;
+    LogDownloadWindow window;
     QFile         file;
     QString       filename;
+    QString       binsFilename;     // Received bins, kept next to the log file until it is complete
     uint          ID;
     QGCLogEntry*  entry;
     uint          written;
     size_t        rate_bytes;
     qreal         rate_avg;
     QElapsedTimer elapsed;
-
-    void advanceChunk()
-    {
-           current_chunk++;
-           chunk_table = QBitArray(chunkBins(), false);
-    }
-
-    // The number of MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN bins in the current chunk
-    uint32_t chunkBins() const
-    {
-        return qMin(qCeil((entry->size() - current_chunk*kChunkSize)/static_cast<qreal>(MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN)),
-                    kTableBins);
-    }
-
-    // The number of kChunkSize chunks in the file
-    uint32_t numChunks() const
-    {
-        return qCeil(entry->size() / static_cast<qreal>(kChunkSize));
-    }
-
-    // True if all bins in the chunk have been set to val
-    bool chunkEquals(const bool val) const
-    {
-        return chunk_table == QBitArray(chunk_table.size(), val);
-    }
-
+    QElapsedTimer clock;
+    qint64        savedMsecs;
 };
 
 //----------------------------------------------------------------------------------------
@@ -80,8 +55,9 @@ LogDownloadData::LogDownloadData(QGCLogEntry* entry_)
     , written(0)
     , rate_bytes(0)
     , rate_avg(0)
+    , savedMsecs(0)
 {
-
+    clock.start();
 }
 
 //----------------------------------------------------------------------------------------
@@ -124,7 +100,7 @@ LogDownloadController::_processDownload()
 {
     if(_requestingLogEntries) {
         _findMissingEntries();
-    } else if(_downloadingLogs) {
+    } else if(_downloadingLogs && _downloadData) {
         _findMissingData();
     }
 }
@@ -133,6 +109,16 @@ LogDownloadController::_processDownload()
 void
 LogDownloadController::_setActiveVehicle(Vehicle* vehicle)
 {
+    //-- Keep what we have so far, the download resumes once the vehicle is back
+    if(_downloadData) {
+        _interruptDownload(QString("Interrupted"));
+    }
+    if(_vehicle) {
+        _timer.stop();
+        _resetSelection();
+        _setDownloading(false);
+        _setListing(false);
+    }
     if(_uas) {
         _logEntriesModel.clear();
         disconnect(_uas, &UASInterface::logEntry, this, &LogDownloadController::_logEntry);
@@ -312,87 +298,76 @@ LogDownloadController::_logData(UASInterface* uas, uint32_t ofs, uint16_t id, ui
         return;
     }
 
-    bool result = false;
-    uint32_t timeout_time = kTimeOutMilliseconds;
-    if(ofs <= _downloadData->entry->size()) {
-        const uint32_t chunk = ofs / kChunkSize;
-        if (chunk != _downloadData->current_chunk) {
-            qWarning() << "Ignored packet for out of order chunk" << chunk;
-            return;
-        }
-        const uint16_t bin = (ofs - chunk*kChunkSize) / MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN;
-        if (bin >= _downloadData->chunk_table.size()) {
-            qWarning() << "Out of range bin received";
-        } else
-            _downloadData->chunk_table.setBit(bin);
+    if(ofs >= _downloadData->entry->size()) {
+        qWarning() << "Received log offset greater than expected";
+        _downloadData->entry->setStatus(QString("Error"));
+        return;
+    }
+
+    qint64 now = _downloadData->clock.elapsed();
+    //-- Bins already received, resent as part of a request spanning several gaps, are not written again
+    if(_downloadData->window.received(ofs, count, now)) {
         if (_downloadData->file.pos() != ofs) {
             // Seek to correct position
             if (!_downloadData->file.seek(ofs)) {
                 qWarning() << "Error while seeking log file offset";
+                _downloadData->entry->setStatus(QString("Error"));
                 return;
             }
         }
 
         //-- Write chunk to file
-        if(_downloadData->file.write((const char*)data, count)) {
-            _downloadData->written += count;
-            _downloadData->rate_bytes += count;
-            if (_downloadData->elapsed.elapsed() >= kGUIRateMilliseconds) {
-                //-- Update download rate
-                qreal rrate = _downloadData->rate_bytes/(_downloadData->elapsed.elapsed()/1000.0);
-                _downloadData->rate_avg = _downloadData->rate_avg*0.95 + rrate*0.05;
-                _downloadData->rate_bytes = 0;
-
-                //-- Update status
-                const QString status = QString("%1 (%2/s)").arg(QGCMapEngine::bigSizeToString(_downloadData->written),
-                                                                QGCMapEngine::bigSizeToString(_downloadData->rate_avg));
-
-                _downloadData->entry->setStatus(status);
-                _downloadData->elapsed.start();
-            }
-            result = true;
-            //-- reset retries
-            _retries = 0;
-            //-- Reset timer
-            _timer.start(timeout_time);
-            //-- Do we have it all?
-            if(_logComplete()) {
-                _downloadData->entry->setStatus(QString("Downloaded"));
-                //-- Check for more
-                _receivedAllData();
-            } else if (_chunkComplete()) {
-                _downloadData->advanceChunk();
-                _requestLogData(_downloadData->ID,
-                                _downloadData->current_chunk*kChunkSize,
-                                _downloadData->chunk_table.size()*MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN);
-            } else if (bin < _downloadData->chunk_table.size() - 1 && _downloadData->chunk_table.at(bin+1)) {
-                // Likely to be grabbing fragments and got to the end of a gap
-                _findMissingData();
-            }
-        } else {
+        if(!_downloadData->file.write((const char*)data, count)) {
             qWarning() << "Error while writing log file chunk";
+            _downloadData->entry->setStatus(QString("Error"));
+            return;
         }
-    } else {
-        qWarning() << "Received log offset greater than expected";
-    }
-    if(!result) {
-        _downloadData->entry->setStatus(QString("Error"));
-    }
-}
 
+        _downloadData->written += count;
+        _downloadData->rate_bytes += count;
+        if (_downloadData->elapsed.elapsed() >= kGUIRateMilliseconds) {
+            //-- Update download rate
+            qreal rrate = _downloadData->rate_bytes/(_downloadData->elapsed.elapsed()/1000.0);
+            _downloadData->rate_avg = _downloadData->rate_avg*0.95 + rrate*0.05;
+            _downloadData->rate_bytes = 0;
 
-//----------------------------------------------------------------------------------------
-bool
-LogDownloadController::_chunkComplete() const
-{
-    return _downloadData->chunkEquals(true);
+            //-- Update status
+            const QString status = QString("%1 (%2/s)").arg(QGCMapEngine::bigSizeToString(_downloadData->window.bytesReceived()),
+                                                            QGCMapEngine::bigSizeToString(_downloadData->rate_avg));
+
+            _downloadData->entry->setStatus(status);
+            _downloadData->elapsed.start();
+        }
+        //-- Keep the received bins on disk so the download survives a crash
+        if (now - _downloadData->savedMsecs >= kSaveBinsMilliseconds) {
+            _saveReceivedBins();
+        }
+    }
+
+    //-- Do we have it all?
+    if(_downloadData->window.complete()) {
+        _logDownloaded();
+    } else {
+        _requestMissingData();
+    }
 }
 
 //----------------------------------------------------------------------------------------
-bool
-LogDownloadController::_logComplete() const
-{
-    return _chunkComplete() && (_downloadData->current_chunk+1) == _downloadData->numChunks();
+void
+LogDownloadController::_logDownloaded()
+{
+    const LogDownloadWindow& window = _downloadData->window;
+    qCDebug(LogDownloadLog) << "Log downloaded: bytes" << _downloadData->written
+                            << "bytes/sec" << window.bytesPerSecond(_downloadData->clock.elapsed())
+                            << "rtt" << window.rttMsecs()
+                            << "requests" << window.requestCount()
+                            << "timeouts" << window.timeoutCount()
+                            << "duplicate bins" << window.duplicateBinCount();
+    _downloadData->file.close();
+    QFile::remove(_downloadData->binsFilename);
+    _downloadData->entry->setStatus(QString("Downloaded"));
+    //-- Check for more
+    _receivedAllData();
 }
 
 //----------------------------------------------------------------------------------------
@@ -402,8 +377,13 @@ LogDownloadController::_receivedAllData()
     _timer.stop();
     //-- Anything queued up for download?
     if(_prepareLogDownload()) {
-        //-- Request Log
-        _requestLogData(_downloadData->ID, 0, _downloadData->chunk_table.size()*MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN);
+        if(_downloadData->window.complete()) {
+            //-- Empty log, or all of it was received before
+            _logDownloaded();
+        } else {
+            //-- Request Log
+            _requestMissingData();
+        }
     } else {
         _resetSelection();
         _setDownloading(false);
@@ -414,38 +394,58 @@ LogDownloadController::_receivedAllData()
 void
 LogDownloadController::_findMissingData()
 {
-    if (_logComplete()) {
-         _receivedAllData();
-         return;
-    } else if (_chunkComplete()) {
-        _downloadData->advanceChunk();
+    if(!_downloadData->window.takeTimedOut(_downloadData->clock.elapsed())) {
+        _requestMissingData();
+        return;
     }
 
-    if(_retries++ > 2) {
-        _downloadData->entry->setStatus(QString("Timed Out"));
-        //-- Give up
+    if(_downloadData->window.retries() >= LogDownloadWindow::maxRetries) {
+        //-- Give up, what we have so far is kept for the next attempt
         qWarning() << "Too many errors retreiving log data. Giving up.";
+        _interruptDownload(QString("Timed Out"));
         _receivedAllData();
         return;
     }
 
-    uint16_t start = 0, end = 0;
-    const int size = _downloadData->chunk_table.size();
-    for (; start < size; start++) {
-        if (!_downloadData->chunk_table.testBit(start)) {
-            break;
-        }
+    qCDebug(LogDownloadLog) << "Log data request timed out, retry" << _downloadData->window.retries() << "timeout" << _downloadData->window.rtoMsecs();
+    _requestMissingData();
+}
+
+//----------------------------------------------------------------------------------------
+void
+LogDownloadController::_requestMissingData()
+{
+    qint64 now = _downloadData->clock.elapsed();
+    LogDownloadWindow::Range range;
+    if(_downloadData->window.takeRequestToSend(now, range)) {
+        _requestLogData(_downloadData->ID, range.first, range.second);
     }
+    int timeout = _downloadData->window.msecsToNextTimeout(now);
+    _timer.start(timeout == -1 ? kTimeOutMilliseconds : qMax(timeout, 1));
+}
 
-    for (end = start; end < size; end++) {
-        if (_downloadData->chunk_table.testBit(end)) {
-            break;
-        }
+//----------------------------------------------------------------------------------------
+void
+LogDownloadController::_saveReceivedBins()
+{
+    if(!_downloadData->window.save(_downloadData->binsFilename, _downloadData->ID, _downloadData->entry->time().toTime_t())) {
+        qWarning() << "Failed to save log download state:" << _downloadData->binsFilename;
     }
+    _downloadData->savedMsecs = _downloadData->clock.elapsed();
+}
 
-    const uint32_t pos = _downloadData->current_chunk*kChunkSize + start*MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN,
-                   len = (end - start)*MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN;
-    _requestLogData(_downloadData->ID, pos, len);
+//----------------------------------------------------------------------------------------
+/// Stops the current download, keeping the partial log file and its received bins so it can be resumed
+void
+LogDownloadController::_interruptDownload(const QString& status)
+{
+    _timer.stop();
+    _downloadData->file.flush();
+    _saveReceivedBins();
+    _downloadData->file.close();
+    _downloadData->entry->setStatus(status);
+    delete _downloadData;
+    _downloadData = NULL;
 }
 
 //----------------------------------------------------------------------------------------
@@ -518,8 +518,7 @@ void LogDownloadController::downloadToDirectory(const QString& dir)
     _receivedAllEntries();
     //-- Reset downloads, again just in case
     if(_downloadData) {
-        delete _downloadData;
-        _downloadData = 0;
+        _interruptDownload(QString("Canceled"));
     }
     _downloadPath = dir;
     if(!_downloadPath.isEmpty()) {
@@ -589,31 +588,40 @@ LogDownloadController::_prepareLogDownload()
         _downloadData->filename += ".bin";
     }
     _downloadData->file.setFileName(_downloadPath + _downloadData->filename);
-    //-- Append a number to the end if the filename already exists
-    if (_downloadData->file.exists()){
-        uint num_dups = 0;
-        QStringList filename_spl = _downloadData->filename.split('.');
-        do {
-            num_dups +=1;
-            _downloadData->file.setFileName(filename_spl[0] + '_' + QString::number(num_dups) + '.' + filename_spl[1]);
-        } while( _downloadData->file.exists());
-    }
-    //-- Create file
-    if (!_downloadData->file.open(QIODevice::WriteOnly)) {
+    _downloadData->binsFilename = _downloadData->file.fileName() + kBinsFileSuffix;
+    //-- Pick up a previous partial download of the same log
+    bool resume = _downloadData->file.exists() &&
+            _downloadData->window.load(_downloadData->binsFilename, entry->id(), entry->size(), entry->time().toTime_t(), _downloadData->clock.elapsed());
+    if (resume) {
+        qCDebug(LogDownloadLog) << "Resuming log download:" << _downloadData->filename << _downloadData->window.bytesReceived() << "bytes already received";
+        _downloadData->written = _downloadData->window.bytesReceived();
+    } else {
+        //-- Append a number to the end if the filename already exists
+        if (_downloadData->file.exists()){
+            uint num_dups = 0;
+            QStringList filename_spl = _downloadData->filename.split('.');
+            do {
+                num_dups +=1;
+                _downloadData->file.setFileName(_downloadPath + filename_spl[0] + '_' + QString::number(num_dups) + '.' + filename_spl[1]);
+            } while( _downloadData->file.exists());
+            _downloadData->binsFilename = _downloadData->file.fileName() + kBinsFileSuffix;
+        }
+        _downloadData->window.start(entry->size(), _downloadData->clock.elapsed());
+    }
+    //-- Create file, or open the partial one without truncating it
+    if (!_downloadData->file.open(resume ? QIODevice::ReadWrite : QIODevice::WriteOnly)) {
         qWarning() << "Failed to create log file:" <<  _downloadData->filename;
     } else {
         //-- Preallocate file
         if(!_downloadData->file.resize(entry->size())) {
             qWarning() << "Failed to allocate space for log file:" <<  _downloadData->filename;
         } else {
-            _downloadData->current_chunk = 0;
-            _downloadData->chunk_table = QBitArray(_downloadData->chunkBins(), false);
             _downloadData->elapsed.start();
             result = true;
         }
     }
     if(!result) {
-        if (_downloadData->file.exists()) {
+        if (!resume && _downloadData->file.exists()) {
             _downloadData->file.remove();
         }
         _downloadData->entry->setStatus(QString("Error"));
@@ -629,7 +637,9 @@ LogDownloadController::_setDownloading(bool active)
 {
     if (_downloadingLogs != active) {
         _downloadingLogs = active;
-        _vehicle->setConnectionLostEnabled(!active);
+        if (_vehicle) {
+            _vehicle->setConnectionLostEnabled(!active);
+        }
         emit downloadingLogsChanged();
     }
 }
@@ -640,7 +650,9 @@ LogDownloadController::_setListing(bool active)
 {
     if (_requestingLogEntries != active) {
         _requestingLogEntries = active;
-        _vehicle->setConnectionLostEnabled(!active);
+        if (_vehicle) {
+            _vehicle->setConnectionLostEnabled(!active);
+        }
         emit requestingListChanged();
     }
 }
@@ -670,12 +682,8 @@ LogDownloadController::cancel(void)
         _receivedAllEntries();
     }
     if(_downloadData) {
-        _downloadData->entry->setStatus(QString("Canceled"));
-        if (_downloadData->file.exists()) {
-            _downloadData->file.remove();
-        }
-        delete _downloadData;
-        _downloadData = 0;
+        //-- The partial log is kept, downloading it again resumes it
+        _interruptDownload(QString("Canceled"));
     }
     _resetSelection(true);
     _setDownloading(false);
@@ -146,13 +146,15 @@ private slots:
 private:
 
     bool _entriesComplete   ();
-    bool _chunkComplete     () const;
-    bool _logComplete       () const;
     void _findMissingEntries();
     void _receivedAllEntries();
     void _receivedAllData   ();
+    void _logDownloaded     ();
     void _resetSelection    (bool canceled = false);
     void _findMissingData   ();
+    void _requestMissingData();
+    void _saveReceivedBins  ();
+    void _interruptDownload (const QString& status);
     void _requestLogList    (uint32_t start, uint32_t end);
     void _requestLogData    (uint8_t id, uint32_t offset = 0, uint32_t count = 0xFFFFFFFF);
     bool _prepareLogDownload();
@@ -9,29 +9,44 @@
 
 #include "LogDownloadTest.h"
 #include "LogDownloadController.h"
+#include "LogDownloadWindow.h"
 #include "MockLink.h"
 
 #include <QDir>
+#include <QSignalSpy>
 
 LogDownloadTest::LogDownloadTest(void)
+    : _controller(NULL)
+    , _multiSpyLogDownloadController(NULL)
 {
 
 }
 
-void LogDownloadTest::downloadTest(void)
+void LogDownloadTest::cleanup(void)
 {
+    delete _multiSpyLogDownloadController;
+    _multiSpyLogDownloadController = NULL;
+    delete _controller;
+    _controller = NULL;
 
-    _connectMockLink(MAV_AUTOPILOT_PX4);
+    UnitTest::cleanup();
+}
 
-    LogDownloadController* controller = new LogDownloadController();
+/// Creates the controller under test along with the spy on its signals, both are deleted by cleanup
+void LogDownloadTest::_createController(void)
+{
+    _controller = new LogDownloadController();
 
     _rgLogDownloadControllerSignals[requestingListChangedSignalIndex] =     SIGNAL(requestingListChanged());
     _rgLogDownloadControllerSignals[downloadingLogsChangedSignalIndex] =    SIGNAL(downloadingLogsChanged());
     _rgLogDownloadControllerSignals[modelChangedSignalIndex] =              SIGNAL(modelChanged());
 
     _multiSpyLogDownloadController = new MultiSignalSpy();
-    QVERIFY(_multiSpyLogDownloadController->init(controller, _rgLogDownloadControllerSignals, _cLogDownloadControllerSignals));
+    QVERIFY(_multiSpyLogDownloadController->init(_controller, _rgLogDownloadControllerSignals, _cLogDownloadControllerSignals));
+}
 
+void LogDownloadTest::_refreshLogList(LogDownloadController* controller)
+{
     controller->refresh();
     QVERIFY(_multiSpyLogDownloadController->waitForSignalByIndex(requestingListChangedSignalIndex, 10000));
     _multiSpyLogDownloadController->clearAllSignals();
@@ -40,27 +55,232 @@ void LogDownloadTest::downloadTest(void)
         QCOMPARE(controller->requestingList(), false);
     }
     _multiSpyLogDownloadController->clearAllSignals();
+}
 
+void LogDownloadTest::_startDownload(LogDownloadController* controller, const QString& downloadTo)
+{
     QGCLogModel* model = controller->model();
     QVERIFY(model);
-    qDebug() << model->count();
+    QVERIFY(model->count() > 0);
     (*model)[0]->setSelected(true);
 
-    QString downloadTo = QDir::currentPath();
-    qDebug() << "download to:" << downloadTo;
     controller->downloadToDirectory(downloadTo);
     QVERIFY(_multiSpyLogDownloadController->waitForSignalByIndex(downloadingLogsChangedSignalIndex, 10000));
     _multiSpyLogDownloadController->clearAllSignals();
+}
+
+void LogDownloadTest::_waitForDownload(LogDownloadController* controller)
+{
     if (controller->downloadingLogs()) {
-        QVERIFY(_multiSpyLogDownloadController->waitForSignalByIndex(downloadingLogsChangedSignalIndex, 10000));
+        QVERIFY(_multiSpyLogDownloadController->waitForSignalByIndex(downloadingLogsChangedSignalIndex, 60000));
         QCOMPARE(controller->downloadingLogs(), false);
     }
     _multiSpyLogDownloadController->clearAllSignals();
+}
+
+void LogDownloadTest::downloadTest(void)
+{
+
+    _connectMockLink(MAV_AUTOPILOT_PX4);
+
+    _createController();
+    LogDownloadController* controller = _controller;
+
+    _refreshLogList(controller);
+    qDebug() << controller->model()->count();
+
+    QString downloadTo = QDir::currentPath();
+    qDebug() << "download to:" << downloadTo;
+    _startDownload(controller, downloadTo);
+    _waitForDownload(controller);
 
     QString downloadFile = QDir(downloadTo).filePath("log_0_UnknownDate.px4log");
     QVERIFY(UnitTest::fileCompare(downloadFile, _mockLink->logDownloadFile()));
+    QVERIFY(!QFile::exists(downloadFile + ".bins"));
+
+    QFile::remove(downloadFile);
+
+}
+
+/// A single request covers the whole log, what the stream lost is requested next
+void LogDownloadTest::_window_test(void)
+{
+    LogDownloadWindow           window;
+    LogDownloadWindow::Range    range;
+    const uint32_t              binSize = LogDownloadWindow::binSize;
+
+    window.start(binSize * 100 + 10, 0);
+    QCOMPARE(window.binCount(), 101);
+    QVERIFY(window.takeRequestToSend(0, range));
+    QCOMPARE(range, LogDownloadWindow::Range(0, binSize * 100 + 10));
+    QVERIFY(!window.takeRequestToSend(0, range));
+    QCOMPARE(window.msecsToNextTimeout(0), (int)LogDownloadWindow::initialRtoMsecs);
+
+    // Stream the log, losing bins 10, 12 and 60
+    for (int bin=0; bin<101; bin++) {
+        if (bin == 10 || bin == 12 || bin == 60) {
+            continue;
+        }
+        QVERIFY(window.received(bin * binSize, bin == 100 ? 10 : binSize, 20 + bin));
+    }
+    QVERIFY(!window.received(0, binSize, 120));
+    QCOMPARE(window.duplicateBinCount(), 1);
+    QCOMPARE(window.rttMsecs(), 20);
+    QVERIFY(!window.outstanding());
+    QVERIFY(!window.complete());
+    QCOMPARE(window.bytesReceived(), binSize * 97 + 10);
+
+    // Bins 10 and 12 are close enough to go out in one request, bin 60 is not
+    QVERIFY(window.takeRequestToSend(120, range));
+    QCOMPARE(range, LogDownloadWindow::Range(10 * binSize, 3 * binSize));
+    QVERIFY(window.received(10 * binSize, binSize, 140));
+    QVERIFY(!window.received(11 * binSize, binSize, 140));
+    QVERIFY(window.received(12 * binSize, binSize, 140));
+    QVERIFY(window.takeRequestToSend(140, range));
+    QCOMPARE(range, LogDownloadWindow::Range(60 * binSize, binSize));
+    QVERIFY(window.received(60 * binSize, binSize, 160));
+    QVERIFY(window.complete());
+    QCOMPARE(window.bytesReceived(), window.logSize());
+    QCOMPARE(window.requestCount(), 3);
+    QVERIFY(!window.takeRequestToSend(160, range));
+}
+
+/// The request times out when data stops, with the timeout backed off until data comes in again
+void LogDownloadTest::_windowTimeout_test(void)
+{
+    LogDownloadWindow           window;
+    LogDownloadWindow::Range    range;
+    const uint32_t              binSize = LogDownloadWindow::binSize;
+
+    window.start(binSize * 10, 0);
+    QVERIFY(window.takeRequestToSend(0, range));
+    QVERIFY(window.received(0, binSize, 50));
+    QVERIFY(window.received(binSize, binSize, 60));
+
+    // Timeout counts from the last data received
+    int rtoMsecs = window.rtoMsecs();
+    QCOMPARE(window.msecsToNextTimeout(60), rtoMsecs);
+    QVERIFY(!window.takeTimedOut(60 + rtoMsecs - 1));
+    QVERIFY(window.takeTimedOut(60 + rtoMsecs));
+    QCOMPARE(window.retries(), 1);
+    QCOMPARE(window.rtoMsecs(), rtoMsecs * 2);
+
+    // Request again from the first missing bin
+    qint64 nowMsecs = 60 + rtoMsecs;
+    QVERIFY(window.takeRequestToSend(nowMsecs, range));
+    QCOMPARE(range, LogDownloadWindow::Range(2 * binSize, 8 * binSize));
+    QVERIFY(window.takeTimedOut(nowMsecs + window.rtoMsecs()));
+    QCOMPARE(window.retries(), 2);
+
+    // Round trip of a retried request is not measured, new data clears the retries
+    nowMsecs += rtoMsecs * 2;
+    int rttMsecs = window.rttMsecs();
+    QVERIFY(window.takeRequestToSend(nowMsecs, range));
+    QVERIFY(window.received(2 * binSize, binSize, nowMsecs + 1000));
+    QCOMPARE(window.rttMsecs(), rttMsecs);
+    QCOMPARE(window.retries(), 0);
+    QCOMPARE(window.timeoutCount(), 2);
+}
+
+/// Received bins survive a save and load, for the same log only
+void LogDownloadTest::_windowSave_test(void)
+{
+    QVERIFY(_tempDir.isValid());
+    QString binsFile = QDir(_tempDir.path()).filePath("window.bins");
+    const uint32_t binSize = LogDownloadWindow::binSize;
+
+    LogDownloadWindow window;
+    window.start(binSize * 50, 0);
+    for (int bin=0; bin<50; bin+=2) {
+        QVERIFY(window.received(bin * binSize, binSize, 0));
+    }
+    QVERIFY(window.save(binsFile, 3, 12345));
+
+    LogDownloadWindow loaded;
+    QVERIFY(!loaded.load(binsFile, 4, binSize * 50, 12345, 0));
+    QVERIFY(!loaded.load(binsFile, 3, binSize * 51, 12345, 0));
+    QVERIFY(!loaded.load(binsFile, 3, binSize * 50, 54321, 0));
+    QVERIFY(loaded.load(binsFile, 3, binSize * 50, 12345, 0));
+    QCOMPARE(loaded.receivedBinCount(), 25);
+    QCOMPARE(loaded.bytesReceived(), binSize * 25);
+
+    LogDownloadWindow::Range range;
+    QVERIFY(loaded.takeRequestToSend(0, range));
+    QCOMPARE(range.first, binSize);
+    for (int bin=1; bin<50; bin+=2) {
+        QVERIFY(loaded.received(bin * binSize, binSize, 10));
+    }
+    QVERIFY(loaded.complete());
+}
+
+/// A canceled download keeps its partial log and picks up from there the next time
+void LogDownloadTest::_resume_test(void)
+{
+    QVERIFY(_tempDir.isValid());
+
+    _connectMockLink(MAV_AUTOPILOT_PX4);
+    _mockLink->setLogDownloadFileSize(_largeLogSize);
+
+    _createController();
+    LogDownloadController* controller = _controller;
+
+    _refreshLogList(controller);
+    _startDownload(controller, _tempDir.path());
+
+    // Cancel as soon as the first data is in, the mock vehicle takes over a second to send the whole log
+    QGCLogEntry* entry = (*controller->model())[0];
+    QSignalSpy spyStatus(entry, &QGCLogEntry::statusChanged);
+    while (!entry->status().endsWith("/s)")) {
+        QVERIFY(spyStatus.wait(10000));
+    }
+    controller->cancel();
+    QCOMPARE(controller->downloadingLogs(), false);
+    QCOMPARE((*controller->model())[0]->status(), QString("Canceled"));
+
+    QString downloadFile = QDir(_tempDir.path()).filePath("log_0_UnknownDate.px4log");
+    QVERIFY(QFile::exists(downloadFile));
+    LogDownloadWindow partial;
+    QVERIFY(partial.load(downloadFile + ".bins", 0, _largeLogSize, 0, 0));
+    QVERIFY(partial.receivedBinCount() > 0);
+    QVERIFY(partial.receivedBinCount() < partial.binCount());
+    _multiSpyLogDownloadController->clearAllSignals();
+
+    // Same log again resumes into the same file
+    _startDownload(controller, _tempDir.path());
+    _waitForDownload(controller);
+    QCOMPARE((*controller->model())[0]->status(), QString("Downloaded"));
+    QVERIFY(UnitTest::fileCompare(downloadFile, _mockLink->logDownloadFile()));
+    QVERIFY(!QFile::exists(downloadFile + ".bins"));
+    QVERIFY(!QFile::exists(QDir(_tempDir.path()).filePath("log_0_UnknownDate_1.px4log")));
+
+    QFile::remove(downloadFile);
+
+}
+
+/// Download completes intact with the link dropping every tenth message
+void LogDownloadTest::_packetLoss_test(void)
+{
+    QVERIFY(_tempDir.isValid());
+
+    _connectMockLink(MAV_AUTOPILOT_PX4);
+    _mockLink->setLogDownloadFileSize(_largeLogSize);
+
+    _createController();
+    LogDownloadController* controller = _controller;
+
+    _refreshLogList(controller);
+
+    _mockLink->setPacketDropInterval(10);
+
+    _startDownload(controller, _tempDir.path());
+    _waitForDownload(controller);
+
+    _mockLink->setPacketDropInterval(0);
+
+    QString downloadFile = QDir(_tempDir.path()).filePath("log_0_UnknownDate.px4log");
+    QCOMPARE((*controller->model())[0]->status(), QString("Downloaded"));
+    QVERIFY(UnitTest::fileCompare(downloadFile, _mockLink->logDownloadFile()));
 
     QFile::remove(downloadFile);
 
-    delete controller;
 }
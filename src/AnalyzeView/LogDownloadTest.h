@@ -13,6 +13,10 @@
 #include "UnitTest.h"
 #include "MultiSignalSpy.h"
 
+#include <QTemporaryDir>
+
+class LogDownloadController;
+
 class LogDownloadTest : public UnitTest
 {
     Q_OBJECT
@@ -22,11 +26,21 @@ public:
     
 private slots:
     //void init(void);
-    //void cleanup(void) { _cleanup(); }
+    void cleanup(void);
 
     void downloadTest(void);
+    void _window_test(void);
+    void _windowTimeout_test(void);
+    void _windowSave_test(void);
+    void _resume_test(void);
+    void _packetLoss_test(void);
 
 private:
+    void _createController(void);
+    void _refreshLogList(LogDownloadController* controller);
+    void _startDownload(LogDownloadController* controller, const QString& downloadTo);
+    void _waitForDownload(LogDownloadController* controller);
+
     // LogDownloadController signals
 
     enum {
@@ -42,10 +56,14 @@ private:
         modelChangedSignalIndexMask =       1 << modelChangedSignalIndex,
     };
 
+    LogDownloadController*  _controller;
     MultiSignalSpy*     _multiSpyLogDownloadController;
     static const size_t _cLogDownloadControllerSignals = logDownloadControllerMaxSignalIndex;
     const char*         _rgLogDownloadControllerSignals[_cLogDownloadControllerSignals];
 
+    QTemporaryDir       _tempDir;
+
+    static const uint32_t _largeLogSize = 64 * 1024;
 };
 
 #endif
@@ -0,0 +1,241 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+
+#include "LogDownloadWindow.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+
+LogDownloadWindow::LogDownloadWindow(void)
+    : _logSize(0)
+    , _receivedBins(0)
+    , _firstMissingBin(0)
+    , _outstanding(false)
+    , _requestBin(0)
+    , _requestEndBin(0)
+    , _requestSentMsecs(0)
+    , _requestRetry(false)
+    , _requestAnswered(false)
+    , _lastDataMsecs(0)
+    , _startMsecs(0)
+    , _sessionBytes(0)
+    , _retries(0)
+    , _srttMsecs(-1)
+    , _rttVarMsecs(0)
+    , _rtoMsecs(initialRtoMsecs)
+    , _requestCount(0)
+    , _timeoutCount(0)
+    , _duplicateBins(0)
+{
+
+}
+
+void LogDownloadWindow::start(uint32_t logSize, qint64 nowMsecs)
+{
+    _logSize = logSize;
+    _bins = QBitArray((int)((logSize + binSize - 1) / binSize), false);
+    _receivedBins = 0;
+    _firstMissingBin = 0;
+    _outstanding = false;
+    _lastDataMsecs = nowMsecs;
+    _startMsecs = nowMsecs;
+    _sessionBytes = 0;
+    _retries = 0;
+    _srttMsecs = -1;
+    _rttVarMsecs = 0;
+    _rtoMsecs = initialRtoMsecs;
+    _requestCount = 0;
+    _timeoutCount = 0;
+    _duplicateBins = 0;
+}
+
+bool LogDownloadWindow::load(const QString& fileName, uint32_t logId, uint32_t logSize, uint32_t timeUtc, qint64 nowMsecs)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    quint32     magic, version, fileLogId, fileLogSize, fileTimeUtc;
+    QBitArray   bins;
+    stream >> magic >> version >> fileLogId >> fileLogSize >> fileTimeUtc >> bins;
+    if (stream.status() != QDataStream::Ok || magic != _magic || version != _version ||
+            fileLogId != logId || fileLogSize != logSize || fileTimeUtc != timeUtc ||
+            bins.size() != (int)((logSize + binSize - 1) / binSize)) {
+        return false;
+    }
+
+    start(logSize, nowMsecs);
+    _bins = bins;
+    _receivedBins = _bins.count(true);
+
+    return true;
+}
+
+bool LogDownloadWindow::save(const QString& fileName, uint32_t logId, uint32_t timeUtc) const
+{
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    stream << _magic << _version << (quint32)logId << (quint32)_logSize << (quint32)timeUtc << _bins;
+
+    return stream.status() == QDataStream::Ok && file.commit();
+}
+
+bool LogDownloadWindow::received(uint32_t offset, uint32_t count, qint64 nowMsecs)
+{
+    if (count == 0 || offset >= _logSize || (offset % binSize) != 0) {
+        return false;
+    }
+
+    int bin = offset / binSize;
+    _lastDataMsecs = nowMsecs;
+
+    if (_outstanding && bin >= _requestBin && bin < _requestEndBin) {
+        // Karn's algorithm: data for a request sent after a timeout could belong to the one before
+        if (!_requestAnswered) {
+            _requestAnswered = true;
+            if (!_requestRetry) {
+                _rttSample(nowMsecs - _requestSentMsecs);
+            }
+        }
+        if (bin == _requestEndBin - 1) {
+            // Stream reached the end of the request, anything lost in it is requested next
+            _outstanding = false;
+        }
+    }
+
+    if (_bins.testBit(bin)) {
+        _duplicateBins++;
+        return false;
+    }
+
+    _bins.setBit(bin);
+    _receivedBins++;
+    _sessionBytes += count;
+    _retries = 0;
+
+    return true;
+}
+
+bool LogDownloadWindow::takeRequestToSend(qint64 nowMsecs, Range& range)
+{
+    if (_outstanding || complete()) {
+        return false;
+    }
+
+    while (_firstMissingBin < _bins.size() && _bins.testBit(_firstMissingBin)) {
+        _firstMissingBin++;
+    }
+
+    // Extend the request over following missing ranges while the gaps between them are small
+    int maxGapBins = _binsPerRtt(nowMsecs);
+    int endBin = _firstMissingBin + 1;
+    int gapBins = 0;
+    for (int bin=endBin; bin<_bins.size(); bin++) {
+        if (!_bins.testBit(bin)) {
+            endBin = bin + 1;
+            gapBins = 0;
+        } else if (++gapBins > maxGapBins) {
+            break;
+        }
+    }
+
+    _outstanding = true;
+    _requestBin = _firstMissingBin;
+    _requestEndBin = endBin;
+    _requestSentMsecs = nowMsecs;
+    _requestRetry = _retries != 0;
+    _requestAnswered = false;
+    _requestCount++;
+
+    range.first = _requestBin * binSize;
+    range.second = qMin(_requestEndBin * binSize, _logSize) - range.first;
+
+    return true;
+}
+
+bool LogDownloadWindow::takeTimedOut(qint64 nowMsecs)
+{
+    if (!_outstanding || msecsToNextTimeout(nowMsecs) != 0) {
+        return false;
+    }
+
+    _outstanding = false;
+    _retries++;
+    _timeoutCount++;
+    _rtoMsecs = qMin(_rtoMsecs * 2, (int)maxRtoMsecs);
+
+    return true;
+}
+
+int LogDownloadWindow::msecsToNextTimeout(qint64 nowMsecs) const
+{
+    if (!_outstanding) {
+        return -1;
+    }
+
+    qint64 lastActivityMsecs = qMax(_requestSentMsecs, _lastDataMsecs);
+    return (int)qMax(lastActivityMsecs + _rtoMsecs - nowMsecs, (qint64)0);
+}
+
+double LogDownloadWindow::bytesPerSecond(qint64 nowMsecs) const
+{
+    qint64 elapsedMsecs = qMax(nowMsecs - _startMsecs, (qint64)1);
+    return (double)_sessionBytes * 1000.0 / (double)elapsedMsecs;
+}
+
+uint32_t LogDownloadWindow::bytesReceived(void) const
+{
+    if (_receivedBins == 0) {
+        return 0;
+    }
+
+    uint32_t bytes = _receivedBins * binSize;
+    if (_bins.testBit(_bins.size() - 1)) {
+        // Last bin is usually short
+        bytes -= (_bins.size() * binSize) - _logSize;
+    }
+    return bytes;
+}
+
+/// @return Number of bins the link delivers in one round trip, 0 before a round trip was measured
+int LogDownloadWindow::_binsPerRtt(qint64 nowMsecs) const
+{
+    if (_srttMsecs <= 0) {
+        return 0;
+    }
+
+    return (int)((bytesPerSecond(nowMsecs) * _srttMsecs) / (1000.0 * binSize));
+}
+
+void LogDownloadWindow::_rttSample(int rttMsecs)
+{
+    rttMsecs = qMax(rttMsecs, 0);
+
+    if (_srttMsecs == -1) {
+        _srttMsecs = rttMsecs;
+        _rttVarMsecs = rttMsecs / 2;
+    } else {
+        _rttVarMsecs = ((3 * _rttVarMsecs) + qAbs(_srttMsecs - rttMsecs)) / 4;
+        _srttMsecs = ((7 * _srttMsecs) + rttMsecs) / 8;
+    }
+
+    _rtoMsecs = qBound((int)minRtoMsecs, _srttMsecs + (4 * _rttVarMsecs), (int)maxRtoMsecs);
+}
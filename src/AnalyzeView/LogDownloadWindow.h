@@ -0,0 +1,116 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+
+#ifndef LogDownloadWindow_H
+#define LogDownloadWindow_H
+
+#include "QGCMAVLink.h"
+
+#include <QBitArray>
+#include <QPair>
+#include <QString>
+
+/// Tracks which LOG_DATA bins of a log were received, as used by LogDownloadController.
+///
+/// The bitmap covers the whole log and can be saved next to the partial log file, so a download which was canceled or
+/// lost its vehicle picks up where it left off the next time the same log is downloaded.
+///
+/// Firmware services a single LOG_REQUEST_DATA at a time, a new request replaces the one being streamed. So there is
+/// only ever one request outstanding, but a request can span several missing ranges. Ranges separated by fewer received
+/// bins than the link delivers in one round trip are requested together, resending the bins in between is cheaper
+/// than waiting for another round trip. The request timeout is derived from the measured round trip time the same way
+/// TCP does it (RFC 6298), and counts from the last data received since data streams in for as long as the request runs.
+///
+/// The window does not send anything or keep time itself. The caller passes in the current time and sends the requests
+/// it is handed.
+class LogDownloadWindow
+{
+public:
+    LogDownloadWindow(void);
+
+    typedef QPair<uint32_t, uint32_t> Range;    ///< Offset, count in bytes
+
+    /// Starts a new download with no bins received
+    void start(uint32_t logSize, qint64 nowMsecs);
+
+    /// Starts a download from the bins saved by a previous one
+    /// @return false: file missing, corrupt or for a different log, nothing is changed
+    bool load(const QString& fileName, uint32_t logId, uint32_t logSize, uint32_t timeUtc, qint64 nowMsecs);
+
+    /// Saves the received bins
+    bool save(const QString& fileName, uint32_t logId, uint32_t timeUtc) const;
+
+    /// Called for every LOG_DATA received
+    /// @return true: data is new and must be written, false: duplicate or invalid
+    bool received(uint32_t offset, uint32_t count, qint64 nowMsecs);
+
+    /// @return true: range is set to the next LOG_REQUEST_DATA to send, which is outstanding from here on
+    bool takeRequestToSend(qint64 nowMsecs, Range& range);
+
+    /// @return true: the outstanding request timed out, it is requested again by the next takeRequestToSend
+    bool takeTimedOut(qint64 nowMsecs);
+
+    /// @return Msecs until the outstanding request times out, -1 if there is none
+    int msecsToNextTimeout(qint64 nowMsecs) const;
+
+    /// Average transfer rate of this session, bins loaded from a previous session are not counted
+    double bytesPerSecond(qint64 nowMsecs) const;
+
+    bool complete(void) const               { return _receivedBins == _bins.size(); }
+    bool outstanding(void) const            { return _outstanding; }
+    uint32_t logSize(void) const            { return _logSize; }
+    uint32_t bytesReceived(void) const;
+    int binCount(void) const                { return _bins.size(); }
+    int receivedBinCount(void) const        { return _receivedBins; }
+    int retries(void) const                 { return _retries; }            ///< Timeouts in a row without new data
+    int rttMsecs(void) const                { return _srttMsecs; }          ///< Smoothed round trip, -1 if not measured yet
+    int rtoMsecs(void) const                { return _rtoMsecs; }           ///< Current request timeout
+    int requestCount(void) const            { return _requestCount; }
+    int timeoutCount(void) const            { return _timeoutCount; }
+    int duplicateBinCount(void) const       { return _duplicateBins; }      ///< Bins received more than once
+
+    static const uint32_t binSize =         MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN;
+    static const int initialRtoMsecs =      500;
+    static const int minRtoMsecs =          250;    ///< Leaves room for pauses in the stream of a slow link
+    static const int maxRtoMsecs =          5000;
+    static const int maxRetries =           5;      ///< Consecutive timeouts without any data before giving up
+
+private:
+    int  _binsPerRtt(qint64 nowMsecs) const;
+    void _rttSample(int rttMsecs);
+
+    QBitArray   _bins;
+    uint32_t    _logSize;
+    int         _receivedBins;
+    int         _firstMissingBin;   ///< All bins before this one were received
+
+    bool        _outstanding;
+    int         _requestBin;        ///< First bin of the outstanding request
+    int         _requestEndBin;     ///< One past the last bin of the outstanding request
+    qint64      _requestSentMsecs;
+    bool        _requestRetry;      ///< Outstanding request was sent after a timeout
+    bool        _requestAnswered;   ///< Data for the outstanding request was received
+    qint64      _lastDataMsecs;
+
+    qint64      _startMsecs;
+    uint32_t    _sessionBytes;
+    int         _retries;
+    int         _srttMsecs;
+    int         _rttVarMsecs;
+    int         _rtoMsecs;
+    int         _requestCount;
+    int         _timeoutCount;
+    int         _duplicateBins;
+
+    static const quint32 _magic =   0x5147434C;     ///< 'QGCL'
+    static const quint32 _version = 1;
+};
+
+#endif
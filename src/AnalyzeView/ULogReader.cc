@@ -0,0 +1,185 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "ULogReader.h"
+
+#include <QtEndian>
+
+#include <string.h>
+
+static const char   _ulogMagic[] =      { 'U', 'L', 'o', 'g', 0x01, 0x12, 0x35 };
+static const int    _maxNestingDepth =  8;
+
+ULogReader::ULogReader(void)
+{
+
+}
+
+bool ULogReader::isULog(const QByteArray& data)
+{
+    return data.size() >= (int)sizeof(_ulogMagic) && memcmp(data.constData(), _ulogMagic, sizeof(_ulogMagic)) == 0;
+}
+
+qint64 ULogReader::_readFileHeader(void)
+{
+    _msgIdSlot.fill(-1, 0xFFFF + 1);
+    _formats.clear();
+
+    _file.seek(0);
+    QByteArray header = _file.read(fileHeaderLength);
+
+    return header.size() == fileHeaderLength && isULog(header) ? fileHeaderLength : -1;
+}
+
+FlightLogReader::ScanResult_t ULogReader::_scanRecord(int& recordLength, int& slot)
+{
+    if (!_fill(messageHeaderLength)) {
+        return ScanEnd;
+    }
+
+    const uint8_t* data = _scanData();
+    int messageSize = qFromLittleEndian<quint16>(data);
+    recordLength = messageHeaderLength + messageSize;
+    if (!_fill(recordLength)) {
+        // Truncated last message
+        return ScanEnd;
+    }
+    data = _scanData();
+
+    const uint8_t*  payload = data + messageHeaderLength;
+    uint8_t         messageType = data[2];
+
+    switch (messageType) {
+    case 'D':
+        if (messageSize >= dataHeaderLength) {
+            slot = _msgIdSlot[qFromLittleEndian<quint16>(payload)];
+        }
+        break;
+    case 'F':
+    {
+        // "name:type field;type field;..."
+        QString format = QString::fromLatin1((const char*)payload, messageSize);
+        int nameEnd = format.indexOf(':');
+        if (nameEnd > 0) {
+            _formats[format.left(nameEnd)] = format.mid(nameEnd + 1).split(';', QString::SkipEmptyParts);
+        }
+        break;
+    }
+    case 'A':
+        // uint8 multi_id, uint16 msg_id, char message_name[]
+        if (messageSize > 3) {
+            QString name = QString::fromLatin1((const char*)payload + 3, messageSize - 3);
+            _msgIdSlot[qFromLittleEndian<quint16>(payload + 1)] = _messageSlot(name);
+        }
+        break;
+    default:
+        // Definitions, parameters, log output and dropouts are not indexed. Unknown message types are skipped
+        // by size, as the format specifies.
+        break;
+    }
+
+    return ScanRecord;
+}
+
+bool ULogReader::_decodeRecord(const uint8_t* data, int length, Record_t& record)
+{
+    if (length < messageHeaderLength + dataHeaderLength || data[2] != 'D') {
+        return false;
+    }
+    int messageSize = qFromLittleEndian<quint16>(data);
+    if (messageSize < dataHeaderLength || messageHeaderLength + messageSize > length) {
+        return false;
+    }
+
+    record.payload = data + messageHeaderLength + dataHeaderLength;
+    record.length = messageSize - dataHeaderLength;
+
+    return true;
+}
+
+FlightLogReader::Field_t ULogReader::field(const QString& message, const QString& fieldName)
+{
+    Field_t field;
+    field.type = FieldInvalid;
+    field.offset = 0;
+    field.scale = 1.0;
+
+    QHash<QString, QStringList>::const_iterator it = _formats.constFind(message);
+    if (it == _formats.constEnd()) {
+        return field;
+    }
+
+    foreach (const QString& fieldDefinition, it.value()) {
+        QString type = fieldDefinition.section(' ', 0, 0);
+        QString name = fieldDefinition.section(' ', 1, 1);
+
+        if (name == fieldName) {
+            // Arrays are looked up as their first element
+            QString elementType = type.section('[', 0, 0);
+            if      (elementType == "int8_t")                           field.type = FieldInt8;
+            else if (elementType == "uint8_t" || elementType == "bool") field.type = FieldUInt8;
+            else if (elementType == "int16_t")                          field.type = FieldInt16;
+            else if (elementType == "uint16_t")                         field.type = FieldUInt16;
+            else if (elementType == "int32_t")                          field.type = FieldInt32;
+            else if (elementType == "uint32_t")                         field.type = FieldUInt32;
+            else if (elementType == "int64_t")                          field.type = FieldInt64;
+            else if (elementType == "uint64_t")                         field.type = FieldUInt64;
+            else if (elementType == "float")                            field.type = FieldFloat;
+            else if (elementType == "double")                           field.type = FieldDouble;
+            return field;
+        }
+
+        int size = _typeSize(type, 0);
+        if (size < 0) {
+            break;
+        }
+        field.offset += size;
+    }
+
+    field.type = FieldInvalid;
+    field.offset = 0;
+    return field;
+}
+
+/// @return Size of a field type, arrays and nested formats included, -1 if unknown
+int ULogReader::_typeSize(const QString& type, int depth)
+{
+    int arrayStart = type.indexOf('[');
+    if (arrayStart > 0) {
+        int count = type.mid(arrayStart + 1, type.indexOf(']') - arrayStart - 1).toInt();
+        int elementSize = _typeSize(type.left(arrayStart), depth);
+        return elementSize < 0 ? -1 : elementSize * count;
+    }
+
+    if (type == "int8_t" || type == "uint8_t" || type == "bool" || type == "char") {
+        return 1;
+    } else if (type == "int16_t" || type == "uint16_t") {
+        return 2;
+    } else if (type == "int32_t" || type == "uint32_t" || type == "float") {
+        return 4;
+    } else if (type == "int64_t" || type == "uint64_t" || type == "double") {
+        return 8;
+    }
+
+    // Nested format
+    QHash<QString, QStringList>::const_iterator it = _formats.constFind(type);
+    if (it == _formats.constEnd() || depth >= _maxNestingDepth) {
+        return -1;
+    }
+    int size = 0;
+    foreach (const QString& fieldDefinition, it.value()) {
+        int fieldSize = _typeSize(fieldDefinition.section(' ', 0, 0), depth + 1);
+        if (fieldSize < 0) {
+            return -1;
+        }
+        size += fieldSize;
+    }
+
+    return size;
+}
@@ -0,0 +1,49 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#ifndef ULogReader_H
+#define ULogReader_H
+
+#include "FlightLogReader.h"
+
+/// Indexed reader for PX4 ULog files (.ulg).
+///
+/// The index holds the offsets of the data ('D') messages of each logged topic, all multi instances of a topic
+/// under the topic name. Topic formats come from the format ('F') messages, the topic of a data message from the
+/// subscription ('A') which assigned its msg_id. Field offsets are worked out from the format, nested types included.
+class ULogReader : public FlightLogReader
+{
+public:
+    ULogReader(void);
+
+    /// @return true: data is the start of a ULog file
+    static bool isULog(const QByteArray& data);
+
+    // Overrides from FlightLogReader
+    Field_t field(const QString& message, const QString& fieldName) final;
+
+    static const int fileHeaderLength =     16;     ///< Magic[7], version, timestamp
+    static const int messageHeaderLength =  3;      ///< uint16 msg_size, uint8 msg_type
+    static const int dataHeaderLength =     2;      ///< uint16 msg_id at the start of a data message
+
+protected:
+    // Overrides from FlightLogReader
+    qint64          _readFileHeader (void) final;
+    ScanResult_t    _scanRecord     (int& recordLength, int& slot) final;
+    bool            _decodeRecord   (const uint8_t* data, int length, Record_t& record) final;
+    int             _maxRecordLength(void) const final { return messageHeaderLength + 0xFFFF; }
+
+private:
+    int _typeSize(const QString& type, int depth);
+
+    QVector<int>                _msgIdSlot;     ///< Index slot by msg_id, -1 for none
+    QHash<QString, QStringList> _formats;       ///< Fields ("type name") by format name
+};
+
+#endif
@@ -70,7 +70,10 @@ APMSensorsComponentController::APMSensorsComponentController(void)
     _sensorsComponent = apmPlugin->sensorsComponent();
     connect(_sensorsComponent, &VehicleComponent::setupCompleteChanged, this, &APMSensorsComponentController::setupNeededChanged);
 
-    connect(qgcApp()->toolbox()->mavlinkProtocol(), &MAVLinkProtocol::messageReceived, this, &APMSensorsComponentController::_mavlinkMessageReceived);
+    MAVLinkMessageDispatcher* dispatcher = qgcApp()->toolbox()->mavlinkProtocol()->messageDispatcher();
+    dispatcher->subscribe(_vehicle->id(), MAVLinkMessageDispatcher::anyId, MAVLINK_MSG_ID_COMMAND_ACK,     this, &APMSensorsComponentController::_mavlinkMessageReceived);
+    dispatcher->subscribe(_vehicle->id(), MAVLinkMessageDispatcher::anyId, MAVLINK_MSG_ID_MAG_CAL_PROGRESS, this, &APMSensorsComponentController::_mavlinkMessageReceived);
+    dispatcher->subscribe(_vehicle->id(), MAVLinkMessageDispatcher::anyId, MAVLINK_MSG_ID_MAG_CAL_REPORT,   this, &APMSensorsComponentController::_mavlinkMessageReceived);
 }
 
 APMSensorsComponentController::~APMSensorsComponentController()
@@ -710,10 +713,7 @@ void APMSensorsComponentController::_mavlinkMessageReceived(LinkInterface* link,
 {
     Q_UNUSED(link);
 
-    if (message.sysid != _vehicle->id()) {
-        return;
-    }
-
+    // Dispatcher subscriptions already filter on vehicle sysid and msgid
     switch (message.msgid) {
     case MAVLINK_MSG_ID_COMMAND_ACK:
         _handleCommandAck(message);
@@ -0,0 +1,249 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+
+#include "ParameterCache.h"
+#include "QGC.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+
+#include <string.h>
+
+ParameterCache::ParameterCache(void)
+    : _paramCount(0)
+    , _dirty(false)
+    , _sampling(false)
+    , _sampledCount(0)
+{
+
+}
+
+void ParameterCache::reset(int paramCount)
+{
+    _paramCount = qMax(paramCount, 0);
+    _entries.clear();
+    _nameToParamIndex.clear();
+    _nameToParamIndex.reserve(_paramCount);
+    _dirty = false;
+    _sampling = false;
+}
+
+bool ParameterCache::load(const QString& fileName)
+{
+    reset(0);
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic, version, hash;
+    qint32  paramCount, entryCount;
+    stream >> magic >> version >> paramCount >> hash >> entryCount;
+    if (stream.status() != QDataStream::Ok || magic != _magic || version != _version || paramCount < 0 || entryCount < 0 || entryCount > paramCount) {
+        return false;
+    }
+
+    reset(paramCount);
+    for (int i=0; i<entryCount; i++) {
+        qint32  paramIndex, type;
+        Entry_t entry;
+
+        stream >> paramIndex >> entry.name >> type >> entry.value >> entry.crc;
+        entry.type = (FactMetaData::ValueType_t)type;
+        if (stream.status() != QDataStream::Ok || paramIndex < 0 || paramIndex >= paramCount || entry.crc != entryCrc(entry.name, entry.type, entry.value)) {
+            reset(0);
+            return false;
+        }
+
+        _entries[paramIndex] = entry;
+        _nameToParamIndex[entry.name] = paramIndex;
+    }
+
+    return true;
+}
+
+bool ParameterCache::save(const QString& fileName)
+{
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    stream << _magic << _version << (qint32)_paramCount << hash() << (qint32)_entries.count();
+    for (QMap<int, Entry_t>::const_iterator it = _entries.constBegin(); it != _entries.constEnd(); ++it) {
+        const Entry_t& entry = it.value();
+        stream << (qint32)it.key() << entry.name << (qint32)entry.type << entry.value << entry.crc;
+    }
+
+    if (stream.status() != QDataStream::Ok || !file.commit()) {
+        return false;
+    }
+
+    _dirty = false;
+    return true;
+}
+
+bool ParameterCache::readHash(const QString& fileName, quint32& hash)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic, version;
+    qint32  paramCount, entryCount;
+    stream >> magic >> version >> paramCount >> hash >> entryCount;
+
+    return stream.status() == QDataStream::Ok && magic == _magic && version == _version;
+}
+
+bool ParameterCache::update(int paramIndex, const QString& name, FactMetaData::ValueType_t type, const QVariant& value)
+{
+    if (paramIndex < 0 || paramIndex >= _paramCount) {
+        paramIndex = _nameToParamIndex.value(name, -1);
+        if (paramIndex == -1) {
+            return false;
+        }
+    }
+
+    quint32 crc = entryCrc(name, type, value);
+
+    QMap<int, Entry_t>::iterator it = _entries.find(paramIndex);
+    if (it != _entries.end()) {
+        if (it.value().crc == crc && it.value().name == name) {
+            return false;
+        }
+        if (it.value().name != name) {
+            _nameToParamIndex.remove(it.value().name);
+        }
+    } else {
+        it = _entries.insert(paramIndex, Entry_t());
+    }
+
+    Entry_t& entry = it.value();
+    entry.name = name;
+    entry.type = type;
+    entry.value = value;
+    entry.crc = crc;
+    _nameToParamIndex[name] = paramIndex;
+    _dirty = true;
+
+    return true;
+}
+
+quint32 ParameterCache::hash(void) const
+{
+    quint32 crc = 0;
+
+    foreach (const Entry_t& entry, _entries) {
+        QByteArray name = entry.name.toLatin1();
+        QByteArray value = _valueBytes(entry.type, entry.value);
+        crc = QGC::crc32((const quint8*)name.constData(), name.length(), crc);
+        crc = QGC::crc32((const quint8*)value.constData(), value.length(), crc);
+    }
+
+    return crc;
+}
+
+void ParameterCache::startSampling(void)
+{
+    _sampling = true;
+    _sampledCount = 0;
+}
+
+ParameterCache::SampleResult_t ParameterCache::sample(int paramIndex, const QString& name, FactMetaData::ValueType_t type, const QVariant& value)
+{
+    if (!_sampling) {
+        return SampleRejected;
+    }
+    if (paramIndex < 0 || paramIndex >= _paramCount) {
+        // Not part of the stream
+        return SampleMore;
+    }
+
+    // A single changed value already shows the cache is out of date
+    QMap<int, Entry_t>::const_iterator it = _entries.constFind(paramIndex);
+    if (it == _entries.constEnd() || it.value().name != name || it.value().crc != entryCrc(name, type, value)) {
+        _sampling = false;
+        return SampleRejected;
+    }
+
+    if (++_sampledCount >= qMin((int)sampleCount, _entries.count())) {
+        _sampling = false;
+        return SampleAccepted;
+    }
+
+    return SampleMore;
+}
+
+quint32 ParameterCache::entryCrc(const QString& name, FactMetaData::ValueType_t type, const QVariant& value)
+{
+    QByteArray nameBytes = name.toLatin1();
+    QByteArray valueBytes = _valueBytes(type, value);
+
+    quint32 crc = QGC::crc32((const quint8*)nameBytes.constData(), nameBytes.length(), 0);
+    return QGC::crc32((const quint8*)valueBytes.constData(), valueBytes.length(), crc);
+}
+
+/// @return Value as stored on the vehicle, independent of the type the QVariant holds it in
+QByteArray ParameterCache::_valueBytes(FactMetaData::ValueType_t type, const QVariant& value)
+{
+    union {
+        quint8  uint8;
+        qint8   int8;
+        quint16 uint16;
+        qint16  int16;
+        quint32 uint32;
+        qint32  int32;
+        float   float32;
+        double  float64;
+    } raw;
+
+    memset(&raw, 0, sizeof(raw));
+    switch (type) {
+    case FactMetaData::valueTypeUint8:
+        raw.uint8 = (quint8)value.toUInt();
+        break;
+    case FactMetaData::valueTypeInt8:
+        raw.int8 = (qint8)value.toInt();
+        break;
+    case FactMetaData::valueTypeUint16:
+        raw.uint16 = (quint16)value.toUInt();
+        break;
+    case FactMetaData::valueTypeInt16:
+        raw.int16 = (qint16)value.toInt();
+        break;
+    case FactMetaData::valueTypeUint32:
+        raw.uint32 = value.toUInt();
+        break;
+    case FactMetaData::valueTypeFloat:
+        raw.float32 = value.toFloat();
+        break;
+    case FactMetaData::valueTypeDouble:
+        raw.float64 = value.toDouble();
+        break;
+    default:
+        raw.int32 = value.toInt();
+        break;
+    }
+
+    return QByteArray((const char*)&raw, (int)FactMetaData::typeToSize(type));
+}
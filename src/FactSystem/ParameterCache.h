@@ -0,0 +1,109 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+
+#ifndef ParameterCache_H
+#define ParameterCache_H
+
+#include "FactMetaData.h"
+
+#include <QHash>
+#include <QMap>
+#include <QString>
+#include <QVariant>
+
+/// Local cache of the parameters of a single vehicle component, as used by ParameterManager.
+///
+/// Each cached parameter is stored with a CRC of its name and value. Parameters received from the vehicle are
+/// compared against the cache by CRC, so the cache knows which parameters changed and is only written when one did.
+///
+/// The file starts with a fixed size header holding the parameter count and the PX4 parameter set hash, so checking a
+/// _HASH_CHECK value against the cache does not need to read the parameters. For firmware without a set hash the cache
+/// is verified by sampling the first parameters of the PARAM_VALUE stream against it instead. A cache which passes the
+/// sample completes the parameter load, only parameters missing from it are requested from the vehicle. The rest of the
+/// stream still updates any value which changed.
+class ParameterCache
+{
+public:
+    ParameterCache(void);
+
+    typedef struct {
+        QString                     name;
+        FactMetaData::ValueType_t   type;
+        QVariant                    value;
+        quint32                     crc;    ///< CRC of name and value
+    } Entry_t;
+
+    typedef enum {
+        SampleMore,         ///< Cache matches so far, more samples needed
+        SampleAccepted,     ///< Cache matches the vehicle
+        SampleRejected,     ///< Cache is for a different parameter set
+    } SampleResult_t;
+
+    /// Empties the cache for a component which reports the specified parameter count
+    void reset(int paramCount);
+
+    /// Loads the cache from the file
+    /// @return false: file missing, out of date or corrupt, cache is empty
+    bool load(const QString& fileName);
+
+    /// Writes the cache to the file, clearing the dirty state
+    bool save(const QString& fileName);
+
+    /// Reads the parameter set hash from the cache file header only
+    /// @return false: no valid cache file
+    static bool readHash(const QString& fileName, quint32& hash);
+
+    int paramCount(void) const  { return _paramCount; }
+    int count(void) const       { return _entries.count(); }
+    bool dirty(void) const      { return _dirty; }
+
+    /// @return Cached parameters by parameter index
+    const QMap<int, Entry_t>& entries(void) const { return _entries; }
+
+    /// @return Parameter index for name, -1 if not cached
+    int paramIndex(const QString& name) const { return _nameToParamIndex.value(name, -1); }
+
+    /// Updates the cache with a parameter received from the vehicle. Parameters with an index outside of the
+    /// parameter count (PARAM_VALUE responses to a PARAM_SET) are looked up by name.
+    /// @return true: parameter is new or changed, cache is now dirty
+    bool update(int paramIndex, const QString& name, FactMetaData::ValueType_t type, const QVariant& value);
+
+    /// PX4 parameter set hash: CRC across name and value of all parameters in index order
+    quint32 hash(void) const;
+
+    /// Starts verifying the cache against the parameters streamed by the vehicle
+    void startSampling(void);
+
+    bool sampling(void) const { return _sampling; }
+
+    /// Compares a streamed parameter against the cache. The cache is rejected as soon as a parameter name or value does
+    /// not match.
+    SampleResult_t sample(int paramIndex, const QString& name, FactMetaData::ValueType_t type, const QVariant& value);
+
+    static quint32 entryCrc(const QString& name, FactMetaData::ValueType_t type, const QVariant& value);
+
+    static const int sampleCount = 8;   ///< Number of streamed parameters which must match before the cache is used
+
+private:
+    static QByteArray _valueBytes(FactMetaData::ValueType_t type, const QVariant& value);
+
+    int                 _paramCount;
+    QMap<int, Entry_t>  _entries;           ///< Key is parameter index
+    QHash<QString, int> _nameToParamIndex;
+    bool                _dirty;
+
+    bool                _sampling;
+    int                 _sampledCount;
+
+    static const quint32 _magic =   0x51474350;     ///< 'QGCP'
+    static const quint32 _version = 1;
+};
+
+#endif
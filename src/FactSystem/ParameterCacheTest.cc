@@ -0,0 +1,160 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "ParameterCacheTest.h"
+#include "ParameterCache.h"
+#include "QGC.h"
+
+#include <QFile>
+
+ParameterCacheTest::ParameterCacheTest(void)
+{
+
+}
+
+void ParameterCacheTest::_fillCache(ParameterCache& cache, int paramCount)
+{
+    cache.reset(paramCount);
+    for (int i=0; i<paramCount; i++) {
+        if (i % 2) {
+            cache.update(i, QString("PARAM_%1").arg(i), FactMetaData::valueTypeFloat, (float)i / 10.0f);
+        } else {
+            cache.update(i, QString("PARAM_%1").arg(i), FactMetaData::valueTypeInt32, i);
+        }
+    }
+}
+
+void ParameterCacheTest::_roundTrip_test(void)
+{
+    QVERIFY(_tempDir.isValid());
+    QString cacheFile = _tempDir.path() + "/1_1";
+
+    ParameterCache cache;
+    _fillCache(cache, 100);
+    QVERIFY(cache.dirty());
+    QVERIFY(cache.save(cacheFile));
+    QVERIFY(!cache.dirty());
+
+    // Hash comes from the header alone
+    quint32 hash;
+    QVERIFY(ParameterCache::readHash(cacheFile, hash));
+    QCOMPARE(hash, cache.hash());
+
+    ParameterCache loadedCache;
+    QVERIFY(loadedCache.load(cacheFile));
+    QVERIFY(!loadedCache.dirty());
+    QCOMPARE(loadedCache.paramCount(), 100);
+    QCOMPARE(loadedCache.count(), 100);
+    QCOMPARE(loadedCache.hash(), hash);
+    QCOMPARE(loadedCache.entries()[1].name, QString("PARAM_1"));
+    QCOMPARE(loadedCache.entries()[1].type, FactMetaData::valueTypeFloat);
+    QCOMPARE(loadedCache.entries()[1].value.toFloat(), 0.1f);
+    QCOMPARE(loadedCache.paramIndex("PARAM_42"), 42);
+
+    // Corrupt parameter value
+    QFile file(cacheFile);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.seek(file.size() - 5));
+    QVERIFY(file.putChar('\xff'));
+    file.close();
+    QVERIFY(!loadedCache.load(cacheFile));
+    QCOMPARE(loadedCache.count(), 0);
+
+    // Not a cache file
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write("not a parameter cache");
+    file.close();
+    QVERIFY(!ParameterCache::readHash(cacheFile, hash));
+    QVERIFY(!loadedCache.load(cacheFile));
+}
+
+/// Only parameters which are new or changed dirty the cache
+void ParameterCacheTest::_update_test(void)
+{
+    ParameterCache cache;
+    _fillCache(cache, 10);
+    QVERIFY(cache.save(_tempDir.path() + "/1_2"));
+
+    // Same value, held in a different variant type
+    QVERIFY(!cache.update(2, "PARAM_2", FactMetaData::valueTypeInt32, QVariant(2.0)));
+    QVERIFY(!cache.update(3, "PARAM_3", FactMetaData::valueTypeFloat, QVariant(0.3)));
+    QVERIFY(!cache.dirty());
+
+    QVERIFY(cache.update(2, "PARAM_2", FactMetaData::valueTypeInt32, 3));
+    QVERIFY(cache.dirty());
+    QCOMPARE(cache.entries()[2].value.toInt(), 3);
+
+    // PARAM_SET responses are matched by name
+    QVERIFY(cache.update(65535, "PARAM_4", FactMetaData::valueTypeInt32, 5));
+    QCOMPARE(cache.entries()[4].value.toInt(), 5);
+    QVERIFY(!cache.update(65535, "NOT_CACHED", FactMetaData::valueTypeInt32, 5));
+
+    // Parameter index reused for a different parameter
+    QVERIFY(cache.update(6, "RENAMED", FactMetaData::valueTypeInt32, 6));
+    QCOMPARE(cache.paramIndex("RENAMED"), 6);
+    QCOMPARE(cache.paramIndex("PARAM_6"), -1);
+    QCOMPARE(cache.count(), 10);
+}
+
+/// Set hash matches the PX4 _HASH_CHECK calculation
+void ParameterCacheTest::_hash_test(void)
+{
+    ParameterCache cache;
+    cache.reset(2);
+    cache.update(0, "SYS_AUTOSTART", FactMetaData::valueTypeInt32, 4001);
+    cache.update(1, "MC_ROLL_P", FactMetaData::valueTypeFloat, 6.5f);
+
+    qint32  intValue = 4001;
+    float   floatValue = 6.5f;
+    quint32 crc = QGC::crc32((const quint8*)"SYS_AUTOSTART", 13, 0);
+    crc = QGC::crc32((const quint8*)&intValue, sizeof(intValue), crc);
+    crc = QGC::crc32((const quint8*)"MC_ROLL_P", 9, crc);
+    crc = QGC::crc32((const quint8*)&floatValue, sizeof(floatValue), crc);
+
+    QCOMPARE(cache.hash(), crc);
+}
+
+void ParameterCacheTest::_sample_test(void)
+{
+    ParameterCache cache;
+
+    // Matching stream
+    _fillCache(cache, 100);
+    cache.startSampling();
+    QVERIFY(cache.sampling());
+    QCOMPARE(cache.sample(0, "PARAM_0", FactMetaData::valueTypeInt32, 0), ParameterCache::SampleMore);
+    QCOMPARE(cache.sample(65535, "PARAM_1", FactMetaData::valueTypeFloat, 0.1f), ParameterCache::SampleMore);
+    for (int i=1; i<ParameterCache::sampleCount - 1; i++) {
+        if (i % 2) {
+            QCOMPARE(cache.sample(i, QString("PARAM_%1").arg(i), FactMetaData::valueTypeFloat, (float)i / 10.0f), ParameterCache::SampleMore);
+        } else {
+            QCOMPARE(cache.sample(i, QString("PARAM_%1").arg(i), FactMetaData::valueTypeInt32, i), ParameterCache::SampleMore);
+        }
+    }
+    QCOMPARE(cache.sample(7, "PARAM_7", FactMetaData::valueTypeFloat, 0.7f), ParameterCache::SampleAccepted);
+    QVERIFY(!cache.sampling());
+
+    // Different parameter set
+    cache.startSampling();
+    QCOMPARE(cache.sample(0, "PARAM_0", FactMetaData::valueTypeInt32, 0), ParameterCache::SampleMore);
+    QCOMPARE(cache.sample(1, "OTHER_1", FactMetaData::valueTypeFloat, 0.1f), ParameterCache::SampleRejected);
+    QVERIFY(!cache.sampling());
+
+    // A single parameter which changed since the cache was written
+    cache.startSampling();
+    QCOMPARE(cache.sample(0, "PARAM_0", FactMetaData::valueTypeInt32, 0), ParameterCache::SampleMore);
+    QCOMPARE(cache.sample(2, "PARAM_2", FactMetaData::valueTypeInt32, 3), ParameterCache::SampleRejected);
+    QVERIFY(!cache.sampling());
+
+    // Cache smaller than the sample
+    _fillCache(cache, 2);
+    cache.startSampling();
+    QCOMPARE(cache.sample(1, "PARAM_1", FactMetaData::valueTypeFloat, 0.1f), ParameterCache::SampleMore);
+    QCOMPARE(cache.sample(0, "PARAM_0", FactMetaData::valueTypeInt32, 0), ParameterCache::SampleAccepted);
+}
@@ -0,0 +1,37 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#ifndef ParameterCacheTest_H
+#define ParameterCacheTest_H
+
+#include "UnitTest.h"
+
+#include <QTemporaryDir>
+
+/// Unit test for the local parameter cache
+class ParameterCacheTest : public UnitTest
+{
+    Q_OBJECT
+
+public:
+    ParameterCacheTest(void);
+
+private slots:
+    void _roundTrip_test(void);
+    void _update_test(void);
+    void _hash_test(void);
+    void _sample_test(void);
+
+private:
+    void _fillCache(class ParameterCache& cache, int paramCount);
+
+    QTemporaryDir _tempDir;
+};
+
+#endif
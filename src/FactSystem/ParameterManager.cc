@@ -26,15 +26,11 @@
 #include <QVariantAnimation>
 #include <QJsonArray>
 
-/* types for local parameter cache */
-typedef QPair<int, QVariant> ParamTypeVal;
-typedef QPair<QString, ParamTypeVal> NamedParam;
-typedef QMap<int, NamedParam> MapID2NamedParam;
-
 QGC_LOGGING_CATEGORY(ParameterManagerVerbose1Log, "ParameterManagerVerbose1Log")
 QGC_LOGGING_CATEGORY(ParameterManagerVerbose2Log, "ParameterManagerVerbose2Log")
 
 Fact ParameterManager::_defaultFact;
+QString ParameterManager::_parameterCacheRoot;
 
 const char* ParameterManager::_cachedMetaDataFilePrefix =   "ParameterFactMetaData";
 const char* ParameterManager::_jsonParametersKey =          "parameters";
@@ -61,6 +57,7 @@ ParameterManager::ParameterManager(Vehicle* vehicle)
     , _initialRequestRetryCount(0)
     , _disableAllRetries(false)
     , _totalParamCount(0)
+    , _loadTimeMsecs(-1)
 {
     _versionParam = vehicle->firmwarePlugin()->getVersionParam();
 
@@ -79,18 +76,30 @@ ParameterManager::ParameterManager(Vehicle* vehicle)
     _waitingParamTimeoutTimer.setInterval(3000);
     connect(&_waitingParamTimeoutTimer, &QTimer::timeout, this, &ParameterManager::_waitingParamTimeout);
 
+    _readWindowTimer.setSingleShot(true);
+    connect(&_readWindowTimer, &QTimer::timeout, this, &ParameterManager::_readWindowTimeout);
+    _readWindowClock.start();
+
+    _paramCacheSaveTimer.setSingleShot(true);
+    _paramCacheSaveTimer.setInterval(5000);
+    connect(&_paramCacheSaveTimer, &QTimer::timeout, this, &ParameterManager::_saveParamCaches);
+
     connect(_vehicle->uas(), &UASInterface::parameterUpdate, this, &ParameterManager::_parameterUpdate);
+    connect(_mavlink, &MAVLinkProtocol::receiveLossPercentChanged, this, &ParameterManager::_receiveLossPercentChanged);
 
     _defaultComponentIdParam = vehicle->firmwarePlugin()->getDefaultComponentIdParam();
     qCDebug(ParameterManagerLog) << _logVehiclePrefix() << "Default component param" << _defaultComponentIdParam;
 
     // Ensure the cache directory exists
-    QFileInfo(QSettings().fileName()).dir().mkdir("ParamCache");
+    QDir cacheDir = parameterCacheDir();
+    cacheDir.mkpath(cacheDir.absolutePath());
+    _loadTimer.start();
     refreshAllParameters();
 }
 
 ParameterManager::~ParameterManager()
 {
+    _saveParamCaches();
     delete _parameterMetaData;
 }
 
@@ -140,84 +149,78 @@ void ParameterManager::_parameterUpdate(int vehicleId, int componentId, QString
 
     _dataMutex.lock();
 
-    // Update our total parameter counts
-    if (!_paramCountMap.contains(componentId)) {
-        _paramCountMap[componentId] = parameterCount;
-        _totalParamCount += parameterCount;
-    }
-
-    _mapParameterId2Name[componentId][parameterId] = parameterName;
+    bool readWindowAnswered = _readWindow.received(componentId, parameterId, _readWindowClock.elapsed());
 
-    // If we've never seen this component id before, setup the wait lists.
-    if (!_waitingReadParamIndexMap.contains(componentId)) {
-        // Add all indices to the wait list, parameter index is 0-based
-        for (int waitingIndex=0; waitingIndex<parameterCount; waitingIndex++) {
-            // This will add the new component id, as well as the the new waiting index and set the retry count for that index to 0
-            _waitingReadParamIndexMap[componentId][waitingIndex] = 0;
-        }
+    // If we've never seen this component id before, setup the store and update our total parameter counts
+    if (!_componentStores.contains(componentId)) {
+        ParameterStore& newStore = _componentStores[componentId];
+        newStore.setParamCount(parameterCount);
 
-        // The read and write waiting lists for this component are initialized the empty
-        _waitingReadParamNameMap[componentId] = QMap<QString, int>();
-        _waitingWriteParamNameMap[componentId] = QMap<QString, int>();
+        // Add all indices to the wait list, the read and write name wait lists start out empty
+        newStore.setAllReadIndicesWaiting();
+        _totalParamCount += parameterCount;
 
         qCDebug(ParameterManagerLog) << _logVehiclePrefix(componentId) << "Seeing component for first time - paramcount:" << parameterCount;
+
+        // A cache for this parameter set lets the load complete as soon as the start of the stream confirms it. The
+        // cache may already be loaded through a PX4 hash check.
+        ParameterCache& cache = _componentCaches[componentId];
+        if (cache.count() == 0) {
+            if (cache.load(parameterCacheFile(vehicleId, componentId)) && cache.paramCount() == parameterCount) {
+                qCDebug(ParameterManagerLog) << _logVehiclePrefix(componentId) << "Sampling parameter cache - cached count:" << cache.count();
+                cache.startSampling();
+            } else {
+                cache.reset(parameterCount);
+            }
+        }
     }
 
+    ParameterStore& store = _componentStores[componentId];
+    int slot = store.addSlot(parameterName);
+    store.setParamIndexSlot(parameterId, slot);
+
     // Determine default component id
     if (!_defaultComponentIdParam.isEmpty() && _defaultComponentIdParam == parameterName) {
         qCDebug(ParameterManagerLog) << _logVehiclePrefix(componentId) << "Default component id determined";
         _defaultComponentId = componentId;
     }
 
-    bool componentParamsComplete = false;
-    if (_waitingReadParamIndexMap[componentId].count() == 1) {
-        // We need to know when we get the last param from a component in order to complete setup
-        componentParamsComplete = true;
-    }
+    // We need to know when we get the last param from a component in order to complete setup
+    bool componentParamsComplete = store.waitingReadIndexCount() == 1;
 
-    if (!_waitingReadParamIndexMap[componentId].contains(parameterId) &&
-        !_waitingReadParamNameMap[componentId].contains(parameterName) &&
-        !_waitingWriteParamNameMap[componentId].contains(parameterName)) {
+    if (!store.readIndexWaiting(parameterId) &&
+        !store.waiting(ParameterStore::WaitRead, slot) &&
+        !store.waiting(ParameterStore::WaitWrite, slot)) {
         qCDebug(ParameterManagerVerbose1Log) << _logVehiclePrefix() << "Unrequested param update" << parameterName;
     }
 
     // Remove this parameter from the waiting lists
-    _waitingReadParamIndexMap[componentId].remove(parameterId);
-    _waitingReadParamNameMap[componentId].remove(parameterName);
-    _waitingWriteParamNameMap[componentId].remove(parameterName);
-    if (_waitingReadParamIndexMap[componentId].count()) {
-        qCDebug(ParameterManagerVerbose2Log) << _logVehiclePrefix(componentId) << "_waitingReadParamIndexMap:" << _waitingReadParamIndexMap[componentId];
+    store.clearReadIndexWaiting(parameterId);
+    store.clearWaiting(ParameterStore::WaitRead, slot);
+    store.clearWaiting(ParameterStore::WaitWrite, slot);
+    if (store.waitingReadIndexCount()) {
+        qCDebug(ParameterManagerVerbose2Log) << _logVehiclePrefix(componentId) << "waiting read param indices:" << store.waitingReadIndices();
     }
-    if (_waitingReadParamNameMap[componentId].count()) {
-        qCDebug(ParameterManagerVerbose2Log) << _logVehiclePrefix(componentId) << "_waitingReadParamNameMap" << _waitingReadParamNameMap[componentId];
+    if (store.waitingCount(ParameterStore::WaitRead)) {
+        qCDebug(ParameterManagerVerbose2Log) << _logVehiclePrefix(componentId) << "waiting read param names:" << store.waitingNames(ParameterStore::WaitRead);
     }
-    if (_waitingWriteParamNameMap[componentId].count()) {
-        qCDebug(ParameterManagerVerbose2Log) << _logVehiclePrefix(componentId) << "_waitingWriteParamNameMap" << _waitingWriteParamNameMap[componentId];
+    if (store.waitingCount(ParameterStore::WaitWrite)) {
+        qCDebug(ParameterManagerVerbose2Log) << _logVehiclePrefix(componentId) << "waiting write param names:" << store.waitingNames(ParameterStore::WaitWrite);
     }
 
     // Track how many parameters we are still waiting for
 
-    int waitingReadParamIndexCount = 0;
-    int waitingReadParamNameCount = 0;
-    int waitingWriteParamNameCount = 0;
+    int waitingReadParamIndexCount;
+    int waitingReadParamNameCount;
+    int waitingWriteParamNameCount;
 
-    foreach(int waitingComponentId, _waitingReadParamIndexMap.keys()) {
-        waitingReadParamIndexCount += _waitingReadParamIndexMap[waitingComponentId].count();
-    }
+    _waitingParamCounts(waitingReadParamIndexCount, waitingReadParamNameCount, waitingWriteParamNameCount);
     if (waitingReadParamIndexCount) {
         qCDebug(ParameterManagerVerbose1Log) << _logVehiclePrefix(componentId) << "waitingReadParamIndexCount:" << waitingReadParamIndexCount;
     }
-
-    foreach(int waitingComponentId, _waitingReadParamNameMap.keys()) {
-        waitingReadParamNameCount += _waitingReadParamNameMap[waitingComponentId].count();
-    }
     if (waitingReadParamNameCount) {
         qCDebug(ParameterManagerVerbose1Log) << _logVehiclePrefix(componentId) << "waitingReadParamNameCount:" << waitingReadParamNameCount;
     }
-
-    foreach(int waitingComponentId, _waitingWriteParamNameMap.keys()) {
-        waitingWriteParamNameCount += _waitingWriteParamNameMap[waitingComponentId].count();
-    }
     if (waitingWriteParamNameCount) {
         qCDebug(ParameterManagerVerbose1Log) << _logVehiclePrefix(componentId) << "waitingWriteParamNameCount:" << waitingWriteParamNameCount;
     }
@@ -254,7 +257,7 @@ void ParameterManager::_parameterUpdate(int vehicleId, int componentId, QString
         _parameterSetMajorVersion = value.toInt();
     }
 
-    if (!_mapParameterName2Variant.contains(componentId) || !_mapParameterName2Variant[componentId].contains(parameterName)) {
+    if (!store.fact(slot)) {
         qCDebug(ParameterManagerVerbose1Log) << _logVehiclePrefix(componentId) << "Adding new fact" << parameterName;
 
         FactMetaData::ValueType_t factType;
@@ -291,20 +294,47 @@ void ParameterManager::_parameterUpdate(int vehicleId, int componentId, QString
 
         Fact* fact = new Fact(componentId, parameterName, factType, this);
 
-        _mapParameterName2Variant[componentId][parameterName] = QVariant::fromValue(fact);
+        store.setFact(slot, fact);
 
         // We need to know when the fact changes from QML so that we can send the new value to the parameter manager
         connect(fact, &Fact::_containerRawValueChanged, this, &ParameterManager::_valueUpdated);
     }
 
+    Fact* fact = store.fact(slot);
+
     _dataMutex.unlock();
 
-    Q_ASSERT(_mapParameterName2Variant[componentId].contains(parameterName));
+    if (readWindowAnswered) {
+        // Keep the read window full while filling gaps
+        _sendReadWindowRequests();
+    }
 
-    Fact* fact = _mapParameterName2Variant[componentId][parameterName].value<Fact*>();
     Q_ASSERT(fact);
     fact->_containerSetRawValue(value);
 
+    // Keep the local cache up to date. Changed parameters are found through their CRC, so the cache is only written
+    // when something actually changed. Values the vehicle streams after the initial load (volatile ArduPilot
+    // parameters, Solo gimbal values) are written at most once per save timer interval.
+    bool preloadFromCache = false;
+    ParameterCache& cache = _componentCaches[componentId];
+    if (cache.sampling()) {
+        switch (cache.sample(parameterId, parameterName, fact->type(), value)) {
+        case ParameterCache::SampleAccepted:
+            qCDebug(ParameterManagerLog) << _logVehiclePrefix(componentId) << "Parameter cache matches vehicle, loading from cache";
+            preloadFromCache = true;
+            break;
+        case ParameterCache::SampleRejected:
+            qCDebug(ParameterManagerLog) << _logVehiclePrefix(componentId) << "Parameter cache does not match vehicle";
+            cache.reset(parameterCount);
+            break;
+        default:
+            break;
+        }
+    }
+    if (cache.update(parameterId, parameterName, fact->type(), value) && _initialLoadComplete && !_paramCacheSaveTimer.isActive()) {
+        _paramCacheSaveTimer.start();
+    }
+
     if (componentParamsComplete) {
         if (componentId == _defaultComponentId) {
             // Add meta data to default component. We need to do this before we setup the group map since group
@@ -323,14 +353,9 @@ void ParameterManager::_parameterUpdate(int vehicleId, int componentId, QString
         _saveToEEPROM();
     }
 
-    // Update param cache. The param cache is only used on PX4 Firmware since ArduPilot and Solo have volatile params
-    // which invalidate the cache. The Solo also streams param updates in flight for things like gimbal values
-    // which in turn causes a perf problem with all the param cache updates.
-    if (_vehicle->px4Firmware()) {
-        if (_prevWaitingReadParamIndexCount + _prevWaitingReadParamNameCount != 0 && readWaitingParamCount == 0) {
-            // All reads just finished, update the cache
-            _writeLocalParamCache(vehicleId, componentId);
-        }
+    if (_prevWaitingReadParamIndexCount + _prevWaitingReadParamNameCount != 0 && readWaitingParamCount == 0) {
+        // All reads just finished, update the caches
+        _saveParamCaches();
     }
 
     _prevWaitingReadParamIndexCount = waitingReadParamIndexCount;
@@ -340,6 +365,14 @@ void ParameterManager::_parameterUpdate(int vehicleId, int componentId, QString
     // Don't fail initial load complete if default component isn't found yet. That will be handled in wait timeout check.
     _checkInitialLoadComplete(false /* failIfNoDefaultComponent */);
 
+    if (preloadFromCache) {
+        // The sample confirmed the cache, so the load completes without waiting for the rest of the stream. The
+        // vehicle can't be told to stop streaming, values which changed since the cache was written are corrected as
+        // the stream goes by.
+        _preloadFromParamCache(vehicleId, componentId);
+        _requestMissingParams(componentId);
+    }
+
     qCDebug(ParameterManagerVerbose1Log) << _logVehiclePrefix(componentId) << "_parameterUpdate complete";
 }
 
@@ -356,9 +389,9 @@ void ParameterManager::_valueUpdated(const QVariant& value)
 
     _dataMutex.lock();
 
-    Q_ASSERT(_waitingWriteParamNameMap.contains(componentId));
-    _waitingWriteParamNameMap[componentId].remove(name);    // Remove any old entry
-    _waitingWriteParamNameMap[componentId][name] = 0;       // Add new entry and set retry count
+    Q_ASSERT(_componentStores.contains(componentId));
+    ParameterStore& store = _componentStores[componentId];
+    store.setWaiting(ParameterStore::WaitWrite, store.slot(name));  // Add new entry or reset retry count of old one
     _waitingParamTimeoutTimer.start();
     _saveRequired = true;
 
@@ -381,16 +414,17 @@ void ParameterManager::refreshAllParameters(uint8_t componentId)
     }
 
     // Reset index wait lists
-    foreach (int cid, _paramCountMap.keys()) {
-        // Add/Update all indices to the wait list, parameter index is 0-based
-        if(componentId != MAV_COMP_ID_ALL && componentId != cid)
+    for (QMap<int, ParameterStore>::iterator it = _componentStores.begin(); it != _componentStores.end(); ++it) {
+        // Add/Update all indices to the wait list, resetting their retry counts
+        if(componentId != MAV_COMP_ID_ALL && componentId != it.key())
             continue;
-        for (int waitingIndex = 0; waitingIndex < _paramCountMap[cid]; waitingIndex++) {
-            // This will add a new waiting index if needed and set the retry count for that index to 0
-            _waitingReadParamIndexMap[cid][waitingIndex] = 0;
-        }
+        it.value().setAllReadIndicesWaiting();
     }
 
+    // The new request list stream will fill most of the gaps the read window was working on
+    _readWindow.clear();
+    _readWindowTimer.stop();
+
     _dataMutex.unlock();
 
     MAVLinkProtocol* mavlink = qgcApp()->toolbox()->mavlinkProtocol();
@@ -417,11 +451,11 @@ void ParameterManager::_determineDefaultComponentId(void)
         // the set of parameters. Better than nothing!
 
         int largestCompParamCount = 0;
-        foreach(int componentId, _mapParameterName2Variant.keys()) {
-            int compParamCount = _mapParameterName2Variant[componentId].count();
+        for (QMap<int, ParameterStore>::const_iterator it = _componentStores.constBegin(); it != _componentStores.constEnd(); ++it) {
+            int compParamCount = it.value().factCount();
             if (compParamCount > largestCompParamCount) {
                 largestCompParamCount = compParamCount;
-                _defaultComponentId = componentId;
+                _defaultComponentId = it.key();
             }
         }
 
@@ -451,13 +485,13 @@ void ParameterManager::refreshParameter(int componentId, const QString& name)
 
     _dataMutex.lock();
 
-    Q_ASSERT(_waitingReadParamNameMap.contains(componentId));
+    Q_ASSERT(_componentStores.contains(componentId));
 
-    if (_waitingReadParamNameMap.contains(componentId)) {
+    if (_componentStores.contains(componentId)) {
         QString mappedParamName = _remapParamNameToVersion(name);
+        ParameterStore& store = _componentStores[componentId];
 
-        _waitingReadParamNameMap[componentId].remove(mappedParamName);  // Remove old wait entry if there
-        _waitingReadParamNameMap[componentId][mappedParamName] = 0;     // Add new wait entry and update retry count
+        store.setWaiting(ParameterStore::WaitRead, store.addSlot(mappedParamName));  // Add new wait entry or reset retry count of old one
         qCDebug(ParameterManagerLog) << _logVehiclePrefix(componentId) << "restarting _waitingParamTimeout";
         _waitingParamTimeoutTimer.start();
     }
@@ -472,7 +506,11 @@ void ParameterManager::refreshParametersPrefix(int componentId, const QString& n
     componentId = _actualComponentId(componentId);
     qCDebug(ParameterManagerLog) << _logVehiclePrefix(componentId) << "refreshParametersPrefix - name:" << namePrefix << ")";
 
-    foreach(const QString &name, _mapParameterName2Variant[componentId].keys()) {
+    if (!_componentStores.contains(componentId)) {
+        return;
+    }
+
+    foreach(const QString &name, _componentStores[componentId].factNames()) {
         if (name.startsWith(namePrefix)) {
             refreshParameter(componentId, name);
         }
@@ -484,8 +522,8 @@ bool ParameterManager::parameterExists(int componentId, const QString&  name)
     bool ret = false;
 
     componentId = _actualComponentId(componentId);
-    if (_mapParameterName2Variant.contains(componentId)) {
-        ret = _mapParameterName2Variant[componentId].contains(_remapParamNameToVersion(name));
+    if (_componentStores.contains(componentId)) {
+        ret = _componentStores[componentId].fact(_remapParamNameToVersion(name)) != NULL;
     }
 
     return ret;
@@ -496,23 +534,23 @@ Fact* ParameterManager::getParameter(int componentId, const QString& name)
     componentId = _actualComponentId(componentId);
 
     QString mappedParamName = _remapParamNameToVersion(name);
-    if (!_mapParameterName2Variant.contains(componentId) || !_mapParameterName2Variant[componentId].contains(mappedParamName)) {
+    Fact* fact = _componentStores.contains(componentId) ? _componentStores[componentId].fact(mappedParamName) : NULL;
+    if (!fact) {
         qgcApp()->reportMissingParameter(componentId, mappedParamName);
         return &_defaultFact;
     }
 
-    return _mapParameterName2Variant[componentId][mappedParamName].value<Fact*>();
+    return fact;
 }
 
 QStringList ParameterManager::parameterNames(int componentId)
 {
-    QStringList names;
-
-    foreach(const QString &paramName, _mapParameterName2Variant[_actualComponentId(componentId)].keys()) {
-        names << paramName;
+    componentId = _actualComponentId(componentId);
+    if (!_componentStores.contains(componentId)) {
+        return QStringList();
     }
 
-    return names;
+    return _componentStores[componentId].factNames();
 }
 
 void ParameterManager::_setupGroupMap(void)
@@ -520,10 +558,11 @@ void ParameterManager::_setupGroupMap(void)
     // Must be able to handle being called multiple times
     _mapGroup2ParameterName.clear();
 
-    foreach (int componentId, _mapParameterName2Variant.keys()) {
-        foreach (const QString &name, _mapParameterName2Variant[componentId].keys()) {
-            Fact* fact = _mapParameterName2Variant[componentId][name].value<Fact*>();
-            _mapGroup2ParameterName[componentId][fact->group()] += name;
+    for (QMap<int, ParameterStore>::const_iterator it = _componentStores.constBegin(); it != _componentStores.constEnd(); ++it) {
+        const ParameterStore& store = it.value();
+        QMap<QString, QStringList>& groupMap = _mapGroup2ParameterName[it.key()];
+        foreach (int slot, store.sortedFactSlots()) {
+            groupMap[store.fact(slot)->group()] += store.name(slot);
         }
     }
 }
@@ -541,32 +580,36 @@ void ParameterManager::_waitingParamTimeout(void)
 
     qCDebug(ParameterManagerLog) << _logVehiclePrefix() << "_waitingParamTimeout";
 
-    // First check for any missing parameters from the initial index based load
+    // First check for any missing parameters from the initial index based load. These are handed to the read window
+    // which keeps re-requests pipelined until the gaps are filled, timing out and retrying them on its own.
 
-    batchCount = 0;
-    foreach(int componentId, _waitingReadParamIndexMap.keys()) {
-        if (_waitingReadParamIndexMap[componentId].count()) {
-            qCDebug(ParameterManagerLog) << _logVehiclePrefix() << "_waitingReadParamIndexMap" << _waitingReadParamIndexMap[componentId];
-        }
+    if (!_readWindow.isIdle()) {
+        qCDebug(ParameterManagerLog) << _logVehiclePrefix() << "Read window still busy - queued:outstanding" << _readWindow.queuedCount() << _readWindow.outstandingCount();
+        paramsRequested = true;
+    } else {
+        for (QMap<int, ParameterStore>::iterator it = _componentStores.begin(); it != _componentStores.end(); ++it) {
+            int componentId = it.key();
+            ParameterStore& store = it.value();
 
-        foreach(int paramIndex, _waitingReadParamIndexMap[componentId].keys()) {            
-            if (++batchCount > maxBatchSize) {
-                goto Out;
+            if (store.waitingReadIndexCount()) {
+                qCDebug(ParameterManagerLog) << _logVehiclePrefix() << "waiting read param indices" << store.waitingReadIndices();
             }
 
-            _waitingReadParamIndexMap[componentId][paramIndex]++;   // Bump retry count
-            if (_disableAllRetries || _waitingReadParamIndexMap[componentId][paramIndex] > _maxInitialLoadRetrySingleParam) {
-                // Give up on this index
-                _failedReadParamIndexMap[componentId] << paramIndex;
-                qCDebug(ParameterManagerLog) << _logVehiclePrefix(componentId) << "Giving up on (paramIndex:" << paramIndex << "retryCount:" << _waitingReadParamIndexMap[componentId][paramIndex] << ")";
-                _waitingReadParamIndexMap[componentId].remove(paramIndex);
-            } else {
-                // Retry again
-                paramsRequested = true;
-                _readParameterRaw(componentId, "", paramIndex);
-                qCDebug(ParameterManagerLog) << _logVehiclePrefix(componentId) << "Read re-request for (paramIndex:" << paramIndex << "retryCount:" << _waitingReadParamIndexMap[componentId][paramIndex] << ")";
+            for (int paramIndex = store.nextWaitingReadIndex(0); paramIndex != -1; paramIndex = store.nextWaitingReadIndex(paramIndex + 1)) {
+                int retryCount = store.bumpReadIndexRetry(paramIndex);
+                if (_disableAllRetries || retryCount > _maxInitialLoadRetrySingleParam) {
+                    // Give up on this index
+                    store.setReadIndexFailed(paramIndex);
+                    qCDebug(ParameterManagerLog) << _logVehiclePrefix(componentId) << "Giving up on (paramIndex:" << paramIndex << "retryCount:" << retryCount << ")";
+                } else {
+                    // Retry again
+                    paramsRequested = true;
+                    _readWindow.queue(componentId, paramIndex);
+                    qCDebug(ParameterManagerVerbose1Log) << _logVehiclePrefix(componentId) << "Read re-request queued for (paramIndex:" << paramIndex << "retryCount:" << retryCount << ")";
+                }
             }
         }
+        _sendReadWindowRequests();
     }
 
     if (!paramsRequested && _defaultComponentId == MAV_COMP_ID_ALL && !_defaultComponentIdParam.isEmpty() && !_waitingForDefaultComponent) {
@@ -583,19 +626,23 @@ void ParameterManager::_waitingParamTimeout(void)
     _checkInitialLoadComplete(true /* failIfNoDefaultComponent */);
 
     if (!paramsRequested) {
-        foreach(int componentId, _waitingWriteParamNameMap.keys()) {
-            foreach(const QString &paramName, _waitingWriteParamNameMap[componentId].keys()) {
+        for (QMap<int, ParameterStore>::iterator it = _componentStores.begin(); it != _componentStores.end(); ++it) {
+            int componentId = it.key();
+            ParameterStore& store = it.value();
+
+            for (int slot = store.nextWaiting(ParameterStore::WaitWrite, 0); slot != -1; slot = store.nextWaiting(ParameterStore::WaitWrite, slot + 1)) {
+                const QString& paramName = store.name(slot);
                 paramsRequested = true;
-                _waitingWriteParamNameMap[componentId][paramName]++;   // Bump retry count
-                if (_waitingWriteParamNameMap[componentId][paramName] <= _maxReadWriteRetry) {
-                    _writeParameterRaw(componentId, paramName, getParameter(componentId, paramName)->rawValue());
-                    qCDebug(ParameterManagerLog) << _logVehiclePrefix(componentId) << "Write resend for (paramName:" << paramName << "retryCount:" << _waitingWriteParamNameMap[componentId][paramName] << ")";
+                int retryCount = store.bumpRetry(ParameterStore::WaitWrite, slot);
+                if (retryCount <= _maxReadWriteRetry) {
+                    _writeParameterRaw(componentId, paramName, store.fact(slot)->rawValue());
+                    qCDebug(ParameterManagerLog) << _logVehiclePrefix(componentId) << "Write resend for (paramName:" << paramName << "retryCount:" << retryCount << ")";
                     if (++batchCount > maxBatchSize) {
                         goto Out;
                     }
                 } else {
                     // Exceeded max retry count, notify user
-                    _waitingWriteParamNameMap[componentId].remove(paramName);
+                    store.clearWaiting(ParameterStore::WaitWrite, slot);
                     QString errorMsg = tr("Parameter write failed: veh:%1 comp:%2 param:%3").arg(_vehicle->id()).arg(componentId).arg(paramName);
                     qCDebug(ParameterManagerLog) << errorMsg;
                     qgcApp()->showMessage(errorMsg);
@@ -605,19 +652,23 @@ void ParameterManager::_waitingParamTimeout(void)
     }
 
     if (!paramsRequested) {
-        foreach(int componentId, _waitingReadParamNameMap.keys()) {
-            foreach(const QString &paramName, _waitingReadParamNameMap[componentId].keys()) {
+        for (QMap<int, ParameterStore>::iterator it = _componentStores.begin(); it != _componentStores.end(); ++it) {
+            int componentId = it.key();
+            ParameterStore& store = it.value();
+
+            for (int slot = store.nextWaiting(ParameterStore::WaitRead, 0); slot != -1; slot = store.nextWaiting(ParameterStore::WaitRead, slot + 1)) {
+                const QString& paramName = store.name(slot);
                 paramsRequested = true;
-                _waitingReadParamNameMap[componentId][paramName]++;   // Bump retry count
-                if (_waitingReadParamNameMap[componentId][paramName] <= _maxReadWriteRetry) {
+                int retryCount = store.bumpRetry(ParameterStore::WaitRead, slot);
+                if (retryCount <= _maxReadWriteRetry) {
                     _readParameterRaw(componentId, paramName, -1);
-                    qCDebug(ParameterManagerLog) << _logVehiclePrefix(componentId) << "Read re-request for (paramName:" << paramName << "retryCount:" << _waitingReadParamNameMap[componentId][paramName] << ")";
+                    qCDebug(ParameterManagerLog) << _logVehiclePrefix(componentId) << "Read re-request for (paramName:" << paramName << "retryCount:" << retryCount << ")";
                     if (++batchCount > maxBatchSize) {
                         goto Out;
                     }
                 } else {
                     // Exceeded max retry count, notify user
-                    _waitingReadParamNameMap[componentId].remove(paramName);
+                    store.clearWaiting(ParameterStore::WaitRead, slot);
                     QString errorMsg = tr("Parameter read failed: veh:%1 comp:%2 param:%3").arg(_vehicle->id()).arg(componentId).arg(paramName);
                     qCDebug(ParameterManagerLog) << errorMsg;
                     qgcApp()->showMessage(errorMsg);
@@ -707,26 +758,31 @@ void ParameterManager::_writeParameterRaw(int componentId, const QString& paramN
     _vehicle->sendMessageOnLink(_vehicle->priorityLink(), msg);
 }
 
-void ParameterManager::_writeLocalParamCache(int vehicleId, int componentId)
+/// Writes all caches which changed since they were last written
+void ParameterManager::_saveParamCaches(void)
 {
-    MapID2NamedParam cache_map;
+    _paramCacheSaveTimer.stop();
 
-    foreach(int id, _mapParameterId2Name[componentId].keys()) {
-        const QString name(_mapParameterId2Name[componentId][id]);
-        const Fact *fact = _mapParameterName2Variant[componentId][name].value<Fact*>();
-        cache_map[id] = NamedParam(name, ParamTypeVal(fact->type(), fact->rawValue()));
+    for (QMap<int, ParameterCache>::iterator it = _componentCaches.begin(); it != _componentCaches.end(); ++it) {
+        if (it.value().dirty()) {
+            QString cacheFile = parameterCacheFile(_vehicle->id(), it.key());
+            if (it.value().save(cacheFile)) {
+                qCDebug(ParameterManagerLog) << _logVehiclePrefix(it.key()) << "Parameter cache saved - count:" << it.value().count();
+            } else {
+                qWarning() << _logVehiclePrefix(it.key()) << "Unable to save parameter cache" << cacheFile;
+            }
+        }
     }
+}
 
-    QFile cache_file(parameterCacheFile(vehicleId, componentId));
-    cache_file.open(QIODevice::WriteOnly | QIODevice::Truncate);
-
-    QDataStream ds(&cache_file);
-    ds << cache_map;
+void ParameterManager::setParameterCacheRoot(const QString& path)
+{
+    _parameterCacheRoot = path;
 }
 
 QDir ParameterManager::parameterCacheDir()
 {
-    const QString spath(QFileInfo(QSettings().fileName()).dir().absolutePath());
+    const QString spath(_parameterCacheRoot.isEmpty() ? QFileInfo(QSettings().fileName()).dir().absolutePath() : _parameterCacheRoot);
     return spath + QDir::separator() + "ParamCache";
 }
 
@@ -737,47 +793,26 @@ QString ParameterManager::parameterCacheFile(int vehicleId, int componentId)
 
 void ParameterManager::_tryCacheHashLoad(int vehicleId, int componentId, QVariant hash_value)
 {
-    uint32_t crc32_value = 0;
-    /* The datastructure of the cache table */
-    MapID2NamedParam cache_map;
-    QFile cache_file(parameterCacheFile(vehicleId, componentId));
-    if (!cache_file.exists()) {
-        /* no local cache, just wait for them to come in*/
-        return;
-    }
-    cache_file.open(QIODevice::ReadOnly);
+    QString cacheFile = parameterCacheFile(vehicleId, componentId);
+    quint32 cacheHash;
 
-    /* Deserialize the parameter cache table */
-    QDataStream ds(&cache_file);
-    ds >> cache_map;
-
-    /* compute the crc of the local cache to check against the remote */
-
-    foreach(int id, cache_map.keys()) {
-        const QString name(cache_map[id].first);
-        const void *vdat = cache_map[id].second.second.constData();
-        const FactMetaData::ValueType_t fact_type = static_cast<FactMetaData::ValueType_t>(cache_map[id].second.first);
-        crc32_value = QGC::crc32((const uint8_t *)qPrintable(name), name.length(),  crc32_value);
-        crc32_value = QGC::crc32((const uint8_t *)vdat, FactMetaData::typeToSize(fact_type), crc32_value);
+    // Only the cache header is needed to check the hash, the parameters are read when it matches
+    if (!ParameterCache::readHash(cacheFile, cacheHash) || cacheHash != hash_value.toUInt()) {
+        /* no local cache or out of date, just wait for them to come in */
+        return;
     }
 
-    if (crc32_value == hash_value.toUInt()) {
-        qCInfo(ParameterManagerLog) << "Parameters loaded from cache" << qPrintable(QFileInfo(cache_file).absoluteFilePath());
+    if (_componentCaches[componentId].load(cacheFile)) {
+        qCInfo(ParameterManagerLog) << "Parameters loaded from cache" << qPrintable(QFileInfo(cacheFile).absoluteFilePath());
         /* if the two param set hashes match, just load from the disk */
-        int count = cache_map.count();
-        foreach(int id, cache_map.keys()) {
-            const QString &name = cache_map[id].first;
-            const QVariant &value = cache_map[id].second.second;
-            const FactMetaData::ValueType_t fact_type = static_cast<FactMetaData::ValueType_t>(cache_map[id].second.first);
-            const int mavType = _factTypeToMavType(fact_type);
-            _parameterUpdate(vehicleId, componentId, name, count, id, mavType, value);
-        }
+        _preloadFromParamCache(vehicleId, componentId);
+
         // Return the hash value to notify we don't want any more updates
         mavlink_param_set_t     p;
         mavlink_param_union_t   union_value;
         p.param_type = MAV_PARAM_TYPE_UINT32;
         strncpy(p.param_id, "_HASH_CHECK", sizeof(p.param_id));
-        union_value.param_uint32 = crc32_value;
+        union_value.param_uint32 = cacheHash;
         p.param_value = union_value.param_float;
         p.target_system = (uint8_t)_vehicle->id();
         p.target_component = (uint8_t)componentId;
@@ -811,6 +846,52 @@ void ParameterManager::_tryCacheHashLoad(int vehicleId, int componentId, QVarian
     }
 }
 
+/// Fills in all parameters of the component which have not been received yet from its cache. The cache must have been
+/// confirmed, either through the PX4 parameter set hash or by sampling the start of the parameter stream.
+void ParameterManager::_preloadFromParamCache(int vehicleId, int componentId)
+{
+    // Work from a copy, each update goes back through the cache
+    QMap<int, ParameterCache::Entry_t> entries = _componentCaches[componentId].entries();
+    int paramCount = _componentCaches[componentId].paramCount();
+
+    int preloadCount = 0;
+    for (QMap<int, ParameterCache::Entry_t>::const_iterator it = entries.constBegin(); it != entries.constEnd(); ++it) {
+        if (_componentStores.contains(componentId) && !_componentStores[componentId].readIndexWaiting(it.key())) {
+            // Already received from the vehicle
+            continue;
+        }
+
+        const ParameterCache::Entry_t& entry = it.value();
+        _parameterUpdate(vehicleId, componentId, entry.name, paramCount, it.key(), _factTypeToMavType(entry.type), entry.value);
+        preloadCount++;
+    }
+
+    qCDebug(ParameterManagerLog) << _logVehiclePrefix(componentId) << "Parameters loaded from cache - count:" << preloadCount;
+}
+
+/// Requests the parameters of the component which are still missing after loading it from its cache through the read
+/// window, instead of waiting for the stream to get to them
+void ParameterManager::_requestMissingParams(int componentId)
+{
+    _dataMutex.lock();
+
+    int requestCount = 0;
+    if (_componentStores.contains(componentId)) {
+        ParameterStore& store = _componentStores[componentId];
+        for (int paramIndex = store.nextWaitingReadIndex(0); paramIndex != -1; paramIndex = store.nextWaitingReadIndex(paramIndex + 1)) {
+            _readWindow.queue(componentId, paramIndex);
+            requestCount++;
+        }
+    }
+
+    _dataMutex.unlock();
+
+    if (requestCount) {
+        qCDebug(ParameterManagerLog) << _logVehiclePrefix(componentId) << "Requesting parameters missing from cache - count:" << requestCount;
+        _sendReadWindowRequests();
+    }
+}
+
 void ParameterManager::_saveToEEPROM(void)
 {
     if (_saveRequired) {
@@ -879,9 +960,12 @@ void ParameterManager::writeParametersToStream(QTextStream &stream)
     stream << "#\n";
     stream << "# Vehicle-Id Component-Id Name Value Type\n";
 
-    foreach (int componentId, _mapParameterName2Variant.keys()) {
-        foreach (const QString &paramName, _mapParameterName2Variant[componentId].keys()) {
-            Fact* fact = _mapParameterName2Variant[componentId][paramName].value<Fact*>();
+    for (QMap<int, ParameterStore>::const_iterator it = _componentStores.constBegin(); it != _componentStores.constEnd(); ++it) {
+        int componentId = it.key();
+        const ParameterStore& store = it.value();
+        foreach (int slot, store.sortedFactSlots()) {
+            Fact* fact = store.fact(slot);
+            const QString& paramName = store.name(slot);
             if (fact) {
                 stream << _vehicle->id() << "\t" << componentId << "\t" << paramName << "\t" << fact->rawValueStringFullPrecision() << "\t" << QString("%1").arg(_factTypeToMavType(fact->type())) << "\n";
             } else {
@@ -974,9 +1058,11 @@ void ParameterManager::_addMetaDataToDefaultComponent(void)
      _parameterMetaData = _vehicle->firmwarePlugin()->loadParameterMetaData(metaDataFile);
 
     // Loop over all parameters in default component adding meta data
-    QVariantMap& factMap = _mapParameterName2Variant[_defaultComponentId];
-    foreach (const QString& key, factMap.keys()) {
-        _vehicle->firmwarePlugin()->addMetaDataToFact(_parameterMetaData, factMap[key].value<Fact*>(), _vehicle->vehicleType());
+    if (_componentStores.contains(_defaultComponentId)) {
+        const ParameterStore& store = _componentStores[_defaultComponentId];
+        foreach (int slot, store.sortedFactSlots()) {
+            _vehicle->firmwarePlugin()->addMetaDataToFact(_parameterMetaData, store.fact(slot), _vehicle->vehicleType());
+        }
     }
 }
 
@@ -988,8 +1074,8 @@ void ParameterManager::_checkInitialLoadComplete(bool failIfNoDefaultComponent)
         return;
     }
 
-    foreach (int componentId, _waitingReadParamIndexMap.keys()) {
-        if (_waitingReadParamIndexMap[componentId].count()) {
+    for (QMap<int, ParameterStore>::const_iterator it = _componentStores.constBegin(); it != _componentStores.constEnd(); ++it) {
+        if (it.value().waitingReadIndexCount()) {
             // We are still waiting on some parameters, not done yet
             return;
         }
@@ -1003,13 +1089,17 @@ void ParameterManager::_checkInitialLoadComplete(bool failIfNoDefaultComponent)
     // We aren't waiting for any more initial parameter updates, initial parameter loading is complete
     _initialLoadComplete = true;
 
-    qCDebug(ParameterManagerLog) << _logVehiclePrefix() << "Initial load complete";
+    _loadTimeMsecs = _loadTimer.elapsed();
+    qCDebug(ParameterManagerLog) << _logVehiclePrefix() << "Initial load complete - msecs:" << _loadTimeMsecs
+                                 << "re-requested:" << _readWindow.answeredCount() << "timeouts:" << _readWindow.timeoutCount()
+                                 << "rtt:" << _readWindow.rttMsecs() << "window:" << _readWindow.window();
 
     // Check for index based load failures
     QString indexList;
     bool initialLoadFailures = false;
-    foreach (int componentId, _failedReadParamIndexMap.keys()) {
-        foreach (int paramIndex, _failedReadParamIndexMap[componentId]) {
+    for (QMap<int, ParameterStore>::const_iterator it = _componentStores.constBegin(); it != _componentStores.constEnd(); ++it) {
+        int componentId = it.key();
+        foreach (int paramIndex, it.value().failedReadIndices()) {
             if (initialLoadFailures) {
                 indexList += ", ";
             }
@@ -1322,7 +1412,8 @@ void ParameterManager::_loadOfflineEditingParams(void)
         }
 
         Fact* fact = new Fact(_defaultComponentId, paramName, _mavTypeToFactType(paramType), this);
-        _mapParameterName2Variant[_defaultComponentId][paramName] = QVariant::fromValue(fact);
+        ParameterStore& store = _componentStores[_defaultComponentId];
+        store.setFact(store.addSlot(paramName), fact);
     }
 
     _addMetaDataToDefaultComponent();
@@ -1337,7 +1428,7 @@ void ParameterManager::saveToJson(int componentId, const QStringList& paramsToSa
     QStringList rgParamNames;
 
     if (componentId == MAV_COMP_ID_ALL) {
-        rgCompIds = _mapParameterName2Variant.keys();
+        rgCompIds = _componentStores.keys();
     } else {
         rgCompIds.append(_actualComponentId(componentId));
     }
@@ -1348,7 +1439,7 @@ void ParameterManager::saveToJson(int componentId, const QStringList& paramsToSa
     for (int i=0; i<rgCompIds.count(); i++) {
         int compId = rgCompIds[i];
 
-        if (!_mapParameterName2Variant.contains(compId)) {
+        if (!_componentStores.contains(compId)) {
             qCDebug(ParameterManagerLog) << "ParameterManager::saveToJson no params for compId" << compId;
             continue;
         }
@@ -1454,6 +1545,73 @@ QString ParameterManager::_logVehiclePrefix(int componentId)
     }
 }
 
+/// Sends as many read window requests as the window allows and times out the ones in flight
+void ParameterManager::_sendReadWindowRequests(void)
+{
+    qint64 nowMsecs = _readWindowClock.elapsed();
+
+    foreach (const ParameterReadWindow::Request& request, _readWindow.takeRequestsToSend(nowMsecs)) {
+        qCDebug(ParameterManagerVerbose1Log) << _logVehiclePrefix(request.first) << "Read re-request for (paramIndex:" << request.second << ")";
+        _readParameterRaw(request.first, "", request.second);
+    }
+
+    int timeoutMsecs = _readWindow.msecsToNextTimeout(nowMsecs);
+    if (timeoutMsecs == -1) {
+        _readWindowTimer.stop();
+    } else {
+        _readWindowTimer.start(timeoutMsecs);
+    }
+}
+
+void ParameterManager::_readWindowTimeout(void)
+{
+    foreach (const ParameterReadWindow::Request& request, _readWindow.takeTimedOut(_readWindowClock.elapsed())) {
+        int componentId = request.first;
+        int paramIndex = request.second;
+
+        if (!_componentStores.contains(componentId) || !_componentStores[componentId].readIndexWaiting(paramIndex)) {
+            continue;
+        }
+
+        ParameterStore& store = _componentStores[componentId];
+        int retryCount = store.bumpReadIndexRetry(paramIndex);
+        if (retryCount > _maxInitialLoadRetrySingleParam) {
+            // Give up on this index
+            store.setReadIndexFailed(paramIndex);
+            qCDebug(ParameterManagerLog) << _logVehiclePrefix(componentId) << "Giving up on (paramIndex:" << paramIndex << "retryCount:" << retryCount << ")";
+        } else {
+            _readWindow.requeue(request);
+            qCDebug(ParameterManagerLog) << _logVehiclePrefix(componentId) << "Read re-request timed out (paramIndex:" << paramIndex << "retryCount:" << retryCount << "rto:" << _readWindow.rtoMsecs() << ")";
+        }
+    }
+
+    _sendReadWindowRequests();
+
+    // Make sure the load is wrapped up, even if the last requests never got an answer
+    _waitingParamTimeoutTimer.start();
+}
+
+void ParameterManager::_receiveLossPercentChanged(int uasId, float lossPercent)
+{
+    if (uasId == _vehicle->id()) {
+        _readWindow.setLinkLossPercent(lossPercent);
+    }
+}
+
+/// Totals the wait lists across all components
+void ParameterManager::_waitingParamCounts(int& waitingReadParamIndexCount, int& waitingReadParamNameCount, int& waitingWriteParamNameCount)
+{
+    waitingReadParamIndexCount = 0;
+    waitingReadParamNameCount = 0;
+    waitingWriteParamNameCount = 0;
+
+    for (QMap<int, ParameterStore>::const_iterator it = _componentStores.constBegin(); it != _componentStores.constEnd(); ++it) {
+        waitingReadParamIndexCount += it.value().waitingReadIndexCount();
+        waitingReadParamNameCount += it.value().waitingCount(ParameterStore::WaitRead);
+        waitingWriteParamNameCount += it.value().waitingCount(ParameterStore::WaitWrite);
+    }
+}
+
 void ParameterManager::_setLoadProgress(double loadProgress)
 {
     _loadProgress = loadProgress;
@@ -18,8 +18,12 @@
 #include <QMutex>
 #include <QDir>
 #include <QJsonObject>
+#include <QElapsedTimer>
 
 #include "FactSystem.h"
+#include "ParameterStore.h"
+#include "ParameterReadWindow.h"
+#include "ParameterCache.h"
 #include "MAVLinkProtocol.h"
 #include "AutoPilotPlugin.h"
 #include "QGCMAVLink.h"
@@ -55,6 +59,10 @@ public:
     /// @return Directory of parameter caches
     static QDir parameterCacheDir();
 
+    /// Keeps the parameter caches below the specified directory instead of the settings directory. Used by unit tests
+    /// so they never touch the caches of the real application.
+    static void setParameterCacheRoot(const QString& path);
+
     /// @return Location of parameter cache file
     static QString parameterCacheFile(int vehicleId, int componentId);
     
@@ -121,6 +129,12 @@ public:
 
     Vehicle* vehicle(void) { return _vehicle; }
 
+    /// @return Time the initial parameter load took in msecs, -1 if not complete yet
+    int loadTimeMsecs(void) const { return _loadTimeMsecs; }
+
+    /// Window used to re-request parameters missing from the initial load, for its metrics
+    const ParameterReadWindow& readWindow(void) const { return _readWindow; }
+
 signals:
     void parametersReadyChanged(bool parametersReady);
     void missingParametersChanged(bool missingParameters);
@@ -135,6 +149,9 @@ protected:
     void _waitingParamTimeout(void);
     void _tryCacheLookup(void);
     void _initialRequestTimeout(void);
+    void _readWindowTimeout(void);
+    void _receiveLossPercentChanged(int uasId, float lossPercent);
+    void _saveParamCaches(void);
 
 private:
     static QVariant _stringToTypedVariant(const QString& string, FactMetaData::ValueType_t type, bool failOk = false);
@@ -143,8 +160,9 @@ private:
     void _setupGroupMap(void);
     void _readParameterRaw(int componentId, const QString& paramName, int paramIndex);
     void _writeParameterRaw(int componentId, const QString& paramName, const QVariant& value);
-    void _writeLocalParamCache(int vehicleId, int componentId);
     void _tryCacheHashLoad(int vehicleId, int componentId, QVariant hash_value);
+    void _preloadFromParamCache(int vehicleId, int componentId);
+    void _requestMissingParams(int componentId);
     void _addMetaDataToDefaultComponent(void);
     QString _remapParamNameToVersion(const QString& paramName);
     void _loadOfflineEditingParams(void);
@@ -155,13 +173,16 @@ private:
     FactMetaData::ValueType_t _mavTypeToFactType(MAV_PARAM_TYPE mavType);
     void _saveToEEPROM(void);
     void _checkInitialLoadComplete(bool failIfNoDefaultComponent);
+    void _sendReadWindowRequests(void);
+    void _waitingParamCounts(int& waitingReadParamIndexCount, int& waitingReadParamNameCount, int& waitingWriteParamNameCount);
 
-    /// First mapping is by component id
-    /// Second mapping is parameter name, to Fact* in QVariant
-    QMap<int, QVariantMap>            _mapParameterName2Variant;
+    /// Parameters and their wait lists, by component id
+    QMap<int, ParameterStore>   _componentStores;
+
+    /// Local parameter caches, by component id
+    QMap<int, ParameterCache>   _componentCaches;
+    QTimer                      _paramCacheSaveTimer;   ///< Limits how often parameter changes are written to the caches
 
-    QMap<int, QMap<int, QString> >    _mapParameterId2Name;
-    
     /// First mapping is by component id
     /// Second mapping is group name, to Fact
     QMap<int, QMap<QString, QStringList> > _mapGroup2ParameterName;
@@ -190,21 +211,24 @@ private:
     static const int    _maxReadWriteRetry = 5;                 ///< Maximum retries read/write
     bool                _disableAllRetries;                     ///< true: Don't retry any requests (used for testing)
 
-    QMap<int, int>                  _paramCountMap;             ///< Key: Component id, Value: count of parameters in this component
-    QMap<int, QMap<int, int> >      _waitingReadParamIndexMap;  ///< Key: Component id, Value: Map { Key: parameter index still waiting for, Value: retry count }
-    QMap<int, QMap<QString, int> >  _waitingReadParamNameMap;   ///< Key: Component id, Value: Map { Key: parameter name still waiting for, Value: retry count }
-    QMap<int, QMap<QString, int> >  _waitingWriteParamNameMap;  ///< Key: Component id, Value: Map { Key: parameter name still waiting for, Value: retry count }
-    QMap<int, QList<int> >          _failedReadParamIndexMap;   ///< Key: Component id, Value: failed parameter index
-
     int _totalParamCount;   ///< Number of parameters across all components
     
     QTimer _initialRequestTimeoutTimer;
     QTimer _waitingParamTimeoutTimer;
+
+    ParameterReadWindow _readWindow;        ///< Re-requests parameters missing from the initial load
+    QTimer              _readWindowTimer;   ///< Fires when the oldest read window request times out
+    QElapsedTimer       _readWindowClock;
+
+    QElapsedTimer       _loadTimer;
+    int                 _loadTimeMsecs;     ///< Initial load time, -1 until complete
     
     QMutex _dataMutex;
     
     static Fact _defaultFact;   ///< Used to return default fact, when parameter not found
 
+    static QString _parameterCacheRoot; ///< Overrides the settings directory as parent of parameterCacheDir
+
     static const char* _cachedMetaDataFilePrefix;
     static const char* _jsonParametersKey;
     static const char* _jsonCompIdKey;
@@ -138,3 +138,59 @@ void ParameterManagerTest::_requestListMissingParamFail(void)
     // User should have been notified
     checkExpectedMessageBox();
 }
+
+/// Parameter load over a link which drops every tenth message. Parameters lost from the initial stream must all be
+/// filled in by re-requests, without re-requesting much more than what was lost.
+void ParameterManagerTest::_lossyLink(void)
+{
+    const int dropInterval = 10;
+
+    Q_ASSERT(!_mockLink);
+    _mockLink = MockLink::startPX4MockLink(false);
+    _mockLink->setPacketDropInterval(dropInterval);
+
+    MultiVehicleManager* vehicleMgr = qgcApp()->toolbox()->multiVehicleManager();
+    QVERIFY(vehicleMgr);
+
+    // The first heartbeat may be one of the dropped messages
+    QSignalSpy spyVehicle(vehicleMgr, SIGNAL(activeVehicleAvailableChanged(bool)));
+    QCOMPARE(spyVehicle.wait(5000), true);
+
+    Vehicle* vehicle = vehicleMgr->activeVehicle();
+    QVERIFY(vehicle);
+    ParameterManager* parameterManager = vehicle->parameterManager();
+
+    QSignalSpy spyParamsReady(vehicleMgr, SIGNAL(parameterReadyVehicleAvailableChanged(bool)));
+    QCOMPARE(spyParamsReady.wait(15000), true);
+    QCOMPARE(parameterManager->missingParameters(), false);
+    QVERIFY(parameterManager->loadTimeMsecs() > 0);
+
+    // At most one in dropInterval parameters is lost from the initial stream, plus the re-request answers which are
+    // lost in turn and retried
+    int paramCount = parameterManager->parameterNames(parameterManager->defaultComponentId()).count();
+    int maxLostParams = paramCount / dropInterval + 1;
+    const ParameterReadWindow& readWindow = parameterManager->readWindow();
+    QVERIFY(paramCount > 0);
+    QVERIFY(readWindow.answeredCount() > 0);
+    QVERIFY(readWindow.answeredCount() <= 2 * maxLostParams);
+    QVERIFY(readWindow.timeoutCount() <= maxLostParams);
+}
+
+/// ArduPilot has no parameter set hash. Once the start of the parameter stream confirms the cache from the first
+/// connection the second load completes right away, without waiting for the rest of the stream.
+void ParameterManagerTest::_apmCachedReconnect(void)
+{
+    _connectMockLink(MAV_AUTOPILOT_ARDUPILOTMEGA);
+    ParameterManager* parameterManager = _vehicle->parameterManager();
+    int firstLoadMsecs = parameterManager->loadTimeMsecs();
+    int paramCount = parameterManager->parameterNames(parameterManager->defaultComponentId()).count();
+    QVERIFY(firstLoadMsecs > 0);
+    QVERIFY(paramCount > 100);
+    _disconnectMockLink();
+
+    _connectMockLink(MAV_AUTOPILOT_ARDUPILOTMEGA);
+    parameterManager = _vehicle->parameterManager();
+    QCOMPARE(parameterManager->missingParameters(), false);
+    QCOMPARE(parameterManager->parameterNames(parameterManager->defaultComponentId()).count(), paramCount);
+    QVERIFY(parameterManager->loadTimeMsecs() < firstLoadMsecs / 2);
+}
@@ -0,0 +1,204 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+
+#include "ParameterMetaDataCache.h"
+#include "QGCLoggingCategory.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QDir>
+#include <QSaveFile>
+#include <QSettings>
+#include <QtEndian>
+
+#include <string.h>
+
+QGC_LOGGING_CATEGORY(ParameterMetaDataCacheLog, "ParameterMetaDataCacheLog")
+
+// File layout, all integers are little endian quint32:
+//      magic, format version, source stamp length, source stamp bytes
+//      record count, index entries (key offset, key length, data offset, data length) sorted by key
+//      keys and record data
+
+static void _appendUInt32(QByteArray& buffer, quint32 value)
+{
+    uchar bytes[4];
+    qToLittleEndian(value, bytes);
+    buffer.append((const char*)bytes, sizeof(bytes));
+}
+
+ParameterMetaDataCache::ParameterMetaDataCache(void)
+    : _data(NULL)
+    , _size(0)
+    , _recordCount(0)
+    , _indexOffset(0)
+{
+
+}
+
+ParameterMetaDataCache::~ParameterMetaDataCache()
+{
+    close();
+}
+
+QString ParameterMetaDataCache::cacheFile(const QString& metaDataFile)
+{
+    // Same location as ParameterManager::cacheMetaDataFile uses
+    QSettings settings;
+    QDir cacheDir = QFileInfo(settings.fileName()).dir();
+
+    return cacheDir.filePath(QString("%1.bin").arg(QFileInfo(metaDataFile).completeBaseName()));
+}
+
+QByteArray ParameterMetaDataCache::recordKey(const QString& category, const QString& name)
+{
+    return category.toUtf8() + '\x1f' + name.toUtf8();
+}
+
+QByteArray ParameterMetaDataCache::_sourceStamp(const QString& metaDataFile)
+{
+    QFileInfo info(metaDataFile);
+
+    return QString("%1|%2|%3|%4").arg(info.absoluteFilePath()).arg(info.size()).arg(info.lastModified().toMSecsSinceEpoch()).arg(QCoreApplication::applicationVersion()).toUtf8();
+}
+
+bool ParameterMetaDataCache::write(const QString& metaDataFile, const RecordMap& records)
+{
+    QSaveFile file(cacheFile(metaDataFile));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(ParameterMetaDataCacheLog) << "Unable to write parameter meta data cache" << file.fileName() << file.errorString();
+        return false;
+    }
+
+    QByteArray stamp = _sourceStamp(metaDataFile);
+    QByteArray header;
+    _appendUInt32(header, _magic);
+    _appendUInt32(header, formatVersion);
+    _appendUInt32(header, stamp.size());
+    header.append(stamp);
+    _appendUInt32(header, records.count());
+
+    // QMap iterates in key order, which is the order find() searches in
+    quint32 dataOffset = header.size() + (records.count() * _indexEntrySize);
+    QByteArray index;
+    QByteArray data;
+    for (RecordMap::const_iterator it = records.constBegin(); it != records.constEnd(); ++it) {
+        _appendUInt32(index, dataOffset + data.size());
+        _appendUInt32(index, it.key().size());
+        data.append(it.key());
+        _appendUInt32(index, dataOffset + data.size());
+        _appendUInt32(index, it.value().size());
+        data.append(it.value());
+    }
+
+    if (file.write(header) != header.size() || file.write(index) != index.size() || file.write(data) != data.size() || !file.commit()) {
+        qCWarning(ParameterMetaDataCacheLog) << "Unable to write parameter meta data cache" << file.fileName() << file.errorString();
+        return false;
+    }
+    qCDebug(ParameterMetaDataCacheLog) << "Wrote parameter meta data cache" << file.fileName() << "records:" << records.count();
+
+    return true;
+}
+
+bool ParameterMetaDataCache::open(const QString& metaDataFile)
+{
+    close();
+
+    _file.setFileName(cacheFile(metaDataFile));
+    if (!_file.exists()) {
+        qCDebug(ParameterMetaDataCacheLog) << "No parameter meta data cache for" << metaDataFile;
+        return false;
+    }
+    if (!_file.open(QIODevice::ReadOnly)) {
+        qCWarning(ParameterMetaDataCacheLog) << "Unable to open parameter meta data cache" << _file.fileName() << _file.errorString();
+        return false;
+    }
+    _size = _file.size();
+    _data = _file.map(0, _size);
+    if (!_data) {
+        qCWarning(ParameterMetaDataCacheLog) << "Unable to map parameter meta data cache" << _file.fileName() << _file.errorString();
+        close();
+        return false;
+    }
+
+    // Validate everything up front, find() relies on it
+    QByteArray stamp = _sourceStamp(metaDataFile);
+    qint64 offset = 12;
+    bool valid = _size >= offset &&
+            qFromLittleEndian<quint32>(_data) == _magic &&
+            qFromLittleEndian<quint32>(_data + 4) == formatVersion &&
+            qFromLittleEndian<quint32>(_data + 8) == (quint32)stamp.size() &&
+            _size >= offset + stamp.size() + 4 &&
+            memcmp(_data + offset, stamp.constData(), stamp.size()) == 0;
+    if (valid) {
+        offset += stamp.size();
+        _recordCount = qFromLittleEndian<quint32>(_data + offset);
+        _indexOffset = offset + 4;
+        valid = _recordCount >= 0 && _indexOffset + ((qint64)_recordCount * _indexEntrySize) <= _size;
+        for (int i=0; valid && i<_recordCount; i++) {
+            const uchar* entry = _data + _indexOffset + (i * _indexEntrySize);
+            valid = (qint64)qFromLittleEndian<quint32>(entry) + qFromLittleEndian<quint32>(entry + 4) <= _size &&
+                    (qint64)qFromLittleEndian<quint32>(entry + 8) + qFromLittleEndian<quint32>(entry + 12) <= _size;
+        }
+    }
+    if (!valid) {
+        qCDebug(ParameterMetaDataCacheLog) << "Parameter meta data cache out of date" << _file.fileName();
+        close();
+        return false;
+    }
+    qCDebug(ParameterMetaDataCacheLog) << "Using parameter meta data cache" << _file.fileName() << "records:" << _recordCount;
+
+    return true;
+}
+
+void ParameterMetaDataCache::close(void)
+{
+    if (_data) {
+        _file.unmap(_data);
+        _data = NULL;
+    }
+    _file.close();
+    _size = 0;
+    _recordCount = 0;
+    _indexOffset = 0;
+}
+
+bool ParameterMetaDataCache::find(const QString& category, const QString& name, QByteArray& record) const
+{
+    if (!_data) {
+        return false;
+    }
+
+    QByteArray key = recordKey(category, name);
+    int low = 0;
+    int high = _recordCount - 1;
+    while (low <= high) {
+        int mid = (low + high) / 2;
+        const uchar* entry = _data + _indexOffset + (mid * _indexEntrySize);
+        quint32 keyLength = qFromLittleEndian<quint32>(entry + 4);
+
+        // Same ordering as QByteArray, which sorted the index
+        int compare = memcmp(_data + qFromLittleEndian<quint32>(entry), key.constData(), qMin((int)keyLength, key.size()));
+        if (compare == 0) {
+            compare = (int)keyLength - key.size();
+        }
+        if (compare == 0) {
+            record = QByteArray::fromRawData((const char*)_data + qFromLittleEndian<quint32>(entry + 8), qFromLittleEndian<quint32>(entry + 12));
+            return true;
+        } else if (compare < 0) {
+            low = mid + 1;
+        } else {
+            high = mid - 1;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,80 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+
+#ifndef ParameterMetaDataCache_H
+#define ParameterMetaDataCache_H
+
+#include <QFile>
+#include <QMap>
+#include <QByteArray>
+#include <QLoggingCategory>
+
+Q_DECLARE_LOGGING_CATEGORY(ParameterMetaDataCacheLog)
+
+/// Binary cache of parsed parameter meta data.
+///
+/// The firmware plugins compile the meta data they parse from xml into a cache file the first time a meta data
+/// file is used, and memory map it on later loads instead of parsing the xml again. The cache holds one opaque
+/// record per parameter, encoded by the plugin. Records are found by category and parameter name with a binary
+/// search over a sorted index in the mapped file, so nothing is decoded until a Fact asks for its meta data.
+///
+/// A cache is only used if it was built from the same meta data file (path, size and modification time) by the
+/// same application version. Otherwise the xml is parsed again and the cache rebuilt.
+class ParameterMetaDataCache
+{
+public:
+    ParameterMetaDataCache(void);
+    ~ParameterMetaDataCache();
+
+    /// Records keyed by category and parameter name, see recordKey
+    typedef QMap<QByteArray, QByteArray> RecordMap;
+
+    /// @return Cache file for the specified meta data file. Caches are stored next to the cached meta data files.
+    static QString cacheFile(const QString& metaDataFile);
+
+    /// @return Key for the specified parameter in a RecordMap
+    static QByteArray recordKey(const QString& category, const QString& name);
+
+    /// Writes the cache for the specified meta data file, replacing any existing one
+    ///     @return false: cache could not be written
+    static bool write(const QString& metaDataFile, const RecordMap& records);
+
+    /// Maps the cache for the specified meta data file
+    ///     @return false: no cache available, or cache is out of date
+    bool open(const QString& metaDataFile);
+
+    void close(void);
+
+    bool isOpen(void) const { return _data != NULL; }
+
+    /// @return Number of records in the open cache
+    int count(void) const { return _recordCount; }
+
+    /// Looks up a parameter record in the open cache
+    ///     @param[out] record Record data. Refers to the mapped file, only valid until the cache is closed.
+    /// @return false: parameter not in cache
+    bool find(const QString& category, const QString& name, QByteArray& record) const;
+
+    static const quint32 formatVersion = 1;  ///< Bump when the file layout or any plugin record encoding changes
+
+private:
+    static QByteArray _sourceStamp(const QString& metaDataFile);
+
+    QFile   _file;
+    uchar*  _data;
+    qint64  _size;
+    int     _recordCount;
+    qint64  _indexOffset;
+
+    static const quint32 _magic = 0x444D5051;   ///< "QPMD"
+    static const int     _indexEntrySize = 16;  ///< key offset, key length, data offset, data length
+};
+
+#endif
@@ -0,0 +1,168 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "ParameterMetaDataCacheTest.h"
+#include "ParameterMetaDataCache.h"
+#include "PX4ParameterMetaData.h"
+#include "APMParameterMetaData.h"
+#include "Fact.h"
+
+#include <QFile>
+
+ParameterMetaDataCacheTest::ParameterMetaDataCacheTest(void)
+{
+
+}
+
+QString ParameterMetaDataCacheTest::_writeSourceFile(const QByteArray& contents)
+{
+    QString sourceFile = _tempDir.path() + "/ParameterMetaDataCacheTest.xml";
+    QFile file(sourceFile);
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(contents);
+    }
+    return sourceFile;
+}
+
+void ParameterMetaDataCacheTest::_roundTrip_test(void)
+{
+    QVERIFY(_tempDir.isValid());
+    QString sourceFile = _writeSourceFile("<parameters/>");
+
+    ParameterMetaDataCache::RecordMap records;
+    for (int i=0; i<1000; i++) {
+        records[ParameterMetaDataCache::recordKey(i % 2 ? "ArduCopter" : "libraries", QString("PARAM_%1").arg(i))] = QByteArray(i % 50, (char)i);
+    }
+    QVERIFY(ParameterMetaDataCache::write(sourceFile, records));
+
+    ParameterMetaDataCache cache;
+    QVERIFY(cache.open(sourceFile));
+    QCOMPARE(cache.count(), records.count());
+
+    QByteArray record;
+    for (int i=0; i<1000; i++) {
+        QVERIFY(cache.find(i % 2 ? "ArduCopter" : "libraries", QString("PARAM_%1").arg(i), record));
+        QCOMPARE(record, QByteArray(i % 50, (char)i));
+    }
+
+    // Category is part of the key, names which are prefixes of others must not match
+    QVERIFY(!cache.find("ArduCopter", "PARAM_0", record));
+    QVERIFY(!cache.find("libraries", "PARAM_", record));
+    QVERIFY(!cache.find("libraries", "PARAM_00", record));
+    QVERIFY(!cache.find(QString(), "PARAM_0", record));
+
+    cache.close();
+    QVERIFY(!cache.isOpen());
+    QVERIFY(!cache.find("libraries", "PARAM_0", record));
+
+    QFile::remove(ParameterMetaDataCache::cacheFile(sourceFile));
+}
+
+/// A cache is only used for the source file it was built from
+void ParameterMetaDataCacheTest::_outOfDate_test(void)
+{
+    QVERIFY(_tempDir.isValid());
+    QString sourceFile = _writeSourceFile("<parameters/>");
+    QString cacheFile = ParameterMetaDataCache::cacheFile(sourceFile);
+
+    ParameterMetaDataCache::RecordMap records;
+    records[ParameterMetaDataCache::recordKey(QString(), "PARAM")] = "record";
+    QVERIFY(ParameterMetaDataCache::write(sourceFile, records));
+
+    ParameterMetaDataCache cache;
+    QVERIFY(cache.open(sourceFile));
+    cache.close();
+
+    // Changed source file
+    _writeSourceFile("<parameters></parameters>");
+    QVERIFY(!cache.open(sourceFile));
+
+    // Truncated cache file
+    QVERIFY(ParameterMetaDataCache::write(sourceFile, records));
+    QVERIFY(cache.open(sourceFile));
+    cache.close();
+    QFile file(cacheFile);
+    QVERIFY(file.resize(file.size() - 1));
+    QVERIFY(!cache.open(sourceFile));
+
+    QFile::remove(cacheFile);
+    QVERIFY(!cache.open(sourceFile));
+}
+
+void ParameterMetaDataCacheTest::_compareMetaData(Fact& xmlFact, Fact& cacheFact)
+{
+    QCOMPARE(cacheFact.group(),              xmlFact.group());
+    QCOMPARE(cacheFact.shortDescription(),   xmlFact.shortDescription());
+    QCOMPARE(cacheFact.longDescription(),    xmlFact.longDescription());
+    QCOMPARE(cacheFact.rawUnits(),           xmlFact.rawUnits());
+    QCOMPARE(cacheFact.rawMin(),             xmlFact.rawMin());
+    QCOMPARE(cacheFact.rawMax(),             xmlFact.rawMax());
+    QCOMPARE(cacheFact.rawDefaultValue(),    xmlFact.rawDefaultValue());
+    QCOMPARE(cacheFact.decimalPlaces(),      xmlFact.decimalPlaces());
+    QCOMPARE(cacheFact.rebootRequired(),     xmlFact.rebootRequired());
+    QCOMPARE(cacheFact.enumStrings(),        xmlFact.enumStrings());
+    QCOMPARE(cacheFact.bitmaskStrings(),     xmlFact.bitmaskStrings());
+}
+
+/// PX4 meta data loaded from the cache matches the meta data parsed from xml
+void ParameterMetaDataCacheTest::_px4MetaData_test(void)
+{
+    QString metaDataFile(":/FirmwarePlugin/PX4/PX4ParameterFactMetaData.xml");
+    QString cacheFile = ParameterMetaDataCache::cacheFile(metaDataFile);
+    QFile::remove(cacheFile);
+
+    PX4ParameterMetaData xmlMetaData;
+    xmlMetaData.loadParameterFactMetaDataFile(metaDataFile);
+    QVERIFY(QFile::exists(cacheFile));
+
+    PX4ParameterMetaData cacheMetaData;
+    cacheMetaData.loadParameterFactMetaDataFile(metaDataFile);
+
+    // Enum values, bitmask, boolean and range/decimal/reboot meta data
+    QStringList names;
+    names << "BAT_SOURCE" << "EKF2_GPS_CHECK" << "ATT_J_EN" << "TRIG_PINS";
+    foreach (const QString& name, names) {
+        Fact xmlFact(0, name, FactMetaData::valueTypeInt32);
+        Fact cacheFact(0, name, FactMetaData::valueTypeInt32);
+        xmlMetaData.addMetaDataToFact(&xmlFact, MAV_TYPE_QUADROTOR);
+        cacheMetaData.addMetaDataToFact(&cacheFact, MAV_TYPE_QUADROTOR);
+        QVERIFY(!cacheFact.shortDescription().isEmpty());
+        _compareMetaData(xmlFact, cacheFact);
+    }
+
+    QFile::remove(cacheFile);
+}
+
+/// ArduPilot meta data loaded from the cache matches the meta data parsed from xml
+void ParameterMetaDataCacheTest::_apmMetaData_test(void)
+{
+    QString metaDataFile(":/FirmwarePlugin/APM/APMParameterFactMetaData.Copter.3.5.xml");
+    QString cacheFile = ParameterMetaDataCache::cacheFile(metaDataFile);
+    QFile::remove(cacheFile);
+
+    APMParameterMetaData xmlMetaData;
+    xmlMetaData.loadParameterFactMetaDataFile(metaDataFile);
+    QVERIFY(QFile::exists(cacheFile));
+
+    APMParameterMetaData cacheMetaData;
+    cacheMetaData.loadParameterFactMetaDataFile(metaDataFile);
+
+    // Vehicle parameters, library parameters and a parameter with no meta data
+    QStringList names;
+    names << "ARMING_CHECK" << "FLTMODE1" << "DISARM_DELAY" << "BATT_CAPACITY" << "NOT_A_PARAMETER";
+    foreach (const QString& name, names) {
+        Fact xmlFact(0, name, FactMetaData::valueTypeInt16);
+        Fact cacheFact(0, name, FactMetaData::valueTypeInt16);
+        xmlMetaData.addMetaDataToFact(&xmlFact, MAV_TYPE_QUADROTOR);
+        cacheMetaData.addMetaDataToFact(&cacheFact, MAV_TYPE_QUADROTOR);
+        _compareMetaData(xmlFact, cacheFact);
+    }
+
+    QFile::remove(cacheFile);
+}
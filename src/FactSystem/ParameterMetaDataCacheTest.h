@@ -0,0 +1,43 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#ifndef ParameterMetaDataCacheTest_H
+#define ParameterMetaDataCacheTest_H
+
+#include "UnitTest.h"
+
+#include <QTemporaryDir>
+
+class Fact;
+
+/// Unit test for the binary parameter meta data cache, and for the firmware plugin meta data loaded through it
+class ParameterMetaDataCacheTest : public UnitTest
+{
+    Q_OBJECT
+
+public:
+    ParameterMetaDataCacheTest(void);
+
+private slots:
+    void _roundTrip_test(void);
+    void _outOfDate_test(void);
+    void _px4MetaData_test(void);
+    void _apmMetaData_test(void);
+
+private:
+    /// Writes a meta data source file for the cache tests
+    QString _writeSourceFile(const QByteArray& contents);
+
+    /// Verifies that two facts ended up with the same meta data
+    void _compareMetaData(Fact& xmlFact, Fact& cacheFact);
+
+    QTemporaryDir _tempDir;
+};
+
+#endif
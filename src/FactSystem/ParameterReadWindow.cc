@@ -0,0 +1,166 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+
+#include "ParameterReadWindow.h"
+
+#include <QtGlobal>
+
+ParameterReadWindow::ParameterReadWindow(void)
+    : _window(initialWindow)
+    , _slowStartThreshold(maxWindow)
+    , _srttMsecs(-1)
+    , _rttVarMsecs(0)
+    , _rtoMsecs(initialRtoMsecs)
+    , _answeredCount(0)
+    , _timeoutCount(0)
+{
+
+}
+
+void ParameterReadWindow::clear(void)
+{
+    _queue.clear();
+    _queued.clear();
+    _retries.clear();
+    _outstanding.clear();
+}
+
+void ParameterReadWindow::queue(int componentId, int paramIndex)
+{
+    Request request(componentId, paramIndex);
+
+    if (!_queued.contains(request) && !_outstanding.contains(request)) {
+        _queue.append(request);
+        _queued.insert(request);
+    }
+}
+
+void ParameterReadWindow::requeue(const Request& request)
+{
+    _outstanding.remove(request);
+    if (!_queued.contains(request)) {
+        _queue.prepend(request);
+        _queued.insert(request);
+    }
+    _retries.insert(request);
+}
+
+bool ParameterReadWindow::received(int componentId, int paramIndex, qint64 nowMsecs)
+{
+    Request request(componentId, paramIndex);
+
+    if (_outstanding.contains(request)) {
+        Outstanding_t outstanding = _outstanding.take(request);
+
+        // Karn's algorithm: a response to a retried request could belong to any of the sends
+        if (!outstanding.retry) {
+            _rttSample(nowMsecs - outstanding.sentMsecs);
+        }
+
+        // Slow start until the window was cut once, additive increase after that
+        if (_window < _slowStartThreshold) {
+            _window += 1.0;
+        } else {
+            _window += 1.0 / _window;
+        }
+        _window = qMin(_window, (double)maxWindow);
+
+        _answeredCount++;
+        return true;
+    }
+
+    // Answered by the stream before we got to send it. The stale _queue entry is skipped when it comes up.
+    _retries.remove(request);
+    return _queued.remove(request);
+}
+
+QList<ParameterReadWindow::Request> ParameterReadWindow::takeRequestsToSend(qint64 nowMsecs)
+{
+    QList<Request> requests;
+
+    while (!_queue.isEmpty() && _outstanding.count() < window()) {
+        Request request = _queue.takeFirst();
+        if (!_queued.remove(request)) {
+            continue;
+        }
+
+        Outstanding_t outstanding;
+        outstanding.sentMsecs = nowMsecs;
+        outstanding.retry = _retries.remove(request);
+        _outstanding[request] = outstanding;
+        requests.append(request);
+    }
+
+    return requests;
+}
+
+QList<ParameterReadWindow::Request> ParameterReadWindow::takeTimedOut(qint64 nowMsecs)
+{
+    QList<Request> requests;
+
+    QHash<Request, Outstanding_t>::iterator it = _outstanding.begin();
+    while (it != _outstanding.end()) {
+        if (nowMsecs - it.value().sentMsecs >= _rtoMsecs) {
+            requests.append(it.key());
+            it = _outstanding.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    if (requests.count()) {
+        // One cut per timeout round, however many requests were lost in it
+        _timeoutCount += requests.count();
+        _slowStartThreshold = qMax(_window / 2.0, 1.0);
+        _window = _slowStartThreshold;
+        _rtoMsecs = qMin(_rtoMsecs * 2, (int)maxRtoMsecs);
+    }
+
+    return requests;
+}
+
+int ParameterReadWindow::msecsToNextTimeout(qint64 nowMsecs) const
+{
+    if (_outstanding.isEmpty()) {
+        return -1;
+    }
+
+    qint64 oldestSentMsecs = nowMsecs;
+    foreach (const Outstanding_t& outstanding, _outstanding) {
+        oldestSentMsecs = qMin(oldestSentMsecs, outstanding.sentMsecs);
+    }
+
+    return (int)qMax(oldestSentMsecs + _rtoMsecs - nowMsecs, (qint64)0);
+}
+
+void ParameterReadWindow::setLinkLossPercent(float lossPercent)
+{
+    if (lossPercent > 0.0f) {
+        // Treat reported loss as congestion, shrinking the window in proportion to it
+        double lossFraction = qMin((double)lossPercent, 100.0) / 100.0;
+        _window = qMax(_window * (1.0 - (lossFraction / 2.0)), 1.0);
+        _slowStartThreshold = qMin(_slowStartThreshold, qMax(_window, 2.0));
+    }
+}
+
+void ParameterReadWindow::_rttSample(int rttMsecs)
+{
+    rttMsecs = qMax(rttMsecs, 0);
+
+    if (_srttMsecs == -1) {
+        _srttMsecs = rttMsecs;
+        _rttVarMsecs = rttMsecs / 2;
+    } else {
+        _rttVarMsecs = ((3 * _rttVarMsecs) + qAbs(_srttMsecs - rttMsecs)) / 4;
+        _srttMsecs = ((7 * _srttMsecs) + rttMsecs) / 8;
+    }
+
+    _rtoMsecs = qBound((int)minRtoMsecs, _srttMsecs + (4 * _rttVarMsecs), (int)maxRtoMsecs);
+}
@@ -0,0 +1,100 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+
+#ifndef ParameterReadWindow_H
+#define ParameterReadWindow_H
+
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QSet>
+
+/// Sliding window of outstanding index based PARAM_REQUEST_READs, used by ParameterManager to fill the gaps the
+/// PARAM_REQUEST_LIST stream left.
+///
+/// Instead of re-requesting a fixed batch of indices per timeout, missing indices are queued here and requests are
+/// kept in flight up to the window size. Every answered request frees a slot for the next one. The window grows while
+/// requests are answered (slow start, then additive increase) and is halved when requests time out or the link reports
+/// receive loss. The request timeout is derived from the measured round trip time the same way TCP does it (RFC 6298),
+/// with round trips of retried requests not being measured.
+///
+/// The window does not send anything or keep time itself. The caller passes in the current time and sends the requests
+/// it is handed.
+class ParameterReadWindow
+{
+public:
+    ParameterReadWindow(void);
+
+    typedef QPair<int, int> Request;    ///< Component id, parameter index
+
+    /// Drops all queued and outstanding requests. Measured round trip and window size are kept.
+    void clear(void);
+
+    /// Queues a request, requests which are already queued or outstanding are ignored
+    void queue(int componentId, int paramIndex);
+
+    /// Queues a request which timed out to be sent again ahead of all others
+    void requeue(const Request& request);
+
+    /// Called for every parameter received, whether requested through the window or not
+    /// @return true: request was queued or outstanding
+    bool received(int componentId, int paramIndex, qint64 nowMsecs);
+
+    /// @return Requests to send now, these are outstanding from here on
+    QList<Request> takeRequestsToSend(qint64 nowMsecs);
+
+    /// @return Outstanding requests which timed out, these are no longer outstanding
+    QList<Request> takeTimedOut(qint64 nowMsecs);
+
+    /// @return Msecs until the next outstanding request times out, -1 if there are none
+    int msecsToNextTimeout(qint64 nowMsecs) const;
+
+    /// Receive loss reported by the link
+    void setLinkLossPercent(float lossPercent);
+
+    bool isIdle(void) const { return _queued.isEmpty() && _outstanding.isEmpty(); }
+
+    int queuedCount(void) const         { return _queued.count(); }
+    int outstandingCount(void) const    { return _outstanding.count(); }
+    int window(void) const              { return (int)_window; }
+    int rttMsecs(void) const            { return _srttMsecs; }      ///< Smoothed round trip, -1 if not measured yet
+    int rtoMsecs(void) const            { return _rtoMsecs; }       ///< Current request timeout
+    int answeredCount(void) const       { return _answeredCount; }  ///< Requests which got a response
+    int timeoutCount(void) const        { return _timeoutCount; }   ///< Requests which timed out
+
+    static const int initialWindow =        4;
+    static const int maxWindow =            32;
+    static const int initialRtoMsecs =      1000;
+    static const int minRtoMsecs =          100;
+    static const int maxRtoMsecs =          5000;
+
+private:
+    void _rttSample(int rttMsecs);
+
+    typedef struct {
+        qint64  sentMsecs;
+        bool    retry;
+    } Outstanding_t;
+
+    QList<Request>                  _queue;         ///< Send order, may hold requests which were answered from the stream
+    QSet<Request>                   _queued;        ///< Requests in _queue which still need to be sent
+    QSet<Request>                   _retries;       ///< Queued requests which were sent before
+    QHash<Request, Outstanding_t>   _outstanding;
+
+    double  _window;
+    double  _slowStartThreshold;
+    int     _srttMsecs;
+    int     _rttVarMsecs;
+    int     _rtoMsecs;
+    int     _answeredCount;
+    int     _timeoutCount;
+};
+
+#endif
@@ -0,0 +1,139 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "ParameterReadWindowTest.h"
+#include "ParameterReadWindow.h"
+
+ParameterReadWindowTest::ParameterReadWindowTest(void)
+{
+
+}
+
+/// Requests are kept in flight up to the window, which grows as they are answered
+void ParameterReadWindowTest::_window_test(void)
+{
+    ParameterReadWindow readWindow;
+
+    for (int i=0; i<100; i++) {
+        readWindow.queue(1, i);
+    }
+    readWindow.queue(1, 0);
+    QCOMPARE(readWindow.queuedCount(), 100);
+
+    qint64 nowMsecs = 0;
+    QList<ParameterReadWindow::Request> requests = readWindow.takeRequestsToSend(nowMsecs);
+    QCOMPARE(requests.count(), (int)ParameterReadWindow::initialWindow);
+    QCOMPARE(requests[0], ParameterReadWindow::Request(1, 0));
+    QCOMPARE(readWindow.outstandingCount(), requests.count());
+    QCOMPARE(readWindow.msecsToNextTimeout(nowMsecs), (int)ParameterReadWindow::initialRtoMsecs);
+
+    // Answer everything after 50 msecs until the queue is empty
+    int answered = 0;
+    while (!readWindow.isIdle()) {
+        nowMsecs += 50;
+        foreach (const ParameterReadWindow::Request& request, requests) {
+            QVERIFY(readWindow.received(request.first, request.second, nowMsecs));
+            answered++;
+        }
+        QVERIFY(readWindow.window() <= ParameterReadWindow::maxWindow);
+        requests = readWindow.takeRequestsToSend(nowMsecs);
+    }
+    QCOMPARE(answered, 100);
+    QCOMPARE(readWindow.answeredCount(), 100);
+    QCOMPARE(readWindow.timeoutCount(), 0);
+    QVERIFY(readWindow.window() > ParameterReadWindow::initialWindow);
+    QCOMPARE(readWindow.rttMsecs(), 50);
+    QCOMPARE(readWindow.rtoMsecs(), (int)ParameterReadWindow::minRtoMsecs);
+    QCOMPARE(readWindow.msecsToNextTimeout(nowMsecs), -1);
+}
+
+/// Timed out requests shrink the window, back off the timeout and are sent again first
+void ParameterReadWindowTest::_timeout_test(void)
+{
+    ParameterReadWindow readWindow;
+
+    for (int i=0; i<10; i++) {
+        readWindow.queue(1, i);
+    }
+    QList<ParameterReadWindow::Request> requests = readWindow.takeRequestsToSend(0);
+    QCOMPARE(requests.count(), 4);
+
+    QVERIFY(readWindow.received(1, 0, 100));
+    QVERIFY(readWindow.received(1, 1, 100));
+    QVERIFY(readWindow.takeTimedOut(200).isEmpty());
+    QCOMPARE(readWindow.msecsToNextTimeout(200), readWindow.rtoMsecs() - 200);
+
+    int rtoMsecs = readWindow.rtoMsecs();
+    int window = readWindow.window();
+    QList<ParameterReadWindow::Request> timedOut = readWindow.takeTimedOut(rtoMsecs);
+    QCOMPARE(timedOut.count(), 2);
+    QCOMPARE(readWindow.timeoutCount(), 2);
+    QCOMPARE(readWindow.outstandingCount(), 0);
+    QCOMPARE(readWindow.window(), window / 2);
+    QCOMPARE(readWindow.rtoMsecs(), rtoMsecs * 2);
+
+    foreach (const ParameterReadWindow::Request& request, timedOut) {
+        readWindow.requeue(request);
+    }
+    requests = readWindow.takeRequestsToSend(rtoMsecs);
+    QCOMPARE(requests.count(), readWindow.window());
+    QVERIFY(timedOut.contains(requests[0]));
+    QVERIFY(timedOut.contains(requests[1]));
+
+    // Round trips of retried requests are not measured
+    int rttMsecs = readWindow.rttMsecs();
+    QVERIFY(readWindow.received(requests[0].first, requests[0].second, rtoMsecs + 2000));
+    QCOMPARE(readWindow.rttMsecs(), rttMsecs);
+}
+
+/// Parameters the stream delivers are dropped from the window
+void ParameterReadWindowTest::_streamAnswered_test(void)
+{
+    ParameterReadWindow readWindow;
+
+    readWindow.queue(1, 0);
+    readWindow.queue(1, 1);
+    readWindow.queue(2, 0);
+    QVERIFY(readWindow.received(1, 1, 0));
+    QVERIFY(!readWindow.received(1, 1, 0));
+    QVERIFY(!readWindow.received(1, 2, 0));
+    QCOMPARE(readWindow.queuedCount(), 2);
+
+    QList<ParameterReadWindow::Request> requests = readWindow.takeRequestsToSend(0);
+    QCOMPARE(requests, QList<ParameterReadWindow::Request>() << ParameterReadWindow::Request(1, 0) << ParameterReadWindow::Request(2, 0));
+    QCOMPARE(readWindow.answeredCount(), 0);
+
+    readWindow.clear();
+    QVERIFY(readWindow.isIdle());
+    QVERIFY(!readWindow.received(1, 0, 0));
+}
+
+void ParameterReadWindowTest::_linkLoss_test(void)
+{
+    ParameterReadWindow readWindow;
+
+    for (int i=0; i<10; i++) {
+        readWindow.queue(1, i);
+    }
+    foreach (const ParameterReadWindow::Request& request, readWindow.takeRequestsToSend(0)) {
+        readWindow.received(request.first, request.second, 10);
+    }
+    QCOMPARE(readWindow.window(), 8);
+
+    readWindow.setLinkLossPercent(0);
+    QCOMPARE(readWindow.window(), 8);
+    readWindow.setLinkLossPercent(50);
+    QCOMPARE(readWindow.window(), 6);
+    readWindow.setLinkLossPercent(100);
+    QCOMPARE(readWindow.window(), 3);
+    for (int i=0; i<10; i++) {
+        readWindow.setLinkLossPercent(100);
+    }
+    QCOMPARE(readWindow.window(), 1);
+}
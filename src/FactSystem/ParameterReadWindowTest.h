@@ -0,0 +1,30 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#ifndef ParameterReadWindowTest_H
+#define ParameterReadWindowTest_H
+
+#include "UnitTest.h"
+
+/// Unit test for the parameter re-request window, driven with simulated time
+class ParameterReadWindowTest : public UnitTest
+{
+    Q_OBJECT
+
+public:
+    ParameterReadWindowTest(void);
+
+private slots:
+    void _window_test(void);
+    void _timeout_test(void);
+    void _streamAnswered_test(void);
+    void _linkLoss_test(void);
+};
+
+#endif
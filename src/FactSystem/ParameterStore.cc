@@ -0,0 +1,238 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+
+#include "ParameterStore.h"
+#include "Fact.h"
+
+#include <algorithm>
+
+ParameterStore::ParameterStore(void)
+    : _paramCount(0)
+    , _factCount(0)
+    , _sortedFactSlotsValid(true)
+    , _waitingReadIndexCount(0)
+{
+    for (int i=0; i<WaitListCount; i++) {
+        _waitingCount[i] = 0;
+    }
+}
+
+void ParameterStore::setParamCount(int paramCount)
+{
+    _paramCount = qMax(paramCount, 0);
+
+    _paramIndexToSlot.fill(-1, _paramCount);
+    _waitingReadIndex = QBitArray(_paramCount);
+    _failedReadIndex = QBitArray(_paramCount);
+    _readIndexRetries.fill(0, _paramCount);
+    _waitingReadIndexCount = 0;
+
+    // Most parameters will show up by index, so make room for them all up front
+    _names.reserve(_paramCount);
+    _facts.reserve(_paramCount);
+    _nameToSlot.reserve(_paramCount);
+    for (int i=0; i<WaitListCount; i++) {
+        _retries[i].reserve(_paramCount);
+    }
+}
+
+int ParameterStore::addSlot(const QString& name)
+{
+    int slot = _nameToSlot.value(name, -1);
+
+    if (slot == -1) {
+        slot = _names.count();
+        _names.append(name);
+        _facts.append(NULL);
+        _nameToSlot[name] = slot;
+        for (int i=0; i<WaitListCount; i++) {
+            _waiting[i].resize(slot + 1);
+            _retries[i].append(0);
+        }
+    }
+
+    return slot;
+}
+
+Fact* ParameterStore::fact(const QString& name) const
+{
+    int nameSlot = slot(name);
+    return nameSlot == -1 ? NULL : _facts[nameSlot];
+}
+
+void ParameterStore::setFact(int slot, Fact* fact)
+{
+    if (!_facts[slot]) {
+        _factCount++;
+        _sortedFactSlotsValid = false;
+    }
+    _facts[slot] = fact;
+}
+
+void ParameterStore::setParamIndexSlot(int paramIndex, int slot)
+{
+    if (paramIndex >= 0 && paramIndex < _paramCount) {
+        _paramIndexToSlot[paramIndex] = slot;
+    }
+}
+
+int ParameterStore::paramIndexSlot(int paramIndex) const
+{
+    if (paramIndex >= 0 && paramIndex < _paramCount) {
+        return _paramIndexToSlot[paramIndex];
+    }
+    return -1;
+}
+
+const QVector<int>& ParameterStore::sortedFactSlots(void) const
+{
+    if (!_sortedFactSlotsValid) {
+        _sortedFactSlots.clear();
+        _sortedFactSlots.reserve(_factCount);
+        for (int i=0; i<_facts.count(); i++) {
+            if (_facts[i]) {
+                _sortedFactSlots.append(i);
+            }
+        }
+
+        const QVector<QString>& names = _names;
+        std::sort(_sortedFactSlots.begin(), _sortedFactSlots.end(), [&names](int slot1, int slot2) {
+            return names[slot1] < names[slot2];
+        });
+        _sortedFactSlotsValid = true;
+    }
+
+    return _sortedFactSlots;
+}
+
+QStringList ParameterStore::factNames(void) const
+{
+    QStringList names;
+
+    const QVector<int>& factSlots = sortedFactSlots();
+    names.reserve(factSlots.count());
+    foreach (int slot, factSlots) {
+        names.append(_names[slot]);
+    }
+
+    return names;
+}
+
+void ParameterStore::setAllReadIndicesWaiting(void)
+{
+    _waitingReadIndex.fill(true);
+    _readIndexRetries.fill(0);
+    _waitingReadIndexCount = _paramCount;
+}
+
+bool ParameterStore::readIndexWaiting(int paramIndex) const
+{
+    return paramIndex >= 0 && paramIndex < _paramCount && _waitingReadIndex.testBit(paramIndex);
+}
+
+void ParameterStore::clearReadIndexWaiting(int paramIndex)
+{
+    if (readIndexWaiting(paramIndex)) {
+        _waitingReadIndex.clearBit(paramIndex);
+        _waitingReadIndexCount--;
+    }
+}
+
+int ParameterStore::bumpReadIndexRetry(int paramIndex)
+{
+    return ++_readIndexRetries[paramIndex];
+}
+
+int ParameterStore::nextWaitingReadIndex(int from) const
+{
+    return _waitingReadIndexCount ? _nextSetBit(_waitingReadIndex, from) : -1;
+}
+
+void ParameterStore::setReadIndexFailed(int paramIndex)
+{
+    clearReadIndexWaiting(paramIndex);
+    _failedReadIndex.setBit(paramIndex);
+}
+
+QList<int> ParameterStore::waitingReadIndices(void) const
+{
+    QList<int> indices;
+
+    for (int paramIndex = nextWaitingReadIndex(0); paramIndex != -1; paramIndex = nextWaitingReadIndex(paramIndex + 1)) {
+        indices.append(paramIndex);
+    }
+
+    return indices;
+}
+
+QList<int> ParameterStore::failedReadIndices(void) const
+{
+    QList<int> indices;
+
+    for (int paramIndex = _nextSetBit(_failedReadIndex, 0); paramIndex != -1; paramIndex = _nextSetBit(_failedReadIndex, paramIndex + 1)) {
+        indices.append(paramIndex);
+    }
+
+    return indices;
+}
+
+void ParameterStore::setWaiting(WaitList_t waitList, int slot)
+{
+    if (!_waiting[waitList].testBit(slot)) {
+        _waiting[waitList].setBit(slot);
+        _waitingCount[waitList]++;
+    }
+    _retries[waitList][slot] = 0;
+}
+
+bool ParameterStore::waiting(WaitList_t waitList, int slot) const
+{
+    return _waiting[waitList].testBit(slot);
+}
+
+void ParameterStore::clearWaiting(WaitList_t waitList, int slot)
+{
+    if (_waiting[waitList].testBit(slot)) {
+        _waiting[waitList].clearBit(slot);
+        _waitingCount[waitList]--;
+    }
+}
+
+int ParameterStore::bumpRetry(WaitList_t waitList, int slot)
+{
+    return ++_retries[waitList][slot];
+}
+
+int ParameterStore::nextWaiting(WaitList_t waitList, int from) const
+{
+    return _waitingCount[waitList] ? _nextSetBit(_waiting[waitList], from) : -1;
+}
+
+QStringList ParameterStore::waitingNames(WaitList_t waitList) const
+{
+    QStringList names;
+
+    for (int slot = nextWaiting(waitList, 0); slot != -1; slot = nextWaiting(waitList, slot + 1)) {
+        names.append(_names[slot]);
+    }
+
+    return names;
+}
+
+int ParameterStore::_nextSetBit(const QBitArray& bits, int from)
+{
+    for (int i=from; i<bits.size(); i++) {
+        if (bits.testBit(i)) {
+            return i;
+        }
+    }
+
+    return -1;
+}
@@ -0,0 +1,140 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+
+#ifndef ParameterStore_H
+#define ParameterStore_H
+
+#include <QBitArray>
+#include <QHash>
+#include <QVector>
+#include <QStringList>
+
+class Fact;
+
+/// Parameters of a single vehicle component, as used by ParameterManager.
+///
+/// Every parameter name the component is known to have gets a slot. The Fact, the name and the name based wait state
+/// for a parameter live in flat arrays indexed by its slot. Names are found through a hash, parameter indices through
+/// a vector sized to the parameter count the component reports. Waiting and failed state are bitsets which keep a
+/// running count, so checking on load progress never has to walk a list.
+///
+/// A slot may be reserved for a name before the vehicle has sent the parameter (refreshing a parameter which is not
+/// known yet). Such slots have no Fact and are not reported as parameters.
+class ParameterStore
+{
+public:
+    ParameterStore(void);
+
+    /// Wait lists for name based requests
+    typedef enum {
+        WaitRead,
+        WaitWrite,
+        WaitListCount
+    } WaitList_t;
+
+    /// Sets the parameter count reported by the component. Sizes the parameter index arrays.
+    void setParamCount(int paramCount);
+
+    int paramCount(void) const { return _paramCount; }
+
+    /// @return Number of parameters which have a Fact
+    int factCount(void) const { return _factCount; }
+
+    /// @return Slot for the parameter name, -1 if not known
+    int slot(const QString& name) const { return _nameToSlot.value(name, -1); }
+
+    /// @return Slot for the parameter name, a new one is added if it is not known yet
+    int addSlot(const QString& name);
+
+    const QString& name(int slot) const { return _names[slot]; }
+
+    /// @return Fact in slot, NULL if the parameter has not been received yet
+    Fact* fact(int slot) const { return _facts[slot]; }
+
+    /// @return Fact for parameter name, NULL if none
+    Fact* fact(const QString& name) const;
+
+    void setFact(int slot, Fact* fact);
+
+    /// Associates a parameter index with a slot. Indices outside of the parameter count are ignored.
+    void setParamIndexSlot(int paramIndex, int slot);
+
+    /// @return Slot for the parameter index, -1 if not known
+    int paramIndexSlot(int paramIndex) const;
+
+    /// @return Slots which have a Fact, in parameter name order
+    const QVector<int>& sortedFactSlots(void) const;
+
+    /// @return Names of all parameters which have a Fact, sorted
+    QStringList factNames(void) const;
+
+    /// Places all parameter indices on the read wait list, with their retry count reset
+    void setAllReadIndicesWaiting(void);
+
+    bool readIndexWaiting(int paramIndex) const;
+    int waitingReadIndexCount(void) const { return _waitingReadIndexCount; }
+
+    /// Removes the parameter index from the read wait list
+    void clearReadIndexWaiting(int paramIndex);
+
+    /// @return New retry count for parameter index
+    int bumpReadIndexRetry(int paramIndex);
+
+    /// @return First parameter index at or after from which is on the read wait list, -1 if none
+    int nextWaitingReadIndex(int from) const;
+
+    /// Removes the parameter index from the read wait list and marks it as failed
+    void setReadIndexFailed(int paramIndex);
+
+    QList<int> waitingReadIndices(void) const;
+    QList<int> failedReadIndices(void) const;
+
+    /// Places the slot on the wait list, with its retry count reset
+    void setWaiting(WaitList_t waitList, int slot);
+
+    bool waiting(WaitList_t waitList, int slot) const;
+    int waitingCount(WaitList_t waitList) const { return _waitingCount[waitList]; }
+
+    /// Removes the slot from the wait list
+    void clearWaiting(WaitList_t waitList, int slot);
+
+    /// @return New retry count for slot
+    int bumpRetry(WaitList_t waitList, int slot);
+
+    /// @return First slot at or after from which is on the wait list, -1 if none
+    int nextWaiting(WaitList_t waitList, int from) const;
+
+    QStringList waitingNames(WaitList_t waitList) const;
+
+private:
+    static int _nextSetBit(const QBitArray& bits, int from);
+
+    int                 _paramCount;
+    int                 _factCount;
+
+    QVector<QString>    _names;             ///< Indexed by slot
+    QVector<Fact*>      _facts;             ///< Indexed by slot
+    QHash<QString, int> _nameToSlot;
+    QVector<int>        _paramIndexToSlot;  ///< Indexed by parameter index, -1 for not received
+
+    mutable QVector<int>    _sortedFactSlots;
+    mutable bool            _sortedFactSlotsValid;
+
+    QBitArray           _waitingReadIndex;      ///< Indexed by parameter index
+    QBitArray           _failedReadIndex;       ///< Indexed by parameter index
+    QVector<quint8>     _readIndexRetries;      ///< Indexed by parameter index
+    int                 _waitingReadIndexCount;
+
+    QBitArray           _waiting[WaitListCount];        ///< Indexed by slot
+    QVector<quint8>     _retries[WaitListCount];        ///< Indexed by slot
+    int                 _waitingCount[WaitListCount];
+};
+
+#endif
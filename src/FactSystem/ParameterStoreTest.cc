@@ -0,0 +1,125 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "ParameterStoreTest.h"
+#include "ParameterStore.h"
+#include "Fact.h"
+
+ParameterStoreTest::ParameterStoreTest(void)
+{
+
+}
+
+void ParameterStoreTest::_slots_test(void)
+{
+    ParameterStore store;
+    store.setParamCount(3);
+    QCOMPARE(store.paramCount(), 3);
+
+    Fact fact1(1, "B_PARAM", FactMetaData::valueTypeInt32);
+    Fact fact2(1, "A_PARAM", FactMetaData::valueTypeFloat);
+
+    int slot1 = store.addSlot("B_PARAM");
+    int slot2 = store.addSlot("A_PARAM");
+    QCOMPARE(store.addSlot("B_PARAM"), slot1);
+    QCOMPARE(store.slot("A_PARAM"), slot2);
+    QCOMPARE(store.slot("C_PARAM"), -1);
+
+    // Slots without a Fact are not parameters
+    QCOMPARE(store.factCount(), 0);
+    QVERIFY(store.fact("B_PARAM") == NULL);
+    QVERIFY(store.factNames().isEmpty());
+
+    store.setFact(slot1, &fact1);
+    store.setFact(slot2, &fact2);
+    QCOMPARE(store.factCount(), 2);
+    QVERIFY(store.fact("B_PARAM") == &fact1);
+    QVERIFY(store.fact(slot2) == &fact2);
+    QCOMPARE(store.name(slot2), QString("A_PARAM"));
+    QCOMPARE(store.factNames(), QStringList() << "A_PARAM" << "B_PARAM");
+    QCOMPARE(store.sortedFactSlots(), QVector<int>() << slot2 << slot1);
+
+    // Parameter indices outside of the parameter count are not tracked
+    store.setParamIndexSlot(2, slot1);
+    store.setParamIndexSlot(3, slot2);
+    store.setParamIndexSlot(-1, slot2);
+    QCOMPARE(store.paramIndexSlot(0), -1);
+    QCOMPARE(store.paramIndexSlot(2), slot1);
+    QCOMPARE(store.paramIndexSlot(3), -1);
+    QCOMPARE(store.paramIndexSlot(-1), -1);
+}
+
+void ParameterStoreTest::_readIndexWait_test(void)
+{
+    ParameterStore store;
+    store.setParamCount(100);
+    QCOMPARE(store.waitingReadIndexCount(), 0);
+    QCOMPARE(store.nextWaitingReadIndex(0), -1);
+
+    store.setAllReadIndicesWaiting();
+    QCOMPARE(store.waitingReadIndexCount(), 100);
+
+    for (int i=0; i<100; i++) {
+        if (i != 10 && i != 50) {
+            store.clearReadIndexWaiting(i);
+        }
+    }
+    store.clearReadIndexWaiting(0);
+    store.clearReadIndexWaiting(100);
+    QCOMPARE(store.waitingReadIndexCount(), 2);
+    QVERIFY(store.readIndexWaiting(10));
+    QVERIFY(!store.readIndexWaiting(11));
+    QCOMPARE(store.waitingReadIndices(), QList<int>() << 10 << 50);
+    QCOMPARE(store.nextWaitingReadIndex(11), 50);
+    QCOMPARE(store.nextWaitingReadIndex(51), -1);
+
+    QCOMPARE(store.bumpReadIndexRetry(10), 1);
+    QCOMPARE(store.bumpReadIndexRetry(10), 2);
+    store.setReadIndexFailed(10);
+    QCOMPARE(store.waitingReadIndexCount(), 1);
+    QCOMPARE(store.failedReadIndices(), QList<int>() << 10);
+
+    // Waiting on everything again resets the retry counts
+    store.setAllReadIndicesWaiting();
+    QCOMPARE(store.waitingReadIndexCount(), 100);
+    QCOMPARE(store.bumpReadIndexRetry(10), 1);
+}
+
+void ParameterStoreTest::_nameWait_test(void)
+{
+    ParameterStore store;
+    store.setParamCount(2);
+
+    int slot1 = store.addSlot("PARAM1");
+    int slot2 = store.addSlot("PARAM2");
+
+    store.setWaiting(ParameterStore::WaitWrite, slot2);
+    store.setWaiting(ParameterStore::WaitWrite, slot2);
+    QCOMPARE(store.waitingCount(ParameterStore::WaitWrite), 1);
+    QCOMPARE(store.waitingCount(ParameterStore::WaitRead), 0);
+    QVERIFY(store.waiting(ParameterStore::WaitWrite, slot2));
+    QVERIFY(!store.waiting(ParameterStore::WaitRead, slot2));
+    QCOMPARE(store.nextWaiting(ParameterStore::WaitWrite, 0), slot2);
+    QCOMPARE(store.nextWaiting(ParameterStore::WaitRead, 0), -1);
+
+    // Slots added while waiting are not waiting
+    int slot3 = store.addSlot("PARAM3");
+    QVERIFY(!store.waiting(ParameterStore::WaitWrite, slot3));
+    QCOMPARE(store.waitingNames(ParameterStore::WaitWrite), QStringList() << "PARAM2");
+
+    QCOMPARE(store.bumpRetry(ParameterStore::WaitWrite, slot2), 1);
+    QCOMPARE(store.bumpRetry(ParameterStore::WaitWrite, slot2), 2);
+    store.setWaiting(ParameterStore::WaitWrite, slot2);
+    QCOMPARE(store.bumpRetry(ParameterStore::WaitWrite, slot2), 1);
+
+    store.clearWaiting(ParameterStore::WaitWrite, slot2);
+    store.clearWaiting(ParameterStore::WaitWrite, slot1);
+    QCOMPARE(store.waitingCount(ParameterStore::WaitWrite), 0);
+    QCOMPARE(store.nextWaiting(ParameterStore::WaitWrite, 0), -1);
+}
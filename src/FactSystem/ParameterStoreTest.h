@@ -0,0 +1,29 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#ifndef ParameterStoreTest_H
+#define ParameterStoreTest_H
+
+#include "UnitTest.h"
+
+/// Unit test for the per component parameter store used by ParameterManager
+class ParameterStoreTest : public UnitTest
+{
+    Q_OBJECT
+
+public:
+    ParameterStoreTest(void);
+
+private slots:
+    void _slots_test(void);
+    void _readIndexWait_test(void);
+    void _nameWait_test(void);
+};
+
+#endif
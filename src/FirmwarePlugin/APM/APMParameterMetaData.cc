@@ -17,6 +17,7 @@
 #include <QDir>
 #include <QDebug>
 #include <QStack>
+#include <QDataStream>
 
 QGC_LOGGING_CATEGORY(APMParameterMetaDataLog,           "APMParameterMetaDataLog")
 QGC_LOGGING_CATEGORY(APMParameterMetaDataVerboseLog,    "APMParameterMetaDataVerboseLog")
@@ -123,6 +124,10 @@ void APMParameterMetaData::loadParameterFactMetaDataFile(const QString& metaData
 
     qCDebug(APMParameterMetaDataLog) << "Loading parameter meta data:" << metaDataFile;
 
+    if (_cache.open(metaDataFile)) {
+        return;
+    }
+
     QFile xmlFile(metaDataFile);
     Q_ASSERT(xmlFile.exists());
 
@@ -281,6 +286,53 @@ void APMParameterMetaData::loadParameterFactMetaDataFile(const QString& metaData
         }
         xml.readNext();
     }
+
+    _writeCache(metaDataFile);
+}
+
+/// Compiles the meta data parsed from xml into the cache, so the next load can skip the xml
+void APMParameterMetaData::_writeCache(const QString& metaDataFile)
+{
+    ParameterMetaDataCache::RecordMap records;
+    foreach (const QString& category, _vehicleTypeToParametersMap.keys()) {
+        const ParameterNametoFactMetaDataMap& parameterMap = _vehicleTypeToParametersMap[category];
+        foreach (const QString& name, parameterMap.keys()) {
+            records[ParameterMetaDataCache::recordKey(category, name)] = _encodeRawMetaData(parameterMap[name]);
+        }
+    }
+    ParameterMetaDataCache::write(metaDataFile, records);
+}
+
+QByteArray APMParameterMetaData::_encodeRawMetaData(const APMFactMetaDataRaw* rawMetaData)
+{
+    QByteArray record;
+    QDataStream stream(&record, QIODevice::WriteOnly);
+    stream << rawMetaData->name << rawMetaData->group << rawMetaData->shortDescription << rawMetaData->longDescription
+           << rawMetaData->min << rawMetaData->max << rawMetaData->incrementSize << rawMetaData->units
+           << rawMetaData->rebootRequired << rawMetaData->values << rawMetaData->bitmask;
+    return record;
+}
+
+bool APMParameterMetaData::_decodeRawMetaData(const QByteArray& record, APMFactMetaDataRaw& rawMetaData)
+{
+    QDataStream stream(record);
+    stream >> rawMetaData.name >> rawMetaData.group >> rawMetaData.shortDescription >> rawMetaData.longDescription
+           >> rawMetaData.min >> rawMetaData.max >> rawMetaData.incrementSize >> rawMetaData.units
+           >> rawMetaData.rebootRequired >> rawMetaData.values >> rawMetaData.bitmask;
+    return stream.status() == QDataStream::Ok;
+}
+
+bool APMParameterMetaData::_cachedRawMetaData(const QString& category, const QString& name, APMFactMetaDataRaw& rawMetaData)
+{
+    QByteArray record;
+    if (!_cache.find(category, name, record)) {
+        return false;
+    }
+    if (!_decodeRawMetaData(record, rawMetaData)) {
+        qWarning() << "Parameter meta data cache corruption, parameter:" << name;
+        return false;
+    }
+    return true;
 }
 
 void APMParameterMetaData::correctGroupMemberships(ParameterNametoFactMetaDataMap& parameterToFactMetaDataMap,
@@ -404,9 +456,14 @@ void APMParameterMetaData::addMetaDataToFact(Fact* fact, MAV_TYPE vehicleType)
 {
     const QString mavTypeString = mavTypeToString(vehicleType);
     APMFactMetaDataRaw* rawMetaData = NULL;
+    APMFactMetaDataRaw cachedRawMetaData;
 
     // check if we have metadata for fact, use generic otherwise
-    if (_vehicleTypeToParametersMap[mavTypeString].contains(fact->name())) {
+    if (_cache.isOpen()) {
+        if (_cachedRawMetaData(mavTypeString, fact->name(), cachedRawMetaData) || _cachedRawMetaData("libraries", fact->name(), cachedRawMetaData)) {
+            rawMetaData = &cachedRawMetaData;
+        }
+    } else if (_vehicleTypeToParametersMap[mavTypeString].contains(fact->name())) {
         rawMetaData = _vehicleTypeToParametersMap[mavTypeString][fact->name()];
     } else if (_vehicleTypeToParametersMap["libraries"].contains(fact->name())) {
         rawMetaData = _vehicleTypeToParametersMap["libraries"][fact->name()];
@@ -20,6 +20,7 @@
 #include "FactSystem.h"
 #include "AutoPilotPlugin.h"
 #include "Vehicle.h"
+#include "ParameterMetaDataCache.h"
 
 Q_DECLARE_LOGGING_CATEGORY(APMParameterMetaDataLog)
 Q_DECLARE_LOGGING_CATEGORY(APMParameterMetaDataVerboseLog)
@@ -79,9 +80,15 @@ private:
     bool parseParameterAttributes(QXmlStreamReader& xml, APMFactMetaDataRaw *rawMetaData);
     void correctGroupMemberships(ParameterNametoFactMetaDataMap& parameterToFactMetaDataMap, QMap<QString,QStringList>& groupMembers);
     QString mavTypeToString(MAV_TYPE vehicleTypeEnum);
+    bool _cachedRawMetaData(const QString& category, const QString& name, APMFactMetaDataRaw& rawMetaData);
+    void _writeCache(const QString& metaDataFile);
+
+    static QByteArray _encodeRawMetaData(const APMFactMetaDataRaw* rawMetaData);
+    static bool _decodeRawMetaData(const QByteArray& record, APMFactMetaDataRaw& rawMetaData);
 
     bool _parameterMetaDataLoaded;   ///< true: parameter meta data already loaded
-    QMap<QString, ParameterNametoFactMetaDataMap> _vehicleTypeToParametersMap; ///< Maps from a vehicle type to paramametertoFactMeta map>
+    QMap<QString, ParameterNametoFactMetaDataMap> _vehicleTypeToParametersMap; ///< Maps from a vehicle type to paramametertoFactMeta map>, empty when loaded from cache
+    ParameterMetaDataCache _cache;
 };
 
 #endif
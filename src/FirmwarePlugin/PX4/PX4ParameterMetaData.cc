@@ -19,6 +19,7 @@
 #include <QFileInfo>
 #include <QDir>
 #include <QDebug>
+#include <QDataStream>
 
 QGC_LOGGING_CATEGORY(PX4ParameterMetaDataLog, "PX4ParameterMetaDataLog")
 
@@ -74,6 +75,10 @@ void PX4ParameterMetaData::loadParameterFactMetaDataFile(const QString& metaData
 	
     qCDebug(PX4ParameterMetaDataLog) << "Loading parameter meta data:" << metaDataFile;
 
+    if (_cache.open(metaDataFile)) {
+        return;
+    }
+
     QFile xmlFile(metaDataFile);
 
     if (!xmlFile.exists()) {
@@ -93,11 +98,10 @@ void PX4ParameterMetaData::loadParameterFactMetaDataFile(const QString& metaData
         return;
     }
     
-    QString         factGroup;
-    QString         errorString;
-    FactMetaData*   metaData = NULL;
-    int             xmlState = XmlStateNone;
-    bool            badMetaData = true;
+    QString             factGroup;
+    PX4FactMetaDataRaw* rawMetaData = NULL;
+    int                 xmlState = XmlStateNone;
+    bool                badMetaData = true;
     
     while (!xml.atEnd()) {
         if (xml.isStartElement()) {
@@ -176,29 +180,25 @@ void PX4ParameterMetaData::loadParameterFactMetaDataFile(const QString& metaData
                     return;
                 }
                 
-                // Now that we know type we can create meta data object and add it to the system
+                // Now that we know type we can add the meta data to the system. The FactMetaData object itself is
+                // created when a Fact first needs it.
                 
-                metaData = new FactMetaData(foundType);
-                Q_CHECK_PTR(metaData);
-                if (_mapParameterName2FactMetaData.contains(name)) {
+                if (_mapParameterName2RawMetaData.contains(name)) {
                     // We can't trust the meta dafa since we have dups
                     qCWarning(PX4ParameterMetaDataLog) << "Duplicate parameter found:" << name;
                     badMetaData = true;
                     // Reset to default meta data
-                    _mapParameterName2FactMetaData[name] = metaData;
+                    rawMetaData = &_mapParameterName2RawMetaData[name];
+                    *rawMetaData = PX4FactMetaDataRaw();
+                    rawMetaData->type = foundType;
+                    rawMetaData->duplicate = true;
                 } else {
-                    _mapParameterName2FactMetaData[name] = metaData;
-                    metaData->setName(name);
-                    metaData->setGroup(factGroup);
-                    
-                    if (xml.attributes().hasAttribute("default") && !strDefault.isEmpty()) {
-                        QVariant varDefault;
-                        
-                        if (metaData->convertAndValidateRaw(strDefault, false, varDefault, errorString)) {
-                            metaData->setRawDefaultValue(varDefault);
-                        } else {
-                            qCWarning(PX4ParameterMetaDataLog) << "Invalid default value, name:" << name << " type:" << type << " default:" << strDefault << " error:" << errorString;
-                        }
+                    rawMetaData = &_mapParameterName2RawMetaData[name];
+                    rawMetaData->name = name;
+                    rawMetaData->group = factGroup;
+                    rawMetaData->type = foundType;
+                    if (xml.attributes().hasAttribute("default")) {
+                        rawMetaData->defaultValue = strDefault;
                     }
                 }
                 
@@ -210,70 +210,12 @@ void PX4ParameterMetaData::loadParameterFactMetaDataFile(const QString& metaData
                 }
 
                 if (!badMetaData) {
-                    if (elementName == "short_desc") {
-                        Q_ASSERT(metaData);
+                    if (elementName == "short_desc" || elementName == "long_desc" || elementName == "min" || elementName == "max" ||
+                            elementName == "unit" || elementName == "decimal" || elementName == "reboot_required" || elementName == "increment") {
+                        Q_ASSERT(rawMetaData);
                         QString text = xml.readElementText();
-                        text = text.replace("\n", " ");
-                        qCDebug(PX4ParameterMetaDataLog) << "Short description:" << text;
-                        metaData->setShortDescription(text);
-
-                    } else if (elementName == "long_desc") {
-                        Q_ASSERT(metaData);
-                        QString text = xml.readElementText();
-                        text = text.replace("\n", " ");
-                        qCDebug(PX4ParameterMetaDataLog) << "Long description:" << text;
-                        metaData->setLongDescription(text);
-                        
-                    } else if (elementName == "min") {
-                        Q_ASSERT(metaData);
-                        QString text = xml.readElementText();
-                        qCDebug(PX4ParameterMetaDataLog) << "Min:" << text;
-                        
-                        QVariant varMin;
-                        if (metaData->convertAndValidateRaw(text, true /* convertOnly */, varMin, errorString)) {
-                            metaData->setRawMin(varMin);
-                        } else {
-                            qCWarning(PX4ParameterMetaDataLog) << "Invalid min value, name:" << metaData->name() << " type:" << metaData->type() << " min:" << text << " error:" << errorString;
-                        }
-                        
-                    } else if (elementName == "max") {
-                        Q_ASSERT(metaData);
-                        QString text = xml.readElementText();
-                        qCDebug(PX4ParameterMetaDataLog) << "Max:" << text;
-                        
-                        QVariant varMax;
-                        if (metaData->convertAndValidateRaw(text, true /* convertOnly */, varMax, errorString)) {
-                            metaData->setRawMax(varMax);
-                        } else {
-                            qCWarning(PX4ParameterMetaDataLog) << "Invalid max value, name:" << metaData->name() << " type:" << metaData->type() << " max:" << text << " error:" << errorString;
-                        }
-                        
-                    } else if (elementName == "unit") {
-                        Q_ASSERT(metaData);
-                        QString text = xml.readElementText();
-                        qCDebug(PX4ParameterMetaDataLog) << "Unit:" << text;
-                        metaData->setRawUnits(text);
-                        
-                    } else if (elementName == "decimal") {
-                        Q_ASSERT(metaData);
-                        QString text = xml.readElementText();
-                        qCDebug(PX4ParameterMetaDataLog) << "Decimal:" << text;
-
-                        bool convertOk;
-                        QVariant varDecimals = QVariant(text).toUInt(&convertOk);
-                        if (convertOk) {
-                            metaData->setDecimalPlaces(varDecimals.toInt());
-                        } else {
-                            qCWarning(PX4ParameterMetaDataLog) << "Invalid decimals value, name:" << metaData->name() << " type:" << metaData->type() << " decimals:" << text << " error: invalid number";
-                        }
-
-                    } else if (elementName == "reboot_required") {
-                        Q_ASSERT(metaData);
-                        QString text = xml.readElementText();
-                        qCDebug(PX4ParameterMetaDataLog) << "RebootRequired:" << text;
-                        if (text.compare("true", Qt::CaseInsensitive) == 0) {
-                            metaData->setRebootRequired(true);
-                        }
+                        qCDebug(PX4ParameterMetaDataLog) << elementName << text;
+                        rawMetaData->elements << (QStringList() << elementName << text);
 
                     } else if (elementName == "values") {
                         // doing nothing individual value will follow anyway. May be used for sanity checking.
@@ -283,60 +225,23 @@ void PX4ParameterMetaData::loadParameterFactMetaDataFile(const QString& metaData
                         QString enumString = xml.readElementText();
                         qCDebug(PX4ParameterMetaDataLog) << "parameter value:"
                                                          << "value desc:" << enumString << "code:" << enumValueStr;
-
-                        QVariant    enumValue;
-                        QString     errorString;
-                        if (metaData->convertAndValidateRaw(enumValueStr, false /* validate */, enumValue, errorString)) {
-                            metaData->addEnumInfo(enumString, enumValue);
-                        } else {
-                            qCDebug(PX4ParameterMetaDataLog) << "Invalid enum value, name:" << metaData->name()
-                                                             << " type:" << metaData->type() << " value:" << enumValueStr
-                                                             << " error:" << errorString;
-                        }
-                    } else if (elementName == "increment") {
-                        Q_ASSERT(metaData);
-                        double  increment;
-                        bool    ok;
-                        QString text = xml.readElementText();
-                        increment = text.toDouble(&ok);
-                        if (ok) {
-                            metaData->setIncrement(increment);
-                        } else {
-                            qCWarning(PX4ParameterMetaDataLog) << "Invalid value for increment, name:" << metaData->name() << " increment:" << text;
-                        }
+                        rawMetaData->elements << (QStringList() << elementName << enumString << enumValueStr);
 
                     } else if (elementName == "boolean") {
-                        QVariant    enumValue;
-                        metaData->convertAndValidateRaw(1, false /* validate */, enumValue, errorString);
-                        metaData->addEnumInfo(tr("Enabled"), enumValue);
-                        metaData->convertAndValidateRaw(0, false /* validate */, enumValue, errorString);
-                        metaData->addEnumInfo(tr("Disabled"), enumValue);
+                        rawMetaData->elements << (QStringList() << elementName << QString());
 
                     } else if (elementName == "bitmask") {
                         // doing nothing individual bits will follow anyway. May be used for sanity checking.
 
                     } else if (elementName == "bit") {
+                        QString bitIndex = xml.attributes().value("index").toString();
                         bool ok = false;
-                        unsigned char bit = xml.attributes().value("index").toString().toUInt(&ok);
+                        bitIndex.toUInt(&ok);
                         if (ok) {
                             QString bitDescription = xml.readElementText();
                             qCDebug(PX4ParameterMetaDataLog) << "parameter value:"
-                                                             << "index:" << bit << "description:" << bitDescription;
-
-                            if (bit < 31) {
-                                QVariant bitmaskRawValue = 1 << bit;
-                                QVariant bitmaskValue;
-                                QString errorString;
-                                if (metaData->convertAndValidateRaw(bitmaskRawValue, true, bitmaskValue, errorString)) {
-                                    metaData->addBitmaskInfo(bitDescription, bitmaskValue);
-                                } else {
-                                    qCDebug(PX4ParameterMetaDataLog) << "Invalid bitmask value, name:" << metaData->name()
-                                                                     << " type:" << metaData->type() << " value:" << bitmaskValue
-                                                                     << " error:" << errorString;
-                                }
-                            } else {
-                                qCWarning(PX4ParameterMetaDataLog) << "Invalid value for bitmask, bit:" << bit;
-                            }
+                                                             << "index:" << bitIndex << "description:" << bitDescription;
+                            rawMetaData->elements << (QStringList() << elementName << bitDescription << bitIndex);
                         }
                     } else {
                         qCDebug(PX4ParameterMetaDataLog) << "Unknown element in XML: " << elementName;
@@ -347,17 +252,8 @@ void PX4ParameterMetaData::loadParameterFactMetaDataFile(const QString& metaData
             QString elementName = xml.name().toString();
 
             if (elementName == "parameter") {
-                // Done loading this parameter, validate default value
-                if (metaData->defaultValueAvailable()) {
-                    QVariant var;
-                    
-                    if (!metaData->convertAndValidateRaw(metaData->rawDefaultValue(), false /* convertOnly */, var, errorString)) {
-                        qCWarning(PX4ParameterMetaDataLog) << "Invalid default value, name:" << metaData->name() << " type:" << metaData->type() << " default:" << metaData->rawDefaultValue() << " error:" << errorString;
-                    }
-                }
-                
                 // Reset for next parameter
-                metaData = NULL;
+                rawMetaData = NULL;
                 badMetaData = false;
                 xmlState = XmlStateFoundGroup;
             } else if (elementName == "group") {
@@ -368,15 +264,205 @@ void PX4ParameterMetaData::loadParameterFactMetaDataFile(const QString& metaData
         }
         xml.readNext();
     }
+
+    _writeCache(metaDataFile);
+}
+
+/// Compiles the meta data parsed from xml into the cache, so the next load can skip the xml
+void PX4ParameterMetaData::_writeCache(const QString& metaDataFile)
+{
+    ParameterMetaDataCache::RecordMap records;
+    foreach (const QString& name, _mapParameterName2RawMetaData.keys()) {
+        records[ParameterMetaDataCache::recordKey(QString(), name)] = _encodeRawMetaData(_mapParameterName2RawMetaData[name]);
+    }
+    ParameterMetaDataCache::write(metaDataFile, records);
+}
+
+QByteArray PX4ParameterMetaData::_encodeRawMetaData(const PX4FactMetaDataRaw& rawMetaData)
+{
+    QByteArray record;
+    QDataStream stream(&record, QIODevice::WriteOnly);
+    stream << rawMetaData.name << rawMetaData.group << (qint32)rawMetaData.type << rawMetaData.defaultValue << rawMetaData.duplicate << rawMetaData.elements;
+    return record;
+}
+
+bool PX4ParameterMetaData::_decodeRawMetaData(const QByteArray& record, PX4FactMetaDataRaw& rawMetaData)
+{
+    QDataStream stream(record);
+    qint32 type;
+    stream >> rawMetaData.name >> rawMetaData.group >> type >> rawMetaData.defaultValue >> rawMetaData.duplicate >> rawMetaData.elements;
+    rawMetaData.type = (FactMetaData::ValueType_t)type;
+    return stream.status() == QDataStream::Ok;
+}
+
+/// Returns the raw meta data for a parameter, from the parsed xml or from the cache
+bool PX4ParameterMetaData::_rawMetaData(const QString& name, PX4FactMetaDataRaw& rawMetaData)
+{
+    if (_mapParameterName2RawMetaData.contains(name)) {
+        rawMetaData = _mapParameterName2RawMetaData[name];
+        return true;
+    }
+
+    QByteArray record;
+    if (_cache.find(QString(), name, record)) {
+        if (_decodeRawMetaData(record, rawMetaData)) {
+            return true;
+        }
+        qWarning() << "Parameter meta data cache corruption, parameter:" << name;
+    }
+
+    return false;
+}
+
+FactMetaData* PX4ParameterMetaData::_createMetaData(const PX4FactMetaDataRaw& rawMetaData)
+{
+    FactMetaData* metaData = new FactMetaData(rawMetaData.type);
+    Q_CHECK_PTR(metaData);
+
+    if (rawMetaData.duplicate) {
+        // Default meta data only
+        return metaData;
+    }
+
+    metaData->setName(rawMetaData.name);
+    metaData->setGroup(rawMetaData.group);
+
+    QString errorString;
+    if (!rawMetaData.defaultValue.isEmpty()) {
+        QVariant varDefault;
+
+        if (metaData->convertAndValidateRaw(rawMetaData.defaultValue, false, varDefault, errorString)) {
+            metaData->setRawDefaultValue(varDefault);
+        } else {
+            qCWarning(PX4ParameterMetaDataLog) << "Invalid default value, name:" << rawMetaData.name << " type:" << rawMetaData.type << " default:" << rawMetaData.defaultValue << " error:" << errorString;
+        }
+    }
+
+    foreach (const QStringList& element, rawMetaData.elements) {
+        _addElementToMetaData(metaData, element);
+    }
+
+    // Done loading this parameter, validate default value
+    if (metaData->defaultValueAvailable()) {
+        QVariant var;
+
+        if (!metaData->convertAndValidateRaw(metaData->rawDefaultValue(), false /* convertOnly */, var, errorString)) {
+            qCWarning(PX4ParameterMetaDataLog) << "Invalid default value, name:" << metaData->name() << " type:" << metaData->type() << " default:" << metaData->rawDefaultValue() << " error:" << errorString;
+        }
+    }
+
+    return metaData;
+}
+
+/// Applies one meta data element from the xml to the FactMetaData
+///     @param element Element name, text and for value/bit elements the code/index attribute
+void PX4ParameterMetaData::_addElementToMetaData(FactMetaData* metaData, const QStringList& element)
+{
+    QString elementName = element.value(0);
+    QString text = element.value(1);
+    QString errorString;
+
+    if (elementName == "short_desc") {
+        text = text.replace("\n", " ");
+        metaData->setShortDescription(text);
+
+    } else if (elementName == "long_desc") {
+        text = text.replace("\n", " ");
+        metaData->setLongDescription(text);
+
+    } else if (elementName == "min") {
+        QVariant varMin;
+        if (metaData->convertAndValidateRaw(text, true /* convertOnly */, varMin, errorString)) {
+            metaData->setRawMin(varMin);
+        } else {
+            qCWarning(PX4ParameterMetaDataLog) << "Invalid min value, name:" << metaData->name() << " type:" << metaData->type() << " min:" << text << " error:" << errorString;
+        }
+
+    } else if (elementName == "max") {
+        QVariant varMax;
+        if (metaData->convertAndValidateRaw(text, true /* convertOnly */, varMax, errorString)) {
+            metaData->setRawMax(varMax);
+        } else {
+            qCWarning(PX4ParameterMetaDataLog) << "Invalid max value, name:" << metaData->name() << " type:" << metaData->type() << " max:" << text << " error:" << errorString;
+        }
+
+    } else if (elementName == "unit") {
+        metaData->setRawUnits(text);
+
+    } else if (elementName == "decimal") {
+        bool convertOk;
+        QVariant varDecimals = QVariant(text).toUInt(&convertOk);
+        if (convertOk) {
+            metaData->setDecimalPlaces(varDecimals.toInt());
+        } else {
+            qCWarning(PX4ParameterMetaDataLog) << "Invalid decimals value, name:" << metaData->name() << " type:" << metaData->type() << " decimals:" << text << " error: invalid number";
+        }
+
+    } else if (elementName == "reboot_required") {
+        if (text.compare("true", Qt::CaseInsensitive) == 0) {
+            metaData->setRebootRequired(true);
+        }
+
+    } else if (elementName == "value") {
+        QString enumValueStr = element.value(2);
+        QVariant enumValue;
+        if (metaData->convertAndValidateRaw(enumValueStr, false /* validate */, enumValue, errorString)) {
+            metaData->addEnumInfo(text, enumValue);
+        } else {
+            qCDebug(PX4ParameterMetaDataLog) << "Invalid enum value, name:" << metaData->name()
+                                             << " type:" << metaData->type() << " value:" << enumValueStr
+                                             << " error:" << errorString;
+        }
+
+    } else if (elementName == "increment") {
+        double  increment;
+        bool    ok;
+        increment = text.toDouble(&ok);
+        if (ok) {
+            metaData->setIncrement(increment);
+        } else {
+            qCWarning(PX4ParameterMetaDataLog) << "Invalid value for increment, name:" << metaData->name() << " increment:" << text;
+        }
+
+    } else if (elementName == "boolean") {
+        QVariant    enumValue;
+        metaData->convertAndValidateRaw(1, false /* validate */, enumValue, errorString);
+        metaData->addEnumInfo(tr("Enabled"), enumValue);
+        metaData->convertAndValidateRaw(0, false /* validate */, enumValue, errorString);
+        metaData->addEnumInfo(tr("Disabled"), enumValue);
+
+    } else if (elementName == "bit") {
+        unsigned char bit = element.value(2).toUInt();
+        if (bit < 31) {
+            QVariant bitmaskRawValue = 1 << bit;
+            QVariant bitmaskValue;
+            if (metaData->convertAndValidateRaw(bitmaskRawValue, true, bitmaskValue, errorString)) {
+                metaData->addBitmaskInfo(text, bitmaskValue);
+            } else {
+                qCDebug(PX4ParameterMetaDataLog) << "Invalid bitmask value, name:" << metaData->name()
+                                                 << " type:" << metaData->type() << " value:" << bitmaskValue
+                                                 << " error:" << errorString;
+            }
+        } else {
+            qCWarning(PX4ParameterMetaDataLog) << "Invalid value for bitmask, bit:" << bit;
+        }
+    }
 }
 
 void PX4ParameterMetaData::addMetaDataToFact(Fact* fact, MAV_TYPE vehicleType)
 {
     Q_UNUSED(vehicleType)
 
-    if (_mapParameterName2FactMetaData.contains(fact->name())) {
-        fact->setMetaData(_mapParameterName2FactMetaData[fact->name()]);
+    FactMetaData* metaData = _mapParameterName2FactMetaData.value(fact->name());
+    if (!metaData) {
+        PX4FactMetaDataRaw rawMetaData;
+        if (!_rawMetaData(fact->name(), rawMetaData)) {
+            return;
+        }
+        metaData = _createMetaData(rawMetaData);
+        _mapParameterName2FactMetaData[fact->name()] = metaData;
     }
+    fact->setMetaData(metaData);
 }
 
 void PX4ParameterMetaData::getParameterMetaDataVersionInfo(const QString& metaDataFile, int& majorVersion, int& minorVersion)
@@ -19,12 +19,30 @@
 #include "FactSystem.h"
 #include "AutoPilotPlugin.h"
 #include "Vehicle.h"
+#include "ParameterMetaDataCache.h"
 
 /// @file
 ///     @author Don Gagne <don@thegagnes.com>
 
 Q_DECLARE_LOGGING_CATEGORY(PX4ParameterMetaDataLog)
 
+/// Parameter meta data as read from the xml. The FactMetaData is only created from it once a Fact needs it.
+class PX4FactMetaDataRaw
+{
+public:
+    PX4FactMetaDataRaw(void)
+        : type(FactMetaData::valueTypeInt32)
+        , duplicate(false)
+    { }
+
+    QString                     name;
+    QString                     group;
+    FactMetaData::ValueType_t   type;
+    QString                     defaultValue;
+    bool                        duplicate;  ///< true: Parameter found more than once, only the type can be trusted
+    QList<QStringList>          elements;   ///< Meta data elements in xml order: element name, text, code/index attribute
+};
+
 /// Loads and holds parameter fact meta data for PX4 stack
 class PX4ParameterMetaData : public QObject
 {
@@ -49,9 +67,18 @@ private:
     };    
 
     QVariant _stringToTypedVariant(const QString& string, FactMetaData::ValueType_t type, bool* convertOk);
+    bool _rawMetaData(const QString& name, PX4FactMetaDataRaw& rawMetaData);
+    FactMetaData* _createMetaData(const PX4FactMetaDataRaw& rawMetaData);
+    void _addElementToMetaData(FactMetaData* metaData, const QStringList& element);
+    void _writeCache(const QString& metaDataFile);
+
+    static QByteArray _encodeRawMetaData(const PX4FactMetaDataRaw& rawMetaData);
+    static bool _decodeRawMetaData(const QByteArray& record, PX4FactMetaDataRaw& rawMetaData);
 
     bool _parameterMetaDataLoaded;   ///< true: parameter meta data already loaded
-    QMap<QString, FactMetaData*> _mapParameterName2FactMetaData; ///< Maps from a parameter name to FactMetaData
+    QMap<QString, PX4FactMetaDataRaw> _mapParameterName2RawMetaData; ///< Meta data parsed from xml, empty when loaded from cache
+    QMap<QString, FactMetaData*> _mapParameterName2FactMetaData; ///< Maps from a parameter name to FactMetaData, created on first use
+    ParameterMetaDataCache _cache;
 };
 
 #endif
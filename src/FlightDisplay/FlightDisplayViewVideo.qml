@@ -54,4 +54,41 @@ Item {
         }
         */
     }
+    //-- Additional streams as thumbnails, only the one clicked on decodes every frame
+    Row {
+        anchors.top:        parent.top
+        anchors.right:      parent.right
+        anchors.margins:    ScreenTools.defaultFontPixelHeight
+        spacing:            ScreenTools.defaultFontPixelWidth
+        visible:            !_mainIsMap
+        Repeater {
+            model:          QGroundControl.videoManager.streams
+            Rectangle {
+                width:          root.width * 0.2
+                height:         width * 9 / 16
+                color:          Qt.rgba(0,0,0,0.75)
+                border.width:   _focused ? 2 : 0
+                border.color:   "white"
+                property bool _focused: QGroundControl.videoManager.focusedStream === object
+                QGCVideoBackground {
+                    anchors.fill:       parent
+                    anchors.margins:    parent.border.width
+                    display:            object.videoSurface
+                    receiver:           object.videoReceiver
+                    visible:            object.videoRunning
+                }
+                QGCLabel {
+                    text:               qsTr("NO VIDEO")
+                    color:              "white"
+                    font.pointSize:     ScreenTools.smallFontPointSize
+                    anchors.centerIn:   parent
+                    visible:            !object.videoRunning
+                }
+                MouseArea {
+                    anchors.fill:   parent
+                    onClicked:      QGroundControl.videoManager.focusedStream = parent._focused ? null : object
+                }
+            }
+        }
+    }
 }
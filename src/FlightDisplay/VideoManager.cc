@@ -27,6 +27,9 @@
 static const char* kVideoSourceKey  = "VideoSource";
 static const char* kVideoUDPPortKey = "VideoUDPPort";
 static const char* kVideoRTSPUrlKey = "VideoRTSPUrl";
+static const char* kVideoJitterBufferModeKey = "VideoJitterBufferMode";
+static const char* kVideoDecoderKey = "VideoDecoder";
+static const char* kVideoStreamsKey = "VideoStreams";
 #if defined(QGC_GST_STREAMING)
 static const char* kUDPStream       = "UDP Video Stream";
 static const char* kRTSPStream      = "RTSP Video Stream";
@@ -42,6 +45,8 @@ VideoManager::VideoManager(QGCApplication* app)
     , _videoReceiver(NULL)
     , _videoRunning(false)
     , _udpPort(5600) //-- Defalut Port 5600 == Solo UDP Port
+    , _jitterBufferMode(VideoReceiver::JitterBufferOff)
+    , _focusedStream(NULL)
     , _init(false)
 {
 }
@@ -49,7 +54,7 @@ VideoManager::VideoManager(QGCApplication* app)
 //-----------------------------------------------------------------------------
 VideoManager::~VideoManager()
 {
-
+    _streams.clearAndDeleteContents();
 }
 
 //-----------------------------------------------------------------------------
@@ -59,6 +64,7 @@ VideoManager::setToolbox(QGCToolbox *toolbox)
    QGCTool::setToolbox(toolbox);
    QQmlEngine::setObjectOwnership(this, QQmlEngine::CppOwnership);
    qmlRegisterUncreatableType<VideoManager>("QGroundControl.VideoManager", 1, 0, "VideoManager", "Reference only");
+   qmlRegisterUncreatableType<VideoStream> ("QGroundControl.VideoManager", 1, 0, "VideoStream",  "Reference only");
    //-- Get saved settings
 #if defined(QGC_GST_STREAMING)
    QSettings settings;
@@ -80,12 +86,17 @@ VideoManager::setToolbox(QGCToolbox *toolbox)
        setUdpPort(settings.value(kVideoUDPPortKey, 5600).toUInt());
        setRtspURL(settings.value(kVideoRTSPUrlKey, "rtsp://192.168.42.1:554/live").toString()); //-- Example RTSP URL
    }
+   setJitterBufferMode(settings.value(kVideoJitterBufferModeKey, VideoReceiver::JitterBufferOff).toInt());
+   setVideoDecoder(settings.value(kVideoDecoderKey).toString());
 #endif
    _init = true;
 #if defined(QGC_GST_STREAMING)
    _updateVideo();
    connect(&_frameTimer, &QTimer::timeout, this, &VideoManager::_updateTimer);
    _frameTimer.start(1000);
+   foreach(const QString& uri, settings.value(kVideoStreamsKey).toStringList()) {
+       addStream(uri);
+   }
 #endif
 }
 
@@ -186,6 +197,137 @@ VideoManager::setRtspURL(QString url)
     */
 }
 
+//-----------------------------------------------------------------------------
+void
+VideoManager::setJitterBufferMode(int mode)
+{
+    if(mode < VideoReceiver::JitterBufferOff || mode > VideoReceiver::JitterBufferSmooth)
+        mode = VideoReceiver::JitterBufferOff;
+    if(mode == _jitterBufferMode)
+        return;
+    _jitterBufferMode = mode;
+    QSettings settings;
+    settings.setValue(kVideoJitterBufferModeKey, mode);
+    emit jitterBufferModeChanged();
+    //-- Unlike the source settings, this only needs the stream restarted
+    if(_videoReceiver) {
+        _videoReceiver->setJitterBufferMode((VideoReceiver::JitterBufferMode_t)mode);
+        if(isGStreamer()) {
+            _videoReceiver->start();
+        }
+    }
+    for(int i = 0; i < _streams.count(); i++) {
+        VideoStream* stream = _streams.value<VideoStream*>(i);
+        stream->videoReceiver()->setJitterBufferMode((VideoReceiver::JitterBufferMode_t)mode);
+        stream->start();
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+VideoManager::setVideoDecoder(QString decoder)
+{
+    if(decoder == _videoDecoder)
+        return;
+    _videoDecoder = decoder;
+    QSettings settings;
+    settings.setValue(kVideoDecoderKey, decoder);
+    emit videoDecoderChanged();
+    qCDebug(VideoManagerLog) << "New Video Decoder:" << (decoder.isEmpty() ? QStringLiteral("automatic") : decoder);
+    if(_videoReceiver) {
+        _videoReceiver->setPreferredDecoder(decoder);
+        if(isGStreamer()) {
+            _videoReceiver->start();
+        }
+    }
+    for(int i = 0; i < _streams.count(); i++) {
+        VideoStream* stream = _streams.value<VideoStream*>(i);
+        stream->videoReceiver()->setPreferredDecoder(decoder);
+        stream->start();
+    }
+}
+
+//-----------------------------------------------------------------------------
+VideoStream*
+VideoManager::addStream(const QString& uri)
+{
+    VideoStream* stream = new VideoStream(uri, this);
+    stream->videoReceiver()->setJitterBufferMode((VideoReceiver::JitterBufferMode_t)_jitterBufferMode);
+    stream->videoReceiver()->setPreferredDecoder(_videoDecoder);
+    _streams.append(stream);
+    _saveStreams();
+    _balanceStreams();
+    stream->start();
+    return stream;
+}
+
+//-----------------------------------------------------------------------------
+void
+VideoManager::removeStream(VideoStream* stream)
+{
+    if(!_streams.contains(stream))
+        return;
+    _streams.removeOne(stream);
+    _saveStreams();
+    if(stream == _focusedStream) {
+        _focusedStream = NULL;
+        emit focusedStreamChanged();
+    }
+    stream->stop();
+    stream->deleteLater();
+    _balanceStreams();
+}
+
+//-----------------------------------------------------------------------------
+void
+VideoManager::setFocusedStream(VideoStream* stream)
+{
+    if(stream && !_streams.contains(stream))
+        stream = NULL;
+    if(stream != _focusedStream) {
+        _focusedStream = stream;
+        emit focusedStreamChanged();
+        _balanceStreams();
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+VideoManager::_saveStreams()
+{
+    QStringList uris;
+    for(int i = 0; i < _streams.count(); i++) {
+        uris.append(_streams.value<VideoStream*>(i)->uri());
+    }
+    QSettings settings;
+    settings.setValue(kVideoStreamsKey, uris);
+}
+
+//-----------------------------------------------------------------------------
+//-- Streams run their own GStreamer decode threads, so the number of threads
+//   across all streams is bounded here instead: the focused stream decodes every
+//   frame with whatever cores the others leave, the others decode key frames
+//   only on a single thread. Changing focus only switches key frame dropping,
+//   which takes effect at the next key frame. Thread counts are picked up the
+//   next time a stream restarts.
+void
+VideoManager::_balanceStreams()
+{
+    int streamCount = _streams.count() + (_videoReceiver ? 1 : 0);
+    int focusedThreads = qMax(1, QThread::idealThreadCount() - (streamCount - 1));
+    if(_videoReceiver) {
+        bool focused = _focusedStream == NULL;
+        _videoReceiver->setKeyframesOnly(!focused);
+        _videoReceiver->setDecoderThreads(focused ? focusedThreads : 1);
+    }
+    for(int i = 0; i < _streams.count(); i++) {
+        VideoStream* stream = _streams.value<VideoStream*>(i);
+        bool focused = stream == _focusedStream;
+        stream->videoReceiver()->setKeyframesOnly(!focused);
+        stream->videoReceiver()->setDecoderThreads(focused ? focusedThreads : 1);
+    }
+}
+
 //-----------------------------------------------------------------------------
 QStringList
 VideoManager::videoSourceList()
@@ -257,6 +399,9 @@ void VideoManager::_updateVideo()
             delete _videoSurface;
         _videoSurface  = new VideoSurface;
         _videoReceiver = new VideoReceiver(this);
+        _videoReceiver->setJitterBufferMode((VideoReceiver::JitterBufferMode_t)_jitterBufferMode);
+        _videoReceiver->setPreferredDecoder(_videoDecoder);
+        _balanceStreams();
         #if defined(QGC_GST_STREAMING)
         _videoReceiver->setVideoSink(_videoSurface->videoSink());
         if(_videoSource == kUDPStream)
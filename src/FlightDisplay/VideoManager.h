@@ -17,6 +17,8 @@
 #include "QGCLoggingCategory.h"
 #include "VideoSurface.h"
 #include "VideoReceiver.h"
+#include "VideoStream.h"
+#include "QmlObjectListModel.h"
 #include "QGCToolbox.h"
 
 Q_DECLARE_LOGGING_CATEGORY(VideoManagerLog)
@@ -37,9 +39,18 @@ public:
     Q_PROPERTY(bool             videoRunning    READ    videoRunning                            NOTIFY videoRunningChanged)
     Q_PROPERTY(quint16          udpPort         READ    udpPort         WRITE setUdpPort        NOTIFY udpPortChanged)
     Q_PROPERTY(QString          rtspURL         READ    rtspURL         WRITE setRtspURL        NOTIFY rtspURLChanged)
+    Q_PROPERTY(int              jitterBufferMode READ   jitterBufferMode WRITE setJitterBufferMode NOTIFY jitterBufferModeChanged)
+    Q_PROPERTY(QString          videoDecoder    READ    videoDecoder    WRITE setVideoDecoder   NOTIFY videoDecoderChanged)
+    Q_PROPERTY(QStringList      videoDecoderList READ   videoDecoderList                        CONSTANT)
     Q_PROPERTY(bool             uvcEnabled      READ    uvcEnabled                              CONSTANT)
     Q_PROPERTY(VideoSurface*    videoSurface    MEMBER  _videoSurface                           CONSTANT)
     Q_PROPERTY(VideoReceiver*   videoReceiver   MEMBER  _videoReceiver                          CONSTANT)
+    Q_PROPERTY(QmlObjectListModel* streams      READ    streams                                 CONSTANT)
+    Q_PROPERTY(VideoStream*     focusedStream   READ    focusedStream   WRITE setFocusedStream  NOTIFY focusedStreamChanged)
+
+    /// Adds a stream shown alongside the main one, e.g. for another vehicle. Streams are kept across restarts.
+    Q_INVOKABLE VideoStream* addStream      (const QString& uri);
+    Q_INVOKABLE void        removeStream    (VideoStream* stream);
 
     bool        hasVideo            ();
     bool        isGStreamer         ();
@@ -49,6 +60,13 @@ public:
     QStringList videoSourceList     ();
     quint16     udpPort             () { return _udpPort; }
     QString     rtspURL             () { return _rtspURL; }
+    int         jitterBufferMode    () { return _jitterBufferMode; }
+    /// Decoder element tried first, empty to pick one automatically
+    QString     videoDecoder        () { return _videoDecoder; }
+    QStringList videoDecoderList    () { return VideoReceiver::decoderNames(); }
+    QmlObjectListModel* streams     () { return &_streams; }
+    /// Stream which is decoded in full, NULL for the main stream. All others only decode key frames.
+    VideoStream* focusedStream      () { return _focusedStream; }
 
 #if defined(QGC_DISABLE_UVC)
     bool        uvcEnabled          () { return false; }
@@ -59,6 +77,9 @@ public:
     void        setVideoSource      (QString vSource);
     void        setUdpPort          (quint16 port);
     void        setRtspURL          (QString url);
+    void        setJitterBufferMode (int mode);
+    void        setVideoDecoder     (QString decoder);
+    void        setFocusedStream    (VideoStream* stream);
 
     // Override from QGCTool
     void        setToolbox          (QGCToolbox *toolbox);
@@ -72,10 +93,15 @@ signals:
     void videoSourceIDChanged   ();
     void udpPortChanged         ();
     void rtspURLChanged         ();
+    void jitterBufferModeChanged();
+    void videoDecoderChanged    ();
+    void focusedStreamChanged   ();
 
 private:
     void _updateTimer           ();
     void _updateVideo           ();
+    void _balanceStreams        ();
+    void _saveStreams           ();
 
 private:
     VideoSurface*       _videoSurface;
@@ -89,6 +115,10 @@ private:
     QStringList         _videoSourceList;
     quint16             _udpPort;
     QString             _rtspURL;
+    int                 _jitterBufferMode;  ///< VideoReceiver::JitterBufferMode_t
+    QString             _videoDecoder;
+    QmlObjectListModel  _streams;
+    VideoStream*        _focusedStream;
     bool                _init;
 };
 
@@ -57,6 +57,9 @@
 #include "MultiVehicleManager.h"
 #include "Vehicle.h"
 #include "MavlinkQmlSingleton.h"
+#ifndef __mobile__
+#include "MAVLinkLogIndex.h"
+#endif
 #include "JoystickConfigController.h"
 #include "JoystickManager.h"
 #include "QmlObjectListModel.h"
@@ -295,10 +298,12 @@ QGCApplication::QGCApplication(int &argc, char* argv[], bool unitTesting)
         settings.clear();
         settings.setValue(_settingsVersionKey, QGC_SETTINGS_VERSION);
 
-        // Clear parameter cache
-        QDir paramDir(ParameterManager::parameterCacheDir());
-        paramDir.removeRecursively();
-        paramDir.mkpath(paramDir.absolutePath());
+        // Clear parameter cache. Unit tests use their own cache directory, see UnitTest::init.
+        if (!_runningUnitTests) {
+            QDir paramDir(ParameterManager::parameterCacheDir());
+            paramDir.removeRecursively();
+            paramDir.mkpath(paramDir.absolutePath());
+        }
     } else {
         // Determine if upgrade message for settings version bump is required. Check must happen before toolbox is started since
         // that will write some settings.
@@ -547,10 +552,17 @@ void QGCApplication::saveTempFlightDataLogOnMainThread(QString tempLogfile)
                 // if file could not be copied, prompt user and ask new path
                 saveError = true;
                 QGCMessageBox::warning("File Error","Could not create file.\nPlease provide a different file name to save to.");
+            } else {
+                // Bring the time index along so replay doesn't need to rebuild it. A stale index from an overwritten
+                // log is removed, replay will rebuild it if needed.
+                QString saveIndexFilename = MAVLinkLogIndex::indexFilename(saveFilename);
+                QFile::remove(saveIndexFilename);
+                QFile::copy(MAVLinkLogIndex::indexFilename(tempLogfile), saveIndexFilename);
             }
         }
     } while(saveError); // if the file could not be overwritten, ask for new file
     QFile::remove(tempLogfile);
+    QFile::remove(MAVLinkLogIndex::indexFilename(tempLogfile));
 }
 #endif
 
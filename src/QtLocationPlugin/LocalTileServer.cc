@@ -0,0 +1,109 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+
+#include "LocalTileServer.h"
+
+#include <QTimer>
+#include <QPointer>
+
+LocalTileServer::LocalTileServer(QObject* parent)
+    : QTcpServer(parent)
+    , _latencyMsecs(0)
+    , _errorInterval(0)
+    , _requestCount(0)
+    , _errorCount(0)
+    , _openRequests(0)
+    , _maxOpenRequests(0)
+{
+    connect(this, &QTcpServer::newConnection, this, &LocalTileServer::_newConnection);
+}
+
+bool LocalTileServer::start(void)
+{
+    return listen(QHostAddress::LocalHost, 0);
+}
+
+QString LocalTileServer::baseUrl(void) const
+{
+    return QString("http://127.0.0.1:%1").arg(serverPort());
+}
+
+QByteArray LocalTileServer::tileForPath(const QString& path)
+{
+    // PNG signature so the url factory recognizes the image format
+    return QByteArray("\x89PNG\r\n\x1a\n", 8) + path.toLatin1();
+}
+
+void LocalTileServer::_newConnection(void)
+{
+    while (hasPendingConnections()) {
+        QTcpSocket* socket = nextPendingConnection();
+        connect(socket, &QTcpSocket::readyRead, this, &LocalTileServer::_readRequests);
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            _buffers.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void LocalTileServer::_readRequests(void)
+{
+    QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
+    if (!socket) {
+        return;
+    }
+
+    QByteArray& buffer = _buffers[socket];
+    buffer += socket->readAll();
+
+    // Requests have no body, each one ends with an empty line
+    int end;
+    while ((end = buffer.indexOf("\r\n\r\n")) >= 0) {
+        QByteArray request = buffer.left(end);
+        buffer.remove(0, end + 4);
+
+        QList<QByteArray> requestLine = request.left(request.indexOf("\r\n")).split(' ');
+        QString path = requestLine.count() > 1 ? QString::fromLatin1(requestLine[1]) : QString();
+
+        _requestCount++;
+        bool fail = _errorInterval > 0 && (_requestCount % _errorInterval) == 0;
+        _openRequests++;
+        _maxOpenRequests = qMax(_maxOpenRequests, _openRequests);
+
+        QPointer<QTcpSocket> guardedSocket(socket);
+        QTimer::singleShot(_latencyMsecs, this, [this, guardedSocket, path, fail]() {
+            _openRequests--;
+            if (guardedSocket) {
+                _respond(guardedSocket, path, fail);
+            }
+        });
+    }
+}
+
+void LocalTileServer::_respond(QTcpSocket* socket, const QString& path, bool fail)
+{
+    QByteArray body;
+    QByteArray status;
+
+    if (fail) {
+        _errorCount++;
+        status = "503 Service Unavailable";
+    } else {
+        status = "200 OK";
+        body = tileForPath(path);
+    }
+
+    QByteArray response = "HTTP/1.1 " + status + "\r\n"
+            "Content-Type: image/png\r\n"
+            "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+            "Connection: keep-alive\r\n"
+            "\r\n" + body;
+    socket->write(response);
+}
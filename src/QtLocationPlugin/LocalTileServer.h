@@ -0,0 +1,68 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+
+#ifndef LocalTileServer_H
+#define LocalTileServer_H
+
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHash>
+
+/// @file
+///     @brief Stand in for a map tile server, used by the unit tests
+///
+///     Minimal HTTP/1.1 server on the loopback interface. Any GET is answered with a small PNG "tile" whose content
+///     identifies the requested path. Each response is delayed by a fixed latency, and every errorInterval'th request
+///     can be failed with a 503 to exercise error handling. Persistent connections are supported, as used by
+///     QNetworkAccessManager.
+
+class LocalTileServer : public QTcpServer
+{
+    Q_OBJECT
+
+public:
+    LocalTileServer(QObject* parent = NULL);
+
+    /// Starts listening on a free loopback port
+    bool start(void);
+
+    /// @return Base url of the server, for example "http://127.0.0.1:12345"
+    QString baseUrl(void) const;
+
+    /// Sets the delay before each response is sent
+    void setLatency(int msecs) { _latencyMsecs = msecs; }
+
+    /// Fails every errorInterval'th request with a 503, 0 to never fail, 1 to fail all requests
+    void setErrorInterval(int errorInterval) { _errorInterval = errorInterval; }
+
+    int requestCount(void) const        { return _requestCount; }
+    int errorCount(void) const          { return _errorCount; }
+    int maxOpenRequests(void) const     { return _maxOpenRequests; }
+
+    /// @return Tile content served for the specified path
+    static QByteArray tileForPath(const QString& path);
+
+private slots:
+    void _newConnection(void);
+    void _readRequests(void);
+
+private:
+    void _respond(QTcpSocket* socket, const QString& path, bool fail);
+
+    int                         _latencyMsecs;
+    int                         _errorInterval;
+    int                         _requestCount;
+    int                         _errorCount;
+    int                         _openRequests;
+    int                         _maxOpenRequests;
+    QHash<QTcpSocket*, QByteArray> _buffers;
+};
+
+#endif
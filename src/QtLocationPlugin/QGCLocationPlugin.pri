@@ -16,6 +16,8 @@ HEADERS += \
     $$PWD/QGCMapTileSet.h \
     $$PWD/QGCMapUrlEngine.h \
     $$PWD/QGCTileCacheWorker.h \
+    $$PWD/QGCTileDownloader.h \
+    $$PWD/QGCTileMemCache.h \
     $$PWD/QGeoCodeReplyQGC.h \
     $$PWD/QGeoCodingManagerEngineQGC.h \
     $$PWD/QGeoMapReplyQGC.h \
@@ -28,6 +30,8 @@ SOURCES += \
     $$PWD/QGCMapTileSet.cpp \
     $$PWD/QGCMapUrlEngine.cpp \
     $$PWD/QGCTileCacheWorker.cpp \
+    $$PWD/QGCTileDownloader.cpp \
+    $$PWD/QGCTileMemCache.cpp \
     $$PWD/QGeoCodeReplyQGC.cpp \
     $$PWD/QGeoCodingManagerEngineQGC.cpp \
     $$PWD/QGeoMapReplyQGC.cpp \
@@ -204,6 +204,7 @@ QGCMapEngine::init()
     } else {
         qCritical() << "Could not find suitable map cache directory.";
     }
+    _memCache.setMaxBytes((quint64)getMaxMemCache() * 1024 * 1024);
     QGCMapTask* task = new QGCMapTask(QGCMapTask::taskInit);
     _worker.enqueueTask(task);
 }
@@ -234,6 +235,9 @@ QGCMapEngine::_wipeDirectory(const QString& dirPath)
 void
 QGCMapEngine::addTask(QGCMapTask* task)
 {
+    if(task->type() == QGCMapTask::taskReset) {
+        _memCache.clear();
+    }
     _worker.enqueueTask(task);
 }
 
@@ -241,42 +245,64 @@ QGCMapEngine::addTask(QGCMapTask* task)
 void
 QGCMapEngine::cacheTile(UrlFactory::MapType type, int x, int y, int z, const QByteArray& image, const QString &format, qulonglong set)
 {
-    QString hash = getTileHash(type, x, y, z);
-    cacheTile(type, hash, image, format, set);
+    memCacheTile(type, x, y, z, image, format);
+    cacheTile(getTileKey(type, x, y, z), image, format, set);
 }
 
 //-----------------------------------------------------------------------------
 void
-QGCMapEngine::cacheTile(UrlFactory::MapType type, const QString& hash, const QByteArray& image, const QString& format, qulonglong set)
+QGCMapEngine::cacheTile(quint64 key, const QByteArray& image, const QString& format, qulonglong set)
 {
-    QGCSaveTileTask* task = new QGCSaveTileTask(new QGCCacheTile(hash, image, format, type, set));
+    QGCSaveTileTask* task = new QGCSaveTileTask(new QGCCacheTile(key, image, format, getTypeFromKey(key), set));
     _worker.enqueueTask(task);
 }
 
 //-----------------------------------------------------------------------------
-QString
-QGCMapEngine::getTileHash(UrlFactory::MapType type, int x, int y, int z)
+quint64
+QGCMapEngine::getTileKey(UrlFactory::MapType type, int x, int y, int z)
 {
-    return QString().sprintf("%04d%08d%08d%03d", (int)type, x, y, z);
+    //-- 16 bits of type, 8 bits of zoom and 20 bits each for x and y (enough up to MAX_MAP_ZOOM)
+    return ((quint64)(quint16)type << 48) | ((quint64)(quint8)z << 40) | ((quint64)(x & 0xFFFFF) << 20) | (quint64)(y & 0xFFFFF);
 }
 
 //-----------------------------------------------------------------------------
 UrlFactory::MapType
-QGCMapEngine::hashToType(const QString& hash)
+QGCMapEngine::getTypeFromKey(quint64 key)
 {
-    QString type = hash.mid(0,4);
-    return (UrlFactory::MapType)type.toInt();
+    return (UrlFactory::MapType)(quint16)(key >> 48);
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCMapEngine::getTileFromKey(quint64 key, int& x, int& y, int& z)
+{
+    x = (int)((key >> 20) & 0xFFFFF);
+    y = (int)(key & 0xFFFFF);
+    z = (int)(quint8)(key >> 40);
 }
 
 //-----------------------------------------------------------------------------
 QGCFetchTileTask*
 QGCMapEngine::createFetchTileTask(UrlFactory::MapType type, int x, int y, int z)
 {
-    QString hash = getTileHash(type, x, y, z);
-    QGCFetchTileTask* task = new QGCFetchTileTask(hash);
+    QGCFetchTileTask* task = new QGCFetchTileTask(getTileKey(type, x, y, z));
     return task;
 }
 
+//-----------------------------------------------------------------------------
+bool
+QGCMapEngine::getMemCachedTile(UrlFactory::MapType type, int x, int y, int z, QByteArray& image, QString& format)
+{
+    return _memCache.find(getTileKey(type, x, y, z), image, format);
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCMapEngine::memCacheTile(UrlFactory::MapType type, int x, int y, int z, const QByteArray& image, const QString& format)
+{
+    _memCache.insert(getTileKey(type, x, y, z), image, format);
+}
+
 //-----------------------------------------------------------------------------
 QGCTileSet
 QGCMapEngine::getTileCount(int zoom, double topleftLon, double topleftLat, double bottomRightLon, double bottomRightLat, UrlFactory::MapType mapType)
@@ -407,6 +433,7 @@ QGCMapEngine::setMaxMemCache(quint32 size)
     QSettings settings;
     settings.setValue(kMaxMemCacheKey, size);
     _maxMemCache = size;
+    _memCache.setMaxBytes((quint64)size * 1024 * 1024);
 }
 
 //-----------------------------------------------------------------------------
@@ -448,8 +475,12 @@ QGCMapEngine::_updateTotals(quint32 totaltiles, quint64 totalsize, quint32 defau
 }
 //-----------------------------------------------------------------------------
 void
-QGCMapEngine::_pruned()
+QGCMapEngine::_pruned(QList<quint64> tileKeys)
 {
+    //-- Tiles dropped from disk must not keep being served from memory
+    for(int i = 0; i < tileKeys.count(); i++) {
+        _memCache.remove(tileKeys[i]);
+    }
     _prunning = false;
 }
 
@@ -24,6 +24,7 @@
 #include "QGCMapUrlEngine.h"
 #include "QGCMapEngineData.h"
 #include "QGCTileCacheWorker.h"
+#include "QGCTileMemCache.h"
 
 //-----------------------------------------------------------------------------
 class QGCTileSet
@@ -72,12 +73,13 @@ public:
     void                        init                ();
     void                        addTask             (QGCMapTask *task);
     void                        cacheTile           (UrlFactory::MapType type, int x, int y, int z, const QByteArray& image, const QString& format, qulonglong set = UINT64_MAX);
-    void                        cacheTile           (UrlFactory::MapType type, const QString& hash, const QByteArray& image, const QString& format, qulonglong set = UINT64_MAX);
+    void                        cacheTile           (quint64 key, const QByteArray& image, const QString& format, qulonglong set = UINT64_MAX);
     QGCFetchTileTask*           createFetchTileTask (UrlFactory::MapType type, int x, int y, int z);
+    bool                        getMemCachedTile    (UrlFactory::MapType type, int x, int y, int z, QByteArray& image, QString& format);
+    void                        memCacheTile        (UrlFactory::MapType type, int x, int y, int z, const QByteArray& image, const QString& format);
     QStringList                 getMapNameList      ();
     const QString               userAgent           () { return _userAgent; }
     void                        setUserAgent        (const QString& ua) { _userAgent = ua; }
-    UrlFactory::MapType         hashToType          (const QString& hash);
     QString                     getMapBoxToken      ();
     void                        setMapBoxToken      (const QString& token);
     quint32                     getMaxDiskCache     ();
@@ -94,7 +96,9 @@ public:
     static QGCTileSet           getTileCount        (int zoom, double topleftLon, double topleftLat, double bottomRightLon, double bottomRightLat, UrlFactory::MapType mapType);
     static int                  long2tileX          (double lon, int z);
     static int                  lat2tileY           (double lat, int z);
-    static QString              getTileHash         (UrlFactory::MapType type, int x, int y, int z);
+    static quint64              getTileKey          (UrlFactory::MapType type, int x, int y, int z);
+    static UrlFactory::MapType  getTypeFromKey      (quint64 key);
+    static void                 getTileFromKey      (quint64 key, int& x, int& y, int& z);
     static UrlFactory::MapType  getTypeFromName     (const QString &name);
     static QString              bigSizeToString     (quint64 size);
     static QString              numberToString      (quint64 number);
@@ -102,7 +106,7 @@ public:
 
 private slots:
     void _updateTotals          (quint32 totaltiles, quint64 totalsize, quint32 defaulttiles, quint64 defaultsize);
-    void _pruned                ();
+    void _pruned                (QList<quint64> tileKeys);
 
 signals:
     void updateTotals           (quint32 totaltiles, quint64 totalsize, quint32 defaulttiles, quint64 defaultsize);
@@ -114,6 +118,7 @@ private:
 
 private:
     QGCCacheWorker          _worker;
+    QGCTileMemCache         _memCache;
     QString                 _cachePath;
     QString                 _cacheFile;
     QString                 _mapBoxToken;
@@ -37,6 +37,7 @@ public:
         , _y(0)
         , _z(0)
         , _set(UINT64_MAX)
+        , _key(0)
         , _type(UrlFactory::Invalid)
     {
     }
@@ -52,14 +53,14 @@ public:
     int                 y           () const { return _y; }
     int                 z           () const { return _z; }
     qulonglong          set         () const { return _set;  }
-    const QString       hash        () const { return _hash; }
+    quint64             key         () const { return _key; }
     UrlFactory::MapType type        () const { return _type; }
 
     void                setX        (int x) { _x = x; }
     void                setY        (int y) { _y = y; }
     void                setZ        (int z) { _z = z; }
     void                setTileSet  (qulonglong set) { _set = set;  }
-    void                setHash     (const QString& hash) { _hash = hash; }
+    void                setKey      (quint64 key) { _key = key; }
     void                setType     (UrlFactory::MapType type) { _type = type; }
 
 private:
@@ -67,7 +68,7 @@ private:
     int         _y;
     int         _z;
     qulonglong  _set;
-    QString     _hash;
+    quint64     _key;
     UrlFactory::MapType _type;
 };
 
@@ -76,27 +77,28 @@ class QGCCacheTile : public QObject
 {
     Q_OBJECT
 public:
-    QGCCacheTile    (const QString hash, const QByteArray img, const QString format, UrlFactory::MapType type, qulonglong set = UINT64_MAX)
+    QGCCacheTile    (quint64 key, const QByteArray img, const QString format, UrlFactory::MapType type, qulonglong set = UINT64_MAX)
         : _set(set)
-        , _hash(hash)
+        , _key(key)
         , _img(img)
         , _format(format)
         , _type(type)
     {
     }
-    QGCCacheTile    (const QString hash, qulonglong set)
+    QGCCacheTile    (quint64 key, qulonglong set)
         : _set(set)
-        , _hash(hash)
+        , _key(key)
+        , _type(UrlFactory::Invalid)
     {
     }
     qulonglong          set     () { return _set;   }
-    QString             hash    () { return _hash;  }
+    quint64             key     () { return _key;   }
     QByteArray          img     () { return _img;   }
     QString             format  () { return _format;}
     UrlFactory::MapType type    () { return _type; }
 private:
     qulonglong  _set;
-    QString     _hash;
+    quint64     _key;
     QByteArray  _img;
     QString     _format;
     UrlFactory::MapType _type;
@@ -194,9 +196,9 @@ class QGCFetchTileTask : public QGCMapTask
 {
     Q_OBJECT
 public:
-    QGCFetchTileTask(const QString hash)
+    QGCFetchTileTask(quint64 key)
         : QGCMapTask(QGCMapTask::taskFetchTile)
-        , _hash(hash)
+        , _key(key)
     {}
 
     ~QGCFetchTileTask()
@@ -208,13 +210,13 @@ public:
         emit tileFetched(tile);
     }
 
-    QString         hash() { return _hash; }
+    quint64         key() { return _key; }
 
 signals:
     void            tileFetched     (QGCCacheTile* tile);
 
 private:
-    QString         _hash;
+    quint64         _key;
 };
 
 //-----------------------------------------------------------------------------
@@ -271,21 +273,22 @@ class QGCUpdateTileDownloadStateTask : public QGCMapTask
 {
     Q_OBJECT
 public:
-    QGCUpdateTileDownloadStateTask(qulonglong setID, QGCTile::TyleState state, const QString& hash)
+    //-- A key of UINT64_MAX updates all tiles in the set
+    QGCUpdateTileDownloadStateTask(qulonglong setID, QGCTile::TyleState state, quint64 key)
         : QGCMapTask(QGCMapTask::taskUpdateTileDownloadState)
         , _setID(setID)
         , _state(state)
-        , _hash(hash)
+        , _key(key)
     {}
 
-    QString             hash    () { return _hash; }
+    quint64             key     () { return _key; }
     qulonglong          setID   () { return _setID; }
     QGCTile::TyleState  state   () { return _state; }
 
 private:
     qulonglong          _setID;
     QGCTile::TyleState  _state;
-    QString             _hash;
+    quint64             _key;
 };
 
 //-----------------------------------------------------------------------------
@@ -324,13 +327,13 @@ public:
 
     quint64  amount() { return _amount; }
 
-    void setPruned()
+    void setPruned(QList<quint64> tileKeys)
     {
-        emit pruned();
+        emit pruned(tileKeys);
     }
 
 signals:
-    void pruned();
+    void pruned(QList<quint64> tileKeys);
 
 private:
     quint64  _amount;
@@ -19,6 +19,7 @@
 #include "QGCMapEngine.h"
 #include "QGCMapTileSet.h"
 #include "QGCMapEngineManager.h"
+#include "QGCTileDownloader.h"
 
 #include <QSettings>
 #include <math.h>
@@ -48,6 +49,7 @@ QGCCachedTileSet::QGCCachedTileSet(const QString& name)
     , _id(0)
     , _type(UrlFactory::Invalid)
     , _networkManager(NULL)
+    , _downloader(NULL)
     , _errorCount(0)
     , _noMoreTiles(false)
     , _batchRequested(false)
@@ -59,6 +61,10 @@ QGCCachedTileSet::QGCCachedTileSet(const QString& name)
 //-----------------------------------------------------------------------------
 QGCCachedTileSet::~QGCCachedTileSet()
 {
+    //-- The downloader aborts its replies, it must go before the network manager
+    if(_downloader) {
+        delete _downloader;
+    }
     if(_networkManager) {
         delete _networkManager;
     }
@@ -135,6 +141,8 @@ QGCCachedTileSet::createDownloadTask()
         _errorCount   = 0;
         _downloading  = true;
         _noMoreTiles  = false;
+        qDeleteAll(_tilesToDownload);
+        _tilesToDownload.clear();
         emit downloadingChanged();
         emit errorCountChanged();
     }
@@ -153,7 +161,7 @@ void
 QGCCachedTileSet::resumeDownloadTask()
 {
     //-- Reset and download error flag (for all tiles)
-    QGCUpdateTileDownloadStateTask* task = new QGCUpdateTileDownloadStateTask(_id, QGCTile::StatePending, "*");
+    QGCUpdateTileDownloadStateTask* task = new QGCUpdateTileDownloadStateTask(_id, QGCTile::StatePending, UINT64_MAX);
     getQGCMapEngine()->addTask(task);
     //-- Start download
     createDownloadTask();
@@ -167,6 +175,12 @@ QGCCachedTileSet::cancelDownloadTask()
         _downloading = false;
         emit downloadingChanged();
     }
+    //-- Tiles left in the downloading state are reset when the download is resumed
+    if(_downloader) {
+        _downloader->abort();
+    }
+    qDeleteAll(_tilesToDownload);
+    _tilesToDownload.clear();
 }
 
 //-----------------------------------------------------------------------------
@@ -178,13 +192,16 @@ QGCCachedTileSet::_tileListFetched(QList<QGCTile *> tiles)
     if(tiles.size() < TILE_BATCH_SIZE) {
         _noMoreTiles = true;
     }
-    if(!tiles.size()) {
+    if(!tiles.size() && !_downloader) {
         _doneWithDownload();
         return;
     }
     //-- If this is the first time, create Network Manager
     if (!_networkManager) {
         _networkManager = new QNetworkAccessManager(this);
+        _downloader = new QGCTileDownloader(_networkManager, QGCMapEngine::concurrentDownloads(_type), this);
+        connect(_downloader, &QGCTileDownloader::tileDownloaded, this, &QGCCachedTileSet::_tileDownloaded);
+        connect(_downloader, &QGCTileDownloader::tileFailed, this, &QGCCachedTileSet::_tileDownloadFailed);
     }
     //-- Add tiles to the list
     _tilesToDownload += tiles;
@@ -215,123 +232,78 @@ void QGCCachedTileSet::_doneWithDownload()
 //-----------------------------------------------------------------------------
 void QGCCachedTileSet::_prepareDownload()
 {
-    if(!_tilesToDownload.count()) {
+    if(!_downloading) {
+        return;
+    }
+    //-- Hand everything fetched from the database over to the downloader, it spreads the requests over the servers
+    while(_tilesToDownload.count()) {
+        QGCTile* tile = _tilesToDownload.first();
+        _tilesToDownload.removeFirst();
+        QNetworkRequest request = getQGCMapEngine()->urlFactory()->getTileURL(tile->type(), tile->x(), tile->y(), tile->z(), _networkManager);
+        _downloader->addDownload(tile->key(), request);
+        delete tile;
+    }
+    if(!_downloader->queuedCount() && !_downloader->activeCount()) {
         //-- Are we done?
         if(_noMoreTiles) {
             _doneWithDownload();
-        } else {
-            if(!_batchRequested)
-                createDownloadTask();
+        } else if(!_batchRequested) {
+            createDownloadTask();
         }
         return;
     }
-    //-- Prepare queue (QNetworkAccessManager has a limit for concurrent downloads)
-    for(int i = _replies.count(); i < QGCMapEngine::concurrentDownloads(_type); i++) {
-        if(_tilesToDownload.count()) {
-            QGCTile* tile = _tilesToDownload.first();
-            _tilesToDownload.removeFirst();
-            QNetworkRequest request = getQGCMapEngine()->urlFactory()->getTileURL(tile->type(), tile->x(), tile->y(), tile->z(), _networkManager);
-            request.setAttribute(QNetworkRequest::User, tile->hash());
-            QNetworkReply* reply = _networkManager->get(request);
-            reply->setParent(0);
-            connect(reply, &QNetworkReply::finished, this, &QGCCachedTileSet::_networkReplyFinished);
-            connect(reply, static_cast<void (QNetworkReply::*)(QNetworkReply::NetworkError)>(&QNetworkReply::error), this, &QGCCachedTileSet::_networkReplyError);
-            _replies.insert(tile->hash(), reply);
-            delete tile;
-            //-- Refill queue if running low
-            if(!_batchRequested && !_noMoreTiles && _tilesToDownload.count() < (QGCMapEngine::concurrentDownloads(_type) * 10)) {
-                //-- Request new batch of tiles
-                createDownloadTask();
-            }
-        }
+    //-- Refill queue if running low
+    if(!_batchRequested && !_noMoreTiles && _downloader->queuedCount() < (_downloader->maxConcurrency() * 10)) {
+        //-- Request new batch of tiles
+        createDownloadTask();
     }
 }
 
 //-----------------------------------------------------------------------------
 void
-QGCCachedTileSet::_networkReplyFinished()
+QGCCachedTileSet::_tileDownloaded(quint64 key, QByteArray image)
 {
-    //-- Figure out which reply this is
-    QNetworkReply* reply = qobject_cast<QNetworkReply*>(QObject::sender());
-    if(!reply) {
-        qWarning() << "QGCMapEngineManager::networkReplyFinished() NULL Reply";
-        return;
-    }
-    //-- Get tile hash
-    const QString hash = reply->request().attribute(QNetworkRequest::User).toString();
-    if(!hash.isEmpty()) {
-        if(_replies.contains(hash)) {
-            _replies.remove(hash);
-        } else {
-            qWarning() << "QGCMapEngineManager::networkReplyFinished() Reply not in list: " << hash;
-        }
-        if (reply->error() != QNetworkReply::NoError) {
-            qWarning() << "QGCMapEngineManager::networkReplyFinished() Error:" << reply->errorString();
-            return;
-        }
-        qCDebug(QGCCachedTileSetLog) << "Tile fetched" << hash;
-        QByteArray image = reply->readAll();
-        UrlFactory::MapType type = getQGCMapEngine()->hashToType(hash);
-        QString format = getQGCMapEngine()->urlFactory()->getImageFormat(type, image);
-        if(!format.isEmpty()) {
-            //-- Cache tile
-            getQGCMapEngine()->cacheTile(type, hash, image, format, _id);
-            QGCUpdateTileDownloadStateTask* task = new QGCUpdateTileDownloadStateTask(_id, QGCTile::StateComplete, hash);
-            getQGCMapEngine()->addTask(task);
-            //-- Updated cached (downloaded) data
-            _savedTileSize += image.size();
-            _savedTileCount++;
-            emit savedTileSizeChanged();
-            emit savedTileCountChanged();
-            //-- Update estimate
-            if(_savedTileCount % 10 == 0) {
-                quint32 avg = _savedTileSize / _savedTileCount;
-                _totalTileSize  = avg * _totalTileCount;
-                _uniqueTileSize = avg * _uniqueTileCount;
-                emit totalTilesSizeChanged();
-                emit uniqueTileSizeChanged();
-            }
+    qCDebug(QGCCachedTileSetLog) << "Tile fetched" << key;
+    UrlFactory::MapType type = QGCMapEngine::getTypeFromKey(key);
+    QString format = getQGCMapEngine()->urlFactory()->getImageFormat(type, image);
+    if(!format.isEmpty()) {
+        //-- Cache tile
+        getQGCMapEngine()->cacheTile(key, image, format, _id);
+        QGCUpdateTileDownloadStateTask* task = new QGCUpdateTileDownloadStateTask(_id, QGCTile::StateComplete, key);
+        getQGCMapEngine()->addTask(task);
+        //-- Updated cached (downloaded) data
+        _savedTileSize += image.size();
+        _savedTileCount++;
+        emit savedTileSizeChanged();
+        emit savedTileCountChanged();
+        //-- Update estimate
+        if(_savedTileCount % 10 == 0) {
+            quint32 avg = _savedTileSize / _savedTileCount;
+            _totalTileSize  = avg * _totalTileCount;
+            _uniqueTileSize = avg * _uniqueTileCount;
+            emit totalTilesSizeChanged();
+            emit uniqueTileSizeChanged();
         }
-        //-- Setup a new download
-        _prepareDownload();
-    } else {
-        qWarning() << "QGCMapEngineManager::networkReplyFinished() Empty Hash";
     }
-    reply->deleteLater();
+    //-- Setup a new download
+    _prepareDownload();
 }
 
 //-----------------------------------------------------------------------------
 void
-QGCCachedTileSet::_networkReplyError(QNetworkReply::NetworkError error)
+QGCCachedTileSet::_tileDownloadFailed(quint64 key, QNetworkReply::NetworkError error, QString errorString)
 {
-    //-- Figure out which reply this is
-    QNetworkReply* reply = qobject_cast<QNetworkReply*>(QObject::sender());
-    if (!reply) {
-        return;
-    }
     //-- Upodate error count
     _errorCount++;
     emit errorCountChanged();
-    //-- Get tile hash
-    QString hash = reply->request().attribute(QNetworkRequest::User).toString();
-    qCDebug(QGCCachedTileSetLog) << "Error fetching tile" << reply->errorString();
-    if(!hash.isEmpty()) {
-        if(_replies.contains(hash)) {
-            _replies.remove(hash);
-        } else {
-            qWarning() << "QGCMapEngineManager::networkReplyError() Reply not in list: " << hash;
-        }
-        if (error != QNetworkReply::OperationCanceledError) {
-            qWarning() << "QGCMapEngineManager::networkReplyError() Error:" << reply->errorString();
-        }
-        QGCUpdateTileDownloadStateTask* task = new QGCUpdateTileDownloadStateTask(_id, QGCTile::StateError, hash);
-        getQGCMapEngine()->addTask(task);
-    } else {
-        qWarning() << "QGCMapEngineManager::networkReplyError() Empty Hash";
+    qCDebug(QGCCachedTileSetLog) << "Error fetching tile" << errorString;
+    if (error != QNetworkReply::OperationCanceledError) {
+        qWarning() << "QGCCachedTileSet::_tileDownloadFailed() Error:" << errorString;
     }
+    QGCUpdateTileDownloadStateTask* task = new QGCUpdateTileDownloadStateTask(_id, QGCTile::StateError, key);
+    getQGCMapEngine()->addTask(task);
     //-- Setup a new download
     _prepareDownload();
-    reply->deleteLater();
 }
 
 //-----------------------------------------------------------------------------
@@ -33,6 +33,7 @@ Q_DECLARE_LOGGING_CATEGORY(QGCCachedTileSetLog)
 
 class QGCTile;
 class QGCMapEngineManager;
+class QGCTileDownloader;
 
 //-----------------------------------------------------------------------------
 class QGCCachedTileSet : public QObject
@@ -145,8 +146,8 @@ signals:
 
 private slots:
     void _tileListFetched               (QList<QGCTile*> tiles);
-    void _networkReplyFinished          ();
-    void _networkReplyError             (QNetworkReply::NetworkError error);
+    void _tileDownloaded                (quint64 key, QByteArray image);
+    void _tileDownloadFailed            (quint64 key, QNetworkReply::NetworkError error, QString errorString);
 
 private:
     void        _prepareDownload        ();
@@ -174,7 +175,7 @@ private:
     quint64     _id;
     UrlFactory::MapType _type;
     QNetworkAccessManager*  _networkManager;
-    QHash<QString, QNetworkReply*> _replies;
+    QGCTileDownloader*      _downloader;
     quint32     _errorCount;
     //-- Tile download
     QList<QGCTile *> _tilesToDownload;
@@ -0,0 +1,463 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "QGCTileCacheTest.h"
+#include "QGCMapEngine.h"
+#include "QGCTileCacheWorker.h"
+#include "QGCTileMemCache.h"
+#include "QGCMapTileSet.h"
+
+#include <QElapsedTimer>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+
+#include <math.h>
+
+QGCTileCacheTest::QGCTileCacheTest(void)
+{
+
+}
+
+quint64 QGCTileCacheTest::_tileKey(int index)
+{
+    return QGCMapEngine::getTileKey(UrlFactory::GoogleMap, index % 4096, index / 4096, 19);
+}
+
+/// Small tile images so a large cache stays manageable on disk, the bytes identify the tile
+QByteArray QGCTileCacheTest::_tileImage(int index)
+{
+    QByteArray image(256, (char)(index & 0xFF));
+    memcpy(image.data(), &index, sizeof(index));
+    return image;
+}
+
+bool QGCTileCacheTest::_waitForCount(QAtomicInt& counter, int count, int msecs)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (counter.loadAcquire() < count) {
+        if (timer.elapsed() > msecs) {
+            return false;
+        }
+        QTest::qWait(1);
+    }
+    return true;
+}
+
+/// Initializes the worker against a new database and waits for it to accept tasks
+bool QGCTileCacheTest::_startWorker(QGCCacheWorker& worker, const QString& name)
+{
+    worker.setDatabaseFile(_tempDir.path() + "/" + name);
+    worker.enqueueTask(new QGCMapTask(QGCMapTask::taskInit));
+
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < _taskTimeoutMsecs) {
+        QGCFetchTileTask* task = new QGCFetchTileTask(_tileKey(-1));
+        QAtomicInt done(0);
+        connect(task, &QGCMapTask::error, [&done](QGCMapTask::TaskType, QString) { done.storeRelease(1); });
+        if (worker.enqueueTask(task)) {
+            return _waitForCount(done, 1, _taskTimeoutMsecs);
+        }
+        // Rejected tasks signal the error synchronously, so done can be discarded here
+        QTest::qWait(10);
+    }
+    return false;
+}
+
+/// Queues saves for tiles first to first + count - 1. Saves are not signalled, follow with a fetch to wait for them.
+void QGCTileCacheTest::_saveTiles(QGCCacheWorker& worker, int first, int count)
+{
+    for (int i=first; i<first + count; i++) {
+        worker.enqueueTask(new QGCSaveTileTask(new QGCCacheTile(_tileKey(i), _tileImage(i), "png", UrlFactory::GoogleMap)));
+    }
+}
+
+/// Fetches the tiles and waits for all of them to complete
+///     @param[out] tiles Images of the tiles which were found, NULL to discard them
+bool QGCTileCacheTest::_fetchTiles(QGCCacheWorker& worker, const QList<quint64>& keys, QHash<quint64, QByteArray>* tiles)
+{
+    QAtomicInt completed(0);
+
+    foreach (quint64 key, keys) {
+        QGCFetchTileTask* task = new QGCFetchTileTask(key);
+        // Signals are emitted from the worker thread, the results are only read once all fetches have completed
+        connect(task, &QGCFetchTileTask::tileFetched, [&completed, tiles](QGCCacheTile* tile) {
+            if (tiles) {
+                tiles->insert(tile->key(), tile->img());
+            }
+            delete tile;
+            completed.fetchAndAddOrdered(1);
+        });
+        connect(task, &QGCMapTask::error, [&completed](QGCMapTask::TaskType, QString) { completed.fetchAndAddOrdered(1); });
+        worker.enqueueTask(task);
+    }
+
+    return _waitForCount(completed, keys.count(), _taskTimeoutMsecs);
+}
+
+void QGCTileCacheTest::_saveFetch_test(void)
+{
+    QVERIFY(_tempDir.isValid());
+
+    QGCCacheWorker worker;
+    QVERIFY(_startWorker(worker, "saveFetch.db"));
+
+    const int tileCount = 500;
+    _saveTiles(worker, 0, tileCount);
+
+    // Saving the same tile twice must keep the first copy
+    worker.enqueueTask(new QGCSaveTileTask(new QGCCacheTile(_tileKey(0), QByteArray("duplicate"), "png", UrlFactory::GoogleMap)));
+
+    QList<quint64> keys;
+    for (int i=0; i<tileCount; i++) {
+        keys << _tileKey(i);
+    }
+    keys << _tileKey(tileCount);
+
+    QHash<quint64, QByteArray> tiles;
+    QVERIFY(_fetchTiles(worker, keys, &tiles));
+    QCOMPARE(tiles.count(), tileCount);
+    for (int i=0; i<tileCount; i++) {
+        QCOMPARE(tiles.value(_tileKey(i)), _tileImage(i));
+    }
+    QVERIFY(!tiles.contains(_tileKey(tileCount)));
+
+    worker.quit();
+    worker.wait();
+}
+
+void QGCTileCacheTest::_memCache_test(void)
+{
+    const int tileBytes = 256;
+    const int budgetTiles = 64;
+
+    QGCTileMemCache cache;
+    cache.setMaxBytes(budgetTiles * tileBytes);
+
+    QByteArray  image;
+    QString     format;
+    QVERIFY(!cache.find(QGCMapEngine::getTileKey(UrlFactory::GoogleMap, 0, 0, 19), image, format));
+
+    // Keep touching tile 0 while filling the cache well past its budget, the LRU must keep it
+    quint64 firstKey = QGCMapEngine::getTileKey(UrlFactory::GoogleMap, 0, 0, 19);
+    cache.insert(firstKey, _tileImage(0), "png");
+    for (int i=1; i<budgetTiles * 10; i++) {
+        cache.insert(QGCMapEngine::getTileKey(UrlFactory::GoogleMap, i % 4096, i / 4096, 19), _tileImage(i), "png");
+        QVERIFY(cache.find(firstKey, image, format));
+    }
+    QCOMPARE(image, _tileImage(0));
+    QCOMPARE(format, QString("png"));
+
+    // Everything else is bounded by the byte budget
+    int cachedTiles = 0;
+    for (int i=1; i<budgetTiles * 10; i++) {
+        if (cache.find(QGCMapEngine::getTileKey(UrlFactory::GoogleMap, i % 4096, i / 4096, 19), image, format)) {
+            QCOMPARE(image, _tileImage(i));
+            cachedTiles++;
+        }
+    }
+    QVERIFY(cachedTiles > 0);
+    QVERIFY(cachedTiles < budgetTiles);
+
+    // Same x/y/z with a different map type is a different tile
+    QVERIFY(!cache.find(QGCMapEngine::getTileKey(UrlFactory::GoogleSatellite, 0, 0, 19), image, format));
+
+    // Removing a tile, as done for tiles pruned from disk, leaves the others alone
+    quint64 secondKey = QGCMapEngine::getTileKey(UrlFactory::GoogleMap, 1, 0, 19);
+    cache.insert(secondKey, _tileImage(1), "png");
+    cache.remove(firstKey);
+    QVERIFY(!cache.find(firstKey, image, format));
+    QVERIFY(cache.find(secondKey, image, format));
+    cache.remove(firstKey);
+
+    cache.clear();
+    QVERIFY(!cache.find(firstKey, image, format));
+}
+
+/// Tile totals are maintained incrementally by the database, check them against what was saved and pruned
+void QGCTileCacheTest::_totals_test(void)
+{
+    QVERIFY(_tempDir.isValid());
+
+    QGCCacheWorker worker;
+    QVERIFY(_startWorker(worker, "totals.db"));
+
+    // Totals are reported from the worker thread once its queue runs empty
+    QAtomicInt totalCount(-1);
+    QAtomicInt totalSize(-1);
+    QAtomicInt defaultCount(-1);
+    QAtomicInt defaultSize(-1);
+    connect(&worker, &QGCCacheWorker::updateTotals, [&](quint32 totaltiles, quint64 totalsize, quint32 defaulttiles, quint64 defaultsize) {
+        totalSize.storeRelease((int)totalsize);
+        defaultCount.storeRelease((int)defaulttiles);
+        defaultSize.storeRelease((int)defaultsize);
+        totalCount.storeRelease((int)totaltiles);
+    }, Qt::DirectConnection);
+
+    const int tileCount = 100;
+    const int tileBytes = _tileImage(0).size();
+    _saveTiles(worker, 0, tileCount);
+    QVERIFY(_fetchTiles(worker, QList<quint64>() << _tileKey(tileCount - 1), NULL));
+    QVERIFY(_waitForCount(totalCount, tileCount, _taskTimeoutMsecs));
+    QCOMPARE(totalSize.loadAcquire(), tileCount * tileBytes);
+    QCOMPARE(defaultCount.loadAcquire(), tileCount);
+    QCOMPARE(defaultSize.loadAcquire(), tileCount * tileBytes);
+
+    // Pruning stops at the first tile which reaches the amount
+    const int prunedTiles = 10;
+    QGCPruneCacheTask* task = new QGCPruneCacheTask(prunedTiles * tileBytes - 1);
+    QAtomicInt      pruned(0);
+    QList<quint64>  prunedKeys;
+    connect(task, &QGCPruneCacheTask::pruned, [&pruned, &prunedKeys](QList<quint64> tileKeys) {
+        prunedKeys = tileKeys;
+        pruned.storeRelease(1);
+    });
+    worker.enqueueTask(task);
+    QVERIFY(_waitForCount(pruned, 1, _taskTimeoutMsecs));
+
+    // The pruned tiles are reported so the engine can drop them from the memory cache
+    QCOMPARE(prunedKeys.count(), prunedTiles);
+    for (int i=0; i<prunedKeys.count(); i++) {
+        bool savedTile = false;
+        for (int j=0; j<tileCount && !savedTile; j++) {
+            savedTile = prunedKeys[i] == _tileKey(j);
+        }
+        QVERIFY(savedTile);
+        QVERIFY(prunedKeys.indexOf(prunedKeys[i]) == i);
+    }
+    QVERIFY(_fetchTiles(worker, QList<quint64>() << _tileKey(0), NULL));
+
+    QElapsedTimer timer;
+    timer.start();
+    while (totalCount.loadAcquire() != tileCount - prunedTiles && timer.elapsed() < _taskTimeoutMsecs) {
+        QTest::qWait(1);
+    }
+    QCOMPARE(totalCount.loadAcquire(), tileCount - prunedTiles);
+    QCOMPARE(totalSize.loadAcquire(), (tileCount - prunedTiles) * tileBytes);
+    QCOMPARE(defaultCount.loadAcquire(), tileCount - prunedTiles);
+    QCOMPARE(defaultSize.loadAcquire(), (tileCount - prunedTiles) * tileBytes);
+
+    worker.quit();
+    worker.wait();
+}
+
+/// Creates a tile set over a region which is partly cached already. Cached tiles must be added to the set, the
+/// rest must end up in the download list.
+///     @param regionTiles Approximate number of tiles in the region
+///     @param[out] createMsecs Time taken to create the tile set, NULL if not needed
+void QGCTileCacheTest::_createTileSet(int regionTiles, qint64* createMsecs)
+{
+    QVERIFY(_tempDir.isValid());
+
+    QGCCacheWorker worker;
+    QVERIFY(_startWorker(worker, QString("createTileSet%1.db").arg(regionTiles)));
+
+    // Square region of roughly regionTiles tiles at zoom 19, corners at the tile centers
+    const int zoom = 19;
+    const UrlFactory::MapType type = UrlFactory::GoogleMap;
+    const int firstTile = 1000;
+    int side = qMax((int)sqrt((double)regionTiles), 2);
+    double tiles = 1 << zoom;
+    double topleftLon = (firstTile + 0.5) / tiles * 360.0 - 180.0;
+    double bottomRightLon = (firstTile + side - 0.5) / tiles * 360.0 - 180.0;
+    double topleftLat = atan(sinh(M_PI * (1.0 - 2.0 * (firstTile + 0.5) / tiles))) * 180.0 / M_PI;
+    double bottomRightLat = atan(sinh(M_PI * (1.0 - 2.0 * (firstTile + side - 0.5) / tiles))) * 180.0 / M_PI;
+    QGCTileSet region = QGCMapEngine::getTileCount(zoom, topleftLon, topleftLat, bottomRightLon, bottomRightLat, type);
+    QCOMPARE(region.tileCount, (quint64)(side * side));
+
+    // Cache every other tile of the region
+    int cachedTiles = 0;
+    int index = 0;
+    for (int x=region.tileX0; x<=region.tileX1; x++) {
+        for (int y=region.tileY0; y<=region.tileY1; y++) {
+            if (index++ % 2 == 0) {
+                worker.enqueueTask(new QGCSaveTileTask(new QGCCacheTile(QGCMapEngine::getTileKey(type, x, y, zoom), _tileImage(index), "png", type)));
+                cachedTiles++;
+            }
+        }
+    }
+    QVERIFY(_fetchTiles(worker, QList<quint64>() << QGCMapEngine::getTileKey(type, region.tileX0, region.tileY0, zoom), NULL));
+
+    QGCCachedTileSet* tileSet = new QGCCachedTileSet("Region");
+    tileSet->setMapTypeStr("Google Street Map");
+    tileSet->setType(type);
+    tileSet->setTopleftLat(topleftLat);
+    tileSet->setTopleftLon(topleftLon);
+    tileSet->setBottomRightLat(bottomRightLat);
+    tileSet->setBottomRightLon(bottomRightLon);
+    tileSet->setMinZoom(zoom);
+    tileSet->setMaxZoom(zoom);
+    tileSet->setTotalTileCount(region.tileCount);
+
+    QGCCreateTileSetTask* createTask = new QGCCreateTileSetTask(tileSet);
+    QAtomicInt done(0);
+    bool created = false;
+    connect(createTask, &QGCCreateTileSetTask::tileSetSaved, [&done, &created](QGCCachedTileSet*) { created = true; done.storeRelease(1); });
+    connect(createTask, &QGCMapTask::error, [&done](QGCMapTask::TaskType, QString) { done.storeRelease(1); });
+    QElapsedTimer timer;
+    timer.start();
+    worker.enqueueTask(createTask);
+    QVERIFY(_waitForCount(done, 1, _taskTimeoutMsecs));
+    if (createMsecs) {
+        *createMsecs = qMax(timer.elapsed(), (qint64)1);
+    }
+    QVERIFY(created);
+
+    QCOMPARE((int)tileSet->savedTileCount(), cachedTiles);
+
+    // Everything which isn't cached yet is to be downloaded
+    QGCGetTileDownloadListTask* listTask = new QGCGetTileDownloadListTask(tileSet->id(), region.tileCount);
+    QAtomicInt listed(-1);
+    QSet<quint64> downloadKeys;
+    int badTiles = 0;
+    connect(listTask, &QGCGetTileDownloadListTask::tileListFetched, [&listed, &downloadKeys, &badTiles](QList<QGCTile*> tiles) {
+        foreach (QGCTile* tile, tiles) {
+            // Type and coordinates are decoded from the key
+            if (tile->key() != QGCMapEngine::getTileKey(tile->type(), tile->x(), tile->y(), tile->z())) {
+                badTiles++;
+            }
+            downloadKeys.insert(tile->key());
+            delete tile;
+        }
+        listed.storeRelease(tiles.count());
+    });
+    worker.enqueueTask(listTask);
+    QVERIFY(_waitForCount(listed, 0, _taskTimeoutMsecs));
+    QCOMPARE(listed.loadAcquire(), (int)region.tileCount - cachedTiles);
+    QCOMPARE(badTiles, 0);
+    QVERIFY(!downloadKeys.contains(QGCMapEngine::getTileKey(type, region.tileX0, region.tileY0, zoom)));
+    QVERIFY(downloadKeys.contains(QGCMapEngine::getTileKey(type, region.tileX0, region.tileY0 + 1, zoom)));
+
+    worker.quit();
+    worker.wait();
+    delete tileSet;
+}
+
+void QGCTileCacheTest::_createTileSet_test(void)
+{
+    _createTileSet(_testTileSetTiles, NULL);
+}
+
+/// Caches created before tiles were keyed by QGCMapEngine::getTileKey() are converted when opened
+void QGCTileCacheTest::_keyUpgrade_test(void)
+{
+    QVERIFY(_tempDir.isValid());
+
+    const QString path = _tempDir.path() + "/keyUpgrade.db";
+    const UrlFactory::MapType type = UrlFactory::GoogleSatellite;
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "QGCTileCacheTestUpgrade");
+        db.setDatabaseName(path);
+        QVERIFY(db.open());
+        QSqlQuery query(db);
+        QVERIFY(query.exec("CREATE TABLE Tiles (tileID INTEGER PRIMARY KEY NOT NULL, hash TEXT NOT NULL UNIQUE, format TEXT NOT NULL, tile BLOB NULL, size INTEGER, type INTEGER, date INTEGER DEFAULT 0)"));
+        QVERIFY(query.exec("CREATE TABLE TileSets (setID INTEGER PRIMARY KEY NOT NULL, name TEXT NOT NULL UNIQUE, typeStr TEXT, topleftLat REAL DEFAULT 0.0, topleftLon REAL DEFAULT 0.0, bottomRightLat REAL DEFAULT 0.0, bottomRightLon REAL DEFAULT 0.0, minZoom INTEGER DEFAULT 3, maxZoom INTEGER DEFAULT 3, type INTEGER DEFAULT -1, numTiles INTEGER DEFAULT 0, defaultSet INTEGER DEFAULT 0, date INTEGER DEFAULT 0)"));
+        QVERIFY(query.exec("CREATE TABLE SetTiles (setID INTEGER, tileID INTEGER)"));
+        QVERIFY(query.exec("CREATE TABLE TilesDownload (setID INTEGER, hash TEXT NOT NULL UNIQUE, type INTEGER, x INTEGER, y INTEGER, z INTEGER, state INTEGER DEFAULT 0)"));
+        QVERIFY(query.exec("INSERT INTO TileSets(setID, name, defaultSet) VALUES(1, 'Default Tile Set', 1)"));
+        QVERIFY(query.exec("INSERT INTO TileSets(setID, name, numTiles) VALUES(2, 'Region', 2)"));
+        for (int i=0; i<2; i++) {
+            query.prepare("INSERT INTO Tiles(tileID, hash, format, tile, size, type) VALUES(?, ?, 'png', ?, ?, ?)");
+            query.addBindValue(i + 1);
+            query.addBindValue(QString().sprintf("%04d%08d%08d%03d", (int)type, 1000 + i, 2000, 19));
+            query.addBindValue(_tileImage(i));
+            query.addBindValue(_tileImage(i).size());
+            query.addBindValue((int)type);
+            QVERIFY(query.exec());
+            QVERIFY(query.exec(QString("INSERT INTO SetTiles(setID, tileID) VALUES(%1, %2)").arg(i + 1).arg(i + 1)));
+        }
+        QVERIFY(query.exec(QString("INSERT INTO TilesDownload(setID, hash, type, x, y, z) VALUES(2, '%1', %2, 1002, 2000, 19)")
+                           .arg(QString().sprintf("%04d%08d%08d%03d", (int)type, 1002, 2000, 19)).arg((int)type)));
+        db.close();
+    }
+    QSqlDatabase::removeDatabase("QGCTileCacheTestUpgrade");
+
+    QGCCacheWorker worker;
+    QVERIFY(_startWorker(worker, "keyUpgrade.db"));
+
+    QHash<quint64, QByteArray> tiles;
+    QVERIFY(_fetchTiles(worker, QList<quint64>() << QGCMapEngine::getTileKey(type, 1000, 2000, 19) << QGCMapEngine::getTileKey(type, 1001, 2000, 19), &tiles));
+    QCOMPARE(tiles.count(), 2);
+    QCOMPARE(tiles.value(QGCMapEngine::getTileKey(type, 1000, 2000, 19)), _tileImage(0));
+    QCOMPARE(tiles.value(QGCMapEngine::getTileKey(type, 1001, 2000, 19)), _tileImage(1));
+
+    QGCGetTileDownloadListTask* listTask = new QGCGetTileDownloadListTask(2, 10);
+    QAtomicInt listed(-1);
+    quint64 downloadKey = 0;
+    connect(listTask, &QGCGetTileDownloadListTask::tileListFetched, [&listed, &downloadKey](QList<QGCTile*> tiles) {
+        foreach (QGCTile* tile, tiles) {
+            downloadKey = tile->key();
+            delete tile;
+        }
+        listed.storeRelease(tiles.count());
+    });
+    worker.enqueueTask(listTask);
+    QVERIFY(_waitForCount(listed, 0, _taskTimeoutMsecs));
+    QCOMPARE(listed.loadAcquire(), 1);
+    QCOMPARE(downloadKey, QGCMapEngine::getTileKey(type, 1002, 2000, 19));
+
+    worker.quit();
+    worker.wait();
+}
+
+void QGCTileCacheTest::_throughput_benchmark(void)
+{
+    QVERIFY(_tempDir.isValid());
+
+    int tileCount = qgetenv("QGC_TILE_CACHE_BENCHMARK_TILES").toInt();
+    if (tileCount <= 0) {
+        tileCount = _defaultBenchmarkTiles;
+    }
+
+    QGCCacheWorker worker;
+    QVERIFY(_startWorker(worker, "benchmark.db"));
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int first=0; first<tileCount; first+=_saveChunk) {
+        int count = qMin(_saveChunk, tileCount - first);
+        _saveTiles(worker, first, count);
+        // Wait for the chunk so the task queue stays bounded
+        QVERIFY(_fetchTiles(worker, QList<quint64>() << _tileKey(first + count - 1), NULL));
+    }
+    qint64 saveMsecs = qMax(timer.elapsed(), (qint64)1);
+    qDebug() << "Saved" << tileCount << "tiles in" << saveMsecs << "msecs," << (tileCount * 1000LL) / saveMsecs << "tiles/sec";
+
+    QList<quint64> keys;
+    qsrand(1);
+    for (int i=0; i<_benchmarkFetches; i++) {
+        keys << _tileKey(qrand() % tileCount);
+    }
+
+    QHash<quint64, QByteArray> tiles;
+    timer.restart();
+    QVERIFY(_fetchTiles(worker, keys, &tiles));
+    qint64 fetchMsecs = qMax(timer.elapsed(), (qint64)1);
+    qDebug() << "Fetched" << keys.count() << "tiles from a" << tileCount << "tile cache in" << fetchMsecs << "msecs," << (keys.count() * 1000LL) / fetchMsecs << "tiles/sec";
+
+    QCOMPARE(tiles.count(), keys.toSet().count());
+
+    worker.quit();
+    worker.wait();
+}
+
+void QGCTileCacheTest::_createTileSet_benchmark(void)
+{
+    int regionTiles = qgetenv("QGC_TILE_SET_BENCHMARK_TILES").toInt();
+    if (regionTiles <= 0) {
+        regionTiles = _defaultTileSetTiles;
+    }
+
+    qint64 createMsecs = 0;
+    _createTileSet(regionTiles, &createMsecs);
+    if (!QTest::currentTestFailed()) {
+        qDebug() << "Created tile set of about" << regionTiles << "tiles in" << createMsecs << "msecs," << (regionTiles * 1000LL) / createMsecs << "tiles/sec";
+    }
+}
@@ -0,0 +1,62 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#ifndef QGCTileCacheTest_H
+#define QGCTileCacheTest_H
+
+#include "UnitTest.h"
+
+#include <QTemporaryDir>
+#include <QAtomicInt>
+
+class QGCCacheWorker;
+
+/// Unit test and benchmark for the map tile cache worker and the in memory tile cache.
+///
+/// The benchmarks only run with --unittest-benchmark. The throughput benchmark fills a fresh cache with small tiles
+/// through the worker and then measures random fetches against it. It uses 100000 tiles by default, set
+/// QGC_TILE_CACHE_BENCHMARK_TILES to run it against a bigger cache (for example 1000000). Tile set creation is timed
+/// against a region of QGC_TILE_SET_BENCHMARK_TILES tiles (default 10000).
+class QGCTileCacheTest : public UnitTest
+{
+    Q_OBJECT
+
+public:
+    QGCTileCacheTest(void);
+
+private slots:
+    void _saveFetch_test(void);
+    void _memCache_test(void);
+    void _totals_test(void);
+    void _createTileSet_test(void);
+    void _keyUpgrade_test(void);
+    void _throughput_benchmark(void);
+    void _createTileSet_benchmark(void);
+
+private:
+    bool    _startWorker    (QGCCacheWorker& worker, const QString& name);
+    void    _saveTiles      (QGCCacheWorker& worker, int first, int count);
+    bool    _fetchTiles     (QGCCacheWorker& worker, const QList<quint64>& keys, QHash<quint64, QByteArray>* tiles);
+    bool    _waitForCount   (QAtomicInt& counter, int count, int msecs);
+    void    _createTileSet  (int regionTiles, qint64* createMsecs);
+
+    static quint64      _tileKey    (int index);
+    static QByteArray   _tileImage  (int index);
+
+    QTemporaryDir   _tempDir;
+
+    static const int _defaultBenchmarkTiles =   100000;
+    static const int _defaultTileSetTiles =     10000;
+    static const int _testTileSetTiles =        400;
+    static const int _benchmarkFetches =        10000;
+    static const int _saveChunk =               10000;
+    static const int _taskTimeoutMsecs =        60000;
+};
+
+#endif
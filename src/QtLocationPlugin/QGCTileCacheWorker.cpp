@@ -39,9 +39,32 @@ QGC_LOGGING_CATEGORY(QGCTileCacheLog, "QGCTileCacheLog")
 #define LONG_TIMEOUT        5
 #define SHORT_TIMEOUT       2
 
+//-- Cache database schema version (PRAGMA user_version)
+
+#define CACHE_SCHEMA_VERSION    2
+
+//-- Maximum number of tasks run within a single transaction
+
+#define MAX_BATCH_TASKS     256
+
+//-- Indexed by QGCCacheWorker::PreparedStatement
+
+static const char* kPreparedStatements[] = {
+    "SELECT tile, format, type FROM Tiles WHERE tileID = ?",
+    "SELECT setID FROM TileSets WHERE name = ?",
+    "INSERT INTO Tiles(tileID, format, tile, size, type, date) VALUES(?, ?, ?, ?, ?, ?)",
+    "INSERT OR IGNORE INTO SetTiles(tileID, setID) VALUES(?, ?)",
+    "UPDATE TilesDownload SET state = ? WHERE setID = ? AND tileID = ?",
+    "DELETE FROM TilesDownload WHERE setID = ? AND tileID = ?",
+    "INSERT OR IGNORE INTO temp.CreateTiles(tileID) VALUES(?)"
+};
+
 //-----------------------------------------------------------------------------
 QGCCacheWorker::QGCCacheWorker()
-    : _db(NULL)
+    : _session(QString("%1_%2").arg(kSession).arg((quintptr)this))
+    , _db(NULL)
+    , _batchOpen(false)
+    , _batchCount(0)
     , _valid(false)
     , _failed(false)
     , _defaultSet(UINT64_MAX)
@@ -52,7 +75,10 @@ QGCCacheWorker::QGCCacheWorker()
     , _lastUpdate(0)
     , _updateTimeout(SHORT_TIMEOUT)
 {
-
+    Q_ASSERT(sizeof(kPreparedStatements) / sizeof(kPreparedStatements[0]) == StatementCount);
+    for(int i = 0; i < StatementCount; i++) {
+        _preparedQueries[i] = NULL;
+    }
 }
 
 //-----------------------------------------------------------------------------
@@ -117,10 +143,13 @@ QGCCacheWorker::run()
         _init();
     }
     if(_valid) {
-        _db = new QSqlDatabase(QSqlDatabase::addDatabase("QSQLITE", kSession));
+        _db = new QSqlDatabase(QSqlDatabase::addDatabase("QSQLITE", _session));
         _db->setDatabaseName(_databasePath);
         _db->setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
         _valid = _db->open();
+        if(_valid) {
+            _configureConnection();
+        }
     }
     while(true) {
         QGCMapTask* task;
@@ -128,6 +157,16 @@ QGCCacheWorker::run()
             _mutex.lock();
             task = _taskQueue.dequeue();
             _mutex.unlock();
+            //-- Tile saves, fetches and download state updates are run in batches
+            //   within a transaction, anything else runs on its own.
+            bool batchTask = _isBatchTask(task);
+            if(_valid) {
+                if(batchTask) {
+                    _beginBatch();
+                } else {
+                    _endBatch();
+                }
+            }
             switch(task->type()) {
                 case QGCMapTask::taskInit:
                     break;
@@ -160,6 +199,15 @@ QGCCacheWorker::run()
                     break;
             }
             task->deleteLater();
+            //-- Commit the batch once the next task can't join it
+            if(_batchOpen) {
+                _mutex.lock();
+                bool nextInBatch = _taskQueue.count() && _isBatchTask(_taskQueue.head());
+                _mutex.unlock();
+                if(!nextInBatch || _batchCount >= MAX_BATCH_TASKS) {
+                    _endBatch();
+                }
+            }
             //-- Check for update timeout
             size_t count = _taskQueue.count();
             if(count > 100) {
@@ -191,26 +239,111 @@ QGCCacheWorker::run()
         }
     }
     if(_db) {
+        _endBatch();
+        _clearPreparedQueries();
         delete _db;
         _db = NULL;
-        QSqlDatabase::removeDatabase(kSession);
+        QSqlDatabase::removeDatabase(_session);
     }
 }
+
 //-----------------------------------------------------------------------------
-bool
-QGCCacheWorker::_findTileSetID(const QString name, quint64& setID)
+void
+QGCCacheWorker::_configureConnection()
 {
     QSqlQuery query(*_db);
-    QString s = QString("SELECT setID FROM TileSets WHERE name = \"%1\"").arg(name);
-    if(query.exec(s)) {
-        if(query.next()) {
-            setID = query.value(0).toULongLong();
-            return true;
+    //-- Write ahead logging so reads are not blocked behind writes and commits don't rewrite the database.
+    //   With WAL, synchronous NORMAL is still safe from corruption, only the last commits may be lost on power loss.
+    if(!query.exec("PRAGMA journal_mode=WAL")) {
+        qWarning() << "Map Cache SQL error (journal mode):" << query.lastError().text();
+    }
+    if(!query.exec("PRAGMA synchronous=NORMAL")) {
+        qWarning() << "Map Cache SQL error (synchronous mode):" << query.lastError().text();
+    }
+    //-- Staging table for new tile sets (see _addTileSetTiles()). Temporary tables only live as long as the connection.
+    if(!query.exec("CREATE TEMP TABLE IF NOT EXISTS CreateTiles (tileID INTEGER PRIMARY KEY NOT NULL)")) {
+        qWarning() << "Map Cache SQL error (create CreateTiles):" << query.lastError().text();
+    }
+}
+
+//-----------------------------------------------------------------------------
+QSqlQuery*
+QGCCacheWorker::_preparedQuery(PreparedStatement statement)
+{
+    if(!_preparedQueries[statement]) {
+        QSqlQuery* query = new QSqlQuery(*_db);
+        if(!query->prepare(kPreparedStatements[statement])) {
+            qWarning() << "Map Cache SQL error (prepare):" << kPreparedStatements[statement] << query->lastError().text();
         }
+        _preparedQueries[statement] = query;
+    }
+    return _preparedQueries[statement];
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCCacheWorker::_clearPreparedQueries()
+{
+    for(int i = 0; i < StatementCount; i++) {
+        delete _preparedQueries[i];
+        _preparedQueries[i] = NULL;
+    }
+}
+
+//-----------------------------------------------------------------------------
+bool
+QGCCacheWorker::_isBatchTask(QGCMapTask* task)
+{
+    switch(task->type()) {
+        case QGCMapTask::taskCacheTile:
+        case QGCMapTask::taskFetchTile:
+        case QGCMapTask::taskUpdateTileDownloadState:
+            return true;
+        default:
+            break;
     }
     return false;
 }
 
+//-----------------------------------------------------------------------------
+void
+QGCCacheWorker::_beginBatch()
+{
+    if(!_batchOpen) {
+        _batchOpen = _db->transaction();
+        _batchCount = 0;
+    }
+    _batchCount++;
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCCacheWorker::_endBatch()
+{
+    if(_batchOpen) {
+        if(!_db->commit()) {
+            qWarning() << "Map Cache SQL error (commit):" << _db->lastError().text();
+        }
+        _batchOpen = false;
+    }
+}
+//-----------------------------------------------------------------------------
+bool
+QGCCacheWorker::_findTileSetID(const QString name, quint64& setID)
+{
+    bool found = false;
+    QSqlQuery* query = _preparedQuery(StatementFindTileSetID);
+    query->bindValue(0, name);
+    if(query->exec()) {
+        if(query->next()) {
+            setID = query->value(0).toULongLong();
+            found = true;
+        }
+    }
+    query->finish();
+    return found;
+}
+
 //-----------------------------------------------------------------------------
 quint64
 QGCCacheWorker::_getDefaultTileSet()
@@ -234,23 +367,24 @@ QGCCacheWorker::_saveTile(QGCMapTask *mtask)
 {
     if(_valid) {
         QGCSaveTileTask* task = static_cast<QGCSaveTileTask*>(mtask);
-        QSqlQuery query(*_db);
-        query.prepare("INSERT INTO Tiles(hash, format, tile, size, type, date) VALUES(?, ?, ?, ?, ?, ?)");
-        query.addBindValue(task->tile()->hash());
-        query.addBindValue(task->tile()->format());
-        query.addBindValue(task->tile()->img());
-        query.addBindValue(task->tile()->img().size());
-        query.addBindValue(task->tile()->type());
-        query.addBindValue(QDateTime::currentDateTime().toTime_t());
-        if(query.exec()) {
-            quint64 tileID = query.lastInsertId().toULongLong();
+        QByteArray img = task->tile()->img();
+        QSqlQuery* query = _preparedQuery(StatementInsertTile);
+        query->bindValue(0, (qint64)task->tile()->key());
+        query->bindValue(1, task->tile()->format());
+        query->bindValue(2, img);
+        query->bindValue(3, img.size());
+        query->bindValue(4, task->tile()->type());
+        query->bindValue(5, QDateTime::currentDateTime().toTime_t());
+        if(query->exec()) {
+            quint64 tileID = task->tile()->key();
             quint64 setID = task->tile()->set() == UINT64_MAX ? _getDefaultTileSet() : task->tile()->set();
-            QString s = QString("INSERT INTO SetTiles(tileID, setID) VALUES(%1, %2)").arg(tileID).arg(setID);
-            query.prepare(s);
-            if(!query.exec()) {
-                qWarning() << "Map Cache SQL error (add tile into SetTiles):" << query.lastError().text();
+            QSqlQuery* setQuery = _preparedQuery(StatementInsertSetTile);
+            setQuery->bindValue(0, (qint64)tileID);
+            setQuery->bindValue(1, setID);
+            if(!setQuery->exec()) {
+                qWarning() << "Map Cache SQL error (add tile into SetTiles):" << setQuery->lastError().text();
             }
-            qCDebug(QGCTileCacheLog) << "_saveTile() HASH:" << task->tile()->hash();
+            qCDebug(QGCTileCacheLog) << "_saveTile() KEY:" << tileID;
         } else {
             //-- Tile was already there.
             //   QtLocation some times requests the same tile twice in a row. The first is saved, the second is already there.
@@ -270,21 +404,22 @@ QGCCacheWorker::_getTile(QGCMapTask* mtask)
     }
     bool found = false;
     QGCFetchTileTask* task = static_cast<QGCFetchTileTask*>(mtask);
-    QSqlQuery query(*_db);
-    QString s = QString("SELECT tile, format, type FROM Tiles WHERE hash = \"%1\"").arg(task->hash());
-    if(query.exec(s)) {
-        if(query.next()) {
-            QByteArray ar   = query.value(0).toByteArray();
-            QString format  = query.value(1).toString();
-            UrlFactory::MapType type = (UrlFactory::MapType)query.value(2).toInt();
-            qCDebug(QGCTileCacheLog) << "_getTile() (Found in DB) HASH:" << task->hash();
-            QGCCacheTile* tile = new QGCCacheTile(task->hash(), ar, format, type);
+    QSqlQuery* query = _preparedQuery(StatementGetTile);
+    query->bindValue(0, (qint64)task->key());
+    if(query->exec()) {
+        if(query->next()) {
+            QByteArray ar   = query->value(0).toByteArray();
+            QString format  = query->value(1).toString();
+            UrlFactory::MapType type = (UrlFactory::MapType)query->value(2).toInt();
+            qCDebug(QGCTileCacheLog) << "_getTile() (Found in DB) KEY:" << task->key();
+            QGCCacheTile* tile = new QGCCacheTile(task->key(), ar, format, type);
             task->setTileFetched(tile);
             found = true;
         }
     }
+    query->finish();
     if(!found) {
-        qCDebug(QGCTileCacheLog) << "_getTile() (NOT in DB) HASH:" << task->hash();
+        qCDebug(QGCTileCacheLog) << "_getTile() (NOT in DB) KEY:" << task->key();
         task->setError("Tile not in cache database");
     }
 }
@@ -339,8 +474,9 @@ QGCCacheWorker::_updateSetTotals(QGCCachedTileSet* set)
         set->setTotalTileSize(_defaultSize);
         return;
     }
+    //-- Totals are maintained by triggers as tiles are added and removed (see _tileTotalsUpgrade())
     QSqlQuery subquery(*_db);
-    QString sq = QString("SELECT COUNT(size), SUM(size) FROM Tiles A INNER JOIN SetTiles B on A.tileID = B.tileID WHERE B.setID = %1").arg(set->id());
+    QString sq = QString("SELECT savedTiles, savedSize, uniqueTiles, uniqueSize FROM TileSets WHERE setID = %1").arg(set->id());
     qCDebug(QGCTileCacheLog) << "_updateSetTotals(): " << sq;
     if(subquery.exec(sq)) {
         if(subquery.next()) {
@@ -360,16 +496,9 @@ QGCCacheWorker::_updateSetTotals(QGCCachedTileSet* set)
                 set->setTotalTileSize(avg * set->totalTileCount());
             }
             //-- Now figure out the count for tiles unique to this set
-            quint32 ucount = 0;
-            quint64 usize  = 0;
-            sq = QString("SELECT COUNT(size), SUM(size) FROM Tiles WHERE tileID IN (SELECT A.tileID FROM SetTiles A join SetTiles B on A.tileID = B.tileID WHERE B.setID = %1 GROUP by A.tileID HAVING COUNT(A.tileID) = 1)").arg(set->id());
-            if(subquery.exec(sq)) {
-                if(subquery.next()) {
-                    //-- This is only accurate when all tiles are downloaded
-                    ucount = subquery.value(0).toUInt();
-                    usize  = subquery.value(1).toULongLong();
-                }
-            }
+            //   This is only accurate when all tiles are downloaded
+            quint32 ucount = subquery.value(2).toUInt();
+            quint64 usize  = subquery.value(3).toULongLong();
             //-- If we haven't downloaded it all, estimate size of unique tiles
             quint32 expectedUcount = set->totalTileCount() - set->savedTileCount();
             if(!ucount) {
@@ -389,7 +518,7 @@ QGCCacheWorker::_updateTotals()
 {
     QSqlQuery query(*_db);
     QString s;
-    s = QString("SELECT COUNT(size), SUM(size) FROM Tiles");
+    s = QString("SELECT tileCount, tileSize FROM TilesTotals");
     qCDebug(QGCTileCacheLog) << "_updateTotals(): " << s;
     if(query.exec(s)) {
         if(query.next()) {
@@ -397,7 +526,7 @@ QGCCacheWorker::_updateTotals()
             _totalSize  = query.value(1).toULongLong();
         }
     }
-    s = QString("SELECT COUNT(size), SUM(size) FROM Tiles WHERE tileID IN (SELECT A.tileID FROM SetTiles A join SetTiles B on A.tileID = B.tileID WHERE B.setID = %1 GROUP by A.tileID HAVING COUNT(A.tileID) = 1)").arg(_getDefaultTileSet());
+    s = QString("SELECT uniqueTiles, uniqueSize FROM TileSets WHERE setID = %1").arg(_getDefaultTileSet());
     qCDebug(QGCTileCacheLog) << "_updateTotals(): " << s;
     if(query.exec(s)) {
         if(query.next()) {
@@ -409,20 +538,6 @@ QGCCacheWorker::_updateTotals()
     _lastUpdate = time(0);
 }
 
-//-----------------------------------------------------------------------------
-quint64 QGCCacheWorker::_findTile(const QString hash)
-{
-    quint64 tileID = 0;
-    QSqlQuery query(*_db);
-    QString s = QString("SELECT tileID FROM Tiles WHERE hash = \"%1\"").arg(hash);
-    if(query.exec(s)) {
-        if(query.next()) {
-            tileID = query.value(0).toULongLong();
-        }
-    }
-    return tileID;
-}
-
 //-----------------------------------------------------------------------------
 void
 QGCCacheWorker::_createTileSet(QGCMapTask *mtask)
@@ -431,6 +546,8 @@ QGCCacheWorker::_createTileSet(QGCMapTask *mtask)
         //-- Create Tile Set
         quint32 actual_count = 0;
         QGCCreateTileSetTask* task = static_cast<QGCCreateTileSetTask*>(mtask);
+        //-- The set and its whole download list are created in a single transaction
+        _db->transaction();
         QSqlQuery query(*_db);
         query.prepare("INSERT INTO TileSets("
             "name, typeStr, topleftLat, topleftLon, bottomRightLat, bottomRightLon, minZoom, maxZoom, type, numTiles, date"
@@ -448,51 +565,30 @@ QGCCacheWorker::_createTileSet(QGCMapTask *mtask)
         query.addBindValue(QDateTime::currentDateTime().toTime_t());
         if(!query.exec()) {
             qWarning() << "Map Cache SQL error (add tileSet into TileSets):" << query.lastError().text();
+            _db->rollback();
         } else {
             //-- Get just created (auto-incremented) setID
             quint64 setID = query.lastInsertId().toULongLong();
             task->tileSet()->setId(setID);
             //-- Prepare Download List
-            quint64 tileCount = 0;
             for(int z = task->tileSet()->minZoom(); z <= task->tileSet()->maxZoom(); z++) {
                 QGCTileSet set = QGCMapEngine::getTileCount(z,
                     task->tileSet()->topleftLon(), task->tileSet()->topleftLat(),
                     task->tileSet()->bottomRightLon(), task->tileSet()->bottomRightLat(), task->tileSet()->type());
-                tileCount += set.tileCount;
-                UrlFactory::MapType type = task->tileSet()->type();
-                for(int x = set.tileX0; x <= set.tileX1; x++) {
-                    for(int y = set.tileY0; y <= set.tileY1; y++) {
-                        //-- See if tile is already downloaded
-                        QString hash = QGCMapEngine::getTileHash(type, x, y, z);
-                        quint64 tileID = _findTile(hash);
-                        if(!tileID) {
-                            //-- Set to download
-                            query.prepare("INSERT OR IGNORE INTO TilesDownload(setID, hash, type, x, y, z, state) VALUES(?, ?, ?, ?, ? ,? ,?)");
-                            query.addBindValue(setID);
-                            query.addBindValue(hash);
-                            query.addBindValue(type);
-                            query.addBindValue(x);
-                            query.addBindValue(y);
-                            query.addBindValue(z);
-                            query.addBindValue(0);
-                            if(!query.exec()) {
-                                qWarning() << "Map Cache SQL error (add tile into TilesDownload):" << query.lastError().text();
-                                mtask->setError("Error creating tile set download list");
-                                return;
-                            } else
-                                actual_count++;
-                        } else {
-                            //-- Tile already in the database. No need to dowload.
-                            QString s = QString("INSERT OR IGNORE INTO SetTiles(tileID, setID) VALUES(%1, %2)").arg(tileID).arg(setID);
-                            query.prepare(s);
-                            if(!query.exec()) {
-                                qWarning() << "Map Cache SQL error (add tile into SetTiles):" << query.lastError().text();
-                            }
-                            qCDebug(QGCTileCacheLog) << "_createTileSet() Already Cached HASH:" << hash;
-                        }
-                    }
+                quint32 count = 0;
+                if(!_addTileSetTiles(setID, task->tileSet()->type(), z, set, count)) {
+                    _db->rollback();
+                    mtask->setError("Error creating tile set download list");
+                    return;
                 }
+                actual_count += count;
             }
+            if(!_db->commit()) {
+                qWarning() << "Map Cache SQL error (commit tile set):" << _db->lastError().text();
+                mtask->setError("Error saving tile set");
+                return;
+            }
+            qCDebug(QGCTileCacheLog) << "_createTileSet() Set" << setID << "tiles to download:" << actual_count;
             //-- Done
             _updateSetTotals(task->tileSet());
             task->setTileSetSaved();
@@ -502,6 +598,47 @@ QGCCacheWorker::_createTileSet(QGCMapTask *mtask)
     mtask->setError("Error saving tile set");
 }
 
+//-----------------------------------------------------------------------------
+// Adds the tiles of one zoom level to a new tile set. Instead of looking up each tile on its own, all tiles of
+// the level are staged in the temporary CreateTiles table, then the ones already cached are added to the set and
+// the rest to the download list with one set based query each. Must be called within a transaction.
+bool
+QGCCacheWorker::_addTileSetTiles(quint64 setID, UrlFactory::MapType type, int z, const QGCTileSet& set, quint32& count)
+{
+    QSqlQuery query(*_db);
+    if(!query.exec("DELETE FROM temp.CreateTiles")) {
+        qWarning() << "Map Cache SQL error (clear CreateTiles):" << query.lastError().text();
+        return false;
+    }
+    QSqlQuery* stageQuery = _preparedQuery(StatementInsertCreateTile);
+    for(int x = set.tileX0; x <= set.tileX1; x++) {
+        for(int y = set.tileY0; y <= set.tileY1; y++) {
+            stageQuery->bindValue(0, (qint64)QGCMapEngine::getTileKey(type, x, y, z));
+            if(!stageQuery->exec()) {
+                qWarning() << "Map Cache SQL error (add tile into CreateTiles):" << stageQuery->lastError().text();
+                return false;
+            }
+        }
+    }
+    stageQuery->finish();
+    //-- Tiles already in the database. No need to dowload.
+    QString s = QString("INSERT OR IGNORE INTO SetTiles(tileID, setID) SELECT B.tileID, %1 FROM temp.CreateTiles A JOIN Tiles B ON A.tileID = B.tileID").arg(setID);
+    if(!query.exec(s)) {
+        qWarning() << "Map Cache SQL error (add tiles into SetTiles):" << query.lastError().text();
+        return false;
+    }
+    qCDebug(QGCTileCacheLog) << "_addTileSetTiles() Zoom" << z << "already cached:" << query.numRowsAffected();
+    //-- Set the rest to download
+    s = QString("INSERT OR IGNORE INTO TilesDownload(setID, tileID, state) "
+                "SELECT %1, tileID, 0 FROM temp.CreateTiles A WHERE NOT EXISTS (SELECT 1 FROM Tiles B WHERE B.tileID = A.tileID)").arg(setID);
+    if(!query.exec(s)) {
+        qWarning() << "Map Cache SQL error (add tiles into TilesDownload):" << query.lastError().text();
+        return false;
+    }
+    count = query.numRowsAffected();
+    return true;
+}
+
 //-----------------------------------------------------------------------------
 void
 QGCCacheWorker::_getTileDownloadList(QGCMapTask* mtask)
@@ -513,24 +650,32 @@ QGCCacheWorker::_getTileDownloadList(QGCMapTask* mtask)
     QList<QGCTile*> tiles;
     QGCGetTileDownloadListTask* task = static_cast<QGCGetTileDownloadListTask*>(mtask);
     QSqlQuery query(*_db);
-    QString s = QString("SELECT hash, type, x, y, z FROM TilesDownload WHERE setID = %1 AND state = 0 LIMIT %2").arg(task->setID()).arg(task->count());
+    //-- Fetch the next tiles and flag them as downloading in one go
+    _db->transaction();
+    QString s = QString("SELECT tileID FROM TilesDownload WHERE setID = %1 AND state = 0 ORDER BY rowid LIMIT %2").arg(task->setID()).arg(task->count());
     if(query.exec(s)) {
         while(query.next()) {
+            //-- Type and coordinates are packed in the tile key
+            quint64 key = query.value(0).toULongLong();
+            int x, y, z;
+            QGCMapEngine::getTileFromKey(key, x, y, z);
             QGCTile* tile = new QGCTile;
-            tile->setHash(query.value("hash").toString());
-            tile->setType((UrlFactory::MapType)query.value("type").toInt());
-            tile->setX(query.value("x").toInt());
-            tile->setY(query.value("y").toInt());
-            tile->setZ(query.value("z").toInt());
+            tile->setKey(key);
+            tile->setType(QGCMapEngine::getTypeFromKey(key));
+            tile->setX(x);
+            tile->setY(y);
+            tile->setZ(z);
             tiles.append(tile);
         }
-        for(int i = 0; i < tiles.size(); i++) {
-            s = QString("UPDATE TilesDownload SET state = %1 WHERE setID = %2 and hash = \"%3\"").arg((int)QGCTile::StateDownloading).arg(task->setID()).arg(tiles[i]->hash());
+        if(tiles.size()) {
+            s = QString("UPDATE TilesDownload SET state = %1 WHERE rowid IN (SELECT rowid FROM TilesDownload WHERE setID = %2 AND state = 0 ORDER BY rowid LIMIT %3)")
+                .arg((int)QGCTile::StateDownloading).arg(task->setID()).arg(tiles.size());
             if(!query.exec(s)) {
                 qWarning() << "Map Cache SQL error (set TilesDownload state):" << query.lastError().text();
             }
         }
     }
+    _db->commit();
     task->setTileListFetched(tiles);
 }
 
@@ -543,20 +688,31 @@ QGCCacheWorker::_updateTileDownloadState(QGCMapTask* mtask)
         return;
     }
     QGCUpdateTileDownloadStateTask* task = static_cast<QGCUpdateTileDownloadStateTask*>(mtask);
-    QSqlQuery query(*_db);
-    QString s;
+    QSqlQuery* query;
     if(task->state() == QGCTile::StateComplete) {
-        s = QString("DELETE FROM TilesDownload WHERE setID = %1 AND hash = \"%2\"").arg(task->setID()).arg(task->hash());
+        query = _preparedQuery(StatementDeleteTileDownload);
+        query->bindValue(0, task->setID());
+        query->bindValue(1, (qint64)task->key());
+        if(!query->exec()) {
+            qWarning() << "QGCCacheWorker::_updateTileDownloadState() Error:" << query->lastError().text();
+        }
     } else {
-        if(task->hash() == "*") {
-            s = QString("UPDATE TilesDownload SET state = %1 WHERE setID = %2").arg((int)task->state()).arg(task->setID());
+        if(task->key() == UINT64_MAX) {
+            QSqlQuery allQuery(*_db);
+            QString s = QString("UPDATE TilesDownload SET state = %1 WHERE setID = %2").arg((int)task->state()).arg(task->setID());
+            if(!allQuery.exec(s)) {
+                qWarning() << "QGCCacheWorker::_updateTileDownloadState() Error:" << allQuery.lastError().text();
+            }
         } else {
-            s = QString("UPDATE TilesDownload SET state = %1 WHERE setID = %2 AND hash = \"%3\"").arg((int)task->state()).arg(task->setID()).arg(task->hash());
+            query = _preparedQuery(StatementSetTileDownloadState);
+            query->bindValue(0, (int)task->state());
+            query->bindValue(1, task->setID());
+            query->bindValue(2, (qint64)task->key());
+            if(!query->exec()) {
+                qWarning() << "QGCCacheWorker::_updateTileDownloadState() Error:" << query->lastError().text();
+            }
         }
     }
-    if(!query.exec(s)) {
-        qWarning() << "QGCCacheWorker::_updateTileDownloadState() Error:" << query.lastError().text();
-    }
 }
 
 //-----------------------------------------------------------------------------
@@ -571,22 +727,24 @@ QGCCacheWorker::_pruneCache(QGCMapTask* mtask)
     QSqlQuery query(*_db);
     QString s;
     //-- Select tiles in default set only, sorted by oldest.
-    s = QString("SELECT tileID, size, hash FROM Tiles WHERE tileID IN (SELECT A.tileID FROM SetTiles A join SetTiles B on A.tileID = B.tileID WHERE B.setID = %1 GROUP by A.tileID HAVING COUNT(A.tileID) = 1) ORDER BY DATE ASC LIMIT 128").arg(_getDefaultTileSet());
+    s = QString("SELECT A.tileID, A.size FROM Tiles A JOIN SetTiles B ON A.tileID = B.tileID WHERE B.setID = %1 AND A.setCount = 1 ORDER BY A.date ASC LIMIT 128").arg(_getDefaultTileSet());
     qint64 amount = (qint64)task->amount();
     QList<quint64> tlist;
+    QList<quint64> pruned;
     if(query.exec(s)) {
         while(query.next() && amount >= 0) {
             tlist << query.value(0).toULongLong();
             amount -= query.value(1).toULongLong();
-            qCDebug(QGCTileCacheLog) << "_pruneCache() HASH:" << query.value(2).toString();
+            qCDebug(QGCTileCacheLog) << "_pruneCache() KEY:" << query.value(0).toULongLong();
         }
         while(tlist.count()) {
             s = QString("DELETE FROM Tiles WHERE tileID = %1").arg(tlist[0]);
-            tlist.removeFirst();
             if(!query.exec(s))
                 break;
+            pruned << tlist.takeFirst();
         }
-        task->setPruned();
+        //-- The tile keys are the same as the memory cache keys, the engine evicts them from there too
+        task->setPruned(pruned);
     }
 }
 
@@ -601,15 +759,19 @@ QGCCacheWorker::_deleteTileSet(QGCMapTask* mtask)
     QGCDeleteTileSetTask* task = static_cast<QGCDeleteTileSetTask*>(mtask);
     QSqlQuery query(*_db);
     QString s;
+    _db->transaction();
     //-- Only delete tiles unique to this set
-    s = QString("DELETE FROM Tiles WHERE tileID IN (SELECT A.tileID FROM SetTiles A JOIN SetTiles B ON A.tileID = B.tileID WHERE B.setID = %1 GROUP BY A.tileID HAVING COUNT(A.tileID) = 1)").arg(task->setID());
+    s = QString("DELETE FROM Tiles WHERE tileID IN (SELECT tileID FROM SetTiles WHERE setID = %1) AND setCount = 1").arg(task->setID());
     query.exec(s);
     s = QString("DELETE FROM TilesDownload WHERE setID = %1").arg(task->setID());
     query.exec(s);
-    s = QString("DELETE FROM TileSets WHERE setID = %1").arg(task->setID());
-    query.exec(s);
+    //-- Drop the set's references to shared tiles before the set itself, so the triggers
+    //   update the totals of the sets which still hold them.
     s = QString("DELETE FROM SetTiles WHERE setID = %1").arg(task->setID());
     query.exec(s);
+    s = QString("DELETE FROM TileSets WHERE setID = %1").arg(task->setID());
+    query.exec(s);
+    _db->commit();
     _updateTotals();
     task->setTileSetDeleted();
 }
@@ -622,6 +784,8 @@ QGCCacheWorker::_resetCacheDatabase(QGCMapTask* mtask)
         return;
     }
     QGCResetTask* task = static_cast<QGCResetTask*>(mtask);
+    //-- Statements referencing the dropped tables must not be kept around
+    _clearPreparedQueries();
     QSqlQuery query(*_db);
     QString s;
     s = QString("DROP TABLE Tiles");
@@ -632,6 +796,9 @@ QGCCacheWorker::_resetCacheDatabase(QGCMapTask* mtask)
     query.exec(s);
     s = QString("DROP TABLE TilesDownload");
     query.exec(s);
+    s = QString("DROP TABLE TilesTotals");
+    query.exec(s);
+    query.exec("PRAGMA user_version = 0");
     _createDB();
     task->setResetCompleted();
 }
@@ -644,7 +811,7 @@ QGCCacheWorker::_init()
     if(!_databasePath.isEmpty()) {
         qCDebug(QGCTileCacheLog) << "Mapping cache directory:" << _databasePath;
         //-- Initialize Database
-        _db = new QSqlDatabase(QSqlDatabase::addDatabase("QSQLITE", kSession));
+        _db = new QSqlDatabase(QSqlDatabase::addDatabase("QSQLITE", _session));
         _db->setDatabaseName(_databasePath);
         _db->setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
         if (_db->open()) {
@@ -655,7 +822,7 @@ QGCCacheWorker::_init()
         }
         delete _db;
         _db = NULL;
-        QSqlDatabase::removeDatabase(kSession);
+        QSqlDatabase::removeDatabase(_session);
     } else {
         qCritical() << "Could not find suitable cache directory.";
         _failed = true;
@@ -671,12 +838,12 @@ QGCCacheWorker::_createDB()
     if(!query.exec(
         "CREATE TABLE IF NOT EXISTS Tiles ("
         "tileID INTEGER PRIMARY KEY NOT NULL, "
-        "hash TEXT NOT NULL UNIQUE, "
         "format TEXT NOT NULL, "
         "tile BLOB NULL, "
         "size INTEGER, "
         "type INTEGER, "
-        "date INTEGER DEFAULT 0)"))
+        "date INTEGER DEFAULT 0, "
+        "setCount INTEGER DEFAULT 0)"))
     {
         qWarning() << "Map Cache SQL error (create Tiles db):" << query.lastError().text();
     } else {
@@ -694,7 +861,11 @@ QGCCacheWorker::_createDB()
             "type INTEGER DEFAULT -1, "
             "numTiles INTEGER DEFAULT 0, "
             "defaultSet INTEGER DEFAULT 0, "
-            "date INTEGER DEFAULT 0)"))
+            "date INTEGER DEFAULT 0, "
+            "savedTiles INTEGER DEFAULT 0, "
+            "savedSize INTEGER DEFAULT 0, "
+            "uniqueTiles INTEGER DEFAULT 0, "
+            "uniqueSize INTEGER DEFAULT 0)"))
         {
             qWarning() << "Map Cache SQL error (create TileSets db):" << query.lastError().text();
         } else {
@@ -708,17 +879,13 @@ QGCCacheWorker::_createDB()
                 if(!query.exec(
                     "CREATE TABLE IF NOT EXISTS TilesDownload ("
                     "setID INTEGER, "
-                    "hash TEXT NOT NULL UNIQUE, "
-                    "type INTEGER, "
-                    "x INTEGER, "
-                    "y INTEGER, "
-                    "z INTEGER, "
+                    "tileID INTEGER NOT NULL UNIQUE, "
                     "state INTEGER DEFAULT 0)"))
                 {
                     qWarning() << "Map Cache SQL error (create TilesDownload db):" << query.lastError().text();
                 } else {
                     //-- Database it ready for use
-                    _valid = true;
+                    _valid = _upgradeDB();
                 }
             }
         }
@@ -747,3 +914,196 @@ QGCCacheWorker::_createDB()
     }
     _failed = !_valid;
 }
+
+//-----------------------------------------------------------------------------
+bool
+QGCCacheWorker::_hasColumn(const QString& table, const QString& column)
+{
+    QSqlQuery query(*_db);
+    if(query.exec(QString("PRAGMA table_info(%1)").arg(table))) {
+        while(query.next()) {
+            if(query.value("name").toString() == column) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+bool
+QGCCacheWorker::_upgradeDB()
+{
+    QSqlQuery query(*_db);
+    int version = 0;
+    if(query.exec("PRAGMA user_version") && query.next()) {
+        version = query.value(0).toInt();
+    }
+    if(version >= CACHE_SCHEMA_VERSION) {
+        return true;
+    }
+    qCDebug(QGCTileCacheLog) << "Upgrading map cache schema from version" << version << "to" << CACHE_SCHEMA_VERSION;
+    QStringList statements;
+    if(version < 1) {
+        statements << _tileTotalsUpgrade();
+    }
+    if(version < 2) {
+        statements << _tileKeyUpgrade();
+    }
+    statements << QString("PRAGMA user_version = %1").arg(CACHE_SCHEMA_VERSION);
+    _db->transaction();
+    foreach(const QString& statement, statements) {
+        if(!query.exec(statement)) {
+            qWarning() << "Map Cache SQL error (upgrade schema):" << statement << query.lastError().text();
+            _db->rollback();
+            return false;
+        }
+    }
+    return _db->commit();
+}
+
+//-----------------------------------------------------------------------------
+// Schema version 1: Tile counts and sizes for the whole cache and for each tile set are kept up to date by
+// triggers as tiles and set references are added and removed. Tiles.setCount is the number of sets holding a
+// tile, a tile is unique to a set when it is 1.
+QStringList
+QGCCacheWorker::_tileTotalsUpgrade()
+{
+    QStringList statements;
+    if(!_hasColumn("Tiles", "setCount")) {
+        statements << "ALTER TABLE Tiles ADD COLUMN setCount INTEGER DEFAULT 0";
+    }
+    const char* setColumns[] = { "savedTiles", "savedSize", "uniqueTiles", "uniqueSize" };
+    for(size_t i = 0; i < sizeof(setColumns) / sizeof(setColumns[0]); i++) {
+        if(!_hasColumn("TileSets", setColumns[i])) {
+            statements << QString("ALTER TABLE TileSets ADD COLUMN %1 INTEGER DEFAULT 0").arg(setColumns[i]);
+        }
+    }
+    statements
+        //-- Older versions left set references behind when pruning tiles, and allowed duplicates
+        << "DELETE FROM SetTiles WHERE tileID NOT IN (SELECT tileID FROM Tiles)"
+        << "DELETE FROM SetTiles WHERE rowid NOT IN (SELECT MIN(rowid) FROM SetTiles GROUP BY tileID, setID)"
+        << "CREATE UNIQUE INDEX IF NOT EXISTS SetTilesTileIndex ON SetTiles(tileID, setID)"
+        << "CREATE INDEX IF NOT EXISTS SetTilesSetIndex ON SetTiles(setID)"
+        << "CREATE TABLE IF NOT EXISTS TilesTotals ("
+           "id INTEGER PRIMARY KEY NOT NULL, "
+           "tileCount INTEGER DEFAULT 0, "
+           "tileSize INTEGER DEFAULT 0)"
+        //-- One time aggregation of what is already in the cache
+        << "UPDATE Tiles SET setCount = (SELECT COUNT(*) FROM SetTiles WHERE SetTiles.tileID = Tiles.tileID)"
+        << "INSERT OR REPLACE INTO TilesTotals(id, tileCount, tileSize) SELECT 0, COUNT(*), IFNULL(SUM(size), 0) FROM Tiles"
+        << "UPDATE TileSets SET "
+           "savedTiles  = (SELECT COUNT(*) FROM SetTiles A JOIN Tiles B ON A.tileID = B.tileID WHERE A.setID = TileSets.setID), "
+           "savedSize   = (SELECT IFNULL(SUM(B.size), 0) FROM SetTiles A JOIN Tiles B ON A.tileID = B.tileID WHERE A.setID = TileSets.setID), "
+           "uniqueTiles = (SELECT COUNT(*) FROM SetTiles A JOIN Tiles B ON A.tileID = B.tileID WHERE A.setID = TileSets.setID AND B.setCount = 1), "
+           "uniqueSize  = (SELECT IFNULL(SUM(B.size), 0) FROM SetTiles A JOIN Tiles B ON A.tileID = B.tileID WHERE A.setID = TileSets.setID AND B.setCount = 1)";
+    statements << _tileTotalsTriggers();
+    return statements;
+}
+
+//-----------------------------------------------------------------------------
+QStringList
+QGCCacheWorker::_tileTotalsTriggers()
+{
+    QStringList statements;
+    statements
+        //-- Cache totals
+        << "CREATE TRIGGER IF NOT EXISTS TilesInsert AFTER INSERT ON Tiles BEGIN "
+           "UPDATE TilesTotals SET tileCount = tileCount + 1, tileSize = tileSize + IFNULL(NEW.size, 0) WHERE id = 0; "
+           "END"
+        //-- A deleted tile is removed from all the sets holding it. The set references are deleted after the tile,
+        //   so the SetTiles trigger does not count them a second time.
+        << "CREATE TRIGGER IF NOT EXISTS TilesDelete AFTER DELETE ON Tiles BEGIN "
+           "UPDATE TileSets SET "
+           "savedTiles = savedTiles - 1, "
+           "savedSize = savedSize - IFNULL(OLD.size, 0), "
+           "uniqueTiles = uniqueTiles - (OLD.setCount = 1), "
+           "uniqueSize = uniqueSize - (CASE WHEN OLD.setCount = 1 THEN IFNULL(OLD.size, 0) ELSE 0 END) "
+           "WHERE setID IN (SELECT setID FROM SetTiles WHERE tileID = OLD.tileID); "
+           "DELETE FROM SetTiles WHERE tileID = OLD.tileID; "
+           "UPDATE TilesTotals SET tileCount = tileCount - 1, tileSize = tileSize - IFNULL(OLD.size, 0) WHERE id = 0; "
+           "END"
+        //-- Set totals
+        << "CREATE TRIGGER IF NOT EXISTS SetTilesInsert AFTER INSERT ON SetTiles "
+           "WHEN EXISTS (SELECT 1 FROM Tiles WHERE tileID = NEW.tileID) BEGIN "
+           "UPDATE Tiles SET setCount = setCount + 1 WHERE tileID = NEW.tileID; "
+           //-- A tile which was unique to another set is now shared
+           "UPDATE TileSets SET "
+           "uniqueTiles = uniqueTiles - 1, "
+           "uniqueSize = uniqueSize - (SELECT IFNULL(size, 0) FROM Tiles WHERE tileID = NEW.tileID) "
+           "WHERE (SELECT setCount FROM Tiles WHERE tileID = NEW.tileID) = 2 "
+           "AND setID IN (SELECT setID FROM SetTiles WHERE tileID = NEW.tileID AND setID != NEW.setID); "
+           "UPDATE TileSets SET "
+           "savedTiles = savedTiles + 1, "
+           "savedSize = savedSize + (SELECT IFNULL(size, 0) FROM Tiles WHERE tileID = NEW.tileID), "
+           "uniqueTiles = uniqueTiles + (SELECT setCount = 1 FROM Tiles WHERE tileID = NEW.tileID), "
+           "uniqueSize = uniqueSize + (SELECT CASE WHEN setCount = 1 THEN IFNULL(size, 0) ELSE 0 END FROM Tiles WHERE tileID = NEW.tileID) "
+           "WHERE setID = NEW.setID; "
+           "END"
+        << "CREATE TRIGGER IF NOT EXISTS SetTilesDelete AFTER DELETE ON SetTiles "
+           "WHEN EXISTS (SELECT 1 FROM Tiles WHERE tileID = OLD.tileID) BEGIN "
+           "UPDATE Tiles SET setCount = setCount - 1 WHERE tileID = OLD.tileID; "
+           "UPDATE TileSets SET "
+           "savedTiles = savedTiles - 1, "
+           "savedSize = savedSize - (SELECT IFNULL(size, 0) FROM Tiles WHERE tileID = OLD.tileID), "
+           "uniqueTiles = uniqueTiles - (SELECT setCount = 0 FROM Tiles WHERE tileID = OLD.tileID), "
+           "uniqueSize = uniqueSize - (SELECT CASE WHEN setCount = 0 THEN IFNULL(size, 0) ELSE 0 END FROM Tiles WHERE tileID = OLD.tileID) "
+           "WHERE setID = OLD.setID; "
+           //-- A tile shared with one other set is now unique to it
+           "UPDATE TileSets SET "
+           "uniqueTiles = uniqueTiles + 1, "
+           "uniqueSize = uniqueSize + (SELECT IFNULL(size, 0) FROM Tiles WHERE tileID = OLD.tileID) "
+           "WHERE (SELECT setCount FROM Tiles WHERE tileID = OLD.tileID) = 1 "
+           "AND setID IN (SELECT setID FROM SetTiles WHERE tileID = OLD.tileID); "
+           "END";
+    return statements;
+}
+
+//-----------------------------------------------------------------------------
+// Schema version 2: Tiles are keyed by QGCMapEngine::getTileKey() instead of by a text hash. The key is the
+// tileID (the table rowid), so tile lookups no longer go through a separate text index. Older caches are
+// converted in place: the key is computed from the "%04d%08d%08d%03d" hash (type, x, y, z) and the set
+// references and download lists are moved over to it.
+QStringList
+QGCCacheWorker::_tileKeyUpgrade()
+{
+    QStringList statements;
+    if(!_hasColumn("Tiles", "hash")) {
+        return statements;
+    }
+    const QString key = QString(
+        "((CAST(substr(hash, 1, 4) AS INTEGER) << 48) | "
+        "(CAST(substr(hash, 21, 3) AS INTEGER) << 40) | "
+        "(CAST(substr(hash, 5, 8) AS INTEGER) << 20) | "
+        "CAST(substr(hash, 13, 8) AS INTEGER))");
+    statements
+        //-- The triggers refer to the tables being replaced
+        << "DROP TRIGGER IF EXISTS TilesInsert"
+        << "DROP TRIGGER IF EXISTS TilesDelete"
+        << "DROP TRIGGER IF EXISTS SetTilesInsert"
+        << "DROP TRIGGER IF EXISTS SetTilesDelete"
+        //-- Keys start at 1 << 48 so they never collide with the old tile IDs while updating
+        << QString("UPDATE SetTiles SET tileID = (SELECT %1 FROM Tiles WHERE Tiles.tileID = SetTiles.tileID)").arg(key)
+        << "CREATE TABLE TilesKeyed ("
+           "tileID INTEGER PRIMARY KEY NOT NULL, "
+           "format TEXT NOT NULL, "
+           "tile BLOB NULL, "
+           "size INTEGER, "
+           "type INTEGER, "
+           "date INTEGER DEFAULT 0, "
+           "setCount INTEGER DEFAULT 0)"
+        << QString("INSERT OR IGNORE INTO TilesKeyed(tileID, format, tile, size, type, date, setCount) "
+                   "SELECT %1, format, tile, size, type, date, setCount FROM Tiles").arg(key)
+        << "DROP TABLE Tiles"
+        << "ALTER TABLE TilesKeyed RENAME TO Tiles"
+        << "CREATE TABLE TilesDownloadKeyed ("
+           "setID INTEGER, "
+           "tileID INTEGER NOT NULL UNIQUE, "
+           "state INTEGER DEFAULT 0)"
+        << QString("INSERT OR IGNORE INTO TilesDownloadKeyed(setID, tileID, state) "
+                   "SELECT setID, %1, state FROM TilesDownload ORDER BY rowid").arg(key)
+        << "DROP TABLE TilesDownload"
+        << "ALTER TABLE TilesDownloadKeyed RENAME TO TilesDownload";
+    statements << _tileTotalsTriggers();
+    return statements;
+}
@@ -20,19 +20,23 @@
 #define QGC_TILE_CACHE_WORKER_H
 
 #include <QString>
+#include <QStringList>
 #include <QThread>
 #include <QQueue>
 #include <QMutex>
 #include <QWaitCondition>
 #include <QMutexLocker>
 #include <QtSql/QSqlDatabase>
+#include <QtSql/QSqlQuery>
 
 #include "QGCLoggingCategory.h"
+#include "QGCMapUrlEngine.h"
 
 Q_DECLARE_LOGGING_CATEGORY(QGCTileCacheLog)
 
 class QGCMapTask;
 class QGCCachedTileSet;
+class QGCTileSet;
 
 //-----------------------------------------------------------------------------
 class QGCCacheWorker : public QThread
@@ -54,19 +58,43 @@ private:
     void        _getTile                (QGCMapTask* mtask);
     void        _getTileSets            (QGCMapTask* mtask);
     void        _createTileSet          (QGCMapTask* mtask);
+    bool        _addTileSetTiles        (quint64 setID, UrlFactory::MapType type, int z, const QGCTileSet& set, quint32& count);
     void        _getTileDownloadList    (QGCMapTask* mtask);
     void        _updateTileDownloadState(QGCMapTask* mtask);
     void        _deleteTileSet          (QGCMapTask* mtask);
     void        _resetCacheDatabase     (QGCMapTask* mtask);
     void        _pruneCache             (QGCMapTask* mtask);
 
-    quint64     _findTile               (const QString hash);
     bool        _findTileSetID          (const QString name, quint64& setID);
     void        _updateSetTotals        (QGCCachedTileSet* set);
     bool        _init                   ();
     void        _createDB               ();
+    bool        _upgradeDB              ();
+    QStringList _tileTotalsUpgrade      ();
+    QStringList _tileTotalsTriggers     ();
+    QStringList _tileKeyUpgrade         ();
+    bool        _hasColumn              (const QString& table, const QString& column);
     quint64     _getDefaultTileSet      ();
     void        _updateTotals           ();
+    void        _configureConnection    ();
+    bool        _isBatchTask            (QGCMapTask* task);
+    void        _beginBatch             ();
+    void        _endBatch               ();
+    void        _clearPreparedQueries   ();
+
+    //-- Statements run for every tile. These are prepared once per connection and reused.
+    enum PreparedStatement {
+        StatementGetTile,
+        StatementFindTileSetID,
+        StatementInsertTile,
+        StatementInsertSetTile,
+        StatementSetTileDownloadState,
+        StatementDeleteTileDownload,
+        StatementInsertCreateTile,
+        StatementCount
+    };
+
+    QSqlQuery*  _preparedQuery          (PreparedStatement statement);
 
 signals:
     void        updateTotals            (quint32 totaltiles, quint64 totalsize, quint32 defaulttiles, quint64 defaultsize);
@@ -77,7 +105,11 @@ private:
     QMutex                  _waitmutex;
     QWaitCondition          _waitc;
     QString                 _databasePath;
+    QString                 _session;
     QSqlDatabase*           _db;
+    QSqlQuery*              _preparedQueries[StatementCount];
+    bool                    _batchOpen;
+    int                     _batchCount;
     bool                    _valid;
     bool                    _failed;
     quint64                 _defaultSet;
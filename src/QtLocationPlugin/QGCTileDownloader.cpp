@@ -0,0 +1,224 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file
+ *   @brief Offline Map Tile Download Scheduler
+ *
+ */
+
+#include "QGCTileDownloader.h"
+#include "QGCLoggingCategory.h"
+
+#include <QNetworkAccessManager>
+
+QGC_LOGGING_CATEGORY(QGCTileDownloaderLog, "QGCTileDownloaderLog")
+
+//-- Weight of a new sample in the smoothed latency
+#define LATENCY_GAIN            0.2
+//-- A shard is considered congested once its latency is this many times its best latency
+#define CONGESTION_FACTOR       2.0
+//-- Latency below which a shard is never considered congested (local or very fast servers)
+#define MIN_LATENCY_MSECS       20.0
+//-- Consecutive errors before a shard is paused, and the pause time
+#define BACKOFF_ERRORS          3
+#define BACKOFF_MSECS           500
+#define MAX_BACKOFF_MSECS       30000
+
+//-----------------------------------------------------------------------------
+QGCTileDownloader::QGCTileDownloader(QNetworkAccessManager* networkManager, int maxConcurrency, QObject* parent)
+    : QObject(parent)
+    , _networkManager(networkManager)
+    , _maxConcurrency(qMax(maxConcurrency, 1))
+    , _nextShardIndex(0)
+    , _queuedCount(0)
+{
+    _clock.start();
+    _backoffTimer.setSingleShot(true);
+    connect(&_backoffTimer, &QTimer::timeout, this, &QGCTileDownloader::_dispatch);
+}
+
+//-----------------------------------------------------------------------------
+QGCTileDownloader::~QGCTileDownloader()
+{
+    abort();
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCTileDownloader::addDownload(quint64 tileKey, const QNetworkRequest& request)
+{
+    //-- The server number picked by the url factory shows in the host name
+    QString key = QString("%1:%2").arg(request.url().host()).arg(request.url().port());
+    Shard* shard = _shards.value(key);
+    if(!shard) {
+        shard = new Shard;
+        shard->active           = 0;
+        shard->window           = kInitialShardWindow;
+        shard->latencyMsecs     = 0;
+        shard->bestLatencyMsecs = 0;
+        shard->errors           = 0;
+        shard->pausedUntil      = 0;
+        _shards.insert(key, shard);
+        _shardList.append(shard);
+        qCDebug(QGCTileDownloaderLog) << "New server shard" << key;
+    }
+    Download download;
+    download.tileKey = tileKey;
+    download.request = request;
+    shard->queue.enqueue(download);
+    _queuedCount++;
+    _dispatch();
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCTileDownloader::abort()
+{
+    QHash<QNetworkReply*, ActiveReply> replies = _activeReplies;
+    _activeReplies.clear();
+    foreach(QNetworkReply* reply, replies.keys()) {
+        disconnect(reply, NULL, this, NULL);
+        reply->abort();
+        reply->deleteLater();
+    }
+    qDeleteAll(_shardList);
+    _shards.clear();
+    _shardList.clear();
+    _nextShardIndex = 0;
+    _queuedCount    = 0;
+    _backoffTimer.stop();
+}
+
+//-----------------------------------------------------------------------------
+int
+QGCTileDownloader::concurrency()
+{
+    int total = 0;
+    foreach(Shard* shard, _shardList) {
+        total += (int)shard->window;
+    }
+    return qMin(total, _maxConcurrency);
+}
+
+//-----------------------------------------------------------------------------
+QGCTileDownloader::Shard*
+QGCTileDownloader::_nextShard()
+{
+    qint64 now = _clock.elapsed();
+    for(int i = 0; i < _shardList.count(); i++) {
+        int index = (_nextShardIndex + i) % _shardList.count();
+        Shard* shard = _shardList[index];
+        if(shard->queue.count() && shard->active < (int)shard->window && shard->pausedUntil <= now) {
+            _nextShardIndex = (index + 1) % _shardList.count();
+            return shard;
+        }
+    }
+    return NULL;
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCTileDownloader::_dispatch()
+{
+    //-- Round robin over the shards so all servers are kept busy
+    while(_activeReplies.count() < _maxConcurrency) {
+        Shard* shard = _nextShard();
+        if(!shard) {
+            break;
+        }
+        Download download = shard->queue.dequeue();
+        _queuedCount--;
+        QNetworkReply* reply = _networkManager->get(download.request);
+        reply->setParent(0);
+        connect(reply, &QNetworkReply::finished, this, &QGCTileDownloader::_replyFinished);
+        ActiveReply active;
+        active.tileKey    = download.tileKey;
+        active.shard      = shard;
+        active.startMsecs = _clock.elapsed();
+        _activeReplies.insert(reply, active);
+        shard->active++;
+    }
+    //-- Wake up when the first paused shard with work left may resume
+    qint64 now = _clock.elapsed();
+    qint64 wakeup = -1;
+    foreach(Shard* shard, _shardList) {
+        if(shard->queue.count() && shard->pausedUntil > now) {
+            if(wakeup < 0 || shard->pausedUntil < wakeup) {
+                wakeup = shard->pausedUntil;
+            }
+        }
+    }
+    if(wakeup >= 0 && !_backoffTimer.isActive()) {
+        _backoffTimer.start(wakeup - now);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCTileDownloader::_replyFinished()
+{
+    QNetworkReply* reply = qobject_cast<QNetworkReply*>(QObject::sender());
+    if(!reply || !_activeReplies.contains(reply)) {
+        qWarning() << "QGCTileDownloader::_replyFinished() Reply not in list";
+        return;
+    }
+    ActiveReply active = _activeReplies.take(reply);
+    active.shard->active--;
+    //-- Update the shard before telling anyone, the signals may abort the whole download
+    if(reply->error() == QNetworkReply::NoError) {
+        _replySucceeded(active.shard, _clock.elapsed() - active.startMsecs);
+        emit tileDownloaded(active.tileKey, reply->readAll());
+    } else {
+        _replyFailed(active.shard, reply);
+        emit tileFailed(active.tileKey, reply->error(), reply->errorString());
+    }
+    reply->deleteLater();
+    _dispatch();
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCTileDownloader::_replySucceeded(Shard* shard, qint64 latencyMsecs)
+{
+    shard->errors = 0;
+    if(shard->latencyMsecs <= 0) {
+        shard->latencyMsecs = latencyMsecs;
+    } else {
+        shard->latencyMsecs += LATENCY_GAIN * (latencyMsecs - shard->latencyMsecs);
+    }
+    if(shard->bestLatencyMsecs <= 0 || shard->latencyMsecs < shard->bestLatencyMsecs) {
+        shard->bestLatencyMsecs = shard->latencyMsecs;
+    }
+    //-- Grow or shrink by about one slot per window's worth of replies
+    double step = 1.0 / shard->window;
+    if(shard->latencyMsecs > CONGESTION_FACTOR * qMax(shard->bestLatencyMsecs, MIN_LATENCY_MSECS)) {
+        shard->window = qMax(1.0, shard->window - step);
+    } else {
+        shard->window = qMin((double)kMaxShardWindow, shard->window + step);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCTileDownloader::_replyFailed(Shard* shard, QNetworkReply* reply)
+{
+    //-- Missing tiles are not the server's fault
+    if(reply->error() == QNetworkReply::ContentNotFoundError) {
+        return;
+    }
+    shard->errors++;
+    shard->window = qMax(1.0, shard->window / 2);
+    if(shard->errors >= BACKOFF_ERRORS) {
+        qint64 backoff = qMin((qint64)MAX_BACKOFF_MSECS, (qint64)BACKOFF_MSECS << qMin(shard->errors - BACKOFF_ERRORS, 6));
+        shard->pausedUntil = _clock.elapsed() + backoff;
+        qCDebug(QGCTileDownloaderLog) << "Pausing server" << reply->url().host() << "for" << backoff << "msecs after" << shard->errors << "errors";
+    }
+}
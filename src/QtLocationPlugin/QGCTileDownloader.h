@@ -0,0 +1,110 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file
+ *   @brief Offline Map Tile Download Scheduler
+ *
+ *   Downloads the tiles of an offline tile set. Map providers spread their
+ *   tiles over several servers (see UrlFactory::_getServerNum()), so
+ *   requests are queued per server (one shard per host and port) and each
+ *   shard gets its own connection window.
+ *
+ *   The window of a shard adapts to how the server is doing. It grows by
+ *   one slot per window's worth of fast replies, shrinks when the reply
+ *   latency climbs well above the best latency seen for that server (the
+ *   server or the link is queuing requests) and is halved on errors.
+ *   Repeated errors pause the shard with an exponential back off. Slots
+ *   a shard can't use go to the other shards, up to an overall limit.
+ *
+ */
+
+#ifndef QGC_TILE_DOWNLOADER_H
+#define QGC_TILE_DOWNLOADER_H
+
+#include <QObject>
+#include <QString>
+#include <QHash>
+#include <QList>
+#include <QQueue>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QNetworkRequest>
+#include <QNetworkReply>
+
+class QNetworkAccessManager;
+
+//-----------------------------------------------------------------------------
+class QGCTileDownloader : public QObject
+{
+    Q_OBJECT
+public:
+    QGCTileDownloader               (QNetworkAccessManager* networkManager, int maxConcurrency, QObject* parent = NULL);
+    ~QGCTileDownloader              ();
+
+    void    addDownload             (quint64 tileKey, const QNetworkRequest& request);
+    void    abort                   ();
+
+    int     queuedCount             () { return _queuedCount; }
+    int     activeCount             () { return _activeReplies.count(); }
+    int     shardCount              () { return _shards.count(); }
+    int     maxConcurrency          () { return _maxConcurrency; }
+    //-- Sum of the current shard windows, as adapted to the servers
+    int     concurrency             ();
+
+    static const int kInitialShardWindow    = 2;
+    static const int kMaxShardWindow        = 6;    ///< QNetworkAccessManager opens at most 6 connections per host
+
+signals:
+    void    tileDownloaded          (quint64 tileKey, QByteArray image);
+    void    tileFailed              (quint64 tileKey, QNetworkReply::NetworkError error, QString errorString);
+
+private slots:
+    void    _replyFinished          ();
+    void    _dispatch               ();
+
+private:
+    struct Download {
+        quint64             tileKey;
+        QNetworkRequest     request;
+    };
+
+    struct Shard {
+        QQueue<Download>    queue;
+        int                 active;
+        double              window;
+        double              latencyMsecs;       ///< Smoothed reply latency
+        double              bestLatencyMsecs;   ///< Lowest smoothed latency seen
+        int                 errors;             ///< Consecutive errors
+        qint64              pausedUntil;        ///< Back off after repeated errors, in _clock msecs
+    };
+
+    struct ActiveReply {
+        quint64             tileKey;
+        Shard*              shard;
+        qint64              startMsecs;
+    };
+
+    Shard*  _nextShard              ();
+    void    _replySucceeded         (Shard* shard, qint64 latencyMsecs);
+    void    _replyFailed            (Shard* shard, QNetworkReply* reply);
+
+    QNetworkAccessManager*              _networkManager;
+    int                                 _maxConcurrency;
+    QHash<QString, Shard*>              _shards;
+    QList<Shard*>                       _shardList;         ///< Round robin order
+    int                                 _nextShardIndex;
+    int                                 _queuedCount;
+    QHash<QNetworkReply*, ActiveReply>  _activeReplies;
+    QElapsedTimer                       _clock;
+    QTimer                              _backoffTimer;
+};
+
+#endif // QGC_TILE_DOWNLOADER_H
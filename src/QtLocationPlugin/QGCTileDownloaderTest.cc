@@ -0,0 +1,171 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "QGCTileDownloaderTest.h"
+#include "QGCTileDownloader.h"
+#include "LocalTileServer.h"
+
+#include <QNetworkAccessManager>
+#include <QElapsedTimer>
+
+QGCTileDownloaderTest::QGCTileDownloaderTest(void)
+{
+
+}
+
+QString QGCTileDownloaderTest::_tilePath(int index)
+{
+    return QString("/tiles/19/%1/%2.png").arg(index % 4096).arg(index / 4096);
+}
+
+void QGCTileDownloaderTest::_addDownloads(QGCTileDownloader& downloader, const QList<LocalTileServer*>& servers, int count)
+{
+    for (int i=0; i<count; i++) {
+        downloader.addDownload(i, QNetworkRequest(QUrl(servers[i % servers.count()]->baseUrl() + _tilePath(i))));
+    }
+}
+
+bool QGCTileDownloaderTest::_runDownloads(QGCTileDownloader& downloader, int count, QHash<quint64, QByteArray>& tiles, QList<quint64>& failed)
+{
+    QMetaObject::Connection downloaded = connect(&downloader, &QGCTileDownloader::tileDownloaded, [&tiles](quint64 tileKey, QByteArray image) {
+        tiles.insert(tileKey, image);
+    });
+    QMetaObject::Connection failure = connect(&downloader, &QGCTileDownloader::tileFailed, [&failed](quint64 tileKey, QNetworkReply::NetworkError, QString) {
+        failed.append(tileKey);
+    });
+
+    QElapsedTimer timer;
+    timer.start();
+    while (tiles.count() + failed.count() < count && timer.elapsed() < _downloadTimeoutMsecs) {
+        QTest::qWait(1);
+    }
+
+    disconnect(downloaded);
+    disconnect(failure);
+
+    return tiles.count() + failed.count() == count;
+}
+
+void QGCTileDownloaderTest::_download_test(void)
+{
+    LocalTileServer server1;
+    LocalTileServer server2;
+    QVERIFY(server1.start());
+    QVERIFY(server2.start());
+    server1.setLatency(5);
+    server2.setLatency(5);
+
+    QNetworkAccessManager networkManager;
+    QGCTileDownloader downloader(&networkManager, 8);
+
+    const int tileCount = 300;
+    _addDownloads(downloader, QList<LocalTileServer*>() << &server1 << &server2, tileCount);
+    QCOMPARE(downloader.shardCount(), 2);
+    QVERIFY(downloader.activeCount() <= downloader.maxConcurrency());
+
+    QHash<quint64, QByteArray> tiles;
+    QList<quint64> failed;
+    QVERIFY(_runDownloads(downloader, tileCount, tiles, failed));
+    QCOMPARE(failed.count(), 0);
+    QCOMPARE(tiles.count(), tileCount);
+    for (int i=0; i<tileCount; i++) {
+        QCOMPARE(tiles.value(i), LocalTileServer::tileForPath(_tilePath(i)));
+    }
+
+    // Requests are spread evenly over the servers and never exceed a shard window
+    QCOMPARE(server1.requestCount(), tileCount / 2);
+    QCOMPARE(server2.requestCount(), tileCount / 2);
+    QVERIFY(server1.maxOpenRequests() <= QGCTileDownloader::kMaxShardWindow);
+    QVERIFY(server2.maxOpenRequests() <= QGCTileDownloader::kMaxShardWindow);
+    QVERIFY(server1.maxOpenRequests() + server2.maxOpenRequests() > QGCTileDownloader::kInitialShardWindow * 2);
+
+    QCOMPARE(downloader.queuedCount(), 0);
+    QCOMPARE(downloader.activeCount(), 0);
+}
+
+/// A server which fails all requests is backed off, without holding up the healthy one
+void QGCTileDownloaderTest::_serverErrors_test(void)
+{
+    LocalTileServer failingServer;
+    LocalTileServer server;
+    QVERIFY(failingServer.start());
+    QVERIFY(server.start());
+    failingServer.setErrorInterval(1);
+    server.setLatency(5);
+
+    QNetworkAccessManager networkManager;
+    QGCTileDownloader downloader(&networkManager, 8);
+
+    // The first two errors only shrink the window, the third one pauses the shard for 500 msecs and the fourth
+    // for 1000 msecs, so the last tile fails after about 1500 msecs
+    const int failingTiles = 5;
+    const int tileCount = 100;
+    for (int i=0; i<failingTiles; i++) {
+        downloader.addDownload(tileCount + i, QNetworkRequest(QUrl(failingServer.baseUrl() + _tilePath(i))));
+    }
+    for (int i=0; i<tileCount; i++) {
+        downloader.addDownload(i, QNetworkRequest(QUrl(server.baseUrl() + _tilePath(i))));
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    qint64 lastSuccessMsecs = 0;
+    qint64 lastFailureMsecs = 0;
+    connect(&downloader, &QGCTileDownloader::tileDownloaded, [&timer, &lastSuccessMsecs](quint64, QByteArray) {
+        lastSuccessMsecs = timer.elapsed();
+    });
+    connect(&downloader, &QGCTileDownloader::tileFailed, [&timer, &lastFailureMsecs](quint64, QNetworkReply::NetworkError, QString) {
+        lastFailureMsecs = timer.elapsed();
+    });
+
+    QHash<quint64, QByteArray> tiles;
+    QList<quint64> failed;
+    QVERIFY(_runDownloads(downloader, tileCount + failingTiles, tiles, failed));
+    QCOMPARE(tiles.count(), tileCount);
+    QCOMPARE(failed.count(), failingTiles);
+    QCOMPARE(failingServer.errorCount(), failingTiles);
+
+    QVERIFY(failingServer.maxOpenRequests() <= QGCTileDownloader::kInitialShardWindow);
+    QVERIFY(lastFailureMsecs >= 1400);
+    QVERIFY(lastSuccessMsecs < lastFailureMsecs);
+}
+
+void QGCTileDownloaderTest::_throughput_benchmark(void)
+{
+    int tileCount = qgetenv("QGC_TILE_DOWNLOAD_BENCHMARK_TILES").toInt();
+    if (tileCount <= 0) {
+        tileCount = _defaultBenchmarkTiles;
+    }
+
+    QList<LocalTileServer*> servers;
+    for (int i=0; i<4; i++) {
+        LocalTileServer* server = new LocalTileServer(this);
+        QVERIFY(server->start());
+        server->setLatency(_benchmarkLatencyMsecs);
+        servers.append(server);
+    }
+
+    QNetworkAccessManager networkManager;
+    QGCTileDownloader downloader(&networkManager, servers.count() * QGCTileDownloader::kMaxShardWindow);
+
+    QElapsedTimer timer;
+    timer.start();
+    _addDownloads(downloader, servers, tileCount);
+
+    QHash<quint64, QByteArray> tiles;
+    QList<quint64> failed;
+    QVERIFY(_runDownloads(downloader, tileCount, tiles, failed));
+    qint64 msecs = qMax(timer.elapsed(), (qint64)1);
+    QCOMPARE(tiles.count(), tileCount);
+
+    qDebug() << "Downloaded" << tileCount << "tiles from" << servers.count() << "servers with" << _benchmarkLatencyMsecs << "msecs latency in"
+             << msecs << "msecs," << (tileCount * 1000LL) / msecs << "tiles/sec, final concurrency" << downloader.concurrency();
+
+    qDeleteAll(servers);
+}
@@ -0,0 +1,52 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#ifndef QGCTileDownloaderTest_H
+#define QGCTileDownloaderTest_H
+
+#include "UnitTest.h"
+
+#include <QHash>
+
+class LocalTileServer;
+class QGCTileDownloader;
+
+/// Unit test and benchmark for the offline map tile download scheduler, run against local tile servers.
+///
+/// The benchmark only runs with --unittest-benchmark. It downloads 2000 tiles from four servers by default. Set
+/// QGC_TILE_DOWNLOAD_BENCHMARK_TILES to change the number of tiles.
+class QGCTileDownloaderTest : public UnitTest
+{
+    Q_OBJECT
+
+public:
+    QGCTileDownloaderTest(void);
+
+private slots:
+    void _download_test(void);
+    void _serverErrors_test(void);
+    void _throughput_benchmark(void);
+
+private:
+    /// Queues count tiles spread round robin over the servers
+    void _addDownloads      (QGCTileDownloader& downloader, const QList<LocalTileServer*>& servers, int count);
+
+    /// Runs the downloader until all tiles are done
+    ///     @param[out] tiles Downloaded tiles by key
+    ///     @param[out] failed Failed tile keys
+    bool _runDownloads      (QGCTileDownloader& downloader, int count, QHash<quint64, QByteArray>& tiles, QList<quint64>& failed);
+
+    static QString _tilePath(int index);
+
+    static const int _defaultBenchmarkTiles =   2000;
+    static const int _benchmarkLatencyMsecs =   20;
+    static const int _downloadTimeoutMsecs =    60000;
+};
+
+#endif
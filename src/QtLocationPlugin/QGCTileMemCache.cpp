@@ -0,0 +1,104 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file
+ *   @brief Map Tile Memory Cache
+ *
+ */
+
+#include "QGCTileMemCache.h"
+
+#include <limits.h>
+
+//-----------------------------------------------------------------------------
+QGCTileMemCache::QGCTileMemCache()
+    : _maxBytes(0)
+    , _hits(0)
+    , _misses(0)
+{
+    setMaxBytes(0);
+}
+
+//-----------------------------------------------------------------------------
+QGCTileMemCache::Shard&
+QGCTileMemCache::_shard(quint64 key)
+{
+    //-- Neighboring tiles only differ in the low bits of x and y, mix the whole key before picking a shard
+    quint64 h = (key ^ (key >> 29)) * Q_UINT64_C(0x9E3779B97F4A7C15);
+    return _shards[(h >> 60) % _shardCount];
+}
+
+//-----------------------------------------------------------------------------
+bool
+QGCTileMemCache::find(quint64 key, QByteArray& image, QString& format)
+{
+    Shard& shard = _shard(key);
+    QMutexLocker lock(&shard.mutex);
+    //-- QCache::object() also moves the tile to the front of the LRU list
+    CachedTile* tile = shard.tiles.object(key);
+    if(!tile) {
+        _misses.fetchAndAddRelaxed(1);
+        return false;
+    }
+    //-- Implicitly shared, no tile data is copied
+    image  = tile->image;
+    format = tile->format;
+    _hits.fetchAndAddRelaxed(1);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCTileMemCache::insert(quint64 key, const QByteArray& image, const QString& format)
+{
+    Shard& shard = _shard(key);
+    QMutexLocker lock(&shard.mutex);
+    if(image.size() > shard.tiles.maxCost()) {
+        return;
+    }
+    CachedTile* tile = new CachedTile;
+    tile->image  = image;
+    tile->format = format;
+    //-- Takes ownership of the tile and evicts the least recently used tiles if over budget
+    shard.tiles.insert(key, tile, image.size());
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCTileMemCache::remove(quint64 key)
+{
+    Shard& shard = _shard(key);
+    QMutexLocker lock(&shard.mutex);
+    shard.tiles.remove(key);
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCTileMemCache::clear()
+{
+    for(int i = 0; i < _shardCount; i++) {
+        QMutexLocker lock(&_shards[i].mutex);
+        _shards[i].tiles.clear();
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCTileMemCache::setMaxBytes(quint64 maxBytes)
+{
+    _maxBytes = maxBytes;
+    //-- QCache costs are int, which limits each shard to 2G
+    int shardBytes = (int)qMin(maxBytes / _shardCount, (quint64)INT_MAX);
+    for(int i = 0; i < _shardCount; i++) {
+        QMutexLocker lock(&_shards[i].mutex);
+        _shards[i].tiles.setMaxCost(shardBytes);
+    }
+}
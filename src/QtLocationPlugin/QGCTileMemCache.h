@@ -0,0 +1,69 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file
+ *   @brief Map Tile Memory Cache
+ *
+ *   In memory LRU of tile images which sits in front of the tile cache
+ *   database. Tiles which were recently shown are served from here without
+ *   queuing a task to the cache worker thread.
+ *
+ *   The cache is split into shards, each with its own lock and its own
+ *   share of the byte budget, so concurrent lookups rarely contend.
+ *
+ */
+
+#ifndef QGC_TILE_MEM_CACHE_H
+#define QGC_TILE_MEM_CACHE_H
+
+#include <QByteArray>
+#include <QString>
+#include <QCache>
+#include <QMutex>
+#include <QAtomicInteger>
+
+//-----------------------------------------------------------------------------
+class QGCTileMemCache
+{
+public:
+    QGCTileMemCache             ();
+
+    bool    find                (quint64 key, QByteArray& image, QString& format);
+    void    insert              (quint64 key, const QByteArray& image, const QString& format);
+    void    remove              (quint64 key);
+    void    clear               ();
+    void    setMaxBytes         (quint64 maxBytes);
+
+    quint64 maxBytes            () { return _maxBytes; }
+    quint64 hits                () { return _hits.load(); }
+    quint64 misses              () { return _misses.load(); }
+
+private:
+    struct CachedTile {
+        QByteArray  image;
+        QString     format;
+    };
+
+    struct Shard {
+        QMutex                          mutex;
+        QCache<quint64, CachedTile>     tiles;      ///< Cost is the size of the tile in bytes
+    };
+
+    Shard&  _shard              (quint64 key);
+
+    static const int        _shardCount = 16;
+    Shard                   _shards[_shardCount];
+    quint64                 _maxBytes;
+    QAtomicInteger<quint64> _hits;
+    QAtomicInteger<quint64> _misses;
+};
+
+#endif // QGC_TILE_MEM_CACHE_H
@@ -69,6 +69,16 @@ QGeoTiledMapReplyQGC::QGeoTiledMapReplyQGC(QNetworkAccessManager *networkManager
         setFinished(true);
         setCached(false);
     } else {
+        //-- Recently shown tiles are served straight from memory
+        QByteArray image;
+        QString format;
+        if(getQGCMapEngine()->getMemCachedTile((UrlFactory::MapType)spec.mapId(), spec.x(), spec.y(), spec.zoom(), image, format)) {
+            setMapImageData(image);
+            setMapImageFormat(format);
+            setFinished(true);
+            setCached(true);
+            return;
+        }
         QGCFetchTileTask* task = getQGCMapEngine()->createFetchTileTask((UrlFactory::MapType)spec.mapId(), spec.x(), spec.y(), spec.zoom());
         connect(task, &QGCFetchTileTask::tileFetched, this, &QGeoTiledMapReplyQGC::cacheReply);
         connect(task, &QGCMapTask::error, this, &QGeoTiledMapReplyQGC::cacheError);
@@ -168,6 +178,7 @@ QGeoTiledMapReplyQGC::cacheError(QGCMapTask::TaskType type, QString /*errorStrin
 void
 QGeoTiledMapReplyQGC::cacheReply(QGCCacheTile* tile)
 {
+    getQGCMapEngine()->memCacheTile((UrlFactory::MapType)tileSpec().mapId(), tileSpec().x(), tileSpec().y(), tileSpec().zoom(), tile->img(), tile->format());
     setMapImageData(tile->img());
     setMapImageFormat(tile->format());
     setFinished(true);
@@ -8,6 +8,7 @@
  ****************************************************************************/
 
 #include "MAVLinkLogManager.h"
+#include "ULogStreamWriter.h"
 #include "QGCApplication.h"
 #include <QQmlContext>
 #include <QQmlProperty>
@@ -112,12 +113,7 @@ MAVLinkLogFiles::setUploaded(bool uploaded)
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 MAVLinkLogProcessor::MAVLinkLogProcessor()
-    : _fd(NULL)
-    , _written(0)
-    , _sequence(-1)
-    , _numDrops(0)
-    , _gotHeader(false)
-    , _error(false)
+    : _writer(NULL)
     , _record(NULL)
 {
 }
@@ -132,17 +128,29 @@ MAVLinkLogProcessor::~MAVLinkLogProcessor()
 void
 MAVLinkLogProcessor::close()
 {
-    if(_fd) {
-        fclose(_fd);
-        _fd = NULL;
+    if(_writer) {
+        //-- Writes out what is still queued
+        _writer->stopLogging();
+        if(_record) {
+            _record->setSize((quint32)_writer->bytesWritten());
+        }
+        const ULogStreamAssembler& assembler = _writer->assembler();
+        qCDebug(MAVLinkLogManagerLog) << "Log closed:" << _fileName
+                                      << "packets" << assembler.receivedPackets()
+                                      << "dropped" << assembler.droppedPackets()
+                                      << "(" << _writer->overflowPackets() << "by writer )"
+                                      << "discarded bytes" << assembler.discardedBytes();
+        delete _writer;
+        _writer = NULL;
     }
+    _file.close();
 }
 
 //-----------------------------------------------------------------------------
 bool
 MAVLinkLogProcessor::valid()
 {
-    return (_fd != NULL) && (_record != NULL);
+    return (_writer != NULL) && (_record != NULL);
 }
 
 //-----------------------------------------------------------------------------
@@ -154,11 +162,14 @@ MAVLinkLogProcessor::create(MAVLinkLogManager* manager, const QString path, uint
         id,
         QDateTime::currentDateTime().toString("yyyy-MM-dd-hh-mm-ss-zzz").toLatin1().data(),
         kUlogExtension);
-    _fd = fopen(_fileName.toLatin1().data(), "wb");
-    if(_fd) {
+    _file.setFileName(_fileName);
+    if(_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
         _record = new MAVLinkLogFiles(manager, _fileName, true);
         _record->setWriting(true);
-        _sequence = -1;
+        _writer = new ULogStreamWriter;
+        //-- Size updates come from the writer thread (queued)
+        QObject::connect(_writer, &ULogStreamWriter::bytesWrittenChanged, _record, &MAVLinkLogFiles::setSize);
+        _writer->startLogging(&_file);
         return true;
     }
     return false;
@@ -166,131 +177,15 @@ MAVLinkLogProcessor::create(MAVLinkLogManager* manager, const QString path, uint
 
 //-----------------------------------------------------------------------------
 bool
-MAVLinkLogProcessor::_checkSequence(uint16_t seq, int& num_drops)
+MAVLinkLogProcessor::processStreamData(uint16_t sequence, uint8_t first_message, const QByteArray& data)
 {
-    num_drops = 0;
-    //-- Check if a sequence is newer than the one previously received and if
-    //   there were dropped messages between the last one and this.
-    if(_sequence == -1) {
-        _sequence = seq;
-        return true;
-    }
-    if((uint16_t)_sequence == seq) {
+    //-- Write errors are picked up with the next packet
+    if(!_writer || _writer->failed()) {
         return false;
     }
-    if(seq > (uint16_t)_sequence) {
-        // Account for wrap-arounds, sequence is 2 bytes
-        if((seq - _sequence) > (1 << 15)) { // Assume reordered
-            return false;
-        }
-        num_drops = seq - _sequence - 1;
-        _numDrops += num_drops;
-        _sequence = seq;
-        return true;
-    } else {
-        if((_sequence - seq) > (1 << 15)) {
-            num_drops = (1 << 16) - _sequence - 1 + seq;
-            _numDrops += num_drops;
-            _sequence = seq;
-            return true;
-        }
-        return false;
-    }
-}
-
-//-----------------------------------------------------------------------------
-void
-MAVLinkLogProcessor::_writeData(void* data, int len)
-{
-    if(!_error) {
-        _error = fwrite(data, 1, len, _fd) != (size_t)len;
-        if(!_error) {
-            _written += len;
-            if(_record) {
-                _record->setSize(_written);
-            }
-        } else {
-            qCDebug(MAVLinkLogManagerLog) << "File IO error:" << len << "bytes into" << _fileName;
-        }
-    }
-}
-
-//-----------------------------------------------------------------------------
-QByteArray
-MAVLinkLogProcessor::_writeUlogMessage(QByteArray& data)
-{
-    //-- Write ulog data w/o integrity checking, assuming data starts with a
-    //   valid ulog message. returns the remaining data at the end.
-    while(data.length() > 2) {
-        uint8_t* ptr = (uint8_t*)data.data();
-        int message_length = ptr[0] + (ptr[1] * 256) + 3; // 3 = ULog msg header
-        if(message_length > data.length())
-            break;
-        _writeData(data.data(), message_length);
-        data.remove(0, message_length);
-    }
-    return data;
-}
-
-//-----------------------------------------------------------------------------
-bool
-MAVLinkLogProcessor::processStreamData(uint16_t sequence, uint8_t first_message, QByteArray data)
-{
-    int num_drops = 0;
-    _error = false;
-    while(_checkSequence(sequence, num_drops)) {
-        //-- The first 16 bytes need special treatment (this sounds awfully brittle)
-        if(!_gotHeader) {
-            if(data.size() < 16) {
-                //-- Shouldn't happen but if it does, we might as well close shop.
-                qCWarning(MAVLinkLogManagerLog) << "Corrupt log header. Canceling log download.";
-                return false;
-            }
-            //-- Write header
-            _writeData(data.data(), 16);
-            data.remove(0, 16);
-            _gotHeader = true;
-            // What about data start offset now that we removed 16 bytes off the start?
-        }
-        if(_gotHeader && num_drops > 0) {
-            if(num_drops > 25) num_drops = 25;
-            //-- Hocus Pocus
-            //   Write a dropout message. We don't really know the actual duration,
-            //   so just use the number of drops * 10 ms
-            uint8_t bogus[] = {2, 0, 79, 0, 0};
-            bogus[3] = num_drops * 10;
-            _writeData(bogus, sizeof(bogus));
-        }
-        if(num_drops > 0) {
-            _writeUlogMessage(_ulogMessage);
-            _ulogMessage.clear();
-            //-- If no usefull information in this message. Drop it.
-            if(first_message == 255) {
-                break;
-            }
-            if(first_message > 0) {
-                data.remove(0, first_message);
-                first_message = 0;
-            }
-        }
-        if(first_message == 255 && _ulogMessage.length() > 0) {
-            _ulogMessage.append(data);
-            break;
-        }
-        if(_ulogMessage.length()) {
-            _writeData(_ulogMessage.data(), _ulogMessage.length());
-            if(first_message) {
-                _writeData(data.left(first_message).data(), first_message);
-            }
-            _ulogMessage.clear();
-        }
-        if(first_message) {
-            data.remove(0, first_message);
-        }
-        _ulogMessage = _writeUlogMessage(data);
-        break;
-    }
-    return !_error;
+    //-- If the ring is full the packet is dropped and shows up in the log as a dropout
+    _writer->queuePacket(sequence, first_message, (const uint8_t*)data.constData(), data.size());
+    return true;
 }
 
 //-----------------------------------------------------------------------------
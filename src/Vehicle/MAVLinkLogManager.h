@@ -12,6 +12,7 @@
 #define MAVLinkLogManager_H
 
 #include <QObject>
+#include <QFile>
 
 #include "QmlObjectListModel.h"
 #include "QGCLoggingCategory.h"
@@ -22,6 +23,7 @@ Q_DECLARE_LOGGING_CATEGORY(MAVLinkLogManagerLog)
 
 class QNetworkAccessManager;
 class MAVLinkLogManager;
+class ULogStreamWriter;
 
 //-----------------------------------------------------------------------------
 class MAVLinkLogFiles : public QObject
@@ -73,6 +75,8 @@ private:
 };
 
 //-----------------------------------------------------------------------------
+//-- Streamed log being recorded. The log is assembled and written by a
+//   ULogStreamWriter thread, processStreamData only queues the packets.
 class MAVLinkLogProcessor
 {
 public:
@@ -83,19 +87,10 @@ public:
     bool                create      (MAVLinkLogManager *manager, const QString path, uint8_t id);
     MAVLinkLogFiles*    record      () { return _record; }
     QString             fileName    () { return _fileName; }
-    bool                processStreamData(uint16_t _sequence, uint8_t first_message, QByteArray data);
+    bool                processStreamData(uint16_t _sequence, uint8_t first_message, const QByteArray& data);
 private:
-    bool                _checkSequence(uint16_t seq, int &num_drops);
-    QByteArray          _writeUlogMessage(QByteArray &data);
-    void                _writeData(void* data, int len);
-private:
-    FILE*               _fd;
-    quint32             _written;
-    int                 _sequence;
-    int                 _numDrops;
-    bool                _gotHeader;
-    bool                _error;
-    QByteArray          _ulogMessage;
+    QFile               _file;
+    ULogStreamWriter*   _writer;
     QString             _fileName;
     MAVLinkLogFiles*    _record;
 };
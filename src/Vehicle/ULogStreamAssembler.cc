@@ -0,0 +1,162 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "ULogStreamAssembler.h"
+
+#include <QtGlobal>
+
+#include <string.h>
+
+ULogStreamAssembler::ULogStreamAssembler(void)
+    : _length(0)
+    , _messageStart(0)
+    , _sequence(-1)
+    , _gotHeader(false)
+    , _inSync(true)
+    , _error(false)
+    , _receivedPackets(0)
+    , _droppedPackets(0)
+    , _stalePackets(0)
+    , _discardedBytes(0)
+    , _dropouts(0)
+{
+    _buffer.resize(batchBytes + maxMessageLength + maxPacketLength);
+}
+
+void ULogStreamAssembler::reset(void)
+{
+    _length = 0;
+    _messageStart = 0;
+    _sequence = -1;
+    _gotHeader = false;
+    _inSync = true;
+    _error = false;
+    _receivedPackets = 0;
+    _droppedPackets = 0;
+    _stalePackets = 0;
+    _discardedBytes = 0;
+    _dropouts = 0;
+}
+
+bool ULogStreamAssembler::addPacket(uint16_t sequence, uint8_t firstMessage, const uint8_t* data, int length)
+{
+    if (_error) {
+        return false;
+    }
+
+    int droppedPackets = _checkSequence(sequence);
+    if (droppedPackets < 0) {
+        _stalePackets++;
+        return true;
+    }
+    _receivedPackets++;
+    _droppedPackets += droppedPackets;
+
+    length = qBound(0, length, (int)maxPacketLength);
+
+    if (!_gotHeader) {
+        // The file header is sent as the first message of the stream, messages follow right after it
+        if (length < headerLength) {
+            _error = true;
+            return false;
+        }
+        _append(data, headerLength);
+        _messageStart = _length;
+        _gotHeader = true;
+        data += headerLength;
+        length -= headerLength;
+    } else if (droppedPackets) {
+        // The message which was being received can't be completed, replace it by a dropout
+        _discardedBytes += _length - _messageStart;
+        _length = _messageStart;
+        _appendDropout(droppedPackets);
+        _inSync = false;
+    }
+
+    if (!_inSync) {
+        if (firstMessage == 255 || firstMessage > length) {
+            // No message starts in this packet, nothing to pick up from
+            _discardedBytes += length;
+            return true;
+        }
+        _discardedBytes += firstMessage;
+        data += firstMessage;
+        length -= firstMessage;
+        _inSync = true;
+    }
+
+    _append(data, length);
+    _findMessages();
+
+    return true;
+}
+
+void ULogStreamAssembler::consume(void)
+{
+    int partialLength = _length - _messageStart;
+
+    if (partialLength) {
+        memmove(_buffer.data(), _buffer.constData() + _messageStart, partialLength);
+    }
+    _length = partialLength;
+    _messageStart = 0;
+}
+
+/// @return Number of packets lost before this one, -1 if the packet is a duplicate or arrived out of order
+int ULogStreamAssembler::_checkSequence(uint16_t sequence)
+{
+    if (_sequence == -1) {
+        _sequence = sequence;
+        return 0;
+    }
+
+    // Sequence numbers wrap at 16 bits, anything more than half the range behind is taken as reordered
+    uint16_t delta = (uint16_t)(sequence - (uint16_t)_sequence);
+    if (delta == 0 || delta >= 0x8000) {
+        return -1;
+    }
+
+    _sequence = sequence;
+    return delta - 1;
+}
+
+void ULogStreamAssembler::_append(const uint8_t* data, int length)
+{
+    if (_length + length > _buffer.size()) {
+        // Only happens if the caller does not consume after batchBytes
+        _buffer.resize(_length + length);
+    }
+    memcpy(_buffer.data() + _length, data, length);
+    _length += length;
+}
+
+/// Appends a ULog dropout message ('O') with the estimated duration of the dropout
+void ULogStreamAssembler::_appendDropout(int droppedPackets)
+{
+    int     durationMSecs = qMin(droppedPackets * (int)dropoutMSecsPerPacket, 0xFFFF);
+    uint8_t dropout[messageHeaderLength + 2] = { 2, 0, 'O', (uint8_t)(durationMSecs & 0xFF), (uint8_t)(durationMSecs >> 8) };
+
+    _append(dropout, sizeof(dropout));
+    _messageStart = _length;
+    _dropouts++;
+}
+
+/// Moves _messageStart past all messages which are now complete
+void ULogStreamAssembler::_findMessages(void)
+{
+    const uint8_t* buffer = (const uint8_t*)_buffer.constData();
+
+    while (_length - _messageStart >= messageHeaderLength) {
+        int messageLength = buffer[_messageStart] + (buffer[_messageStart + 1] * 256) + messageHeaderLength;
+        if (_messageStart + messageLength > _length) {
+            break;
+        }
+        _messageStart += messageLength;
+    }
+}
@@ -0,0 +1,86 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#ifndef ULogStreamAssembler_H
+#define ULogStreamAssembler_H
+
+#include <QByteArray>
+
+#include <stdint.h>
+
+/// Reassembles the ULog file from the LOGGING_DATA(_ACKED) packets of a PX4 log stream.
+///
+/// Packet data is copied once, straight into a preallocated batch buffer, and ULog message boundaries are tracked
+/// as offsets into that buffer. The buffer is split into complete messages, which can be written out, followed by the
+/// message which is still being received. When packets are lost the partial message is thrown away, a dropout
+/// message is written in its place and the stream picks up again at the first message which starts in the next packet.
+///
+/// The assembler does not do any file IO itself. The caller writes out completeData once completeLength reaches
+/// batchBytes (or whenever it wants to) and then calls consume.
+class ULogStreamAssembler
+{
+public:
+    ULogStreamAssembler(void);
+
+    /// Starts a new log, the file header is expected in the next packet
+    void reset(void);
+
+    /// Adds the data of a single LOGGING_DATA packet
+    ///     @param sequence Packet sequence number
+    ///     @param firstMessage Offset of the first message which starts in this packet, 255 for none
+    ///     @param data Packet data
+    ///     @param length Number of valid bytes in data
+    /// @return false: the stream is corrupt and cannot be continued
+    bool addPacket(uint16_t sequence, uint8_t firstMessage, const uint8_t* data, int length);
+
+    /// @return Start of the complete messages which are ready to be written
+    const char* completeData(void) const { return _buffer.constData(); }
+
+    /// @return Number of bytes of complete messages ready to be written
+    int completeLength(void) const { return _messageStart; }
+
+    /// Removes the complete messages from the buffer after they were written
+    void consume(void);
+
+    bool    error(void) const               { return _error; }
+    quint64 receivedPackets(void) const     { return _receivedPackets; }    ///< Packets added to the log
+    quint64 droppedPackets(void) const      { return _droppedPackets; }     ///< Packets lost, going by sequence numbers
+    quint64 stalePackets(void) const        { return _stalePackets; }       ///< Duplicate or out of order packets which were ignored
+    quint64 discardedBytes(void) const      { return _discardedBytes; }     ///< Bytes of partial messages thrown away because of lost packets
+    quint64 dropouts(void) const            { return _dropouts; }           ///< Dropout messages written
+
+    static const int headerLength =         16;
+    static const int messageHeaderLength =  3;                                      ///< uint16 msg_size, uint8 msg_type
+    static const int maxMessageLength =     0xFFFF + messageHeaderLength;
+    static const int maxPacketLength =      249;                                    ///< LOGGING_DATA data field
+    static const int batchBytes =           64 * 1024;
+    static const int dropoutMSecsPerPacket = 10;                                    ///< Guess, the actual duration of a dropout is unknown
+
+private:
+    int     _checkSequence(uint16_t sequence);
+    void    _append(const uint8_t* data, int length);
+    void    _appendDropout(int droppedPackets);
+    void    _findMessages(void);
+
+    QByteArray  _buffer;            ///< Preallocated to batchBytes + maxMessageLength + maxPacketLength
+    int         _length;            ///< Bytes used in _buffer
+    int         _messageStart;      ///< Offset of the message still being received, everything before it is complete
+    int         _sequence;          ///< Last sequence number added, -1 for none
+    bool        _gotHeader;
+    bool        _inSync;            ///< false: packets were lost, waiting for a packet in which a message starts
+    bool        _error;
+
+    quint64     _receivedPackets;
+    quint64     _droppedPackets;
+    quint64     _stalePackets;
+    quint64     _discardedBytes;
+    quint64     _dropouts;
+};
+
+#endif
@@ -0,0 +1,309 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "ULogStreamTest.h"
+#include "ULogStreamWriter.h"
+
+#include <QTemporaryFile>
+#include <QElapsedTimer>
+#include <QSet>
+
+ULogStreamTest::ULogStreamTest(void)
+{
+
+}
+
+/// Builds a ULog stream of at least the specified size: the file header followed by messages of varying length
+QByteArray ULogStreamTest::_buildStream(int bytes)
+{
+    QByteArray  stream;
+    quint32     random = 12345;
+    int         messageCount = 0;
+
+    const char header[ULogStreamAssembler::headerLength] = { 'U', 'L', 'o', 'g', 0x01, 0x12, 0x35, 0x01, 0x10, 0x27, 0, 0, 0, 0, 0, 0 };
+    stream.append(header, sizeof(header));
+
+    while (stream.size() < bytes) {
+        random = (random * 1103515245) + 12345;
+        int payloadLength = 10 + ((random >> 16) % 110);
+        if ((++messageCount % 50) == 0) {
+            // Now and then a message which spans several packets
+            payloadLength = 300 + ((random >> 16) % 1200);
+        }
+
+        stream.append((char)(payloadLength & 0xFF));
+        stream.append((char)(payloadLength >> 8));
+        stream.append(messageCount & 1 ? 'D' : 'L');
+        for (int i=0; i<payloadLength; i++) {
+            stream.append((char)((messageCount + i) & 0xFF));
+        }
+    }
+
+    return stream;
+}
+
+/// Splits the stream into packets the way the PX4 logger does. Packets are mostly full, with a shorter packet
+/// now and then as if the logger flushed on a timeout.
+QList<ULogStreamTest::Packet_t> ULogStreamTest::_packetize(const QByteArray& stream, uint16_t firstSequence)
+{
+    QList<Packet_t> packets;
+    int             nextMessage = 0;
+    int             offset = 0;
+    uint16_t        sequence = firstSequence;
+
+    while (offset < stream.size()) {
+        int packetLength = (packets.count() % 5) == 4 ? 100 + (packets.count() % 100) : ULogStreamAssembler::maxPacketLength;
+        packetLength = qMin(packetLength, stream.size() - offset);
+
+        Packet_t packet;
+        packet.sequence = sequence++;
+        packet.firstMessage = 255;
+        packet.data = stream.mid(offset, packetLength);
+
+        while (nextMessage < offset + packetLength) {
+            if (nextMessage >= offset && packet.firstMessage == 255) {
+                packet.firstMessage = (uint8_t)(nextMessage - offset);
+            }
+            if (nextMessage == 0) {
+                nextMessage = ULogStreamAssembler::headerLength;
+            } else {
+                const uint8_t* message = (const uint8_t*)stream.constData() + nextMessage;
+                nextMessage += message[0] + (message[1] * 256) + ULogStreamAssembler::messageHeaderLength;
+            }
+        }
+
+        packets.append(packet);
+        offset += packetLength;
+    }
+
+    return packets;
+}
+
+/// Runs the packets through the assembler the way ULogStreamWriter does
+bool ULogStreamTest::_assemble(ULogStreamAssembler& assembler, const QList<Packet_t>& packets, QByteArray& log)
+{
+    log.clear();
+    foreach (const Packet_t& packet, packets) {
+        if (!assembler.addPacket(packet.sequence, packet.firstMessage, (const uint8_t*)packet.data.constData(), packet.data.size())) {
+            return false;
+        }
+        if (assembler.completeLength() >= ULogStreamAssembler::batchBytes) {
+            log.append(assembler.completeData(), assembler.completeLength());
+            assembler.consume();
+        }
+    }
+    log.append(assembler.completeData(), assembler.completeLength());
+    assembler.consume();
+
+    return true;
+}
+
+/// Splits a log file into its messages, not including the file header
+bool ULogStreamTest::_splitMessages(const QByteArray& log, QList<QByteArray>& messages)
+{
+    int offset = ULogStreamAssembler::headerLength;
+
+    messages.clear();
+    while (offset + ULogStreamAssembler::messageHeaderLength <= log.size()) {
+        const uint8_t* message = (const uint8_t*)log.constData() + offset;
+        int messageLength = message[0] + (message[1] * 256) + ULogStreamAssembler::messageHeaderLength;
+        if (offset + messageLength > log.size()) {
+            return false;
+        }
+        messages.append(log.mid(offset, messageLength));
+        offset += messageLength;
+    }
+
+    return offset == log.size();
+}
+
+void ULogStreamTest::_assemble_test(void)
+{
+    QByteArray          stream = _buildStream(200 * 1024);
+    ULogStreamAssembler assembler;
+    QByteArray          log;
+
+    QList<Packet_t> packets = _packetize(stream, 0);
+    QVERIFY(_assemble(assembler, packets, log));
+    QVERIFY(log == stream);
+
+    QCOMPARE(assembler.receivedPackets(), (quint64)packets.count());
+    QCOMPARE(assembler.droppedPackets(), (quint64)0);
+    QCOMPARE(assembler.stalePackets(), (quint64)0);
+    QCOMPARE(assembler.discardedBytes(), (quint64)0);
+    QCOMPARE(assembler.dropouts(), (quint64)0);
+}
+
+void ULogStreamTest::_packetLoss_test(void)
+{
+    QByteArray          stream = _buildStream(100 * 1024);
+    QList<Packet_t>     packets = _packetize(stream, 0);
+    QList<Packet_t>     received;
+    ULogStreamAssembler assembler;
+    QByteArray          log;
+    int                 dropped = 0;
+    int                 gaps = 0;
+    int                 receivedBytes = 0;
+
+    // Single lost packets as well as a run of them, the last packet is always received
+    for (int i=0; i<packets.count(); i++) {
+        bool lost = i != 0 && i != packets.count() - 1 && ((i % 7) == 3 || (i >= 50 && i < 54));
+        if (lost) {
+            if (received.count() && received.last().sequence == packets[i - 1].sequence) {
+                gaps++;
+            }
+            dropped++;
+        } else {
+            received.append(packets[i]);
+            receivedBytes += packets[i].data.size();
+        }
+    }
+
+    QVERIFY(_assemble(assembler, received, log));
+    QCOMPARE(assembler.droppedPackets(), (quint64)dropped);
+    QCOMPARE(assembler.dropouts(), (quint64)gaps);
+    QCOMPARE(assembler.receivedPackets(), (quint64)received.count());
+
+    // Every byte received is either in the log or accounted for as discarded
+    const int dropoutLength = ULogStreamAssembler::messageHeaderLength + 2;
+    QCOMPARE((quint64)(log.size() - (gaps * dropoutLength)), receivedBytes - assembler.discardedBytes());
+
+    // The log is still a valid message stream, made up of original messages and dropouts
+    QList<QByteArray> originalMessages;
+    QVERIFY(_splitMessages(stream, originalMessages));
+    QSet<QByteArray> originalSet = originalMessages.toSet();
+
+    QList<QByteArray> messages;
+    QVERIFY(_splitMessages(log, messages));
+    int dropoutCount = 0;
+    foreach (const QByteArray& message, messages) {
+        if (message[2] == 'O') {
+            QCOMPARE(message.size(), dropoutLength);
+            dropoutCount++;
+        } else {
+            QVERIFY(originalSet.contains(message));
+        }
+    }
+    QCOMPARE(dropoutCount, gaps);
+    QVERIFY(log.startsWith(stream.left(ULogStreamAssembler::headerLength)));
+}
+
+void ULogStreamTest::_stalePackets_test(void)
+{
+    QByteArray          stream = _buildStream(50 * 1024);
+    QList<Packet_t>     packets = _packetize(stream, 0);
+    ULogStreamAssembler assembler;
+    QByteArray          log;
+
+    // Duplicates, and an old packet which shows up late
+    QList<Packet_t> received = packets;
+    received.insert(11, packets[10]);
+    received.insert(31, packets[5]);
+    received.insert(41, packets[38]);
+
+    QVERIFY(_assemble(assembler, received, log));
+    QVERIFY(log == stream);
+    QCOMPARE(assembler.stalePackets(), (quint64)3);
+    QCOMPARE(assembler.droppedPackets(), (quint64)0);
+}
+
+void ULogStreamTest::_sequenceWrap_test(void)
+{
+    QByteArray          stream = _buildStream(50 * 1024);
+    ULogStreamAssembler assembler;
+    QByteArray          log;
+
+    QList<Packet_t> packets = _packetize(stream, 0xFFFF - 100);
+    QVERIFY(packets.count() > 101);
+
+    QVERIFY(_assemble(assembler, packets, log));
+    QVERIFY(log == stream);
+    QCOMPARE(assembler.droppedPackets(), (quint64)0);
+    QCOMPARE(assembler.stalePackets(), (quint64)0);
+}
+
+void ULogStreamTest::_corruptHeader_test(void)
+{
+    ULogStreamAssembler assembler;
+    uint8_t             data[ULogStreamAssembler::headerLength - 6] = { 0 };
+
+    QCOMPARE(assembler.addPacket(0, 0, data, sizeof(data)), false);
+    QVERIFY(assembler.error());
+    QCOMPARE(assembler.addPacket(1, 0, data, sizeof(data)), false);
+}
+
+void ULogStreamTest::_writer_test(void)
+{
+    QByteArray      stream = _buildStream(300 * 1024);
+    QList<Packet_t> packets = _packetize(stream, 0);
+    QTemporaryFile  file;
+
+    QVERIFY(file.open());
+
+    ULogStreamWriter writer;
+    writer.startLogging(&file);
+    foreach (const Packet_t& packet, packets) {
+        QVERIFY(writer.queuePacket(packet.sequence, packet.firstMessage, (const uint8_t*)packet.data.constData(), packet.data.size()));
+    }
+    writer.stopLogging();
+
+    QVERIFY(!writer.failed());
+    QCOMPARE(writer.queuedPackets(), (quint64)packets.count());
+    QCOMPARE(writer.overflowPackets(), (quint64)0);
+    QCOMPARE(writer.bytesWritten(), (quint64)stream.size());
+    QCOMPARE(writer.assembler().receivedPackets(), (quint64)packets.count());
+
+    file.seek(0);
+    QVERIFY(file.readAll() == stream);
+
+    // Stopped writer does not accept packets
+    QCOMPARE(writer.queuePacket(packets.last().sequence + 1, 0, (const uint8_t*)stream.constData(), 10), false);
+}
+
+void ULogStreamTest::_assembler_benchmark(void)
+{
+    QByteArray      stream = _buildStream(4 * 1024 * 1024);
+    QList<Packet_t> packets = _packetize(stream, 0);
+    QByteArray      log;
+
+    QBENCHMARK {
+        ULogStreamAssembler assembler;
+        _assemble(assembler, packets, log);
+    }
+}
+
+/// Sustained throughput of the writer thread, from queuing the first packet until the log is synced to disk
+void ULogStreamTest::_writerThroughput_benchmark(void)
+{
+    QByteArray      stream = _buildStream(32 * 1024 * 1024);
+    QList<Packet_t> packets = _packetize(stream, 0);
+    QTemporaryFile  file;
+    QElapsedTimer   timer;
+
+    QVERIFY(file.open());
+
+    ULogStreamWriter writer;
+    timer.start();
+    writer.startLogging(&file);
+    foreach (const Packet_t& packet, packets) {
+        // Hold off instead of dropping so the complete log makes it to disk
+        while (!writer.queuePacket(packet.sequence, packet.firstMessage, (const uint8_t*)packet.data.constData(), packet.data.size())) {
+            QThread::yieldCurrentThread();
+        }
+    }
+    writer.stopLogging();
+    qint64 elapsedMSecs = qMax(timer.elapsed(), (qint64)1);
+
+    QVERIFY(!writer.failed());
+    QCOMPARE(writer.bytesWritten(), (quint64)stream.size());
+    QCOMPARE(writer.assembler().droppedPackets(), (quint64)0);
+
+    qDebug() << "ULog writer sustained" << (stream.size() / (1024.0 * 1024.0)) / (elapsedMSecs / 1000.0) << "MB/s,"
+             << "producer held off" << writer.overflowPackets() << "times";
+}
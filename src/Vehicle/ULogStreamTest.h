@@ -0,0 +1,53 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#ifndef ULogStreamTest_H
+#define ULogStreamTest_H
+
+#include "UnitTest.h"
+#include "ULogStreamAssembler.h"
+
+#include <QList>
+
+/// Unit test and benchmark for ULogStreamAssembler and ULogStreamWriter.
+///
+/// The log streams are synthetic and packetized the way the PX4 logger does it: the file header is the first message
+/// of the stream and each packet reports the offset of the first message which starts in it. The *_benchmark slots
+/// only run with --unittest-benchmark.
+class ULogStreamTest : public UnitTest
+{
+    Q_OBJECT
+
+public:
+    ULogStreamTest(void);
+
+private slots:
+    void _assemble_test(void);
+    void _packetLoss_test(void);
+    void _stalePackets_test(void);
+    void _sequenceWrap_test(void);
+    void _corruptHeader_test(void);
+    void _writer_test(void);
+    void _assembler_benchmark(void);
+    void _writerThroughput_benchmark(void);
+
+private:
+    typedef struct {
+        uint16_t    sequence;
+        uint8_t     firstMessage;
+        QByteArray  data;
+    } Packet_t;
+
+    QByteArray      _buildStream(int bytes);
+    QList<Packet_t> _packetize(const QByteArray& stream, uint16_t firstSequence);
+    bool            _assemble(ULogStreamAssembler& assembler, const QList<Packet_t>& packets, QByteArray& log);
+    bool            _splitMessages(const QByteArray& log, QList<QByteArray>& messages);
+};
+
+#endif
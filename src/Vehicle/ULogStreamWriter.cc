@@ -0,0 +1,129 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "ULogStreamWriter.h"
+#include "QGCLoggingCategory.h"
+
+QGC_LOGGING_CATEGORY(ULogStreamWriterLog, "ULogStreamWriterLog")
+
+ULogStreamWriter::ULogStreamWriter(QObject* parent)
+    : RingBufferedFileWriter(_ringBufferSize, parent)
+    , _bytesWritten(0)
+    , _queuedPackets(0)
+    , _overflowPackets(0)
+{
+
+}
+
+ULogStreamWriter::~ULogStreamWriter()
+{
+    stopLogging();
+}
+
+void ULogStreamWriter::startLogging(QFile* file)
+{
+    stopLogging();
+
+    _assembler.reset();
+    _bytesWritten.store(0);
+    _queuedPackets.store(0);
+    _overflowPackets.store(0);
+
+    _startWriter(file);
+}
+
+void ULogStreamWriter::stopLogging(void)
+{
+    if (!isRunning()) {
+        return;
+    }
+
+    _stopWriter();
+
+    qCDebug(ULogStreamWriterLog) << "ULog writer stopped bytes:packets:dropped:overflow:stale:discardedBytes"
+                                 << _bytesWritten.load()
+                                 << _assembler.receivedPackets()
+                                 << _assembler.droppedPackets()
+                                 << _overflowPackets.load()
+                                 << _assembler.stalePackets()
+                                 << _assembler.discardedBytes();
+    _file = NULL;
+}
+
+bool ULogStreamWriter::queuePacket(uint16_t sequence, uint8_t firstMessage, const uint8_t* data, int length)
+{
+    if (!isRunning()) {
+        return false;
+    }
+
+    uint8_t header[_packetHeaderLength];
+    header[0] = sequence & 0xFF;
+    header[1] = sequence >> 8;
+    header[2] = firstMessage;
+    header[3] = (uint8_t)qBound(0, length, (int)ULogStreamAssembler::maxPacketLength);
+
+    const uint8_t*  rgParts[2] =    { header, data };
+    quint32         rgLengths[2] =  { sizeof(header), header[3] };
+
+    if (!_queue(rgParts, rgLengths, 2)) {
+        _overflowPackets.fetchAndAddRelaxed(1);
+        return false;
+    }
+    _queuedPackets.fetchAndAddRelaxed(1);
+
+    return true;
+}
+
+/// Runs the queued packets through the assembler, writing out complete messages whenever a batch is full and once
+/// more at the end, since whatever is complete by then has waited out the batch interval
+bool ULogStreamWriter::_writeQueued(quint32 tail, quint32 count)
+{
+    uint8_t headerScratch[_packetHeaderLength];
+    uint8_t dataScratch[ULogStreamAssembler::maxPacketLength];
+    quint32 end = tail + count;
+
+    while (tail != end) {
+        const uint8_t*  header = _ringData(tail, _packetHeaderLength, headerScratch);
+        uint16_t        sequence = header[0] | (header[1] << 8);
+        uint8_t         firstMessage = header[2];
+        uint8_t         length = header[3];
+        const uint8_t*  data = _ringData(tail + _packetHeaderLength, length, dataScratch);
+
+        if (!_assembler.addPacket(sequence, firstMessage, data, length)) {
+            _fail(tr("Corrupt log header"));
+            return false;
+        }
+        if (_assembler.completeLength() >= ULogStreamAssembler::batchBytes && !_writeComplete()) {
+            return false;
+        }
+
+        // Free up the packet right away so the producer is not held up by the batch
+        tail += _packetHeaderLength + length;
+        _releaseRing(tail);
+    }
+
+    return _writeComplete();
+}
+
+/// Writes out the complete messages held by the assembler
+bool ULogStreamWriter::_writeComplete(void)
+{
+    qint64 length = _assembler.completeLength();
+
+    if (length) {
+        if (!_writeFile(_assembler.completeData(), length)) {
+            return false;
+        }
+        _assembler.consume();
+        quint64 bytesWritten = _bytesWritten.fetchAndAddRelaxed(length) + length;
+        emit bytesWrittenChanged((quint32)bytesWritten);
+    }
+
+    return true;
+}
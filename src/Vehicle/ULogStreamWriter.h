@@ -0,0 +1,76 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#ifndef ULogStreamWriter_H
+#define ULogStreamWriter_H
+
+#include <QAtomicInteger>
+#include <QLoggingCategory>
+
+#include "RingBufferedFileWriter.h"
+#include "ULogStreamAssembler.h"
+
+Q_DECLARE_LOGGING_CATEGORY(ULogStreamWriterLog)
+
+/// Assembles and writes a streamed PX4 ULog on its own thread, so high log rates don't load the GUI thread.
+///
+/// queuePacket copies the packet with a small header into the ring of a RingBufferedFileWriter. The writer thread runs
+/// the packets through a ULogStreamAssembler and writes the complete messages out in batches of
+/// ULogStreamAssembler::batchBytes, or at every batch interval when the stream is slow. If the writer falls behind and
+/// the ring fills up the packet is dropped and counted. The assembler sees the gap in the sequence numbers and writes
+/// a dropout into the log, the same as for a packet lost on the link.
+class ULogStreamWriter : public RingBufferedFileWriter
+{
+    Q_OBJECT
+
+public:
+    ULogStreamWriter(QObject* parent = NULL);
+    ~ULogStreamWriter();
+
+    /// Starts the writer thread. The file must already be open for writing and must not be touched by the
+    /// caller until stopLogging returns.
+    void startLogging(QFile* file);
+
+    /// Writes out everything which is queued, syncs the file and stops the writer thread. A message which is still
+    /// incomplete at this point is not written.
+    void stopLogging(void);
+
+    /// Queues a LOGGING_DATA packet for writing. Must only be called from a single thread.
+    /// @return false: ring is full, packet dropped
+    bool queuePacket(uint16_t sequence, uint8_t firstMessage, const uint8_t* data, int length);
+
+    quint64 bytesWritten(void) const    { return _bytesWritten.load(); }
+    quint64 queuedPackets(void) const   { return _queuedPackets.load(); }
+    quint64 overflowPackets(void) const { return _overflowPackets.load(); }     ///< Packets dropped because the ring was full
+
+    /// Assembler statistics, only valid once stopLogging returned
+    const ULogStreamAssembler& assembler(void) const { return _assembler; }
+
+signals:
+    /// Emitted from the writer thread after each batch
+    void bytesWrittenChanged(quint32 bytesWritten);
+
+protected:
+    // Override from RingBufferedFileWriter
+    bool _writeQueued(quint32 tail, quint32 count);
+
+private:
+    bool _writeComplete(void);
+
+    ULogStreamAssembler     _assembler;         ///< Only accessed by the writer thread while it runs
+
+    QAtomicInteger<quint64> _bytesWritten;
+    QAtomicInteger<quint64> _queuedPackets;
+    QAtomicInteger<quint64> _overflowPackets;
+
+    static const int _packetHeaderLength =  4;              ///< Sequence (little endian), first message, length
+    static const int _ringBufferSize =      1024 * 1024;    ///< Must be a power of 2, ~4000 full packets
+};
+
+#endif
@@ -143,7 +143,9 @@ Vehicle::Vehicle(LinkInterface*             link,
 
     _mavlink = qgcApp()->toolbox()->mavlinkProtocol();
 
-    connect(_mavlink, &MAVLinkProtocol::messageReceived,     this, &Vehicle::_mavlinkMessageReceived);
+    // We see our own messages as well as broadcasts from sysid 0
+    _mavlink->messageDispatcher()->subscribe(_id, MAVLinkMessageDispatcher::anyId, MAVLinkMessageDispatcher::anyId, this, &Vehicle::_mavlinkMessageReceived);
+    _mavlink->messageDispatcher()->subscribe(0,   MAVLinkMessageDispatcher::anyId, MAVLinkMessageDispatcher::anyId, this, &Vehicle::_mavlinkMessageReceived);
 
     connect(this, &Vehicle::_sendMessageOnLinkOnThread, this, &Vehicle::_sendMessageOnLink, Qt::QueuedConnection);
     connect(this, &Vehicle::flightModeChanged,          this, &Vehicle::_handleFlightModeChanged);
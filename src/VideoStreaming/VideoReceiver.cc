@@ -17,19 +17,63 @@
 #include "VideoReceiver.h"
 #include <QDebug>
 #include <QUrl>
+#include <QThread>
+#include <string.h>
+
+QGC_LOGGING_CATEGORY(VideoReceiverLog, "VideoReceiverLog")
+
+#if defined(QGC_GST_STREAMING)
+//-- Multi-threaded software decoder, always available
+const char* VideoReceiver::_softwareDecoder = "avdec_h264";
+
+//-- Hardware decoders in order of preference: VA-API, V4L2 M2M, OpenMAX, VideoToolbox
+const char* VideoReceiver::_hardwareDecoders[] = {
+    "vaapih264dec",
+    "v4l2h264dec",
+    "omxh264dec",
+    "vtdec_hw",
+    NULL
+};
+#endif
 
 VideoReceiver::VideoReceiver(QObject* parent)
     : QObject(parent)
+    , _decoderLatencyMsecs(-1)
+    , _framesRendered(0)
+    , _framesDropped(0)
+    , _bitrateKbps(0)
+    , _fps(0)
+    , _jitterBufferMode(JitterBufferOff)
+    , _keyframesOnly(false)
+    , _decoderThreads(0)
 #if defined(QGC_GST_STREAMING)
     , _pipeline(NULL)
     , _videoSink(NULL)
+    , _decoder(NULL)
+    , _sinkProbeId(0)
+    , _lastSinkAgeUsecs(-1)
+    , _lastSinkTimeUsecs(0)
+    , _receivedBytes(0)
+    , _dropDeltaUnits(false)
+    , _sinkFrames(0)
     , _socket(NULL)
     , _serverPresent(false)
 #endif
 {
+    for (int i = 0; i < StageCount; i++) {
+        _stageLatencyMsecs[i] = -1;
+    }
 #if defined(QGC_GST_STREAMING)
+    for (int i = 0; i < StageCount; i++) {
+        _stageProbes[i].receiver = this;
+        _stageProbes[i].stage = (LatencyStage_t)i;
+        _stageSumUsecs[i] = 0;
+        _stageSamples[i] = 0;
+    }
     _timer.setSingleShot(true);
     connect(&_timer, &QTimer::timeout, this, &VideoReceiver::_timeout);
+    _statsTimer.setInterval(1000);
+    connect(&_statsTimer, &QTimer::timeout, this, &VideoReceiver::_updateStats);
 #endif
 }
 
@@ -48,16 +92,95 @@ VideoReceiver::~VideoReceiver()
 void VideoReceiver::setVideoSink(GstElement* sink)
 {
     if (_videoSink) {
+        g_signal_handlers_disconnect_by_data(_videoSink, this);
         gst_object_unref(_videoSink);
         _videoSink = NULL;
     }
     if (sink) {
         _videoSink = sink;
         gst_object_ref_sink(_videoSink);
+        //-- The Qt Quick sink signals when a frame is handed to the UI, which is as close to paint as we get
+        if (g_signal_lookup("update", G_OBJECT_TYPE(_videoSink))) {
+            g_signal_connect(_videoSink, "update", G_CALLBACK(_onSinkUpdate), this);
+        }
     }
 }
 #endif
 
+bool VideoReceiver::hardwareDecoder() const
+{
+#if defined(QGC_GST_STREAMING)
+    return !_decoderName.isEmpty() && _decoderName != _softwareDecoder;
+#else
+    return false;
+#endif
+}
+
+double VideoReceiver::latencyMsecs() const
+{
+    for (int i = StageCount - 1; i >= 0; i--) {
+        if (_stageLatencyMsecs[i] >= 0) {
+            return _stageLatencyMsecs[i];
+        }
+    }
+    return -1;
+}
+
+QVariantList VideoReceiver::stageLatencyMsecs() const
+{
+    QVariantList latencies;
+    for (int i = 0; i < StageCount; i++) {
+        latencies.append(_stageLatencyMsecs[i]);
+    }
+    return latencies;
+}
+
+void VideoReceiver::setKeyframesOnly(bool keyframesOnly)
+{
+    if (keyframesOnly == _keyframesOnly) {
+        return;
+    }
+#if defined(QGC_GST_STREAMING)
+    _latencyMutex.lock();
+    _keyframesOnly = keyframesOnly;
+    //-- Turning it off waits for the next key frame on the streaming thread
+    if (_keyframesOnly) {
+        _dropDeltaUnits = true;
+    }
+    _latencyMutex.unlock();
+#else
+    _keyframesOnly = keyframesOnly;
+#endif
+    emit keyframesOnlyChanged();
+}
+
+void VideoReceiver::setPreferredDecoder(const QString& decoder)
+{
+    _preferredDecoder = decoder;
+#if defined(QGC_GST_STREAMING)
+    //-- Picking a decoder which failed earlier gives it another go
+    _failedDecoders.removeAll(decoder);
+#endif
+}
+
+QStringList VideoReceiver::decoderNames()
+{
+    QStringList names;
+#if defined(QGC_GST_STREAMING)
+    for (int i = 0; _hardwareDecoders[i]; i++) {
+        names << _hardwareDecoders[i];
+    }
+    names << _softwareDecoder;
+#endif
+    return names;
+}
+
+void VideoReceiver::setDecoderThreads(int threads)
+{
+    //-- Restarting here would restart every stream on each focus change, the running decoder keeps its threads
+    _decoderThreads = threads;
+}
+
 #if defined(QGC_GST_STREAMING)
 static void newPadCB(GstElement * element, GstPad* pad, gpointer data)
 {
@@ -143,9 +266,11 @@ void VideoReceiver::start()
     }
 
     bool running = false;
+    bool decoderFailed = false;
 
     GstElement*     dataSource  = NULL;
     GstCaps*        caps        = NULL;
+    GstElement*     jitterBuffer = NULL;
     GstElement*     demux       = NULL;
     GstElement*     parser      = NULL;
     GstElement*     decoder     = NULL;
@@ -177,6 +302,24 @@ void VideoReceiver::start()
             g_object_set(G_OBJECT(dataSource), "location", qPrintable(_uri), "latency", 0, "udp-reconnect", 1, "timeout", 5000000, NULL);
         }
 
+        //-- rtspsrc has its own jitter buffer, the UDP path needs one added
+        if (_jitterBufferMode != JitterBufferOff) {
+            guint latency = _jitterBufferMode == JitterBufferSmooth ? _smoothJitterMsecs : _lowLatencyJitterMsecs;
+            gboolean dropOnLatency = _jitterBufferMode == JitterBufferLowLatency;
+            if (isUdp) {
+                if ((jitterBuffer = gst_element_factory_make("rtpjitterbuffer", "rtp-jitter-buffer")) == NULL) {
+                    qCritical() << "VideoReceiver::start() failed. Error with gst_element_factory_make('rtpjitterbuffer')";
+                    break;
+                }
+                g_object_set(G_OBJECT(jitterBuffer), "latency", latency, "drop-on-latency", dropOnLatency, NULL);
+            } else {
+                g_object_set(G_OBJECT(dataSource), "latency", latency, "drop-on-latency", dropOnLatency, NULL);
+            }
+        }
+
+        //-- Drop frames which reach the sink too late to be shown on time, unless asked to show every frame
+        g_object_set(G_OBJECT(_videoSink), "qos", TRUE, "max-lateness", _jitterBufferMode == JitterBufferSmooth ? (gint64)-1 : _maxLatenessNsecs, NULL);
+
         if ((demux = gst_element_factory_make("rtph264depay", "rtp-h264-depacketizer")) == NULL) {
             qCritical() << "VideoReceiver::start() failed. Error with gst_element_factory_make('rtph264depay')";
             break;
@@ -191,27 +334,55 @@ void VideoReceiver::start()
             break;
         }
 
-        if ((decoder = gst_element_factory_make("avdec_h264", "h264-decoder")) == NULL) {
-            qCritical() << "VideoReceiver::start() failed. Error with gst_element_factory_make('avdec_h264')";
+        if ((decoder = _makeDecoder()) == NULL) {
+            qCritical() << "VideoReceiver::start() failed. No H.264 decoder available";
             break;
         }
 
         gst_bin_add_many(GST_BIN(_pipeline), dataSource, demux, parser, decoder, _videoSink, NULL);
+        _decoder = decoder;
+
+        if (jitterBuffer) {
+            gst_bin_add(GST_BIN(_pipeline), jitterBuffer);
+        }
 
         gboolean res = FALSE;
 
         if(isUdp) {
-            res = gst_element_link_many(dataSource, demux, parser, decoder, _videoSink, NULL);
+            if (jitterBuffer) {
+                res = gst_element_link_many(dataSource, jitterBuffer, demux, parser, decoder, _videoSink, NULL);
+            } else {
+                res = gst_element_link_many(dataSource, demux, parser, decoder, _videoSink, NULL);
+            }
+            if (res) {
+                _addStageProbe(dataSource, "src", StageSource);
+            }
         } else {
             res = gst_element_link_many(demux, parser, decoder, _videoSink, NULL);
         }
 
+        if (res) {
+            _addStageProbe(demux,       "sink", StageDepayloader);
+            _addStageProbe(decoder,     "sink", StageDecoderInput);
+            _addStageProbe(decoder,     "src",  StageDecoderOutput);
+            _sinkProbeId = _addStageProbe(_videoSink, "sink", StageSink);
+        }
+
+        //-- The pipeline owns the elements from here on
+        dataSource = jitterBuffer = demux = parser = decoder = NULL;
+
         if (!res) {
             qCritical() << "VideoReceiver::start() failed. Error with gst_element_link_many()";
             break;
         }
 
-        dataSource = demux = parser = decoder = NULL;
+        //-- Hardware decoders open their device here. Doing this ahead of the rest of the pipeline tells a decoder
+        //   failure apart from a source which can't start.
+        if (gst_element_set_state(_decoder, GST_STATE_READY) == GST_STATE_CHANGE_FAILURE) {
+            qCritical() << "VideoReceiver::start() failed. Decoder" << _decoderName << "could not be started";
+            decoderFailed = true;
+            break;
+        }
 
         GstBus* bus = NULL;
 
@@ -233,6 +404,8 @@ void VideoReceiver::start()
     if (!running) {
         qCritical() << "VideoReceiver::start() failed";
 
+        bool retry = decoderFailed && _fallBackFromDecoder();
+
         if (decoder != NULL) {
             gst_object_unref(decoder);
             decoder = NULL;
@@ -248,15 +421,29 @@ void VideoReceiver::start()
             demux = NULL;
         }
 
+        if (jitterBuffer != NULL) {
+            gst_object_unref(jitterBuffer);
+            jitterBuffer = NULL;
+        }
+
         if (dataSource != NULL) {
             gst_object_unref(dataSource);
             dataSource = NULL;
         }
 
         if (_pipeline != NULL) {
+            gst_element_set_state(_pipeline, GST_STATE_NULL);
             gst_object_unref(_pipeline);
             _pipeline = NULL;
         }
+        _decoder = NULL;
+
+        if (retry) {
+            start();
+        }
+    } else {
+        _statsElapsed.start();
+        _statsTimer.start();
     }
 #endif
 }
@@ -268,8 +455,33 @@ void VideoReceiver::stop()
         gst_element_set_state(_pipeline, GST_STATE_NULL);
         gst_object_unref(_pipeline);
         _pipeline = NULL;
+        _decoder = NULL;
         _serverPresent = false;
     }
+    //-- The sink outlives the pipeline, its probe must not pile up across restarts
+    if (_videoSink && _sinkProbeId) {
+        GstPad* pad = gst_element_get_static_pad(_videoSink, "sink");
+        if (pad) {
+            gst_pad_remove_probe(pad, _sinkProbeId);
+            gst_object_unref(pad);
+        }
+    }
+    _sinkProbeId = 0;
+    _statsTimer.stop();
+    _latencyMutex.lock();
+    for (int i = 0; i < StageCount; i++) {
+        _stageSumUsecs[i] = 0;
+        _stageSamples[i] = 0;
+    }
+    _lastSinkAgeUsecs = -1;
+    _receivedBytes = 0;
+    _dropDeltaUnits = _keyframesOnly;
+    _sinkFrames = 0;
+    _latencyMutex.unlock();
+    if (!_decoderName.isEmpty()) {
+        _decoderName.clear();
+        emit decoderNameChanged();
+    }
 #endif
 }
 
@@ -277,6 +489,10 @@ void VideoReceiver::setUri(const QString & uri)
 {
     stop();
     _uri = uri;
+#if defined(QGC_GST_STREAMING)
+    //-- A different stream may well decode fine in hardware
+    _failedDecoders.clear();
+#endif
 }
 
 #if defined(QGC_GST_STREAMING)
@@ -287,15 +503,29 @@ void VideoReceiver::_onBusMessage(GstMessage* msg)
         stop();
         break;
     case GST_MESSAGE_ERROR:
+    {
+        bool decoderFailed = false;
         do {
             gchar* debug;
             GError* error;
             gst_message_parse_error(msg, &error, &debug);
-            g_free(debug);
             qCritical() << error->message;
+            decoderFailed = _isDecoderError(msg, error, debug);
+            g_free(debug);
             g_error_free(error);
         } while(0);
-        stop();
+        if (decoderFailed && _fallBackFromDecoder()) {
+            //-- Restart once we are out of the bus callback for this pipeline
+            stop();
+            QTimer::singleShot(0, this, &VideoReceiver::start);
+        } else {
+            stop();
+        }
+        break;
+    }
+    case GST_MESSAGE_QOS:
+        //-- Sinks and decoders post one for each frame they drop for being late
+        _framesDropped++;
         break;
     default:
         break;
@@ -313,3 +543,182 @@ gboolean VideoReceiver::_onBusMessage(GstBus* bus, GstMessage* msg, gpointer dat
     return TRUE;
 }
 #endif
+
+#if defined(QGC_GST_STREAMING)
+/// Creates the preferred H.264 decoder which is available, the one set through setPreferredDecoder first
+GstElement* VideoReceiver::_makeDecoder()
+{
+    QStringList candidates;
+    if (!_preferredDecoder.isEmpty()) {
+        candidates << _preferredDecoder;
+    }
+    candidates << decoderNames();
+
+    foreach (const QString& name, candidates) {
+        if (_failedDecoders.contains(name)) {
+            continue;
+        }
+        GstElement* decoder = gst_element_factory_make(qPrintable(name), "h264-decoder");
+        if (decoder) {
+            if (name == _softwareDecoder) {
+                //-- Spread decoding across all cores instead of relying on libav's own detection
+                g_object_set(G_OBJECT(decoder), "max-threads", _decoderThreads > 0 ? _decoderThreads : QThread::idealThreadCount(), NULL);
+            }
+            qCDebug(VideoReceiverLog) << "Using decoder" << name;
+            _decoderName = name;
+            emit decoderNameChanged();
+            return decoder;
+        }
+    }
+
+    return NULL;
+}
+
+/// Only errors from the decoder, or caps which could not be negotiated with it, move on to the next decoder. A hardware
+/// decoder which can't handle the stream usually posts a stream error itself. Failed negotiation is posted by the
+/// source as a stream error with a not-negotiated flow return.
+bool VideoReceiver::_isDecoderError(GstMessage* msg, GError* error, const gchar* debug)
+{
+    if (!_decoder) {
+        return false;
+    }
+    if (g_error_matches(error, GST_CORE_ERROR, GST_CORE_ERROR_NEGOTIATION) ||
+            (g_error_matches(error, GST_STREAM_ERROR, GST_STREAM_ERROR_FAILED) && debug && strstr(debug, "not-negotiated"))) {
+        return true;
+    }
+
+    //-- Decoders may be bins, in which case the error comes from one of their children
+    bool fromDecoder = false;
+    for (GstObject* object = GST_MESSAGE_SRC(msg); object; object = GST_OBJECT_PARENT(object)) {
+        if (object == GST_OBJECT(_decoder)) {
+            fromDecoder = true;
+            break;
+        }
+    }
+    if (!fromDecoder) {
+        return false;
+    }
+    if (error->domain != GST_STREAM_ERROR) {
+        //-- Library and resource errors, a hardware decoder which could not be set up
+        return true;
+    }
+    return error->code == GST_STREAM_ERROR_NOT_IMPLEMENTED ||
+            error->code == GST_STREAM_ERROR_DECODE ||
+            error->code == GST_STREAM_ERROR_FORMAT ||
+            error->code == GST_STREAM_ERROR_CODEC_NOT_FOUND;
+}
+
+/// Marks the current decoder as failed so the next start falls back to the next one in line
+/// @return true: there is a decoder to fall back to
+bool VideoReceiver::_fallBackFromDecoder()
+{
+    if (!hardwareDecoder() || _failedDecoders.contains(_decoderName)) {
+        return false;
+    }
+    qWarning() << "VideoReceiver decoder" << _decoderName << "failed, falling back";
+    _failedDecoders << _decoderName;
+    return true;
+}
+
+/// @return Probe id, 0 if the element has no such pad
+gulong VideoReceiver::_addStageProbe(GstElement* element, const char* padName, LatencyStage_t stage)
+{
+    gulong probeId = 0;
+    GstPad* pad = gst_element_get_static_pad(element, padName);
+    if (pad) {
+        probeId = gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, _stageProbe, &_stageProbes[stage], NULL);
+        gst_object_unref(pad);
+    }
+    return probeId;
+}
+
+/// Live sources time stamp buffers with the running time they arrived at, and all elements downstream keep that
+/// time stamp. The age of a buffer at a pad is therefore the current running time less its pts.
+/// The probe ahead of the depayloader also counts received bytes, the one ahead of the decoder drops delta frames for
+/// key frame only decoding and the one ahead of the sink counts rendered frames.
+GstPadProbeReturn VideoReceiver::_stageProbe(GstPad* pad, GstPadProbeInfo* info, gpointer data)
+{
+    StageProbe_t* probe = (StageProbe_t*)data;
+    VideoReceiver* pThis = probe->receiver;
+    GstBuffer* buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    GstElement* element = GST_ELEMENT(GST_OBJECT_PARENT(pad));
+    if (!buffer || !element) {
+        return GST_PAD_PROBE_OK;
+    }
+
+    if (probe->stage == StageDepayloader) {
+        QMutexLocker lock(&pThis->_latencyMutex);
+        pThis->_receivedBytes += gst_buffer_get_size(buffer);
+    } else if (probe->stage == StageSink) {
+        QMutexLocker lock(&pThis->_latencyMutex);
+        pThis->_sinkFrames++;
+    } else if (probe->stage == StageDecoderInput) {
+        QMutexLocker lock(&pThis->_latencyMutex);
+        if (!GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT)) {
+            pThis->_dropDeltaUnits = pThis->_keyframesOnly;
+        } else if (pThis->_dropDeltaUnits) {
+            return GST_PAD_PROBE_DROP;
+        }
+    }
+
+    if (!GST_BUFFER_PTS_IS_VALID(buffer)) {
+        return GST_PAD_PROBE_OK;
+    }
+    GstClock* clock = gst_element_get_clock(element);
+    if (!clock) {
+        return GST_PAD_PROBE_OK;
+    }
+    GstClockTime runningTime = gst_clock_get_time(clock) - gst_element_get_base_time(element);
+    gst_object_unref(clock);
+
+    gint64 ageUsecs = qMax(GST_CLOCK_DIFF(GST_BUFFER_PTS(buffer), runningTime), (GstClockTimeDiff)0) / GST_USECOND;
+    QMutexLocker lock(&pThis->_latencyMutex);
+    pThis->_stageSumUsecs[probe->stage] += ageUsecs;
+    pThis->_stageSamples[probe->stage]++;
+    if (probe->stage == StageSink) {
+        pThis->_lastSinkAgeUsecs = ageUsecs;
+        pThis->_lastSinkTimeUsecs = g_get_monotonic_time();
+    }
+    return GST_PAD_PROBE_OK;
+}
+
+/// Runs on the UI thread once the sink handed the frame on for painting
+void VideoReceiver::_onSinkUpdate(GstElement* sink, gpointer data)
+{
+    Q_UNUSED(sink);
+    VideoReceiver* pThis = (VideoReceiver*)data;
+    QMutexLocker lock(&pThis->_latencyMutex);
+    if (pThis->_lastSinkAgeUsecs >= 0) {
+        pThis->_stageSumUsecs[StagePaint] += pThis->_lastSinkAgeUsecs + (g_get_monotonic_time() - pThis->_lastSinkTimeUsecs);
+        pThis->_stageSamples[StagePaint]++;
+        pThis->_lastSinkAgeUsecs = -1;
+    }
+}
+
+void VideoReceiver::_updateStats()
+{
+    qint64 elapsedMsecs = qMax(_statsElapsed.restart(), (qint64)1);
+
+    _latencyMutex.lock();
+    _bitrateKbps = (double)_receivedBytes * 8.0 / (double)elapsedMsecs;
+    _receivedBytes = 0;
+    //-- GstBaseSink only has a stats property from GStreamer 1.18 on, so the sink probe counts frames instead
+    _framesRendered += _sinkFrames;
+    _fps = (double)_sinkFrames * 1000.0 / (double)elapsedMsecs;
+    _sinkFrames = 0;
+    for (int i = 0; i < StageCount; i++) {
+        if (_stageSamples[i]) {
+            _stageLatencyMsecs[i] = (double)_stageSumUsecs[i] / (double)_stageSamples[i] / 1000.0;
+            _stageSumUsecs[i] = 0;
+            _stageSamples[i] = 0;
+        }
+    }
+    _latencyMutex.unlock();
+
+    if (_stageLatencyMsecs[StageDecoderInput] >= 0 && _stageLatencyMsecs[StageDecoderOutput] >= 0) {
+        _decoderLatencyMsecs = qMax(_stageLatencyMsecs[StageDecoderOutput] - _stageLatencyMsecs[StageDecoderInput], 0.0);
+    }
+
+    emit statsChanged();
+}
+#endif
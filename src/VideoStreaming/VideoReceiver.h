@@ -20,11 +20,19 @@
 #include <QObject>
 #include <QTimer>
 #include <QTcpSocket>
+#include <QStringList>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <QVariantList>
+
+#include "QGCLoggingCategory.h"
 
 #if defined(QGC_GST_STREAMING)
 #include <gst/gst.h>
 #endif
 
+Q_DECLARE_LOGGING_CATEGORY(VideoReceiverLog)
+
 class VideoReceiver : public QObject
 {
     Q_OBJECT
@@ -32,10 +40,85 @@ public:
     explicit VideoReceiver(QObject* parent = 0);
     ~VideoReceiver();
 
+    typedef enum {
+        JitterBufferOff,            ///< No jitter buffer, frames are shown as soon as they are decoded
+        JitterBufferLowLatency,     ///< Short jitter buffer, packets and frames which arrive too late are dropped
+        JitterBufferSmooth,         ///< Long jitter buffer for links with a lot of jitter, nothing is dropped
+    } JitterBufferMode_t;
+
+    /// Points in the pipeline where the age of a frame is measured. The age is the time since its first packet
+    /// arrived at the source, so each stage includes all stages before it.
+    typedef enum {
+        StageSource,                ///< Leaving the udp source, RTSP streams have no measurement here
+        StageDepayloader,           ///< Leaving the jitter buffer and entering the depayloader
+        StageDecoderInput,
+        StageDecoderOutput,
+        StageSink,                  ///< Entering the video sink
+        StagePaint,                 ///< Handed to the UI for painting, only for sinks which signal "update"
+        StageCount
+    } LatencyStage_t;
+
+    Q_PROPERTY(QString  decoderName         READ decoderName            NOTIFY decoderNameChanged)
+    Q_PROPERTY(bool     hardwareDecoder     READ hardwareDecoder        NOTIFY decoderNameChanged)
+    Q_PROPERTY(double   decoderLatencyMsecs READ decoderLatencyMsecs    NOTIFY statsChanged)
+    Q_PROPERTY(int      framesRendered      READ framesRendered         NOTIFY statsChanged)
+    Q_PROPERTY(int      framesDropped       READ framesDropped          NOTIFY statsChanged)
+    Q_PROPERTY(double   latencyMsecs        READ latencyMsecs           NOTIFY statsChanged)
+    Q_PROPERTY(QVariantList stageLatencyMsecs READ stageLatencyMsecs    NOTIFY statsChanged)
+    Q_PROPERTY(double   bitrateKbps         READ bitrateKbps            NOTIFY statsChanged)
+    Q_PROPERTY(double   fps                 READ fps                    NOTIFY statsChanged)
+    Q_PROPERTY(bool     keyframesOnly       READ keyframesOnly          NOTIFY keyframesOnlyChanged)
+
+    /// Name of the decoder element in use, empty if not streaming
+    QString decoderName         (void) const { return _decoderName; }
+    bool    hardwareDecoder     (void) const;
+    /// Average time a frame spent in the decoder over the last stats interval, -1 if not known
+    double  decoderLatencyMsecs (void) const { return _decoderLatencyMsecs; }
+    /// Frames which reached the sink, counted by the sink pad probe
+    int     framesRendered      (void) const { return _framesRendered; }
+    /// Frames dropped for being late, counted from QoS messages
+    int     framesDropped       (void) const { return _framesDropped; }
+    /// Average age of a frame at the last measured stage over the last stats interval, -1 if not known
+    double  latencyMsecs        (void) const;
+    /// Average age of a frame at each stage over the last stats interval, by LatencyStage_t, -1 if not known
+    QVariantList stageLatencyMsecs  (void) const;
+    double  stageLatencyMsecs   (LatencyStage_t stage) const { return _stageLatencyMsecs[stage]; }
+    /// Received stream bitrate over the last stats interval
+    double  bitrateKbps         (void) const { return _bitrateKbps; }
+    /// Frames rendered per second over the last stats interval
+    double  fps                 (void) const { return _fps; }
+
+    JitterBufferMode_t jitterBufferMode (void) const { return _jitterBufferMode; }
+    /// Takes effect the next time the stream is started
+    void    setJitterBufferMode (JitterBufferMode_t mode) { _jitterBufferMode = mode; }
+
+    bool    keyframesOnly       (void) const { return _keyframesOnly; }
+    /// Only decodes key frames, for streams which are not in focus. Delta frames are dropped ahead of the decoder
+    /// until the next key frame after this is turned off again.
+    void    setKeyframesOnly    (bool keyframesOnly);
+
+    QString preferredDecoder    (void) const { return _preferredDecoder; }
+    /// Decoder element tried ahead of the built in order, empty for the built in order. Takes effect the next time the
+    /// stream is started.
+    void    setPreferredDecoder (const QString& decoder);
+
+    /// @return Names of the decoder elements tried, in order of preference
+    static QStringList decoderNames(void);
+
+    int     decoderThreads      (void) const { return _decoderThreads; }
+    /// Number of threads the software decoder may use, 0 for one per core. Takes effect the next time the stream is
+    /// started.
+    void    setDecoderThreads   (int threads);
+
 #if defined(QGC_GST_STREAMING)
     void setVideoSink(GstElement* sink);
 #endif
 
+signals:
+    void decoderNameChanged (void);
+    void statsChanged       (void);
+    void keyframesOnlyChanged(void);
+
 public slots:
     void start      ();
     void stop       ();
@@ -46,6 +129,7 @@ private slots:
     void _timeout       ();
     void _connected     ();
     void _socketError   (QAbstractSocket::SocketError socketError);
+    void _updateStats   ();
 #endif
 
 private:
@@ -53,13 +137,57 @@ private:
 #if defined(QGC_GST_STREAMING)
     void            _onBusMessage(GstMessage* message);
     static gboolean _onBusMessage(GstBus* bus, GstMessage* msg, gpointer data);
+    GstElement*     _makeDecoder    ();
+    bool            _fallBackFromDecoder();
+    bool            _isDecoderError (GstMessage* msg, GError* error, const gchar* debug);
+    gulong          _addStageProbe  (GstElement* element, const char* padName, LatencyStage_t stage);
+    static GstPadProbeReturn _stageProbe(GstPad* pad, GstPadProbeInfo* info, gpointer data);
+    static void     _onSinkUpdate   (GstElement* sink, gpointer data);
 #endif
 
     QString     _uri;
+    QString     _decoderName;
+    QString     _preferredDecoder;
+    double      _decoderLatencyMsecs;
+    double      _stageLatencyMsecs[StageCount];
+    int         _framesRendered;
+    int         _framesDropped;
+    double      _bitrateKbps;
+    double      _fps;
+    JitterBufferMode_t _jitterBufferMode;
+    bool        _keyframesOnly;
+    int         _decoderThreads;
 
 #if defined(QGC_GST_STREAMING)
     GstElement* _pipeline;
     GstElement* _videoSink;
+    GstElement* _decoder;           ///< Owned by _pipeline
+    QStringList _failedDecoders;    ///< Hardware decoders which failed to start or negotiate for the current uri
+
+    //-- Frame age per stage, measured on the streaming threads
+    typedef struct {
+        VideoReceiver*  receiver;
+        LatencyStage_t  stage;
+    } StageProbe_t;
+
+    StageProbe_t    _stageProbes[StageCount];
+    gulong          _sinkProbeId;
+    QMutex          _latencyMutex;
+    gint64          _stageSumUsecs[StageCount];
+    int             _stageSamples[StageCount];
+    gint64          _lastSinkAgeUsecs;      ///< Age of the last frame entering the sink
+    gint64          _lastSinkTimeUsecs;     ///< Monotonic time it entered the sink
+    gint64          _receivedBytes;
+    bool            _dropDeltaUnits;        ///< Streaming thread copy of _keyframesOnly, held until the next key frame
+    int             _sinkFrames;            ///< Frames which entered the sink since the last stats interval
+    QElapsedTimer   _statsElapsed;
+    QTimer          _statsTimer;
+
+    static const char*  _softwareDecoder;
+    static const char*  _hardwareDecoders[];
+    static const int    _lowLatencyJitterMsecs  = 50;
+    static const int    _smoothJitterMsecs      = 300;
+    static const gint64 _maxLatenessNsecs       = 20 * GST_MSECOND;    ///< Late frames are dropped past this
 #endif
 
     //-- Wait for Video Server to show up before starting
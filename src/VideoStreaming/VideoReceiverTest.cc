@@ -0,0 +1,201 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "VideoReceiverTest.h"
+
+#include <QUdpSocket>
+
+VideoReceiverTest::VideoReceiverTest(void)
+#if defined(QGC_GST_STREAMING)
+    : _senderSumUsecs(0)
+    , _senderSamples(0)
+#endif
+{
+
+}
+
+void VideoReceiverTest::_multiStream_test(void)
+{
+#if defined(QGC_GST_STREAMING)
+    QString missingElement = _missingElement();
+    if (!missingElement.isEmpty()) {
+        QSKIP(qPrintable(QString("GStreamer element %1 not available").arg(missingElement)));
+    }
+
+    // One focused stream decoding every frame plus thumbnails decoding key frames only, one key frame per second
+    const int streamCount = 4;
+    GstElement*     senders[streamCount];
+    VideoReceiver*  receivers[streamCount];
+
+    for (int i=0; i<streamCount; i++) {
+        quint16 port;
+        senders[i] = _makeSender(port);
+        QVERIFY(senders[i]);
+
+        GstElement* fakeSink = gst_element_factory_make("fakesink", NULL);
+        g_object_set(G_OBJECT(fakeSink), "sync", TRUE, NULL);
+        receivers[i] = new VideoReceiver(this);
+        receivers[i]->setVideoSink(fakeSink);
+        receivers[i]->setKeyframesOnly(i != 0);
+        receivers[i]->setDecoderThreads(i == 0 ? 0 : 1);
+        receivers[i]->setUri(QString("udp://127.0.0.1:%1").arg(port));
+        receivers[i]->start();
+        QVERIFY(gst_element_set_state(senders[i], GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE);
+    }
+
+    QTest::qWait(4000);
+
+    for (int i=0; i<streamCount; i++) {
+        gst_element_set_state(senders[i], GST_STATE_NULL);
+        gst_object_unref(senders[i]);
+        receivers[i]->stop();
+
+        QVERIFY(receivers[i]->framesRendered() > 0);
+        QVERIFY(receivers[i]->bitrateKbps() > 0);
+    }
+
+    // Thumbnails get a frame per key frame, the focused stream all 30
+    for (int i=1; i<streamCount; i++) {
+        QVERIFY(receivers[i]->fps() < receivers[0]->fps() / 2);
+        QVERIFY(receivers[i]->framesRendered() < receivers[0]->framesRendered() / 2);
+    }
+
+    for (int i=0; i<streamCount; i++) {
+        delete receivers[i];
+    }
+#else
+    QSKIP("Built without video streaming");
+#endif
+}
+
+void VideoReceiverTest::_latency_benchmark(void)
+{
+#if defined(QGC_GST_STREAMING)
+    QString missingElement = _missingElement();
+    if (!missingElement.isEmpty()) {
+        QSKIP(qPrintable(QString("GStreamer element %1 not available").arg(missingElement)));
+    }
+
+    _benchmark(VideoReceiver::JitterBufferOff);
+    _benchmark(VideoReceiver::JitterBufferLowLatency);
+    _benchmark(VideoReceiver::JitterBufferSmooth);
+#else
+    QSKIP("Built without video streaming");
+#endif
+}
+
+#if defined(QGC_GST_STREAMING)
+/// @return Name of the first element the tests need which is not installed, empty if all are
+QString VideoReceiverTest::_missingElement(void)
+{
+    const char* requiredElements[] = { "videotestsrc", "x264enc", "rtph264pay", "udpsink", "fakesink", NULL };
+    for (int i = 0; requiredElements[i]; i++) {
+        GstElementFactory* factory = gst_element_factory_find(requiredElements[i]);
+        if (!factory) {
+            return requiredElements[i];
+        }
+        gst_object_unref(factory);
+    }
+    return QString();
+}
+
+/// Creates a videotestsrc H.264 RTP sender to a free loopback port, with its udpsink named "sink"
+/// @return Sender pipeline, not started yet, NULL on error
+GstElement* VideoReceiverTest::_makeSender(quint16& port)
+{
+    // Let the OS pick a free port
+    QUdpSocket socket;
+    if (!socket.bind(QHostAddress::LocalHost, 0)) {
+        return NULL;
+    }
+    port = socket.localPort();
+    socket.close();
+
+    QString senderDescription = QString("videotestsrc is-live=true ! video/x-raw,width=1280,height=720,framerate=30/1 ! "
+                                        "x264enc tune=zerolatency speed-preset=ultrafast key-int-max=30 ! rtph264pay config-interval=1 ! "
+                                        "udpsink name=sink host=127.0.0.1 port=%1").arg(port);
+    GError* error = NULL;
+    GstElement* sender = gst_parse_launch(qPrintable(senderDescription), &error);
+    if (error) {
+        qWarning() << error->message;
+        g_error_free(error);
+    }
+    return sender;
+}
+
+void VideoReceiverTest::_benchmark(VideoReceiver::JitterBufferMode_t mode)
+{
+    quint16 port;
+    GstElement* sender = _makeSender(port);
+    QVERIFY(sender);
+
+    // Sender side age is the time from capture to leaving the udp sink
+    _senderSumUsecs = 0;
+    _senderSamples = 0;
+    GstElement* udpSink = gst_bin_get_by_name(GST_BIN(sender), "sink");
+    QVERIFY(udpSink);
+    GstPad* pad = gst_element_get_static_pad(udpSink, "sink");
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, _senderProbe, this, NULL);
+    gst_object_unref(pad);
+    gst_object_unref(udpSink);
+
+    VideoReceiver receiver;
+    GstElement* fakeSink = gst_element_factory_make("fakesink", NULL);
+    g_object_set(G_OBJECT(fakeSink), "sync", TRUE, NULL);
+    receiver.setVideoSink(fakeSink);
+    receiver.setJitterBufferMode(mode);
+    receiver.setUri(QString("udp://127.0.0.1:%1").arg(port));
+    receiver.start();
+
+    QVERIFY(gst_element_set_state(sender, GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE);
+
+    // Skip the first stats while the encoder and the jitter buffer settle
+    QTest::qWait(3000);
+    _senderMutex.lock();
+    _senderSumUsecs = 0;
+    _senderSamples = 0;
+    _senderMutex.unlock();
+    QTest::qWait(3000);
+
+    gst_element_set_state(sender, GST_STATE_NULL);
+    double senderMsecs = _senderSamples ? (double)_senderSumUsecs / (double)_senderSamples / 1000.0 : -1;
+
+    gst_object_unref(sender);
+    receiver.stop();
+
+    QVERIFY(receiver.framesRendered() > 0);
+    QVERIFY(receiver.stageLatencyMsecs(VideoReceiver::StageSink) >= 0);
+
+    qDebug() << "Jitter buffer mode" << mode
+             << "decoder" << receiver.decoderName()
+             << "stage latencies (msecs)" << receiver.stageLatencyMsecs()
+             << "sender msecs" << senderMsecs
+             << "end to end msecs" << senderMsecs + receiver.latencyMsecs()
+             << "rendered" << receiver.framesRendered()
+             << "dropped" << receiver.framesDropped();
+}
+
+GstPadProbeReturn VideoReceiverTest::_senderProbe(GstPad* pad, GstPadProbeInfo* info, gpointer data)
+{
+    VideoReceiverTest* pThis = (VideoReceiverTest*)data;
+    GstBuffer* buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    GstElement* element = GST_ELEMENT(GST_OBJECT_PARENT(pad));
+    if (buffer && GST_BUFFER_PTS_IS_VALID(buffer) && element) {
+        GstClock* clock = gst_element_get_clock(element);
+        if (clock) {
+            GstClockTime runningTime = gst_clock_get_time(clock) - gst_element_get_base_time(element);
+            gst_object_unref(clock);
+            QMutexLocker lock(&pThis->_senderMutex);
+            pThis->_senderSumUsecs += GST_CLOCK_DIFF(GST_BUFFER_PTS(buffer), runningTime) / GST_USECOND;
+            pThis->_senderSamples++;
+        }
+    }
+    return GST_PAD_PROBE_OK;
+}
+#endif
@@ -0,0 +1,47 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#ifndef VideoReceiverTest_H
+#define VideoReceiverTest_H
+
+#include "UnitTest.h"
+#include "VideoReceiver.h"
+
+#include <QMutex>
+
+/// Unit test and latency benchmark for VideoReceiver, streaming videotestsrc as H.264 over loopback UDP into receivers.
+///
+/// The unit test runs several streams side by side, with all but one decoding key frames only. The latency benchmark
+/// only runs with --unittest-benchmark, it logs the frame age at each stage for every jitter buffer mode.
+class VideoReceiverTest : public UnitTest
+{
+    Q_OBJECT
+
+public:
+    VideoReceiverTest(void);
+
+private slots:
+    void _multiStream_test(void);
+    void _latency_benchmark(void);
+
+private:
+#if defined(QGC_GST_STREAMING)
+    QString     _missingElement (void);
+    GstElement* _makeSender     (quint16& port);
+    void        _benchmark      (VideoReceiver::JitterBufferMode_t mode);
+
+    static GstPadProbeReturn _senderProbe(GstPad* pad, GstPadProbeInfo* info, gpointer data);
+
+    QMutex  _senderMutex;
+    gint64  _senderSumUsecs;
+    int     _senderSamples;
+#endif
+};
+
+#endif
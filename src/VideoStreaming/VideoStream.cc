@@ -0,0 +1,83 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file
+ *   @brief One of several video streams shown at the same time
+ */
+
+#include "VideoStream.h"
+
+#include <time.h>
+
+//-----------------------------------------------------------------------------
+VideoStream::VideoStream(const QString& uri, QObject* parent)
+    : QObject(parent)
+    , _uri(uri)
+    , _videoSurface(new VideoSurface(this))
+    , _videoReceiver(new VideoReceiver(this))
+    , _videoRunning(false)
+{
+#if defined(QGC_GST_STREAMING)
+    _videoReceiver->setVideoSink(_videoSurface->videoSink());
+    _videoReceiver->setUri(_uri);
+    connect(&_frameTimer, &QTimer::timeout, this, &VideoStream::_updateTimer);
+#endif
+}
+
+//-----------------------------------------------------------------------------
+VideoStream::~VideoStream()
+{
+    stop();
+}
+
+//-----------------------------------------------------------------------------
+void
+VideoStream::start()
+{
+    _videoReceiver->start();
+#if defined(QGC_GST_STREAMING)
+    _frameTimer.start(1000);
+#endif
+}
+
+//-----------------------------------------------------------------------------
+void
+VideoStream::stop()
+{
+#if defined(QGC_GST_STREAMING)
+    _frameTimer.stop();
+#endif
+    _videoReceiver->stop();
+    if(_videoRunning) {
+        _videoRunning = false;
+        emit videoRunningChanged();
+    }
+}
+
+//-----------------------------------------------------------------------------
+//-- Same frame watchdog as the VideoManager uses for its main stream
+void
+VideoStream::_updateTimer()
+{
+#if defined(QGC_GST_STREAMING)
+    if(_videoRunning) {
+        if(time(0) - _videoSurface->lastFrame() > 2) {
+            _videoRunning = false;
+            _videoSurface->setLastFrame(0);
+            emit videoRunningChanged();
+            _videoReceiver->start();
+        }
+    } else if(_videoSurface->lastFrame()) {
+        _videoRunning = true;
+        emit videoRunningChanged();
+    }
+#endif
+}
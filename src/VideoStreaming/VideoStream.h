@@ -0,0 +1,59 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file
+ *   @brief One of several video streams shown at the same time
+ */
+
+#ifndef VIDEOSTREAM_H
+#define VIDEOSTREAM_H
+
+#include <QObject>
+
+#include "VideoSurface.h"
+#include "VideoReceiver.h"
+
+class VideoStream : public QObject
+{
+    Q_OBJECT
+public:
+    explicit VideoStream(const QString& uri, QObject* parent = 0);
+    ~VideoStream();
+
+    Q_PROPERTY(QString          uri             READ    uri                         CONSTANT)
+    Q_PROPERTY(bool             videoRunning    READ    videoRunning                NOTIFY videoRunningChanged)
+    Q_PROPERTY(VideoSurface*    videoSurface    MEMBER  _videoSurface               CONSTANT)
+    Q_PROPERTY(VideoReceiver*   videoReceiver   MEMBER  _videoReceiver              CONSTANT)
+
+    QString         uri             () { return _uri; }
+    bool            videoRunning    () { return _videoRunning; }
+    VideoReceiver*  videoReceiver   () { return _videoReceiver; }
+
+    void            start           ();
+    void            stop            ();
+
+signals:
+    void videoRunningChanged        ();
+
+private slots:
+    void _updateTimer               ();
+
+private:
+    QString         _uri;
+    VideoSurface*   _videoSurface;
+    VideoReceiver*  _videoReceiver;
+    bool            _videoRunning;
+#if defined(QGC_GST_STREAMING)
+    QTimer          _frameTimer;
+#endif
+};
+
+#endif // VIDEOSTREAM_H
@@ -82,6 +82,43 @@ inline const char * qtvideosink_glsl_rgbxFragmentShader()
     "}\n";
 }
 
+// Y in the luminance texture, interleaved UV in the luminance/alpha texture
+inline const char * qtvideosink_glsl_nv12FragmentShader()
+{
+    return
+    "uniform sampler2D yTexture;\n"
+    "uniform sampler2D uvTexture;\n"
+    "uniform mediump mat4 colorMatrix;\n"
+    "uniform lowp float opacity;\n"
+    "varying highp vec2 qt_TexCoord;\n"
+    "void main(void)\n"
+    "{\n"
+    "    highp vec4 color = vec4(\n"
+    "           texture2D(yTexture, qt_TexCoord.st).r,\n"
+    "           texture2D(uvTexture, qt_TexCoord.st).ra,\n"
+    "           1.0);\n"
+    "    gl_FragColor = colorMatrix * color * opacity;\n"
+    "}\n";
+}
+
+inline const char * qtvideosink_glsl_nv21FragmentShader()
+{
+    return
+    "uniform sampler2D yTexture;\n"
+    "uniform sampler2D uvTexture;\n"
+    "uniform mediump mat4 colorMatrix;\n"
+    "uniform lowp float opacity;\n"
+    "varying highp vec2 qt_TexCoord;\n"
+    "void main(void)\n"
+    "{\n"
+    "    highp vec4 color = vec4(\n"
+    "           texture2D(yTexture, qt_TexCoord.st).r,\n"
+    "           texture2D(uvTexture, qt_TexCoord.st).ar,\n"
+    "           1.0);\n"
+    "    gl_FragColor = colorMatrix * color * opacity;\n"
+    "}\n";
+}
+
 inline const char * qtvideosink_glsl_yuvPlanarFragmentShader()
 {
     return
@@ -117,6 +154,7 @@ public:
             program()->setUniformValue(m_id_yTexture, 0);
             program()->setUniformValue(m_id_uTexture, 1);
             program()->setUniformValue(m_id_vTexture, 2);
+            program()->setUniformValue(m_id_uvTexture, 1);
         }
 
         if (state.isOpacityDirty()) {
@@ -149,6 +187,7 @@ protected:
         m_id_yTexture = program()->uniformLocation("yTexture");
         m_id_uTexture = program()->uniformLocation("uTexture");
         m_id_vTexture = program()->uniformLocation("vTexture");
+        m_id_uvTexture = program()->uniformLocation("uvTexture");
         m_id_colorMatrix = program()->uniformLocation("colorMatrix");
         m_id_opacity = program()->uniformLocation("opacity");
     }
@@ -162,6 +201,7 @@ protected:
     int m_id_yTexture;
     int m_id_uTexture;
     int m_id_vTexture;
+    int m_id_uvTexture;
     int m_id_colorMatrix;
     int m_id_opacity;
 };
@@ -233,6 +273,16 @@ VideoMaterial *VideoMaterial::create(const BufferFormat & format)
             format.frameSize());
         break;
 
+    // YUV 420 semi-planar, as put out by most hardware decoders
+    case GST_VIDEO_FORMAT_NV12:
+        material = new VideoMaterialImpl<qtvideosink_glsl_nv12FragmentShader>;
+        material->initYuv420SpTextureInfo(format.videoInfo());
+        break;
+    case GST_VIDEO_FORMAT_NV21:
+        material = new VideoMaterialImpl<qtvideosink_glsl_nv21FragmentShader>;
+        material->initYuv420SpTextureInfo(format.videoInfo());
+        break;
+
     default:
         Q_ASSERT(false);
         break;
@@ -244,13 +294,15 @@ VideoMaterial *VideoMaterial::create(const BufferFormat & format)
 
 VideoMaterial::VideoMaterial()
     : m_frame(0)
+    , m_frameDirty(false)
     , m_textureCount(0)
-    , m_textureFormat(0)
-    , m_textureInternalFormat(0)
+    , m_texturesAllocated(false)
     , m_textureType(0)
     , m_colorMatrixType(GST_VIDEO_COLOR_MATRIX_UNKNOWN)
 {
     memset(m_textureIds, 0, sizeof(m_textureIds));
+    memset(m_textureFormats, 0, sizeof(m_textureFormats));
+    memset(m_textureInternalFormats, 0, sizeof(m_textureInternalFormats));
     setFlag(Blending, false);
 }
 
@@ -296,8 +348,8 @@ void VideoMaterial::initRgbTextureInfo(
     }
 #endif
 
-    m_textureInternalFormat = internalFormat;
-    m_textureFormat = format;
+    m_textureInternalFormats[0] = internalFormat;
+    m_textureFormats[0] = format;
     m_textureType = type;
     m_textureCount = 1;
     m_textureWidths[0] = size.width();
@@ -310,8 +362,10 @@ void VideoMaterial::initYuv420PTextureInfo(bool uvSwapped, const QSize &size)
     int bytesPerLine = (size.width() + 3) & ~3;
     int bytesPerLine2 = (size.width() / 2 + 3) & ~3;
 
-    m_textureInternalFormat = GL_LUMINANCE;
-    m_textureFormat = GL_LUMINANCE;
+    for (int i = 0; i < 3; i++) {
+        m_textureInternalFormats[i] = GL_LUMINANCE;
+        m_textureFormats[i] = GL_LUMINANCE;
+    }
     m_textureType = GL_UNSIGNED_BYTE;
     m_textureCount = 3;
     m_textureWidths[0] = bytesPerLine;
@@ -328,6 +382,26 @@ void VideoMaterial::initYuv420PTextureInfo(bool uvSwapped, const QSize &size)
       qSwap (m_textureOffsets[1], m_textureOffsets[2]);
 }
 
+void VideoMaterial::initYuv420SpTextureInfo(const GstVideoInfo &info)
+{
+    m_textureType = GL_UNSIGNED_BYTE;
+    m_textureCount = 2;
+
+    // Full resolution luma, one byte per pixel
+    m_textureInternalFormats[0] = GL_LUMINANCE;
+    m_textureFormats[0] = GL_LUMINANCE;
+    m_textureWidths[0] = GST_VIDEO_INFO_PLANE_STRIDE(&info, 0);
+    m_textureHeights[0] = GST_VIDEO_INFO_HEIGHT(&info);
+    m_textureOffsets[0] = GST_VIDEO_INFO_PLANE_OFFSET(&info, 0);
+
+    // Half resolution chroma, two bytes per sample which end up in luminance and alpha
+    m_textureInternalFormats[1] = GL_LUMINANCE_ALPHA;
+    m_textureFormats[1] = GL_LUMINANCE_ALPHA;
+    m_textureWidths[1] = GST_VIDEO_INFO_PLANE_STRIDE(&info, 1) / 2;
+    m_textureHeights[1] = (GST_VIDEO_INFO_HEIGHT(&info) + 1) / 2;
+    m_textureOffsets[1] = GST_VIDEO_INFO_PLANE_OFFSET(&info, 1);
+}
+
 void VideoMaterial::init(GstVideoColorMatrix colorMatrixType)
 {
     QOpenGLFunctionsDef *funcs = getQOpenGLFunctions();
@@ -343,6 +417,7 @@ void VideoMaterial::setCurrentFrame(GstBuffer *buffer)
 {
     QMutexLocker lock(&m_frameMutex);
     gst_buffer_replace(&m_frame, buffer);
+    m_frameDirty = true;
 }
 
 void VideoMaterial::updateColors(int brightness, int contrast, int hue, int saturation)
@@ -426,31 +501,32 @@ void VideoMaterial::bind()
     if (!funcs)
         return;
 
+    // The scene graph binds the material on every render, only upload when there is a new frame
     GstBuffer *frame = NULL;
 
     m_frameMutex.lock();
-    if (m_frame)
+    if (m_frame && m_frameDirty) {
       frame = gst_buffer_ref(m_frame);
+      m_frameDirty = false;
+    }
     m_frameMutex.unlock();
 
     if (frame) {
         GstMapInfo info;
         gst_buffer_map(frame, &info, GST_MAP_READ);
-        funcs->glActiveTexture(GL_TEXTURE1);
-        bindTexture(1, info.data);
-        funcs->glActiveTexture(GL_TEXTURE2);
-        bindTexture(2, info.data);
-        funcs->glActiveTexture(GL_TEXTURE0); // Finish with 0 as default texture unit
-        bindTexture(0, info.data);
+        // Finish with 0 as default texture unit
+        for (int i = m_textureCount - 1; i >= 0; i--) {
+            funcs->glActiveTexture(GL_TEXTURE0 + i);
+            bindTexture(i, info.data);
+        }
+        m_texturesAllocated = true;
         gst_buffer_unmap(frame, &info);
         gst_buffer_unref(frame);
     } else {
-        funcs->glActiveTexture(GL_TEXTURE1);
-        funcs->glBindTexture(GL_TEXTURE_2D, m_textureIds[1]);
-        funcs->glActiveTexture(GL_TEXTURE2);
-        funcs->glBindTexture(GL_TEXTURE_2D, m_textureIds[2]);
-        funcs->glActiveTexture(GL_TEXTURE0); // Finish with 0 as default texture unit
-        funcs->glBindTexture(GL_TEXTURE_2D, m_textureIds[0]);
+        for (int i = m_textureCount - 1; i >= 0; i--) {
+            funcs->glActiveTexture(GL_TEXTURE0 + i);
+            funcs->glBindTexture(GL_TEXTURE_2D, m_textureIds[i]);
+        }
     }
 }
 
@@ -461,14 +537,30 @@ void VideoMaterial::bindTexture(int i, const quint8 *data)
         return;
 
     funcs->glBindTexture(GL_TEXTURE_2D, m_textureIds[i]);
+
+    // Texture size is fixed for the material, so after the first frame only the pixels are replaced
+    if (m_texturesAllocated) {
+        funcs->glTexSubImage2D(
+            GL_TEXTURE_2D,
+            0,
+            0,
+            0,
+            m_textureWidths[i],
+            m_textureHeights[i],
+            m_textureFormats[i],
+            m_textureType,
+            data + m_textureOffsets[i]);
+        return;
+    }
+
     funcs->glTexImage2D(
         GL_TEXTURE_2D,
         0,
-        m_textureInternalFormat,
+        m_textureInternalFormats[i],
         m_textureWidths[i],
         m_textureHeights[i],
         0,
-        m_textureFormat,
+        m_textureFormats[i],
         m_textureType,
         data + m_textureOffsets[i]);
     funcs->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -476,4 +568,3 @@ void VideoMaterial::bindTexture(int i, const quint8 *data)
     funcs->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     funcs->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 }
-
@@ -53,6 +53,7 @@ protected:
     void initRgbTextureInfo(GLenum internalFormat, GLuint format,
                             GLenum type, const QSize &size);
     void initYuv420PTextureInfo(bool uvSwapped, const QSize &size);
+    void initYuv420SpTextureInfo(const GstVideoInfo &info);
     void init(GstVideoColorMatrix colorMatrixType);
 
 private:
@@ -60,6 +61,7 @@ private:
 
 
     GstBuffer *m_frame;
+    bool m_frameDirty;          // m_frame has not been uploaded yet
     QMutex m_frameMutex;
 
     static const int Num_Texture_IDs = 3;
@@ -69,9 +71,10 @@ private:
     int m_textureHeights[Num_Texture_IDs];
     int m_textureOffsets[Num_Texture_IDs];
     QSize m_textureSize;
+    bool m_texturesAllocated;   // storage exists, frames are uploaded with glTexSubImage2D
 
-    GLenum m_textureFormat;
-    GLuint m_textureInternalFormat;
+    GLenum m_textureFormats[Num_Texture_IDs];
+    GLuint m_textureInternalFormats[Num_Texture_IDs];
     GLenum m_textureType;
 
     QMatrix4x4 m_colorMatrix;
@@ -11,9 +11,9 @@
 #include "LogReplayLink.h"
 #include "LinkManager.h"
 #include "QGCApplication.h"
+#include "MAVLinkFrameScanner.h"
 
 #include <QFileInfo>
-#include <QtEndian>
 
 const char*  LogReplayLinkConfiguration::_logFilenameKey = "logFilename";
 
@@ -64,11 +64,23 @@ QString LogReplayLinkConfiguration::logFilenameShort(void)
     return fi.fileName();
 }
 
+LogReplayMapping::LogReplayMapping(const QString& fileName, qint64 size)
+    : _file(fileName)
+    , _data(NULL)
+{
+    if (_file.open(QFile::ReadOnly)) {
+        _data = _file.map(0, size);
+    }
+}
+
 LogReplayLink::LogReplayLink(SharedLinkConfigurationPointer& config)
     : LinkInterface(config)
     , _logReplayConfig(qobject_cast<LogReplayLinkConfiguration*>(config.data()))
     , _connected(false)
     , _replayAccelerationFactor(1.0f)
+    , _logMap(NULL)
+    , _maxSpeed(false)
+    , _maxSpeedBatchesInFlight(new QAtomicInt(0))
 {
     Q_ASSERT(_logReplayConfig);
     
@@ -78,6 +90,21 @@ LogReplayLink::LogReplayLink(SharedLinkConfigurationPointer& config)
     QObject::connect(this, &LogReplayLink::_playOnThread, this, &LogReplayLink::_play);
     QObject::connect(this, &LogReplayLink::_pauseOnThread, this, &LogReplayLink::_pause);
     QObject::connect(this, &LogReplayLink::_setAccelerationFactorOnThread, this, &LogReplayLink::_setAccelerationFactor);
+    QObject::connect(this, &LogReplayLink::_setMaxSpeedOnThread, this, &LogReplayLink::_setMaxSpeed);
+
+    // The batch marker is queued to the main thread behind the bytesReceived signals for the batch, so by the time it
+    // is delivered the main thread has handled all of the batch's messages. The queued marker holds a reference to the
+    // log mapping the messages point into until then. It is also how max speed playback is throttled to what the main
+    // thread can handle. The counter is captured instead of the link, since the marker may arrive after the link has
+    // been deleted.
+    qRegisterMetaType<LogReplayMappingPointer>();
+    QSharedPointer<QAtomicInt> batchesInFlight = _maxSpeedBatchesInFlight;
+    QObject::connect(this, &LogReplayLink::_mappedBatchQueued, qgcApp()->toolbox()->linkManager(), [batchesInFlight](LogReplayMappingPointer mapping, bool maxSpeed) {
+        Q_UNUSED(mapping);
+        if (maxSpeed) {
+            batchesInFlight->deref();
+        }
+    });
     
     moveToThread(this);
 }
@@ -148,16 +175,7 @@ void LogReplayLink::_writeBytes(const QByteArray bytes)
 /// @return A Unix timestamp in microseconds UTC for found message or 0 if parsing failed
 quint64 LogReplayLink::_parseTimestamp(const QByteArray& bytes)
 {
-    quint64 timestamp = qFromBigEndian(*((quint64*)(bytes.constData())));
-    quint64 currentTimestamp = ((quint64)QDateTime::currentMSecsSinceEpoch()) * 1000;
-    
-    // Now if the parsed timestamp is in the future, it must be an old file where the timestamp was stored as
-    // little endian, so switch it.
-    if (timestamp > currentTimestamp) {
-        timestamp = qbswap(timestamp);
-    }
-    
-    return timestamp;
+    return MAVLinkLogIndex::parseTimestamp((const uint8_t*)bytes.constData());
 }
 
 /// Seeks to the beginning of the next successfully parsed mavlink message in the log file.
@@ -182,6 +200,46 @@ quint64 LogReplayLink::_seekToNextMavlinkMessage(mavlink_message_t* nextMsg)
     return 0;
 }
 
+/// Positions the log at the first message with a timestamp at or after the specified time. The index takes us
+/// to within one index interval of the time, from there we walk forward record by record. Same as
+/// _seekToNextMavlinkMessage the log is left at the start of the mavlink message following the timestamp.
+/// @return A Unix timestamp in microseconds UTC for found message or 0 if seek failed
+quint64 LogReplayLink::_seekToTime(quint64 timeUSecs)
+{
+    quint64 recordTimeUSecs;
+    qint64  offset = _logIndex.findOffset(timeUSecs, &recordTimeUSecs);
+    quint64 nowUSecs = MAVLinkLogIndex::currentTimeUSecs();
+
+    while (_logFile.seek(offset)) {
+        char    record[cbTimestamp + MAVLINK_MAX_PACKET_LEN];
+        qint64  cRecordBytes = _logFile.peek(record, sizeof(record));
+
+        if (cRecordBytes <= cbTimestamp) {
+            return 0;
+        }
+
+        int frameLength = MAVLinkFrameScanner::checkFrame((const uint8_t*)record + cbTimestamp, cRecordBytes - cbTimestamp);
+        if (frameLength == 0) {
+            // Truncated record at end of log
+            return 0;
+        } else if (frameLength < 0) {
+            // Corrupt record, fall back to resyncing on the next message
+            mavlink_message_t msg;
+            return _seekToNextMavlinkMessage(&msg);
+        }
+
+        recordTimeUSecs = MAVLinkLogIndex::parseTimestamp((const uint8_t*)record, nowUSecs);
+        if (recordTimeUSecs >= timeUSecs) {
+            _logFile.seek(offset + cbTimestamp);
+            return recordTimeUSecs;
+        }
+
+        offset += cbTimestamp + frameLength;
+    }
+
+    return 0;
+}
+
 bool LogReplayLink::_loadLogFile(void)
 {
     QString errorMsg;
@@ -205,30 +263,28 @@ bool LogReplayLink::_loadLogFile(void)
     _logTimestamped = logFilename.endsWith(".mavlink");
     
     if (_logTimestamped) {
-        // Get the first timestamp from the log
-        // This should be a big-endian uint64.
-        QByteArray timestamp = _logFile.read(cbTimestamp);
-        quint64 startTimeUSecs = _parseTimestamp(timestamp);
-        
-        // Now find the last timestamp by scanning for the last MAVLink packet and
-        // find the timestamp before it. To do this we start searchin a little before
-        // the end of the file, specifically the maximum MAVLink packet size + the
-        // timestamp size. This guarantees that we will hit a MAVLink packet before
-        // the end of the file. Unfortunately, it basically guarantees that we will
-        // hit more than one. This is why we have to search for a bit.
-        qint64 fileLoc = _logFile.size() - MAVLINK_MAX_PACKET_LEN - cbTimestamp;
-        _logFile.seek(fileLoc);
-        quint64 endTimeUSecs = startTimeUSecs; // Set a sane default for the endtime
-        mavlink_message_t msg;
-        quint64 messageTimeUSecs;
-        while ((messageTimeUSecs = _seekToNextMavlinkMessage(&msg)) > endTimeUSecs) {
-            endTimeUSecs = messageTimeUSecs;
+        // The start and end times come from the time index. The index is loaded from the sidecar file next to
+        // the log, so load time doesn't depend on the log size. Only logs which have never been indexed
+        // are scanned, once.
+        if (!_logIndex.load(_logFile, errorMsg)) {
+            goto Error;
         }
+        quint64 startTimeUSecs = _logIndex.startTimeUSecs();
+        quint64 endTimeUSecs = _logIndex.endTimeUSecs();
         
         if (endTimeUSecs == startTimeUSecs) {
             errorMsg = QString("The log file '%1' is corrupt. No valid timestamps were found at the end of the file.").arg(logFilename);
             goto Error;
         }
+
+        // Playback reads messages straight out of the mapped file. If the file can't be mapped we fall back
+        // to reading it.
+        _logMapping = LogReplayMappingPointer(new LogReplayMapping(logFilename, _logFileSize));
+        _logMap = _logMapping->data();
+        if (!_logMap) {
+            qWarning() << "Unable to map log file, falling back to file reads" << _logMapping->errorString();
+            _logMapping.clear();
+        }
         
         // Remember the start and end time so we can move around this _logFile with the slider.
         _logEndTimeUSecs = endTimeUSecs;
@@ -282,6 +338,11 @@ Error:
 /// induce a static drift into the log file replay.
 void LogReplayLink::_readNextLogEntry(void)
 {
+    if (_logMap) {
+        _readNextMappedLogEntries();
+        return;
+    }
+
     // If we have a file with timestamps, try and pace this out following the time differences
     // between the timestamps and the current playback speed.
     if (_logTimestamped) {
@@ -345,6 +406,105 @@ void LogReplayLink::_readNextLogEntry(void)
     
 }
 
+/// Finds the next valid record in the mapped log, starting the search at the specified offset.
+///     @param[out] frameLength Length of the MAVLink frame in the record
+/// @return File offset of the record (the timestamp), -1 if there are no more records
+qint64 LogReplayLink::_nextMappedRecord(qint64 offset, int* frameLength)
+{
+    qint64 logFileSize = (qint64)_logFileSize;
+
+    while (offset + cbTimestamp < logFileSize) {
+        int available = (int)qMin(logFileSize - offset - cbTimestamp, (qint64)MAVLINK_MAX_PACKET_LEN);
+
+        *frameLength = MAVLinkFrameScanner::checkFrame(_logMap + offset + cbTimestamp, available);
+        if (*frameLength > 0) {
+            return offset;
+        } else if (*frameLength == 0) {
+            // Truncated record at end of log
+            return -1;
+        }
+
+        // Corrupt record, resync at the next byte
+        offset++;
+    }
+
+    return -1;
+}
+
+/// Mapped log version of _readNextLogEntry. Messages are sent as QByteArrays which reference the mapped file, no data
+/// is copied. The mapping is handed to the main thread along with the batch and stays valid until the main thread has
+/// handled it, even if the link is deleted in the meantime. Receivers which keep the bytes past bytesReceived must copy
+/// them. MAVLinkProtocol does not, the frame scanner is left holding bytes only for partial frames and every record
+/// sent from here is a complete, CRC checked frame.
+void LogReplayLink::_readNextMappedLogEntries(void)
+{
+    if (_maxSpeed && _maxSpeedBatchesInFlight->load() >= _maxSpeedBatchesInFlightMax) {
+        // Main thread is still working through previous batches
+        _readTickTimer.start(1);
+        return;
+    }
+
+    // The file position is used as the playhead so that seeking and resetting work the same as for file reads.
+    // It is either at the start of a record or at the start of the message following the timestamp.
+    int     frameLength;
+    qint64  offset = _nextMappedRecord(qMax(_logFile.pos() - cbTimestamp, (qint64)0), &frameLength);
+    int     timeToNextExecutionMSecs = 0;
+    int     messageCount = 0;
+    quint64 nowUSecs = MAVLinkLogIndex::currentTimeUSecs();
+
+    while (offset >= 0) {
+        const char* frame = (const char*)_logMap + offset + cbTimestamp;
+        emit bytesReceived(this, QByteArray::fromRawData(frame, frameLength));
+        messageCount++;
+
+        offset = _nextMappedRecord(offset + cbTimestamp + frameLength, &frameLength);
+        if (offset < 0) {
+            break;
+        }
+        _logCurrentTimeUSecs = MAVLinkLogIndex::parseTimestamp(_logMap + offset, nowUSecs);
+
+        if (messageCount >= _maxMessagesPerBatch) {
+            break;
+        }
+        if (!_maxSpeed) {
+            // Same pacing as file reads, stop once we have at least 3ms until the next message
+            qint64 timeDiffMSecs = ((_logCurrentTimeUSecs - _logStartTimeUSecs) / 1000) / _replayAccelerationFactor;
+            quint64 desiredPacedTimeMSecs = _playbackStartTimeMSecs + timeDiffMSecs;
+            quint64 currentTimeMSecs = (quint64)QDateTime::currentMSecsSinceEpoch();
+            timeToNextExecutionMSecs = desiredPacedTimeMSecs - currentTimeMSecs;
+            if (timeToNextExecutionMSecs >= 3) {
+                break;
+            }
+        }
+    }
+
+    if (messageCount) {
+        if (_maxSpeed) {
+            _maxSpeedBatchesInFlight->ref();
+        }
+        emit _mappedBatchQueued(_logMapping, _maxSpeed);
+    }
+
+    if (offset < 0) {
+        _logCurrentTimeUSecs = _logEndTimeUSecs;
+        _logFile.seek(_logFileSize);
+        emit playbackPercentCompleteChanged(100);
+        _finishPlayback();
+        return;
+    }
+
+    emit playbackPercentCompleteChanged(((float)(_logCurrentTimeUSecs - _logStartTimeUSecs) / (float)_logDurationUSecs) * 100);
+
+    _logFile.seek(offset + cbTimestamp);
+    _readTickTimer.start(_maxSpeed ? 0 : qMax(timeToNextExecutionMSecs, 0));
+}
+
+/// Adjusts the playback start time such that the next message plays immediately at the current acceleration factor
+void LogReplayLink::_rebasePlaybackStartTime(void)
+{
+    _playbackStartTimeMSecs = (quint64)QDateTime::currentMSecsSinceEpoch() - (quint64)(((_logCurrentTimeUSecs - _logStartTimeUSecs) / 1000) / _replayAccelerationFactor);
+}
+
 void LogReplayLink::_play(void)
 {
     qgcApp()->toolbox()->linkManager()->setConnectionsSuspended(tr("Connect not allowed during Flight Data replay."));
@@ -359,7 +519,7 @@ void LogReplayLink::_play(void)
     
     // Always correct the current start time such that the next message will play immediately at playback.
     // We do this by subtracting the current file playback offset  from now()
-    _playbackStartTimeMSecs = (quint64)QDateTime::currentMSecsSinceEpoch() - ((_logCurrentTimeUSecs - _logStartTimeUSecs) / 1000);
+    _rebasePlaybackStartTime();
     
     // Start timer
     if (_logTimestamped) {
@@ -416,41 +576,17 @@ void LogReplayLink::movePlayhead(int percentComplete)
     
     if (_logTimestamped) {
         // But if we have a timestamped MAVLink log, then actually aim to hit that percentage in terms of
-        // time through the file.
-        qint64 newFilePos = (qint64)(floatPercentComplete * (float)_logFile.size());
-        
-        // Now seek to the appropriate position, failing gracefully if we can't.
-        if (!_logFile.seek(newFilePos)) {
-            _replayError("Unable to seek to new position");
-            return;
-        }
-        
-        // But we do align to the next MAVLink message for consistency.
-        mavlink_message_t dummy;
-        _logCurrentTimeUSecs = _seekToNextMavlinkMessage(&dummy);
-        
-        // Now calculate the current file location based on time.
-        float newRelativeTimeUSecs = (float)(_logCurrentTimeUSecs - _logStartTimeUSecs);
-        
-        // Calculate the effective baud rate of the file in bytes/s.
-        float baudRate = _logFile.size() / (float)_logDurationUSecs / 1e6;
-        
-        // And the desired time is:
-        float desiredTimeUSecs = floatPercentComplete * _logDurationUSecs;
-        
-        // And now jump the necessary number of bytes in the proper direction
-        qint64 offset = (newRelativeTimeUSecs - desiredTimeUSecs) * baudRate;
-        if (!_logFile.seek(_logFile.pos() + offset)) {
+        // time through the file. The time index takes us straight to the message for that time.
+        quint64 desiredTimeUSecs = _logStartTimeUSecs + (quint64)(floatPercentComplete * _logDurationUSecs);
+        quint64 messageTimeUSecs = _seekToTime(desiredTimeUSecs);
+        if (messageTimeUSecs == 0) {
             _replayError("Unable to seek to new position");
             return;
         }
-        
-        // And scan until we reach the start of a MAVLink message. We make sure to record this timestamp for
-        // smooth jumping around the file.
-        _logCurrentTimeUSecs = _seekToNextMavlinkMessage(&dummy);
+        _logCurrentTimeUSecs = messageTimeUSecs;
         
         // Now update the UI with our actual final position.
-        newRelativeTimeUSecs = (float)(_logCurrentTimeUSecs - _logStartTimeUSecs);
+        float newRelativeTimeUSecs = (float)(_logCurrentTimeUSecs - _logStartTimeUSecs);
         percentComplete = (newRelativeTimeUSecs / _logDurationUSecs) * 100;
         emit playbackPercentCompleteChanged(percentComplete);
     } else {
@@ -487,7 +623,10 @@ void LogReplayLink::_setAccelerationFactor(int factor)
     }
     
     // Update timer interval
-    if (!_logTimestamped) {
+    if (_logTimestamped) {
+        // Keep playing from the current position at the new rate
+        _rebasePlaybackStartTime();
+    } else {
         // Read len bytes at a time
         int len = 100;
         // Calculate the number of times to read 100 bytes per second
@@ -499,6 +638,16 @@ void LogReplayLink::_setAccelerationFactor(int factor)
     }
 }
 
+void LogReplayLink::_setMaxSpeed(bool maxSpeed)
+{
+    _maxSpeed = maxSpeed;
+
+    if (!_maxSpeed) {
+        // Continue paced playback from wherever max speed playback got to
+        _rebasePlaybackStartTime();
+    }
+}
+
 /// @brief Called when playback is complete
 void LogReplayLink::_finishPlayback(void)
 {
@@ -512,5 +661,7 @@ void LogReplayLink::_playbackError(void)
 {
     _pause();
     _logFile.close();
+    _logMap = NULL;
+    _logMapping.clear();
     emit playbackError();
 }
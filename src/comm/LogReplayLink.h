@@ -14,9 +14,33 @@
 #include "LinkInterface.h"
 #include "LinkConfiguration.h"
 #include "MAVLinkProtocol.h"
+#include "MAVLinkLogIndex.h"
 
 #include <QTimer>
 #include <QFile>
+#include <QAtomicInt>
+#include <QSharedPointer>
+
+/// Memory mapping of a timestamped log. Mapped playback sends messages as QByteArrays which reference the mapping, so
+/// each batch queued to the main thread holds a reference to it. The log is only unmapped once the link and all
+/// batches in flight are done with it.
+class LogReplayMapping
+{
+public:
+    LogReplayMapping(const QString& fileName, qint64 size);
+
+    /// @return Mapped log, NULL if mapping failed
+    const uchar*    data        (void) const { return _data; }
+    QString         errorString (void) const { return _file.errorString(); }
+
+private:
+    QFile   _file;
+    uchar*  _data;
+};
+
+typedef QSharedPointer<LogReplayMapping> LogReplayMappingPointer;
+
+Q_DECLARE_METATYPE(LogReplayMappingPointer)
 
 class LogReplayLinkConfiguration : public LinkConfiguration
 {
@@ -72,6 +96,11 @@ public:
     /// Sets the acceleration factor: -100: 0.01X, 0: 1.0X, 100: 100.0X
     void setAccelerationFactor(int factor) { emit _setAccelerationFactorOnThread(factor); }
 
+    /// Max speed mode plays a timestamped log as fast as the message handling can keep up with, ignoring the
+    /// timestamps. This is meant for bulk analysis of logs. Requires the log file to be memory mapped, which it
+    /// normally is; if mapping failed playback stays paced.
+    void setMaxSpeed(bool maxSpeed) { emit _setMaxSpeedOnThread(maxSpeed); }
+
     // Virtuals from LinkInterface
     virtual QString getName(void) const { return _config->name(); }
     virtual void requestReset(void){ }
@@ -100,12 +129,15 @@ signals:
     void _playOnThread(void);
     void _pauseOnThread(void);
     void _setAccelerationFactorOnThread(int factor);
+    void _setMaxSpeedOnThread(bool maxSpeed);
+    void _mappedBatchQueued(LogReplayMappingPointer mapping, bool maxSpeed);
 
 private slots:
     void _readNextLogEntry(void);
     void _play(void);
     void _pause(void);
     void _setAccelerationFactor(int factor);
+    void _setMaxSpeed(bool maxSpeed);
 
 private:
     // Links are only created/destroyed by LinkManager so constructor/destructor is not public
@@ -115,6 +147,10 @@ private:
     void _replayError(const QString& errorMsg);
     quint64 _parseTimestamp(const QByteArray& bytes);
     quint64 _seekToNextMavlinkMessage(mavlink_message_t* nextMsg);
+    quint64 _seekToTime(quint64 timeUSecs);
+    qint64 _nextMappedRecord(qint64 offset, int* frameLength);
+    void _readNextMappedLogEntries(void);
+    void _rebasePlaybackStartTime(void);
     bool _loadLogFile(void);
     void _finishPlayback(void);
     void _playbackError(void);
@@ -149,6 +185,15 @@ private:
     QFile               _logFile;
     quint64             _logFileSize;
     bool                _logTimestamped;    ///< true: Timestamped log format, false: no timestamps
+    MAVLinkLogIndex     _logIndex;          ///< Time index for timestamped logs
+    LogReplayMappingPointer _logMapping;    ///< Memory mapped timestamped log, NULL if not mapped
+    const uchar*        _logMap;            ///< _logMapping data, NULL if not mapped
+
+    bool                        _maxSpeed;                  ///< true: Play log as fast as possible, see setMaxSpeed
+    QSharedPointer<QAtomicInt>  _maxSpeedBatchesInFlight;   ///< Number of max speed batches not yet handled by the main thread
+
+    static const int _maxMessagesPerBatch =         1000;   ///< Maximum number of messages sent per read tick
+    static const int _maxSpeedBatchesInFlightMax =  2;      ///< Max speed playback waits for the main thread beyond this
 
     static const int cbTimestamp = sizeof(quint64);
 };
@@ -0,0 +1,235 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "MAVLinkFrameScanner.h"
+
+#include <string.h>
+
+const int MAVLinkFrameScanner::_v1HeaderLength = MAVLINK_CORE_HEADER_MAVLINK1_LEN + 1;
+const int MAVLinkFrameScanner::_v2HeaderLength = MAVLINK_CORE_HEADER_LEN + 1;
+
+MAVLinkFrameScanner::MAVLinkFrameScanner(void)
+    : _channel(0)
+    , _offset(0)
+    , _frameData(NULL)
+    , _frameLength(0)
+    , _discardedBytes(0)
+{
+
+}
+
+void MAVLinkFrameScanner::reset(void)
+{
+    _buffer.clear();
+    _offset = 0;
+    _frameData = NULL;
+    _frameLength = 0;
+    _discardedBytes = 0;
+}
+
+void MAVLinkFrameScanner::append(const QByteArray& bytes)
+{
+    _compact();
+    _frameData = NULL;
+    _frameLength = 0;
+
+    if (_buffer.isEmpty()) {
+        // Common case, nothing left over from the previous block. Share the data instead of copying it.
+        _buffer = bytes;
+    } else {
+        _buffer.append(bytes);
+    }
+}
+
+/// Drops the bytes which have already been scanned. Only the left over partial frame is copied.
+void MAVLinkFrameScanner::_compact(void)
+{
+    if (_offset == 0) {
+        return;
+    }
+    if (_offset >= _buffer.size()) {
+        _buffer.clear();
+    } else {
+        _buffer = _buffer.mid(_offset);
+    }
+    _offset = 0;
+}
+
+int MAVLinkFrameScanner::frameLength(const uint8_t* bytes, int available)
+{
+    if (available < 3) {
+        return 0;
+    }
+
+    int payloadLength = bytes[1];
+
+    if (bytes[0] == MAVLINK_STX_MAVLINK1) {
+        return _v1HeaderLength + payloadLength + MAVLINK_NUM_CHECKSUM_BYTES;
+    } else if (bytes[0] == MAVLINK_STX) {
+        uint8_t incompatFlags = bytes[2];
+        if (incompatFlags & ~MAVLINK_IFLAG_MASK) {
+            // Frame uses a feature we don't understand, same as mavlink_parse_char we treat it as a bad start
+            return -1;
+        }
+        int length = _v2HeaderLength + payloadLength + MAVLINK_NUM_CHECKSUM_BYTES;
+        if (incompatFlags & MAVLINK_IFLAG_SIGNED) {
+            length += MAVLINK_SIGNATURE_BLOCK_LEN;
+        }
+        return length;
+    }
+
+    return -1;
+}
+
+int MAVLinkFrameScanner::checkFrame(const uint8_t* bytes, int available)
+{
+    int length = frameLength(bytes, available);
+    if (length <= 0) {
+        return length;
+    }
+    if (length > available) {
+        return 0;
+    }
+
+    uint16_t crc;
+    return _frameCrcValid(bytes, _frameMsgId(bytes), &crc) ? length : -1;
+}
+
+uint32_t MAVLinkFrameScanner::_frameMsgId(const uint8_t* frame)
+{
+    if (frame[0] == MAVLINK_STX_MAVLINK1) {
+        return frame[5];
+    } else {
+        return frame[7] | (frame[8] << 8) | (frame[9] << 16);
+    }
+}
+
+/// Calculates the frame CRC and compares it against the CRC bytes in the frame
+///     @param[out] crc Calculated CRC
+bool MAVLinkFrameScanner::_frameCrcValid(const uint8_t* frame, uint32_t msgid, uint16_t* crc)
+{
+    int     headerLength = frame[0] == MAVLINK_STX_MAVLINK1 ? _v1HeaderLength : _v2HeaderLength;
+    uint8_t payloadLength = frame[1];
+
+    const mavlink_msg_entry_t* entry = mavlink_get_msg_entry(msgid);
+    uint8_t crcExtra = entry ? entry->crc_extra : 0;
+
+    // CRC covers everything after the STX up to the end of the payload, plus the crc extra byte
+    crc_init(crc);
+    crc_accumulate_buffer(crc, (const char*)frame + 1, headerLength - 1 + payloadLength);
+    crc_accumulate(crcExtra, crc);
+
+    const uint8_t* ck = frame + headerLength + payloadLength;
+    return (*crc & 0xFF) == ck[0] && (*crc >> 8) == ck[1];
+}
+
+bool MAVLinkFrameScanner::nextMessage(mavlink_message_t* message)
+{
+    const uint8_t*  bytes = (const uint8_t*)_buffer.constData();
+    int             size = _buffer.size();
+
+    _frameData = NULL;
+    _frameLength = 0;
+
+    while (_offset < size) {
+        // Find the next start marker
+        const uint8_t* stx = bytes + _offset;
+        const uint8_t* end = bytes + size;
+        while (stx < end && *stx != MAVLINK_STX && *stx != MAVLINK_STX_MAVLINK1) {
+            stx++;
+        }
+        int skipped = stx - (bytes + _offset);
+        _discardedBytes += skipped;
+        _offset += skipped;
+        if (stx == end) {
+            break;
+        }
+
+        int length = frameLength(stx, size - _offset);
+        if (length == 0 || length > size - _offset) {
+            // Partial frame, wait for more bytes
+            break;
+        }
+
+        if (length > 0 && _decodeFrame(stx, message)) {
+            _frameData = stx;
+            _frameLength = length;
+            _offset += length;
+            return true;
+        }
+
+        // Not a valid frame. Resync at the next byte, which may well be the start of a real frame which was
+        // hidden by a false STX.
+        _discardedBytes++;
+        _offset++;
+    }
+
+    return false;
+}
+
+bool MAVLinkFrameScanner::_decodeFrame(const uint8_t* frame, mavlink_message_t* message)
+{
+    mavlink_status_t* status = mavlink_get_channel_status(_channel);
+
+    bool    mavlink1 = frame[0] == MAVLINK_STX_MAVLINK1;
+    int     headerLength = mavlink1 ? _v1HeaderLength : _v2HeaderLength;
+    uint8_t payloadLength = frame[1];
+
+    uint32_t msgid = _frameMsgId(frame);
+
+    uint16_t crc;
+    if (!_frameCrcValid(frame, msgid, &crc)) {
+        status->parse_error++;
+        status->packet_rx_drop_count++;
+        status->msg_received = MAVLINK_FRAMING_BAD_CRC;
+        return false;
+    }
+
+    message->magic = frame[0];
+    message->len = payloadLength;
+    message->checksum = crc;
+    message->msgid = msgid;
+    if (mavlink1) {
+        message->incompat_flags = 0;
+        message->compat_flags = 0;
+        message->seq = frame[2];
+        message->sysid = frame[3];
+        message->compid = frame[4];
+        status->flags |= MAVLINK_STATUS_FLAG_IN_MAVLINK1;
+    } else {
+        message->incompat_flags = frame[2];
+        message->compat_flags = frame[3];
+        message->seq = frame[4];
+        message->sysid = frame[5];
+        message->compid = frame[6];
+        status->flags &= ~MAVLINK_STATUS_FLAG_IN_MAVLINK1;
+    }
+
+    // MAVLink 2 truncates trailing zeros from the payload, the decoders expect them to be there
+    char* payload = _MAV_PAYLOAD_NON_CONST(message);
+    memcpy(payload, frame + headerLength, payloadLength);
+    memset(payload + payloadLength, 0, MAVLINK_MAX_PAYLOAD_LEN - payloadLength);
+
+    const uint8_t* ck = frame + headerLength + payloadLength;
+    message->ck[0] = ck[0];
+    message->ck[1] = ck[1];
+    if (!mavlink1 && (message->incompat_flags & MAVLINK_IFLAG_SIGNED)) {
+        // QGC does not set up signing on its channels, so signed frames are accepted without verification the same as mavlink_parse_char does
+        memcpy(message->signature, ck + MAVLINK_NUM_CHECKSUM_BYTES, MAVLINK_SIGNATURE_BLOCK_LEN);
+    }
+
+    status->msg_received = MAVLINK_FRAMING_OK;
+    status->current_rx_seq = message->seq;
+    if (status->packet_rx_success_count == 0) {
+        status->packet_rx_drop_count = 0;
+    }
+    status->packet_rx_success_count++;
+
+    return true;
+}
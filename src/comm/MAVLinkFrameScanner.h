@@ -0,0 +1,91 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#ifndef MAVLinkFrameScanner_H
+#define MAVLinkFrameScanner_H
+
+#include <QByteArray>
+
+#include "QGCMAVLink.h"
+
+/// Buffer level MAVLink 1/2 frame decoder. This is a replacement for running mavlink_parse_char over every
+/// received byte. Incoming blocks are searched for STX markers, the frame length is taken from the header and
+/// the CRC is validated over the complete frame in one pass. Partial frames at the end of a block are kept
+/// until the next block arrives.
+///
+/// The mavlink channel status (packet_rx_success_count, packet_rx_drop_count, parse_error, current_rx_seq and
+/// the MAVLINK_STATUS_FLAG_IN_MAVLINK1 flag) is updated the same way mavlink_parse_char updates it, so code
+/// which looks at mavlink_get_channel_status continues to work.
+///
+/// Usage:
+///     scanner.append(bytes);
+///     while (scanner.nextMessage(&message)) {
+///         ...
+///     }
+class MAVLinkFrameScanner
+{
+public:
+    MAVLinkFrameScanner(void);
+
+    /// Sets the mavlink channel whose status is updated while decoding
+    void setChannel(int channel) { _channel = channel; }
+    int channel(void) const { return _channel; }
+
+    /// Discards any partial frame
+    void reset(void);
+
+    /// Appends a received block to the scan buffer
+    void append(const QByteArray& bytes);
+
+    /// Decodes the next complete frame in the scan buffer.
+    ///     @param[out] message Decoded message
+    /// @return true: message decoded, false: no more complete frames available
+    bool nextMessage(mavlink_message_t* message);
+
+    /// @return Pointer to the raw bytes of the frame returned by the last successful call to nextMessage. Only valid
+    ///         until the next call to append or nextMessage.
+    const uint8_t* frameData(void) const { return _frameData; }
+
+    /// @return Length of the raw frame returned by the last successful call to nextMessage
+    int frameLength(void) const { return _frameLength; }
+
+    /// @return Number of bytes which have been skipped since construction/reset because they were not part of a valid frame
+    quint64 discardedBytes(void) const { return _discardedBytes; }
+
+    /// Calculates the length of the frame which starts at the specified position
+    ///     @param bytes Start of frame, must point to an STX marker
+    ///     @param available Number of bytes available starting at bytes
+    /// @return >0: frame length, 0: more bytes needed to determine length, -1: not a valid frame start
+    static int frameLength(const uint8_t* bytes, int available);
+
+    /// Validates length and CRC of the frame which starts at the specified position
+    ///     @param bytes Start of frame
+    ///     @param available Number of bytes available starting at bytes
+    /// @return >0: valid frame of this length, 0: more bytes needed, -1: not a valid frame
+    static int checkFrame(const uint8_t* bytes, int available);
+
+private:
+    bool _decodeFrame(const uint8_t* frame, mavlink_message_t* message);
+    void _compact(void);
+
+    static uint32_t _frameMsgId(const uint8_t* frame);
+    static bool     _frameCrcValid(const uint8_t* frame, uint32_t msgid, uint16_t* crc);
+
+    int             _channel;
+    QByteArray      _buffer;            ///< Scan buffer, implicitly shared with the received block when possible
+    int             _offset;            ///< Current scan position in _buffer
+    const uint8_t*  _frameData;
+    int             _frameLength;
+    quint64         _discardedBytes;
+
+    static const int _v1HeaderLength;   ///< STX plus MAVLink 1 core header
+    static const int _v2HeaderLength;   ///< STX plus MAVLink 2 core header
+};
+
+#endif
@@ -0,0 +1,218 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "MAVLinkLogIndex.h"
+#include "MAVLinkFrameScanner.h"
+#include "QGCLoggingCategory.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QtEndian>
+
+QGC_LOGGING_CATEGORY(MAVLinkLogIndexLog, "MAVLinkLogIndexLog")
+
+const char* MAVLinkLogIndex::_indexFileExtension = "idx";
+
+MAVLinkLogIndex::MAVLinkLogIndex(void)
+    : _endTimeUSecs(0)
+{
+
+}
+
+QString MAVLinkLogIndex::indexFilename(const QString& logFilename)
+{
+    return QString("%1.%2").arg(logFilename).arg(_indexFileExtension);
+}
+
+quint64 MAVLinkLogIndex::currentTimeUSecs(void)
+{
+    return ((quint64)QDateTime::currentMSecsSinceEpoch()) * 1000;
+}
+
+quint64 MAVLinkLogIndex::parseTimestamp(const uint8_t* bytes, quint64 currentTimeUSecs)
+{
+    quint64 timestamp = qFromBigEndian<quint64>(bytes);
+
+    // Now if the parsed timestamp is in the future, it must be an old file where the timestamp was stored as
+    // little endian, so switch it.
+    if (timestamp > currentTimeUSecs) {
+        timestamp = qbswap(timestamp);
+    }
+
+    return timestamp;
+}
+
+void MAVLinkLogIndex::clear(void)
+{
+    _entries.clear();
+    _endTimeUSecs = 0;
+}
+
+void MAVLinkLogIndex::addRecord(quint64 timeUSecs, qint64 offset)
+{
+    if (_entries.isEmpty() || timeUSecs >= _entries.last().timeUSecs + _indexIntervalUSecs) {
+        IndexEntry_t entry;
+        entry.timeUSecs = timeUSecs;
+        entry.offset = offset;
+        _entries.append(entry);
+    }
+    if (timeUSecs > _endTimeUSecs) {
+        _endTimeUSecs = timeUSecs;
+    }
+}
+
+qint64 MAVLinkLogIndex::findOffset(quint64 timeUSecs, quint64* entryTimeUSecs) const
+{
+    if (_entries.isEmpty()) {
+        *entryTimeUSecs = 0;
+        return 0;
+    }
+
+    // Binary search for the last entry at or before the requested time
+    int low = 0;
+    int high = _entries.count();
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (_entries[mid].timeUSecs <= timeUSecs) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    const IndexEntry_t& entry = _entries[qMax(low - 1, 0)];
+    *entryTimeUSecs = entry.timeUSecs;
+    return entry.offset;
+}
+
+bool MAVLinkLogIndex::build(QFile& logFile)
+{
+    QElapsedTimer   timer;
+    QByteArray      buffer;
+    qint64          bufferFileOffset = 0;
+    int             position = 0;
+    quint64         nowUSecs = currentTimeUSecs();
+
+    static const int blockSize = 1024 * 1024;
+
+    timer.start();
+    clear();
+
+    if (!logFile.seek(0)) {
+        return false;
+    }
+
+    while (true) {
+        // Keep at least one full record in the buffer
+        if (buffer.size() - position < recordTimestampLength + MAVLINK_MAX_PACKET_LEN && !logFile.atEnd()) {
+            bufferFileOffset += position;
+            buffer = buffer.mid(position) + logFile.read(blockSize);
+            position = 0;
+        }
+
+        int available = buffer.size() - position;
+        if (available <= recordTimestampLength) {
+            break;
+        }
+
+        const uint8_t* record = (const uint8_t*)buffer.constData() + position;
+        int frameLength = MAVLinkFrameScanner::checkFrame(record + recordTimestampLength, available - recordTimestampLength);
+        if (frameLength == 0) {
+            // Truncated record at end of log
+            break;
+        } else if (frameLength < 0) {
+            // Corrupt record, resync on the next valid one
+            position++;
+            continue;
+        }
+
+        addRecord(parseTimestamp(record, nowUSecs), bufferFileOffset + position);
+        position += recordTimestampLength + frameLength;
+    }
+
+    qCDebug(MAVLinkLogIndexLog) << "Built index" << logFile.fileName() << "entries" << _entries.count() << "msecs" << timer.elapsed();
+
+    return !_entries.isEmpty();
+}
+
+bool MAVLinkLogIndex::save(const QString& logFilename, qint64 logFileSize) const
+{
+    QFile indexFile(indexFilename(logFilename));
+
+    if (!indexFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qCWarning(MAVLinkLogIndexLog) << "Unable to save index" << indexFile.fileName() << indexFile.errorString();
+        return false;
+    }
+
+    QDataStream stream(&indexFile);
+    stream << _indexMagic << _indexVersion << logFileSize << _endTimeUSecs << (quint32)_entries.count();
+    for (int i=0; i<_entries.count(); i++) {
+        stream << _entries[i].timeUSecs << _entries[i].offset;
+    }
+
+    return stream.status() == QDataStream::Ok;
+}
+
+/// Loads the sidecar index if it exists and was built for a log of the same size
+bool MAVLinkLogIndex::_loadSidecar(const QString& logFilename, qint64 logFileSize)
+{
+    QFile indexFile(indexFilename(logFilename));
+
+    if (!indexFile.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&indexFile);
+    quint32     magic, version, entryCount;
+    qint64      indexedFileSize;
+
+    stream >> magic >> version >> indexedFileSize >> _endTimeUSecs >> entryCount;
+    if (stream.status() != QDataStream::Ok || magic != _indexMagic || version != _indexVersion || indexedFileSize != logFileSize) {
+        qCDebug(MAVLinkLogIndexLog) << "Stale or invalid index" << indexFile.fileName();
+        clear();
+        return false;
+    }
+    if ((qint64)entryCount * (qint64)(sizeof(quint64) + sizeof(qint64)) > indexFile.size()) {
+        clear();
+        return false;
+    }
+
+    _entries.resize(entryCount);
+    for (quint32 i=0; i<entryCount; i++) {
+        stream >> _entries[i].timeUSecs >> _entries[i].offset;
+    }
+    if (stream.status() != QDataStream::Ok) {
+        clear();
+        return false;
+    }
+
+    return !_entries.isEmpty();
+}
+
+bool MAVLinkLogIndex::load(QFile& logFile, QString& errorString)
+{
+    QString logFilename = logFile.fileName();
+    qint64  logFileSize = logFile.size();
+
+    if (_loadSidecar(logFilename, logFileSize)) {
+        qCDebug(MAVLinkLogIndexLog) << "Loaded index" << indexFilename(logFilename) << "entries" << _entries.count();
+        return true;
+    }
+
+    if (!build(logFile)) {
+        errorString = QString("The log file '%1' is corrupt. No valid timestamps were found.").arg(logFilename);
+        return false;
+    }
+
+    // Failing to save the sidecar (read only media for example) just means we index again next time
+    save(logFilename, logFileSize);
+
+    return true;
+}
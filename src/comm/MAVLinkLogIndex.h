@@ -0,0 +1,93 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#ifndef MAVLinkLogIndex_H
+#define MAVLinkLogIndex_H
+
+#include <QString>
+#include <QVector>
+#include <QFile>
+#include <QLoggingCategory>
+
+Q_DECLARE_LOGGING_CATEGORY(MAVLinkLogIndexLog)
+
+/// Time to file offset index for timestamped .mavlink flight data logs.
+///
+/// The index holds one entry for the first record in each _indexIntervalUSecs slice of log time, so looking up a
+/// timestamp is a binary search followed by a short forward walk over at most one slice of records. The index
+/// is kept in a sidecar file next to the log (see indexFilename). It is written by the log writer as the log is
+/// recorded, or built with a single pass over the log the first time an unindexed log is loaded.
+class MAVLinkLogIndex
+{
+public:
+    MAVLinkLogIndex(void);
+
+    /// Loads the sidecar index for the log. If the sidecar is missing or does not match the log it is rebuilt
+    /// from the log and saved.
+    ///     @param logFile Open log file
+    ///     @param[out] errorString Error message if false is returned
+    /// @return false: log contains no valid records
+    bool load(QFile& logFile, QString& errorString);
+
+    /// Builds the index with a single pass over the log
+    bool build(QFile& logFile);
+
+    /// Saves the index to the sidecar file for the specified log
+    bool save(const QString& logFilename, qint64 logFileSize) const;
+
+    /// Clears the index so a new log can be indexed as it is written
+    void clear(void);
+
+    /// Adds a record to the index as a log is written. Only records which start a new index slice are kept.
+    ///     @param timeUSecs Record timestamp
+    ///     @param offset File offset of the start of the record (the timestamp)
+    void addRecord(quint64 timeUSecs, qint64 offset);
+
+    /// @return File offset of the start of the indexed record closest to, but not after, the specified time
+    ///     @param[out] entryTimeUSecs Timestamp of the returned record
+    qint64 findOffset(quint64 timeUSecs, quint64* entryTimeUSecs) const;
+
+    bool    isEmpty(void) const         { return _entries.isEmpty(); }
+    int     count(void) const           { return _entries.count(); }
+    quint64 startTimeUSecs(void) const  { return _entries.isEmpty() ? 0 : _entries.first().timeUSecs; }
+    quint64 endTimeUSecs(void) const    { return _endTimeUSecs; }
+
+    /// @return Filename of the sidecar index for the specified log
+    static QString indexFilename(const QString& logFilename);
+
+    /// Parses a BigEndian quint64 timestamp. Older logs stored little endian timestamps, these are detected
+    /// by being in the future and byte swapped.
+    ///     @param currentTimeUSecs Current time from currentTimeUSecs, taken once for a whole pass over a log
+    /// @return A Unix timestamp in microseconds UTC
+    static quint64 parseTimestamp(const uint8_t* bytes, quint64 currentTimeUSecs);
+    static quint64 parseTimestamp(const uint8_t* bytes) { return parseTimestamp(bytes, currentTimeUSecs()); }
+
+    /// @return Current Unix time in microseconds UTC
+    static quint64 currentTimeUSecs(void);
+
+    static const int recordTimestampLength = sizeof(quint64);
+
+private:
+    typedef struct {
+        quint64 timeUSecs;
+        qint64  offset;
+    } IndexEntry_t;
+
+    bool _loadSidecar(const QString& logFilename, qint64 logFileSize);
+
+    QVector<IndexEntry_t>   _entries;
+    quint64                 _endTimeUSecs;
+
+    static const quint64    _indexIntervalUSecs = 100000;
+    static const char*      _indexFileExtension;
+    static const quint32    _indexMagic = 0x514C4958;   ///< "QLIX"
+    static const quint32    _indexVersion = 1;
+};
+
+#endif
@@ -0,0 +1,105 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "MAVLinkLogWriter.h"
+#include "QGCLoggingCategory.h"
+
+#include <QtEndian>
+
+QGC_LOGGING_CATEGORY(MAVLinkLogWriterLog, "MAVLinkLogWriterLog")
+
+MAVLinkLogWriter::MAVLinkLogWriter(QObject* parent)
+    : RingBufferedFileWriter(_ringBufferSize, parent)
+    , _fileOffset(0)
+    , _lastDroppedRecords(0)
+    , _queuedRecords(0)
+    , _droppedRecords(0)
+    , _droppedBytes(0)
+{
+
+}
+
+MAVLinkLogWriter::~MAVLinkLogWriter()
+{
+    stopLogging();
+}
+
+void MAVLinkLogWriter::startLogging(QFile* file)
+{
+    stopLogging();
+
+    _index.clear();
+    _fileOffset = 0;
+    _lastDroppedRecords = 0;
+    _queuedRecords.store(0);
+    _droppedRecords.store(0);
+    _droppedBytes.store(0);
+
+    _startWriter(file);
+}
+
+void MAVLinkLogWriter::stopLogging(void)
+{
+    if (!isRunning()) {
+        return;
+    }
+
+    _stopWriter();
+
+    qCDebug(MAVLinkLogWriterLog) << "Log writer stopped queued:dropped" << _queuedRecords.load() << _droppedRecords.load();
+
+    if (!failed() && !_index.isEmpty()) {
+        _index.save(_file->fileName(), _file->size());
+    }
+    _file = NULL;
+}
+
+bool MAVLinkLogWriter::logFrame(quint64 timestampUsecs, const uint8_t* frame, int length)
+{
+    if (!isRunning()) {
+        return false;
+    }
+
+    uint8_t timestamp[sizeof(quint64)];
+    qToBigEndian(timestampUsecs, timestamp);
+
+    const uint8_t*  rgParts[2] =    { timestamp, frame };
+    quint32         rgLengths[2] =  { sizeof(timestamp), (quint32)length };
+    quint32         recordLength =  sizeof(timestamp) + length;
+
+    if (!_queue(rgParts, rgLengths, 2)) {
+        _droppedRecords.fetchAndAddRelaxed(1);
+        _droppedBytes.fetchAndAddRelaxed(recordLength);
+        return false;
+    }
+    _queuedRecords.fetchAndAddRelaxed(1);
+
+    // Dropped records never reach the file, so the running offset is exactly where this record will be written
+    _index.addRecord(timestampUsecs, _fileOffset);
+    _fileOffset += recordLength;
+
+    return true;
+}
+
+/// Records are written to the file exactly as they sit in the ring
+bool MAVLinkLogWriter::_writeQueued(quint32 tail, quint32 count)
+{
+    if (count && !_writeRing(tail, count)) {
+        return false;
+    }
+
+    quint64 droppedRecords = _droppedRecords.load();
+    if (droppedRecords != _lastDroppedRecords) {
+        qCWarning(MAVLinkLogWriterLog) << "Log writer falling behind, dropped records" << droppedRecords;
+        _lastDroppedRecords = droppedRecords;
+        emit droppedRecordsChanged(droppedRecords);
+    }
+
+    return true;
+}
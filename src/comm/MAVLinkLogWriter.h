@@ -0,0 +1,77 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#ifndef MAVLinkLogWriter_H
+#define MAVLinkLogWriter_H
+
+#include <QAtomicInteger>
+#include <QLoggingCategory>
+
+#include "RingBufferedFileWriter.h"
+#include "MAVLinkLogIndex.h"
+
+Q_DECLARE_LOGGING_CATEGORY(MAVLinkLogWriterLog)
+
+/// Writes the telemetry flight data log on its own thread so a slow disk never stalls message decoding.
+///
+/// The receive thread hands each frame to logFrame, which copies the timestamp and the raw frame bytes into the ring
+/// of a RingBufferedFileWriter. The writer thread writes the ring out as is, in large batches. If the writer falls
+/// behind and the ring fills up, records are dropped and counted instead of blocking the receive thread.
+///
+/// The log file format is unchanged: each record is a big endian uint64 timestamp in microseconds followed by the
+/// MAVLink frame. The time index for the log (see MAVLinkLogIndex) is built as records are queued and saved when
+/// logging stops, so replay never has to scan a freshly recorded log.
+class MAVLinkLogWriter : public RingBufferedFileWriter
+{
+    Q_OBJECT
+
+public:
+    MAVLinkLogWriter(QObject* parent = NULL);
+    ~MAVLinkLogWriter();
+
+    /// Starts the writer thread. The file must already be open for writing and must not be touched by the
+    /// caller until stopLogging returns.
+    void startLogging(QFile* file);
+
+    /// Writes out everything which is queued, syncs the file, saves the log index and stops the writer thread.
+    void stopLogging(void);
+
+    /// Queues a frame for writing. Must only be called from a single thread.
+    ///     @param timestampUsecs UTC time in microseconds
+    ///     @param frame Raw frame bytes as received
+    ///     @param length Number of bytes in frame
+    /// @return false: ring buffer is full, record dropped
+    bool logFrame(quint64 timestampUsecs, const uint8_t* frame, int length);
+
+    quint64 queuedRecords(void) const { return _queuedRecords.load(); }
+    quint64 droppedRecords(void) const { return _droppedRecords.load(); }
+    quint64 droppedBytes(void) const { return _droppedBytes.load(); }
+
+signals:
+    /// Emitted from the writer thread when records have been dropped since the last batch
+    ///     @param droppedRecords Total number of dropped records for this log
+    void droppedRecordsChanged(quint64 droppedRecords);
+
+protected:
+    // Override from RingBufferedFileWriter
+    bool _writeQueued(quint32 tail, quint32 count);
+
+private:
+    MAVLinkLogIndex         _index;                 ///< Only accessed by the producer
+    qint64                  _fileOffset;            ///< File offset of the next queued record, only accessed by the producer
+    quint64                 _lastDroppedRecords;    ///< Only accessed by the writer thread
+
+    QAtomicInteger<quint64> _queuedRecords;
+    QAtomicInteger<quint64> _droppedRecords;
+    QAtomicInteger<quint64> _droppedBytes;
+
+    static const int _ringBufferSize = 4 * 1024 * 1024;    ///< Must be a power of 2
+};
+
+#endif
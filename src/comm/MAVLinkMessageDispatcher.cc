@@ -0,0 +1,146 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "MAVLinkMessageDispatcher.h"
+#include "QGCLoggingCategory.h"
+
+#include <QDebug>
+
+QGC_LOGGING_CATEGORY(MAVLinkMessageDispatcherLog, "MAVLinkMessageDispatcherLog")
+
+MAVLinkMessageSubscription::MAVLinkMessageSubscription(QObject* receiver, int sysid, int compid, int msgid, QObject* parent)
+    : QObject(parent)
+    , _receiver(receiver)
+    , _sysid(sysid)
+    , _compid(compid)
+    , _msgid(msgid)
+    , _active(true)
+{
+
+}
+
+MAVLinkMessageDispatcher::MAVLinkMessageDispatcher(QObject* parent)
+    : QObject(parent)
+{
+
+}
+
+MAVLinkMessageDispatcher::~MAVLinkMessageDispatcher()
+{
+    // Subscriptions are children of the dispatcher so they are deleted along with it
+}
+
+MAVLinkMessageDispatcher::SysIdBucket_t& MAVLinkMessageDispatcher::_bucket(int sysid)
+{
+    return sysid == anyId ? _anySysIdBucket : _sysIdBuckets[sysid];
+}
+
+MAVLinkMessageSubscription* MAVLinkMessageDispatcher::_addSubscription(QObject* receiver, int sysid, int compid, int msgid)
+{
+    if (!receiver || sysid < anyId || sysid >= _cSysIdBuckets || compid < anyId || compid > 255 || msgid < anyId) {
+        qWarning() << "MAVLinkMessageDispatcher::subscribe invalid subscription" << receiver << sysid << compid << msgid;
+        return NULL;
+    }
+
+    qCDebug(MAVLinkMessageDispatcherLog) << "subscribe" << receiver << sysid << compid << msgid;
+
+    MAVLinkMessageSubscription* subscription = new MAVLinkMessageSubscription(receiver, sysid, compid, msgid, this);
+
+    SysIdBucket_t& bucket = _bucket(sysid);
+    if (msgid == anyId) {
+        bucket.anyMsgId.append(subscription);
+    } else {
+        bucket.msgIdMap[msgid].append(subscription);
+    }
+
+    if (!_receiverMap.contains(receiver)) {
+        // The dispatcher lives on the protocol thread, as do the receivers which are destroyed while messages are flowing.
+        // A direct connection makes sure the tables never hold a receiver which is already gone.
+        connect(receiver, &QObject::destroyed, this, &MAVLinkMessageDispatcher::_receiverDestroyed, Qt::DirectConnection);
+    }
+    _receiverMap.insert(receiver, subscription);
+
+    return subscription;
+}
+
+void MAVLinkMessageDispatcher::unsubscribe(MAVLinkMessageSubscription* subscription)
+{
+    if (!subscription || !subscription->active()) {
+        return;
+    }
+
+    qCDebug(MAVLinkMessageDispatcherLog) << "unsubscribe" << subscription->receiver() << subscription->sysid() << subscription->compid() << subscription->msgid();
+
+    SysIdBucket_t& bucket = _bucket(subscription->sysid());
+    if (subscription->msgid() == anyId) {
+        bucket.anyMsgId.removeOne(subscription);
+    } else {
+        SubscriptionList& list = bucket.msgIdMap[subscription->msgid()];
+        list.removeOne(subscription);
+        if (list.isEmpty()) {
+            bucket.msgIdMap.remove(subscription->msgid());
+        }
+    }
+
+    QObject* receiver = subscription->receiver();
+    _receiverMap.remove(receiver, subscription);
+    if (!_receiverMap.contains(receiver)) {
+        disconnect(receiver, &QObject::destroyed, this, &MAVLinkMessageDispatcher::_receiverDestroyed);
+    }
+
+    // A dispatch may currently be iterating over a list which holds this subscription. Mark it inactive so it is skipped
+    // and let the event loop delete it.
+    subscription->setActive(false);
+    subscription->disconnect();
+    subscription->deleteLater();
+}
+
+void MAVLinkMessageDispatcher::unsubscribeAll(QObject* receiver)
+{
+    foreach (MAVLinkMessageSubscription* subscription, _receiverMap.values(receiver)) {
+        unsubscribe(subscription);
+    }
+}
+
+void MAVLinkMessageDispatcher::_receiverDestroyed(QObject* receiver)
+{
+    unsubscribeAll(receiver);
+}
+
+void MAVLinkMessageDispatcher::_deliver(const SubscriptionList& subscriptions, LinkInterface* link, const mavlink_message_t& message)
+{
+    // We iterate over a shallow copy so subscribers can add/remove subscriptions from within their slots
+    for (int i=0; i<subscriptions.count(); i++) {
+        MAVLinkMessageSubscription* subscription = subscriptions[i];
+        if (subscription->active() && (subscription->compid() == anyId || subscription->compid() == message.compid)) {
+            emit subscription->messageReceived(link, message);
+        }
+    }
+}
+
+void MAVLinkMessageDispatcher::dispatch(LinkInterface* link, const mavlink_message_t& message)
+{
+    SysIdBucket_t* buckets[2] = { &_sysIdBuckets[message.sysid], &_anySysIdBucket };
+
+    for (size_t i=0; i<sizeof(buckets)/sizeof(buckets[0]); i++) {
+        const SysIdBucket_t& bucket = *buckets[i];
+
+        if (!bucket.anyMsgId.isEmpty()) {
+            SubscriptionList subscriptions = bucket.anyMsgId;
+            _deliver(subscriptions, link, message);
+        }
+        if (!bucket.msgIdMap.isEmpty()) {
+            QHash<uint32_t, SubscriptionList>::const_iterator iter = bucket.msgIdMap.constFind(message.msgid);
+            if (iter != bucket.msgIdMap.constEnd()) {
+                SubscriptionList subscriptions = iter.value();
+                _deliver(subscriptions, link, message);
+            }
+        }
+    }
+}
@@ -0,0 +1,124 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#ifndef MAVLinkMessageDispatcher_H
+#define MAVLinkMessageDispatcher_H
+
+#include <QObject>
+#include <QList>
+#include <QHash>
+#include <QMultiHash>
+#include <QLoggingCategory>
+
+#include "QGCMAVLink.h"
+
+class LinkInterface;
+
+Q_DECLARE_LOGGING_CATEGORY(MAVLinkMessageDispatcherLog)
+
+/// A single subscription held by MAVLinkMessageDispatcher. The dispatcher emits messageReceived only for
+/// messages which match the subscription filter. Subscribers never create these directly, they are
+/// created by MAVLinkMessageDispatcher::subscribe.
+class MAVLinkMessageSubscription : public QObject
+{
+    Q_OBJECT
+
+public:
+    MAVLinkMessageSubscription(QObject* receiver, int sysid, int compid, int msgid, QObject* parent = NULL);
+
+    QObject*    receiver(void) const    { return _receiver; }
+    int         sysid(void) const       { return _sysid; }
+    int         compid(void) const      { return _compid; }
+    int         msgid(void) const       { return _msgid; }
+    bool        active(void) const      { return _active; }
+
+    void setActive(bool active) { _active = active; }
+
+signals:
+    void messageReceived(LinkInterface* link, mavlink_message_t message);
+
+private:
+    QObject*    _receiver;
+    int         _sysid;
+    int         _compid;
+    int         _msgid;
+    bool        _active;    ///< false: subscription has been removed, but may still be referenced by an in progress dispatch
+};
+
+/// Routes decoded MAVLink messages to the consumers which are interested in them. Consumers register
+/// interest by (sysid, compid, msgid), any of which can be MAVLinkMessageDispatcher::anyId. Subscriptions
+/// are bucketed by sysid and then by msgid so dispatching a message only visits the subscribers which
+/// can possibly match it, instead of every consumer receiving and filtering every packet.
+///
+/// The dispatcher must only be used from the thread it lives on (the MAVLinkProtocol thread). Receivers
+/// can live on any thread, delivery follows normal Qt::AutoConnection rules.
+class MAVLinkMessageDispatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    MAVLinkMessageDispatcher(QObject* parent = NULL);
+    ~MAVLinkMessageDispatcher();
+
+    static const int anyId = -1;
+
+    /// Subscribes the specified receiver slot to all messages which match the filter.
+    ///     @param sysid System id to match, or anyId
+    ///     @param compid Component id to match, or anyId
+    ///     @param msgid Message id to match, or anyId
+    ///     @param receiver Object which receives the messages. Subscription is removed when the receiver is destroyed.
+    ///     @param slot Slot with signature (LinkInterface* link, mavlink_message_t message)
+    /// @return Subscription object, can be passed to unsubscribe
+    template <typename Func>
+    MAVLinkMessageSubscription* subscribe(int sysid, int compid, int msgid, const typename QtPrivate::FunctionPointer<Func>::Object* receiver, Func slot)
+    {
+        MAVLinkMessageSubscription* subscription = _addSubscription(const_cast<QObject*>(static_cast<const QObject*>(receiver)), sysid, compid, msgid);
+        if (subscription) {
+            connect(subscription, &MAVLinkMessageSubscription::messageReceived, receiver, slot);
+        }
+        return subscription;
+    }
+
+    /// Removes a single subscription
+    void unsubscribe(MAVLinkMessageSubscription* subscription);
+
+    /// Removes all subscriptions for the specified receiver
+    void unsubscribeAll(QObject* receiver);
+
+    /// Delivers the message to all matching subscribers
+    void dispatch(LinkInterface* link, const mavlink_message_t& message);
+
+    /// @return Number of active subscriptions
+    int subscriptionCount(void) const { return _receiverMap.count(); }
+
+private slots:
+    void _receiverDestroyed(QObject* receiver);
+
+private:
+    typedef QList<MAVLinkMessageSubscription*> SubscriptionList;
+
+    /// All subscriptions for a single sysid, split by msgid
+    typedef struct {
+        SubscriptionList                    anyMsgId;
+        QHash<uint32_t, SubscriptionList>   msgIdMap;
+    } SysIdBucket_t;
+
+    MAVLinkMessageSubscription* _addSubscription(QObject* receiver, int sysid, int compid, int msgid);
+    SysIdBucket_t&              _bucket(int sysid);
+    void                        _deliver(const SubscriptionList& subscriptions, LinkInterface* link, const mavlink_message_t& message);
+
+    static const int _cSysIdBuckets = 256;
+
+    SysIdBucket_t   _sysIdBuckets[_cSysIdBuckets];  ///< Direct index by sysid
+    SysIdBucket_t   _anySysIdBucket;                ///< Subscriptions for anyId sysid
+
+    QMultiHash<QObject*, MAVLinkMessageSubscription*> _receiverMap;
+};
+
+#endif
@@ -22,7 +22,6 @@
 #include <QApplication>
 #include <QSettings>
 #include <QStandardPaths>
-#include <QtEndian>
 #include <QMetaType>
 
 #include "MAVLinkProtocol.h"
@@ -59,15 +58,26 @@ MAVLinkProtocol::MAVLinkProtocol(QGCApplication* app)
     , _logSuspendReplay(false)
     , _vehicleWasArmed(false)
     , _tempLogFile(QString("%2.%3").arg(_tempLogFileTemplate).arg(_logFileExtension))
+    , _logWriter(new MAVLinkLogWriter(this))
 #endif
     , _linkMgr(NULL)
     , _multiVehicleManager(NULL)
+    , _messageDispatcher(new MAVLinkMessageDispatcher(this))
 {
     memset(&totalReceiveCounter, 0, sizeof(totalReceiveCounter));
     memset(&totalLossCounter, 0, sizeof(totalLossCounter));
     memset(&totalErrorCounter, 0, sizeof(totalErrorCounter));
     memset(&currReceiveCounter, 0, sizeof(currReceiveCounter));
     memset(&currLossCounter, 0, sizeof(currLossCounter));
+
+    for (int i=0; i<MAVLINK_COMM_NUM_BUFFERS; i++) {
+        _frameScanners[i].setChannel(i);
+    }
+
+#ifndef __mobile__
+    connect(_logWriter, &MAVLinkLogWriter::writeFailed,             this, &MAVLinkProtocol::_logWriteFailed);
+    connect(_logWriter, &MAVLinkLogWriter::droppedRecordsChanged,   this, &MAVLinkProtocol::_logRecordsDropped);
+#endif
 }
 
 MAVLinkProtocol::~MAVLinkProtocol()
@@ -145,12 +155,14 @@ void MAVLinkProtocol::resetMetadataForLink(const LinkInterface *link)
     totalErrorCounter[channel] = 0;
     currReceiveCounter[channel] = 0;
     currLossCounter[channel] = 0;
+    _frameScanners[channel].reset();
 }
 
 /**
  * This method parses all incoming bytes and constructs a MAVLink packet.
- * It can handle multiple links in parallel, as each link has it's own buffer/
- * parsing state machine.
+ * It can handle multiple links in parallel, as each link has it's own frame
+ * scanner. Complete frames are located and CRC checked a whole frame at a time
+ * instead of running the parser state machine over every byte.
  * @param link The interface to read from
  * @see LinkInterface
  **/
@@ -165,7 +177,6 @@ void MAVLinkProtocol::receiveBytes(LinkInterface* link, QByteArray b)
 
 //    receiveMutex.lock();
     mavlink_message_t message;
-    mavlink_status_t status;
 
     int mavlinkChannel = link->mavlinkChannel();
 
@@ -173,166 +184,152 @@ void MAVLinkProtocol::receiveBytes(LinkInterface* link, QByteArray b)
     static bool checkedUserNonMavlink = false;
     static bool warnedUserNonMavlink = false;
 
-    for (int position = 0; position < b.size(); position++) {
-        unsigned int decodeState = mavlink_parse_char(mavlinkChannel, (uint8_t)(b[position]), &message, &status);
+    MAVLinkFrameScanner& scanner = _frameScanners[mavlinkChannel];
+    scanner.append(b);
 
-        if (decodeState == 0 && !link->decodedFirstMavlinkPacket())
-        {
-            nonmavlinkCount++;
-            if (nonmavlinkCount > 2000 && !warnedUserNonMavlink)
-            {
-                //2000 bytes with no mavlink message. Are we connected to a mavlink capable device?
-                if (!checkedUserNonMavlink)
-                {
-                    link->requestReset();
-                    checkedUserNonMavlink = true;
-                }
-                else
-                {
-                    warnedUserNonMavlink = true;
-                    emit protocolStatusMessage(tr("MAVLink Protocol"), tr("There is a MAVLink Version or Baud Rate Mismatch. "
-                                                                          "Please check if the baud rates of QGroundControl and your autopilot are the same."));
-                }
+    bool decodedMessage = false;
+    while (scanner.nextMessage(&message)) {
+        decodedMessage = true;
+
+        if (!link->decodedFirstMavlinkPacket()) {
+            mavlink_status_t* mavlinkStatus = mavlink_get_channel_status(mavlinkChannel);
+            if (!(mavlinkStatus->flags & MAVLINK_STATUS_FLAG_IN_MAVLINK1) && (mavlinkStatus->flags & MAVLINK_STATUS_FLAG_OUT_MAVLINK1)) {
+                qDebug() << "Switching outbound to mavlink 2.0 due to incoming mavlink 2.0 packet:" << mavlinkStatus << mavlinkChannel << mavlinkStatus->flags;
+                mavlinkStatus->flags &= ~MAVLINK_STATUS_FLAG_OUT_MAVLINK1;
             }
+            link->setDecodedFirstMavlinkPacket(true);
         }
-        if (decodeState == 1)
+
+        if(message.msgid == MAVLINK_MSG_ID_RADIO_STATUS)
         {
-            if (!link->decodedFirstMavlinkPacket()) {
-                mavlink_status_t* mavlinkStatus = mavlink_get_channel_status(mavlinkChannel);
-                if (!(mavlinkStatus->flags & MAVLINK_STATUS_FLAG_IN_MAVLINK1) && (mavlinkStatus->flags & MAVLINK_STATUS_FLAG_OUT_MAVLINK1)) {
-                    qDebug() << "Switching outbound to mavlink 2.0 due to incoming mavlink 2.0 packet:" << mavlinkStatus << mavlinkChannel << mavlinkStatus->flags;
-                    mavlinkStatus->flags &= ~MAVLINK_STATUS_FLAG_OUT_MAVLINK1;
-                }
-                link->setDecodedFirstMavlinkPacket(true);
+            // process telemetry status message
+            mavlink_radio_status_t rstatus;
+            mavlink_msg_radio_status_decode(&message, &rstatus);
+            int rssi = rstatus.rssi,
+                remrssi = rstatus.remrssi;
+            // 3DR Si1k radio needs rssi fields to be converted to dBm
+            if (message.sysid == '3' && message.compid == 'D') {
+                /* Per the Si1K datasheet figure 23.25 and SI AN474 code
+                 * samples the relationship between the RSSI register
+                 * and received power is as follows:
+                 *
+                 *                       10
+                 * inputPower = rssi * ------ 127
+                 *                       19
+                 *
+                 * Additionally limit to the only realistic range [-120,0] dBm
+                 */
+                rssi    = qMin(qMax(qRound(static_cast<qreal>(rssi)    / 1.9 - 127.0), - 120), 0);
+                remrssi = qMin(qMax(qRound(static_cast<qreal>(remrssi) / 1.9 - 127.0), - 120), 0);
+            } else {
+                rssi = (int8_t) rstatus.rssi;
+                remrssi = (int8_t) rstatus.remrssi;
             }
 
-            if(message.msgid == MAVLINK_MSG_ID_RADIO_STATUS)
-            {
-                // process telemetry status message
-                mavlink_radio_status_t rstatus;
-                mavlink_msg_radio_status_decode(&message, &rstatus);
-                int rssi = rstatus.rssi,
-                    remrssi = rstatus.remrssi;
-                // 3DR Si1k radio needs rssi fields to be converted to dBm
-                if (message.sysid == '3' && message.compid == 'D') {
-                    /* Per the Si1K datasheet figure 23.25 and SI AN474 code
-                     * samples the relationship between the RSSI register
-                     * and received power is as follows:
-                     *
-                     *                       10
-                     * inputPower = rssi * ------ 127
-                     *                       19
-                     *
-                     * Additionally limit to the only realistic range [-120,0] dBm
-                     */
-                    rssi    = qMin(qMax(qRound(static_cast<qreal>(rssi)    / 1.9 - 127.0), - 120), 0);
-                    remrssi = qMin(qMax(qRound(static_cast<qreal>(remrssi) / 1.9 - 127.0), - 120), 0);
-                } else {
-                    rssi = (int8_t) rstatus.rssi;
-                    remrssi = (int8_t) rstatus.remrssi;
-                }
-
-                emit radioStatusChanged(link, rstatus.rxerrors, rstatus.fixed, rssi, remrssi,
-                    rstatus.txbuf, rstatus.noise, rstatus.remnoise);
-            }
+            emit radioStatusChanged(link, rstatus.rxerrors, rstatus.fixed, rssi, remrssi,
+                rstatus.txbuf, rstatus.noise, rstatus.remnoise);
+        }
 
 #ifndef __mobile__
-            // Log data
-
-            if (!_logSuspendError && !_logSuspendReplay && _tempLogFile.isOpen()) {
-                uint8_t buf[MAVLINK_MAX_PACKET_LEN+sizeof(quint64)];
-
-                // Write the uint64 time in microseconds in big endian format before the message.
-                // This timestamp is saved in UTC time. We are only saving in ms precision because
-                // getting more than this isn't possible with Qt without a ton of extra code.
-                quint64 time = (quint64)QDateTime::currentMSecsSinceEpoch() * 1000;
-                qToBigEndian(time, buf);
-
-                // Then write the message to the buffer
-                int len = mavlink_msg_to_send_buffer(buf + sizeof(quint64), &message);
-
-                // Determine how many bytes were written by adding the timestamp size to the message size
-                len += sizeof(quint64);
-
-                // Now write this timestamp/message pair to the log.
-                QByteArray b((const char*)buf, len);
-                if(_tempLogFile.write(b) != len)
-                {
-                    // If there's an error logging data, raise an alert and stop logging.
-                    emit protocolStatusMessage(tr("MAVLink Protocol"), tr("MAVLink Logging failed. Could not write to file %1, logging disabled.").arg(_tempLogFile.fileName()));
-                    _stopLogging();
-                    _logSuspendError = true;
-                }
-
-                // Check for the vehicle arming going by. This is used to trigger log save.
-                if (!_vehicleWasArmed && message.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
-                    mavlink_heartbeat_t state;
-                    mavlink_msg_heartbeat_decode(&message, &state);
-                    if (state.base_mode & MAV_MODE_FLAG_DECODE_POSITION_SAFETY) {
-                        _vehicleWasArmed = true;
-                    }
+        // Log data
+
+        if (!_logSuspendError && !_logSuspendReplay && _tempLogFile.isOpen()) {
+            // Write the uint64 time in microseconds in big endian format before the message.
+            // This timestamp is saved in UTC time. We are only saving in ms precision because
+            // getting more than this isn't possible with Qt without a ton of extra code.
+            quint64 time = (quint64)QDateTime::currentMSecsSinceEpoch() * 1000;
+
+            // The frame is logged exactly as it was received. The write itself happens on the log writer
+            // thread so a slow disk can't hold up decoding. Records are only dropped if the writer falls behind.
+            _logWriter->logFrame(time, scanner.frameData(), scanner.frameLength());
+
+            // Check for the vehicle arming going by. This is used to trigger log save.
+            if (!_vehicleWasArmed && message.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
+                mavlink_heartbeat_t state;
+                mavlink_msg_heartbeat_decode(&message, &state);
+                if (state.base_mode & MAV_MODE_FLAG_DECODE_POSITION_SAFETY) {
+                    _vehicleWasArmed = true;
                 }
             }
+        }
 #endif
 
-            if (message.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
+        if (message.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
 #ifndef __mobile__
-                // Start loggin on first heartbeat
-                _startLogging();
+            // Start loggin on first heartbeat
+            _startLogging();
 #endif
 
-                mavlink_heartbeat_t heartbeat;
-                mavlink_msg_heartbeat_decode(&message, &heartbeat);
-                emit vehicleHeartbeatInfo(link, message.sysid, heartbeat.mavlink_version, heartbeat.autopilot, heartbeat.type);
-            }
+            mavlink_heartbeat_t heartbeat;
+            mavlink_msg_heartbeat_decode(&message, &heartbeat);
+            emit vehicleHeartbeatInfo(link, message.sysid, heartbeat.mavlink_version, heartbeat.autopilot, heartbeat.type);
+        }
 
-            // Increase receive counter
-            totalReceiveCounter[mavlinkChannel]++;
-            currReceiveCounter[mavlinkChannel]++;
+        // Increase receive counter
+        totalReceiveCounter[mavlinkChannel]++;
+        currReceiveCounter[mavlinkChannel]++;
 
-            // Determine what the next expected sequence number is, accounting for
-            // never having seen a message for this system/component pair.
-            int lastSeq = lastIndex[message.sysid][message.compid];
-            int expectedSeq = (lastSeq == -1) ? message.seq : (lastSeq + 1);
+        // Determine what the next expected sequence number is, accounting for
+        // never having seen a message for this system/component pair.
+        int lastSeq = lastIndex[message.sysid][message.compid];
+        int expectedSeq = (lastSeq == -1) ? message.seq : (lastSeq + 1);
 
-            // And if we didn't encounter that sequence number, record the error
-            if (message.seq != expectedSeq)
+        // And if we didn't encounter that sequence number, record the error
+        if (message.seq != expectedSeq)
+        {
+
+            // Determine how many messages were skipped
+            int lostMessages = message.seq - expectedSeq;
+
+            // Out of order messages or wraparound can cause this, but we just ignore these conditions for simplicity
+            if (lostMessages < 0)
             {
+                lostMessages = 0;
+            }
 
-                // Determine how many messages were skipped
-                int lostMessages = message.seq - expectedSeq;
+            // And log how many were lost for all time and just this timestep
+            totalLossCounter[mavlinkChannel] += lostMessages;
+            currLossCounter[mavlinkChannel] += lostMessages;
+        }
 
-                // Out of order messages or wraparound can cause this, but we just ignore these conditions for simplicity
-                if (lostMessages < 0)
-                {
-                    lostMessages = 0;
-                }
+        // And update the last sequence number for this system/component pair
+        lastIndex[message.sysid][message.compid] = expectedSeq;
 
-                // And log how many were lost for all time and just this timestep
-                totalLossCounter[mavlinkChannel] += lostMessages;
-                currLossCounter[mavlinkChannel] += lostMessages;
-            }
+        // Update on every 32th packet
+        if ((totalReceiveCounter[mavlinkChannel] & 0x1F) == 0)
+        {
+            // Calculate new loss ratio
+            // Receive loss
+            float receiveLossPercent = (double)currLossCounter[mavlinkChannel]/(double)(currReceiveCounter[mavlinkChannel]+currLossCounter[mavlinkChannel]);
+            receiveLossPercent *= 100.0f;
+            currLossCounter[mavlinkChannel] = 0;
+            currReceiveCounter[mavlinkChannel] = 0;
+            emit receiveLossPercentChanged(message.sysid, receiveLossPercent);
+            emit receiveLossTotalChanged(message.sysid, totalLossCounter[mavlinkChannel]);
+        }
 
-            // And update the last sequence number for this system/component pair
-            lastIndex[message.sysid][message.compid] = expectedSeq;
+        // Only the subscribers which registered for this sysid/compid/msgid see the message
+        _messageDispatcher->dispatch(link, message);
+    }
 
-            // Update on every 32th packet
-            if ((totalReceiveCounter[mavlinkChannel] & 0x1F) == 0)
+    if (!decodedMessage && !link->decodedFirstMavlinkPacket())
+    {
+        // Whole block went by without a single mavlink message
+        nonmavlinkCount += b.size();
+        if (nonmavlinkCount > 2000 && !warnedUserNonMavlink)
+        {
+            //2000 bytes with no mavlink message. Are we connected to a mavlink capable device?
+            if (!checkedUserNonMavlink)
             {
-                // Calculate new loss ratio
-                // Receive loss
-                float receiveLossPercent = (double)currLossCounter[mavlinkChannel]/(double)(currReceiveCounter[mavlinkChannel]+currLossCounter[mavlinkChannel]);
-                receiveLossPercent *= 100.0f;
-                currLossCounter[mavlinkChannel] = 0;
-                currReceiveCounter[mavlinkChannel] = 0;
-                emit receiveLossPercentChanged(message.sysid, receiveLossPercent);
-                emit receiveLossTotalChanged(message.sysid, totalLossCounter[mavlinkChannel]);
+                link->requestReset();
+                checkedUserNonMavlink = true;
+            }
+            else
+            {
+                warnedUserNonMavlink = true;
+                emit protocolStatusMessage(tr("MAVLink Protocol"), tr("There is a MAVLink Version or Baud Rate Mismatch. "
+                                                                      "Please check if the baud rates of QGroundControl and your autopilot are the same."));
             }
-
-            // The packet is emitted as a whole, as it is only 255 - 261 bytes short
-            // kind of inefficient, but no issue for a groundstation pc.
-            // It buys as reentrancy for the whole code over all threads
-            emit messageReceived(link, message);
         }
     }
 }
@@ -385,6 +382,9 @@ void MAVLinkProtocol::_vehicleCountChanged(int count)
 bool MAVLinkProtocol::_closeLogFile(void)
 {
     if (_tempLogFile.isOpen()) {
+        // Make sure everything queued is on disk before we look at the file
+        _logWriter->stopLogging();
+
         if (_tempLogFile.size() == 0) {
             // Don't save zero byte files
             _tempLogFile.remove();
@@ -414,6 +414,7 @@ void MAVLinkProtocol::_startLogging(void)
             qDebug() << "Temp log" << _tempLogFile.fileName();
 
             _logSuspendError = false;
+            _logWriter->startLogging(&_tempLogFile);
         }
     }
 }
@@ -426,6 +427,7 @@ void MAVLinkProtocol::_stopLogging(void)
             emit saveTempFlightDataLog(_tempLogFile.fileName());
         } else {
             QFile::remove(_tempLogFile.fileName());
+            QFile::remove(MAVLinkLogIndex::indexFilename(_tempLogFile.fileName()));
         }
     }
     _vehicleWasArmed = false;
@@ -447,6 +449,7 @@ void MAVLinkProtocol::checkForLostLogFiles(void)
         if (fileInfo.size() == 0) {
             // Delete all zero length files
             QFile::remove(fileInfo.filePath());
+            QFile::remove(MAVLinkLogIndex::indexFilename(fileInfo.filePath()));
             continue;
         }
 
@@ -459,6 +462,20 @@ void MAVLinkProtocol::checkForLostLogFiles(void)
     }
 }
 
+void MAVLinkProtocol::_logWriteFailed(QString errorString)
+{
+    // If there's an error logging data, raise an alert and stop logging.
+    emit protocolStatusMessage(tr("MAVLink Protocol"), tr("MAVLink Logging failed. Could not write to file %1, logging disabled. %2").arg(_tempLogFile.fileName()).arg(errorString));
+    _stopLogging();
+    _logSuspendError = true;
+}
+
+void MAVLinkProtocol::_logRecordsDropped(quint64 droppedRecords)
+{
+    qCWarning(MAVLinkProtocolLog) << "Flight data log dropped records" << droppedRecords << _tempLogFile.fileName();
+    emit logRecordsDropped(droppedRecords);
+}
+
 void MAVLinkProtocol::suspendLogForReplay(bool suspend)
 {
     _logSuspendReplay = suspend;
@@ -473,6 +490,7 @@ void MAVLinkProtocol::deleteTempLogFiles(void)
 
     foreach(const QFileInfo fileInfo, fileInfoList) {
         QFile::remove(fileInfo.filePath());
+        QFile::remove(MAVLinkLogIndex::indexFilename(fileInfo.filePath()));
     }
 }
 #endif
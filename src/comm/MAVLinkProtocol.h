@@ -20,10 +20,15 @@
 #include <QLoggingCategory>
 
 #include "LinkInterface.h"
+#include "MAVLinkMessageDispatcher.h"
+#include "MAVLinkFrameScanner.h"
 #include "QGCMAVLink.h"
 #include "QGC.h"
 #include "QGCTemporaryFile.h"
 #include "QGCToolbox.h"
+#ifndef __mobile__
+#include "MAVLinkLogWriter.h"
+#endif
 
 class LinkManager;
 class MultiVehicleManager;
@@ -90,6 +95,14 @@ public:
     /// Suspend/Restart logging during replay.
     void suspendLogForReplay(bool suspend);
 
+#ifndef __mobile__
+    /// @return Number of telemetry log records dropped because the log writer could not keep up
+    quint64 droppedLogRecordCount(void) const { return _logWriter->droppedRecords(); }
+#endif
+
+    /// Consumers of decoded messages subscribe through the dispatcher by (sysid, compid, msgid)
+    MAVLinkMessageDispatcher* messageDispatcher(void) { return _messageDispatcher; }
+
     // Override from QGCTool
     virtual void setToolbox(QGCToolbox *toolbox);
 
@@ -132,8 +145,6 @@ signals:
     /// Heartbeat received on link
     void vehicleHeartbeatInfo(LinkInterface* link, int vehicleId, int vehicleMavlinkVersion, int vehicleFirmwareType, int vehicleType);
 
-    /** @brief Message received and directly copied via signal */
-    void messageReceived(LinkInterface* link, mavlink_message_t message);
     /** @brief Emitted if version check is enabled / disabled */
     void versionCheckChanged(bool enabled);
     /** @brief Emitted if a message from the protocol should reach the user */
@@ -161,8 +172,16 @@ signals:
     /// @brief Emitted when a temporary log file is ready for saving
     void saveTempFlightDataLog(QString tempLogfile);
 
+    /// @brief Emitted when telemetry log records are dropped because the disk can't keep up
+    ///     @param droppedRecords Total number of records dropped from the current log
+    void logRecordsDropped(quint64 droppedRecords);
+
 private slots:
     void _vehicleCountChanged(int count);
+#ifndef __mobile__
+    void _logWriteFailed(QString errorString);
+    void _logRecordsDropped(quint64 droppedRecords);
+#endif
     
 private:
 #ifndef __mobile__
@@ -175,12 +194,15 @@ private:
     bool _vehicleWasArmed;      ///< true: Vehicle was armed during log sequence
 
     QGCTemporaryFile    _tempLogFile;            ///< File to log to
+    MAVLinkLogWriter*   _logWriter;              ///< Writes _tempLogFile on a separate thread
     static const char*  _tempLogFileTemplate;    ///< Template for temporary log file
     static const char*  _logFileExtension;       ///< Extension for log files
 #endif
 
-    LinkManager*            _linkMgr;
-    MultiVehicleManager*    _multiVehicleManager;
+    LinkManager*                _linkMgr;
+    MultiVehicleManager*        _multiVehicleManager;
+    MAVLinkMessageDispatcher*   _messageDispatcher;
+    MAVLinkFrameScanner         _frameScanners[MAVLINK_COMM_NUM_BUFFERS];  ///< Per channel frame decoders
 };
 
 #endif // MAVLINKPROTOCOL_H_
@@ -43,6 +43,7 @@ const char* MockConfiguration::_firmwareTypeKey =   "FirmwareType";
 const char* MockConfiguration::_vehicleTypeKey =    "VehicleType";
 const char* MockConfiguration::_sendStatusTextKey = "SendStatusText";
 const char* MockConfiguration::_failureModeKey =    "FailureMode";
+const char* MockConfiguration::_packetDropPercentKey = "PacketDropPercent";
 
 MockLink::MockLink(SharedLinkConfigurationPointer& config)
     : LinkInterface(config)
@@ -61,10 +62,14 @@ MockLink::MockLink(SharedLinkConfigurationPointer& config)
     , _sendStatusText(false)
     , _apmSendHomePositionOnEmptyList(false)
     , _failureMode(MockConfiguration::FailNone)
+    , _packetDropPercent(0)
+    , _packetDropInterval(0)
+    , _packetDropCount(0)
     , _sendHomePositionDelayCount(10)   // No home position for 4 seconds
     , _sendGPSPositionDelayCount(100)   // No gps lock for 5 seconds
     , _currentParamRequestListComponentIndex(-1)
     , _currentParamRequestListParamIndex(-1)
+    , _logDownloadFileSize(_defaultLogDownloadFileSize)
     , _logDownloadCurrentOffset(0)
     , _logDownloadBytesRemaining(0)
 {
@@ -73,6 +78,7 @@ MockLink::MockLink(SharedLinkConfigurationPointer& config)
     _vehicleType = mockConfig->vehicleType();
     _sendStatusText = mockConfig->sendStatusText();
     _failureMode = mockConfig->failureMode();
+    _packetDropPercent.store(mockConfig->packetDropPercent());
 
     union px4_custom_mode   px4_cm;
 
@@ -296,6 +302,18 @@ void MockLink::respondWithMavlinkMessage(const mavlink_message_t& msg)
 {
     uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
 
+    int packetDropPercent = _packetDropPercent.load();
+    if (packetDropPercent > 0 && (qrand() % 100) < packetDropPercent) {
+        qCDebug(MockLinkVerboseLog) << "Dropping message" << msg.msgid;
+        return;
+    }
+
+    int packetDropInterval = _packetDropInterval.load();
+    if (packetDropInterval > 0 && (_packetDropCount.fetchAndAddRelaxed(1) % packetDropInterval) == packetDropInterval - 1) {
+        qCDebug(MockLinkVerboseLog) << "Dropping message" << msg.msgid;
+        return;
+    }
+
     int cBuffer = mavlink_msg_to_send_buffer(buffer, &msg);
     QByteArray bytes((char *)buffer, cBuffer);
     emit bytesReceived(this, bytes);
@@ -976,6 +994,7 @@ MockConfiguration::MockConfiguration(const QString& name)
     , _vehicleType(MAV_TYPE_QUADROTOR)
     , _sendStatusText(false)
     , _failureMode(FailNone)
+    , _packetDropPercent(0)
 {
 
 }
@@ -987,6 +1006,7 @@ MockConfiguration::MockConfiguration(MockConfiguration* source)
     _vehicleType =      source->_vehicleType;
     _sendStatusText =   source->_sendStatusText;
     _failureMode =      source->_failureMode;
+    _packetDropPercent = source->_packetDropPercent;
 }
 
 void MockConfiguration::copyFrom(LinkConfiguration *source)
@@ -1003,6 +1023,7 @@ void MockConfiguration::copyFrom(LinkConfiguration *source)
     _vehicleType =      usource->_vehicleType;
     _sendStatusText =   usource->_sendStatusText;
     _failureMode =      usource->_failureMode;
+    _packetDropPercent = usource->_packetDropPercent;
 }
 
 void MockConfiguration::saveSettings(QSettings& settings, const QString& root)
@@ -1012,6 +1033,7 @@ void MockConfiguration::saveSettings(QSettings& settings, const QString& root)
     settings.setValue(_vehicleTypeKey, (int)_vehicleType);
     settings.setValue(_sendStatusTextKey, _sendStatusText);
     settings.setValue(_failureModeKey, (int)_failureMode);
+    settings.setValue(_packetDropPercentKey, _packetDropPercent);
     settings.sync();
     settings.endGroup();
 }
@@ -1023,6 +1045,7 @@ void MockConfiguration::loadSettings(QSettings& settings, const QString& root)
     _vehicleType = (MAV_TYPE)settings.value(_vehicleTypeKey, (int)MAV_TYPE_QUADROTOR).toInt();
     _sendStatusText = settings.value(_sendStatusTextKey, false).toBool();
     _failureMode = (FailureMode_t)settings.value(_failureModeKey, (int)FailNone).toInt();
+    _packetDropPercent = settings.value(_packetDropPercentKey, 0).toInt();
     settings.endGroup();
 }
 
@@ -1228,7 +1251,7 @@ void MockLink::_logDownloadWorker(void)
             Q_ASSERT(file.seek(_logDownloadCurrentOffset));
             Q_ASSERT(file.read((char *)buffer, bytesToRead) == bytesToRead);
 
-            qDebug() << "MockLink::_logDownloadWorker" << _logDownloadCurrentOffset << _logDownloadBytesRemaining;
+            qCDebug(MockLinkVerboseLog) << "MockLink::_logDownloadWorker" << _logDownloadCurrentOffset << _logDownloadBytesRemaining;
 
             mavlink_message_t responseMsg;
             mavlink_msg_log_data_pack_chan(_vehicleSystemId,
@@ -12,6 +12,7 @@
 #define MOCKLINK_H
 
 #include <QMap>
+#include <QAtomicInt>
 #include <QLoggingCategory>
 
 #include "MockLinkMissionItemHandler.h"
@@ -60,6 +61,10 @@ public:
     FailureMode_t failureMode(void) { return _failureMode; }
     void setFailureMode(FailureMode_t failureMode) { _failureMode = failureMode; }
 
+    /// @param packetDropPercent Percentage of messages to QGC which are randomly dropped, to simulate a lossy link
+    int packetDropPercent(void) { return _packetDropPercent; }
+    void setPacketDropPercent(int packetDropPercent) { _packetDropPercent = packetDropPercent; }
+
     // Overrides from LinkConfiguration
     LinkType    type            (void) { return LinkConfiguration::TypeMock; }
     void        copyFrom        (LinkConfiguration* source);
@@ -78,11 +83,13 @@ private:
     MAV_TYPE        _vehicleType;
     bool            _sendStatusText;
     FailureMode_t   _failureMode;
+    int             _packetDropPercent;
 
     static const char* _firmwareTypeKey;
     static const char* _vehicleTypeKey;
     static const char* _sendStatusTextKey;
     static const char* _failureModeKey;
+    static const char* _packetDropPercentKey;
 };
 
 class MockLink : public LinkInterface
@@ -100,6 +107,14 @@ public:
     void setSendStatusText(bool sendStatusText) { _sendStatusText = sendStatusText; }
     void setFailureMode(MockConfiguration::FailureMode_t failureMode) { _failureMode = failureMode; }
 
+    /// Randomly drops the specified percentage of messages sent to QGC. Sequence numbers are still used up by dropped
+    /// messages, so QGC sees the loss the same way it would on a real link.
+    void setPacketDropPercent(int packetDropPercent) { _packetDropPercent.store(packetDropPercent); }
+
+    /// Drops every dropInterval'th message sent to QGC, 0 for none. Unlike setPacketDropPercent the loss pattern is
+    /// the same on every run, which is what unit tests want.
+    void setPacketDropInterval(int dropInterval) { _packetDropInterval.store(dropInterval); }
+
     /// APM stack has strange handling of the first item of the mission list. If it has no
     /// onboard mission items, sometimes it sends back a home position in position 0 and
     /// sometimes it doesn't. Don't ask. This option allows you to configure that behavior
@@ -144,6 +159,9 @@ public:
     /// Returns the filename for the simulated log file. Onyl available after a download is requested.
     QString logDownloadFile(void) { return _logDownloadFilename; }
 
+    /// Sets the size of the simulated log file, must be called before the log list is requested
+    void setLogDownloadFileSize(uint32_t logDownloadFileSize) { _logDownloadFileSize = logDownloadFileSize; }
+
     static MockLink* startPX4MockLink            (bool sendStatusText, MockConfiguration::FailureMode_t failureMode = MockConfiguration::FailNone);
     static MockLink* startGenericMockLink        (bool sendStatusText, MockConfiguration::FailureMode_t failureMode = MockConfiguration::FailNone);
     static MockLink* startAPMArduCopterMockLink  (bool sendStatusText, MockConfiguration::FailureMode_t failureMode = MockConfiguration::FailNone);
@@ -221,6 +239,9 @@ private:
     bool _sendStatusText;
     bool _apmSendHomePositionOnEmptyList;
     MockConfiguration::FailureMode_t _failureMode;
+    QAtomicInt _packetDropPercent;
+    QAtomicInt _packetDropInterval;
+    QAtomicInt _packetDropCount;        ///< Messages counted towards _packetDropInterval
 
     int _sendHomePositionDelayCount;
     int _sendGPSPositionDelayCount;
@@ -229,8 +250,9 @@ private:
     int _currentParamRequestListParamIndex;     // Current parameter index for param request list workflow
 
     static const uint16_t _logDownloadLogId = 0;        ///< Id of siumulated log file
-    static const uint32_t _logDownloadFileSize = 1000;  ///< Size of simulated log file
+    static const uint32_t _defaultLogDownloadFileSize = 1000;   ///< Default size of simulated log file
 
+    uint32_t    _logDownloadFileSize;       ///< Size of simulated log file
     QString _logDownloadFilename;           ///< Filename for log download which is in progress
     uint32_t    _logDownloadCurrentOffset;  ///< Current offset we are sending from
     uint32_t    _logDownloadBytesRemaining; ///< Number of bytes still to send, 0 = send inactive
@@ -11,6 +11,8 @@
 #include "MockLinkFileServer.h"
 #include "MockLink.h"
 
+#include <QTimer>
+
 const MockLinkFileServer::ErrorMode_t MockLinkFileServer::rgFailureModes[] = {
     MockLinkFileServer::errModeNoResponse,
     MockLinkFileServer::errModeNakResponse,
@@ -27,13 +29,18 @@ const MockLinkFileServer::FileTestCase MockLinkFileServer::rgFileTestCases[MockL
     { "exact.qgc",      sizeof(((FileManager::Request*)0)->data),         1,    true },
     // File is larger than a single Read Ack packets, requires multiple Reads
     { "multi.qgc",      sizeof(((FileManager::Request*)0)->data) + 1,     2,    false },
+    // File spans many Read Ack packets, used for windowed transfer testing
+    { "large.qgc",      64 * 1024,  (64 * 1024 + sizeof(((FileManager::Request*)0)->data) - 1) / sizeof(((FileManager::Request*)0)->data),  false },
 };
 
 // We only support a single fixed session
 const uint8_t MockLinkFileServer::_sessionId = 1;
 
 MockLinkFileServer::MockLinkFileServer(uint8_t systemIdServer, uint8_t componentIdServer, MockLink* mockLink) :
+    _readFileLength(0),
     _errMode(errModeNone),
+    _latencyMsecs(0),
+    _packetLossPercent(0),
     _systemIdServer(systemIdServer),
     _componentIdServer(componentIdServer),
     _mockLink(mockLink)
@@ -146,6 +153,12 @@ void MockLinkFileServer::_readCommand(uint8_t senderSystemId, uint8_t senderComp
     
     uint32_t readOffset = request->hdr.offset;  // offset into file for reading
     uint8_t cDataBytes = 0;                     // current number of data bytes used
+    uint8_t cMaxDataBytes = sizeof(response.data);
+
+    if (request->hdr.size != 0 && request->hdr.size < cMaxDataBytes) {
+        // Only send the part of a chunk which was asked for
+        cMaxDataBytes = request->hdr.size;
+    }
     
     if (readOffset != 0) {
         // If we get here it means the client is requesting additional data past the first request
@@ -165,7 +178,7 @@ void MockLinkFileServer::_readCommand(uint8_t senderSystemId, uint8_t senderComp
     }
     
     // Write file bytes. Data is a repeating sequence of 0x00, 0x01, .. 0xFF.
-    for (; cDataBytes < sizeof(response.data) && readOffset < _readFileLength; readOffset++, cDataBytes++) {
+    for (; cDataBytes < cMaxDataBytes && readOffset < _readFileLength; readOffset++, cDataBytes++) {
         response.data[cDataBytes] = readOffset & 0xFF;
     }
     
@@ -233,6 +246,61 @@ void MockLinkFileServer::_streamCommand(uint8_t senderSystemId, uint8_t senderCo
     _sendNak(senderSystemId, senderComponentId, FileManager::kErrEOF, outgoingSeqNumber, FileManager::kCmdBurstReadFile);
 }
 
+/// @brief Handles Create command requests. Any path is accepted, the data written is kept in memory.
+void MockLinkFileServer::_createCommand(uint8_t senderSystemId, uint8_t senderComponentId, FileManager::Request* request, uint16_t seqNumber)
+{
+    Q_UNUSED(request);
+
+    FileManager::Request    response;
+    uint16_t                outgoingSeqNumber = _nextSeqNumber(seqNumber);
+
+    _writeFileData.clear();
+
+    response.hdr.opcode = FileManager::kRspAck;
+    response.hdr.req_opcode = FileManager::kCmdCreateFile;
+    response.hdr.session = _sessionId;
+    response.hdr.size = 0;
+
+    _sendResponse(senderSystemId, senderComponentId, &response, outgoingSeqNumber);
+}
+
+void MockLinkFileServer::_writeCommand(uint8_t senderSystemId, uint8_t senderComponentId, FileManager::Request* request, uint16_t seqNumber)
+{
+    FileManager::Request    response;
+    uint16_t                outgoingSeqNumber = _nextSeqNumber(seqNumber);
+
+    if (request->hdr.session != _sessionId) {
+        _sendNak(senderSystemId, senderComponentId, FileManager::kErrFail, outgoingSeqNumber, FileManager::kCmdWriteFile);
+        return;
+    }
+
+    if (request->hdr.offset != 0) {
+        // If we get here it means the client is sending additional data past the first request
+        if (_errMode == errModeNakSecondResponse) {
+            _sendNak(senderSystemId, senderComponentId, FileManager::kErrFail, outgoingSeqNumber, FileManager::kCmdWriteFile);
+            return;
+        } else if (_errMode == errModeNoSecondResponse) {
+            return;
+        }
+    }
+
+    // Writes may arrive in any order
+    uint32_t writeEnd = request->hdr.offset + request->hdr.size;
+    if ((uint32_t)_writeFileData.size() < writeEnd) {
+        _writeFileData.resize(writeEnd);
+    }
+    memcpy(_writeFileData.data() + request->hdr.offset, request->data, request->hdr.size);
+
+    response.hdr.session = _sessionId;
+    response.hdr.size = sizeof(uint32_t);
+    response.hdr.offset = request->hdr.offset;
+    response.hdr.opcode = FileManager::kRspAck;
+    response.hdr.req_opcode = FileManager::kCmdWriteFile;
+    response.writeFileLength = request->hdr.size;
+
+    _sendResponse(senderSystemId, senderComponentId, &response, outgoingSeqNumber);
+}
+
 void MockLinkFileServer::_terminateCommand(uint8_t senderSystemId, uint8_t senderComponentId, FileManager::Request* request, uint16_t seqNumber)
 {
     uint16_t outgoingSeqNumber = _nextSeqNumber(seqNumber);
@@ -275,6 +343,10 @@ void MockLinkFileServer::handleFTPMessage(const mavlink_message_t& message)
 
     uint16_t incomingSeqNumber = request->hdr.seqNumber;
     uint16_t outgoingSeqNumber = _nextSeqNumber(incomingSeqNumber);
+
+    if (_dropPacket(request->hdr.opcode)) {
+        return;
+    }
     
     if (request->hdr.opcode != FileManager::kCmdResetSessions && request->hdr.opcode != FileManager::kCmdTerminateSession) {
         if (_errMode == errModeNoResponse) {
@@ -316,6 +388,14 @@ void MockLinkFileServer::handleFTPMessage(const mavlink_message_t& message)
             _streamCommand(message.sysid, message.compid, request, incomingSeqNumber);
             break;
 
+        case FileManager::kCmdCreateFile:
+            _createCommand(message.sysid, message.compid, request, incomingSeqNumber);
+            break;
+
+        case FileManager::kCmdWriteFile:
+            _writeCommand(message.sysid, message.compid, request, incomingSeqNumber);
+            break;
+
         case FileManager::kCmdTerminateSession:
             _terminateCommand(message.sysid, message.compid, request, incomingSeqNumber);
             break;
@@ -363,6 +443,10 @@ void MockLinkFileServer::_sendResponse(uint8_t targetSystemId, uint8_t targetCom
 {
     mavlink_message_t   mavlinkMessage;
     
+    if (request->hdr.opcode == FileManager::kRspAck && _dropPacket(request->hdr.req_opcode)) {
+        return;
+    }
+
     request->hdr.seqNumber = seqNumber;
     
     mavlink_msg_file_transfer_protocol_pack_chan(_systemIdServer,    // System ID
@@ -374,7 +458,21 @@ void MockLinkFileServer::_sendResponse(uint8_t targetSystemId, uint8_t targetCom
                                                  targetComponentId,
                                                  (uint8_t*)request); // Payload
     
-    _mockLink->respondWithMavlinkMessage(mavlinkMessage);
+    if (_latencyMsecs > 0) {
+        MockLink* mockLink = _mockLink;
+        QTimer::singleShot(_latencyMsecs, _mockLink, [mockLink, mavlinkMessage]() { mockLink->respondWithMavlinkMessage(mavlinkMessage); });
+    } else {
+        _mockLink->respondWithMavlinkMessage(mavlinkMessage);
+    }
+}
+
+/// @brief Simulates loss of read and write requests and responses when setPacketLossPercent is set.
+bool MockLinkFileServer::_dropPacket(uint8_t opcode)
+{
+    if (_packetLossPercent <= 0 || (opcode != FileManager::kCmdReadFile && opcode != FileManager::kCmdWriteFile)) {
+        return false;
+    }
+    return (qrand() % 100) < _packetLossPercent;
 }
 
 /// @brief Generates the next sequence number given an incoming sequence number. Handles generating
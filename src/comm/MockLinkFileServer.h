@@ -44,6 +44,15 @@ public:
     
     /// @brief Sets the error mode for command responses. This allows you to simulate various server errors.
     void setErrorMode(ErrorMode_t errMode) { _errMode = errMode; };
+
+    /// @brief Delays all responses by the specified amount, to simulate a link with a long round trip.
+    void setLatencyMsecs(int latencyMsecs) { _latencyMsecs = latencyMsecs; }
+
+    /// @brief Drops the specified percentage of read and write requests and responses.
+    void setPacketLossPercent(int packetLossPercent) { _packetLossPercent = packetLossPercent; }
+
+    /// @brief Data received through the Create and Write commands
+    const QByteArray& writtenFileData(void) const { return _writeFileData; }
     
     /// @brief Array of failure modes you can cycle through for testing. By looping through this array you can avoid
     /// hardcoding the specific error modes in your unit test. This way when new error modes are added your unit test
@@ -59,13 +68,13 @@ public:
     /// @brief Used to represent a single test case for download testing.
     struct FileTestCase {
         const char* filename;               ///< Filename to download
-        uint8_t     length;                 ///< Length of file in bytes
+        uint32_t    length;                 ///< Length of file in bytes
 		int			packetCount;			///< Number of packets required for data
         bool        exactFit;				///< true: last packet is exact fit, false: last packet is partially filled
     };
     
     /// @brief The numbers of test cases in the rgFileTestCases array.
-    static const size_t cFileTestCases = 3;
+    static const size_t cFileTestCases = 4;
     
     /// @brief The set of files supported by the mock server for testing purposes. Each one represents a different edge case for testing.
     static const FileTestCase rgFileTestCases[cFileTestCases];
@@ -85,6 +94,9 @@ private:
     void _openCommand(uint8_t senderSystemId, uint8_t senderComponentId, FileManager::Request* request, uint16_t seqNumber);
     void _readCommand(uint8_t senderSystemId, uint8_t senderComponentId, FileManager::Request* request, uint16_t seqNumber);
 	void _streamCommand(uint8_t senderSystemId, uint8_t senderComponentId, FileManager::Request* request, uint16_t seqNumber);
+    void _createCommand(uint8_t senderSystemId, uint8_t senderComponentId, FileManager::Request* request, uint16_t seqNumber);
+    void _writeCommand(uint8_t senderSystemId, uint8_t senderComponentId, FileManager::Request* request, uint16_t seqNumber);
+    bool _dropPacket(uint8_t opcode);
     void _terminateCommand(uint8_t senderSystemId, uint8_t senderComponentId, FileManager::Request* request, uint16_t seqNumber);
     void _resetCommand(uint8_t senderSystemId, uint8_t senderComponentId, uint16_t seqNumber);
     uint16_t _nextSeqNumber(uint16_t seqNumber);
@@ -92,8 +104,11 @@ private:
     QStringList _fileList;  ///< List of files returned by List command
     
     static const uint8_t    _sessionId;
-    uint8_t                 _readFileLength;    ///< Length of active file being read
+    uint32_t                _readFileLength;    ///< Length of active file being read
+    QByteArray              _writeFileData;     ///< Data of file being written
     ErrorMode_t             _errMode;           ///< Currently set error mode, as specified by setErrorMode
+    int                     _latencyMsecs;      ///< Response delay, as specified by setLatencyMsecs
+    int                     _packetLossPercent; ///< Read/Write loss, as specified by setPacketLossPercent
     const uint8_t           _systemIdServer;    ///< System ID for server
     const uint8_t           _componentIdServer; ///< Component ID for server
     MockLink*               _mockLink;          ///< MockLink to communicate through
@@ -0,0 +1,200 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "RingBufferedFileWriter.h"
+#include "QGCLoggingCategory.h"
+
+#include <QElapsedTimer>
+
+#include <string.h>
+#include <errno.h>
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+QGC_LOGGING_CATEGORY(RingBufferedFileWriterLog, "RingBufferedFileWriterLog")
+
+RingBufferedFileWriter::RingBufferedFileWriter(int ringBufferSize, QObject* parent)
+    : QThread(parent)
+    , _file(NULL)
+    , _ringSize(ringBufferSize)
+    , _ringMask(ringBufferSize - 1)
+    , _head(0)
+    , _tail(0)
+    , _stopRequested(0)
+    , _failed(0)
+{
+    Q_ASSERT((ringBufferSize & (ringBufferSize - 1)) == 0);
+}
+
+RingBufferedFileWriter::~RingBufferedFileWriter()
+{
+    // Derived classes must stop the thread themselves, _writeQueued is gone by now
+    Q_ASSERT(!isRunning());
+}
+
+void RingBufferedFileWriter::_startWriter(QFile* file)
+{
+    if (_ring.isEmpty()) {
+        _ring.resize(_ringSize);
+    }
+
+    _file = file;
+    _head.store(0);
+    _tail.store(0);
+    _stopRequested.store(0);
+    _failed.store(0);
+
+    start(LowPriority);
+}
+
+void RingBufferedFileWriter::_stopWriter(void)
+{
+    _stopRequested.store(1);
+    _wakeMutex.lock();
+    _wakeCondition.wakeOne();
+    _wakeMutex.unlock();
+    wait();
+}
+
+bool RingBufferedFileWriter::_queue(const uint8_t* const* rgParts, const quint32* rgLengths, int partCount)
+{
+    quint32 recordLength = 0;
+    for (int i=0; i<partCount; i++) {
+        recordLength += rgLengths[i];
+    }
+
+    quint32 head = _head.load();
+    quint32 used = head - _tail.loadAcquire();
+
+    if (_ringSize - used < recordLength) {
+        return false;
+    }
+
+    // Copy the record into the ring, wrapping around the end if needed
+    char* ring = _ring.data();
+    quint32 position = head;
+    for (int i=0; i<partCount; i++) {
+        quint32 index = position & _ringMask;
+        quint32 firstPart = qMin(rgLengths[i], _ringSize - index);
+        memcpy(ring + index, rgParts[i], firstPart);
+        memcpy(ring, rgParts[i] + firstPart, rgLengths[i] - firstPart);
+        position += rgLengths[i];
+    }
+
+    _head.storeRelease(head + recordLength);
+
+    if (used + recordLength > _ringSize / 2) {
+        // Writer is getting behind, don't wait for the batch interval. We don't take the mutex here to stay lock free,
+        // if the wakeup is missed the writer still wakes up at the next batch interval.
+        _wakeCondition.wakeOne();
+    }
+
+    return true;
+}
+
+void RingBufferedFileWriter::run(void)
+{
+    QElapsedTimer syncTimer;
+    syncTimer.start();
+
+    while (true) {
+        bool stopRequested = _stopRequested.load();
+
+        quint32 tail = _tail.load();
+        quint32 count = _head.loadAcquire() - tail;
+
+        if (!_writeQueued(tail, count)) {
+            return;
+        }
+        _tail.storeRelease(tail + count);
+
+        if (stopRequested) {
+            break;
+        }
+
+        if (syncTimer.elapsed() > _syncIntervalMSecs) {
+            if (!_syncFile()) {
+                return;
+            }
+            syncTimer.restart();
+        }
+
+        _wakeMutex.lock();
+        if (!_stopRequested.load()) {
+            _wakeCondition.wait(&_wakeMutex, _batchIntervalMSecs);
+        }
+        _wakeMutex.unlock();
+    }
+
+    _syncFile();
+}
+
+const uint8_t* RingBufferedFileWriter::_ringData(quint32 position, quint32 length, uint8_t* scratch) const
+{
+    const uint8_t*  ring = (const uint8_t*)_ring.constData();
+    quint32         index = position & _ringMask;
+    quint32         firstPart = qMin(length, _ringSize - index);
+
+    if (firstPart == length) {
+        return ring + index;
+    }
+
+    memcpy(scratch, ring + index, firstPart);
+    memcpy(scratch + firstPart, ring, length - firstPart);
+    return scratch;
+}
+
+/// Writes the bytes in at most two write calls
+bool RingBufferedFileWriter::_writeRing(quint32 position, quint32 length)
+{
+    const char* ring = _ring.constData();
+    quint32     index = position & _ringMask;
+    quint32     firstPart = qMin(length, _ringSize - index);
+
+    return _writeFile(ring + index, firstPart) && (length == firstPart || _writeFile(ring, length - firstPart));
+}
+
+bool RingBufferedFileWriter::_writeFile(const char* data, qint64 length)
+{
+    if (_file->write(data, length) != length) {
+        _fail(_file->errorString());
+        return false;
+    }
+
+    return true;
+}
+
+void RingBufferedFileWriter::_fail(const QString& errorString)
+{
+    qCWarning(RingBufferedFileWriterLog) << "Writing" << _file->fileName() << "failed" << errorString;
+    _failed.store(1);
+    emit writeFailed(errorString);
+}
+
+/// Flushes Qt buffers and forces the data out to disk, calls _fail on error
+bool RingBufferedFileWriter::_syncFile(void)
+{
+    if (!_file->flush()) {
+        _fail(_file->errorString());
+        return false;
+    }
+#ifdef Q_OS_WIN
+    if (_commit(_file->handle()) != 0) {
+#else
+    if (fsync(_file->handle()) != 0) {
+#endif
+        _fail(qt_error_string(errno));
+        return false;
+    }
+
+    return true;
+}
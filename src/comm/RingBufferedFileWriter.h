@@ -0,0 +1,105 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#ifndef RingBufferedFileWriter_H
+#define RingBufferedFileWriter_H
+
+#include <QThread>
+#include <QFile>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInteger>
+#include <QByteArray>
+#include <QLoggingCategory>
+
+#include <stdint.h>
+
+Q_DECLARE_LOGGING_CATEGORY(RingBufferedFileWriterLog)
+
+/// Base class for log writers which write a file on their own thread, so a slow disk never stalls the thread producing
+/// the data. Used by MAVLinkLogWriter and ULogStreamWriter.
+///
+/// The producer thread copies records into a single producer/single consumer byte ring through _queue, without taking
+/// any locks. The writer thread hands everything queued to _writeQueued at least every _batchIntervalMSecs, sooner if
+/// the ring is more than half full, and syncs the file to disk every _syncIntervalMSecs. If the ring is full _queue
+/// fails, it is up to the derived class to count the drop. A failed write or sync stops the writer thread and is
+/// reported through writeFailed.
+class RingBufferedFileWriter : public QThread
+{
+    Q_OBJECT
+
+public:
+    ~RingBufferedFileWriter();
+
+    /// @return true: writing failed, the writer thread has stopped
+    bool failed(void) const { return _failed.load() != 0; }
+
+signals:
+    /// Writing or syncing the file to disk failed, the writer thread has stopped
+    void writeFailed(QString errorString);
+
+protected:
+    /// @param ringBufferSize Size of the byte ring, must be a power of 2
+    RingBufferedFileWriter(int ringBufferSize, QObject* parent = NULL);
+
+    /// Starts the writer thread on an empty ring. The file must already be open for writing.
+    void _startWriter(QFile* file);
+
+    /// Hands everything which is queued to _writeQueued, syncs the file and stops the writer thread
+    void _stopWriter(void);
+
+    /// Copies a record made up of several parts into the ring. Must only be called from a single thread.
+    /// @return false: not enough room in the ring, nothing queued
+    bool _queue(const uint8_t* const* rgParts, const quint32* rgLengths, int partCount);
+
+    /// Called on the writer thread with the bytes queued since the last call, possibly none. The bytes are freed up for
+    /// the producer once this returns, or earlier through _releaseRing.
+    ///     @param tail Ring position of the first byte
+    ///     @param count Number of bytes
+    /// @return false: writing failed, _fail has been called
+    virtual bool _writeQueued(quint32 tail, quint32 count) = 0;
+
+    /// Frees up the ring up to position for the producer, for _writeQueued implementations which take a while
+    void _releaseRing(quint32 position) { _tail.storeRelease(position); }
+
+    /// @return Pointer to length bytes at the ring position, copied to scratch if they wrap around the end of the ring
+    const uint8_t* _ringData(quint32 position, quint32 length, uint8_t* scratch) const;
+
+    /// Writes length bytes starting at the ring position to the file, calls _fail on error
+    bool _writeRing(quint32 position, quint32 length);
+
+    /// Writes to the file, calls _fail on error
+    bool _writeFile(const char* data, qint64 length);
+
+    /// Stops writing for good, the file on disk can't be trusted from here on
+    void _fail(const QString& errorString);
+
+    QFile* _file;
+
+private:
+    // Override from QThread
+    void run(void);
+
+    bool _syncFile(void);
+
+    QByteArray              _ring;
+    quint32                 _ringSize;
+    quint32                 _ringMask;
+    QAtomicInteger<quint32> _head;              ///< Only written by the producer
+    QAtomicInteger<quint32> _tail;              ///< Only written by the writer thread
+    QAtomicInt              _stopRequested;
+    QAtomicInt              _failed;
+    QMutex                  _wakeMutex;
+    QWaitCondition          _wakeCondition;
+
+    static const int _batchIntervalMSecs =  250;    ///< Maximum time data sits in the ring before being written
+    static const int _syncIntervalMSecs =   2000;   ///< How often the file is synced to disk
+};
+
+#endif
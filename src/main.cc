@@ -175,18 +175,20 @@ int main(int argc, char *argv[])
     // which need to be handled before a QApplication object is started.
 
     bool stressUnitTests = false;       // Stress test unit tests
+    bool benchmarkUnitTests = false;    // Run the benchmarks instead of the unit tests
     bool quietWindowsAsserts = false;   // Don't let asserts pop dialog boxes
 
     QString unitTestOptions;
     CmdLineOpt_t rgCmdLineOptions[] = {
         { "--unittest",             &runUnitTests,          &unitTestOptions },
         { "--unittest-stress",      &stressUnitTests,       &unitTestOptions },
+        { "--unittest-benchmark",   &benchmarkUnitTests,    &unitTestOptions },
         { "--no-windows-assert-ui", &quietWindowsAsserts,   NULL },
         // Add additional command line option flags here
     };
 
     ParseCmdLineOptions(argc, argv, rgCmdLineOptions, sizeof(rgCmdLineOptions)/sizeof(rgCmdLineOptions[0]), false);
-    if (stressUnitTests) {
+    if (stressUnitTests || benchmarkUnitTests) {
         runUnitTests = true;
     }
 
@@ -234,7 +236,7 @@ int main(int argc, char *argv[])
             }
 
             // Run the test
-            int failures = UnitTest::run(unitTestOptions);
+            int failures = UnitTest::run(unitTestOptions, benchmarkUnitTests);
             if (failures == 0) {
                 qDebug() << "ALL TESTS PASSED";
                 exitCode = 0;
@@ -0,0 +1,309 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "FileTransferWindowTest.h"
+#include "FileTransferWindow.h"
+#include "FileManager.h"
+#include "MockLink.h"
+#include "MultiVehicleManager.h"
+#include "UAS.h"
+#include "QGCApplication.h"
+
+#include <QElapsedTimer>
+#include <QSignalSpy>
+
+FileTransferWindowTest::FileTransferWindowTest(void)
+    : _fileManager(NULL)
+    , _fileServer(NULL)
+{
+
+}
+
+/// Chunks are requested up to the window size, each response frees a slot for the next chunk
+void FileTransferWindowTest::_window_test(void)
+{
+    FileTransferWindow transferWindow;
+    uint32_t offset, size;
+
+    transferWindow.start(1000, 100, 4, 0);
+    for (int i=0; i<4; i++) {
+        QVERIFY(transferWindow.takeRequestToSend(0, offset, size));
+        QCOMPARE(offset, (uint32_t)(i * 100));
+        QCOMPARE(size, (uint32_t)100);
+    }
+    QVERIFY(!transferWindow.takeRequestToSend(0, offset, size));
+    QCOMPARE(transferWindow.outstandingCount(), 4);
+    QCOMPARE(transferWindow.msecsToNextTimeout(0), (int)FileTransferWindow::initialRtoMsecs);
+
+    // Responses out of order, duplicates ignored
+    size = 100;
+    QVERIFY(transferWindow.received(200, size, 40));
+    size = 100;
+    QVERIFY(!transferWindow.received(200, size, 40));
+    size = 100;
+    QVERIFY(transferWindow.received(0, size, 40));
+    QCOMPARE(transferWindow.rttMsecs(), 40);
+    QCOMPARE(transferWindow.bytesTransferred(), (uint32_t)200);
+
+    // Answer everything until the file is complete
+    qint64 nowMsecs = 40;
+    int requestCount = 4;
+    while (!transferWindow.complete()) {
+        while (transferWindow.takeRequestToSend(nowMsecs, offset, size)) {
+            requestCount++;
+        }
+        QVERIFY(transferWindow.outstandingCount() <= 4);
+        nowMsecs += 40;
+        QList<uint32_t> offsets;
+        for (uint32_t chunk=0; chunk<1000; chunk+=100) {
+            offsets.append(chunk);
+        }
+        foreach (uint32_t chunk, offsets) {
+            uint32_t chunkSize = 100;
+            transferWindow.received(chunk, chunkSize, nowMsecs);
+        }
+    }
+    QCOMPARE(requestCount, 10);
+    QCOMPARE(transferWindow.bytesTransferred(), (uint32_t)1000);
+    QCOMPARE(transferWindow.retransmitCount(), 0);
+    QCOMPARE(transferWindow.rtoMsecs(), (int)FileTransferWindow::minRtoMsecs);
+    QCOMPARE(transferWindow.msecsToNextTimeout(nowMsecs), -1);
+    QCOMPARE(transferWindow.bytesPerSecond(nowMsecs), 1000.0 * 1000.0 / nowMsecs);
+}
+
+/// Only the part of a chunk a short response left out is requested again
+void FileTransferWindowTest::_shortResponse_test(void)
+{
+    FileTransferWindow transferWindow;
+    uint32_t offset, size;
+
+    transferWindow.start(300, 100, 8, 0);
+    while (transferWindow.takeRequestToSend(0, offset, size)) {
+    }
+    QCOMPARE(transferWindow.outstandingCount(), 3);
+
+    // Short response, the rest goes out ahead of anything else
+    size = 60;
+    QVERIFY(transferWindow.received(100, size, 10));
+    QCOMPARE(size, (uint32_t)60);
+    QCOMPARE(transferWindow.missingCount(), 1);
+    QVERIFY(transferWindow.takeRequestToSend(10, offset, size));
+    QCOMPARE(offset, (uint32_t)160);
+    QCOMPARE(size, (uint32_t)40);
+
+    // A response with more data than requested only counts what was requested
+    size = 100;
+    QVERIFY(transferWindow.received(160, size, 20));
+    QCOMPARE(size, (uint32_t)40);
+
+    size = 100;
+    QVERIFY(transferWindow.received(0, size, 20));
+    size = 100;
+    QVERIFY(transferWindow.received(200, size, 20));
+    QVERIFY(transferWindow.complete());
+    QCOMPARE(transferWindow.bytesTransferred(), (uint32_t)300);
+}
+
+/// Timed out requests are sent again first, in file order, with the timeout backed off once per round
+void FileTransferWindowTest::_timeout_test(void)
+{
+    FileTransferWindow transferWindow;
+    uint32_t offset, size;
+
+    transferWindow.start(500, 100, 8, 0);
+    while (transferWindow.takeRequestToSend(0, offset, size)) {
+    }
+    QCOMPARE(transferWindow.outstandingCount(), 5);
+
+    size = 100;
+    QVERIFY(transferWindow.received(100, size, 50));
+    size = 100;
+    QVERIFY(transferWindow.received(300, size, 50));
+    QVERIFY(transferWindow.takeTimedOut(60).isEmpty());
+
+    int rtoMsecs = transferWindow.rtoMsecs();
+    QList<uint32_t> timedOut = transferWindow.takeTimedOut(rtoMsecs);
+    QCOMPARE(timedOut, QList<uint32_t>() << 0 << 200 << 400);
+    QCOMPARE(transferWindow.rtoMsecs(), rtoMsecs * 2);
+    QCOMPARE(transferWindow.retransmitCount(), 3);
+    QCOMPARE(transferWindow.maxRetries(), 1);
+    QCOMPARE(transferWindow.outstandingCount(), 0);
+
+    qint64 nowMsecs = rtoMsecs;
+    QList<uint32_t> resent;
+    while (transferWindow.takeRequestToSend(nowMsecs, offset, size)) {
+        resent.append(offset);
+    }
+    QCOMPARE(resent, timedOut);
+
+    // Round trip of retried requests is not measured
+    int rttMsecs = transferWindow.rttMsecs();
+    foreach (uint32_t chunk, resent) {
+        size = 100;
+        QVERIFY(transferWindow.received(chunk, size, nowMsecs + 500));
+    }
+    QCOMPARE(transferWindow.rttMsecs(), rttMsecs);
+    QCOMPARE(transferWindow.maxRetries(), 0);
+    QVERIFY(transferWindow.complete());
+}
+
+/// Without a file size the transfer goes one chunk at a time until the end of the file
+void FileTransferWindowTest::_unknownSize_test(void)
+{
+    FileTransferWindow transferWindow;
+    uint32_t offset, size;
+
+    transferWindow.start(0, 100, 8, 0);
+    QCOMPARE(transferWindow.windowSize(), 1);
+
+    QVERIFY(transferWindow.takeRequestToSend(0, offset, size));
+    QCOMPARE(offset, (uint32_t)0);
+    QVERIFY(!transferWindow.takeRequestToSend(0, offset, size));
+    size = 70;
+    QVERIFY(transferWindow.received(0, size, 10));
+    QVERIFY(transferWindow.takeRequestToSend(10, offset, size));
+    QCOMPARE(offset, (uint32_t)70);
+    QCOMPARE(size, (uint32_t)100);
+    QVERIFY(!transferWindow.complete());
+}
+
+void FileTransferWindowTest::_connectFileServer(void)
+{
+    _connectMockLink();
+    _fileServer = _mockLink->getFileServer();
+    _fileManager = qgcApp()->toolbox()->multiVehicleManager()->activeVehicle()->uas()->getFileManager();
+}
+
+bool FileTransferWindowTest::_waitForCommand(void)
+{
+    QSignalSpy completeSpy(_fileManager, SIGNAL(commandComplete()));
+    QSignalSpy errorSpy(_fileManager, SIGNAL(commandError(const QString&)));
+
+    QElapsedTimer timer;
+    timer.start();
+    while (completeSpy.count() == 0 && errorSpy.count() == 0 && timer.elapsed() < _transferTimeoutMsecs) {
+        QTest::qWait(50);
+    }
+    if (errorSpy.count()) {
+        qWarning() << "Transfer failed" << errorSpy[0][0].toString();
+    }
+
+    return completeSpy.count() == 1 && errorSpy.count() == 0;
+}
+
+/// Downloads large.qgc through the FileManager and checks its contents
+///     @param elapsedMsecs Returned time the transfer took
+bool FileTransferWindowTest::_download(int windowSize, int& elapsedMsecs)
+{
+    QString downloadFilePath = _tempDir.path() + "/large.qgc";
+    QFile::remove(downloadFilePath);
+
+    _fileManager->setWindowSize(windowSize);
+
+    QElapsedTimer timer;
+    timer.start();
+    _fileManager->downloadPath("large.qgc", QDir(_tempDir.path()));
+    bool success = _waitForCommand();
+    elapsedMsecs = (int)timer.elapsed();
+    if (!success) {
+        return false;
+    }
+
+    QFile downloadFile(downloadFilePath);
+    if (!downloadFile.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QByteArray bytes = downloadFile.readAll();
+
+    // Mock file data is a repeating sequence of 0x00, 0x01, .. 0xFF
+    if ((uint32_t)bytes.size() != MockLinkFileServer::rgFileTestCases[3].length) {
+        return false;
+    }
+    for (int i=0; i<bytes.size(); i++) {
+        if ((uint8_t)bytes[i] != (i & 0xFF)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// A windowed download over a link with latency is much faster than one chunk at a time
+void FileTransferWindowTest::_download_test(void)
+{
+    _connectFileServer();
+    QVERIFY(_tempDir.isValid());
+
+    _fileServer->setLatencyMsecs(_latencyMsecs);
+
+    int singleMsecs, windowedMsecs;
+    QVERIFY(_download(1, singleMsecs));
+    QVERIFY(_download(FileTransferWindow::defaultWindowSize, windowedMsecs));
+    QCOMPARE(_fileManager->transferWindow().retransmitCount(), 0);
+    QVERIFY(windowedMsecs * 3 < singleMsecs);
+    QVERIFY(_fileManager->transferWindow().rttMsecs() >= _latencyMsecs);
+}
+
+/// Lost requests and responses are retransmitted without failing the download
+void FileTransferWindowTest::_downloadLoss_test(void)
+{
+    _connectFileServer();
+    QVERIFY(_tempDir.isValid());
+
+    _fileServer->setLatencyMsecs(_latencyMsecs);
+    _fileServer->setPacketLossPercent(5);
+
+    int elapsedMsecs;
+    QVERIFY(_download(FileTransferWindow::defaultWindowSize, elapsedMsecs));
+    QVERIFY(_fileManager->transferWindow().retransmitCount() > 0);
+}
+
+/// A Nak in the middle of a windowed download fails it without leaving a partial file behind
+void FileTransferWindowTest::_downloadNak_test(void)
+{
+    _connectFileServer();
+    QVERIFY(_tempDir.isValid());
+
+    QString downloadFilePath = _tempDir.path() + "/large.qgc";
+    QFile::remove(downloadFilePath);
+
+    _fileServer->setLatencyMsecs(_latencyMsecs);
+    _fileServer->setErrorMode(MockLinkFileServer::errModeNakSecondResponse);
+
+    _fileManager->setWindowSize(FileTransferWindow::defaultWindowSize);
+    _fileManager->downloadPath("large.qgc", QDir(_tempDir.path()));
+    QVERIFY(!_waitForCommand());
+    QVERIFY(!QFile::exists(downloadFilePath));
+}
+
+/// Windowed upload over a lossy link arrives intact
+void FileTransferWindowTest::_upload_test(void)
+{
+    _connectFileServer();
+    QVERIFY(_tempDir.isValid());
+
+    QByteArray bytes;
+    for (int i=0; i<32 * 1024; i++) {
+        bytes.append((char)(qrand() & 0xFF));
+    }
+    QString uploadFilePath = _tempDir.path() + "/upload.bin";
+    QFile uploadFile(uploadFilePath);
+    QVERIFY(uploadFile.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    QCOMPARE(uploadFile.write(bytes), (qint64)bytes.size());
+    uploadFile.close();
+
+    _fileServer->setLatencyMsecs(_latencyMsecs);
+    _fileServer->setPacketLossPercent(5);
+
+    _fileManager->setWindowSize(FileTransferWindow::defaultWindowSize);
+    _fileManager->uploadPath("/fs/microsd", QFileInfo(uploadFilePath));
+    QVERIFY(_waitForCommand());
+    QCOMPARE(_fileServer->writtenFileData(), bytes);
+    QCOMPARE(_fileManager->transferWindow().bytesTransferred(), (uint32_t)bytes.size());
+}
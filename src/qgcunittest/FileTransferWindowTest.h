@@ -0,0 +1,52 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#ifndef FileTransferWindowTest_H
+#define FileTransferWindowTest_H
+
+#include "UnitTest.h"
+
+#include <QTemporaryDir>
+
+class FileManager;
+class MockLinkFileServer;
+
+/// Unit test for windowed MAVLink FTP transfers. The window itself is driven with simulated time, the transfers run
+/// against MockLinkFileServer with added latency and loss.
+class FileTransferWindowTest : public UnitTest
+{
+    Q_OBJECT
+
+public:
+    FileTransferWindowTest(void);
+
+private slots:
+    void _window_test(void);
+    void _shortResponse_test(void);
+    void _timeout_test(void);
+    void _unknownSize_test(void);
+    void _download_test(void);
+    void _downloadLoss_test(void);
+    void _downloadNak_test(void);
+    void _upload_test(void);
+
+private:
+    void _connectFileServer(void);
+    bool _download(int windowSize, int& elapsedMsecs);
+    bool _waitForCommand(void);
+
+    FileManager*        _fileManager;
+    MockLinkFileServer* _fileServer;
+    QTemporaryDir       _tempDir;
+
+    static const int _latencyMsecs = 20;
+    static const int _transferTimeoutMsecs = 60000;
+};
+
+#endif
@@ -0,0 +1,151 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "LogReplayLinkTest.h"
+#include "LogReplayLink.h"
+#include "LinkManager.h"
+#include "QGCApplication.h"
+
+#include <QDir>
+#include <QSignalSpy>
+#include <QtEndian>
+
+LogReplayLinkTest::LogReplayLinkTest(void)
+    : _playbackAtEnd(false)
+    , _playbackPaused(false)
+{
+
+}
+
+/// Writes a log of attitude messages, one every _recordIntervalUsecs. Heartbeats are left out so replay does not
+/// create a vehicle.
+/// @return Log filename
+QString LogReplayLinkTest::_writeLog(const QString& name, int recordCount)
+{
+    QByteArray          log;
+    mavlink_message_t   message;
+    uint8_t             buffer[MAVLINK_MAX_PACKET_LEN];
+    uchar               timestamp[sizeof(quint64)];
+
+    _logFrames.clear();
+    for (int i=0; i<recordCount; i++) {
+        mavlink_msg_attitude_pack_chan(1, MAV_COMP_ID_AUTOPILOT1, _packChannel, &message, i, 0.01f * i, 0.2f, 0.3f, 0.0f, 0.0f, 0.0f);
+        int length = mavlink_msg_to_send_buffer(buffer, &message);
+
+        qToBigEndian(_baseTimestampUsecs + i * _recordIntervalUsecs, timestamp);
+        log.append((const char*)timestamp, sizeof(timestamp));
+        log.append((const char*)buffer, length);
+        _logFrames.append(QByteArray((const char*)buffer, length));
+    }
+
+    QFile file(QDir(_tempDir.path()).filePath(name));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(log) != log.size()) {
+        return QString();
+    }
+
+    return file.fileName();
+}
+
+LogReplayLink* LogReplayLinkTest::_startReplay(const QString& logFilename)
+{
+    LinkManager* linkManager = qgcApp()->toolbox()->linkManager();
+
+    _receivedFrames.clear();
+    _playbackAtEnd = false;
+    _playbackPaused = false;
+
+    LogReplayLinkConfiguration* linkConfig = new LogReplayLinkConfiguration(QStringLiteral("Log Replay Test"));
+    linkConfig->setLogFilename(logFilename);
+    SharedLinkConfigurationPointer sharedConfig = linkManager->addConfiguration(linkConfig);
+    LogReplayLink* replayLink = qobject_cast<LogReplayLink*>(linkManager->createConnectedLink(sharedConfig));
+    if (!replayLink) {
+        return NULL;
+    }
+
+    // Queued to this thread behind the link's bytesReceived signals, so the frames are all in once the flags are set.
+    // The bytes point into the log mapping, which may be gone by the time the frames are checked.
+    connect(replayLink, &LinkInterface::bytesReceived, this, [this](LinkInterface*, QByteArray bytes) { _receivedFrames.append(QByteArray(bytes.constData(), bytes.size())); });
+    connect(replayLink, &LogReplayLink::playbackAtEnd, this, [this]() { _playbackAtEnd = true; });
+    connect(replayLink, &LogReplayLink::playbackPaused, this, [this]() { _playbackPaused = true; });
+
+    return replayLink;
+}
+
+/// Deletes the link, which also unmaps the log
+void LogReplayLinkTest::_stopReplay(LogReplayLink* replayLink)
+{
+    LinkManager*        linkManager = qgcApp()->toolbox()->linkManager();
+    LinkConfiguration*  linkConfig = replayLink->getLinkConfiguration();
+    QSignalSpy          spyLinkDeleted(linkManager, &LinkManager::linkDeleted);
+
+    linkManager->disconnectLink(replayLink);
+    QCOMPARE(spyLinkDeleted.count(), 1);
+    linkManager->removeConfiguration(linkConfig);
+}
+
+/// Max speed plays the whole log, every message in order, without waiting on the timestamps
+void LogReplayLinkTest::_maxSpeed_test(void)
+{
+    QVERIFY(_tempDir.isValid());
+
+    // More than one batch worth of messages, paced playback would take almost an hour
+    const int   recordCount = 3000;
+    QString     logFilename = _writeLog("maxspeed.mavlink", recordCount);
+    QVERIFY(!logFilename.isEmpty());
+
+    LogReplayLink* replayLink = _startReplay(logFilename);
+    QVERIFY(replayLink);
+    replayLink->setMaxSpeed(true);
+
+    QTRY_VERIFY_WITH_TIMEOUT(_playbackAtEnd, 10000);
+
+    // The received messages must not depend on the log mapping, which goes away with the link
+    _stopReplay(replayLink);
+
+    QCOMPARE(_receivedFrames.count(), recordCount);
+    for (int i=0; i<recordCount; i++) {
+        QVERIFY(_receivedFrames[i] == _logFrames[i]);
+    }
+}
+
+/// Moving the playhead goes through the time index to the first message at or after the requested time
+void LogReplayLinkTest::_seek_test(void)
+{
+    QVERIFY(_tempDir.isValid());
+
+    const int   recordCount = 101;
+    QString     logFilename = _writeLog("seek.mavlink", recordCount);
+    QVERIFY(!logFilename.isEmpty());
+
+    LogReplayLink* replayLink = _startReplay(logFilename);
+    QVERIFY(replayLink);
+
+    // Playback starts as soon as the link connects, it has to be paused before the playhead can move
+    replayLink->pause();
+    QTRY_VERIFY_WITH_TIMEOUT(_playbackPaused, 5000);
+    QVERIFY(!replayLink->isPlaying());
+    _receivedFrames.clear();
+
+    // Log is 100 seconds long, so half way is the message at 50 seconds
+    QSignalSpy spyPercent(replayLink, &LogReplayLink::playbackPercentCompleteChanged);
+    replayLink->movePlayhead(50);
+    QCOMPARE(spyPercent.count(), 1);
+    QCOMPARE(spyPercent[0][0].toInt(), 50);
+
+    replayLink->setMaxSpeed(true);
+    replayLink->play();
+    QTRY_VERIFY_WITH_TIMEOUT(_playbackAtEnd, 10000);
+
+    _stopReplay(replayLink);
+
+    QCOMPARE(_receivedFrames.count(), recordCount - 50);
+    for (int i=0; i<_receivedFrames.count(); i++) {
+        QVERIFY(_receivedFrames[i] == _logFrames[i + 50]);
+    }
+}
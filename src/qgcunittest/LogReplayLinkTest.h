@@ -0,0 +1,48 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#ifndef LogReplayLinkTest_H
+#define LogReplayLinkTest_H
+
+#include "UnitTest.h"
+#include "QGCMAVLink.h"
+
+#include <QTemporaryDir>
+
+class LogReplayLink;
+
+/// Unit test for LogReplayLink playback of mapped .mavlink logs: max speed playback and seeking
+class LogReplayLinkTest : public UnitTest
+{
+    Q_OBJECT
+
+public:
+    LogReplayLinkTest(void);
+
+private slots:
+    void _maxSpeed_test(void);
+    void _seek_test(void);
+
+private:
+    QString         _writeLog   (const QString& name, int recordCount);
+    LogReplayLink*  _startReplay(const QString& logFilename);
+    void            _stopReplay (LogReplayLink* replayLink);
+
+    QTemporaryDir       _tempDir;
+    QList<QByteArray>   _logFrames;         ///< Frames written to the log by _writeLog
+    QList<QByteArray>   _receivedFrames;    ///< Frames received from the replay link
+    bool                _playbackAtEnd;
+    bool                _playbackPaused;
+
+    static const int        _packChannel = MAVLINK_COMM_NUM_BUFFERS - 1;
+    static const quint64    _baseTimestampUsecs = 1500000000000000ULL;
+    static const quint64    _recordIntervalUsecs = 1000000;     ///< Paced playback of a test log takes minutes
+};
+
+#endif
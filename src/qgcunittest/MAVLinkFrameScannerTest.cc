@@ -0,0 +1,214 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "MAVLinkFrameScannerTest.h"
+#include "MAVLinkFrameScanner.h"
+
+#include <QFile>
+#include <QtEndian>
+
+MAVLinkFrameScannerTest::MAVLinkFrameScannerTest(void)
+{
+
+}
+
+void MAVLinkFrameScannerTest::_resetChannel(int channel)
+{
+    memset(mavlink_get_channel_status(channel), 0, sizeof(mavlink_status_t));
+}
+
+/// Builds a raw telemetry stream of mixed message types
+QByteArray MAVLinkFrameScannerTest::_buildStream(int messageCount, bool mixVersions)
+{
+    QByteArray          stream;
+    mavlink_message_t   message;
+    uint8_t             buffer[MAVLINK_MAX_PACKET_LEN];
+
+    _resetChannel(_packChannel);
+
+    for (int i=0; i<messageCount; i++) {
+        mavlink_status_t* packStatus = mavlink_get_channel_status(_packChannel);
+        if (mixVersions && (i % 7) == 0) {
+            packStatus->flags |= MAVLINK_STATUS_FLAG_OUT_MAVLINK1;
+        } else {
+            packStatus->flags &= ~MAVLINK_STATUS_FLAG_OUT_MAVLINK1;
+        }
+
+        switch (i % 4) {
+        case 0:
+            mavlink_msg_heartbeat_pack_chan(1, MAV_COMP_ID_AUTOPILOT1, _packChannel, &message, MAV_TYPE_QUADROTOR, MAV_AUTOPILOT_PX4, 0, 0, MAV_STATE_ACTIVE);
+            break;
+        case 1:
+            mavlink_msg_attitude_pack_chan(1, MAV_COMP_ID_AUTOPILOT1, _packChannel, &message, i, 0.1f * i, 0.2f, 0.3f, 0.0f, 0.0f, 0.0f);
+            break;
+        case 2:
+            mavlink_msg_param_value_pack_chan(1, MAV_COMP_ID_AUTOPILOT1, _packChannel, &message, "TEST_PARAM", i, MAV_PARAM_TYPE_REAL32, 1000, i % 1000);
+            break;
+        case 3:
+            mavlink_msg_gps_raw_int_pack_chan(2, MAV_COMP_ID_AUTOPILOT1, _packChannel, &message, i, 3, 473977420, 85455940, 488000, 100, 100, 500, 0, 10);
+            break;
+        }
+
+        int length = mavlink_msg_to_send_buffer(buffer, &message);
+        stream.append((const char*)buffer, length);
+    }
+
+    return stream;
+}
+
+/// Returns the frames from the benchmark log with the .mavlink timestamps removed, the way a link would deliver them
+QByteArray MAVLinkFrameScannerTest::_loadBenchmarkStream(void)
+{
+    QString logFilename = QString::fromLocal8Bit(qgetenv("QGC_MAVLINK_BENCHMARK_LOG"));
+    if (logFilename.isEmpty()) {
+        return _buildStream(100000, true);
+    }
+
+    QFile logFile(logFilename);
+    if (!logFile.open(QIODevice::ReadOnly)) {
+        qWarning() << "Unable to open benchmark log" << logFilename;
+        return _buildStream(100000, true);
+    }
+
+    QByteArray  log = logFile.readAll();
+    QByteArray  stream;
+    int         offset = 0;
+
+    while (offset + (int)sizeof(quint64) < log.size()) {
+        offset += sizeof(quint64);
+        int frameLength = MAVLinkFrameScanner::frameLength((const uint8_t*)log.constData() + offset, log.size() - offset);
+        if (frameLength <= 0 || offset + frameLength > log.size()) {
+            break;
+        }
+        stream.append(log.constData() + offset, frameLength);
+        offset += frameLength;
+    }
+
+    qDebug() << "Benchmark log" << logFilename << "bytes" << stream.size();
+
+    return stream;
+}
+
+QList<mavlink_message_t> MAVLinkFrameScannerTest::_parseCharDecode(const QByteArray& stream, int chunkSize)
+{
+    QList<mavlink_message_t>    messages;
+    mavlink_message_t           message;
+    mavlink_status_t            status;
+
+    _resetChannel(_parseCharChannel);
+
+    for (int chunkStart=0; chunkStart<stream.size(); chunkStart+=chunkSize) {
+        QByteArray chunk = stream.mid(chunkStart, chunkSize);
+        for (int i=0; i<chunk.size(); i++) {
+            if (mavlink_parse_char(_parseCharChannel, (uint8_t)chunk[i], &message, &status)) {
+                messages.append(message);
+            }
+        }
+    }
+
+    return messages;
+}
+
+QList<mavlink_message_t> MAVLinkFrameScannerTest::_frameScannerDecode(const QByteArray& stream, int chunkSize)
+{
+    QList<mavlink_message_t>    messages;
+    mavlink_message_t           message;
+    MAVLinkFrameScanner         scanner;
+
+    _resetChannel(_scannerChannel);
+    scanner.setChannel(_scannerChannel);
+
+    for (int chunkStart=0; chunkStart<stream.size(); chunkStart+=chunkSize) {
+        scanner.append(stream.mid(chunkStart, chunkSize));
+        while (scanner.nextMessage(&message)) {
+            messages.append(message);
+        }
+    }
+
+    return messages;
+}
+
+void MAVLinkFrameScannerTest::_compareMessages(const QList<mavlink_message_t>& expected, const QList<mavlink_message_t>& actual)
+{
+    QCOMPARE(actual.count(), expected.count());
+    for (int i=0; i<expected.count(); i++) {
+        const mavlink_message_t& expectedMessage = expected[i];
+        const mavlink_message_t& actualMessage = actual[i];
+
+        QCOMPARE(actualMessage.magic,   expectedMessage.magic);
+        QCOMPARE(actualMessage.len,     expectedMessage.len);
+        QCOMPARE(actualMessage.seq,     expectedMessage.seq);
+        QCOMPARE(actualMessage.sysid,   expectedMessage.sysid);
+        QCOMPARE(actualMessage.compid,  expectedMessage.compid);
+        QCOMPARE((uint32_t)actualMessage.msgid, (uint32_t)expectedMessage.msgid);
+        QCOMPARE(memcmp(_MAV_PAYLOAD(&actualMessage), _MAV_PAYLOAD(&expectedMessage), expectedMessage.len), 0);
+    }
+}
+
+void MAVLinkFrameScannerTest::_decodeMatchesParseChar_test(void)
+{
+    QByteArray stream = _buildStream(1000, true);
+
+    QList<mavlink_message_t> expected = _parseCharDecode(stream, stream.size());
+    QCOMPARE(expected.count(), 1000);
+    _compareMessages(expected, _frameScannerDecode(stream, stream.size()));
+
+    // Channel status must be kept the same way mavlink_parse_char keeps it
+    QCOMPARE(mavlink_get_channel_status(_scannerChannel)->packet_rx_success_count, mavlink_get_channel_status(_parseCharChannel)->packet_rx_success_count);
+    QCOMPARE(mavlink_get_channel_status(_scannerChannel)->flags & MAVLINK_STATUS_FLAG_IN_MAVLINK1, mavlink_get_channel_status(_parseCharChannel)->flags & MAVLINK_STATUS_FLAG_IN_MAVLINK1);
+}
+
+void MAVLinkFrameScannerTest::_splitFrames_test(void)
+{
+    QByteArray stream = _buildStream(200, true);
+
+    // Chunk sizes which split frames at every possible position
+    int rgChunkSizes[] = { 1, 2, 3, 7, 11, 64, 255 };
+    for (size_t i=0; i<sizeof(rgChunkSizes)/sizeof(rgChunkSizes[0]); i++) {
+        _compareMessages(_parseCharDecode(stream, rgChunkSizes[i]), _frameScannerDecode(stream, rgChunkSizes[i]));
+    }
+}
+
+void MAVLinkFrameScannerTest::_corruptedStream_test(void)
+{
+    QByteArray stream = _buildStream(100, false);
+
+    // Leading garbage which includes false start markers
+    QByteArray garbage;
+    garbage.append((char)MAVLINK_STX);
+    garbage.append((char)0x05);
+    garbage.append("noise");
+    garbage.append((char)MAVLINK_STX_MAVLINK1);
+    stream.prepend(garbage);
+
+    // Break the crc of the last message
+    stream[stream.size() - 1] = stream[stream.size() - 1] ^ 0xFF;
+
+    QList<mavlink_message_t> messages = _frameScannerDecode(stream, 50);
+    QCOMPARE(messages.count(), 99);
+    QVERIFY(mavlink_get_channel_status(_scannerChannel)->packet_rx_drop_count > 0);
+}
+
+void MAVLinkFrameScannerTest::_parseChar_benchmark(void)
+{
+    QByteArray stream = _loadBenchmarkStream();
+
+    QBENCHMARK {
+        _parseCharDecode(stream, 4096);
+    }
+}
+
+void MAVLinkFrameScannerTest::_frameScanner_benchmark(void)
+{
+    QByteArray stream = _loadBenchmarkStream();
+
+    QBENCHMARK {
+        _frameScannerDecode(stream, 4096);
+    }
+}
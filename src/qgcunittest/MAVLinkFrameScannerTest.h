@@ -0,0 +1,48 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#ifndef MAVLinkFrameScannerTest_H
+#define MAVLinkFrameScannerTest_H
+
+#include "UnitTest.h"
+#include "QGCMAVLink.h"
+
+/// Unit test and benchmark for MAVLinkFrameScanner against mavlink_parse_char.
+///
+/// The benchmarks only run with --unittest-benchmark. They use a synthetic telemetry log by default. Set
+/// QGC_MAVLINK_BENCHMARK_LOG to the path of a recorded .mavlink flight data log to push a real log through both
+/// decode paths.
+class MAVLinkFrameScannerTest : public UnitTest
+{
+    Q_OBJECT
+
+public:
+    MAVLinkFrameScannerTest(void);
+
+private slots:
+    void _decodeMatchesParseChar_test(void);
+    void _splitFrames_test(void);
+    void _corruptedStream_test(void);
+    void _parseChar_benchmark(void);
+    void _frameScanner_benchmark(void);
+
+private:
+    QByteArray                  _buildStream(int messageCount, bool mixVersions);
+    QByteArray                  _loadBenchmarkStream(void);
+    QList<mavlink_message_t>    _parseCharDecode(const QByteArray& stream, int chunkSize);
+    QList<mavlink_message_t>    _frameScannerDecode(const QByteArray& stream, int chunkSize);
+    void                        _compareMessages(const QList<mavlink_message_t>& expected, const QList<mavlink_message_t>& actual);
+    void                        _resetChannel(int channel);
+
+    static const int _packChannel = MAVLINK_COMM_NUM_BUFFERS - 1;
+    static const int _parseCharChannel = MAVLINK_COMM_NUM_BUFFERS - 2;
+    static const int _scannerChannel = MAVLINK_COMM_NUM_BUFFERS - 3;
+};
+
+#endif
@@ -0,0 +1,291 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "MAVLinkLogIndexTest.h"
+#include "MAVLinkLogIndex.h"
+
+#include <QDir>
+#include <QtEndian>
+
+MAVLinkLogIndexTest::MAVLinkLogIndexTest(void)
+{
+
+}
+
+/// @return A .mavlink log record: timestamp followed by a heartbeat frame
+QByteArray MAVLinkLogIndexTest::_record(quint64 timestampUsecs, int sequence, bool littleEndian)
+{
+    mavlink_message_t   message;
+    uint8_t             buffer[MAVLINK_MAX_PACKET_LEN];
+    uchar               timestamp[sizeof(quint64)];
+
+    mavlink_msg_heartbeat_pack_chan(1, MAV_COMP_ID_AUTOPILOT1, _packChannel, &message, MAV_TYPE_QUADROTOR, MAV_AUTOPILOT_PX4, 0, sequence, MAV_STATE_ACTIVE);
+    int length = mavlink_msg_to_send_buffer(buffer, &message);
+
+    if (littleEndian) {
+        qToLittleEndian(timestampUsecs, timestamp);
+    } else {
+        qToBigEndian(timestampUsecs, timestamp);
+    }
+
+    return QByteArray((const char*)timestamp, sizeof(timestamp)) + QByteArray((const char*)buffer, length);
+}
+
+/// Writes a log with one record every _recordIntervalUsecs
+///     @param[out] recordOffsets File offset of each record
+/// @return Log filename
+QString MAVLinkLogIndexTest::_writeLog(const QString& name, int recordCount, QList<qint64>& recordOffsets, bool littleEndian)
+{
+    QByteArray log;
+
+    recordOffsets.clear();
+    for (int i=0; i<recordCount; i++) {
+        recordOffsets.append(log.size());
+        log.append(_record(_baseTimestampUsecs + i * _recordIntervalUsecs, i, littleEndian));
+    }
+
+    QFile file(QDir(_tempDir.path()).filePath(name));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(log) != log.size()) {
+        return QString();
+    }
+
+    return file.fileName();
+}
+
+void MAVLinkLogIndexTest::_build_test(void)
+{
+    QVERIFY(_tempDir.isValid());
+
+    // 10 seconds of log, five records per index slice
+    const int       recordCount = 500;
+    QList<qint64>   recordOffsets;
+    QString         logFilename = _writeLog("build.mavlink", recordCount, recordOffsets);
+    QVERIFY(!logFilename.isEmpty());
+
+    QFile logFile(logFilename);
+    QVERIFY(logFile.open(QIODevice::ReadOnly));
+
+    MAVLinkLogIndex index;
+    QVERIFY(index.build(logFile));
+    QCOMPARE(index.count(), recordCount / 5);
+    QCOMPARE(index.startTimeUSecs(), _baseTimestampUsecs);
+    QCOMPARE(index.endTimeUSecs(), _baseTimestampUsecs + (recordCount - 1) * _recordIntervalUsecs);
+
+    // Every entry points at the first record of its slice
+    for (int i=0; i<index.count(); i++) {
+        quint64 entryTime;
+        quint64 sliceTime = _baseTimestampUsecs + i * 5 * _recordIntervalUsecs;
+        QCOMPARE(index.findOffset(sliceTime, &entryTime), recordOffsets[i * 5]);
+        QCOMPARE(entryTime, sliceTime);
+    }
+
+    // A log without a single valid record has no index
+    QFile garbageFile(QDir(_tempDir.path()).filePath("garbage.mavlink"));
+    QVERIFY(garbageFile.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    garbageFile.write(QByteArray(4096, 0x55));
+    garbageFile.close();
+    QVERIFY(garbageFile.open(QIODevice::ReadOnly));
+    QVERIFY(!index.build(garbageFile));
+    QVERIFY(index.isEmpty());
+}
+
+/// Corrupt bytes are skipped and a truncated record at the end of the log is ignored
+void MAVLinkLogIndexTest::_corruptRecords_test(void)
+{
+    QVERIFY(_tempDir.isValid());
+
+    QByteArray      log;
+    QList<qint64>   recordOffsets;
+    QList<quint64>  recordTimes;
+
+    for (int i=0; i<100; i++) {
+        if (i == 50) {
+            log.append(QByteArray(37, (char)0xFD));
+        }
+        quint64 timestamp = _baseTimestampUsecs + i * 100000;
+        recordOffsets.append(log.size());
+        recordTimes.append(timestamp);
+        log.append(_record(timestamp, i));
+    }
+    QByteArray truncatedRecord = _record(_baseTimestampUsecs + 100 * 100000, 100);
+    log.append(truncatedRecord.left(truncatedRecord.size() - 3));
+
+    QFile logFile(QDir(_tempDir.path()).filePath("corrupt.mavlink"));
+    QVERIFY(logFile.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    QCOMPARE(logFile.write(log), (qint64)log.size());
+    logFile.close();
+    QVERIFY(logFile.open(QIODevice::ReadOnly));
+
+    MAVLinkLogIndex index;
+    QVERIFY(index.build(logFile));
+    QCOMPARE(index.count(), 100);
+    QCOMPARE(index.endTimeUSecs(), recordTimes.last());
+
+    quint64 entryTime;
+    QCOMPARE(index.findOffset(recordTimes[50], &entryTime), recordOffsets[50]);
+    QCOMPARE(entryTime, recordTimes[50]);
+    QCOMPARE(index.findOffset(recordTimes[99], &entryTime), recordOffsets[99]);
+}
+
+/// Seeking lands on the last indexed record at or before the requested time
+void MAVLinkLogIndexTest::_findOffset_test(void)
+{
+    MAVLinkLogIndex index;
+    quint64         entryTime;
+
+    QCOMPARE(index.findOffset(_baseTimestampUsecs, &entryTime), (qint64)0);
+    QCOMPARE(entryTime, (quint64)0);
+
+    // Records closer together than the index interval only keep the first one
+    index.addRecord(_baseTimestampUsecs,            0);
+    index.addRecord(_baseTimestampUsecs + 50000,    100);
+    index.addRecord(_baseTimestampUsecs + 100000,   200);
+    index.addRecord(_baseTimestampUsecs + 350000,   300);
+    index.addRecord(_baseTimestampUsecs + 400000,   400);
+    QCOMPARE(index.count(), 3);
+    QCOMPARE(index.endTimeUSecs(), _baseTimestampUsecs + 400000);
+
+    // Before the start of the log
+    QCOMPARE(index.findOffset(_baseTimestampUsecs - 1, &entryTime), (qint64)0);
+    QCOMPARE(entryTime, _baseTimestampUsecs);
+
+    // Exact entry times
+    QCOMPARE(index.findOffset(_baseTimestampUsecs, &entryTime), (qint64)0);
+    QCOMPARE(index.findOffset(_baseTimestampUsecs + 100000, &entryTime), (qint64)200);
+    QCOMPARE(entryTime, _baseTimestampUsecs + 100000);
+    QCOMPARE(index.findOffset(_baseTimestampUsecs + 350000, &entryTime), (qint64)300);
+
+    // Between entries, including a record which was not indexed
+    QCOMPARE(index.findOffset(_baseTimestampUsecs + 50000, &entryTime), (qint64)0);
+    QCOMPARE(entryTime, _baseTimestampUsecs);
+    QCOMPARE(index.findOffset(_baseTimestampUsecs + 349999, &entryTime), (qint64)200);
+
+    // Past the end of the log
+    QCOMPARE(index.findOffset(_baseTimestampUsecs + 10000000, &entryTime), (qint64)300);
+    QCOMPARE(entryTime, _baseTimestampUsecs + 350000);
+
+    index.clear();
+    QVERIFY(index.isEmpty());
+    QCOMPARE(index.endTimeUSecs(), (quint64)0);
+}
+
+/// Older logs stored little endian timestamps, which show up as being in the future
+void MAVLinkLogIndexTest::_parseTimestamp_test(void)
+{
+    uchar   bytes[sizeof(quint64)];
+    quint64 nowUSecs = _baseTimestampUsecs + 1000000;
+
+    qToBigEndian(_baseTimestampUsecs, bytes);
+    QCOMPARE(MAVLinkLogIndex::parseTimestamp(bytes, nowUSecs), _baseTimestampUsecs);
+
+    qToLittleEndian(_baseTimestampUsecs, bytes);
+    QCOMPARE(MAVLinkLogIndex::parseTimestamp(bytes, nowUSecs), _baseTimestampUsecs);
+    QCOMPARE(MAVLinkLogIndex::parseTimestamp(bytes), _baseTimestampUsecs);
+
+    // A whole little endian log indexes the same as a big endian one
+    QVERIFY(_tempDir.isValid());
+    QList<qint64>   recordOffsets;
+    QString         logFilename = _writeLog("littleendian.mavlink", 50, recordOffsets, true /* littleEndian */);
+    QVERIFY(!logFilename.isEmpty());
+
+    QFile logFile(logFilename);
+    QVERIFY(logFile.open(QIODevice::ReadOnly));
+
+    MAVLinkLogIndex index;
+    QVERIFY(index.build(logFile));
+    QCOMPARE(index.count(), 10);
+    QCOMPARE(index.startTimeUSecs(), _baseTimestampUsecs);
+    QCOMPARE(index.endTimeUSecs(), _baseTimestampUsecs + 49 * _recordIntervalUsecs);
+}
+
+/// The first load builds and saves the sidecar, later loads use it without reading the log
+void MAVLinkLogIndexTest::_sidecar_test(void)
+{
+    QVERIFY(_tempDir.isValid());
+
+    QList<qint64>   recordOffsets;
+    QString         logFilename = _writeLog("sidecar.mavlink", 200, recordOffsets);
+    QString         errorString;
+    QVERIFY(!logFilename.isEmpty());
+    QVERIFY(!QFile::exists(MAVLinkLogIndex::indexFilename(logFilename)));
+
+    QFile logFile(logFilename);
+    QVERIFY(logFile.open(QIODevice::ReadOnly));
+
+    MAVLinkLogIndex builtIndex;
+    QVERIFY(builtIndex.load(logFile, errorString));
+    QVERIFY(QFile::exists(MAVLinkLogIndex::indexFilename(logFilename)));
+    logFile.close();
+
+    // Wipe the log contents but keep its size, only a load from the sidecar can still find the records
+    QVERIFY(logFile.open(QIODevice::ReadWrite));
+    logFile.write(QByteArray(logFile.size(), 0));
+    logFile.close();
+    QVERIFY(logFile.open(QIODevice::ReadOnly));
+
+    MAVLinkLogIndex loadedIndex;
+    QVERIFY(loadedIndex.load(logFile, errorString));
+    QCOMPARE(loadedIndex.count(), builtIndex.count());
+    QCOMPARE(loadedIndex.startTimeUSecs(), builtIndex.startTimeUSecs());
+    QCOMPARE(loadedIndex.endTimeUSecs(), builtIndex.endTimeUSecs());
+    for (int i=0; i<recordOffsets.count(); i+=5) {
+        quint64 builtTime, loadedTime;
+        quint64 timestamp = _baseTimestampUsecs + i * _recordIntervalUsecs;
+        QCOMPARE(loadedIndex.findOffset(timestamp, &loadedTime), builtIndex.findOffset(timestamp, &builtTime));
+        QCOMPARE(loadedTime, builtTime);
+    }
+}
+
+/// A sidecar written for a different log size is rebuilt, a log without records fails to load
+void MAVLinkLogIndexTest::_staleSidecar_test(void)
+{
+    QVERIFY(_tempDir.isValid());
+
+    QList<qint64>   recordOffsets;
+    QString         logFilename = _writeLog("stale.mavlink", 100, recordOffsets);
+    QString         errorString;
+    QVERIFY(!logFilename.isEmpty());
+
+    QFile logFile(logFilename);
+    QVERIFY(logFile.open(QIODevice::ReadOnly));
+    MAVLinkLogIndex index;
+    QVERIFY(index.load(logFile, errorString));
+    QCOMPARE(index.endTimeUSecs(), _baseTimestampUsecs + 99 * _recordIntervalUsecs);
+    logFile.close();
+
+    // Log grows after the sidecar was written
+    QVERIFY(logFile.open(QIODevice::Append));
+    for (int i=100; i<150; i++) {
+        logFile.write(_record(_baseTimestampUsecs + i * _recordIntervalUsecs, i));
+    }
+    logFile.close();
+    QVERIFY(logFile.open(QIODevice::ReadOnly));
+
+    MAVLinkLogIndex rebuiltIndex;
+    QVERIFY(rebuiltIndex.load(logFile, errorString));
+    QCOMPARE(rebuiltIndex.count(), 30);
+    QCOMPARE(rebuiltIndex.endTimeUSecs(), _baseTimestampUsecs + 149 * _recordIntervalUsecs);
+    logFile.close();
+
+    // Corrupt sidecar on a log with no records
+    QFile garbageFile(QDir(_tempDir.path()).filePath("empty.mavlink"));
+    QVERIFY(garbageFile.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    garbageFile.write(QByteArray(64, 0x55));
+    garbageFile.close();
+    QFile garbageIndex(MAVLinkLogIndex::indexFilename(garbageFile.fileName()));
+    QVERIFY(garbageIndex.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    garbageIndex.write(QByteArray(16, 0x55));
+    garbageIndex.close();
+
+    QVERIFY(garbageFile.open(QIODevice::ReadOnly));
+    MAVLinkLogIndex emptyIndex;
+    errorString.clear();
+    QVERIFY(!emptyIndex.load(garbageFile, errorString));
+    QVERIFY(!errorString.isEmpty());
+}
@@ -0,0 +1,45 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#ifndef MAVLinkLogIndexTest_H
+#define MAVLinkLogIndexTest_H
+
+#include "UnitTest.h"
+#include "QGCMAVLink.h"
+
+#include <QTemporaryDir>
+
+/// Unit test for MAVLinkLogIndex: index build, seeking, timestamp lookup and the sidecar index file
+class MAVLinkLogIndexTest : public UnitTest
+{
+    Q_OBJECT
+
+public:
+    MAVLinkLogIndexTest(void);
+
+private slots:
+    void _build_test(void);
+    void _corruptRecords_test(void);
+    void _findOffset_test(void);
+    void _parseTimestamp_test(void);
+    void _sidecar_test(void);
+    void _staleSidecar_test(void);
+
+private:
+    QByteArray  _record     (quint64 timestampUsecs, int sequence, bool littleEndian = false);
+    QString     _writeLog   (const QString& name, int recordCount, QList<qint64>& recordOffsets, bool littleEndian = false);
+
+    QTemporaryDir _tempDir;
+
+    static const int        _packChannel = MAVLINK_COMM_NUM_BUFFERS - 1;
+    static const quint64    _baseTimestampUsecs = 1500000000000000ULL;
+    static const quint64    _recordIntervalUsecs = 20000;
+};
+
+#endif
@@ -0,0 +1,219 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "MAVLinkLogWriterTest.h"
+#include "MAVLinkLogWriter.h"
+#include "MAVLinkLogIndex.h"
+
+#include <QDir>
+#include <QMutex>
+#include <QSignalSpy>
+#include <QtEndian>
+
+/// Log file which can hold the writer thread inside write, so the writer falls behind, or fail writes like a full disk
+class MAVLinkLogWriterTestFile : public QFile
+{
+public:
+    MAVLinkLogWriterTestFile(const QString& name)
+        : QFile(name)
+        , _failWrites(false)
+    {
+
+    }
+
+    void blockWrites   (void) { _gate.lock(); }
+    void releaseWrites (void) { _gate.unlock(); }
+    void failWrites    (void) { _failWrites = true; }
+
+protected:
+    qint64 writeData(const char* data, qint64 len)
+    {
+        _gate.lock();
+        _gate.unlock();
+
+        if (_failWrites) {
+            setErrorString("No space left on device");
+            return -1;
+        }
+        return QFile::writeData(data, len);
+    }
+
+private:
+    QMutex          _gate;
+    volatile bool   _failWrites;
+};
+
+static const quint64 _baseTimestampUsecs = 1500000000000000ULL;
+
+MAVLinkLogWriterTest::MAVLinkLogWriterTest(void)
+{
+
+}
+
+/// Frame contents only need to be recognizable, the writer does not decode them
+QByteArray MAVLinkLogWriterTest::_frame(int index)
+{
+    QByteArray frame(10 + (index % 270), (char)(index & 0xFF));
+    memcpy(frame.data(), &index, sizeof(index));
+    return frame;
+}
+
+QByteArray MAVLinkLogWriterTest::_record(quint64 timestampUsecs, const QByteArray& frame)
+{
+    uchar timestamp[sizeof(quint64)];
+    qToBigEndian(timestampUsecs, timestamp);
+
+    return QByteArray((const char*)timestamp, sizeof(timestamp)) + frame;
+}
+
+/// Several times the ring size goes through the writer, records must come out complete and in order
+void MAVLinkLogWriterTest::_ordering_test(void)
+{
+    QVERIFY(_tempDir.isValid());
+
+    QFile file(QDir(_tempDir.path()).filePath("ordering.mavlink"));
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+
+    const int   recordCount = 100000;
+    QByteArray  expected;
+
+    MAVLinkLogWriter writer;
+    writer.startLogging(&file);
+    for (int i=0; i<recordCount; i++) {
+        quint64     timestamp = _baseTimestampUsecs + i * 1000;
+        QByteArray  frame = _frame(i);
+        // Hold off instead of dropping so every record makes it to disk
+        while (!writer.logFrame(timestamp, (const uint8_t*)frame.constData(), frame.size())) {
+            QThread::yieldCurrentThread();
+        }
+        expected.append(_record(timestamp, frame));
+    }
+    writer.stopLogging();
+    file.close();
+
+    QCOMPARE(writer.queuedRecords(), (quint64)recordCount);
+    QVERIFY(expected.size() > 3 * 4 * 1024 * 1024);
+
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QByteArray written = file.readAll();
+    QCOMPARE(written.size(), expected.size());
+    QVERIFY(written == expected);
+}
+
+/// A writer which can't keep up drops whole records and counts them, the records which were queued stay intact
+void MAVLinkLogWriterTest::_overflow_test(void)
+{
+    QVERIFY(_tempDir.isValid());
+
+    MAVLinkLogWriterTestFile file(QDir(_tempDir.path()).filePath("overflow.mavlink"));
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+
+    QByteArray  frame(200, 0x55);
+    QByteArray  expected;
+    int         acceptedRecords = 0;
+    int         attempts = 0;
+    int         droppedRecords = 0;
+
+    // Nothing gets written until the file is released, so the ring fills up
+    file.blockWrites();
+
+    MAVLinkLogWriter writer;
+    writer.startLogging(&file);
+    while (droppedRecords < 100) {
+        quint64 timestamp = _baseTimestampUsecs + attempts++ * 1000;
+        if (writer.logFrame(timestamp, (const uint8_t*)frame.constData(), frame.size())) {
+            QCOMPARE(droppedRecords, 0);
+            expected.append(_record(timestamp, frame));
+            acceptedRecords++;
+        } else {
+            droppedRecords++;
+        }
+    }
+
+    file.releaseWrites();
+    writer.stopLogging();
+    file.close();
+
+    QVERIFY(acceptedRecords > 0);
+    QCOMPARE(writer.queuedRecords(), (quint64)acceptedRecords);
+    QCOMPARE(writer.droppedRecords(), (quint64)droppedRecords);
+    QCOMPARE(writer.droppedBytes(), (quint64)(droppedRecords * (sizeof(quint64) + frame.size())));
+
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QVERIFY(file.readAll() == expected);
+}
+
+/// Records still sitting in the ring when logging stops must be written, synced and indexed
+void MAVLinkLogWriterTest::_stopFlushes_test(void)
+{
+    QVERIFY(_tempDir.isValid());
+
+    QFile file(QDir(_tempDir.path()).filePath("stop.mavlink"));
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+
+    const int       recordCount = 100;
+    const quint64   recordIntervalUsecs = 100000;
+    QByteArray      expected;
+    QList<qint64>   recordOffsets;
+
+    MAVLinkLogWriter writer;
+    writer.startLogging(&file);
+    for (int i=0; i<recordCount; i++) {
+        quint64     timestamp = _baseTimestampUsecs + i * recordIntervalUsecs;
+        QByteArray  frame = _frame(i);
+        QVERIFY(writer.logFrame(timestamp, (const uint8_t*)frame.constData(), frame.size()));
+        recordOffsets.append(expected.size());
+        expected.append(_record(timestamp, frame));
+    }
+    // Stop well within the batch interval
+    writer.stopLogging();
+
+    QCOMPARE(file.size(), (qint64)expected.size());
+    file.close();
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QVERIFY(file.readAll() == expected);
+
+    // The index written along with the log is picked up without rebuilding it
+    QVERIFY(QFile::exists(MAVLinkLogIndex::indexFilename(file.fileName())));
+    MAVLinkLogIndex index;
+    QString         errorString;
+    QVERIFY(index.load(file, errorString));
+    QCOMPARE(index.count(), recordCount);
+    QCOMPARE(index.startTimeUSecs(), _baseTimestampUsecs);
+    QCOMPARE(index.endTimeUSecs(), _baseTimestampUsecs + (recordCount - 1) * recordIntervalUsecs);
+
+    quint64 entryTime;
+    QCOMPARE(index.findOffset(_baseTimestampUsecs + 50 * recordIntervalUsecs + 10, &entryTime), recordOffsets[50]);
+    QCOMPARE(entryTime, _baseTimestampUsecs + 50 * recordIntervalUsecs);
+}
+
+void MAVLinkLogWriterTest::_writeFailure_test(void)
+{
+    QVERIFY(_tempDir.isValid());
+
+    MAVLinkLogWriterTestFile file(QDir(_tempDir.path()).filePath("failure.mavlink"));
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.failWrites();
+
+    MAVLinkLogWriter writer;
+    QSignalSpy spyFailed(&writer, &MAVLinkLogWriter::writeFailed);
+
+    QByteArray frame = _frame(0);
+    writer.startLogging(&file);
+    QVERIFY(writer.logFrame(_baseTimestampUsecs, (const uint8_t*)frame.constData(), frame.size()));
+
+    // The writer thread stops on its own after the failure
+    QVERIFY(writer.wait(10000));
+    QCOMPARE(spyFailed.count(), 1);
+    QVERIFY(spyFailed[0][0].toString().contains("No space left on device"));
+    QCOMPARE(writer.logFrame(_baseTimestampUsecs, (const uint8_t*)frame.constData(), frame.size()), false);
+
+    writer.stopLogging();
+    QVERIFY(!QFile::exists(MAVLinkLogIndex::indexFilename(file.fileName())));
+}
@@ -0,0 +1,38 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#ifndef MAVLinkLogWriterTest_H
+#define MAVLinkLogWriterTest_H
+
+#include "UnitTest.h"
+
+#include <QTemporaryDir>
+
+/// Unit test for MAVLinkLogWriter: record ordering, ring buffer overflow, flushing on stop and write failures
+class MAVLinkLogWriterTest : public UnitTest
+{
+    Q_OBJECT
+
+public:
+    MAVLinkLogWriterTest(void);
+
+private slots:
+    void _ordering_test(void);
+    void _overflow_test(void);
+    void _stopFlushes_test(void);
+    void _writeFailure_test(void);
+
+private:
+    QByteArray  _frame  (int index);
+    QByteArray  _record (quint64 timestampUsecs, const QByteArray& frame);
+
+    QTemporaryDir _tempDir;
+};
+
+#endif
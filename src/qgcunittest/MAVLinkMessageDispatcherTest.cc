@@ -0,0 +1,115 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "MAVLinkMessageDispatcherTest.h"
+
+MAVLinkMessageDispatcherTest::MAVLinkMessageDispatcherTest(void)
+    : _dispatcher(NULL)
+    , _subscription(NULL)
+{
+
+}
+
+mavlink_message_t MAVLinkMessageDispatcherTest::_message(uint8_t sysid, uint8_t compid, uint32_t msgid)
+{
+    mavlink_message_t message;
+
+    memset(&message, 0, sizeof(message));
+    message.sysid = sysid;
+    message.compid = compid;
+    message.msgid = msgid;
+
+    return message;
+}
+
+void MAVLinkMessageDispatcherTest::_messageReceived(LinkInterface* link, mavlink_message_t message)
+{
+    Q_UNUSED(link);
+    _received.append(message);
+}
+
+void MAVLinkMessageDispatcherTest::_unsubscribeOnReceive(LinkInterface* link, mavlink_message_t message)
+{
+    Q_UNUSED(link);
+    _received.append(message);
+    _dispatcher->unsubscribe(_subscription);
+}
+
+void MAVLinkMessageDispatcherTest::_sysIdFilter_test(void)
+{
+    MAVLinkMessageDispatcher dispatcher;
+    _received.clear();
+
+    dispatcher.subscribe(1, MAVLinkMessageDispatcher::anyId, MAVLinkMessageDispatcher::anyId, this, &MAVLinkMessageDispatcherTest::_messageReceived);
+
+    dispatcher.dispatch(NULL, _message(1, 1, MAVLINK_MSG_ID_HEARTBEAT));
+    dispatcher.dispatch(NULL, _message(2, 1, MAVLINK_MSG_ID_HEARTBEAT));
+    dispatcher.dispatch(NULL, _message(1, 50, MAVLINK_MSG_ID_ATTITUDE));
+
+    QCOMPARE(_received.count(), 2);
+    QCOMPARE((int)_received[0].sysid, 1);
+    QCOMPARE((int)_received[1].msgid, MAVLINK_MSG_ID_ATTITUDE);
+
+    // Any sysid sees everything
+    _received.clear();
+    dispatcher.subscribe(MAVLinkMessageDispatcher::anyId, MAVLinkMessageDispatcher::anyId, MAVLinkMessageDispatcher::anyId, this, &MAVLinkMessageDispatcherTest::_messageReceived);
+    dispatcher.dispatch(NULL, _message(2, 1, MAVLINK_MSG_ID_HEARTBEAT));
+    dispatcher.dispatch(NULL, _message(1, 1, MAVLINK_MSG_ID_HEARTBEAT));
+    QCOMPARE(_received.count(), 3);
+}
+
+void MAVLinkMessageDispatcherTest::_compIdMsgIdFilter_test(void)
+{
+    MAVLinkMessageDispatcher dispatcher;
+    _received.clear();
+
+    dispatcher.subscribe(1, MAV_COMP_ID_AUTOPILOT1, MAVLINK_MSG_ID_PARAM_VALUE, this, &MAVLinkMessageDispatcherTest::_messageReceived);
+
+    dispatcher.dispatch(NULL, _message(1, MAV_COMP_ID_AUTOPILOT1, MAVLINK_MSG_ID_HEARTBEAT));
+    dispatcher.dispatch(NULL, _message(1, MAV_COMP_ID_CAMERA, MAVLINK_MSG_ID_PARAM_VALUE));
+    dispatcher.dispatch(NULL, _message(1, MAV_COMP_ID_AUTOPILOT1, MAVLINK_MSG_ID_PARAM_VALUE));
+
+    QCOMPARE(_received.count(), 1);
+    QCOMPARE((int)_received[0].compid, (int)MAV_COMP_ID_AUTOPILOT1);
+    QCOMPARE((int)_received[0].msgid, MAVLINK_MSG_ID_PARAM_VALUE);
+}
+
+void MAVLinkMessageDispatcherTest::_receiverDestroyed_test(void)
+{
+    MAVLinkMessageDispatcher dispatcher;
+    MAVLinkMessageDispatcherTest* receiver = new MAVLinkMessageDispatcherTest;
+
+    dispatcher.subscribe(1, MAVLinkMessageDispatcher::anyId, MAVLinkMessageDispatcher::anyId, receiver, &MAVLinkMessageDispatcherTest::_messageReceived);
+    dispatcher.subscribe(1, MAVLinkMessageDispatcher::anyId, MAVLINK_MSG_ID_HEARTBEAT, receiver, &MAVLinkMessageDispatcherTest::_messageReceived);
+    QCOMPARE(dispatcher.subscriptionCount(), 2);
+
+    delete receiver;
+    QCOMPARE(dispatcher.subscriptionCount(), 0);
+
+    // Must not crash
+    dispatcher.dispatch(NULL, _message(1, 1, MAVLINK_MSG_ID_HEARTBEAT));
+}
+
+void MAVLinkMessageDispatcherTest::_unsubscribeDuringDispatch_test(void)
+{
+    MAVLinkMessageDispatcher dispatcher;
+    _dispatcher = &dispatcher;
+    _received.clear();
+
+    _subscription = dispatcher.subscribe(1, MAVLinkMessageDispatcher::anyId, MAVLinkMessageDispatcher::anyId, this, &MAVLinkMessageDispatcherTest::_unsubscribeOnReceive);
+
+    dispatcher.dispatch(NULL, _message(1, 1, MAVLINK_MSG_ID_HEARTBEAT));
+    dispatcher.dispatch(NULL, _message(1, 1, MAVLINK_MSG_ID_HEARTBEAT));
+
+    QCOMPARE(_received.count(), 1);
+    QCOMPARE(dispatcher.subscriptionCount(), 0);
+
+    _dispatcher = NULL;
+    _subscription = NULL;
+}
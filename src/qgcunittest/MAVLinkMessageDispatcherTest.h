@@ -0,0 +1,42 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#ifndef MAVLinkMessageDispatcherTest_H
+#define MAVLinkMessageDispatcherTest_H
+
+#include "UnitTest.h"
+#include "MAVLinkMessageDispatcher.h"
+
+/// Unit test for MAVLinkMessageDispatcher subscription filtering
+class MAVLinkMessageDispatcherTest : public UnitTest
+{
+    Q_OBJECT
+
+public:
+    MAVLinkMessageDispatcherTest(void);
+
+private slots:
+    void _sysIdFilter_test(void);
+    void _compIdMsgIdFilter_test(void);
+    void _receiverDestroyed_test(void);
+    void _unsubscribeDuringDispatch_test(void);
+
+public slots:
+    void _messageReceived(LinkInterface* link, mavlink_message_t message);
+    void _unsubscribeOnReceive(LinkInterface* link, mavlink_message_t message);
+
+private:
+    mavlink_message_t _message(uint8_t sysid, uint8_t compid, uint32_t msgid);
+
+    MAVLinkMessageDispatcher*   _dispatcher;
+    MAVLinkMessageSubscription* _subscription;
+    QList<mavlink_message_t>    _received;
+};
+
+#endif
@@ -18,7 +18,9 @@
 #include "MAVLinkProtocol.h"
 #include "MainWindow.h"
 #include "Vehicle.h"
+#include "ParameterManager.h"
 
+#include <QTemporaryDir>
 #include <QTemporaryFile>
 #include <QTime>
 
@@ -77,14 +79,43 @@ QList<QObject*>& UnitTest::_testList(void)
 	return tests;
 }
 
-int UnitTest::run(QString& singleTest)
+/// @brief Returns the names of the test functions to run. Benchmarks are kept out of the normal unit test run
+/// since they are slow and only report numbers.
+QStringList UnitTest::_testFunctions(QObject* test, bool benchmarks)
+{
+    QStringList functions;
+    const QMetaObject* metaObject = test->metaObject();
+
+    for (int i=0; i<metaObject->methodCount(); i++) {
+        QMetaMethod method = metaObject->method(i);
+        if (method.methodType() != QMetaMethod::Slot || method.access() != QMetaMethod::Private || method.parameterCount() != 0) {
+            continue;
+        }
+        QString name = QString::fromLatin1(method.name());
+        if (name == "initTestCase" || name == "cleanupTestCase" || name == "init" || name == "cleanup" || name.endsWith("_data")) {
+            continue;
+        }
+        if (name.endsWith("_benchmark") == benchmarks) {
+            functions << name;
+        }
+    }
+
+    return functions;
+}
+
+int UnitTest::run(QString& singleTest, bool benchmarks)
 {
     int ret = 0;
     
     foreach (QObject* test, _testList()) {
         if (singleTest.isEmpty() || singleTest == test->objectName()) {
+            QStringList functions = _testFunctions(test, benchmarks);
+            if (functions.isEmpty()) {
+                continue;
+            }
+
             QStringList args;
-            args << "*" << "-maxwarnings" << "0";
+            args << "*" << "-maxwarnings" << "0" << functions;
             ret += QTest::qExec(test, args);
         }
     }
@@ -119,6 +150,14 @@ void UnitTest::init(void)
     _expectMissedMessageBox = false;
     
     MAVLinkProtocol::deleteTempLogFiles();
+
+    // Parameter caches from a previous test would short circuit parameter loading. Tests keep their caches in a
+    // temporary directory, so the caches of the real application are left alone.
+    static QTemporaryDir parameterCacheRoot;
+    ParameterManager::setParameterCacheRoot(parameterCacheRoot.path());
+    QDir paramDir(ParameterManager::parameterCacheDir());
+    paramDir.removeRecursively();
+    paramDir.mkpath(paramDir.absolutePath());
 }
 
 /// @brief Called after each test.
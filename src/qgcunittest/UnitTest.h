@@ -44,7 +44,8 @@ public:
     
     /// @brief Called to run all the registered unit tests
     ///     @param singleTest Name of test to just run a single test
-    static int run(QString& singleTest);
+    ///     @param benchmarks true: run only the benchmark slots (name ends in _benchmark), false: run everything else
+    static int run(QString& singleTest, bool benchmarks = false);
     
     /// @brief Sets up for an expected QGCMessageBox
     ///     @param response Response to take on message box
@@ -171,6 +172,7 @@ private:
 
     void _unitTestCalled(void);
 	static QList<QObject*>& _testList(void);
+    static QStringList _testFunctions(QObject* test, bool benchmarks);
 
     // Catch QGCMessageBox calls
     static bool                         _messageBoxRespondedTo;     ///< Message box was responded to
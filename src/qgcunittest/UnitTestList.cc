@@ -27,11 +27,28 @@
 #include "MavlinkLogTest.h"
 #include "MainWindowTest.h"
 #include "FileManagerTest.h"
+#include "FileTransferWindowTest.h"
 #include "TCPLinkTest.h"
 #include "ParameterManagerTest.h"
+#include "ParameterMetaDataCacheTest.h"
+#include "ParameterStoreTest.h"
+#include "ParameterReadWindowTest.h"
+#include "ParameterCacheTest.h"
 #include "MissionCommandTreeTest.h"
 #include "LogDownloadTest.h"
 #include "SendMavCommandTest.h"
+#include "MAVLinkMessageDispatcherTest.h"
+#include "LogReplayLinkTest.h"
+#include "MAVLinkFrameScannerTest.h"
+#include "MAVLinkLogIndexTest.h"
+#include "MAVLinkLogWriterTest.h"
+#include "QGCTileCacheTest.h"
+#include "QGCTileDownloaderTest.h"
+#include "VideoReceiverTest.h"
+#include "ULogStreamTest.h"
+#include "FlightLogReaderTest.h"
+#include "TimeSeriesPyramidTest.h"
+#include "TimeSeriesStoreTest.h"
 
 UT_REGISTER_TEST(FactSystemTestGeneric)
 UT_REGISTER_TEST(FactSystemTestPX4)
@@ -49,9 +66,26 @@ UT_REGISTER_TEST(MissionManagerTest)
 UT_REGISTER_TEST(RadioConfigTest)
 UT_REGISTER_TEST(TCPLinkTest)
 UT_REGISTER_TEST(ParameterManagerTest)
+UT_REGISTER_TEST(ParameterMetaDataCacheTest)
+UT_REGISTER_TEST(ParameterStoreTest)
+UT_REGISTER_TEST(ParameterReadWindowTest)
+UT_REGISTER_TEST(ParameterCacheTest)
 UT_REGISTER_TEST(MissionCommandTreeTest)
 UT_REGISTER_TEST(LogDownloadTest)
 UT_REGISTER_TEST(SendMavCommandTest)
+UT_REGISTER_TEST(MAVLinkMessageDispatcherTest)
+UT_REGISTER_TEST(LogReplayLinkTest)
+UT_REGISTER_TEST(MAVLinkFrameScannerTest)
+UT_REGISTER_TEST(MAVLinkLogIndexTest)
+UT_REGISTER_TEST(MAVLinkLogWriterTest)
+UT_REGISTER_TEST(QGCTileCacheTest)
+UT_REGISTER_TEST(QGCTileDownloaderTest)
+UT_REGISTER_TEST(VideoReceiverTest)
+UT_REGISTER_TEST(FileTransferWindowTest)
+UT_REGISTER_TEST(ULogStreamTest)
+UT_REGISTER_TEST(FlightLogReaderTest)
+UT_REGISTER_TEST(TimeSeriesPyramidTest)
+UT_REGISTER_TEST(TimeSeriesStoreTest)
 
 // List of unit test which are currently disabled.
 // If disabling a new test, include reason in comment.
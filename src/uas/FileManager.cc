@@ -28,9 +28,14 @@ FileManager::FileManager(QObject* parent, Vehicle* vehicle)
     , _dedicatedLink(NULL)
     , _lastOutgoingSeqNumber(0)
     , _activeSession(0)
+    , _windowSize(FileTransferWindow::defaultWindowSize)
     , _systemIdQGC(0)
 {
     connect(&_ackTimer, &QTimer::timeout, this, &FileManager::_ackTimeout);
+
+    _transferTimer.setSingleShot(true);
+    connect(&_transferTimer, &QTimer::timeout, this, &FileManager::_transferTimeout);
+    _transferClock.start();
     
     _systemIdServer = _vehicle->id();
     
@@ -50,16 +55,30 @@ void FileManager::_openAckResponse(Request* openAck)
     // File length comes back in data
     Q_ASSERT(openAck->hdr.size == sizeof(uint32_t));
     _downloadFileSize = openAck->openFileLength;
+
+    // Data is written to the file as it comes in instead of being held until the download completes
+    QString downloadFilePath = _readFileDownloadDir.absoluteFilePath(_readFileDownloadFilename);
+    _downloadFile.setFileName(downloadFilePath);
+    if (!_downloadFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        _closeDownloadSession(false /* failure */);
+        _emitErrorMessage(tr("Unable to open local file for writing (%1)").arg(downloadFilePath));
+        return;
+    }
     
-    // Start the sequence of read commands
+    if (_currentOperation == kCORead) {
+        // Start the window of read commands
+        _transferWindow.start(_downloadFileSize, sizeof(((Request*)0)->data), _windowSize, _transferClock.elapsed());
+        _sendTransferRequests();
+        return;
+    }
 
-    _downloadOffset = 0;            // Start reading at beginning of file
-    _readFileAccumulator.clear();   // Start with an empty file
+    // Start the burst from the beginning of the file
+
+    _downloadOffset = 0;
 
     Request request;
     request.hdr.session = _activeSession;
-	Q_ASSERT(_currentOperation == kCORead || _currentOperation == kCOBurst);
-	request.hdr.opcode = _currentOperation == kCORead ? kCmdReadFile : kCmdBurstReadFile;
+	request.hdr.opcode = kCmdBurstReadFile;
     request.hdr.offset = _downloadOffset;
     request.hdr.size = sizeof(request.data);
 
@@ -72,30 +91,29 @@ void FileManager::_closeDownloadSession(bool success)
 {
     qCDebug(FileManagerLog) << QString("_closeDownloadSession: success(%1)").arg(success);
     
+    bool readFile = _currentOperation == kCORead;
     _currentOperation = kCOIdle;
+    _transferTimer.stop();
     
-    if (success) {
-        QString downloadFilePath = _readFileDownloadDir.absoluteFilePath(_readFileDownloadFilename);
-
-        QFile file(downloadFilePath);
-        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
-            _emitErrorMessage(tr("Unable to open local file for writing (%1)").arg(downloadFilePath));
-            return;
-        }
+    if (_downloadFile.isOpen()) {
+        _downloadFile.close();
+    }
+    if (!success && !_downloadFile.fileName().isEmpty()) {
+        // Don't leave a partial file behind
+        _downloadFile.remove();
+    }
 
-        qint64 bytesWritten = file.write((const char *)_readFileAccumulator, _readFileAccumulator.length());
-        if (bytesWritten != _readFileAccumulator.length()) {
-            file.close();
-            _emitErrorMessage(tr("Unable to write data to local file (%1)").arg(downloadFilePath));
-            return;
+    if (success) {
+        if (readFile) {
+            qint64 nowMsecs = _transferClock.elapsed();
+            qCDebug(FileManagerLog) << "Download complete: bytes" << _transferWindow.bytesTransferred()
+                                    << "bytes/sec" << _transferWindow.bytesPerSecond(nowMsecs)
+                                    << "rtt" << _transferWindow.rttMsecs()
+                                    << "retransmits" << _transferWindow.retransmitCount();
         }
-        file.close();
-
         emit commandComplete();
     }
     
-    _readFileAccumulator.clear();
-    
     // Close the open session
     _sendResetCommand();
 }
@@ -107,10 +125,15 @@ void FileManager::_closeUploadSession(bool success)
     qCDebug(FileManagerLog) << QString("_closeUploadSession: success(%1)").arg(success);
     
     _currentOperation = kCOIdle;
-    _writeFileAccumulator.clear();
-    _writeFileSize = 0;
+    _transferTimer.stop();
+    _uploadFile.close();
     
     if (success) {
+        qint64 nowMsecs = _transferClock.elapsed();
+        qCDebug(FileManagerLog) << "Upload complete: bytes" << _transferWindow.bytesTransferred()
+                                << "bytes/sec" << _transferWindow.bytesPerSecond(nowMsecs)
+                                << "rtt" << _transferWindow.rttMsecs()
+                                << "retransmits" << _transferWindow.retransmitCount();
         emit commandComplete();
     }
     
@@ -128,7 +151,15 @@ void FileManager::_downloadAckResponse(Request* readAck, bool readFile)
         return;
     }
 
-    if (readAck->hdr.offset != _downloadOffset) {
+    uint32_t dataSize = readAck->hdr.size;
+
+    if (readFile) {
+        // Reads may come back in any order, or more than once if they were sent again
+        if (!_transferWindow.received(readAck->hdr.offset, dataSize, _transferClock.elapsed())) {
+            qCDebug(FileManagerLog) << QString("_downloadAckResponse: ignoring duplicate offset(%1)").arg(readAck->hdr.offset);
+            return;
+        }
+    } else if (readAck->hdr.offset != _downloadOffset) {
         _closeDownloadSession(false /* failure */);
         _emitErrorMessage(tr("Download: Offset returned (%1) differs from offset requested/expected (%2)").arg(readAck->hdr.offset).arg(_downloadOffset));
         return;
@@ -136,24 +167,42 @@ void FileManager::_downloadAckResponse(Request* readAck, bool readFile)
     
     qCDebug(FileManagerLog) << QString("_downloadAckResponse: offset(%1) size(%2) burstComplete(%3)").arg(readAck->hdr.offset).arg(readAck->hdr.size).arg(readAck->hdr.burstComplete);
 
+    if (!_downloadFile.seek(readAck->hdr.offset) || _downloadFile.write((const char*)readAck->data, dataSize) != (qint64)dataSize) {
+        QString downloadFilePath = _downloadFile.fileName();
+        _closeDownloadSession(false /* failure */);
+        _emitErrorMessage(tr("Unable to write data to local file (%1)").arg(downloadFilePath));
+        return;
+    }
+
+    if (readFile) {
+        if (_downloadFileSize != 0) {
+            emit commandProgress(100 * ((float)_transferWindow.bytesTransferred() / (float)_downloadFileSize));
+        }
+        if (_transferWindow.complete()) {
+            _closeDownloadSession(true /* success */);
+        } else {
+            _sendTransferRequests();
+        }
+        return;
+    }
+
 	_downloadOffset += readAck->hdr.size;
-    _readFileAccumulator.append((const char*)readAck->data, readAck->hdr.size);
     
     if (_downloadFileSize != 0) {
-        emit commandProgress(100 * ((float)_readFileAccumulator.length() / (float)_downloadFileSize));
+        emit commandProgress(100 * ((float)_downloadOffset / (float)_downloadFileSize));
     }
 
-    if (readFile || readAck->hdr.burstComplete) {
-        // Possibly still more data to read, send next read request
+    if (readAck->hdr.burstComplete) {
+        // Possibly still more data to read, send next burst request
 
         Request request;
         request.hdr.session = _activeSession;
-        request.hdr.opcode = readFile ? kCmdReadFile : kCmdBurstReadFile;
+        request.hdr.opcode = kCmdBurstReadFile;
         request.hdr.offset = _downloadOffset;
         request.hdr.size = 0;
 
         _sendRequest(&request);
-    } else if (!readFile) {
+    } else {
         // Streaming, so next ack should come automatically
         _setupAckTimeout();
     }
@@ -226,74 +275,118 @@ void FileManager::_createAckResponse(Request* createAck)
     _currentOperation = kCOWrite;
     _activeSession = createAck->hdr.session;
 
-    // Start the sequence of write commands from the beginning of the file
-
-    _writeOffset = 0;
-    _writeSize = 0;
-    
-    _writeFileDatablock();
+    // Start the window of write commands from the beginning of the file
+    _transferWindow.start(_uploadFile.size(), sizeof(((Request*)0)->data), _windowSize, _transferClock.elapsed());
+    _sendTransferRequests();
 }
 
 /// @brief Respond to the Ack associated with the write command.
 void FileManager::_writeAckResponse(Request* writeAck)
 {
-    if(_writeOffset + _writeSize >= _writeFileSize){
-        _closeUploadSession(true /* success */);
-    }
-
     if (writeAck->hdr.session != _activeSession) {
         _closeUploadSession(false /* failure */);
         _emitErrorMessage(tr("Write: Incorrect session returned"));
         return;
     }
 
-    if (writeAck->hdr.offset != _writeOffset) {
-        _closeUploadSession(false /* failure */);
-        _emitErrorMessage(tr("Write: Offset returned (%1) differs from offset requested (%2)").arg(writeAck->hdr.offset).arg(_writeOffset));
-        return;
-    }
-
     if (writeAck->hdr.size != sizeof(uint32_t)) {
         _closeUploadSession(false /* failure */);
         _emitErrorMessage(tr("Write: Returned invalid size of write size data"));
         return;
     }
 
-
-    if( writeAck->writeFileLength !=_writeSize) {
-        _closeUploadSession(false /* failure */);
-        _emitErrorMessage(tr("Write: Size returned (%1) differs from size requested (%2)").arg(writeAck->writeFileLength).arg(_writeSize));
+    // Writes may be acked in any order, or more than once if they were sent again
+    uint32_t writeFileLength = writeAck->writeFileLength;
+    if (!_transferWindow.received(writeAck->hdr.offset, writeFileLength, _transferClock.elapsed())) {
+        qCDebug(FileManagerLog) << QString("_writeAckResponse: ignoring duplicate offset(%1)").arg(writeAck->hdr.offset);
         return;
     }
 
-    _writeFileDatablock();
+    emit commandProgress(100 * ((float)_transferWindow.bytesTransferred() / (float)_transferWindow.fileSize()));
+
+    if (_transferWindow.complete()) {
+        _closeUploadSession(true /* success */);
+    } else {
+        _sendTransferRequests();
+    }
 }
 
-/// @brief Send next write file data block.
-void FileManager::_writeFileDatablock(void)
+/// @brief Fills the transfer window with read or write requests and sets up the timeout for the oldest one
+void FileManager::_sendTransferRequests(void)
 {
-    if (_writeOffset + _writeSize >= _writeFileSize){
-        _closeUploadSession(true /* success */);
-        return;
+    qint64 nowMsecs = _transferClock.elapsed();
+    uint32_t offset, size;
+
+    while (_transferWindow.takeRequestToSend(nowMsecs, offset, size)) {
+        Request request;
+        request.hdr.session = _activeSession;
+        request.hdr.offset = offset;
+
+        if (_currentOperation == kCORead) {
+            request.hdr.opcode = kCmdReadFile;
+            request.hdr.size = size;
+        } else {
+            request.hdr.opcode = kCmdWriteFile;
+            qint64 bytesRead = -1;
+            if (_uploadFile.seek(offset)) {
+                bytesRead = _uploadFile.read((char*)request.data, size);
+            }
+            if (bytesRead != (qint64)size) {
+                _closeUploadSession(false /* failure */);
+                _emitErrorMessage(tr("Unable to read data from local file (%1)").arg(_uploadFile.fileName()));
+                return;
+            }
+            request.hdr.size = size;
+        }
+
+        _transmitRequest(&request);
     }
 
-    _writeOffset += _writeSize;
+    int timeoutMsecs = _transferWindow.msecsToNextTimeout(nowMsecs);
+    if (timeoutMsecs != -1) {
+        _transferTimer.start(timeoutMsecs);
+    }
+}
 
-    Request request;
-    request.hdr.session = _activeSession;
-    request.hdr.opcode = kCmdWriteFile;
-    request.hdr.offset = _writeOffset;
+/// @brief Called when the oldest outstanding read or write request timed out
+void FileManager::_transferTimeout(void)
+{
+    if (_currentOperation != kCORead && _currentOperation != kCOWrite) {
+        return;
+    }
 
-    if(_writeFileSize -_writeOffset > sizeof(request.data) )
-        _writeSize = sizeof(request.data);
-    else
-        _writeSize = _writeFileSize - _writeOffset;
+    QList<uint32_t> timedOut = _transferWindow.takeTimedOut(_transferClock.elapsed());
+    qCDebug(FileManagerLog) << "_transferTimeout: offsets" << timedOut << "rto" << _transferWindow.rtoMsecs();
 
-    request.hdr.size = _writeSize;
+    if (_transferWindow.maxRetries() > maxTransferRetries) {
+        if (_currentOperation == kCORead) {
+            _closeDownloadSession(false /* failure */);
+            _emitErrorMessage(tr("Timeout waiting for ack: Download failed"));
+        } else {
+            _closeUploadSession(false /* failure */);
+            _emitErrorMessage(tr("Timeout waiting for ack: Upload failed"));
+        }
+        return;
+    }
 
-    memcpy(request.data, &_writeFileAccumulator.data()[_writeOffset], _writeSize);
+    _sendTransferRequests();
+}
 
-    _sendRequest(&request);
+/// @brief Read and write responses can still come in after their transfer ended, from requests which were sent
+/// again. Those are dropped without touching the sequence number checks.
+/// @return true: response must be ignored
+bool FileManager::_transferResponseIsStale(Request* response)
+{
+    if (response->hdr.opcode != kRspAck && response->hdr.opcode != kRspNak) {
+        return false;
+    }
+    if (response->hdr.req_opcode == kCmdReadFile) {
+        return _currentOperation != kCORead;
+    }
+    if (response->hdr.req_opcode == kCmdWriteFile) {
+        return _currentOperation != kCOWrite;
+    }
+    return false;
 }
 
 void FileManager::receiveMessage(mavlink_message_t message)
@@ -313,6 +406,11 @@ void FileManager::receiveMessage(mavlink_message_t message)
     }
     
     Request* request = (Request*)&data.payload[0];
+
+    if (_transferResponseIsStale(request)) {
+        qCDebug(FileManagerLog) << "receiveMessage: ignoring late transfer response" << request->hdr.req_opcode << request->hdr.offset;
+        return;
+    }
     
     _clearAckTimeout();
     
@@ -320,9 +418,11 @@ void FileManager::receiveMessage(mavlink_message_t message)
 	
     uint16_t incomingSeqNumber = request->hdr.seqNumber;
     
-    // Make sure we have a good sequence number
+    // Make sure we have a good sequence number. Responses within the read and write windows are matched to their
+    // request by offset instead, since several requests are in flight at once.
     uint16_t expectedSeqNumber = _lastOutgoingSeqNumber + 1;
-    if (incomingSeqNumber != expectedSeqNumber) {
+    bool windowed = _currentOperation == kCORead || _currentOperation == kCOWrite;
+    if (!windowed && incomingSeqNumber != expectedSeqNumber) {
         switch (_currentOperation) {
             case kCOBurst:
             case kCORead:
@@ -352,7 +452,9 @@ void FileManager::receiveMessage(mavlink_message_t message)
     }
     
     // Move past the incoming sequence number for next request
-    _lastOutgoingSeqNumber = incomingSeqNumber;
+    if (!windowed) {
+        _lastOutgoingSeqNumber = incomingSeqNumber;
+    }
 
     if (request->hdr.opcode == kRspAck) {
         switch (request->hdr.req_opcode) {
@@ -392,13 +494,29 @@ void FileManager::receiveMessage(mavlink_message_t message)
         // Nak's normally have 1 byte of data for error code, except for kErrFailErrno which has additional byte for errno
         Q_ASSERT((errorCode == kErrFailErrno && request->hdr.size == 2) || request->hdr.size == 1);
         
+        if (request->hdr.req_opcode == kCmdReadFile) {
+            if (errorCode == kErrEOF) {
+                // End of a file of unknown size. For a file of known size the reads never go past its end.
+                bool success = _transferWindow.fileSize() == 0 || _transferWindow.complete();
+                _closeDownloadSession(success);
+                if (!success) {
+                    _emitErrorMessage(tr("Download: File is shorter than its reported size"));
+                }
+            } else {
+                // Any other error fails the whole window, the partial file is closed and removed
+                _closeDownloadSession(false /* failure */);
+                _emitErrorMessage(tr("Download: Nak received, error: %1").arg(errorString(errorCode)));
+            }
+            return;
+        }
+
         _currentOperation = kCOIdle;
 
         if (request->hdr.req_opcode == kCmdListDirectory && errorCode == kErrEOF) {
             // This is not an error, just the end of the list loop
             emit commandComplete();
             return;
-        } else if ((request->hdr.req_opcode == kCmdReadFile || request->hdr.req_opcode == kCmdBurstReadFile) && errorCode == kErrEOF) {
+        } else if (request->hdr.req_opcode == kCmdBurstReadFile && errorCode == kErrEOF) {
             // This is not an error, just the end of the download loop
             _closeDownloadSession(true /* success */);
             return;
@@ -407,7 +525,7 @@ void FileManager::receiveMessage(mavlink_message_t message)
             return;
         } else {
             // Generic Nak handling
-            if (request->hdr.req_opcode == kCmdReadFile || request->hdr.req_opcode == kCmdBurstReadFile) {
+            if (request->hdr.req_opcode == kCmdBurstReadFile) {
                 // Nak error during download loop, download failed
                 _closeDownloadSession(false /* failure */);
             } else if (request->hdr.req_opcode == kCmdWriteFile) {
@@ -556,18 +674,17 @@ void FileManager::uploadPath(const QString& toPath, const QFileInfo& uploadFile)
         return;
     }
 
-    QFile file(uploadFile.absoluteFilePath());
-    if (!file.open(QIODevice::ReadOnly)) {
-            _emitErrorMessage(tr("Unable to open local file for upload (%1)").arg(uploadFile.absoluteFilePath()));
-            return;
-        }
-
-    _writeFileAccumulator = file.readAll();
-    _writeFileSize = _writeFileAccumulator.size();
-
-    file.close();
+    // The file is read a chunk at a time as the writes go out. A previous upload which failed before its session was
+    // created may have left it open.
+    _uploadFile.close();
+    _uploadFile.setFileName(uploadFile.absoluteFilePath());
+    if (!_uploadFile.open(QIODevice::ReadOnly)) {
+        _emitErrorMessage(tr("Unable to open local file for upload (%1)").arg(uploadFile.absoluteFilePath()));
+        return;
+    }
 
-    if (_writeFileAccumulator.size() == 0) {
+    if (_uploadFile.size() == 0) {
+        _uploadFile.close();
         _emitErrorMessage(tr("Unable to read data from local file (%1)").arg(uploadFile.absoluteFilePath()));
         return;
     }
@@ -714,14 +831,19 @@ void FileManager::_emitListEntry(const QString& entry)
     emit listEntry(entry);
 }
 
-/// @brief Sends the specified Request out to the UAS.
+/// @brief Sends the specified Request out to the UAS and waits for its ack.
 void FileManager::_sendRequest(Request* request)
 {
+    _setupAckTimeout();
+    _transmitRequest(request);
+}
 
+/// @brief Sends the specified Request out to the UAS. Read and write requests of a transfer window are timed out by
+/// the window instead of the ack timer.
+void FileManager::_transmitRequest(Request* request)
+{
     mavlink_message_t message;
 
-    _setupAckTimeout();
-    
     _lastOutgoingSeqNumber++;
 
     request->hdr.seqNumber = _lastOutgoingSeqNumber;
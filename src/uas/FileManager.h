@@ -14,9 +14,12 @@
 #include <QObject>
 #include <QDir>
 #include <QTimer>
+#include <QFile>
+#include <QElapsedTimer>
 
 #include "UASInterface.h"
 #include "QGCLoggingCategory.h"
+#include "FileTransferWindow.h"
 
 Q_DECLARE_LOGGING_CATEGORY(FileManagerLog)
 
@@ -37,6 +40,16 @@ public:
     /// for the FileManager to timeout.
     static const int ackTimerTimeoutMsecs = 10000;
 
+    /// Number of times a read or write request is sent again before the transfer fails
+    static const int maxTransferRetries = 5;
+
+    /// Maximum number of read or write requests in flight during downloadPath and uploadPath
+    int windowSize(void) const { return _windowSize; }
+    void setWindowSize(int windowSize) { _windowSize = qBound(1, windowSize, (int)FileTransferWindow::maxWindowSize); }
+
+    /// Window of the current or last downloadPath/uploadPath transfer, for its throughput and round trip statistics
+    const FileTransferWindow& transferWindow(void) const { return _transferWindow; }
+
 	/// Downloads the specified file.
 	///     @param from File to download from UAS, fully qualified path
 	///     @param downloadDir Local directory to download file to
@@ -78,6 +91,7 @@ public slots:
 	
 private slots:
 	void _ackTimeout(void);
+    void _transferTimeout(void);
 
 private:
     /// @brief This is the fixed length portion of the protocol data. Trying to pack structures across differing compilers is
@@ -172,13 +186,15 @@ private:
     void _emitErrorMessage(const QString& msg);
     void _emitListEntry(const QString& entry);
     void _sendRequest(Request* request);
+    void _transmitRequest(Request* request);
+    void _sendTransferRequests(void);
+    bool _transferResponseIsStale(Request* response);
     void _fillRequestWithString(Request* request, const QString& str);
     void _openAckResponse(Request* openAck);
     void _downloadAckResponse(Request* readAck, bool readFile);
     void _listAckResponse(Request* listAck);
     void _createAckResponse(Request* createAck);
     void _writeAckResponse(Request* writeAck);
-    void _writeFileDatablock(void);
     void _sendListCommand(void);
     void _sendResetCommand(void);
     void _closeDownloadSession(bool success);
@@ -200,19 +216,19 @@ private:
     
     uint8_t     _activeSession;             ///< currently active session, 0 for none
     
-    uint32_t    _readOffset;                ///< current read offset
+    QFile       _uploadFile;                ///< File being uploaded, read a chunk at a time
     
-    uint32_t    _writeOffset;               ///< current write offset
-    uint32_t    _writeSize;                 ///< current write data size
-    uint32_t    _writeFileSize;             ///< Size of file being uploaded
-    QByteArray  _writeFileAccumulator;      ///< Holds file being uploaded
-    
-    uint32_t    _downloadOffset;            ///< current download offset
-    QByteArray  _readFileAccumulator;       ///< Holds file being downloaded
+    uint32_t    _downloadOffset;            ///< current burst download offset
+    QFile       _downloadFile;              ///< File being downloaded, written as chunks come in
     QDir        _readFileDownloadDir;       ///< Directory to download file to
     QString     _readFileDownloadFilename;  ///< Filename (no path) for download file
     uint32_t    _downloadFileSize;          ///< Size of file being downloaded
 
+    FileTransferWindow  _transferWindow;    ///< Outstanding read/write requests of the current transfer
+    int                 _windowSize;
+    QTimer              _transferTimer;     ///< Fires when the next outstanding read/write request times out
+    QElapsedTimer       _transferClock;
+
     uint8_t     _systemIdQGC;               ///< System ID for QGC
     uint8_t     _systemIdServer;            ///< System ID for server
     
@@ -0,0 +1,203 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+
+#include "FileTransferWindow.h"
+
+#include <QtGlobal>
+
+FileTransferWindow::FileTransferWindow(void)
+    : _fileSize(0)
+    , _chunkSize(1)
+    , _windowSize(defaultWindowSize)
+    , _nextOffset(0)
+    , _bytesTransferred(0)
+    , _startMsecs(0)
+    , _srttMsecs(-1)
+    , _rttVarMsecs(0)
+    , _rtoMsecs(initialRtoMsecs)
+    , _retransmitCount(0)
+{
+
+}
+
+void FileTransferWindow::start(uint32_t fileSize, uint32_t chunkSize, int windowSize, qint64 nowMsecs)
+{
+    _outstanding.clear();
+    _missing.clear();
+    _retries.clear();
+
+    _fileSize = fileSize;
+    _chunkSize = qMax(chunkSize, (uint32_t)1);
+    // Without a size the end of the file is only found by reading past it, one chunk at a time
+    _windowSize = fileSize ? qBound(1, windowSize, (int)maxWindowSize) : 1;
+    _nextOffset = 0;
+    _bytesTransferred = 0;
+    _startMsecs = nowMsecs;
+    _srttMsecs = -1;
+    _rttVarMsecs = 0;
+    _rtoMsecs = initialRtoMsecs;
+    _retransmitCount = 0;
+}
+
+bool FileTransferWindow::takeRequestToSend(qint64 nowMsecs, uint32_t& offset, uint32_t& size)
+{
+    if (_outstanding.count() >= _windowSize) {
+        return false;
+    }
+
+    Outstanding_t outstanding;
+    if (!_missing.isEmpty()) {
+        Range range = _missing.takeFirst();
+        offset = range.first;
+        size = range.second;
+        outstanding.retry = _retries.contains(offset);
+    } else if (_fileSize) {
+        if (_nextOffset >= _fileSize) {
+            return false;
+        }
+        offset = _nextOffset;
+        size = qMin(_chunkSize, _fileSize - _nextOffset);
+        _nextOffset += size;
+        outstanding.retry = false;
+    } else {
+        // Unknown size: _nextOffset moves on with each response instead
+        offset = _nextOffset;
+        size = _chunkSize;
+        outstanding.retry = false;
+    }
+
+    outstanding.size = size;
+    outstanding.sentMsecs = nowMsecs;
+    _outstanding[offset] = outstanding;
+
+    return true;
+}
+
+bool FileTransferWindow::received(uint32_t offset, uint32_t& size, qint64 nowMsecs)
+{
+    QMap<uint32_t, Outstanding_t>::iterator it = _outstanding.find(offset);
+    if (it == _outstanding.end()) {
+        return false;
+    }
+    Outstanding_t outstanding = it.value();
+    _outstanding.erase(it);
+
+    // Karn's algorithm: a response to a retried request could belong to any of the sends
+    if (!outstanding.retry) {
+        _rttSample(nowMsecs - outstanding.sentMsecs);
+    }
+
+    size = qMin(size, outstanding.size);
+
+    if (!_fileSize) {
+        _bytesTransferred += size;
+        _nextOffset = offset + size;
+        if (size) {
+            _retries.remove(offset);
+        } else {
+            _retries[offset]++;
+        }
+        return true;
+    }
+
+    _bytesTransferred += size;
+
+    if (size < outstanding.size) {
+        // Short response, ask for the rest of the chunk next. A response without any data counts as a retry so a server
+        // which keeps doing that fails the transfer instead of stalling it.
+        Range rest(offset + size, outstanding.size - size);
+        if (size == 0) {
+            _retries[offset]++;
+        }
+        _missing.prepend(rest);
+    }
+    if (size) {
+        _retries.remove(offset);
+    }
+
+    return true;
+}
+
+QList<uint32_t> FileTransferWindow::takeTimedOut(qint64 nowMsecs)
+{
+    QList<uint32_t> timedOut;
+    QList<Range> ranges;
+
+    QMap<uint32_t, Outstanding_t>::iterator it = _outstanding.begin();
+    while (it != _outstanding.end()) {
+        if (nowMsecs - it.value().sentMsecs >= _rtoMsecs) {
+            timedOut.append(it.key());
+            ranges.append(Range(it.key(), it.value().size));
+            _retries[it.key()]++;
+            it = _outstanding.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    if (timedOut.count()) {
+        // Lost ranges go out again first, in file order
+        _missing = ranges + _missing;
+        _retransmitCount += timedOut.count();
+        // One back off per timeout round, however many requests were lost in it
+        _rtoMsecs = qMin(_rtoMsecs * 2, (int)maxRtoMsecs);
+    }
+
+    return timedOut;
+}
+
+int FileTransferWindow::msecsToNextTimeout(qint64 nowMsecs) const
+{
+    if (_outstanding.isEmpty()) {
+        return -1;
+    }
+
+    qint64 oldestSentMsecs = nowMsecs;
+    foreach (const Outstanding_t& outstanding, _outstanding) {
+        oldestSentMsecs = qMin(oldestSentMsecs, outstanding.sentMsecs);
+    }
+
+    return (int)qMax(oldestSentMsecs + _rtoMsecs - nowMsecs, (qint64)0);
+}
+
+bool FileTransferWindow::complete(void) const
+{
+    return _fileSize && _bytesTransferred >= _fileSize && _outstanding.isEmpty() && _missing.isEmpty();
+}
+
+int FileTransferWindow::maxRetries(void) const
+{
+    int retries = 0;
+    foreach (int count, _retries) {
+        retries = qMax(retries, count);
+    }
+    return retries;
+}
+
+double FileTransferWindow::bytesPerSecond(qint64 nowMsecs) const
+{
+    qint64 elapsedMsecs = qMax(nowMsecs - _startMsecs, (qint64)1);
+    return (double)_bytesTransferred * 1000.0 / (double)elapsedMsecs;
+}
+
+void FileTransferWindow::_rttSample(int rttMsecs)
+{
+    rttMsecs = qMax(rttMsecs, 0);
+
+    if (_srttMsecs == -1) {
+        _srttMsecs = rttMsecs;
+        _rttVarMsecs = rttMsecs / 2;
+    } else {
+        _rttVarMsecs = ((3 * _rttVarMsecs) + qAbs(_srttMsecs - rttMsecs)) / 4;
+        _srttMsecs = ((7 * _srttMsecs) + rttMsecs) / 8;
+    }
+
+    _rtoMsecs = qBound((int)minRtoMsecs, _srttMsecs + (4 * _rttVarMsecs), (int)maxRtoMsecs);
+}
@@ -0,0 +1,110 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+
+#ifndef FileTransferWindow_H
+#define FileTransferWindow_H
+
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QPair>
+
+#include <stdint.h>
+
+/// Window of in flight read or write requests for a MAVLink FTP transfer, as used by FileManager.
+///
+/// Instead of sending the request for the next chunk only once the previous one was acked, requests for up to window
+/// size chunks are kept outstanding. Responses may come back in any order and are matched to their request by file
+/// offset. Requests which time out, and the part of a chunk a short response left out, are queued to be sent again
+/// ahead of new chunks, so only missing ranges are retransmitted. The request timeout is derived from the measured
+/// round trip time the same way TCP does it (RFC 6298).
+///
+/// For a file of unknown size the transfer falls back to one chunk at a time, each one following the last response,
+/// until the server reports end of file.
+///
+/// The window does not send anything or keep time itself. The caller passes in the current time and sends the requests
+/// it is handed.
+class FileTransferWindow
+{
+public:
+    FileTransferWindow(void);
+
+    /// Starts a new transfer
+    ///     @param fileSize Size of the file, 0 if not known
+    ///     @param chunkSize Maximum data size of a single request
+    ///     @param windowSize Maximum number of outstanding requests
+    void start(uint32_t fileSize, uint32_t chunkSize, int windowSize, qint64 nowMsecs);
+
+    /// @return true: offset and size are set to the next request to send, which is outstanding from here on
+    bool takeRequestToSend(qint64 nowMsecs, uint32_t& offset, uint32_t& size);
+
+    /// Called for every response
+    ///     @param size Number of bytes read or written, clamped to the size which was requested on return
+    /// @return false: request is not outstanding, response is a duplicate and must be ignored
+    bool received(uint32_t offset, uint32_t& size, qint64 nowMsecs);
+
+    /// @return Offsets of outstanding requests which timed out, these are queued to be sent again
+    QList<uint32_t> takeTimedOut(qint64 nowMsecs);
+
+    /// @return Msecs until the next outstanding request times out, -1 if there are none
+    int msecsToNextTimeout(qint64 nowMsecs) const;
+
+    /// @return true: all of a file of known size was transferred
+    bool complete(void) const;
+
+    /// @return Highest number of times any single range was sent again without getting a response
+    int maxRetries(void) const;
+
+    /// Average transfer rate since start
+    double bytesPerSecond(qint64 nowMsecs) const;
+
+    uint32_t fileSize(void) const           { return _fileSize; }
+    uint32_t bytesTransferred(void) const   { return _bytesTransferred; }
+    int outstandingCount(void) const        { return _outstanding.count(); }
+    int missingCount(void) const            { return _missing.count(); }
+    int windowSize(void) const              { return _windowSize; }
+    int rttMsecs(void) const                { return _srttMsecs; }          ///< Smoothed round trip, -1 if not measured yet
+    int rtoMsecs(void) const                { return _rtoMsecs; }           ///< Current request timeout
+    int retransmitCount(void) const         { return _retransmitCount; }    ///< Requests which were sent again
+
+    static const int defaultWindowSize =    8;
+    static const int maxWindowSize =        64;
+    static const int initialRtoMsecs =      1000;
+    static const int minRtoMsecs =          100;
+    static const int maxRtoMsecs =          5000;
+
+private:
+    void _rttSample(int rttMsecs);
+
+    typedef struct {
+        uint32_t    size;
+        qint64      sentMsecs;
+        bool        retry;
+    } Outstanding_t;
+
+    typedef QPair<uint32_t, uint32_t> Range;    ///< Offset, size
+
+    QMap<uint32_t, Outstanding_t>   _outstanding;   ///< Key is offset
+    QList<Range>                    _missing;       ///< Ranges to send again, in send order
+    QHash<uint32_t, int>            _retries;       ///< Retry count of ranges which were sent again, by offset
+
+    uint32_t    _fileSize;
+    uint32_t    _chunkSize;
+    int         _windowSize;
+    uint32_t    _nextOffset;        ///< Start of the part of the file no request was sent for yet
+    uint32_t    _bytesTransferred;
+    qint64      _startMsecs;
+    int         _srttMsecs;
+    int         _rttVarMsecs;
+    int         _rtoMsecs;
+    int         _retransmitCount;
+};
+
+#endif
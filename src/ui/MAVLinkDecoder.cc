@@ -1,5 +1,6 @@
 #include "QGCMAVLink.h"
 #include "MAVLinkDecoder.h"
+#include "QGC.h"
 
 #include <QDebug>
 
@@ -45,13 +46,18 @@ MAVLinkDecoder::MAVLinkDecoder(MAVLinkProtocol* protocol, QObject *parent) :
     #endif
     messageFilter.insert(MAVLINK_MSG_ID_FILE_TRANSFER_PROTOCOL, false);
 
+    valueChangedSignal = QMetaMethod::fromSignal(&MAVLinkDecoder::valueChanged);
+    textMessageReceivedSignal = QMetaMethod::fromSignal(&MAVLinkDecoder::textMessageReceived);
+
     textMessageFilter.insert(MAVLINK_MSG_ID_DEBUG, false);
     textMessageFilter.insert(MAVLINK_MSG_ID_DEBUG_VECT, false);
     textMessageFilter.insert(MAVLINK_MSG_ID_NAMED_VALUE_FLOAT, false);
     textMessageFilter.insert(MAVLINK_MSG_ID_NAMED_VALUE_INT, false);
 //    textMessageFilter.insert(MAVLINK_MSG_ID_HIGHRES_IMU, false);
 
-    connect(protocol, &MAVLinkProtocol::messageReceived, this, &MAVLinkDecoder::receiveMessage);
+    // The decoder lives on its own thread so messages are queued across to it
+    protocol->messageDispatcher()->subscribe(MAVLinkMessageDispatcher::anyId, MAVLinkMessageDispatcher::anyId, MAVLinkMessageDispatcher::anyId,
+                                             this, &MAVLinkDecoder::receiveMessage);
 
     start(LowPriority);
 }
@@ -110,10 +116,33 @@ void MAVLinkDecoder::receiveMessage(LinkInterface* link,mavlink_message_t messag
     // Align UAS time to global time
     time = getUnixTimeFromMs(message.sysid, time);
 
+    // Store component ID
+    if (componentID[msgid] == -1)
+    {
+        componentID[msgid] = message.compid;
+    }
+    else
+    {
+        // Got this message already
+        if (componentID[msgid] != message.compid)
+        {
+            componentMulti[msgid] = true;
+        }
+    }
+
+    // The line charts read the values from the store. Building the string based
+    // values is only worth it if someone is listening for them.
+    bool emitValues = isSignalConnected(valueChangedSignal) || isSignalConnected(textMessageReceivedSignal);
+    quint64 groundTime = QGC::groundTimeMilliseconds();
+
     // Send out all field values for this message
     for (unsigned int i = 0; i < msgInfo->num_fields; ++i)
     {
-        emitFieldValue(&message, i, time);
+        storeFieldValue(&message, i, time, groundTime);
+        if (emitValues)
+        {
+            emitFieldValue(&message, i, time);
+        }
     }
 
     // Send out combined math expressions
@@ -198,35 +227,13 @@ quint64 MAVLinkDecoder::getUnixTimeFromMs(int systemID, quint64 time)
     return ret;
 }
 
-void MAVLinkDecoder::emitFieldValue(mavlink_message_t* msg, int fieldid, quint64 time)
+QString MAVLinkDecoder::curveName(mavlink_message_t* msg, int fieldid, quint64* time)
 {
-    bool multiComponentSourceDetected = false;
+    bool multiComponentSourceDetected = componentMulti[msg->msgid];
     const mavlink_message_info_t* msgInfo = mavlink_get_message_info(msg);
-
-    // Store component ID
-    if (componentID[msg->msgid] == -1)
-    {
-        componentID[msg->msgid] = msg->compid;
-    }
-    else
-    {
-        // Got this message already
-        if (componentID[msg->msgid] != msg->compid)
-        {
-            componentMulti[msg->msgid] = true;
-        }
-    }
-
-    if (componentMulti[msg->msgid] == true) multiComponentSourceDetected = true;
-
-    // Add field tree widget item
     uint8_t msgid = msg->msgid;
-    if (messageFilter.contains(msgid)) return;
     QString fieldName(msgInfo->fields[fieldid].name);
-    QString fieldType;
-    uint8_t* m = (uint8_t*)&((mavlink_message_t*)(receivedMessages+msgid))->payload64[0];
     QString name("%1.%2");
-    QString unit("");
 
     // Debug vector messages
     if (msgid == MAVLINK_MSG_ID_DEBUG_VECT)
@@ -237,14 +244,14 @@ void MAVLinkDecoder::emitFieldValue(mavlink_message_t* msg, int fieldid, quint64
         strncpy(buf, debug.name, 10);
         buf[10] = '\0';
         name = QString("%1.%2").arg(buf).arg(fieldName);
-        time = getUnixTimeFromMs(msg->sysid, (debug.time_usec+500)/1000); // Scale to milliseconds, round up/down correctly
+        *time = getUnixTimeFromMs(msg->sysid, (debug.time_usec+500)/1000); // Scale to milliseconds, round up/down correctly
     }
     else if (msgid == MAVLINK_MSG_ID_DEBUG)
     {
         mavlink_debug_t debug;
         mavlink_msg_debug_decode(msg, &debug);
         name = name.arg(QString("debug")).arg(debug.ind);
-        time = getUnixTimeFromMs(msg->sysid, debug.time_boot_ms);
+        *time = getUnixTimeFromMs(msg->sysid, debug.time_boot_ms);
     }
     else if (msgid == MAVLINK_MSG_ID_NAMED_VALUE_FLOAT)
     {
@@ -254,7 +261,7 @@ void MAVLinkDecoder::emitFieldValue(mavlink_message_t* msg, int fieldid, quint64
         strncpy(buf, debug.name, 10);
         buf[10] = '\0';
         name = QString(buf);
-        time = getUnixTimeFromMs(msg->sysid, debug.time_boot_ms);
+        *time = getUnixTimeFromMs(msg->sysid, debug.time_boot_ms);
     }
     else if (msgid == MAVLINK_MSG_ID_NAMED_VALUE_INT)
     {
@@ -264,7 +271,7 @@ void MAVLinkDecoder::emitFieldValue(mavlink_message_t* msg, int fieldid, quint64
         strncpy(buf, debug.name, 10);
         buf[10] = '\0';
         name = QString(buf);
-        time = getUnixTimeFromMs(msg->sysid, debug.time_boot_ms);
+        *time = getUnixTimeFromMs(msg->sysid, debug.time_boot_ms);
     }
     else if (msgid == MAVLINK_MSG_ID_RC_CHANNELS_RAW)
     {
@@ -302,6 +309,21 @@ void MAVLinkDecoder::emitFieldValue(mavlink_message_t* msg, int fieldid, quint64
 
     name = name.prepend(QString("M%1:").arg(msg->sysid));
 
+    return name;
+}
+
+void MAVLinkDecoder::emitFieldValue(mavlink_message_t* msg, int fieldid, quint64 time)
+{
+    const mavlink_message_info_t* msgInfo = mavlink_get_message_info(msg);
+
+    // Add field tree widget item
+    uint8_t msgid = msg->msgid;
+    if (messageFilter.contains(msgid)) return;
+    QString fieldType;
+    uint8_t* m = (uint8_t*)&((mavlink_message_t*)(receivedMessages+msgid))->payload64[0];
+    QString name = curveName(msg, fieldid, &time);
+    QString unit("");
+
     switch (msgInfo->fields[fieldid].type)
     {
     case MAVLINK_TYPE_CHAR:
@@ -505,3 +527,144 @@ void MAVLinkDecoder::emitFieldValue(mavlink_message_t* msg, int fieldid, quint64
         qDebug() << "WARNING: UNKNOWN MAVLINK TYPE";
     }
 }
+
+void MAVLinkDecoder::storeFieldValue(mavlink_message_t* msg, int fieldid, quint64 time, quint64 groundTime)
+{
+    uint8_t msgid = msg->msgid;
+    if (messageFilter.contains(msgid)) return;
+
+    const mavlink_message_info_t* msgInfo = mavlink_get_message_info(msg);
+    const mavlink_field_info_t& field = msgInfo->fields[fieldid];
+
+    // Strings go out as text messages, there is nothing to plot
+    if (field.type == MAVLINK_TYPE_CHAR && field.array_length > 0) return;
+
+    const uint8_t* m = (const uint8_t*)&receivedMessages[msgid].payload64[0];
+    unsigned int valueCount = field.array_length > 0 ? field.array_length : 1;
+    bool integerValued = field.type != MAVLINK_TYPE_FLOAT && field.type != MAVLINK_TYPE_DOUBLE;
+
+    // The curve name of debug and named value messages comes from the message contents. These
+    // are low rate, so the name is built every time and used as the key.
+    bool namedValue = msgid == MAVLINK_MSG_ID_DEBUG_VECT || msgid == MAVLINK_MSG_ID_DEBUG ||
+            msgid == MAVLINK_MSG_ID_NAMED_VALUE_FLOAT || msgid == MAVLINK_MSG_ID_NAMED_VALUE_INT;
+
+    QString name;
+    quint64 fieldKey = 0;
+    if (namedValue)
+    {
+        name = curveName(msg, fieldid, &time);
+    }
+    else
+    {
+        // All other curves are keyed by everything which goes into the curve name:
+        // bits 0-7 sysid, 8-15 compid, 16 multi component flag, 17-24 msgid, 25-32 fieldid, 33-40 port, 41-48 array index
+        quint64 port = 0;
+        if (msgid == MAVLINK_MSG_ID_RC_CHANNELS_SCALED)
+        {
+            port = mavlink_msg_rc_channels_scaled_get_port(msg);
+        }
+        else if (msgid == MAVLINK_MSG_ID_SERVO_OUTPUT_RAW)
+        {
+            port = mavlink_msg_servo_output_raw_get_port(msg);
+        }
+        quint64 multi = componentMulti[msgid] ? 1 : 0;
+        quint64 compid = multi ? msg->compid : 0;
+        fieldKey = (quint64)msg->sysid | (compid << 8) | (multi << 16) | ((quint64)msgid << 17) | ((quint64)fieldid << 25) | (port << 33);
+    }
+
+    for (unsigned int j = 0; j < valueCount; ++j)
+    {
+        int curveId;
+
+        if (namedValue)
+        {
+            QString valueName = field.array_length > 0 ? QString("%1.%2").arg(name).arg(j) : name;
+            QString unit = fieldUnit(field);
+            QHash<QString, int>::const_iterator iter = namedCurveIds.constFind(valueName + unit);
+            if (iter == namedCurveIds.constEnd())
+            {
+                curveId = store.addCurve(msg->sysid, valueName, unit, integerValued);
+                namedCurveIds.insert(valueName + unit, curveId);
+            }
+            else
+            {
+                curveId = iter.value();
+            }
+        }
+        else
+        {
+            quint64 key = fieldKey | ((quint64)j << 41);
+            QHash<quint64, int>::const_iterator iter = fieldCurveIds.constFind(key);
+            if (iter == fieldCurveIds.constEnd())
+            {
+                // First value for this field, intern the curve
+                quint64 nameTime = time;
+                QString valueName = curveName(msg, fieldid, &nameTime);
+                if (field.array_length > 0)
+                {
+                    valueName = QString("%1.%2").arg(valueName).arg(j);
+                }
+                curveId = store.addCurve(msg->sysid, valueName, fieldUnit(field), integerValued);
+                fieldCurveIds.insert(key, curveId);
+            }
+            else
+            {
+                curveId = iter.value();
+            }
+        }
+
+        if (curveId != -1)
+        {
+            store.append(curveId, time, groundTime, fieldValue(m, field, j));
+        }
+    }
+}
+
+QString MAVLinkDecoder::fieldUnit(const mavlink_field_info_t& field)
+{
+    static const char* rgTypeNames[] = { "char", "uint8_t", "int8_t", "uint16_t", "int16_t", "uint32_t", "int32_t", "uint64_t", "int64_t", "float", "double" };
+
+    QString typeName;
+    if (field.type < sizeof(rgTypeNames) / sizeof(rgTypeNames[0]))
+    {
+        typeName = rgTypeNames[field.type];
+    }
+    if (field.array_length > 0)
+    {
+        return QString("%1[%2]").arg(typeName).arg(field.array_length);
+    }
+    return typeName;
+}
+
+double MAVLinkDecoder::fieldValue(const uint8_t* payload, const mavlink_field_info_t& field, unsigned int index)
+{
+    const uint8_t* p = payload + field.wire_offset;
+
+    switch (field.type)
+    {
+    case MAVLINK_TYPE_CHAR:
+        return ((const char*)p)[index];
+    case MAVLINK_TYPE_UINT8_T:
+        return ((const uint8_t*)p)[index];
+    case MAVLINK_TYPE_INT8_T:
+        return ((const int8_t*)p)[index];
+    case MAVLINK_TYPE_UINT16_T:
+        return ((const uint16_t*)p)[index];
+    case MAVLINK_TYPE_INT16_T:
+        return ((const int16_t*)p)[index];
+    case MAVLINK_TYPE_UINT32_T:
+        return ((const uint32_t*)p)[index];
+    case MAVLINK_TYPE_INT32_T:
+        return ((const int32_t*)p)[index];
+    case MAVLINK_TYPE_FLOAT:
+        return ((const float*)p)[index];
+    case MAVLINK_TYPE_DOUBLE:
+        return ((const double*)p)[index];
+    case MAVLINK_TYPE_UINT64_T:
+        return ((const uint64_t*)p)[index];
+    case MAVLINK_TYPE_INT64_T:
+        return ((const int64_t*)p)[index];
+    default:
+        return 0;
+    }
+}
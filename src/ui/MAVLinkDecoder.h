@@ -2,7 +2,10 @@
 #define MAVLINKDECODER_H
 
 #include <QObject>
+#include <QHash>
+#include <QMetaMethod>
 #include "MAVLinkProtocol.h"
+#include "TimeSeriesStore.h"
 
 class MAVLinkDecoder : public QThread
 {
@@ -12,6 +15,9 @@ public:
 
     void run();
 
+    /** @brief Store which holds the decoded field values for plotting */
+    TimeSeriesStore* timeSeriesStore() { return &store; }
+
 signals:
     void textMessageReceived(int uasid, int componentid, int severity, const QString& text);
     void valueChanged(const int uasId, const QString& name, const QString& unit, const QVariant& value, const quint64 msec);
@@ -22,6 +28,14 @@ public slots:
 protected:
     /** @brief Emit the value of one message field */
     void emitFieldValue(mavlink_message_t* msg, int fieldid, quint64 time);
+    /** @brief Append the value(s) of one message field to the time series store */
+    void storeFieldValue(mavlink_message_t* msg, int fieldid, quint64 time, quint64 groundTime);
+    /** @brief Build the curve name of one message field, debug messages also update the time */
+    QString curveName(mavlink_message_t* msg, int fieldid, quint64* time);
+    /** @brief Unit string of a message field, this is the field type */
+    static QString fieldUnit(const mavlink_field_info_t& field);
+    /** @brief Get one value of a message field as a double */
+    static double fieldValue(const uint8_t* payload, const mavlink_field_info_t& field, unsigned int index);
     /** @brief Shift a timestamp in Unix time if necessary */
     quint64 getUnixTimeFromMs(int systemID, quint64 time);
 
@@ -35,6 +49,12 @@ protected:
     quint64 onboardTimeOffset[cMessageIds];                 ///< Offset of onboard time from Unix epoch (of the receiving GCS)
     qint64 onboardToGCSUnixTimeOffsetAndDelay[cMessageIds]; ///< Offset of onboard time and GCS Unix time
     quint64 firstOnboardTime[cMessageIds];                  ///< First seen onboard time
+
+    TimeSeriesStore store;                                  ///< Decoded field values
+    QHash<quint64, int> fieldCurveIds;                      ///< Field key to store curve id, see storeFieldValue
+    QHash<QString, int> namedCurveIds;                      ///< Curve name + unit to store curve id for debug/named value messages
+    QMetaMethod valueChangedSignal;
+    QMetaMethod textMessageReceivedSignal;
 };
 
 #endif // MAVLINKDECODER_H
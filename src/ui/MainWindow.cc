@@ -291,8 +291,9 @@ void MainWindow::_buildCommonWidgets(void)
 {
     // Add generic MAVLink decoder
     // TODO: This is never deleted
+    // The decoder only builds string based values while someone is connected to valueChanged, so it
+    // is not relayed here. The line charts read the decoded values from its time series store.
     mavlinkDecoder = new MAVLinkDecoder(qgcApp()->toolbox()->mavlinkProtocol(), this);
-    connect(mavlinkDecoder.data(), &MAVLinkDecoder::valueChanged, this, &MainWindow::valueChanged);
 
     // Log player
     // TODO: Make this optional with a preferences setting or under a "View" menu
@@ -42,7 +42,8 @@ QGCMAVLinkInspector::QGCMAVLinkInspector(const QString& title, QAction* action,
 
     // Connect external connections
     connect(qgcApp()->toolbox()->multiVehicleManager(), &MultiVehicleManager::vehicleAdded, this, &QGCMAVLinkInspector::_vehicleAdded);
-    connect(protocol, &MAVLinkProtocol::messageReceived, this, &QGCMAVLinkInspector::receiveMessage);
+    protocol->messageDispatcher()->subscribe(MAVLinkMessageDispatcher::anyId, MAVLinkMessageDispatcher::anyId, MAVLinkMessageDispatcher::anyId,
+                                             this, &QGCMAVLinkInspector::receiveMessage);
 
     // Attach the UI's refresh rate to a timer.
     connect(&updateTimer, &QTimer::timeout, this, &QGCMAVLinkInspector::refreshView);
@@ -26,6 +26,7 @@ QGCMAVLinkLogPlayer::QGCMAVLinkLogPlayer(QWidget *parent) :
     connect(_ui->playButton, &QPushButton::clicked, this, &QGCMAVLinkLogPlayer::_playPauseToggle);
     connect(_ui->positionSlider, &QSlider::valueChanged, this, &QGCMAVLinkLogPlayer::_setPlayheadFromSlider);
     connect(_ui->positionSlider, &QSlider::sliderPressed, this, &QGCMAVLinkLogPlayer::_pause);
+    connect(_ui->maxSpeedCheckBox, &QCheckBox::toggled, this, &QGCMAVLinkLogPlayer::_setMaxSpeed);
 
 #if 0
     // Speed slider is removed from 3.0 release. Too broken to fix.
@@ -100,6 +101,7 @@ void QGCMAVLinkLogPlayer::_selectLogFileForPlayback(void)
 #if 0
     _ui->speedSlider->setValue(0);
 #endif
+    _ui->maxSpeedCheckBox->setChecked(false);
 }
 
 void QGCMAVLinkLogPlayer::_playbackError(void)
@@ -161,6 +163,13 @@ void QGCMAVLinkLogPlayer::_setPlayheadFromSlider(int value)
     }
 }
 
+void QGCMAVLinkLogPlayer::_setMaxSpeed(bool maxSpeed)
+{
+    if (_replayLink) {
+        _replayLink->setMaxSpeed(maxSpeed);
+    }
+}
+
 void QGCMAVLinkLogPlayer::_enablePlaybackControls(bool enabled)
 {
     _ui->playButton->setEnabled(enabled);
@@ -168,6 +177,7 @@ void QGCMAVLinkLogPlayer::_enablePlaybackControls(bool enabled)
     _ui->speedSlider->setEnabled(enabled);
 #endif
     _ui->positionSlider->setEnabled(enabled);
+    _ui->maxSpeedCheckBox->setEnabled(enabled);
 }
 
 #if 0
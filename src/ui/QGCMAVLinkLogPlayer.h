@@ -33,6 +33,7 @@ private slots:
     void _playPauseToggle(void);
     void _pause(void);
     void _setPlayheadFromSlider(int value);
+    void _setMaxSpeed(bool maxSpeed);
 #if 0
     void _setAccelerationFromSlider(int value);
 #endif
@@ -134,6 +134,9 @@ int LinechartPlot::getPlotId()
  */
 double LinechartPlot::getCurrentValue(QString id)
 {
+    if (storeData.contains(id)) {
+        return storeData.value(id)->getCurrentValue();
+    }
     return data.value(id)->getCurrentValue();
 }
 
@@ -142,6 +145,9 @@ double LinechartPlot::getCurrentValue(QString id)
  */
 double LinechartPlot::getMean(QString id)
 {
+    if (storeData.contains(id)) {
+        return storeData.value(id)->getMean(averageWindowSize);
+    }
     return data.value(id)->getMean();
 }
 
@@ -150,6 +156,10 @@ double LinechartPlot::getMean(QString id)
  */
 double LinechartPlot::getMedian(QString id)
 {
+    if (storeData.contains(id)) {
+        // Median is not calculated for store curves, same as it is no longer calculated for TimeSeriesData
+        return 0.0;
+    }
     return data.value(id)->getMedian();
 }
 
@@ -158,6 +168,9 @@ double LinechartPlot::getMedian(QString id)
  */
 double LinechartPlot::getVariance(QString id)
 {
+    if (storeData.contains(id)) {
+        return storeData.value(id)->getVariance(averageWindowSize);
+    }
     return data.value(id)->getVariance();
 }
 
@@ -275,9 +288,7 @@ void LinechartPlot::appendData(QString dataname, quint64 ms, double value)
     if (value > maxValue) maxValue = value;
     valueInterval = maxValue - minValue;
 
-    // Assign dataset to curve
-    QwtPlotCurve* curve = _curves.value(dataname);
-    curve->setRawSamples(dataset->getPlotX(), dataset->getPlotY(), dataset->getPlotCount());
+    // The samples are assigned to the curve when the plot is repainted
 
     //    qDebug() << "mintime" << minTime << "maxtime" << maxTime << "last max time" << "window position" << getWindowPosition();
 
@@ -314,7 +325,38 @@ bool LinechartPlot::groundTime()
     return m_groundTime;
 }
 
+void LinechartPlot::addStoreCurve(QString id, const TimeSeriesStore* store, int curveId)
+{
+    if (_curves.contains(id)) {
+        return;
+    }
+
+    QwtPlotCurve* curve = createCurve(id);
+
+    // The curve takes ownership of the series
+    TimeSeriesStoreSeries* series = new TimeSeriesStoreSeries(store, curveId);
+    curve->setData(series);
+    storeData.insert(id, series);
+
+    // Notify connected components about new curve
+    emit curveAdded(id);
+}
+
 void LinechartPlot::addCurve(QString id)
+{
+    createCurve(id);
+
+    // Create dataset
+    TimeSeriesData* dataset = new TimeSeriesData(this, id, maxInterval);
+
+    // Add dataset to list
+    data.insert(id, dataset);
+
+    // Notify connected components about new curve
+    emit curveAdded(id);
+}
+
+QwtPlotCurve* LinechartPlot::createCurve(QString id)
 {
     QColor currentColor = getNextColor();
 
@@ -342,14 +384,27 @@ void LinechartPlot::addCurve(QString id)
         sym.setSize(3);
         curve->setSymbol(sym);*/
 
-    // Create dataset
-    TimeSeriesData* dataset = new TimeSeriesData(this, id, this->plotInterval, maxInterval);
-
-    // Add dataset to list
-    data.insert(id, dataset);
+    return curve;
+}
 
-    // Notify connected components about new curve
-    emit curveAdded(id);
+/**
+ * @brief Update the time range of the plot from the store backed curves
+ * Data for these curves does not go through appendData, so the plot picks up
+ * the newest times here before each repaint.
+ **/
+void LinechartPlot::updateStoreTimes()
+{
+    foreach (TimeSeriesStoreSeries* series, storeData) {
+        quint64 last = series->lastTime(m_groundTime);
+        if (last == 0) {
+            continue;
+        }
+        quint64 first = series->firstTime(m_groundTime);
+        if (first < minTime || minTime == 0) minTime = first;
+        if (last > maxTime) maxTime = last;
+        if (last > lastTime) lastTime = last;
+    }
+    storageInterval = maxTime - minTime;
 }
 
 /**
@@ -574,19 +629,8 @@ quint64 LinechartPlot::getPlotInterval()
  **/
 void LinechartPlot::setPlotInterval(int interval)
 {
-    //Only ever increase the amount of stored data,
-    // so that we allow the user to change between
-    // different intervals without constantly losing
-    // data points
-    if((unsigned)interval > plotInterval) {
-
-        QMap<QString, TimeSeriesData*>::iterator j;
-        for(j = data.begin(); j != data.end(); ++j)
-        {
-            TimeSeriesData* d = data.value(j.key());
-            d->setInterval(interval);
-        }
-    }
+    // The data sets keep all data points, the plot window
+    // is selected from them on each repaint
     plotInterval = interval;
     if(plotInterval > 5*60*1000) //If the interval is longer than 4 minutes, change the time scale step to 2 minutes
         timeScaleStep = 2*60*1000;
@@ -652,6 +696,8 @@ void LinechartPlot::paintRealtime()
         qDebug() << "EVENTLOOP: (" << MG::TIME::getGroundTimeNow() - timestamp << ")" << __FILE__ << __LINE__;
         timestamp = MG::TIME::getGroundTimeNow();
 #endif
+        updateStoreTimes();
+
         // Update plot window value to new max time if the last time was also the max time
         windowLock.lock();
         if (automaticScrollActive)
@@ -679,6 +725,31 @@ void LinechartPlot::paintRealtime()
 
         windowLock.unlock();
 
+        // Point the curves at the samples in the plot window. Long windows are decimated to
+        // about one min/max pair per pixel, so repaint time does not grow with the history length.
+        double windowStart = plotPosition > plotInterval ? (double)(plotPosition - plotInterval) : 0.0;
+        double windowEnd = (double)plotPosition;
+        int maxBuckets = canvas()->width();
+
+        datalock.lock();
+        QMap<QString, TimeSeriesData*>::iterator j;
+        for (j = data.begin(); j != data.end(); ++j) {
+            QwtPlotCurve* curve = _curves.value(j.key());
+            if (curve->isVisible()) {
+                TimeSeriesData* dataset = j.value();
+                dataset->updatePlotSamples(windowStart, windowEnd, maxBuckets);
+                curve->setRawSamples(dataset->getPlotX(), dataset->getPlotY(), dataset->getPlotCount());
+            }
+        }
+        datalock.unlock();
+
+        QMap<QString, TimeSeriesStoreSeries*>::iterator k;
+        for (k = storeData.begin(); k != storeData.end(); ++k) {
+            if (_curves.value(k.key())->isVisible()) {
+                k.value()->updateWindow(windowStart, windowEnd, m_groundTime, maxBuckets);
+            }
+        }
+
         replot();
 
         /*
@@ -726,12 +797,14 @@ void LinechartPlot::removeAllData()
         // Set the pointer null
         d = NULL;
     }
+    // Store backed data was owned by the curves
+    storeData.clear();
     datalock.unlock();
     replot();
 }
 
 
-TimeSeriesData::TimeSeriesData(QwtPlot* plot, QString friendlyName, quint64 plotInterval, quint64 maxInterval, double zeroValue):
+TimeSeriesData::TimeSeriesData(QwtPlot* plot, QString friendlyName, quint64 maxInterval, double zeroValue):
     minValue(DBL_MAX),
     maxValue(DBL_MIN),
     zeroValue(0),
@@ -745,13 +818,10 @@ TimeSeriesData::TimeSeriesData(QwtPlot* plot, QString friendlyName, quint64 plot
     this->friendlyName = friendlyName;
     this->maxInterval = maxInterval;
     this->zeroValue = zeroValue;
-    this->plotInterval = plotInterval;
 
     /* initialize time */
     startTime = QUINT64_MAX;
     stopTime = QUINT64_MIN;
-
-    plotCount = 0;
 }
 
 TimeSeriesData::~TimeSeriesData()
@@ -759,11 +829,6 @@ TimeSeriesData::~TimeSeriesData()
 
 }
 
-void TimeSeriesData::setInterval(quint64 ms)
-{
-    plotInterval = ms;
-}
-
 void TimeSeriesData::setAverageWindowSize(int windowSize)
 {
     this->averageWindow = windowSize;
@@ -778,23 +843,26 @@ void TimeSeriesData::setAverageWindowSize(int windowSize)
 void TimeSeriesData::append(quint64 ms, double value)
 {
     dataMutex.lock();
-    // Qt will automatically use a smart growth strategy: http://doc.qt.io/qt-5/containers.html#growth-strategies
-    this->ms.append(ms);
-    this->value.append(value);
+    samples.append(ms, value);
     this->lastValue = value;
+
+    // Short-term statistics over the newest averageWindow samples
+    const QVector<double>& values = samples.y();
+    int last = values.count() - 1;
+    int windowCount = qMin((int)averageWindow, values.count());
     this->mean = 0;
     //QList<double> medianList = QList<double>();
-    for (unsigned int i = 0; (i < averageWindow) && (((int)count - (int)i) >= 0); ++i) {
-        this->mean += this->value[count-i];
-        //medianList.append(this->value[count-i]);
+    for (int i = 0; i < windowCount; ++i) {
+        this->mean += values[last-i];
+        //medianList.append(values[last-i]);
     }
-    this->mean = mean / static_cast<double>(qMin(averageWindow,static_cast<unsigned int>(count)));
+    this->mean = mean / static_cast<double>(windowCount);
 
     this->variance = 0;
-    for (unsigned int i = 0; (i < averageWindow) && (((int)count - (int)i) >= 0); ++i) {
-        this->variance += (this->value[count-i] - mean) * (this->value[count-i] - mean);
+    for (int i = 0; i < windowCount; ++i) {
+        this->variance += (values[last-i] - mean) * (values[last-i] - mean);
     }
-    this->variance = this->variance / static_cast<double>(qMin(averageWindow,static_cast<unsigned int>(count)));
+    this->variance = this->variance / static_cast<double>(windowCount);
 
 //    qSort(medianList);
 
@@ -815,14 +883,7 @@ void TimeSeriesData::append(quint64 ms, double value)
     if(ms > stopTime) stopTime = ms;
     interval = stopTime - startTime;
 
-    if (interval > plotInterval) {
-        while (this->ms[count - plotCount] < stopTime - plotInterval) {
-            plotCount--;
-        }
-    }
-
     count++;
-    plotCount++;
 
     if(minValue > value) minValue = value;
     if(maxValue < value) maxValue = value;
@@ -831,20 +892,28 @@ void TimeSeriesData::append(quint64 ms, double value)
     if(maxInterval > 0) {
         // maxInterval = 0 means infinite
 
-        if(interval > maxInterval && !this->ms.isEmpty() && !this->value.isEmpty()) {
-            // The time at which this time series should be cut
-            double minTime = stopTime - maxInterval;
-            // Delete elements from the start of the list as long the time
-            // value of this elements is before the cut time
-            while(this->ms.first() < minTime) {
-                this->ms.pop_front();
-                this->value.pop_front();
-            }
+        if(interval > maxInterval) {
+            // Delete samples before the cut time
+            samples.removeBefore(stopTime - maxInterval);
         }
     }
     dataMutex.unlock();
 }
 
+/**
+ * @brief Select the samples which are drawn for the plot window
+ *
+ * @param startMs Start of the plot window in milliseconds
+ * @param endMs End of the plot window in milliseconds
+ * @param maxBuckets Maximum number of min/max pairs, normally the plot width in pixels
+ **/
+void TimeSeriesData::updatePlotSamples(double startMs, double endMs, int maxBuckets)
+{
+    dataMutex.lock();
+    samples.decimate(startMs, endMs, maxBuckets, plotMs, plotValue);
+    dataMutex.unlock();
+}
+
 /**
  * @brief Get the id of this data set
  *
@@ -943,20 +1012,20 @@ int TimeSeriesData::getCount() const
  **/
 int TimeSeriesData::getPlotCount() const
 {
-    return plotCount;
+    return plotMs.count();
 }
 
 /**
  * @brief Get the data array size
  * The data array size is \e NOT equal to the number of items in the data set, as
- * array space is pre-allocated. Use getCount() to get the number of data points.
+ * old items are dropped if a maximum interval is set. Use getCount() to get the number of data points.
  *
  * @return The data array size
  * @see getCount()
  **/
 int TimeSeriesData::size() const
 {
-    return ms.size();
+    return samples.count();
 }
 
 /**
@@ -966,12 +1035,12 @@ int TimeSeriesData::size() const
  **/
 const double* TimeSeriesData::getX() const
 {
-    return ms.data();
+    return samples.x().constData();
 }
 
 const double* TimeSeriesData::getPlotX() const
 {
-    return ms.data() + (count - plotCount);
+    return plotMs.constData();
 }
 
 /**
@@ -981,10 +1050,185 @@ const double* TimeSeriesData::getPlotX() const
  **/
 const double* TimeSeriesData::getY() const
 {
-    return value.data();
+    return samples.y().constData();
 }
 
 const double* TimeSeriesData::getPlotY() const
 {
-    return value.data() + (count - plotCount);
+    return plotValue.constData();
+}
+
+
+TimeSeriesStoreSeries::TimeSeriesStoreSeries(const TimeSeriesStore* store, int curveId):
+    _store(store),
+    _curveId(curveId),
+    _consumed(0),
+    _pyramidGroundTime(true)
+{
+
+}
+
+void TimeSeriesStoreSeries::updateWindow(double startMsecs, double endMsecs, bool groundTime, int maxBuckets)
+{
+    if (groundTime != _pyramidGroundTime) {
+        _pyramid.clear();
+        _consumed = 0;
+        _pyramidGroundTime = groundTime;
+    }
+
+    _consumeSamples();
+    _pyramid.decimate(startMsecs, endMsecs, maxBuckets, _plotX, _plotY);
+
+    // Invalidate the bounding rect cache of QwtSeriesData
+    d_boundingRect = QRectF(0.0, 0.0, -1.0, -1.0);
+}
+
+/**
+ * @brief Copy the samples appended to the store since the last call into the pyramid
+ * The pyramid keeps as many samples as the store, older ones are dropped as new ones come in.
+ **/
+void TimeSeriesStoreSeries::_consumeSamples()
+{
+    while (true) {
+        quint32 head = _store->head(_curveId);
+        quint32 first = _store->firstIndex(head);
+
+        // Samples which dropped out of the store before they were copied are lost
+        if (head - _consumed > head - first) {
+            _consumed = first;
+        }
+
+        quint32 start = _consumed;
+        for (quint32 i = start; i != head; i++) {
+            _pyramid.append(_store->time(_curveId, i, _pyramidGroundTime), _store->value(_curveId, i));
+        }
+        _consumed = head;
+
+        if (!_store->overwritten(_curveId, start)) {
+            break;
+        }
+
+        // The writer wrapped around onto the samples while they were copied, start over from what the store holds now
+        _pyramid.clear();
+        _consumed = 0;
+    }
+
+    int count = _pyramid.count();
+    if (count > TimeSeriesStore::sampleCapacity) {
+        _pyramid.removeBefore(_pyramid.x().at(count - TimeSeriesStore::sampleCapacity));
+    }
+}
+
+quint64 TimeSeriesStoreSeries::lastTime(bool groundTime) const
+{
+    quint32 head;
+    quint64 time;
+    do {
+        head = _store->head(_curveId);
+        if (head == 0) {
+            return 0;
+        }
+        time = (quint64)_store->time(_curveId, head - 1, groundTime);
+    } while (_store->overwritten(_curveId, head - 1));
+
+    return time;
+}
+
+quint64 TimeSeriesStoreSeries::firstTime(bool groundTime) const
+{
+    quint32 first;
+    quint64 time;
+    do {
+        quint32 head = _store->head(_curveId);
+        if (head == 0) {
+            return 0;
+        }
+        first = _store->firstIndex(head);
+        time = (quint64)_store->time(_curveId, first, groundTime);
+    } while (_store->overwritten(_curveId, first));
+
+    return time;
+}
+
+double TimeSeriesStoreSeries::getCurrentValue() const
+{
+    quint32 head;
+    double  value;
+    do {
+        head = _store->head(_curveId);
+        if (head == 0) {
+            return 0.0;
+        }
+        value = _store->value(_curveId, head - 1);
+    } while (_store->overwritten(_curveId, head - 1));
+
+    return value;
+}
+
+double TimeSeriesStoreSeries::getMean(int windowSize) const
+{
+    quint32 head;
+    quint32 first;
+    double  sum;
+    do {
+        head = _store->head(_curveId);
+        first = qMax(_store->firstIndex(head), head > (quint32)windowSize ? head - windowSize : 0);
+        if (head == first) {
+            return 0.0;
+        }
+
+        sum = 0.0;
+        for (quint32 i = first; i != head; i++) {
+            sum += _store->value(_curveId, i);
+        }
+    } while (_store->overwritten(_curveId, first));
+
+    return sum / (head - first);
+}
+
+double TimeSeriesStoreSeries::getVariance(int windowSize) const
+{
+    quint32 head;
+    quint32 first;
+    double  mean;
+    double  variance;
+    do {
+        head = _store->head(_curveId);
+        first = qMax(_store->firstIndex(head), head > (quint32)windowSize ? head - windowSize : 0);
+        if (head == first) {
+            return 0.0;
+        }
+
+        mean = 0.0;
+        for (quint32 i = first; i != head; i++) {
+            mean += _store->value(_curveId, i);
+        }
+        mean /= (head - first);
+
+        variance = 0.0;
+        for (quint32 i = first; i != head; i++) {
+            double diff = _store->value(_curveId, i) - mean;
+            variance += diff * diff;
+        }
+    } while (_store->overwritten(_curveId, first));
+
+    return variance / (head - first);
+}
+
+size_t TimeSeriesStoreSeries::size() const
+{
+    return _plotX.count();
+}
+
+QPointF TimeSeriesStoreSeries::sample(size_t i) const
+{
+    return QPointF(_plotX.at((int)i), _plotY.at((int)i));
+}
+
+QRectF TimeSeriesStoreSeries::boundingRect() const
+{
+    if (d_boundingRect.width() < 0.0) {
+        d_boundingRect = qwtBoundingRect(*this);
+    }
+    return d_boundingRect;
 }
@@ -33,7 +33,10 @@
 #include <qwt_scale_widget.h>
 #include <qwt_scale_engine.h>
 #include <qwt_plot.h>
+#include <qwt_series_data.h>
 #include "ChartPlot.h"
+#include "TimeSeriesPyramid.h"
+#include "TimeSeriesStore.h"
 #include "MG.h"
 
 class TimeScaleDraw: public QwtScaleDraw
@@ -63,7 +66,7 @@ class TimeSeriesData
 {
 public:
 
-    TimeSeriesData(QwtPlot* plot, QString friendlyName = "data", quint64 plotInterval = 10000, quint64 maxInterval = 0, double zeroValue = 0);
+    TimeSeriesData(QwtPlot* plot, QString friendlyName = "data", quint64 maxInterval = 0, double zeroValue = 0);
     ~TimeSeriesData();
 
     void append(quint64 ms, double value);
@@ -75,6 +78,8 @@ public:
     const double* getX() const;
     const double* getY() const;
 
+    /** @brief Decimate the samples in the plot window, see TimeSeriesPyramid::decimate() */
+    void updatePlotSamples(double startMs, double endMs, int maxBuckets);
     const double* getPlotX() const;
     const double* getPlotY() const;
     int getPlotCount() const;
@@ -93,7 +98,6 @@ public:
     /** @brief Get the current value */
     double getCurrentValue();
     void setZeroValue(double zeroValue);
-    void setInterval(quint64 ms);
     void setAverageWindowSize(int windowSize);
 
 protected:
@@ -101,10 +105,8 @@ protected:
     quint64 startTime;
     quint64 stopTime;
     quint64 interval;
-    quint64 plotInterval;
     quint64 maxInterval;
     int id;
-    quint64 plotCount;
     QString friendlyName;
 
     double lastValue; ///< The last inserted value
@@ -120,17 +122,60 @@ protected:
 
 private:
     quint64 count;
-    QVector<double> ms;
-    QVector<double> value;
+    TimeSeriesPyramid samples;
     double mean;
     double median;
     double variance;
     unsigned int averageWindow;
-    QVector<double> outputMs;
-    QVector<double> outputValue;
+    QVector<double> plotMs;     ///< Decimated samples in the plot window
+    QVector<double> plotValue;
 };
 
 
+/**
+ * @brief Curve data which is read straight out of a TimeSeriesStore curve
+ *
+ * The plot calls updateWindow before each replot. This copies the samples appended to the
+ * store since the last replot into a TimeSeriesPyramid, and decimates the plot window from
+ * the pyramid to the minimum and maximum per pixel column. A replot costs the new samples
+ * plus the plot width instead of the number of samples in the window, and drawing does not
+ * race the store writer.
+ **/
+class TimeSeriesStoreSeries : public QwtSeriesData<QPointF>
+{
+public:
+    TimeSeriesStoreSeries(const TimeSeriesStore* store, int curveId);
+
+    /** @brief Select the samples from startMsecs to endMsecs, decimated to at most maxBuckets min/max pairs */
+    void updateWindow(double startMsecs, double endMsecs, bool groundTime, int maxBuckets);
+
+    /** @brief Time of the newest sample, 0 if there are none */
+    quint64 lastTime(bool groundTime) const;
+    /** @brief Time of the oldest sample still in the store, 0 if there are none */
+    quint64 firstTime(bool groundTime) const;
+
+    double getCurrentValue() const;
+    /** @brief Get the mean of the last windowSize samples */
+    double getMean(int windowSize) const;
+    /** @brief Get the variance of the last windowSize samples */
+    double getVariance(int windowSize) const;
+
+    // Overrides from QwtSeriesData
+    virtual size_t size() const;
+    virtual QPointF sample(size_t i) const;
+    virtual QRectF boundingRect() const;
+
+private:
+    void _consumeSamples();
+
+    const TimeSeriesStore*  _store;
+    int                     _curveId;
+    TimeSeriesPyramid       _pyramid;
+    quint32                 _consumed;          ///< Next store sample to copy into the pyramid
+    bool                    _pyramidGroundTime; ///< The pyramid is keyed by ground receive time
+    QVector<double>         _plotX;             ///< Decimated samples in the plot window
+    QVector<double>         _plotY;
+};
 
 
 
@@ -193,6 +238,14 @@ public slots:
      * @param value value of the data point
      */
     void appendData(QString dataname, quint64 ms, double value);
+    /**
+     * @brief Add a curve which reads its data from a time series store
+     *
+     * @param id unique string (also used to label the data)
+     * @param store the store holding the data
+     * @param curveId id of the curve in the store
+     */
+    void addStoreCurve(QString id, const TimeSeriesStore* store, int curveId);
     void hideCurve(QString id);
     void showCurve(QString id);
     /** @brief Enable auto-refreshing of plot */
@@ -234,6 +287,7 @@ protected:
     QMap<QString, TimeSeriesData*> data;
     QMap<QString, QwtScaleMap*> scaleMaps;
     QMap<QString, quint64> lastUpdate;
+    QMap<QString, TimeSeriesStoreSeries*> storeData;    ///< Store backed curve data, owned by the curves
 
     //static const quint64 MAX_STORAGE_INTERVAL = Q_UINT64_C(300000);
     static const quint64 MAX_STORAGE_INTERVAL = Q_UINT64_C(0);  ///< The maximum interval which is stored
@@ -267,6 +321,8 @@ protected:
 
     // Methods
     void addCurve(QString id);
+    QwtPlotCurve* createCurve(QString id);
+    void updateStoreTimes();
     void showEvent(QShowEvent* event);
     void hideEvent(QHideEvent* event);
 
@@ -52,6 +52,7 @@ LinechartWidget::LinechartWidget(int systemid, QWidget *parent) : QWidget(parent
     curveMeans(new QMap<QString, QLabel*>()),
     curveMedians(new QMap<QString, QLabel*>()),
     curveVariances(new QMap<QString, QLabel*>()),
+    timeSeriesStore(NULL),
     logFile(new QFile()),
     logindex(1),
     logging(false),
@@ -334,14 +335,9 @@ void LinechartWidget::appendData(int uasId, const QString& curve, const QString&
         lastTimestamp = usec;
     } else if (usec != 0) {
         // Difference larger than 3 secs, enforce ground time
-        if (((qint64)usec - (qint64)lastTimestamp) > 3000)
+        if (((qint64)usec - (qint64)lastTimestamp) > TimeSeriesStore::timeJumpMsecs)
         {
-            autoGroundTimeSet = true;
-            // Tick ground time checkbox, but avoid state switching
-            timeButton->blockSignals(true);
-            timeButton->setChecked(true);
-            timeButton->blockSignals(false);
-            if (activePlot) activePlot->enforceGroundTime(true);
+            enforceAutoGroundTime();
         }
         lastTimestamp = usec;
     }
@@ -362,6 +358,98 @@ void LinechartWidget::appendData(int uasId, const QString& curve, const QString&
     }
 }
 
+void LinechartWidget::enforceAutoGroundTime()
+{
+    autoGroundTimeSet = true;
+    // Tick ground time checkbox, but avoid state switching
+    timeButton->blockSignals(true);
+    timeButton->setChecked(true);
+    timeButton->blockSignals(false);
+    if (activePlot) activePlot->enforceGroundTime(true);
+}
+
+void LinechartWidget::setTimeSeriesStore(TimeSeriesStore* store)
+{
+    timeSeriesStore = store;
+    connect(store, &TimeSeriesStore::curveAdded, this, &LinechartWidget::addStoreCurve);
+    // Store backed curves do not go through appendData, so the store checks for time jumps itself
+    connect(store, &TimeSeriesStore::timeJumped, this, &LinechartWidget::enforceAutoGroundTime);
+
+    // Pick up the curves which are already in the store
+    int curveCount = store->curveCount();
+    for (int i = 0; i < curveCount; i++) {
+        addStoreCurve(i);
+    }
+}
+
+void LinechartWidget::addStoreCurve(int curveId)
+{
+    if (selectedMAV != -1 && selectedMAV != timeSeriesStore->uasId(curveId))
+    {
+        return;
+    }
+
+    QString curve = timeSeriesStore->name(curveId);
+    QString unit = timeSeriesStore->unit(curveId);
+    QString curveID = curve + unit;
+
+    if (curveLabels->contains(curveID))
+    {
+        return;
+    }
+
+    // Order matters here, first add to plot, then update curve list
+    activePlot->addStoreCurve(curveID, timeSeriesStore, curveId);
+    storeCurveIds.insert(curveID, curveId);
+    addCurve(curve, unit);
+}
+
+void LinechartWidget::logStoreCurves()
+{
+    QMap<QString, int>::const_iterator i;
+    for (i = storeCurveIds.constBegin(); i != storeCurveIds.constEnd(); ++i)
+    {
+        int curveId = i.value();
+        quint32 head = timeSeriesStore->head(curveId);
+        quint32 first = timeSeriesStore->firstIndex(head);
+        quint32 index = storeLogIndices.value(i.key(), first);
+
+        // Samples which already dropped out of the store are lost
+        if (head - index > head - first)
+        {
+            index = first;
+        }
+        storeLogIndices.insert(i.key(), head);
+
+        if (!activePlot->isVisible(i.key()))
+        {
+            continue;
+        }
+
+        QString curve = timeSeriesStore->name(curveId);
+        int uasId = timeSeriesStore->uasId(curveId);
+        for (; index != head; index++)
+        {
+            quint64 usec = timeSeriesStore->msecs(curveId, index);
+            if (usec == 0) usec = timeSeriesStore->groundMsecs(curveId, index);
+            double value = timeSeriesStore->value(curveId, index);
+
+            // The writer wrapped around onto this sample while it was read
+            if (timeSeriesStore->overwritten(curveId, index))
+            {
+                continue;
+            }
+
+            if (logStartTime == 0) logStartTime = usec;
+            qint64 time = usec - logStartTime;
+            if (time < 0) time = 0;
+
+            QString line = QString("%1\t%2\t%3\t%4\n").arg(time).arg(uasId).arg(curve).arg(value, 0, 'e', 15);
+            logFile->write(line.toLatin1());
+        }
+    }
+}
+
 void LinechartWidget::refresh()
 {
     setUpdatesEnabled(false);
@@ -371,6 +459,8 @@ void LinechartWidget::refresh()
     for (i = curveLabels->begin(); i != curveLabels->end(); ++i) {
         if (intData.contains(i.key())) {
             str.sprintf("% 11i", intData.value(i.key()));
+        } else if (storeCurveIds.contains(i.key()) && timeSeriesStore->isIntegerValued(storeCurveIds.value(i.key()))) {
+            str.sprintf("% 11i", static_cast<int>(activePlot->getCurrentValue(i.key())));
         } else {
             double val = activePlot->getCurrentValue(i.key());
             int intval = static_cast<int>(val);
@@ -417,6 +507,11 @@ void LinechartWidget::refresh()
         l.value()->setText(str);
     }
     setUpdatesEnabled(true);
+
+    if (logging)
+    {
+        logStoreCurves();
+    }
 }
 
 void LinechartWidget::startLogging()
@@ -445,6 +540,13 @@ void LinechartWidget::startLogging()
         if (logFile->open(QIODevice::Truncate | QIODevice::WriteOnly | QIODevice::Text)) {
             logging = true;
             logStartTime = 0;
+
+            // Only log store samples which arrive from now on
+            storeLogIndices.clear();
+            foreach (const QString& key, storeCurveIds.keys())
+            {
+                storeLogIndices.insert(key, timeSeriesStore->head(storeCurveIds.value(key)));
+            }
             curvesWidget->setEnabled(false);
             logindex++;
             logButton->setText(tr("Stop logging"));
@@ -456,6 +558,11 @@ void LinechartWidget::startLogging()
 
 void LinechartWidget::stopLogging()
 {
+    if (logging)
+    {
+        // Pick up the store samples which arrived since the last refresh
+        logStoreCurves();
+    }
     logging = false;
     curvesWidget->setEnabled(true);
     if (logFile->isOpen()) {
@@ -41,6 +41,7 @@
 #include "ui_Linechart.h"
 
 #include "LogCompressor.h"
+#include "TimeSeriesStore.h"
 
 /**
  * @brief The linechart widget allows to visualize different timeseries as lineplot.
@@ -57,6 +58,9 @@ public:
     static const int MIN_TIME_SCROLLBAR_VALUE = 0; ///< The minimum scrollbar value
     static const int MAX_TIME_SCROLLBAR_VALUE = 16383; ///< The maximum scrollbar value
 
+    /** @brief Show the curves of a time series store, curves are added as they appear in the store */
+    void setTimeSeriesStore(TimeSeriesStore* store);
+
 public slots:
     void addCurve(const QString& curve, const QString& unit);
     void removeCurve(QString curve);
@@ -66,6 +70,10 @@ public slots:
     void setShortNames(bool enable);
     /** @brief Append data to the given curve. */
     void appendData(int uasId, const QString& curve, const QString& unit, const QVariant& value, quint64 usec);
+    /** @brief Add a curve from the time series store */
+    void addStoreCurve(int curveId);
+    /** @brief Switch to ground time after the data time jumped */
+    void enforceAutoGroundTime();
     /** @brief Hide curves which do not match the filter pattern */
     void filterCurves(const QString &filter);
 
@@ -112,6 +120,8 @@ protected:
     void createLayout();
     /** @brief Get the name for a curve key */
     QString getCurveName(const QString& key, bool shortEnabled);
+    /** @brief Write new samples of the store curves to the log file */
+    void logStoreCurves();
 
     int sysid;                            ///< ID of the unmanned system this plot belongs to
     LinechartPlot* activePlot;            ///< Plot for this system
@@ -130,6 +140,9 @@ protected:
     QMap<QString, int> intData;           ///< Current values for integer-valued curves
     QMap<QString, QWidget*> colorIcons;    ///< Reference to color icons
     QMap<QString, QCheckBox*> checkBoxes;    ///< Reference to checkboxes
+    TimeSeriesStore* timeSeriesStore;     ///< Store for curves which are not fed through appendData
+    QMap<QString, int> storeCurveIds;     ///< Store curve id for store backed curves
+    QMap<QString, quint32> storeLogIndices; ///< Next store sample to log for store backed curves
 
     QWidget* curvesWidget;                ///< The QWidget containing the curve selection button
     QGridLayout* curvesWidgetLayout;      ///< The layout for the curvesWidget QWidget
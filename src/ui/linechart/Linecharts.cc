@@ -21,8 +21,8 @@ QWidget* Linecharts::_newVehicleWidget(Vehicle* vehicle, QWidget* parent)
     // Connect valueChanged signals
     connect(vehicle->uas(), &UAS::valueChanged, widget, &LinechartWidget::appendData);
 
-    // Connect decoder
-    connect(_mavlinkDecoder, &MAVLinkDecoder::valueChanged, widget, &LinechartWidget::appendData);
+    // Decoded message fields are read from the decoder's store
+    widget->setTimeSeriesStore(_mavlinkDecoder->timeSeriesStore());
 
     // Select system
     widget->setActive(true);
@@ -0,0 +1,167 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+
+#include "TimeSeriesPyramid.h"
+
+#include <algorithm>
+
+TimeSeriesPyramid::TimeSeriesPyramid(void)
+{
+
+}
+
+void TimeSeriesPyramid::append(double x, double y)
+{
+    int index = _x.count();
+
+    _x.append(x);
+    _y.append(y);
+
+    Bucket_t sample = { x, y, x, y };
+    for (int i=0; i<_levels.count(); i++) {
+        _addToBucket(_levels[i], index >> ((i + 1) * _fanoutBits), sample);
+    }
+
+    // Add a coarser level once the current top level no longer fits into a single bucket
+    int topCount = _levels.isEmpty() ? _x.count() : _levels.last().count();
+    if (topCount > _fanout) {
+        _addLevel();
+    }
+}
+
+void TimeSeriesPyramid::clear(void)
+{
+    _x.clear();
+    _y.clear();
+    _levels.clear();
+}
+
+void TimeSeriesPyramid::removeBefore(double x)
+{
+    int obsolete = std::lower_bound(_x.constBegin(), _x.constEnd(), x) - _x.constBegin();
+    if (obsolete == 0 || obsolete < _x.count() / 2) {
+        return;
+    }
+
+    QVector<double> keepX = _x.mid(obsolete);
+    QVector<double> keepY = _y.mid(obsolete);
+
+    clear();
+    for (int i=0; i<keepX.count(); i++) {
+        append(keepX[i], keepY[i]);
+    }
+}
+
+void TimeSeriesPyramid::decimate(double startX, double endX, int maxBuckets, QVector<double>& outX, QVector<double>& outY) const
+{
+    outX.clear();
+    outY.clear();
+
+    int count = _x.count();
+    if (count == 0 || endX < startX) {
+        return;
+    }
+
+    int first = std::lower_bound(_x.constBegin(), _x.constEnd(), startX) - _x.constBegin();
+    int last = std::upper_bound(_x.constBegin(), _x.constEnd(), endX) - _x.constBegin();
+    if (first > 0) {
+        first--;
+    }
+    if (last < count) {
+        last++;
+    }
+
+    maxBuckets = qMax(maxBuckets, 1);
+
+    if (last - first <= 2 * maxBuckets || _levels.isEmpty()) {
+        // Few enough samples to draw them all
+        outX = _x.mid(first, last - first);
+        outY = _y.mid(first, last - first);
+        return;
+    }
+
+    // Pick the finest level which fits into the requested number of buckets
+    int level = 0;
+    int shift;
+    while (true) {
+        shift = (level + 1) * _fanoutBits;
+        int bucketCount = ((last - 1) >> shift) - (first >> shift) + 1;
+        if (bucketCount <= maxBuckets || level == _levels.count() - 1) {
+            break;
+        }
+        level++;
+    }
+
+    const QVector<Bucket_t>& buckets = _levels[level];
+    int firstBucket = first >> shift;
+    int lastBucket = (last - 1) >> shift;
+
+    outX.reserve(2 * (lastBucket - firstBucket + 1));
+    outY.reserve(2 * (lastBucket - firstBucket + 1));
+
+    for (int i=firstBucket; i<=lastBucket; i++) {
+        const Bucket_t& bucket = buckets[i];
+
+        // Emit min and max in time order so the line does not go back in time
+        if (bucket.minX <= bucket.maxX) {
+            outX.append(bucket.minX);
+            outY.append(bucket.minY);
+            if (bucket.maxX != bucket.minX || bucket.maxY != bucket.minY) {
+                outX.append(bucket.maxX);
+                outY.append(bucket.maxY);
+            }
+        } else {
+            outX.append(bucket.maxX);
+            outY.append(bucket.maxY);
+            outX.append(bucket.minX);
+            outY.append(bucket.minY);
+        }
+    }
+}
+
+void TimeSeriesPyramid::_addToBucket(QVector<Bucket_t>& level, int bucketIndex, const Bucket_t& bucket)
+{
+    if (bucketIndex == level.count()) {
+        level.append(bucket);
+        return;
+    }
+
+    Bucket_t& target = level[bucketIndex];
+    if (bucket.minY < target.minY) {
+        target.minX = bucket.minX;
+        target.minY = bucket.minY;
+    }
+    if (bucket.maxY > target.maxY) {
+        target.maxX = bucket.maxX;
+        target.maxY = bucket.maxY;
+    }
+}
+
+/// Builds a new top level from the current top level (or the raw samples)
+void TimeSeriesPyramid::_addLevel(void)
+{
+    QVector<Bucket_t> level;
+
+    if (_levels.isEmpty()) {
+        level.reserve((_x.count() >> _fanoutBits) + 1);
+        for (int i=0; i<_x.count(); i++) {
+            Bucket_t sample = { _x[i], _y[i], _x[i], _y[i] };
+            _addToBucket(level, i >> _fanoutBits, sample);
+        }
+    } else {
+        const QVector<Bucket_t>& top = _levels.last();
+        level.reserve((top.count() >> _fanoutBits) + 1);
+        for (int i=0; i<top.count(); i++) {
+            _addToBucket(level, i >> _fanoutBits, top[i]);
+        }
+    }
+
+    _levels.append(level);
+}
@@ -0,0 +1,68 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+
+#ifndef TimeSeriesPyramid_H
+#define TimeSeriesPyramid_H
+
+#include <QVector>
+
+/// Time series samples with a min/max decimation pyramid on top, used to draw long histories in time proportional
+/// to the plot width instead of the number of samples.
+///
+/// Level 1 of the pyramid holds the minimum and maximum sample of each group of _fanout raw samples, each further
+/// level groups _fanout buckets of the level below. The pyramid is updated incrementally as samples are appended,
+/// which touches one bucket per level. To draw a time window the coarsest level which still has at least one bucket
+/// per pixel is picked and two points (min and max) are emitted per bucket, so spikes stay visible at any zoom.
+///
+/// Sample times are expected to be increasing. Out of order samples are kept, but the window lookup may then start
+/// or end the window a few samples off.
+class TimeSeriesPyramid
+{
+public:
+    TimeSeriesPyramid(void);
+
+    void append(double x, double y);
+    void clear(void);
+
+    /// Drops samples before the specified time. To keep this cheap the pyramid is only rebuilt once at least half
+    /// of the samples are obsolete, so older samples may be kept for a while.
+    void removeBefore(double x);
+
+    int                     count(void) const   { return _x.count(); }
+    const QVector<double>&  x(void) const       { return _x; }
+    const QVector<double>&  y(void) const       { return _y; }
+
+    /// Decimates the samples from startX to endX for drawing. One sample on either side of the window is included
+    /// so the curve reaches the plot edges.
+    ///     @param maxBuckets Maximum number of buckets to emit, normally the plot width in pixels
+    ///     @param[out] outX Sample times, at most 2 * maxBuckets
+    ///     @param[out] outY Sample values
+    void decimate(double startX, double endX, int maxBuckets, QVector<double>& outX, QVector<double>& outY) const;
+
+private:
+    typedef struct {
+        double minX;
+        double minY;
+        double maxX;
+        double maxY;
+    } Bucket_t;
+
+    void _addToBucket(QVector<Bucket_t>& level, int bucketIndex, const Bucket_t& bucket);
+    void _addLevel(void);
+
+    QVector<double>             _x;
+    QVector<double>             _y;
+    QVector<QVector<Bucket_t> > _levels;    ///< _levels[0] is level 1 of the pyramid
+
+    static const int _fanoutBits =  2;
+    static const int _fanout =      1 << _fanoutBits;
+};
+
+#endif
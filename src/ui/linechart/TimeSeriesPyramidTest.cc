@@ -0,0 +1,238 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "TimeSeriesPyramidTest.h"
+#include "TimeSeriesPyramid.h"
+
+#include <algorithm>
+
+TimeSeriesPyramidTest::TimeSeriesPyramidTest(void)
+{
+
+}
+
+/// Noisy samples 10 msecs apart, with repeated values so ties between minimum and maximum candidates are covered
+void TimeSeriesPyramidTest::_randomSamples(int count, QVector<double>& x, QVector<double>& y)
+{
+    quint32 seed = 12345;
+
+    x.clear();
+    y.clear();
+    for (int i=0; i<count; i++) {
+        seed = seed * 1103515245 + 12345;
+        x.append(10.0 * i);
+        y.append((double)((seed >> 16) % 200) - 100.0);
+    }
+}
+
+/// Reference decimation straight from the raw samples. Picks the pyramid level the same way as
+/// TimeSeriesPyramid::decimate, then finds the minimum and maximum of each bucket by scanning the raw samples.
+void TimeSeriesPyramidTest::_bruteForceDecimate(const QVector<double>& x, const QVector<double>& y, double startX, double endX, int maxBuckets, QVector<double>& outX, QVector<double>& outY)
+{
+    outX.clear();
+    outY.clear();
+
+    int count = x.count();
+    if (count == 0 || endX < startX) {
+        return;
+    }
+
+    int first = std::lower_bound(x.constBegin(), x.constEnd(), startX) - x.constBegin();
+    int last = std::upper_bound(x.constBegin(), x.constEnd(), endX) - x.constBegin();
+    if (first > 0) {
+        first--;
+    }
+    if (last < count) {
+        last++;
+    }
+
+    // Number of levels the pyramid builds for this many samples
+    int levelCount = 0;
+    for (int top = count; top > (1 << _fanoutBits); top = (top + (1 << _fanoutBits) - 1) >> _fanoutBits) {
+        levelCount++;
+    }
+
+    maxBuckets = qMax(maxBuckets, 1);
+    if (last - first <= 2 * maxBuckets || levelCount == 0) {
+        outX = x.mid(first, last - first);
+        outY = y.mid(first, last - first);
+        return;
+    }
+
+    int shift = _fanoutBits;
+    for (int level = 1; level < levelCount; level++) {
+        if (((last - 1) >> shift) - (first >> shift) + 1 <= maxBuckets) {
+            break;
+        }
+        shift += _fanoutBits;
+    }
+
+    for (int bucket = first >> shift; bucket <= (last - 1) >> shift; bucket++) {
+        int bucketStart = bucket << shift;
+        int bucketEnd = qMin((bucket + 1) << shift, count);
+        int minIndex = bucketStart;
+        int maxIndex = bucketStart;
+        for (int i=bucketStart + 1; i<bucketEnd; i++) {
+            if (y[i] < y[minIndex]) minIndex = i;
+            if (y[i] > y[maxIndex]) maxIndex = i;
+        }
+
+        int firstIndex = qMin(minIndex, maxIndex);
+        int secondIndex = qMax(minIndex, maxIndex);
+        outX.append(x[firstIndex]);
+        outY.append(y[firstIndex]);
+        if (secondIndex != firstIndex) {
+            outX.append(x[secondIndex]);
+            outY.append(y[secondIndex]);
+        }
+    }
+}
+
+void TimeSeriesPyramidTest::_compareDecimate(const TimeSeriesPyramid& pyramid, const QVector<double>& x, const QVector<double>& y, double startX, double endX, int maxBuckets)
+{
+    QVector<double> outX, outY, expectedX, expectedY;
+
+    pyramid.decimate(startX, endX, maxBuckets, outX, outY);
+    _bruteForceDecimate(x, y, startX, endX, maxBuckets, expectedX, expectedY);
+
+    // The top level may have up to a fanout of buckets, even if fewer were requested
+    QVERIFY(outX.count() <= 2 * qMax(maxBuckets, 1 << _fanoutBits));
+    QCOMPARE(outX.count(), outY.count());
+    QCOMPARE(outX, expectedX);
+    QCOMPARE(outY, expectedY);
+}
+
+/// Windows with no more than two samples per bucket come back undecimated
+void TimeSeriesPyramidTest::_smallWindow_test(void)
+{
+    TimeSeriesPyramid   pyramid;
+    QVector<double>     outX, outY;
+
+    pyramid.decimate(0, 100, 10, outX, outY);
+    QVERIFY(outX.isEmpty());
+
+    QVector<double> x, y;
+    _randomSamples(1000, x, y);
+    for (int i=0; i<x.count(); i++) {
+        pyramid.append(x[i], y[i]);
+    }
+    QCOMPARE(pyramid.count(), 1000);
+
+    // 20 samples in the window, plus one on either side
+    pyramid.decimate(1000, 1195, 100, outX, outY);
+    QCOMPARE(outX, x.mid(99, 22));
+    QCOMPARE(outY, y.mid(99, 22));
+
+    // Window at the start and end of the samples
+    _compareDecimate(pyramid, x, y, -50, 100, 100);
+    _compareDecimate(pyramid, x, y, 9900, 20000, 100);
+
+    // Empty and inverted windows
+    _compareDecimate(pyramid, x, y, 20000, 30000, 100);
+    pyramid.decimate(500, 400, 100, outX, outY);
+    QVERIFY(outX.isEmpty());
+}
+
+/// Every level of the pyramid against the brute force reference, with the pyramid built up incrementally
+void TimeSeriesPyramidTest::_levels_test(void)
+{
+    QVector<double> x, y;
+    _randomSamples(5000, x, y);
+
+    TimeSeriesPyramid pyramid;
+    for (int i=0; i<x.count(); i++) {
+        pyramid.append(x[i], y[i]);
+
+        // Check part way through so the pyramid is compared while the top levels are partially filled
+        int count = i + 1;
+        if (count == 17 || count == 65 || count == 257 || count == 1000 || count == 4097 || count == x.count()) {
+            QVector<double> partX = x.mid(0, count);
+            QVector<double> partY = y.mid(0, count);
+            double endX = partX.last();
+
+            for (int maxBuckets=1; maxBuckets<=1024; maxBuckets*=2) {
+                _compareDecimate(pyramid, partX, partY, 0, endX, maxBuckets);
+                _compareDecimate(pyramid, partX, partY, endX / 3 + 5, 2 * endX / 3 - 5, maxBuckets);
+                _compareDecimate(pyramid, partX, partY, endX / 2, endX, maxBuckets + 3);
+            }
+        }
+    }
+}
+
+/// A single sample spike has to show up at any zoom level
+void TimeSeriesPyramidTest::_spikes_test(void)
+{
+    TimeSeriesPyramid pyramid;
+
+    const int count = 100000;
+    for (int i=0; i<count; i++) {
+        double y = 0;
+        if (i == 12345) {
+            y = 1000;
+        } else if (i == 87654) {
+            y = -1000;
+        }
+        pyramid.append(i, y);
+    }
+
+    for (int maxBuckets=1; maxBuckets<=2048; maxBuckets*=2) {
+        QVector<double> outX, outY;
+        pyramid.decimate(0, count, maxBuckets, outX, outY);
+
+        QVERIFY(outX.count() <= 2 * qMax(maxBuckets, 1 << _fanoutBits));
+        QVERIFY(outX.contains(12345));
+        QVERIFY(outX.contains(87654));
+        QCOMPARE(*std::max_element(outY.constBegin(), outY.constEnd()), 1000.0);
+        QCOMPARE(*std::min_element(outY.constBegin(), outY.constEnd()), -1000.0);
+
+        // Points stay in time order
+        for (int i=1; i<outX.count(); i++) {
+            QVERIFY(outX[i] > outX[i - 1]);
+        }
+    }
+}
+
+/// Removing old samples leaves a pyramid which decimates the same as one built from the remaining samples
+void TimeSeriesPyramidTest::_removeBefore_test(void)
+{
+    QVector<double> x, y;
+    _randomSamples(3000, x, y);
+
+    TimeSeriesPyramid pyramid;
+    for (int i=0; i<x.count(); i++) {
+        pyramid.append(x[i], y[i]);
+    }
+
+    // Less than half the samples are obsolete, nothing is dropped yet
+    pyramid.removeBefore(x[1000]);
+    QCOMPARE(pyramid.count(), 3000);
+
+    pyramid.removeBefore(x[2000]);
+    QCOMPARE(pyramid.count(), 1000);
+    QCOMPARE(pyramid.x().first(), x[2000]);
+
+    QVector<double> keepX = x.mid(2000);
+    QVector<double> keepY = y.mid(2000);
+    for (int maxBuckets=1; maxBuckets<=256; maxBuckets*=4) {
+        _compareDecimate(pyramid, keepX, keepY, keepX.first(), keepX.last(), maxBuckets);
+    }
+
+    // The pyramid keeps growing correctly after a rebuild
+    QVector<double> moreX, moreY;
+    _randomSamples(5000, moreX, moreY);
+    for (int i=3000; i<moreX.count(); i++) {
+        pyramid.append(moreX[i], moreY[i]);
+        keepX.append(moreX[i]);
+        keepY.append(moreY[i]);
+    }
+    _compareDecimate(pyramid, keepX, keepY, keepX.first(), keepX.last(), 64);
+
+    pyramid.clear();
+    QCOMPARE(pyramid.count(), 0);
+}
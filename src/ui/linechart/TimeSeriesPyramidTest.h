@@ -0,0 +1,42 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#ifndef TimeSeriesPyramidTest_H
+#define TimeSeriesPyramidTest_H
+
+#include "UnitTest.h"
+
+#include <QVector>
+
+class TimeSeriesPyramid;
+
+/// Unit test for TimeSeriesPyramid, comparing the decimated output of every pyramid level against a brute force
+/// min/max over the raw samples
+class TimeSeriesPyramidTest : public UnitTest
+{
+    Q_OBJECT
+
+public:
+    TimeSeriesPyramidTest(void);
+
+private slots:
+    void _smallWindow_test(void);
+    void _levels_test(void);
+    void _spikes_test(void);
+    void _removeBefore_test(void);
+
+private:
+    void _bruteForceDecimate(const QVector<double>& x, const QVector<double>& y, double startX, double endX, int maxBuckets, QVector<double>& outX, QVector<double>& outY);
+    void _compareDecimate(const TimeSeriesPyramid& pyramid, const QVector<double>& x, const QVector<double>& y, double startX, double endX, int maxBuckets);
+    void _randomSamples(int count, QVector<double>& x, QVector<double>& y);
+
+    static const int _fanoutBits = 2;   ///< Same as TimeSeriesPyramid
+};
+
+#endif
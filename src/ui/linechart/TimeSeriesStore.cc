@@ -0,0 +1,114 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+
+#include "TimeSeriesStore.h"
+
+#include <QDebug>
+
+TimeSeriesStore::TimeSeriesStore(QObject* parent)
+    : QObject(parent)
+    , _curveCount(0)
+    , _lastMsecs(0)
+{
+    Q_STATIC_ASSERT((chunkSamples & (chunkSamples - 1)) == 0);
+    Q_STATIC_ASSERT((chunkCount & (chunkCount - 1)) == 0);
+    Q_STATIC_ASSERT(sampleCapacity >= maxWindowSecs * maxSampleRate);
+
+    for (int i=0; i<maxCurves; i++) {
+        _curves[i] = NULL;
+    }
+}
+
+TimeSeriesStore::~TimeSeriesStore()
+{
+    for (int i=0; i<maxCurves; i++) {
+        if (_curves[i]) {
+            for (int j=0; j<chunkCount; j++) {
+                delete _curves[i]->chunks[j];
+            }
+            delete _curves[i];
+        }
+    }
+}
+
+int TimeSeriesStore::addCurve(int uasId, const QString& name, const QString& unit, bool integerValued)
+{
+    QMutexLocker locker(&_addCurveMutex);
+
+    int curveId = _curveCount.load();
+    if (curveId >= maxCurves) {
+        qWarning() << "TimeSeriesStore full, unable to add curve" << name;
+        return -1;
+    }
+
+    Curve_t* curve = new Curve_t;
+    curve->uasId = uasId;
+    curve->name = name;
+    curve->unit = unit;
+    curve->integerValued = integerValued;
+    for (int i=0; i<chunkCount; i++) {
+        curve->chunks[i] = NULL;
+    }
+    curve->head.store(0);
+
+    // Readers only look at curves below the count, so the curve must be complete before it is published
+    _curves[curveId] = curve;
+    _curveCount.storeRelease(curveId + 1);
+
+    locker.unlock();
+    emit curveAdded(curveId);
+
+    return curveId;
+}
+
+void TimeSeriesStore::append(int curveId, quint64 msecs, quint64 groundMsecs, double value)
+{
+    Curve_t* curve = _curves[curveId];
+    quint32 head = curve->head.load();
+    quint32 index = head & _chunkMask;
+
+    // The ring grows a chunk at a time until it wraps around for the first time. Readers only look at chunks
+    // holding published samples, so the new chunk is published along with the sample.
+    Chunk_t*& chunk = curve->chunks[(head & _sampleMask) / chunkSamples];
+    if (!chunk) {
+        chunk = new Chunk_t;
+    }
+
+    chunk->msecs[index] = msecs;
+    chunk->groundMsecs[index] = groundMsecs;
+    chunk->values[index] = value;
+
+    curve->head.storeRelease(head + 1);
+
+    // Samples without a data time do not take part in the time jump check
+    if (msecs != 0) {
+        if (_lastMsecs != 0 && (qint64)msecs - (qint64)_lastMsecs > timeJumpMsecs) {
+            emit timeJumped();
+        }
+        _lastMsecs = msecs;
+    }
+}
+
+quint32 TimeSeriesStore::lowerBound(int curveId, quint32 first, quint32 head, double msecs, bool groundTime) const
+{
+    quint32 low = first;
+    quint32 high = head;
+
+    while (low < high) {
+        quint32 mid = low + (high - low) / 2;
+        if (time(curveId, mid, groundTime) < msecs) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
@@ -0,0 +1,135 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+
+#ifndef TimeSeriesStore_H
+#define TimeSeriesStore_H
+
+#include <QObject>
+#include <QString>
+#include <QMutex>
+#include <QAtomicInteger>
+
+#include <atomic>
+
+/// Columnar storage for the time series which are plotted by the line charts.
+///
+/// Each curve is interned once to an integer id, after which samples are appended by id without any string
+/// handling. Samples are stored in ring buffers with one column for the data time, one for the ground receive time
+/// and one for the value, so plots can read a time window straight out of the columns. A ring holds the longest
+/// time axis the line charts offer at the highest sample rate the store is sized for. It is allocated in chunks as
+/// the curve grows, so slow curves only use a fraction of that.
+///
+/// The store has a single writer thread (the MAVLinkDecoder thread) and any number of readers. Appending is lock
+/// free: the writer fills in the sample and then publishes it by advancing the curve head. Readers snapshot the
+/// head and only read samples behind it. Since the writer keeps going while a read is in progress, it can wrap
+/// around onto the samples being read. Readers check for this with overwritten after reading, and read again from
+/// a new head snapshot if it happened.
+class TimeSeriesStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    TimeSeriesStore(QObject* parent = NULL);
+    ~TimeSeriesStore();
+
+    /// Adds a new curve to the store. Thread safe.
+    ///     @param uasId Vehicle the data comes from
+    ///     @param name Full curve name
+    ///     @param unit Curve unit
+    ///     @param integerValued true: values are integers
+    /// @return Curve id, -1 if the store is full
+    int addCurve(int uasId, const QString& name, const QString& unit, bool integerValued);
+
+    /// Appends a sample to a curve. Must only be called from the writer thread.
+    ///     @param curveId Curve id returned by addCurve
+    ///     @param msecs Data time in milliseconds
+    ///     @param groundMsecs Ground receive time in milliseconds
+    ///     @param value Sample value
+    void append(int curveId, quint64 msecs, quint64 groundMsecs, double value);
+
+    int     curveCount(void) const                  { return _curveCount.loadAcquire(); }
+    int     uasId(int curveId) const                { return _curves[curveId]->uasId; }
+    QString name(int curveId) const                 { return _curves[curveId]->name; }
+    QString unit(int curveId) const                 { return _curves[curveId]->unit; }
+    bool    isIntegerValued(int curveId) const      { return _curves[curveId]->integerValued; }
+
+    /// @return Total number of samples appended to the curve. Samples with an index below this are readable.
+    quint32 head(int curveId) const { return _curves[curveId]->head.loadAcquire(); }
+
+    /// @return Index of the oldest sample still in the store given the specified head. The writer may be filling in
+    /// the slot before it.
+    quint32 firstIndex(quint32 head) const { return head >= (quint32)sampleCapacity ? head - sampleCapacity + 1 : 0; }
+
+    /// Checks whether the writer has wrapped around onto a sample. Call this after reading samples, with the oldest
+    /// index which was read. If it returns true the values read may be a mix of old and new samples.
+    bool overwritten(int curveId, quint32 index) const
+    {
+        // The sample reads must complete before the head is loaded again
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return head(curveId) - index >= (quint32)sampleCapacity;
+    }
+
+    double msecs(int curveId, quint32 index) const          { return _chunk(curveId, index)->msecs[index & _chunkMask]; }
+    double groundMsecs(int curveId, quint32 index) const    { return _chunk(curveId, index)->groundMsecs[index & _chunkMask]; }
+    double value(int curveId, quint32 index) const          { return _chunk(curveId, index)->values[index & _chunkMask]; }
+
+    /// @return Time of the sample, either data or ground receive time
+    double time(int curveId, quint32 index, bool groundTime) const { return groundTime ? groundMsecs(curveId, index) : msecs(curveId, index); }
+
+    /// Binary searches for the first sample at or after the specified time
+    ///     @param first First index to search
+    ///     @param head Head snapshot
+    /// @return Sample index, head if all samples are before the time
+    quint32 lowerBound(int curveId, quint32 first, quint32 head, double msecs, bool groundTime) const;
+
+    static const int maxWindowSecs =    10 * 60;    ///< Longest time axis offered by LinechartWidget
+    static const int maxSampleRate =    100;        ///< Highest sample rate in Hz for which a full time axis is stored
+    static const int chunkSamples =     4096;       ///< Samples per allocation, must be a power of 2
+    static const int chunkCount =       16;         ///< Chunks per curve, must be a power of 2
+    static const int sampleCapacity =   chunkSamples * chunkCount;  ///< Samples stored per curve
+    static const int maxCurves =        4096;
+    static const int timeJumpMsecs =    3000;       ///< Data time step between samples which is treated as a time jump
+
+signals:
+    /// Emitted from the writer thread when a new curve is added
+    void curveAdded(int curveId);
+
+    /// Emitted from the writer thread when the data time jumps ahead by more than timeJumpMsecs between two samples,
+    /// for example on a log replay seek or a vehicle clock reset
+    void timeJumped(void);
+
+private:
+    typedef struct {
+        double msecs[chunkSamples];
+        double groundMsecs[chunkSamples];
+        double values[chunkSamples];
+    } Chunk_t;
+
+    typedef struct {
+        int                     uasId;
+        QString                 name;
+        QString                 unit;
+        bool                    integerValued;
+        Chunk_t*                chunks[chunkCount];     ///< Allocated by the writer before the first sample in them is published
+        QAtomicInteger<quint32> head;
+    } Curve_t;
+
+    const Chunk_t* _chunk(int curveId, quint32 index) const { return _curves[curveId]->chunks[(index & _sampleMask) / chunkSamples]; }
+
+    QMutex      _addCurveMutex;
+    QAtomicInt  _curveCount;
+    Curve_t*    _curves[maxCurves];
+    quint64     _lastMsecs;                             ///< Data time of the last sample across all curves, writer thread only
+
+    static const quint32 _sampleMask = sampleCapacity - 1;
+    static const quint32 _chunkMask = chunkSamples - 1;
+};
+
+#endif
@@ -0,0 +1,203 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "TimeSeriesStoreTest.h"
+#include "TimeSeriesStore.h"
+
+#include <QSignalSpy>
+#include <QThread>
+
+/// Appends samples whose times and value are derived from the sample index, so readers can tell a sample which
+/// was overwritten while it was read
+class TimeSeriesStoreTestWriter : public QThread
+{
+public:
+    TimeSeriesStoreTestWriter(TimeSeriesStore* store, int curveId, quint32 count)
+        : _store(store)
+        , _curveId(curveId)
+        , _count(count)
+    {
+
+    }
+
+protected:
+    void run(void)
+    {
+        for (quint32 i=0; i<_count; i++) {
+            _store->append(_curveId, i, 2 * (quint64)i, -(double)i);
+        }
+    }
+
+private:
+    TimeSeriesStore*    _store;
+    int                 _curveId;
+    quint32             _count;
+};
+
+TimeSeriesStoreTest::TimeSeriesStoreTest(void)
+{
+
+}
+
+void TimeSeriesStoreTest::_appendSamples(TimeSeriesStore& store, int curveId, quint32 first, quint32 count)
+{
+    for (quint32 i=first; i<first + count; i++) {
+        store.append(curveId, i, 2 * (quint64)i, -(double)i);
+    }
+}
+
+void TimeSeriesStoreTest::_append_test(void)
+{
+    TimeSeriesStore store;
+    QSignalSpy      spyCurveAdded(&store, &TimeSeriesStore::curveAdded);
+
+    int curveId = store.addCurve(1, "ATTITUDE.roll", "rad", false);
+    QCOMPARE(curveId, 0);
+    QCOMPARE(store.addCurve(2, "HEARTBEAT.type", "", true), 1);
+    QCOMPARE(store.curveCount(), 2);
+    QCOMPARE(spyCurveAdded.count(), 2);
+    QCOMPARE(spyCurveAdded[1][0].toInt(), 1);
+
+    QCOMPARE(store.uasId(curveId), 1);
+    QCOMPARE(store.name(curveId), QStringLiteral("ATTITUDE.roll"));
+    QCOMPARE(store.unit(curveId), QStringLiteral("rad"));
+    QVERIFY(!store.isIntegerValued(curveId));
+    QVERIFY(store.isIntegerValued(1));
+
+    QCOMPARE(store.head(curveId), (quint32)0);
+    QCOMPARE(store.firstIndex(0), (quint32)0);
+
+    // Spans more than one chunk
+    const quint32 count = TimeSeriesStore::chunkSamples + 100;
+    _appendSamples(store, curveId, 0, count);
+    QCOMPARE(store.head(curveId), count);
+    QCOMPARE(store.head(1), (quint32)0);
+    QCOMPARE(store.firstIndex(count), (quint32)0);
+    QVERIFY(!store.overwritten(curveId, 0));
+
+    for (quint32 i=0; i<count; i++) {
+        QCOMPARE(store.msecs(curveId, i), (double)i);
+        QCOMPARE(store.groundMsecs(curveId, i), 2.0 * i);
+        QCOMPARE(store.time(curveId, i, true), 2.0 * i);
+        QCOMPARE(store.value(curveId, i), -(double)i);
+    }
+
+    QCOMPARE(store.lowerBound(curveId, 0, count, 0, false), (quint32)0);
+    QCOMPARE(store.lowerBound(curveId, 0, count, 1000.5, false), (quint32)1001);
+    QCOMPARE(store.lowerBound(curveId, 0, count, 1000.5, true), (quint32)501);
+    QCOMPARE(store.lowerBound(curveId, 0, count, count, false), count);
+}
+
+void TimeSeriesStoreTest::_wraparound_test(void)
+{
+    TimeSeriesStore store;
+
+    int curveId = store.addCurve(1, "ATTITUDE.roll", "rad", false);
+    const quint32 capacity = TimeSeriesStore::sampleCapacity;
+
+    // The ring holds the longest time axis at the highest sample rate
+    QVERIFY(capacity >= (quint32)(TimeSeriesStore::maxWindowSecs * TimeSeriesStore::maxSampleRate));
+
+    // Filling the ring exactly keeps every sample
+    _appendSamples(store, curveId, 0, capacity - 1);
+    QCOMPARE(store.firstIndex(store.head(curveId)), (quint32)0);
+    QVERIFY(!store.overwritten(curveId, 0));
+
+    // Wrap around a couple of times and stop part way into a chunk
+    const quint32 count = 2 * capacity + TimeSeriesStore::chunkSamples / 2 + 3;
+    _appendSamples(store, curveId, capacity - 1, count - (capacity - 1));
+
+    quint32 head = store.head(curveId);
+    quint32 first = store.firstIndex(head);
+    QCOMPARE(head, count);
+    QCOMPARE(first, count - capacity + 1);
+
+    QVERIFY(!store.overwritten(curveId, first));
+    QVERIFY(!store.overwritten(curveId, head - 1));
+    QVERIFY(store.overwritten(curveId, first - 1));
+    QVERIFY(store.overwritten(curveId, 0));
+
+    for (quint32 i=first; i!=head; i++) {
+        QCOMPARE(store.msecs(curveId, i), (double)i);
+        QCOMPARE(store.value(curveId, i), -(double)i);
+    }
+
+    // Searches work across the physical end of the ring
+    QCOMPARE(store.lowerBound(curveId, first, head, 0, false), first);
+    QCOMPARE(store.lowerBound(curveId, first, head, 2 * capacity + 10, false), 2 * capacity + 10);
+    QCOMPARE(store.lowerBound(curveId, first, head, head, false), head);
+}
+
+/// Reads the oldest samples, which are the ones the writer wraps around onto, while the writer thread appends. Any
+/// read which is not flagged as overwritten must return the samples which were appended at those indices.
+void TimeSeriesStoreTest::_concurrentRead_test(void)
+{
+    TimeSeriesStore store;
+
+    int curveId = store.addCurve(1, "ATTITUDE.roll", "rad", false);
+    const quint32 count = 64 * TimeSeriesStore::sampleCapacity;
+    const quint32 readCount = 256;
+
+    TimeSeriesStoreTestWriter writer(&store, curveId, count);
+
+    int  validReads = 0;
+    bool finished = false;
+    writer.start();
+    while (!finished) {
+        // Read one more round once the writer is done, so there always is a valid read
+        finished = writer.isFinished();
+
+        quint32 head = store.head(curveId);
+        quint32 first = store.firstIndex(head);
+        quint32 last = qMin(first + readCount, head);
+
+        double msecs[readCount];
+        double values[readCount];
+        for (quint32 i=first; i!=last; i++) {
+            msecs[i - first] = store.msecs(curveId, i);
+            values[i - first] = store.value(curveId, i);
+        }
+        if (store.overwritten(curveId, first)) {
+            continue;
+        }
+
+        for (quint32 i=first; i!=last; i++) {
+            QCOMPARE(msecs[i - first], (double)i);
+            QCOMPARE(values[i - first], -(double)i);
+        }
+        validReads++;
+    }
+
+    QVERIFY(writer.wait(10000));
+    QCOMPARE(store.head(curveId), count);
+    QVERIFY(validReads > 0);
+}
+
+void TimeSeriesStoreTest::_timeJump_test(void)
+{
+    TimeSeriesStore store;
+    QSignalSpy      spyTimeJumped(&store, &TimeSeriesStore::timeJumped);
+
+    int curveId = store.addCurve(1, "ATTITUDE.roll", "rad", false);
+    int otherCurveId = store.addCurve(1, "GPS_RAW_INT.lat", "degE7", true);
+
+    // Steps up to the limit and backwards steps are not jumps
+    store.append(curveId, 1000, 1, 0);
+    store.append(otherCurveId, 1000 + TimeSeriesStore::timeJumpMsecs, 2, 0);
+    store.append(curveId, 1500, 3, 0);
+    QCOMPARE(spyTimeJumped.count(), 0);
+
+    // Samples without data time are skipped, the jump is checked against the last sample of any curve
+    store.append(curveId, 0, 4, 0);
+    store.append(otherCurveId, 1501 + TimeSeriesStore::timeJumpMsecs, 5, 0);
+    QCOMPARE(spyTimeJumped.count(), 1);
+
+    store.append(curveId, 1502 + TimeSeriesStore::timeJumpMsecs, 6, 0);
+    QCOMPARE(spyTimeJumped.count(), 1);
+}
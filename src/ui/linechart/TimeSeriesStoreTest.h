@@ -0,0 +1,35 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#ifndef TimeSeriesStoreTest_H
+#define TimeSeriesStoreTest_H
+
+#include "UnitTest.h"
+
+class TimeSeriesStore;
+
+/// Unit test for TimeSeriesStore: appending, ring wraparound, time jumps and reading while the writer thread appends
+class TimeSeriesStoreTest : public UnitTest
+{
+    Q_OBJECT
+
+public:
+    TimeSeriesStoreTest(void);
+
+private slots:
+    void _append_test(void);
+    void _wraparound_test(void);
+    void _concurrentRead_test(void);
+    void _timeJump_test(void);
+
+private:
+    void _appendSamples(TimeSeriesStore& store, int curveId, quint32 first, quint32 count);
+};
+
+#endif
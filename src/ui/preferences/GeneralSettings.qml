@@ -524,6 +524,77 @@ QGCView {
                                 }
                             }
                         }
+                        Row {
+                            spacing:    ScreenTools.defaultFontPixelWidth
+                            visible:    QGroundControl.videoManager.isGStreamer
+                            QGCLabel {
+                                anchors.baseline:   jitterBufferCombo.baseline
+                                text:               qsTr("Jitter Buffer:")
+                                width:              _labelWidth
+                            }
+                            QGCComboBox {
+                                id:                 jitterBufferCombo
+                                width:              _editFieldWidth
+                                model:              [ qsTr("Off"), qsTr("Low Latency"), qsTr("Smooth") ]
+                                currentIndex:       QGroundControl.videoManager.jitterBufferMode
+                                onActivated:        QGroundControl.videoManager.jitterBufferMode = index
+                            }
+                        }
+                        Row {
+                            spacing:    ScreenTools.defaultFontPixelWidth
+                            visible:    QGroundControl.videoManager.isGStreamer
+                            QGCLabel {
+                                anchors.baseline:   videoDecoderCombo.baseline
+                                text:               qsTr("Video Decoder:")
+                                width:              _labelWidth
+                            }
+                            QGCComboBox {
+                                id:                 videoDecoderCombo
+                                width:              _editFieldWidth
+                                model:              [ qsTr("Automatic") ].concat(QGroundControl.videoManager.videoDecoderList)
+                                currentIndex:       QGroundControl.videoManager.videoDecoderList.indexOf(QGroundControl.videoManager.videoDecoder) + 1
+                                onActivated:        QGroundControl.videoManager.videoDecoder = index > 0 ? model[index] : ""
+                            }
+                        }
+                        Row {
+                            spacing:    ScreenTools.defaultFontPixelWidth
+                            visible:    QGroundControl.videoManager.isGStreamer
+                            QGCLabel {
+                                anchors.baseline:   streamField.baseline
+                                text:               qsTr("Add Stream:")
+                                width:              _labelWidth
+                            }
+                            QGCTextField {
+                                id:                 streamField
+                                width:              _editFieldWidth
+                                placeholderText:    qsTr("udp://0.0.0.0:5601 or rtsp://...")
+                            }
+                            QGCButton {
+                                text:       qsTr("Add")
+                                enabled:    streamField.text !== ""
+                                onClicked: {
+                                    QGroundControl.videoManager.addStream(streamField.text)
+                                    streamField.text = ""
+                                }
+                            }
+                        }
+                        Repeater {
+                            model:      QGroundControl.videoManager.isGStreamer ? QGroundControl.videoManager.streams : 0
+                            Row {
+                                spacing:    ScreenTools.defaultFontPixelWidth
+                                QGCLabel {
+                                    anchors.baseline:   removeStreamButton.baseline
+                                    text:               object.uri
+                                    width:              _labelWidth + _editFieldWidth + ScreenTools.defaultFontPixelWidth
+                                    elide:              Text.ElideMiddle
+                                }
+                                QGCButton {
+                                    id:         removeStreamButton
+                                    text:       qsTr("Remove")
+                                    onClicked:  QGroundControl.videoManager.removeStream(object)
+                                }
+                            }
+                        }
                     }
                 }
 